@@ -0,0 +1,570 @@
+pragma Style_Checks (Off);
+with Ada.Command_Line;
+with Ada.Directories;
+with Ada.Text_IO; use Ada.Text_IO;
+with Ada.Unchecked_Deallocation;
+with Interfaces; use Interfaces;
+with baud_link;
+with chunk_link;
+with cmd_link;
+with manifest;
+with profiler;
+with ring_monitor;
+------------------------------------------------------------------------------
+--  File:        vectors.adb
+--  Description: Runs one tests/vectors/<unit>.vec file through the
+--               firmware's own package and prints what tests/test_vectors.c
+--               prints for the C mirror, line for line, so `make ada-check`
+--               can diff both against the same <unit>.out.
+--
+--  Components:
+--               Next / Fnv        -- The LCG and FNV-1a of test_vectors.c
+--               Cmd_Line          -- cmd_link: feed, encode, line, fuzz
+--               Ring_Line         -- ring_monitor: reset, produce, consume,
+--                                    fuzz
+--               Baud_Line         -- baud_link: start, rx, pattern, tick,
+--                                    frame, valid
+--               Prof_Line         -- profiler: begin, sample, level, bytes
+--               Manifest_Line     -- manifest: build, fuzz
+--
+--  Target:      Host (GNAT native, src/ of JTAG_Programmer_Cmd_Call)
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+procedure vectors is
+
+   Max_Tokens : constant := 320;
+
+   type Span is record
+      First : Positive := 1;
+      Last  : Natural  := 0;
+   end record;
+   type Span_Table is array (0 .. Max_Tokens - 1) of Span;
+
+   Line : String (1 .. 4096);
+   Last : Natural;
+   T    : Span_Table;
+   N    : Natural;
+
+   --  Token I, as t[I] in test_vectors.c
+   function Tok (I : Natural) return String is (Line (T (I).First .. T (I).Last));
+
+   procedure Split is
+      I : Positive := 1;
+   begin
+      N := 0;
+      while I <= Last and then N < Max_Tokens loop
+         if Line (I) = ' ' or else Line (I) = ASCII.HT or else Line (I) = ASCII.CR then
+            I := I + 1;
+         else
+            T (N).First := I;
+            while I <= Last and then Line (I) /= ' ' and then Line (I) /= ASCII.HT
+              and then Line (I) /= ASCII.CR
+            loop
+               I := I + 1;
+            end loop;
+            T (N).Last := I - 1;
+            N := N + 1;
+         end if;
+      end loop;
+   end Split;
+
+   --  Shared with tests/test_vectors.c
+   Lcg : Unsigned_32 := 0;
+
+   function Next return Unsigned_32 is
+   begin
+      Lcg := Lcg * 1103515245 + 12345;
+      return Shift_Right (Lcg, 16);
+   end Next;
+
+   function Fnv (H : Unsigned_32; B : Unsigned_8) return Unsigned_32 is
+     ((H xor Unsigned_32 (B)) * 16777619);
+
+   function Low (W : Unsigned_32) return Unsigned_8 is (Unsigned_8 (W and 16#FF#));
+
+   --  Leading digits, as strtoul: "-" is 0, "2:0:4000" is 2
+   function Num (S : String) return Unsigned_32 is
+      V : Unsigned_32 := 0;
+   begin
+      for C of S loop
+         exit when C not in '0' .. '9';
+         V := V * 10 + Unsigned_32 (Character'Pos (C) - Character'Pos ('0'));
+      end loop;
+      return V;
+   end Num;
+
+   function Hex (S : String) return Unsigned_32 is
+      V : Unsigned_32 := 0;
+   begin
+      for C of S loop
+         case C is
+            when '0' .. '9' => V := V * 16 + Unsigned_32 (Character'Pos (C) - Character'Pos ('0'));
+            when 'A' .. 'F' => V := V * 16 + Unsigned_32 (Character'Pos (C) - Character'Pos ('A') + 10);
+            when 'a' .. 'f' => V := V * 16 + Unsigned_32 (Character'Pos (C) - Character'Pos ('a') + 10);
+            when others     => exit;
+         end case;
+      end loop;
+      return V;
+   end Hex;
+
+   function Num (I : Natural) return Unsigned_32 is (Num (Tok (I)));
+   function Hex (I : Natural) return Unsigned_32 is (Hex (Tok (I)));
+
+   Hex_Digits : constant String := "0123456789ABCDEF";
+
+   function Hex2 (B : Unsigned_8) return String is
+     (Hex_Digits (Natural (Shift_Right (B, 4)) + 1) & Hex_Digits (Natural (B and 16#0F#) + 1));
+
+   function Hex8 (W : Unsigned_32) return String is
+     (Hex2 (Low (Shift_Right (W, 24))) & Hex2 (Low (Shift_Right (W, 16)))
+      & Hex2 (Low (Shift_Right (W, 8))) & Hex2 (Low (W)));
+
+   function Img (V : Unsigned_32) return String is
+      S : constant String := Unsigned_32'Image (V);
+   begin
+      return S (S'First + 1 .. S'Last);
+   end Img;
+
+   function Img (V : Natural) return String is (Img (Unsigned_32 (V)));
+
+   type Byte_Array is array (Natural range <>) of Unsigned_8;
+   type Byte_Access is access Byte_Array;
+   procedure Free is new Ada.Unchecked_Deallocation (Byte_Array, Byte_Access);
+
+   --  cmd_link
+   --  Prints each verdict (or folds it into Hash), then the counters
+   procedure Cmd_Feed (B : Byte_Array; Fold : Boolean; Hash : in out Unsigned_32) is
+      use cmd_link;
+      P : Parser;
+      V : Verdict;
+   begin
+      for X of B loop
+         Feed (P, X, V);
+         if V = NONE then
+            null;
+         elsif Fold then
+            Hash := Fnv (Hash, Unsigned_8 (Verdict'Pos (V)));
+            Hash := Fnv (Hash, P.Op);
+            Hash := Fnv (Hash, P.Tag);
+            Hash := Fnv (Hash, Unsigned_8 (P.Length mod 256));
+            Hash := Fnv (Hash, Unsigned_8 (P.Length / 256));
+         elsif V = GOOD then
+            Put (" G:" & Hex2 (P.Op) & ":" & Hex2 (P.Tag) & ":" & Img (P.Length) & ":");
+            for I in 0 .. P.Length - 1 loop
+               Put (Hex2 (P.Payload (I)));
+            end loop;
+         elsif V = BAD_CRC then
+            Put (" C:" & Hex2 (P.Op) & ":" & Hex2 (P.Tag));
+         else
+            Put (" L");
+         end if;
+      end loop;
+      Put (" | " & Img (P.Frames) & " " & Img (P.Bad_CRC) & " " & Img (P.Too_Long)
+           & " " & Img (P.Skipped));
+      if Fold then
+         Put (" " & Hex8 (Hash));
+      end if;
+      New_Line;
+   end Cmd_Feed;
+
+   --  Valid frames, some damaged, some too long, and runs of garbage
+   procedure Cmd_Fuzz_Stream (S : in out Byte_Array; Count : Unsigned_32; Len : out Natural) is
+      Kind, Size, CRC, At_Byte : Unsigned_32;
+      Start : Natural;
+
+      procedure Add (B : Unsigned_8) is
+      begin
+         S (Len) := B;
+         Len := Len + 1;
+      end Add;
+   begin
+      Len := 0;
+      for K in 1 .. Count loop
+         Kind := Next mod 4;
+         if Kind = 0 then
+            Size := Next mod 8;
+            for I in 1 .. Size loop
+               Add (Low (Next));
+            end loop;
+         else
+            Start := Len;
+            Size := Next mod (cmd_link.Max_Payload + 12);
+            Add (cmd_link.Sync);
+            Add (Low (Next mod 16));
+            Add (Low (Next));
+            Add (Low (Size));
+            Add (Low (Shift_Right (Size, 8)));
+            if Size <= cmd_link.Max_Payload then
+               for I in 1 .. Size loop
+                  Add (Low (Next));
+               end loop;
+               CRC := 16#FFFF_FFFF#;
+               for I in Start + 1 .. Len - 1 loop
+                  CRC := chunk_link.CRC_Update (CRC, S (I));
+               end loop;
+               CRC := not CRC;
+               for I in 0 .. 3 loop
+                  Add (Low (Shift_Right (CRC, 8 * I)));
+               end loop;
+            end if;
+            if Kind = 3 then
+               At_Byte := Next mod Unsigned_32 (Len - Start);
+               S (Start + Natural (At_Byte)) :=
+                 S (Start + Natural (At_Byte)) xor Shift_Left (Unsigned_8'(1), Natural (Next mod 8));
+            end if;
+         end if;
+      end loop;
+   end Cmd_Fuzz_Stream;
+
+   procedure Cmd_Line is
+      Hash : Unsigned_32 := 2166136261;
+   begin
+      if Tok (0) = "feed" then
+         declare
+            B : Byte_Array (1 .. N - 1);
+         begin
+            for I in B'Range loop
+               B (I) := Low (Hex (I));
+            end loop;
+            Put ("feed");
+            Cmd_Feed (B, False, Hash);
+         end;
+      elsif Tok (0) = "encode" then
+         declare
+            R    : cmd_link.Response;
+            F    : cmd_link.Frame_Bytes;
+            Size : Natural;
+         begin
+            R.Op := Low (Hex (1));
+            R.Tag := Low (Hex (2));
+            R.Status := Low (Hex (3));
+            for I in 4 .. N - 1 loop
+               cmd_link.Add_Word (R, Hex (I));
+            end loop;
+            cmd_link.Encode (R, F, Size);
+            Put ("encode ");
+            for I in 0 .. Size - 1 loop
+               Put (Hex2 (F (I)));
+            end loop;
+            New_Line;
+         end;
+      elsif Tok (0) = "line" then
+         --  The words after it, one space apart
+         declare
+            Text : String (1 .. Line'Length);
+            Len  : Natural := 0;
+            Op   : Unsigned_8;
+            Arg  : Natural;
+         begin
+            for I in 1 .. N - 1 loop
+               if I > 1 then
+                  Len := Len + 1;
+                  Text (Len) := ' ';
+               end if;
+               Text (Len + 1 .. Len + Tok (I)'Length) := Tok (I);
+               Len := Len + Tok (I)'Length;
+            end loop;
+            cmd_link.Parse_Line (Text (1 .. Len), Op, Arg);
+            Put_Line ("line " & Hex2 (Op) & " " & Img (Arg));
+         end;
+      elsif Tok (0) = "fuzz" then
+         declare
+            Count : constant Unsigned_32 := Num (2);
+            S     : Byte_Access := new Byte_Array (0 .. Natural (Count) * (cmd_link.Frame_Bytes'Length + 8) - 1);
+            Len   : Natural;
+         begin
+            Lcg := Num (1);
+            Cmd_Fuzz_Stream (S.all, Count, Len);
+            Put ("fuzz " & Img (Len));
+            Cmd_Feed (S (0 .. Len - 1), True, Hash);
+            Free (S);
+         end;
+      end if;
+   end Cmd_Line;
+
+   --  ring_monitor
+   Ring : ring_monitor.Ring_Stats;
+
+   procedure Ring_Put (What : String) is
+   begin
+      Put_Line (What & " " & Img (Ring.Produced) & " " & Img (Ring.Consumed) & " "
+                & Img (ring_monitor.Level (Ring)) & " " & Img (Ring.High_Water) & " "
+                & Img (Ring.Overruns) & " " & Img (Ring.Lost));
+   end Ring_Put;
+
+   --  Crossings of offset H (1 .. Size) in the bytes 1 .. X the DMA has written
+   function Hits (X, H, Size : Unsigned_32) return Unsigned_32 is
+     (if X >= H then (X - H) / Size + 1 else 0);
+
+   procedure Ring_Line is
+   begin
+      if Tok (0) = "reset" then
+         ring_monitor.Reset (Ring, Positive (Num (1)), Natural (Num (2)), Natural (Num (3)));
+         Ring_Put ("ring");
+      elsif Tok (0) = "produce" then
+         ring_monitor.Produce (Ring, Natural (Num (1)), Num (2) /= 0, Num (3) /= 0);
+         Ring_Put ("ring");
+      elsif Tok (0) = "consume" then
+         ring_monitor.Consume (Ring, Natural (Num (1)));
+         Ring_Put ("ring");
+      elsif Tok (0) = "fuzz" then
+         --  A DMA that runs ahead by up to 1.5 rings between polls, and a
+         --  consumer that sometimes skips a poll
+         declare
+            Count : constant Unsigned_32 := Num (2);
+            Size  : constant Unsigned_32 := Num (3);
+            Pos   : Unsigned_32 := 0;
+            Adv   : Unsigned_32;
+            Half  : Boolean := False;
+            Full  : Boolean := False;
+         begin
+            Lcg := Num (1);
+            ring_monitor.Reset (Ring, Positive (Size), 0, 0);
+            for K in 1 .. Count loop
+               Adv := Next mod (Size + Size / 2);
+               Half := Half or else Hits (Pos + Adv, Size / 2, Size) /= Hits (Pos, Size / 2, Size);
+               Full := Full or else Hits (Pos + Adv, Size, Size) /= Hits (Pos, Size, Size);
+               Pos := Pos + Adv;
+               if Next mod 4 /= 0 then
+                  ring_monitor.Produce (Ring, Natural (Pos mod Size), Half, Full);
+                  Half := False;
+                  Full := False;
+                  ring_monitor.Consume
+                    (Ring, Natural (Next mod (Unsigned_32 (ring_monitor.Level (Ring)) + 1)));
+               end if;
+            end loop;
+            Ring_Put ("fuzz");
+         end;
+      end if;
+   end Ring_Line;
+
+   --  baud_link
+   Baud : baud_link.Session;
+
+   --  Tx goes out, then the switch, as mcu_to_fpga.Negotiate_Baud takes them
+   procedure Baud_Put is
+   begin
+      Put ("baud " & Img (Natural (baud_link.Phase'Pos (Baud.State))) & " " & Img (Natural (Baud.Base))
+           & " " & Img (Natural (Baud.Rate)) & " " & Img (Natural (Baud.Trial)) & " " & Img (Baud.Got)
+           & " " & Img (Baud.Errors) & " " & Img (Baud.Trials) & " tx=");
+      for I in 0 .. Baud.Tx_Len - 1 loop
+         Put (Hex2 (Baud.Tx (I)));
+      end loop;
+      Baud.Tx_Len := 0;
+      if Baud.Switch then
+         Put_Line (" sw=" & Img (Natural (Baud.Rate)));
+      else
+         Put_Line (" sw=-");
+      end if;
+      Baud.Switch := False;
+   end Baud_Put;
+
+   function Bit (B : Boolean) return String is (if B then "1" else "0");
+
+   procedure Baud_Line is
+   begin
+      if Tok (0) = "start" then
+         baud_link.Current := Low (Num (1));
+         baud_link.Start (Baud, Num (2));
+         Baud_Put;
+      elsif Tok (0) = "rx" then
+         for I in 2 .. N - 1 loop
+            baud_link.Rx (Baud, Low (Hex (I)), Num (1));
+         end loop;
+         Baud_Put;
+      elsif Tok (0) = "pattern" then
+         for K in 1 .. Num (2) loop
+            baud_link.Rx (Baud, baud_link.Pattern (K - 1) xor (if K <= Num (3) then 16#FF# else 0), Num (1));
+         end loop;
+         Baud_Put;
+      elsif Tok (0) = "tick" then
+         baud_link.Tick (Baud, Num (1));
+         Baud_Put;
+      elsif Tok (0) = "frame" then
+         declare
+            F : constant baud_link.Frame_Bytes := baud_link.Frame (Low (Hex (1)), Low (Num (2)), Low (Num (3)));
+         begin
+            Put ("frame ");
+            for B of F loop
+               Put (Hex2 (B));
+            end loop;
+            Put_Line (" " & Bit (baud_link.Valid (F)));
+         end;
+      elsif Tok (0) = "valid" then
+         declare
+            F : baud_link.Frame_Bytes;
+         begin
+            for I in F'Range loop
+               F (I) := Low (Hex (I + 1));
+            end loop;
+            Put_Line ("valid " & Bit (baud_link.Valid (F)));
+         end;
+      end if;
+   end Baud_Line;
+
+   --  profiler
+   procedure Prof_Put is
+      use profiler;
+   begin
+      Put ("prof");
+      for S of Report.Phases loop
+         Put (" " & Img (S.Count) & " " & Img (Minimum (S)) & " " & Img (Average (S)) & " "
+              & Img (S.Max) & " " & Img (S.Total));
+      end loop;
+      Put_Line (" " & Img (Report.Bytes) & " " & Img (Bytes_Per_Second) & " " & Img (Report.High_Water));
+   end Prof_Put;
+
+   procedure Prof_Line is
+   begin
+      if Tok (0) = "begin" then
+         profiler.Begin_Session;
+      elsif Tok (0) = "sample" then
+         profiler.Add_Sample (profiler.Phase'Val (Num (1)), Num (2));
+      elsif Tok (0) = "level" then
+         profiler.Note_Level (Natural (Num (1)));
+      elsif Tok (0) = "bytes" then
+         profiler.Report.Bytes := Num (1);
+      else
+         return;
+      end if;
+      Prof_Put;
+   end Prof_Line;
+
+   --  manifest
+   --  More rows than Step_Table, so a table over Max_Steps can be sent
+   type Raw_Table is array (0 .. 15) of manifest.Step;
+
+   --  Header and table as Host_Tools/lib/manifest.c lays them out, data
+   --  length and CRC taken as given so the vectors can break them
+   function Manifest_Check
+     (S : Raw_Table; Count : Natural; Stage, Cache : Unsigned_32; Sum_Data : Boolean;
+      Data_Length, CRC_Xor : Unsigned_32) return Natural
+   is
+      Table : manifest.Step_Table;
+      CRC   : Unsigned_32 := 16#FFFF_FFFF#;
+      Sum   : Unsigned_32 := 0;
+
+      procedure Word (W : Unsigned_32) is
+      begin
+         for I in 0 .. 3 loop
+            CRC := chunk_link.CRC_Update (CRC, Low (Shift_Right (W, 8 * I)));
+         end loop;
+      end Word;
+   begin
+      for I in 0 .. Count - 1 loop
+         Word (S (I).Op);
+         Word (S (I).Length);
+         Word (S (I).Value);
+         Word (S (I).Mask);
+         Sum := Sum + S (I).Length;
+         if I < manifest.Max_Steps then
+            Table (I + 1) := S (I);
+         end if;
+      end loop;
+      CRC := not CRC;
+      if manifest.Valid
+           (H          => (Magic       => manifest.Magic,
+                           Steps       => Unsigned_32 (Count),
+                           Data_Length => (if Sum_Data then Sum else Data_Length),
+                           CRC         => CRC xor CRC_Xor),
+            Steps      => Table,
+            Steps_CRC  => CRC,
+            Stage_Size => Natural (Stage),
+            Cache_Size => Natural (Cache))
+      then
+         return Count;
+      end if;
+      return 0;
+   end Manifest_Check;
+
+   --  kind:arg:length[:value:mask]
+   function Parse_Step (S : String) return manifest.Step is
+      R     : manifest.Step;
+      Field : Natural := 0;
+   begin
+      for I in S'Range loop
+         if I = S'First or else S (I - 1) = ':' then
+            case Field is
+               when 0      => R.Op := Num (S (I .. S'Last));
+               when 1      => R.Op := R.Op or Shift_Left (Num (S (I .. S'Last)), 8);
+               when 2      => R.Length := Num (S (I .. S'Last));
+               when 3      => R.Value := Hex (S (I .. S'Last));
+               when 4      => R.Mask := Hex (S (I .. S'Last));
+               when others => null;
+            end case;
+            Field := Field + 1;
+         end if;
+      end loop;
+      return R;
+   end Parse_Step;
+
+   procedure Manifest_Line is
+      S : Raw_Table;
+      K : Natural := 0;
+   begin
+      if Tok (0) = "build" then
+         --  build STAGE CACHE DATALEN|- CRCXOR kind:arg:length[:value:mask] ...
+         for I in 5 .. N - 1 loop
+            exit when K = S'Length;
+            S (K) := Parse_Step (Tok (I));
+            K := K + 1;
+         end loop;
+         Put_Line ("build " & Img (Manifest_Check (S, K, Num (1), Num (2), Tok (3) = "-", Num (3), Hex (4))));
+      elsif Tok (0) = "fuzz" then
+         --  Tables of 1 .. 9 steps, kinds 0 .. 7, lengths from around the limits
+         declare
+            type Length_Table is array (Unsigned_32 range 0 .. 7) of Unsigned_32;
+            Lengths : constant Length_Table := (0, 0, 4, 6, 2048, 16384, 16388, 65536);
+            Count   : constant Unsigned_32 := Num (2);
+            Valid   : Unsigned_32 := 0;
+            Hash    : Unsigned_32 := 2166136261;
+            Steps   : Natural;
+            R       : Natural;
+         begin
+            Lcg := Num (1);
+            for C in 1 .. Count loop
+               Steps := Natural (Next mod 9 + 1);
+               for J in 0 .. Steps - 1 loop
+                  S (J).Op := Next mod 8;
+                  S (J).Op := S (J).Op or Shift_Left (Next mod 4, 8);
+                  S (J).Length := Lengths (Next mod 8);
+                  S (J).Value := 0;
+                  S (J).Mask := 0;
+               end loop;
+               R := Manifest_Check (S, Steps, 16384, 65536, True, 0, 0);
+               if R /= 0 then
+                  Valid := Valid + 1;
+               end if;
+               Hash := Fnv (Hash, Unsigned_8 (R));
+            end loop;
+            Put_Line ("fuzz " & Img (Valid) & " " & Hex8 (Hash));
+         end;
+      end if;
+   end Manifest_Line;
+
+   --  The file
+   Path : constant String := Ada.Command_Line.Argument (1);
+   Unit : constant String := Ada.Directories.Base_Name (Path);
+   File : File_Type;
+
+begin
+   Open (File, In_File, Path);
+   while not End_Of_File (File) loop
+      Get_Line (File, Line, Last);
+      Split;
+      if N > 0 and then Line (T (0).First) /= '#' then
+         if Unit = "cmd_link" then
+            Cmd_Line;
+         elsif Unit = "ring_monitor" then
+            Ring_Line;
+         elsif Unit = "baud_link" then
+            Baud_Line;
+         elsif Unit = "profiler" then
+            Prof_Line;
+         elsif Unit = "manifest" then
+            Manifest_Line;
+         end if;
+      end if;
+   end loop;
+   Close (File);
+end vectors;
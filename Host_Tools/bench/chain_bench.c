@@ -0,0 +1,59 @@
+/*
+ * Chain-length overhead benchmark
+ * - Programs one Gowin TAP inside chains of 1..JTAG_MAX_DEVICES-1 Gowin TAPs
+ * - Reports total TCKs, bit-banged TCKs (everything but the SPI body) and
+ *   the extra TCKs each additional BYPASS device costs a full session
+ * usage: chain_bench [bitstream.bin]
+ */
+
+#include "host_file.h"
+#include "jtag_master.h"
+#include "tap_chain.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint8_t *Pattern(size_t *len) {
+    uint8_t *buf;
+    *len = MIN_STREAM_BITS / 8 + 1024;
+    buf = malloc(*len);
+    for (size_t i = 0; i < *len; i++) buf[i] = (uint8_t)(i * 37);
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    size_t len;
+    uint8_t *bits = HostFile_Load(argc > 1 ? argv[1] : "../JTAG_Programmer_Serial/output1.bin", &len);
+    uint64_t base = 0;
+    int n;
+
+    if (!bits) bits = Pattern(&len);   // No bitstream: a pattern just over MIN_STREAM_BITS
+    printf("bitstream: %zu bytes\n", len);
+    printf("%-8s %-8s %12s %12s %12s %10s %8s\n", "devices", "target", "tck_total", "tck_bitbang", "tck_extra", "per_dev", "pass");
+
+    for (n = 1; n < JTAG_MAX_DEVICES; n++) {
+        TapChain chain; JtagMaster m; int t;
+        TapChain_Init(&chain);
+        for (t = 0; t < n; t++) TapChain_AddGowin(&chain);
+        Jtag_Init(&m, TapChain_ClockFn, &chain);
+        if (Jtag_Discover(&m) != n) { fprintf(stderr, "discovery failed for %d devices\n", n); return 1; }
+
+        // Device 0 sits nearest TDO: every other TAP pads the stream
+        Jtag_Select(&m, 0);
+        m.tckCount = 0;
+        Jtag_ResetTap(&m);
+        Jtag_InitConfiguration(&m);
+        Jtag_StreamBitstream(&m, bits, len);
+        Jtag_FinishConfiguration(&m);
+
+        if (n == 1) base = m.tckCount;
+        printf("%-8d %-8d %12llu %12llu %12llu %10.1f %8s\n", n, 0,
+               (unsigned long long)m.tckCount,
+               (unsigned long long)(m.tckCount - (uint64_t)(len - 1) * 8),
+               (unsigned long long)(m.tckCount - base),
+               n > 1 ? (double)(m.tckCount - base) / (n - 1) : 0.0,
+               (TapChain_Gowin(&chain, 0)->leds & LED_PROG_5) ? "yes" : "no");
+    }
+    free(bits);
+    return 0;
+}
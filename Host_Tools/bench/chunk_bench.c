@@ -0,0 +1,50 @@
+/*
+ * Chunked upload benchmark: faults on the link against what they cost
+ * - Runs the bitstream through the pty harness (sim/chunk_pipe.c) at bit
+ *   flip rates from 0 to 1000 per million bytes, with a dropped 64-byte
+ *   USB packet for every ten flips, and replies damaged at the same rate
+ * - Prints the bytes on the wire over the file, the chunks resent, NAKs
+ *   and timeouts, and next to it how many whole sends a raw `cat` would
+ *   need on average before one got through clean
+ * usage: chunk_bench [-c chunk] [-r ring] [bitstream.bin]
+ */
+
+#include "chunk_pipe.h"
+#include "host_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    static const uint32_t flips[] = { 0, 1, 10, 50, 200, 1000 };
+    const char *in = "../JTAG_Programmer_Serial/output1.bin";
+    uint32_t chunk = 256, ring = 4096;
+    size_t len, i;
+    uint8_t *bits;
+    int a;
+
+    for (a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-c") == 0 && a + 1 < argc) chunk = (uint32_t)strtoul(argv[++a], NULL, 0);
+        else if (strcmp(argv[a], "-r") == 0 && a + 1 < argc) ring = (uint32_t)strtoul(argv[++a], NULL, 0);
+        else in = argv[a];
+    }
+    if (!(bits = HostFile_Load(in, &len))) { fprintf(stderr, "cannot read bitstream\n"); return 1; }
+    printf("bitstream %zu bytes, chunk %u, ring %u\n", len, chunk, ring);
+    printf("flip_ppm drop_ppm  pass  wire_bytes  over_%%  resent  naks  rtos  evicted  wall_ms  raw_sends\n");
+    for (i = 0; i < sizeof(flips) / sizeof(flips[0]); i++) {
+        ChunkPipeConfig c = { bits, len, chunk, ring, 11, flips[i], flips[i] / 10, 64, flips[i], flips[i], 0 };
+        ChunkPipeResult r;
+        // Every byte has to get through untouched for a raw send to work
+        double clean = 1.0, p = 1.0 - (flips[i] + flips[i] / 10 * 64.0) / 1e6;
+        size_t b;
+        for (b = 0; b < len && clean > 1e-300; b++) clean *= p;
+        if (ChunkPipe_Run(&c, &r) < 0) { perror("pty"); return 1; }
+        printf("%8u %8u %5s %11llu %7.1f %7u %5u %5u %8u %8.0f %10.3g\n",
+               flips[i], flips[i] / 10, r.pass ? "yes" : "NO", (unsigned long long)r.wireBytes,
+               100.0 * ((double)r.wireBytes - (double)len) / (double)len, r.resent, r.naks, r.rtos, r.evicted,
+               r.wallS * 1e3, 1.0 / clean);
+    }
+    free(bits);
+    return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ * Firmware load benchmark: debug module against the UART bootloader
+ * - Loads the executable into the debug module model (sim/riscv_dm.c)
+ *   with DMI accesses taking 0 to 16 TCKs, and reports the TCKs each
+ *   phase took, TCKs per word and the busy retries
+ * - Load time at 1, 4 and 12 MHz TCK next to the image at 19200 baud
+ *   (10 bits per byte) through the NEORV32 bootloader
+ * usage: debug_bench [firmware.exe]
+ */
+
+#include "host_file.h"
+#include "jtag_master.h"
+#include "riscv_debug.h"
+#include "riscv_dm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+    static const uint32_t busy[] = { 0, 4, 8, 16 };
+    static RvDm dm;
+    size_t len, i;
+    uint8_t *exe = HostFile_Load(argc > 1 ? argv[1] : "../JTAG_Programmer_Serial/hello.exe", &len);
+
+    if (!exe) { fprintf(stderr, "cannot read executable\n"); return 1; }
+    printf("executable: %zu bytes, uart bootloader at 19200: %.0f ms\n", len, len * 10 / 19.2);
+    printf("busy_tck   result  connect    write  resume  tck/word  retries idle    1MHz_ms  4MHz_ms 12MHz_ms\n");
+    for (i = 0; i < sizeof(busy) / sizeof(busy[0]); i++) {
+        JtagMaster m;
+        RvDebug d;
+        RvDebugReport r;
+        double total;
+        RvDm_Init(&dm, 1, busy[i]);
+        Jtag_Init(&m, RvDm_ClockFn, &dm);
+        RvDebug_Init(&d, &m);
+        RvDebug_Load(&d, exe, len, &r);
+        total = (double)m.tckCount;
+        printf("%8u %8s %8llu %8llu %7llu %9.1f %8u %4u %10.2f %8.2f %8.2f\n",
+               busy[i], RvDebug_ResultName(r.result), (unsigned long long)r.connectTcks,
+               (unsigned long long)r.writeTcks, (unsigned long long)r.resumeTcks,
+               r.bytes ? (double)r.writeTcks / (r.bytes / 4) : 0.0, r.retries, r.idle,
+               total / 1e3, total / 4e3, total / 12e3);
+    }
+    free(exe);
+    return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Host -> MCU -> FPGA throughput benchmark
+ * - Replays the bitstream (config) and the firmware (upload) through the
+ *   whole pipeline over pseudo-terminals: host uploader, USART2 DMA ring,
+ *   bitstream pump into the Gowin TAP model / firmware bridge out of USART1
+ *   into the NEORV32 bootloader model, driven by its prompts
+ * - Prints one JSON object: end-to-end bytes/s, per-stage latency
+ *   (microseconds, per 256-byte chunk) and CPU time of each process
+ * usage: pipeline_bench [-b baud] [-c chunk] [-r ring] [-i idle_ms]
+ *                       [-H handshake_ms] [-l label] [-o out.json]
+ *                       [bitstream.bin [firmware.exe]]
+ *   -b paces the host at a baud rate (default 0: as fast as the pty goes)
+ *   -H is the bootloader banner delay after power-up (FPGA boot)
+ *   -l tags the run (e.g. the commit id) for comparing runs
+ */
+
+#include "host_file.h"
+#include "pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void Json_Run(FILE *o, const char *name, const char *path, const PipeConfig *c, const PipeResult *r, int last) {
+    int s;
+    fprintf(o, "    {\n");
+    fprintf(o, "      \"name\": \"%s\", \"file\": \"%s\", \"bytes\": %zu, \"pass\": %s,\n", name, path, r->bytes, r->pass ? "true" : "false");
+    fprintf(o, "      \"wall_s\": %.6f, \"bytes_per_s\": %.0f, \"stream_bytes_per_s\": %.0f,\n", r->wallS, r->bytesPerS, r->streamBytesPerS);
+    fprintf(o, "      \"first_byte_ms\": %.3f, \"tail_ms\": %.3f, \"handshake_ms\": %.3f,\n", r->firstByteMs, r->tailMs, r->handshakeMs);
+    fprintf(o, "      \"latency_us\": {\n");
+    for (s = 0; s < PIPE_STAGES; s++) {
+        const PipeLatency *l = &r->stage[s];
+        fprintf(o, "        \"%s\": { \"n\": %u, \"min\": %.1f, \"avg\": %.1f, \"p50\": %.1f, \"p99\": %.1f, \"max\": %.1f }%s\n",
+                Pipeline_StageName((PipeStage)s), l->n, l->min, l->avg, l->p50, l->p99, l->max, s + 1 < PIPE_STAGES ? "," : "");
+    }
+    fprintf(o, "      },\n");
+    fprintf(o, "      \"cpu_s\": { \"host\": %.6f, \"mcu\": %.6f, \"target_model\": %.6f, \"bootloader\": %.6f },\n",
+            r->cpuHostS, r->cpuMcuS, r->cpuTargetS, r->cpuSinkS);
+    fprintf(o, "      \"ring\": { \"size\": %u, \"high_water\": %u, \"overruns\": %u, \"lost\": %u },\n",
+            c->ringSize, r->ring.highWater, r->ring.overruns, r->ring.lost);
+    fprintf(o, "      \"tap\": { \"tck\": %llu, \"stream_bits\": %u }\n", (unsigned long long)r->tck, r->streamBits);
+    fprintf(o, "    }%s\n", last ? "" : ",");
+}
+
+int main(int argc, char **argv) {
+    const char *paths[2] = { "../JTAG_Programmer_Serial/output1.bin", "../JTAG_Programmer_Serial/hello.exe" };
+    const char *names[2] = { "bitstream", "firmware" };
+    const char *label = "", *outPath = NULL;
+    PipeConfig base = { PIPE_BITSTREAM, NULL, 0, 4096, 4096, 0, 20, 100 };
+    FILE *o = stdout;
+    int opt, i, nPaths = 0, fail = 0;
+
+    while ((opt = getopt(argc, argv, "b:c:r:i:H:l:o:")) != -1) {
+        switch (opt) {
+        case 'b': base.baud = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'c': base.chunk = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'r': base.ringSize = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'i': base.idleMs = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'H': base.handshakeMs = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'l': label = optarg; break;
+        case 'o': outPath = optarg; break;
+        default:
+            fprintf(stderr, "usage: pipeline_bench [-b baud] [-c chunk] [-r ring] [-i idle_ms] [-H handshake_ms] [-l label] [-o out.json] [bitstream.bin [firmware.exe]]\n");
+            return 2;
+        }
+    }
+    for (i = optind; i < argc && nPaths < 2; i++) paths[nPaths++] = argv[i];
+    if (base.chunk == 0 || base.ringSize < 2 || (base.ringSize & (base.ringSize - 1))) {
+        fprintf(stderr, "chunk must be > 0 and ring a power of two\n");
+        return 2;
+    }
+    if (outPath && !(o = fopen(outPath, "w"))) { perror(outPath); return 1; }
+
+    fprintf(o, "{\n  \"bench\": \"pipeline\", \"label\": \"%s\",\n", label);
+    fprintf(o, "  \"config\": { \"baud\": %u, \"chunk\": %u, \"ring\": %u, \"idle_ms\": %u, \"handshake_ms\": %u, \"latency_chunk\": %u },\n",
+            base.baud, base.chunk, base.ringSize, base.idleMs, base.handshakeMs, PIPE_LAT_CHUNK);
+    fprintf(o, "  \"runs\": [\n");
+    for (i = 0; i < 2; i++) {
+        PipeConfig c = base;
+        PipeResult r;
+        uint8_t *data = HostFile_Load(paths[i], &c.len);
+        if (!data || c.len == 0) { fprintf(stderr, "cannot read %s\n", paths[i]); free(data); fail = 1; continue; }
+        c.mode = i == 0 ? PIPE_BITSTREAM : PIPE_FIRMWARE;
+        c.data = data;
+        if (Pipeline_Run(&c, &r) < 0) { fprintf(stderr, "%s: pipeline setup failed\n", names[i]); fail = 1; }
+        else {
+            Json_Run(o, names[i], paths[i], &c, &r, i == 1);
+            if (!r.pass) { fprintf(stderr, "%s: FAIL\n", names[i]); fail = 1; }
+        }
+        free(data);
+    }
+    fprintf(o, "  ]\n}\n");
+    if (o != stdout) fclose(o);
+    return fail;
+}
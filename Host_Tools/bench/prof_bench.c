@@ -0,0 +1,60 @@
+/*
+ * Session profiler benchmark
+ * - Cost of the aggregation calls the firmware makes on the hot paths
+ *   (one Sample per Send_Command, one Level per pump batch)
+ * - Then a profiled single-Gowin session in TCKs at the 12 MHz SPI clock,
+ *   printed in the same format as the Cmd_Call "prof" report
+ * usage: prof_bench [bitstream.bin]
+ */
+
+#include "host_file.h"
+#include "jtag_master.h"
+#include "session_prof.h"
+#include "tap_chain.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define ITERATIONS 20000000u
+
+static double Now_Ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+    SessionProf p;
+    volatile uint32_t sink;
+    TapChain chain; JtagMaster m;
+    size_t len = 0;
+    uint8_t *bits = HostFile_Load(argc > 1 ? argv[1] : "../JTAG_Programmer_Serial/output1.bin", &len);
+    double t0;
+    uint32_t i;
+
+    SessionProf_Begin(&p, PROF_FW_TICK_HZ, PROF_FW_RING);
+    t0 = Now_Ns();
+    for (i = 0; i < ITERATIONS; i++) SessionProf_Sample(&p, PROF_COMMAND, (i * 2654435761u) >> 22);
+    printf("Sample: %6.2f ns/call\n", (Now_Ns() - t0) / ITERATIONS);
+
+    t0 = Now_Ns();
+    for (i = 0; i < ITERATIONS; i++) SessionProf_Level(&p, (i * 2654435761u) >> 23);
+    sink = p.highWater;
+    printf("Level:  %6.2f ns/call (high-water %u)\n", (Now_Ns() - t0) / ITERATIONS, (unsigned)sink);
+
+    if (!bits) { fprintf(stderr, "cannot read bitstream\n"); return 1; }
+    TapChain_Init(&chain); TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    SessionProf_Begin(&p, 12000000, PROF_FW_RING);
+    m.prof = &p;
+    Jtag_ResetTap(&m);
+    Jtag_InitConfiguration(&m);
+    Jtag_StreamBitstream(&m, bits, len);
+    Jtag_FinishConfiguration(&m);
+    printf("\nsession: %zu bytes, %llu TCKs, DONE %s\n", len, (unsigned long long)m.tckCount,
+           (TapChain_Gowin(&chain, 0)->leds & LED_PROG_5) ? "yes" : "no");
+    SessionProf_Print(&p, stdout);
+    free(bits);
+    return 0;
+}
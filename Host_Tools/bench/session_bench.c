@@ -0,0 +1,50 @@
+/*
+ * Session benchmark: bitstream then firmware against one overlapped session
+ * - Builds the session image from the bitstream and executable and walks
+ *   both schedules (sim/session_sched.c) at 115200, 230769 and 921600 baud
+ *   on the host link, for the bootloader and the debug module load
+ * - Reports the total to the core started, the bound max(bitstream alone,
+ *   firmware alone), when the stage filled against DONE, and the most
+ *   bytes the ring held while the pump waited on flash
+ * usage: session_bench [bitstream.bin [firmware.exe]]
+ */
+
+#include "host_file.h"
+#include "session_image.h"
+#include "session_sched.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+    static const uint32_t bauds[] = { 115200, 230769, 921600 };
+    static const SchedLoad loads[] = { SCHED_BOOTLOADER, SCHED_DEBUG };
+    size_t len, fwLen, cap, imgLen, i, j;
+    uint8_t *bits = HostFile_Load(argc > 1 ? argv[1] : "../JTAG_Programmer_Serial/output1.bin", &len);
+    uint8_t *fw = HostFile_Load(argc > 2 ? argv[2] : "../JTAG_Programmer_Serial/hello.exe", &fwLen);
+    uint8_t *img;
+
+    if (!bits || !fw) { fprintf(stderr, "cannot read bitstream or executable\n"); return 1; }
+    cap = SessionImage_Size(len, fwLen, 256);
+    img = malloc(cap);
+    imgLen = SessionImage_Build(bits, len, fw, fwLen, 256, img, cap);
+    printf("bitstream %zu bytes, executable %zu bytes, session image %zu bytes\n", len, fwLen, imgLen);
+    printf("load        baud   sequential_ms  overlapped_ms   bound_ms  saved  staged_ms  done_ms  ring_hw\n");
+    for (i = 0; i < sizeof(loads) / sizeof(loads[0]); i++) {
+        for (j = 0; j < sizeof(bauds) / sizeof(bauds[0]); j++) {
+            SchedConfig c;
+            SchedTimeline seq, ovl;
+            Sched_Defaults(&c, len, fwLen);
+            c.load = loads[i];
+            c.hostBaud = bauds[j];
+            Sched_Sequential(&c, &seq);
+            Sched_Overlapped(&c, img, imgLen, &ovl);
+            printf("%-10s %7u %15.1f %14.1f %10.1f %5.0f%% %10.1f %8.1f %8u\n",
+                   loads[i] == SCHED_DEBUG ? "debug" : "bootloader", bauds[j], seq.totalMs, ovl.totalMs,
+                   ovl.boundMs, 100.0 * (seq.totalMs - ovl.totalMs) / seq.totalMs,
+                   ovl.stage[SCHED_STAGE].end, ovl.stage[SCHED_SHIFT].end, ovl.ringHighWater);
+        }
+    }
+    free(bits); free(fw); free(img);
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * Programming station benchmark: how one process scales with the ports
+ * - 1 to 64 simulated programmers (sim/mcu_farm.c) on ptys, every one
+ *   given the whole bitstream by lib/station.c at once
+ * - Prints the wall time, the slowest and mean per-board rate, the
+ *   aggregate rate and the station's own CPU time per board. The ptys are
+ *   unpaced, so the rates are the host's and the models' ceiling, not a
+ *   USB link's; the CPU per board is what says the event loop scales
+ * usage: station_bench [-c chunk] [bitstream.bin]
+ */
+
+#include "mcu_farm.h"
+#include "station.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+static double Cpu_Ms(void) {
+    struct rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    return (double)(u.ru_utime.tv_sec + u.ru_stime.tv_sec) * 1e3 +
+           (double)(u.ru_utime.tv_usec + u.ru_stime.tv_usec) / 1e3;
+}
+
+int main(int argc, char **argv) {
+    static const int ports[] = { 1, 4, 16, 32, 64 };
+    static Station st;
+    const char *in = "../JTAG_Programmer_Serial/output1.bin";
+    uint32_t chunk = 256;
+    const uint8_t *data;
+    size_t len, k;
+    int a;
+
+    for (a = 1; a < argc; a++) {
+        if (strcmp(argv[a], "-c") == 0 && a + 1 < argc) chunk = (uint32_t)strtoul(argv[++a], NULL, 0);
+        else in = argv[a];
+    }
+    if (Station_MapFile(in, &data, &len) < 0) { perror(in); return 1; }
+    printf("bitstream %zu bytes, chunk %u, mapped once\n", len, chunk);
+    printf("ports  done  wall_ms  min_KiB/s  mean_KiB/s  aggregate_KiB/s  cpu_ms/port\n");
+    for (k = 0; k < sizeof(ports) / sizeof(ports[0]); k++) {
+        McuFarmConfig c = { ports[k], 4096, 0, 0, 0, 20.0 };
+        McuFarm f;
+        double cpu, lo = 0, sum = 0;
+        int i;
+        if (McuFarm_Start(&f, &c) < 0) { perror("pty"); return 1; }
+        if (Station_Init(&st, data, len, chunk, 0) < 0) { perror("epoll"); return 1; }
+        cpu = Cpu_Ms();
+        for (i = 0; i < ports[k]; i++) Station_Add(&st, McuFarm_Path(&f, i));
+        Station_Run(&st);
+        cpu = Cpu_Ms() - cpu;
+        for (i = 0; i < st.count; i++) {
+            double r = Station_PortRate(&st, i) / 1024.0;
+            if (i == 0 || r < lo) lo = r;
+            sum += r;
+        }
+        printf("%5d %5d %8.0f %10.0f %11.0f %16.0f %12.2f\n", ports[k], st.done, st.wallMs, lo, sum / st.count,
+               (double)st.done * (double)len / 1024.0 * 1000.0 / st.wallMs, cpu / ports[k]);
+        Station_Free(&st);
+        McuFarm_Free(&f);
+    }
+    Station_UnmapFile(data, len);
+    return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * Baud negotiation, host side
+ */
+
+#include "baud_host.h"
+#include "pty_link.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_TRIES   4
+#define CONFIRM_GAP 100.0   // Between CONFIRMs at the new rate
+
+const char *BaudHost_StateName(BaudHostState st) {
+    static const char *Names[] = { "TRY", "TRIAL", "BACK", "SET", "CONFIRM", "DONE", "FAIL" };
+    return (unsigned)st < sizeof(Names) / sizeof(Names[0]) ? Names[st] : "?";
+}
+
+int BaudHost_Finished(const BaudHost *h) { return h->state == BHOST_DONE || h->state == BHOST_FAIL; }
+
+static void Send(BaudHost *h, uint8_t op, uint8_t index) {
+    if (h->txLen + BAUD_FRAME_SIZE > sizeof(h->tx)) return;
+    BaudLink_Frame(op, index, 0, h->tx + h->txLen);
+    h->txLen += BAUD_FRAME_SIZE;
+}
+
+static void Switch(BaudHost *h, uint8_t index) {
+    h->rate = index;
+    h->switchTo = index;
+    h->rxLen = 0;
+}
+
+static void Try(BaudHost *h, double now) {
+    Send(h, BAUD_TRY, h->trial);
+    h->state = BHOST_TRY;
+    h->deadline = now + BAUD_READY_MS;
+}
+
+static void Set(BaudHost *h, uint8_t index, double now) {
+    h->target = index;
+    h->tries = 1;
+    Send(h, BAUD_SET, index);
+    h->state = BHOST_SET;
+    h->deadline = now + BAUD_READY_MS;
+}
+
+void BaudHost_Begin(BaudHost *h, uint8_t base, uint8_t top, double now) {
+    uint32_t i;
+    memset(h, 0, sizeof(*h));
+    for (i = 0; i < BAUD_COUNT; i++) h->mcuErrors[i] = h->hostErrors[i] = -1;
+    h->base = h->best = h->rate = base;
+    h->top = top < BAUD_COUNT ? top : BAUD_COUNT - 1;
+    h->switchTo = -1;
+    h->tries = 1;
+    h->trial = (uint8_t)(base + 1);
+    if (h->trial > h->top) Set(h, base, now);
+    else Try(h, now);
+}
+
+// The frame of `op` for `index` at the tail of rx, and where it starts
+static int Find(const BaudHost *h, uint8_t op, uint8_t index, size_t *at) {
+    size_t p;
+    for (p = 0; p + BAUD_FRAME_SIZE <= h->rxLen; p++) {
+        uint8_t o, i, a;
+        if (BaudLink_Parse(h->rx + p, &o, &i, &a) && o == op && i == index) { *at = p; return 1; }
+    }
+    return 0;
+}
+
+static void End_Trial(BaudHost *h, int mcuErrors, int hostErrors, double now) {
+    h->mcuErrors[h->trial] = mcuErrors;
+    h->hostErrors[h->trial] = hostErrors;
+    h->passed = mcuErrors == 0 && hostErrors == 0;
+    Switch(h, h->base);
+    h->state = BHOST_BACK;
+    h->deadline = now + BAUD_SETTLE_MS;
+}
+
+void BaudHost_Rx(BaudHost *h, const uint8_t *buf, size_t n, double now) {
+    size_t at, k = sizeof(h->rx) - h->rxLen < n ? sizeof(h->rx) - h->rxLen : n;
+    if (BaudHost_Finished(h) || h->state == BHOST_BACK) return;
+    memcpy(h->rx + h->rxLen, buf, k);
+    h->rxLen += k;
+    switch (h->state) {
+    case BHOST_TRY:
+        if (Find(h, BAUD_READY, h->trial, &at)) {
+            Switch(h, h->trial);
+            h->state = BHOST_TRIAL;
+            h->sendAt = now + BAUD_SETTLE_MS;
+            h->deadline = now + BAUD_REPLY_MS;
+        }
+        break;
+    case BHOST_TRIAL:
+        // The MCU's pattern is everything ahead of its verdict
+        if (Find(h, BAUD_VERDICT, h->trial, &at)) {
+            int errors = 0;
+            size_t i;
+            if (at != BAUD_PATTERN_SIZE) errors = BAUD_PATTERN_SIZE;
+            else for (i = 0; i < at; i++) errors += h->rx[i] != BaudLink_Pattern((uint32_t)i);
+            End_Trial(h, h->rx[at + 3], errors, now);
+        }
+        break;
+    case BHOST_SET:
+        if (Find(h, BAUD_READY, h->target, &at)) {
+            if (h->target == h->base) { h->state = BHOST_DONE; break; }
+            Switch(h, h->target);
+            h->state = BHOST_CONFIRM;
+            h->tries = 0;
+            h->sendAt = now + BAUD_SETTLE_MS;
+            h->deadline = now + BAUD_CONFIRM_MS;
+        }
+        break;
+    case BHOST_CONFIRM:
+        if (Find(h, BAUD_CONFIRM, h->target, &at)) {
+            h->base = h->target;
+            h->state = BHOST_DONE;
+        }
+        break;
+    default:
+        break;
+    }
+    // Keep the tail a frame could still start in
+    if (h->rxLen == sizeof(h->rx)) {
+        memmove(h->rx, h->rx + h->rxLen - (BAUD_FRAME_SIZE - 1), BAUD_FRAME_SIZE - 1);
+        h->rxLen = BAUD_FRAME_SIZE - 1;
+    }
+}
+
+void BaudHost_Tick(BaudHost *h, double now) {
+    uint32_t i;
+    switch (h->state) {
+    case BHOST_TRY:
+    case BHOST_SET:
+        if (now < h->deadline) break;
+        // A READY lost leaves the MCU on the trial rate until its own timeout
+        if (h->tries++ < MAX_TRIES) {
+            h->retries++;
+            Send(h, h->state == BHOST_TRY ? BAUD_TRY : BAUD_SET, h->state == BHOST_TRY ? h->trial : h->target);
+            h->deadline = now + BAUD_READY_MS;
+        } else {
+            h->state = BHOST_FAIL;
+        }
+        break;
+    case BHOST_TRIAL:
+        if (h->sendAt && now >= h->sendAt) {
+            for (i = 0; i < BAUD_PATTERN_SIZE; i++) h->tx[h->txLen++] = BaudLink_Pattern(i);
+            h->sendAt = 0;
+        }
+        if (now >= h->deadline) End_Trial(h, 255, BAUD_PATTERN_SIZE, now);
+        break;
+    case BHOST_BACK:
+        if (now < h->deadline) break;
+        h->rxLen = 0;
+        if (h->passed) h->best = h->trial;
+        if (h->passed && h->trial < h->top) {
+            h->trial++;
+            h->tries = 1;
+            Try(h, now);
+        } else {
+            Set(h, h->best, now);
+        }
+        break;
+    case BHOST_CONFIRM:
+        if (now >= h->deadline) {
+            // Nothing came back at the new rate: the MCU has gone home by
+            // now (it switched first), so go home too and end it there
+            h->confirmsLost++;
+            Switch(h, h->base);
+            h->best = h->base;
+            h->passed = 0;
+            h->state = BHOST_BACK;
+            h->deadline = now + BAUD_SETTLE_MS;
+        } else if (h->sendAt && now >= h->sendAt && h->tries < MAX_TRIES) {
+            Send(h, BAUD_CONFIRM, h->target);
+            h->tries++;
+            h->sendAt = now + CONFIRM_GAP;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+size_t BaudHost_TakeTx(BaudHost *h, uint8_t *buf, size_t max) {
+    size_t n = h->txLen < max ? h->txLen : max;
+    memcpy(buf, h->tx, n);
+    memmove(h->tx, h->tx + n, h->txLen - n);
+    h->txLen -= n;
+    return n;
+}
+
+int BaudHost_TakeSwitch(BaudHost *h) {
+    int s = h->switchTo;
+    if (h->txLen) return -1;
+    h->switchTo = -1;
+    return s;
+}
+
+// --- PORT ---
+static double Now_Ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+BaudHostState BaudHost_Port(BaudHost *h, int fd, uint8_t base, uint8_t top) {
+    static const uint8_t Command[] = "baud\r";
+    uint8_t buf[512];
+    if (PtyLink_SetBaud(fd, BaudLink_Rates[base]) < 0 || PtyLink_WriteAll(fd, Command, sizeof(Command) - 1) < 0) {
+        h->state = BHOST_FAIL;
+        return h->state;
+    }
+    BaudHost_Begin(h, base, top, Now_Ms());
+    while (!BaudHost_Finished(h)) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        size_t n;
+        int to;
+        BaudHost_Tick(h, Now_Ms());
+        while ((n = BaudHost_TakeTx(h, buf, sizeof(buf))) > 0) {
+            if (PtyLink_WriteAll(fd, buf, n) < 0) { h->state = BHOST_FAIL; break; }
+        }
+        if ((to = BaudHost_TakeSwitch(h)) >= 0) {
+            tcdrain(fd);
+            if (PtyLink_SetBaud(fd, BaudLink_Rates[to]) < 0) { h->state = BHOST_FAIL; break; }
+        }
+        if (poll(&p, 1, 2) > 0) {
+            ssize_t got = read(fd, buf, sizeof(buf));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) { h->state = BHOST_FAIL; break; }
+            BaudHost_Rx(h, buf, (size_t)got, Now_Ms());
+        }
+    }
+    // A failure leaves the port where the MCU is: the base rate
+    if (h->state == BHOST_FAIL) PtyLink_SetBaud(fd, BaudLink_Rates[h->base]);
+    return h->state;
+}
@@ -0,0 +1,51 @@
+/*
+ * Baud negotiation, host side
+ * - The other half of baud_link.h as a state machine: fed with the time
+ *   and the bytes read, it gives the bytes to send and the rate switches,
+ *   each switch once the bytes before it are out (tcdrain)
+ * - Climbs from `base` one candidate at a time up to `top` (the fastest
+ *   rate the host's port can be set to), and keeps the last clean one
+ * - BaudHost_Port runs it on a port, switching it with termios, and
+ *   leaves the port at the rate agreed
+ */
+
+#ifndef BAUD_HOST_H
+#define BAUD_HOST_H
+
+#include "baud_link.h"
+
+typedef enum { BHOST_TRY, BHOST_TRIAL, BHOST_BACK, BHOST_SET, BHOST_CONFIRM, BHOST_DONE, BHOST_FAIL } BaudHostState;
+
+typedef struct {
+    BaudHostState state;
+    uint8_t  base, top;
+    uint8_t  trial;              // Rate index being tried (TRY / TRIAL / BACK)
+    uint8_t  target;             // Rate index being set (SET / CONFIRM)
+    uint8_t  best;               // Fastest clean rate so far
+    uint8_t  rate;               // Rate index the port is at (after the pending switch)
+    int      passed;             // The last trial
+    int      tries;
+    double   deadline, sendAt;
+    uint8_t  rx[BAUD_PATTERN_SIZE + 64];
+    size_t   rxLen;
+    uint8_t  tx[BAUD_PATTERN_SIZE];
+    size_t   txLen;
+    int      switchTo;
+    // Per candidate: -1 not tried, else errors the MCU saw / the host saw
+    int      mcuErrors[BAUD_COUNT], hostErrors[BAUD_COUNT];
+    uint32_t retries, confirmsLost;
+} BaudHost;
+
+void   BaudHost_Begin(BaudHost *h, uint8_t base, uint8_t top, double now);
+void   BaudHost_Rx(BaudHost *h, const uint8_t *buf, size_t n, double now);
+void   BaudHost_Tick(BaudHost *h, double now);
+size_t BaudHost_TakeTx(BaudHost *h, uint8_t *buf, size_t max);
+int    BaudHost_TakeSwitch(BaudHost *h);
+int    BaudHost_Finished(const BaudHost *h);
+const char *BaudHost_StateName(BaudHostState st);
+
+// Sends "baud\r" at the port's rate, then negotiates; returns the state
+// (BHOST_DONE with h->rate in use, or BHOST_FAIL at base)
+BaudHostState BaudHost_Port(BaudHost *h, int fd, uint8_t base, uint8_t top);
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * Baud negotiation on the host link
+ */
+
+#include "baud_link.h"
+
+#include <string.h>
+
+const uint32_t BaudLink_Rates[BAUD_COUNT] = { 230400, 460800, 921600, 1000000, 1500000, 2000000, 3000000 };
+
+// A step of 167: every byte once, and never a sync byte followed by an op
+uint8_t BaudLink_Pattern(uint32_t i) { return (uint8_t)(i * 167u + 0x3Cu); }
+
+void BaudLink_Frame(uint8_t op, uint8_t index, uint8_t arg, uint8_t out[BAUD_FRAME_SIZE]) {
+    out[0] = BAUD_SYNC;
+    out[1] = op;
+    out[2] = index;
+    out[3] = arg;
+    out[4] = (uint8_t)(0x5Au ^ BAUD_SYNC ^ op ^ index ^ arg);
+}
+
+int BaudLink_Parse(const uint8_t in[BAUD_FRAME_SIZE], uint8_t *op, uint8_t *index, uint8_t *arg) {
+    if (in[0] != BAUD_SYNC || in[4] != (uint8_t)(0x5Au ^ in[0] ^ in[1] ^ in[2] ^ in[3]) || in[2] >= BAUD_COUNT) return 0;
+    *op = in[1];
+    *index = in[2];
+    *arg = in[3];
+    return 1;
+}
+
+int BaudLink_Index(uint32_t baud) {
+    uint32_t i;
+    for (i = 0; i < BAUD_COUNT; i++) {
+        if (BaudLink_Rates[i] == baud) return (int)i;
+    }
+    return -1;
+}
+
+// --- MCU ---
+static void Send(BaudMcu *m, uint8_t op, uint8_t index, uint8_t arg) {
+    if (m->txLen + BAUD_FRAME_SIZE > sizeof(m->tx)) return;
+    BaudLink_Frame(op, index, arg, m->tx + m->txLen);
+    m->txLen += BAUD_FRAME_SIZE;
+}
+
+static void Switch(BaudMcu *m, uint8_t index) {
+    m->rate = index;
+    m->switchTo = index;
+    m->rxLen = 0;
+}
+
+static void Back_To_Base(BaudMcu *m, double now) {
+    Switch(m, m->base);
+    m->state = BMCU_BASE;
+    m->deadline = now + BAUD_IDLE_MS;
+}
+
+void BaudMcu_Begin(BaudMcu *m, uint8_t current, double now) {
+    memset(m, 0, sizeof(*m));
+    m->base = m->rate = m->trial = current;
+    m->switchTo = -1;
+    m->state = BMCU_BASE;
+    m->deadline = now + BAUD_IDLE_MS;
+}
+
+// The pattern back and the verdict, at the trial rate, then home
+static void End_Trial(BaudMcu *m, double now) {
+    uint32_t i;
+    m->errors += BAUD_PATTERN_SIZE - m->got;
+    for (i = 0; i < BAUD_PATTERN_SIZE; i++) m->tx[m->txLen++] = BaudLink_Pattern(i);
+    Send(m, BAUD_VERDICT, m->trial, (uint8_t)(m->errors > 255 ? 255 : m->errors));
+    Back_To_Base(m, now);
+}
+
+static void Handle(BaudMcu *m, uint8_t op, uint8_t index, double now) {
+    m->frames++;
+    if (m->state == BMCU_BASE && op == BAUD_TRY) {
+        Send(m, BAUD_READY, index, 0);
+        Switch(m, index);
+        m->state = BMCU_TRIAL;
+        m->trial = index;
+        m->got = m->errors = 0;
+        m->trials++;
+        m->deadline = now + BAUD_TRIAL_MS;
+    } else if (m->state == BMCU_BASE && op == BAUD_SET) {
+        Send(m, BAUD_READY, index, 0);
+        if (index == m->base) {
+            m->state = BMCU_DONE;
+        } else {
+            Switch(m, index);
+            m->state = BMCU_CONFIRM;
+            m->deadline = now + BAUD_CONFIRM_MS;
+        }
+    } else if ((m->state == BMCU_CONFIRM || m->state == BMCU_CONFIRMED) && op == BAUD_CONFIRM && index == m->rate) {
+        // Kept from the first one; later ones only mean the reply was lost
+        Send(m, BAUD_CONFIRM, index, 0);
+        if (m->state == BMCU_CONFIRM) m->deadline = now + BAUD_CONFIRM_MS;
+        m->state = BMCU_CONFIRMED;
+        m->base = index;
+    }
+}
+
+void BaudMcu_Rx(BaudMcu *m, const uint8_t *buf, size_t n, double now) {
+    size_t i;
+    for (i = 0; i < n && m->state != BMCU_DONE; i++) {
+        if (m->state == BMCU_TRIAL) {
+            if (buf[i] != BaudLink_Pattern(m->got)) m->errors++;
+            if (++m->got == BAUD_PATTERN_SIZE) End_Trial(m, now);
+            continue;
+        }
+        // Anything else is a frame, found wherever it checks out
+        m->rx[m->rxLen++] = buf[i];
+        if (m->rxLen == BAUD_FRAME_SIZE) {
+            uint8_t op, index, arg;
+            if (BaudLink_Parse(m->rx, &op, &index, &arg)) {
+                m->rxLen = 0;
+                Handle(m, op, index, now);
+            } else {
+                memmove(m->rx, m->rx + 1, --m->rxLen);
+            }
+        }
+    }
+}
+
+void BaudMcu_Tick(BaudMcu *m, double now) {
+    if (m->state == BMCU_DONE || now < m->deadline) return;
+    switch (m->state) {
+    case BMCU_TRIAL:     End_Trial(m, now); break;
+    case BMCU_CONFIRM:   Back_To_Base(m, now); break;   // The new rate never carried a CONFIRM
+    case BMCU_CONFIRMED: m->state = BMCU_DONE; break;
+    default:             m->state = BMCU_DONE; break;   // The host went away
+    }
+}
+
+size_t BaudMcu_TakeTx(BaudMcu *m, uint8_t *buf, size_t max) {
+    size_t n = m->txLen < max ? m->txLen : max;
+    memcpy(buf, m->tx, n);
+    memmove(m->tx, m->tx + n, m->txLen - n);
+    m->txLen -= n;
+    return n;
+}
+
+int BaudMcu_TakeSwitch(BaudMcu *m) {
+    int s = m->switchTo;
+    if (m->txLen) return -1;   // Not before the bytes ahead of it are out
+    m->switchTo = -1;
+    return s;
+}
@@ -0,0 +1,75 @@
+/*
+ * Baud negotiation on the host link
+ * - Mirror of baud_link.ads: the candidate rates, the 5-byte frames (sync,
+ *   op, rate index, argument, check) and the 256-byte test pattern, every
+ *   byte value once
+ * - The host steps up from the rate both sides are at: TRY at that rate,
+ *   READY back, then both switch, the host sends the pattern, the MCU
+ *   checks it and sends its own with a VERDICT (errors seen), then both
+ *   go back. The first trial with any error ends the climb
+ * - SET the fastest clean rate, READY back, both switch and the host has
+ *   to get a CONFIRM through at the new rate; otherwise both fall back
+ * - BaudMcu is the programmer's side as a state machine: bytes and the
+ *   time in, bytes to send and rate switches out, the switch only once
+ *   the bytes before it are on the wire (UART_Flush)
+ */
+
+#ifndef BAUD_LINK_H
+#define BAUD_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BAUD_COUNT         7u
+#define BAUD_POWER_UP      0u          // BRR 16#0D#: 48 MHz / 208 = 230769
+#define BAUD_FRAME_SIZE    5u
+#define BAUD_PATTERN_SIZE  256u
+#define BAUD_SYNC          0xB5u
+
+#define BAUD_TRY           0x54u       // 'T' host, at the base rate
+#define BAUD_READY         0x52u       // 'R' MCU, at the base rate
+#define BAUD_VERDICT       0x56u       // 'V' MCU, at the trial rate, arg = errors
+#define BAUD_SET           0x53u       // 'S' host, at the base rate
+#define BAUD_CONFIRM       0x4Bu       // 'K' both, at the new rate
+
+// Milliseconds, the same on both sides
+#define BAUD_SETTLE_MS     20.0        // After a switch, before sending
+#define BAUD_TRIAL_MS      250.0       // MCU: the pattern, from its switch
+#define BAUD_REPLY_MS      500.0       // Host: pattern and verdict, from its switch
+#define BAUD_READY_MS      300.0       // Host: READY, from TRY or SET
+#define BAUD_CONFIRM_MS    400.0       // MCU: CONFIRM at the new rate
+#define BAUD_IDLE_MS       3000.0      // MCU: nothing at the base rate
+
+extern const uint32_t BaudLink_Rates[BAUD_COUNT];
+
+uint8_t BaudLink_Pattern(uint32_t i);
+// One frame into out; 1 if in is one
+void    BaudLink_Frame(uint8_t op, uint8_t index, uint8_t arg, uint8_t out[BAUD_FRAME_SIZE]);
+int     BaudLink_Parse(const uint8_t in[BAUD_FRAME_SIZE], uint8_t *op, uint8_t *index, uint8_t *arg);
+// Rate index for a baud, or -1
+int     BaudLink_Index(uint32_t baud);
+
+typedef enum { BMCU_BASE, BMCU_TRIAL, BMCU_CONFIRM, BMCU_CONFIRMED, BMCU_DONE } BaudMcuState;
+
+typedef struct {
+    BaudMcuState state;
+    uint8_t  base;                // Rate index both sides fall back to
+    uint8_t  rate;                // Rate index the USART is at (after the pending switch)
+    uint8_t  trial;
+    uint32_t got, errors;         // Pattern bytes in the trial, wrong or missing
+    double   deadline;
+    uint8_t  rx[BAUD_FRAME_SIZE];
+    size_t   rxLen;
+    uint8_t  tx[BAUD_PATTERN_SIZE + 2 * BAUD_FRAME_SIZE];
+    size_t   txLen;
+    int      switchTo;            // -1, or a rate index once tx is out
+    uint32_t trials, frames;
+} BaudMcu;
+
+void   BaudMcu_Begin(BaudMcu *m, uint8_t current, double now);
+void   BaudMcu_Rx(BaudMcu *m, const uint8_t *buf, size_t n, double now);
+void   BaudMcu_Tick(BaudMcu *m, double now);
+size_t BaudMcu_TakeTx(BaudMcu *m, uint8_t *buf, size_t max);
+int    BaudMcu_TakeSwitch(BaudMcu *m);
+
+#endif
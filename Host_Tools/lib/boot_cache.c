@@ -0,0 +1,96 @@
+/*
+ * Boot cache image
+ */
+
+#include "boot_cache.h"
+#include "gowin_tap.h"
+#include "jtag_fanout.h"
+#include "jtag_master.h"
+
+#include <string.h>
+
+#define CRC_CYCLES_PER_WORD 4.0    // CRC unit plus the feed loop, per word
+#define MCU_HZ              48e6
+
+static const char *const names[] = { "LOAD", "NO_IMAGE", "BAD_HEADER", "TOO_LARGE", "BAD_CRC", "SKIPPED" };
+
+const char *BootAction_Name(BootAction a) {
+    return (unsigned)a < sizeof(names) / sizeof(names[0]) ? names[a] : "?";
+}
+
+uint32_t BootCache_Crc32(const uint8_t *data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    size_t i;
+    int b;
+    for (i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+    }
+    return ~crc;
+}
+
+uint32_t BootCache_Padded(uint32_t length) {
+    return (length + 3u) & ~3u;
+}
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void Put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+size_t BootCache_Build(const uint8_t *bits, size_t len, uint8_t *image, size_t cap) {
+    uint32_t padded = BootCache_Padded((uint32_t)len), crc;
+    size_t size = BOOT_HEADER_SIZE + padded;
+    if (len == 0 || len > 0xFFFFFFF0u || size > cap) return 0;
+    memset(image, 0, size);
+    memcpy(image + BOOT_HEADER_SIZE, bits, len);
+    crc = BootCache_Crc32(image + BOOT_HEADER_SIZE, padded);
+    Put32(image, BOOT_MAGIC);
+    Put32(image + 4, (uint32_t)len);
+    Put32(image + 8, crc);
+    Put32(image + 12, ~(BOOT_MAGIC ^ (uint32_t)len ^ crc));
+    return size;
+}
+
+// boot_cache.Decide then boot_cache.Verify
+BootAction BootCache_Decide(const uint8_t *area, size_t areaSize, int skip) {
+    BootHeader h;
+    if (skip || areaSize < BOOT_HEADER_SIZE) return BOOT_SKIPPED;
+    h.magic = Get32(area); h.length = Get32(area + 4); h.crc = Get32(area + 8); h.check = Get32(area + 12);
+    if (h.magic == 0xFFFFFFFFu) return BOOT_NO_IMAGE;
+    if (h.magic != BOOT_MAGIC || h.check != ~(h.magic ^ h.length ^ h.crc) || h.length == 0) return BOOT_BAD_HEADER;
+    if (h.length > areaSize - BOOT_HEADER_SIZE || BootCache_Padded(h.length) > areaSize - BOOT_HEADER_SIZE) return BOOT_TOO_LARGE;
+    if (BootCache_Crc32(area + BOOT_HEADER_SIZE, BootCache_Padded(h.length)) != h.crc) return BOOT_BAD_CRC;
+    return BOOT_LOAD;
+}
+
+BootAction BootCache_Boot(const uint8_t *area, size_t areaSize, double spiHz, double bitbangHz, BootReport *r) {
+    static GowinTap tap;
+    JtagMaster m;
+    uint32_t len;
+
+    memset(r, 0, sizeof(*r));
+    r->result = BootCache_Decide(area, areaSize, 0);
+    if (r->result == BOOT_NO_IMAGE || r->result == BOOT_BAD_HEADER || r->result == BOOT_TOO_LARGE) return r->result;
+    len = Get32(area + 4);
+    r->crcUs = BootCache_Padded(len) / 4 * CRC_CYCLES_PER_WORD / MCU_HZ * 1e6;
+    if (r->result != BOOT_LOAD) return r->result;
+
+    // Load_Boot_Image: reset, init, the whole image from flash, trailer
+    GowinTap_Init(&tap);
+    Jtag_Init(&m, GowinTap_ClockFn, &tap);
+    Jtag_ResetTap(&m);
+    Jtag_InitConfiguration(&m);
+    Jtag_StreamBitstream(&m, area + BOOT_HEADER_SIZE, len);
+    Jtag_FinishConfiguration(&m);
+    r->tck = m.tckCount;
+    r->status = Jtag_ReadStatus(&m);   // For the report; Capture_Status_All already did this scan
+    r->done = (r->status & STATUS_DONE_BIT) != 0;
+    r->bytes = len;
+    r->streamBits = (uint64_t)(len - 1) * 8;   // The last byte goes out bit-banged
+    r->loadUs = (double)r->streamBits / spiHz * 1e6 + (double)(r->tck - r->streamBits) / bitbangHz * 1e6;
+    return r->result;
+}
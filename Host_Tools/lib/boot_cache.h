@@ -0,0 +1,65 @@
+/*
+ * Boot cache image
+ * - Mirror of boot_cache.ads: a 16-byte header (magic "GWBC", length,
+ *   CRC-32 of the padded payload, check word) in front of a bitstream,
+ *   kept in the top Cache_Size bytes of the STM32's flash
+ * - BootCache_Build writes an image, BootCache_Decide is what the firmware
+ *   does with one at power-up, BootCache_Boot runs the load into the
+ *   Gowin TAP model and models the time to user mode
+ */
+
+#ifndef BOOT_CACHE_H
+#define BOOT_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BOOT_MAGIC        0x43425747u   // "GWBC" little-endian
+#define BOOT_HEADER_SIZE  16u
+#define BOOT_AREA_DEFAULT 65536u        // Cache_Size default in alire.toml
+#define BOOT_FLASH_END    0x08020000u   // STM32F070RB, 128 KiB
+
+typedef enum {
+    BOOT_LOAD,
+    BOOT_NO_IMAGE,
+    BOOT_BAD_HEADER,
+    BOOT_TOO_LARGE,
+    BOOT_BAD_CRC,
+    BOOT_SKIPPED
+} BootAction;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t length;   // Bitstream bytes
+    uint32_t crc;
+    uint32_t check;    // ~(magic ^ length ^ crc)
+} BootHeader;
+
+typedef struct {
+    BootAction result;
+    uint32_t   bytes;
+    uint32_t   status;       // Status register read back after the load
+    int        done;
+    uint64_t   tck;          // Every TCK of the session
+    uint64_t   streamBits;   // Of those, shifted by SPI1
+    double     crcUs;        // Modelled: CRC unit over the padded payload
+    double     loadUs;       // Modelled: bit-banged TCKs plus the SPI stream
+} BootReport;
+
+const char *BootAction_Name(BootAction a);
+
+uint32_t BootCache_Crc32(const uint8_t *data, size_t len);   // zlib CRC-32
+uint32_t BootCache_Padded(uint32_t length);
+
+// Image for `len` bitstream bytes: header, payload, zero padding.
+// Returns the image size, or 0 if it does not fit in `cap`
+size_t   BootCache_Build(const uint8_t *bits, size_t len, uint8_t *image, size_t cap);
+
+// Same order of checks as the firmware, CRC included
+BootAction BootCache_Decide(const uint8_t *area, size_t areaSize, int skip);
+
+// Decide, then on LOAD configure a Gowin TAP from the image with SPI1 at
+// spiHz and the bit-banged TCKs at bitbangHz
+BootAction BootCache_Boot(const uint8_t *area, size_t areaSize, double spiHz, double bitbangHz, BootReport *r);
+
+#endif
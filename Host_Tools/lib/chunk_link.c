@@ -0,0 +1,113 @@
+/*
+ * Chunked upload link
+ */
+
+#include "chunk_link.h"
+
+#include <string.h>
+
+// chunk_link.CRC_Update: a nibble at a time, 16 words of table
+static const uint32_t Nibble[16] = {
+    0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+    0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+};
+
+uint32_t ChunkLink_Crc32(uint32_t crc, const uint8_t *data, size_t len) {
+    size_t i;
+    crc = ~crc;
+    for (i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ Nibble[crc & 0xFu];
+        crc = (crc >> 4) ^ Nibble[crc & 0xFu];
+    }
+    return ~crc;
+}
+
+uint16_t ChunkLink_HeaderCheck(uint16_t seq, uint16_t len, uint16_t flags) {
+    return (uint16_t)~(seq ^ len ^ flags);
+}
+
+static void Put16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static uint16_t Get16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+size_t ChunkLink_Frame(uint16_t seq, uint16_t flags, const uint8_t *data, uint16_t len, uint8_t *out) {
+    uint32_t crc;
+    out[0] = (uint8_t)CHUNK_MAGIC; out[1] = (uint8_t)(CHUNK_MAGIC >> 8);
+    out[2] = (uint8_t)(CHUNK_MAGIC >> 16); out[3] = (uint8_t)(CHUNK_MAGIC >> 24);
+    Put16(out + 4, seq);
+    Put16(out + 6, len);
+    Put16(out + 8, flags);
+    Put16(out + 10, ChunkLink_HeaderCheck(seq, len, flags));
+    if (len) memcpy(out + CHUNK_HEADER_SIZE, data, len);
+    crc = ChunkLink_Crc32(0, out + 4, CHUNK_HEADER_SIZE - 4 + len);
+    Put16(out + CHUNK_HEADER_SIZE + len, (uint16_t)crc);
+    Put16(out + CHUNK_HEADER_SIZE + len + 2, (uint16_t)(crc >> 16));
+    return ChunkLink_FrameSize(len);
+}
+
+size_t ChunkLink_ImageSize(size_t len, uint32_t chunk) {
+    size_t count = chunk ? (len + chunk - 1) / chunk : 0;
+    return count ? (count - 1) * ChunkLink_FrameSize(chunk) + ChunkLink_FrameSize(len - (count - 1) * chunk) : 0;
+}
+
+size_t ChunkLink_Image(const uint8_t *data, size_t len, uint32_t chunk, uint8_t *out, size_t cap) {
+    size_t size = ChunkLink_ImageSize(len, chunk), off, at = 0;
+    uint32_t i;
+    if (!size || size > cap || chunk > CHUNK_MAX || (len + chunk - 1) / chunk > 0xFFFFu) return 0;
+    for (i = 0, off = 0; off < len; i++, off += chunk) {
+        uint16_t n = (uint16_t)(len - off < chunk ? len - off : chunk);
+        at += ChunkLink_Frame((uint16_t)i, off + n == len ? CHUNK_LAST : 0, data + off, n, out + at);
+    }
+    return at;
+}
+
+int ChunkLink_ParseHeader(const uint8_t header[CHUNK_HEADER_SIZE], ChunkHeader *h) {
+    if (Get32(header) != CHUNK_MAGIC) return 0;
+    h->seq = Get16(header + 4);
+    h->len = Get16(header + 6);
+    h->flags = Get16(header + 8);
+    return Get16(header + 10) == ChunkLink_HeaderCheck(h->seq, h->len, h->flags) && h->len <= CHUNK_MAX;
+}
+
+int ChunkLink_CheckFrame(const uint8_t *frame, const ChunkHeader *h) {
+    return ChunkLink_Crc32(0, frame + 4, CHUNK_HEADER_SIZE - 4 + h->len) == Get32(frame + CHUNK_HEADER_SIZE + h->len);
+}
+
+// xor of the other nine bytes, so a reply of zeros is not one
+static uint8_t Reply_Check(const uint8_t *p) {
+    uint8_t x = 0x5A;
+    int i;
+    for (i = 0; i < (int)CHUNK_REPLY_SIZE - 1; i++) x ^= p[i];
+    return x;
+}
+
+void ChunkLink_Reply(const ChunkReply *r, uint8_t out[CHUNK_REPLY_SIZE]) {
+    out[0] = r->kind;
+    Put16(out + 1, r->seq);
+    Put16(out + 3, r->next);
+    out[5] = r->room;
+    Put16(out + 6, r->chunk);
+    out[8] = r->status;
+    out[9] = Reply_Check(out);
+}
+
+int ChunkLink_ParseReply(const uint8_t in[CHUNK_REPLY_SIZE], ChunkReply *r) {
+    if ((in[0] != CHUNK_ACK && in[0] != CHUNK_NAK) || in[8] > CHUNK_FAIL || in[9] != Reply_Check(in)) return 0;
+    r->kind = in[0];
+    r->seq = Get16(in + 1);
+    r->next = Get16(in + 3);
+    r->room = in[5];
+    r->chunk = Get16(in + 6);
+    r->status = in[8];
+    return 1;
+}
+
+uint32_t ChunkLink_Window(uint32_t ringBytes, uint32_t chunk) {
+    uint32_t frame = (uint32_t)ChunkLink_FrameSize(chunk), w;
+    w = ringBytes > frame ? (ringBytes - frame) / frame / 2 : 0;
+    if (w < 1) w = 1;
+    return w < CHUNK_SLOTS ? w : CHUNK_SLOTS;
+}
@@ -0,0 +1,73 @@
+/*
+ * Chunked upload link
+ * - Mirror of chunk_link.ads: the bitstream cut into numbered chunks, each
+ *   framed as a 12-byte header (magic "GWCK", sequence, length, flags,
+ *   check), the bytes, then CRC-32 (zlib) of everything after the magic
+ * - The MCU shifts a chunk only once its CRC is good and every chunk
+ *   before it has been shifted; it answers each frame it can read with a
+ *   10-byte reply: ACK (held or shifted, with the next sequence it needs)
+ *   or NAK (bad CRC, or missing before a later chunk)
+ * - A frame with no bytes and PROBE set asks where the MCU is: a host
+ *   that lost the link picks up from the reply's next sequence
+ */
+
+#ifndef CHUNK_LINK_H
+#define CHUNK_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CHUNK_MAGIC       0x4B435747u   // "GWCK" little-endian
+#define CHUNK_HEADER_SIZE 12u
+#define CHUNK_CRC_SIZE    4u
+#define CHUNK_REPLY_SIZE  10u
+#define CHUNK_MAX         1024u         // Bytes per chunk, at most
+#define CHUNK_SLOTS       16u           // Chunks the MCU holds ahead of the next one
+
+#define CHUNK_LAST        0x0001u       // Last chunk: its last byte leaves Shift-DR
+#define CHUNK_PROBE       0x0002u       // No bytes: just reply
+
+#define CHUNK_ACK         0x41u         // 'A'
+#define CHUNK_NAK         0x4Eu         // 'N'
+
+typedef enum { CHUNK_RUNNING, CHUNK_DONE, CHUNK_FAIL } ChunkStatus;
+
+typedef struct {
+    uint16_t seq, len, flags;
+} ChunkHeader;
+
+typedef struct {
+    uint8_t  kind;       // CHUNK_ACK / CHUNK_NAK
+    uint16_t seq;        // The frame it answers
+    uint16_t next;       // Every chunk before this one is in the FPGA
+    uint8_t  room;       // DMA_Buffer size in 64-byte units
+    uint16_t chunk;      // Chunk length the session runs at (0 until known)
+    uint8_t  status;     // ChunkStatus
+} ChunkReply;
+
+static inline size_t ChunkLink_FrameSize(size_t len) { return CHUNK_HEADER_SIZE + len + CHUNK_CRC_SIZE; }
+
+// CRC-32 (zlib) carried on from `crc` (0 to start)
+uint32_t ChunkLink_Crc32(uint32_t crc, const uint8_t *data, size_t len);
+uint16_t ChunkLink_HeaderCheck(uint16_t seq, uint16_t len, uint16_t flags);
+
+// One frame into `out` (ChunkLink_FrameSize(len) bytes); returns its size
+size_t   ChunkLink_Frame(uint16_t seq, uint16_t flags, const uint8_t *data, uint16_t len, uint8_t *out);
+// Every data frame of a bitstream back to back, as they go out: frame i
+// at i * ChunkLink_FrameSize(chunk), the last one shorter. The size for
+// these inputs; the image, or 0 if it does not fit `cap`
+size_t   ChunkLink_ImageSize(size_t len, uint32_t chunk);
+size_t   ChunkLink_Image(const uint8_t *data, size_t len, uint32_t chunk, uint8_t *out, size_t cap);
+// 1 for a header with the magic, a good check and len <= CHUNK_MAX
+int      ChunkLink_ParseHeader(const uint8_t header[CHUNK_HEADER_SIZE], ChunkHeader *h);
+// 1 if the frame's CRC matches (ChunkLink_FrameSize(h->len) bytes at frame)
+int      ChunkLink_CheckFrame(const uint8_t *frame, const ChunkHeader *h);
+
+void     ChunkLink_Reply(const ChunkReply *r, uint8_t out[CHUNK_REPLY_SIZE]);
+int      ChunkLink_ParseReply(const uint8_t in[CHUNK_REPLY_SIZE], ChunkReply *r);
+
+// Chunks the host keeps in flight: half the ring, so a few resends of the
+// oldest fit behind the held ones before the MCU has to drop any
+uint32_t ChunkLink_Window(uint32_t ringBytes, uint32_t chunk);
+
+#endif
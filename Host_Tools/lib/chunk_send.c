@@ -0,0 +1,189 @@
+/*
+ * Chunked upload, host side
+ */
+
+#include "chunk_send.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define RTO_MS        200.0
+#define MAX_TIMEOUTS  25
+
+int ChunkSender_Init(ChunkSender *s, const uint8_t *data, size_t len, uint32_t chunk) {
+    memset(s, 0, sizeof(*s));
+    if (!len || chunk == 0 || chunk > CHUNK_MAX) return -1;
+    s->count = (uint32_t)((len + chunk - 1) / chunk);
+    if (s->count > 0xFFFFu) return -1;   // Sequence numbers wrap past one session
+    s->data = data;
+    s->len = len;
+    s->chunk = chunk;
+    s->rtoMs = RTO_MS;
+    s->maxTimeouts = MAX_TIMEOUTS;
+    s->state = SEND_PROBING;
+    s->acked = calloc(s->count, 1);
+    s->nak = calloc(s->count, 1);
+    s->sentAt = calloc(s->count, sizeof(*s->sentAt));
+    return s->acked && s->nak && s->sentAt ? 0 : -1;
+}
+
+void ChunkSender_Free(ChunkSender *s) {
+    free(s->acked); free(s->nak); free(s->sentAt);
+    s->acked = s->nak = NULL;
+    s->sentAt = NULL;
+}
+
+const char *ChunkSender_StateName(ChunkSendState st) {
+    static const char *Names[] = { "PROBING", "RUNNING", "DONE", "FAIL", "NO_REPLY", "MISMATCH" };
+    return (unsigned)st < sizeof(Names) / sizeof(Names[0]) ? Names[st] : "?";
+}
+
+int ChunkSender_Finished(const ChunkSender *s) {
+    return s->state != SEND_PROBING && s->state != SEND_RUNNING;
+}
+
+// The probe answers with the next sequence and the status; its own
+// sequence is one behind the base, so its ACK marks nothing
+static size_t Probe(ChunkSender *s, double now, uint8_t *out) {
+    s->lastProbe = now;
+    s->probes++;
+    s->bytes += ChunkLink_FrameSize(0);
+    return ChunkLink_Frame((uint16_t)(s->base - 1), CHUNK_PROBE, NULL, 0, out);
+}
+
+static size_t Data(ChunkSender *s, uint32_t i, double now, uint8_t *out) {
+    size_t off = (size_t)i * s->chunk;
+    uint16_t n = (uint16_t)(s->len - off < s->chunk ? s->len - off : s->chunk);
+    s->sentAt[i] = now;
+    s->nak[i] = 0;
+    s->frames++;
+    s->bytes += ChunkLink_FrameSize(n);
+    if (s->framed) {
+        memcpy(out, s->framed + (size_t)i * ChunkLink_FrameSize(s->chunk), ChunkLink_FrameSize(n));
+        return ChunkLink_FrameSize(n);
+    }
+    return ChunkLink_Frame((uint16_t)i, i == s->count - 1 ? CHUNK_LAST : 0, s->data + off, n, out);
+}
+
+size_t ChunkSender_Next(ChunkSender *s, double now, uint8_t *out) {
+    uint32_t i, w = s->window ? s->window : 1, end;
+    if (ChunkSender_Finished(s)) return 0;
+    if (s->state == SEND_PROBING || s->base == s->count) {
+        if (s->lastProbe && now - s->lastProbe < s->rtoMs) return 0;
+        if (s->lastProbe && ++s->timeouts > s->maxTimeouts) { s->state = SEND_NO_REPLY; return 0; }
+        return Probe(s, now, out);
+    }
+    // Resends first, oldest first: the MCU can shift nothing past a hole
+    end = s->fresh;
+    for (i = s->base; i < end; i++) {
+        // An ACK past the base only says the chunk was held: the MCU may
+        // have evicted it since, and that NAK may be the reply that was lost
+        if (s->acked[i] && i != s->base) continue;
+        if (s->nak[i]) { s->resent++; return Data(s, i, now, out); }
+        if (now - s->sentAt[i] >= s->rtoMs) {
+            if (++s->timeouts > s->maxTimeouts) { s->state = SEND_NO_REPLY; return 0; }
+            s->rtos++;
+            s->resent++;
+            return Data(s, i, now, out);
+        }
+    }
+    if (s->fresh < s->count && s->fresh < s->base + w) return Data(s, s->fresh++, now, out);
+    return 0;
+}
+
+// Sequence numbers are 16 bits: relative to the base, in this session
+static uint32_t Unwrap(const ChunkSender *s, uint16_t seq) {
+    return s->base + (uint16_t)(seq - (uint16_t)s->base);
+}
+
+static void Handle(ChunkSender *s, const ChunkReply *r, double now) {
+    uint32_t next, i;
+    s->replies++;
+    s->timeouts = 0;
+    s->lastReply = now;
+    if (!s->window && r->room) s->window = ChunkLink_Window((uint32_t)r->room * 64u, s->chunk);
+    if (s->state == SEND_PROBING) {
+        if (r->next > s->count || (r->next && r->chunk && r->chunk != s->chunk)) { s->state = SEND_MISMATCH; return; }
+        s->base = s->fresh = s->resumedAt = r->next;
+        for (i = 0; i < s->base; i++) s->acked[i] = 1;
+        s->state = SEND_RUNNING;
+    }
+    next = Unwrap(s, r->next);
+    if (next > s->base && next <= s->count) {
+        for (i = s->base; i < next; i++) s->acked[i] = 1;
+        s->base = next;
+        if (s->fresh < next) s->fresh = next;
+    }
+    i = Unwrap(s, r->seq);
+    // A NAK after an ACK is an eviction: the chunk is wanted again
+    if (i >= s->base && i < s->fresh) {
+        if (r->kind == CHUNK_ACK) s->acked[i] = 1;
+        else if (!s->nak[i]) { s->acked[i] = 0; s->nak[i] = 1; s->naks++; }
+    }
+    if (r->status == CHUNK_FAIL) s->state = SEND_FAIL;
+    else if (r->status == CHUNK_DONE && s->base == s->count) s->state = SEND_DONE;
+}
+
+void ChunkSender_Rx(ChunkSender *s, const uint8_t *buf, size_t n, double now) {
+    while (n) {
+        size_t k = sizeof(s->rx) - s->rxLen < n ? sizeof(s->rx) - s->rxLen : n;
+        memcpy(s->rx + s->rxLen, buf, k);
+        s->rxLen += k; buf += k; n -= k;
+        // A reply wherever one checks out; anything else is skipped a byte at a time
+        while (s->rxLen >= CHUNK_REPLY_SIZE) {
+            ChunkReply r;
+            if (ChunkLink_ParseReply(s->rx, &r)) {
+                Handle(s, &r, now);
+                s->rxLen -= CHUNK_REPLY_SIZE;
+                memmove(s->rx, s->rx + CHUNK_REPLY_SIZE, s->rxLen);
+            } else {
+                s->badReplies++;
+                memmove(s->rx, s->rx + 1, --s->rxLen);
+            }
+        }
+    }
+}
+
+// --- PORT ---
+static double Now_Ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static int Write_All(int fd, const uint8_t *buf, size_t len) {
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n; len -= (size_t)n;
+    }
+    return 0;
+}
+
+ChunkSendState ChunkSend_Port(ChunkSender *s, int fd, uint32_t stopAfter) {
+    uint8_t *frame = malloc(ChunkLink_FrameSize(s->chunk)), buf[256];
+    if (!frame) return s->state;
+    while (!ChunkSender_Finished(s)) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        size_t n = ChunkSender_Next(s, Now_Ms(), frame);
+        if (n) {
+            if (stopAfter && s->frames > stopAfter) { s->frames--; break; }   // Dies before it goes out
+            if (Write_All(fd, frame, n) < 0) break;
+        }
+        // Replies as they come; a short wait when there is nothing to send
+        if (poll(&p, 1, n ? 0 : 5) > 0) {
+            ssize_t got = read(fd, buf, sizeof(buf));
+            if (got <= 0) break;
+            ChunkSender_Rx(s, buf, (size_t)got, Now_Ms());
+        }
+    }
+    free(frame);
+    return s->state;
+}
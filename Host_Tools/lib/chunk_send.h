@@ -0,0 +1,77 @@
+/*
+ * Chunked upload, host side
+ * - ChunkSender: which frame to send next, from the replies so far and the
+ *   clock; no I/O, so the tests drive it byte for byte
+ * - Probes until the MCU answers, then starts at the reply's next
+ *   sequence: a fresh session from 0, one the host lost mid-way from where
+ *   the MCU got to
+ * - Keeps up to ChunkLink_Window chunks past the next one in flight;
+ *   resends a chunk on its NAK, or once rtoMs pass with no reply to it
+ * - ChunkSend_Port: the same over a port fd (tools/chunk_send, the pty
+ *   harness)
+ */
+
+#ifndef CHUNK_SEND_H
+#define CHUNK_SEND_H
+
+#include "chunk_link.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    SEND_PROBING,         // No reply yet
+    SEND_RUNNING,
+    SEND_DONE,            // MCU reported DONE after the last chunk
+    SEND_FAIL,            // MCU reported FAIL
+    SEND_NO_REPLY,        // maxTimeouts in a row without progress
+    SEND_MISMATCH         // Resumed session runs at another chunk length
+} ChunkSendState;
+
+typedef struct {
+    const uint8_t *data;
+    size_t         len;
+    uint32_t       chunk;
+    const uint8_t *framed;       // ChunkLink_Image of data, or NULL to frame as it goes
+    uint32_t       count;        // Chunks
+    uint32_t       window;       // 0: from the MCU's ring size
+    double         rtoMs;
+    uint32_t       maxTimeouts;
+    ChunkSendState state;
+    uint32_t       base;         // Every chunk before it is in the FPGA
+    uint32_t       fresh;        // First chunk never sent
+    uint8_t       *acked;        // Per chunk: held or shifted
+    uint8_t       *nak;          // Per chunk: resend asked for
+    double        *sentAt;       // Per chunk: last send, 0 = never
+    double         lastReply;
+    double         lastProbe;
+    uint32_t       timeouts;     // In a row
+    uint8_t        rx[2 * CHUNK_REPLY_SIZE];
+    size_t         rxLen;
+    // Statistics
+    uint32_t       resumedAt;    // Chunk the session started from
+    uint32_t       frames;       // Data frames sent
+    uint32_t       resent;       // Of which resends
+    uint32_t       probes;
+    uint32_t       naks;
+    uint32_t       rtos;
+    uint32_t       replies;
+    uint32_t       badReplies;   // Bytes skipped finding replies
+    uint64_t       bytes;        // On the wire, frames and probes
+} ChunkSender;
+
+int    ChunkSender_Init(ChunkSender *s, const uint8_t *data, size_t len, uint32_t chunk);
+void   ChunkSender_Free(ChunkSender *s);
+// The frame to send at nowMs into out (ChunkLink_FrameSize(chunk) bytes),
+// or 0 when there is nothing to send until a reply or a timeout
+size_t ChunkSender_Next(ChunkSender *s, double nowMs, uint8_t *out);
+// Reply bytes as they come off the port, in any pieces
+void   ChunkSender_Rx(ChunkSender *s, const uint8_t *buf, size_t n, double nowMs);
+int    ChunkSender_Finished(const ChunkSender *s);
+const char *ChunkSender_StateName(ChunkSendState st);
+
+// The whole upload over fd. stopAfter > 0 gives up after that many data
+// frames, as a host that dies mid-way. Returns the final state
+ChunkSendState ChunkSend_Port(ChunkSender *s, int fd, uint32_t stopAfter);
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Binary commands on the host link
+ */
+
+#include "cmd_link.h"
+#include "chunk_link.h"
+
+#include <string.h>
+
+static const char *OpNames[CMD_OPS] = {
+    "ping", "config", "upload", "dmload", "chain", "select", "fanout", "status",
+    "sspi", "prof", "rings", "boot", "baud", "auto", "exit", "text"
+};
+
+const char *CmdLink_OpName(uint8_t op) { return op < CMD_OPS ? OpNames[op] : "?"; }
+
+const char *CmdLink_StatusName(uint8_t status) {
+    static const char *Names[] = { "OK", "FAIL", "READY", "BAD_CRC", "TOO_LONG", "UNKNOWN", "BAD_ARG" };
+    return status < sizeof(Names) / sizeof(Names[0]) ? Names[status] : "?";
+}
+
+int CmdLink_OpByName(const char *name) {
+    unsigned i;
+    for (i = 0; i < CMD_OPS; i++)
+        if (strcmp(OpNames[i], name) == 0) return (int)i;
+    return -1;
+}
+
+// The command line's words, as cmd_link.Commands
+static const struct { const char *name; uint8_t op; } TextCommands[] = {
+    { "help", CMD_LINE_HELP }, { "exit", CMD_EXIT },     { "config", CMD_CONFIG }, { "upload", CMD_UPLOAD },
+    { "dmload", CMD_DMLOAD },  { "chain", CMD_CHAIN },   { "select", CMD_SELECT }, { "fanout", CMD_FANOUT },
+    { "status", CMD_STATUS },  { "sspi", CMD_SSPI },     { "prof", CMD_PROF },     { "rings", CMD_RINGS },
+    { "boot", CMD_BOOT },      { "baud", CMD_BAUD },     { "auto", CMD_AUTO },     { "bin", CMD_LINE_BIN },
+};
+
+uint8_t CmdLink_ParseLine(const char *line, size_t len, unsigned *arg) {
+    const char *space = memchr(line, ' ', len);
+    size_t word = space ? (size_t)(space - line) : len, i;
+    uint8_t op = CMD_LINE_NONE;
+    *arg = 0;
+    for (i = 0; i < sizeof(TextCommands) / sizeof(TextCommands[0]); i++) {
+        if (word && strlen(TextCommands[i].name) == word && memcmp(TextCommands[i].name, line, word) == 0) {
+            op = TextCommands[i].op;
+            break;
+        }
+    }
+    if (len > word + 1) {
+        if (len == word + 2 && line[len - 1] >= '0' && line[len - 1] <= '9' && (op == CMD_SELECT || op == CMD_FANOUT))
+            *arg = (unsigned)(line[len - 1] - '0');
+        else
+            op = CMD_LINE_NONE;
+    }
+    return op;
+}
+
+void CmdParser_Init(CmdParser *p, int reply) {
+    memset(p, 0, sizeof(*p));
+    p->reply = reply;
+}
+
+CmdVerdict CmdParser_Feed(CmdParser *p, uint8_t b) {
+    uint32_t hdr = p->reply ? CMD_REPLY_HEADER_SIZE : CMD_HEADER_SIZE;
+    uint32_t bodyEnd;
+    if (p->got == 0) {
+        if (b == (p->reply ? CMD_REPLY_SYNC : CMD_SYNC)) {
+            p->got = 1;
+            p->len = 0;
+            p->crc = 0;
+            p->sentCrc = 0;
+        } else {
+            p->skipped++;
+        }
+        return CMDV_NONE;
+    }
+    // len is 0 until both its bytes are in: the header always goes into the CRC
+    bodyEnd = hdr + p->len;
+    if (p->got < bodyEnd) p->crc = ChunkLink_Crc32(p->crc, &b, 1);
+    if (p->got == 1) p->op = b;
+    else if (p->got == 2) p->tag = b;
+    else if (p->got == hdr - 3) p->status = b;            // Responses only
+    else if (p->got == hdr - 2) p->len = b;
+    else if (p->got == hdr - 1) {
+        p->len = (uint16_t)(p->len | b << 8);
+        if (p->len > CMD_MAX_PAYLOAD) {
+            p->tooLong++;
+            p->got = 0;
+            p->len = 0;
+            return CMDV_TOO_LONG;
+        }
+    } else if (p->got < bodyEnd) {
+        p->payload[p->got - hdr] = b;
+    } else {
+        p->sentCrc |= (uint32_t)b << (8 * (p->got - bodyEnd));
+    }
+    p->got++;
+    if (p->got == hdr + p->len + CMD_CRC_SIZE) {
+        p->got = 0;
+        if (p->sentCrc == p->crc) { p->frames++; return CMDV_GOOD; }
+        p->badCrc++;
+        return CMDV_BAD_CRC;
+    }
+    return CMDV_NONE;
+}
+
+static size_t Frame(uint8_t sync, const uint8_t *head, size_t headLen, const uint8_t *payload, uint16_t len,
+                    uint8_t *out) {
+    uint32_t crc;
+    size_t n = 0;
+    if (len > CMD_MAX_PAYLOAD) return 0;
+    out[n++] = sync;
+    memcpy(out + n, head, headLen);
+    n += headLen;
+    out[n++] = (uint8_t)len;
+    out[n++] = (uint8_t)(len >> 8);
+    if (len) memcpy(out + n, payload, len);
+    n += len;
+    crc = ChunkLink_Crc32(0, out + 1, n - 1);
+    out[n++] = (uint8_t)crc;
+    out[n++] = (uint8_t)(crc >> 8);
+    out[n++] = (uint8_t)(crc >> 16);
+    out[n++] = (uint8_t)(crc >> 24);
+    return n;
+}
+
+size_t CmdLink_Request(uint8_t op, uint8_t tag, const uint8_t *payload, uint16_t len, uint8_t *out) {
+    const uint8_t head[2] = { op, tag };
+    return Frame(CMD_SYNC, head, 2, payload, len, out);
+}
+
+size_t CmdLink_Reply(uint8_t op, uint8_t tag, uint8_t status, const uint8_t *payload, uint16_t len, uint8_t *out) {
+    const uint8_t head[3] = { op, tag, status };
+    return Frame(CMD_REPLY_SYNC, head, 3, payload, len, out);
+}
+
+uint32_t CmdLink_Word(const uint8_t *payload, unsigned i) {
+    const uint8_t *p = payload + 4 * i;
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
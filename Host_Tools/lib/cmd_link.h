@@ -0,0 +1,91 @@
+/*
+ * Binary commands on the host link
+ * - Mirror of cmd_link.ads: after `bin` on the command line a request is
+ *   sync 0xA5, opcode, tag, payload length (16-bit), the payload and a
+ *   CRC-32 (zlib) of everything between the sync and the CRC; a response
+ *   is sync 0x5A, opcode, tag, status, length, payload and CRC the same way
+ * - The tag comes back as sent and the responses come in order, so a host
+ *   can send a run of requests without waiting for each. Config, upload,
+ *   dmload, sspi and baud take the line for data and end a run
+ * - CmdParser is the byte-at-a-time parser of either direction; it hunts
+ *   for the sync again after every frame, good or not
+ */
+
+#ifndef CMD_LINK_H
+#define CMD_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CMD_SYNC              0xA5u
+#define CMD_REPLY_SYNC        0x5Au
+#define CMD_VERSION           1u
+#define CMD_HEADER_SIZE       5u
+#define CMD_REPLY_HEADER_SIZE 6u
+#define CMD_CRC_SIZE          4u
+#define CMD_MAX_PAYLOAD       128u
+#define CMD_MAX_FRAME         (CMD_REPLY_HEADER_SIZE + CMD_MAX_PAYLOAD + CMD_CRC_SIZE)
+
+// Opcodes, with the response payload in words
+#define CMD_PING    0x00u   // Version, ring size, max payload
+#define CMD_CONFIG  0x01u   // READY, then done mask, session (7), chunks (10), manifest (9)
+#define CMD_UPLOAD  0x02u   // READY; the console's after it
+#define CMD_DMLOAD  0x03u   // READY, then result, bytes, load_us, retries, idle
+#define CMD_CHAIN   0x04u   // Valid, active, count, IDCODE and IR length per device
+#define CMD_SELECT  0x05u   // Payload N; active device
+#define CMD_FANOUT  0x06u   // Payload N; target count
+#define CMD_STATUS  0x07u   // Count, status and done per target
+#define CMD_SSPI    0x08u   // READY, then IDCODE, status, bytes, configured
+#define CMD_PROF    0x09u   // Tick Hz, 5 per phase, bytes, rate, spins, high water, ring
+#define CMD_RINGS   0x0Au   // Size, bytes, high water, overruns, lost; usart2 then usart1
+#define CMD_BOOT    0x0Bu   // Result, bytes, crc_us, load_us, user_us, status, done
+#define CMD_BAUD    0x0Cu   // The rate agreed
+#define CMD_AUTO    0x0Du   // READY; no more commands
+#define CMD_EXIT    0x0Eu
+#define CMD_TEXT    0x0Fu   // Back to the command line
+#define CMD_OPS     16u
+
+// Statuses
+#define CMD_OK       0u
+#define CMD_FAIL     1u
+#define CMD_READY    2u     // Send the data; another response follows
+#define CMD_BAD_CRC  3u
+#define CMD_TOO_LONG 4u
+#define CMD_UNKNOWN  5u
+#define CMD_BAD_ARG  6u
+
+typedef enum { CMDV_NONE, CMDV_GOOD, CMDV_BAD_CRC, CMDV_TOO_LONG } CmdVerdict;
+
+typedef struct {
+    int      reply;               // Parses responses (the host's side)
+    uint32_t got;                 // Bytes of the frame so far; 0: hunting
+    uint8_t  op, tag, status;
+    uint16_t len;
+    uint8_t  payload[CMD_MAX_PAYLOAD];
+    uint32_t crc, sentCrc;
+    uint32_t frames, badCrc, tooLong, skipped;
+} CmdParser;
+
+void       CmdParser_Init(CmdParser *p, int reply);
+// CMDV_NONE until a frame ends; then op, tag, (status,) len and payload
+// are the frame's until the next byte
+CmdVerdict CmdParser_Feed(CmdParser *p, uint8_t b);
+
+// Frame into out (CMD_MAX_FRAME bytes); 0 if len is over CMD_MAX_PAYLOAD
+size_t   CmdLink_Request(uint8_t op, uint8_t tag, const uint8_t *payload, uint16_t len, uint8_t *out);
+size_t   CmdLink_Reply(uint8_t op, uint8_t tag, uint8_t status, const uint8_t *payload, uint16_t len, uint8_t *out);
+uint32_t CmdLink_Word(const uint8_t *payload, unsigned i);
+
+// The command line before `bin` (cmd_link.Parse_Line): one word, and for
+// select and fanout a one-digit N after a single space. Help and bin are
+// the command line's own; NONE is anything else, an empty line included
+#define CMD_LINE_HELP 0xF0u
+#define CMD_LINE_BIN  0xF1u
+#define CMD_LINE_NONE 0xFFu
+uint8_t CmdLink_ParseLine(const char *line, size_t len, unsigned *arg);
+
+const char *CmdLink_OpName(uint8_t op);
+const char *CmdLink_StatusName(uint8_t status);
+int         CmdLink_OpByName(const char *name);   // -1 if none
+
+#endif
@@ -0,0 +1,393 @@
+/*
+ * Content-addressed design cache
+ */
+
+#include "design_cache.h"
+#include "chunk_link.h"
+#include "neorv32_boot.h"
+#include "session_image.h"
+#include "wire_image.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SESSION_SLICE 256u   // As wire_image -f
+
+// --- FILES ---
+static void Object_Path(const DesignCache *c, const char *name, const char *ext, char *path, size_t cap) {
+    snprintf(path, cap, "%s/objects/%s.%s", c->dir, name, ext);
+}
+
+static int Exists(const char *path) {
+    struct stat sb;
+    return stat(path, &sb) == 0;
+}
+
+static uint8_t *Read_File(const char *path, size_t *len) {
+    struct stat sb;
+    uint8_t *buf;
+    size_t got = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &sb) < 0 || !(buf = malloc(sb.st_size ? (size_t)sb.st_size : 1))) { close(fd); return NULL; }
+    while (got < (size_t)sb.st_size) {
+        ssize_t n = read(fd, buf + got, (size_t)sb.st_size - got);
+        if (n <= 0) { free(buf); close(fd); return NULL; }
+        got += (size_t)n;
+    }
+    close(fd);
+    *len = got;
+    return buf;
+}
+
+static int Map(const char *path, const uint8_t **data, size_t *len) {
+    struct stat sb;
+    void *m;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    if (fstat(fd, &sb) < 0 || sb.st_size == 0) { close(fd); return -1; }
+    m = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return -1;
+    *data = m;
+    *len = (size_t)sb.st_size;
+    return 0;
+}
+
+// Written whole or not at all: a crash leaves a .tmp, never half an object
+static int Write_Object(DesignCache *c, const char *name, const char *ext, const uint8_t *data, size_t len) {
+    char path[320], tmp[340];
+    FILE *f;
+    Object_Path(c, name, ext, path, sizeof(path));
+    if (Exists(path)) return 0;
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+    if (!(f = fopen(tmp, "wb"))) return -1;
+    if (fwrite(data, 1, len, f) != len) { fclose(f); unlink(tmp); return -1; }
+    if (fclose(f) != 0 || rename(tmp, path) < 0) { unlink(tmp); return -1; }
+    c->builds++;
+    return 0;
+}
+
+// --- INDEX ---
+static int64_t Mtime_Ns(const struct stat *sb) { return (int64_t)sb->st_mtim.tv_sec * 1000000000 + sb->st_mtim.tv_nsec; }
+
+static void Remember(DesignCache *c, const struct stat *sb, const char *hex, int save) {
+    DesignIndexEntry *e;
+    if (c->indexCount == c->indexCap) {
+        size_t cap = c->indexCap ? c->indexCap * 2 : 64;
+        DesignIndexEntry *n = realloc(c->index, cap * sizeof(*n));
+        if (!n) return;
+        c->index = n;
+        c->indexCap = cap;
+    }
+    e = &c->index[c->indexCount++];
+    e->dev = sb->st_dev;
+    e->ino = sb->st_ino;
+    e->size = sb->st_size;
+    e->mtimeNs = Mtime_Ns(sb);
+    strcpy(e->hex, hex);
+    if (save) {
+        char path[220];
+        FILE *f;
+        snprintf(path, sizeof(path), "%s/index", c->dir);
+        if ((f = fopen(path, "a"))) {
+            fprintf(f, "%llu %llu %lld %lld %s\n", (unsigned long long)e->dev, (unsigned long long)e->ino,
+                    (long long)e->size, (long long)e->mtimeNs, e->hex);
+            fclose(f);
+        }
+    }
+}
+
+// The digest of the file at path: from the index if the file is the one
+// hashed before, otherwise read (left in *buf for the caller) and hashed
+static int Digest_Of(DesignCache *c, const char *path, char hex[SHA256_HEX], uint8_t **buf, size_t *len) {
+    struct stat sb;
+    uint8_t digest[SHA256_SIZE];
+    size_t i;
+    *buf = NULL;
+    if (stat(path, &sb) < 0) { c->error = "cannot read"; return -1; }
+    for (i = c->indexCount; i-- > 0;) {
+        const DesignIndexEntry *e = &c->index[i];
+        if (e->dev == sb.st_dev && e->ino == sb.st_ino && e->size == sb.st_size && e->mtimeNs == Mtime_Ns(&sb)) {
+            strcpy(hex, e->hex);
+            return 0;
+        }
+    }
+    if (!(*buf = Read_File(path, len))) { c->error = "cannot read"; return -1; }
+    Sha256_Digest(*buf, *len, digest);
+    Sha256_Hex(digest, hex);
+    c->hashed++;
+    Remember(c, &sb, hex, 1);
+    return 0;
+}
+
+// --- CHECKS ---
+static int Check_Firmware(DesignCache *c, const uint8_t *fw, size_t len) {
+    Neorv32Header h;
+    Neorv32Sum sum = { 0, 0, 0 };
+    size_t i;
+    if (len < NEORV32_HEADER_SIZE) { c->error = "executable too short"; return -1; }
+    Neorv32_ParseHeader(fw, &h);
+    if (Neorv32_Check(&h) != NEORV32_BOOTED || h.size != len - NEORV32_HEADER_SIZE) {
+        c->error = "not a NEORV32 executable";
+        return -1;
+    }
+    for (i = NEORV32_HEADER_SIZE; i < len; i++) Neorv32Sum_Add(&sum, fw[i]);
+    if (!Neorv32Sum_Ok(&sum, &h)) { c->error = "executable checksum"; return -1; }
+    if (len > SESSION_STAGE_SIZE) { c->error = "executable larger than the stage"; return -1; }
+    return 0;
+}
+
+// The object for a file, written from its bytes if it is not there yet
+static int Store(DesignCache *c, const char *path, const char *ext, char hex[SHA256_HEX]) {
+    char obj[320];
+    uint8_t *buf;
+    size_t len = 0;
+    int ok = 0;
+    if (Digest_Of(c, path, hex, &buf, &len) < 0) return -1;
+    Object_Path(c, hex, ext, obj, sizeof(obj));
+    if (!Exists(obj)) {
+        // Known to the index but the object has gone: read it after all
+        if (!buf) {
+            uint8_t digest[SHA256_SIZE];
+            if (!(buf = Read_File(path, &len))) { c->error = "cannot read"; return -1; }
+            Sha256_Digest(buf, len, digest);
+            Sha256_Hex(digest, hex);
+            c->hashed++;
+        }
+        if (len == 0) { c->error = "empty file"; ok = -1; }
+        else if (strcmp(ext, "fw") == 0 && Check_Firmware(c, buf, len) < 0) ok = -1;
+        else if (Write_Object(c, hex, ext, buf, len) < 0) { c->error = "cannot write the cache"; ok = -1; }
+    }
+    free(buf);
+    return ok;
+}
+
+// --- DESIGNS ---
+static void Unmap(Design *d) {
+    if (d->data) munmap((void *)d->data, d->len);
+    if (d->frames) munmap((void *)d->frames, d->framesLen);
+    if (d->wire) munmap((void *)d->wire, d->wireLen);
+    if (d->session) munmap((void *)d->session, d->sessionLen);
+    free(d);
+}
+
+// Objects named prefix...ext: how many there are, the first one's name
+// (without the extension) in name
+static int Find_Object(DesignCache *c, const char *prefix, const char *ext, char *name, size_t cap) {
+    char dirPath[220];
+    DIR *dir;
+    struct dirent *e;
+    size_t p = strlen(prefix), x = strlen(ext);
+    int found = 0;
+    snprintf(dirPath, sizeof(dirPath), "%s/objects", c->dir);
+    if (!(dir = opendir(dirPath))) return 0;
+    while ((e = readdir(dir))) {
+        size_t n = strlen(e->d_name);
+        if (n >= p + x + 1 && strncmp(e->d_name, prefix, p) == 0 && e->d_name[n - x - 1] == '.' &&
+            strcmp(e->d_name + n - x, ext) == 0 && n - x - 1 < cap) {
+            if (found++ == 0) { memcpy(name, e->d_name, n - x - 1); name[n - x - 1] = 0; }
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+// Every derived object there or built from the .bit / .fw objects, then
+// all of them mapped
+static Design *Load(DesignCache *c, const char *bits, const char *fw) {
+    char path[320], ext[16], name[DESIGN_ID_SIZE];
+    Design *d = calloc(1, sizeof(*d));
+    uint8_t *img = NULL;
+    size_t cap, n;
+    if (!d) { c->error = "out of memory"; return NULL; }
+    strcpy(d->bits, bits);
+    strcpy(d->id, bits);
+    Object_Path(c, bits, "bit", path, sizeof(path));
+    if (Map(path, &d->data, &d->len) < 0) { c->error = "no such design"; free(d); return NULL; }
+
+    snprintf(ext, sizeof(ext), "c%u", c->chunk);
+    Object_Path(c, bits, ext, path, sizeof(path));
+    if (!Exists(path)) {
+        cap = ChunkLink_ImageSize(d->len, c->chunk);
+        if (!(img = malloc(cap)) || !(n = ChunkLink_Image(d->data, d->len, c->chunk, img, cap)) ||
+            Write_Object(c, bits, ext, img, n) < 0) {
+            c->error = img ? "bitstream too long for the chunk length" : "out of memory";
+            goto fail;
+        }
+        free(img);
+        img = NULL;
+    }
+    if (Map(path, &d->frames, &d->framesLen) < 0) { c->error = "cannot map"; goto fail; }
+
+    Object_Path(c, bits, "wire", path, sizeof(path));
+    if (!Exists(path)) {
+        cap = WIRE_HEADER_SIZE + d->len;
+        if (!(img = malloc(cap)) || !(n = WireImage_Build(d->data, d->len, img, cap)) ||
+            Write_Object(c, bits, "wire", img, n) < 0) {
+            c->error = "cannot build the wire image";
+            goto fail;
+        }
+        free(img);
+        img = NULL;
+    }
+    if (Map(path, &d->wire, &d->wireLen) < 0) { c->error = "cannot map"; goto fail; }
+
+    if (fw && *fw) {
+        const uint8_t *exe;
+        size_t exeLen;
+        if (Find_Object(c, fw, "fw", name, sizeof(name)) != 1) { c->error = "no such executable"; goto fail; }
+        strcpy(d->fw, name);
+        snprintf(d->id, sizeof(d->id), "%s+%.*s", bits, DESIGN_FW_DIGITS, name);
+        Object_Path(c, d->id, "session", path, sizeof(path));
+        if (!Exists(path)) {
+            char fwPath[320];
+            Object_Path(c, name, "fw", fwPath, sizeof(fwPath));
+            if (Map(fwPath, &exe, &exeLen) < 0) { c->error = "cannot map"; goto fail; }
+            cap = SessionImage_Size(d->len, exeLen, SESSION_SLICE);
+            n = (img = malloc(cap)) ? SessionImage_Build(d->data, d->len, exe, exeLen, SESSION_SLICE, img, cap) : 0;
+            munmap((void *)exe, exeLen);
+            if (!n || Write_Object(c, d->id, "session", img, n) < 0) { c->error = "cannot build the session image"; goto fail; }
+            free(img);
+            img = NULL;
+        }
+        if (Map(path, &d->session, &d->sessionLen) < 0) { c->error = "cannot map"; goto fail; }
+    }
+    c->loads++;
+    return d;
+fail:
+    free(img);
+    Unmap(d);
+    return NULL;
+}
+
+static const Design *Keep(DesignCache *c, Design *d) {
+    if (c->count == DESIGN_CACHE_MAX) {
+        // The least used goes; it is still on disk
+        int i, least = 0;
+        for (i = 1; i < c->count; i++)
+            if (c->design[i]->uses < c->design[least]->uses) least = i;
+        Unmap(c->design[least]);
+        c->design[least] = c->design[--c->count];
+    }
+    c->design[c->count++] = d;
+    d->uses++;
+    return d;
+}
+
+static Design *Mapped(DesignCache *c, const char *id) {
+    int i;
+    for (i = 0; i < c->count; i++)
+        if (strcmp(c->design[i]->id, id) == 0) return c->design[i];
+    return NULL;
+}
+
+int DesignCache_Open(DesignCache *c, const char *dir, uint32_t chunk) {
+    char path[220];
+    FILE *f;
+    memset(c, 0, sizeof(*c));
+    if (strlen(dir) >= sizeof(c->dir) || chunk == 0 || chunk > CHUNK_MAX) { errno = EINVAL; return -1; }
+    strcpy(c->dir, dir);
+    c->chunk = chunk;
+    if (mkdir(dir, 0755) < 0 && errno != EEXIST) return -1;
+    snprintf(path, sizeof(path), "%s/objects", dir);
+    if (mkdir(path, 0755) < 0 && errno != EEXIST) return -1;
+    snprintf(path, sizeof(path), "%s/index", dir);
+    if ((f = fopen(path, "r"))) {
+        unsigned long long dev, ino;
+        long long size, mtime;
+        char hex[SHA256_HEX];
+        while (fscanf(f, "%llu %llu %lld %lld %64s", &dev, &ino, &size, &mtime, hex) == 5) {
+            struct stat sb;
+            memset(&sb, 0, sizeof(sb));
+            sb.st_dev = (dev_t)dev;
+            sb.st_ino = (ino_t)ino;
+            sb.st_size = (off_t)size;
+            sb.st_mtim.tv_sec = (time_t)(mtime / 1000000000);
+            sb.st_mtim.tv_nsec = (long)(mtime % 1000000000);
+            Remember(c, &sb, hex, 0);
+        }
+        fclose(f);
+    }
+    return 0;
+}
+
+void DesignCache_Close(DesignCache *c) {
+    int i;
+    for (i = 0; i < c->count; i++) Unmap(c->design[i]);
+    free(c->index);
+    memset(c, 0, sizeof(*c));
+}
+
+const Design *DesignCache_Add(DesignCache *c, const char *bitsPath, const char *fwPath, int *built) {
+    char bits[SHA256_HEX], fw[SHA256_HEX] = "", id[DESIGN_ID_SIZE];
+    uint32_t hashed = c->hashed, builds = c->builds;
+    Design *d;
+    *built = 0;
+    if (Store(c, bitsPath, "bit", bits) < 0 || (fwPath && Store(c, fwPath, "fw", fw) < 0)) {
+        *built = c->hashed != hashed || c->builds != builds;
+        return NULL;
+    }
+    if (*fw) snprintf(id, sizeof(id), "%s+%.*s", bits, DESIGN_FW_DIGITS, fw);
+    else strcpy(id, bits);
+    if ((d = Mapped(c, id))) {
+        c->hits++;
+        d->uses++;
+        *built = c->hashed != hashed;
+        return d;
+    }
+    d = Load(c, bits, fw);
+    *built = c->hashed != hashed || c->builds != builds;
+    return d ? Keep(c, d) : NULL;
+}
+
+const Design *DesignCache_Find(DesignCache *c, const char *id) {
+    char bits[SHA256_HEX], name[DESIGN_ID_SIZE];
+    const char *plus = strchr(id, '+');
+    size_t p = plus ? (size_t)(plus - id) : strlen(id);
+    Design *d;
+    int i, n;
+    if (p < 8 || p >= SHA256_HEX) { c->error = "not a design id"; return NULL; }
+    for (i = 0; i < c->count; i++) {
+        if (strncmp(c->design[i]->id, id, strlen(id)) == 0 && !c->design[i]->session == !plus) {
+            c->hits++;
+            c->design[i]->uses++;
+            return c->design[i];
+        }
+    }
+    // By the session image with an executable, by the bitstream without
+    n = Find_Object(c, id, plus ? "session" : "bit", name, sizeof(name));
+    if (n != 1) { c->error = n ? "ambiguous id" : "no such design"; return NULL; }
+    memcpy(bits, name, SHA256_HEX - 1);
+    bits[SHA256_HEX - 1] = 0;
+    if (!(d = Load(c, bits, plus ? name + SHA256_HEX : NULL))) return NULL;
+    return Keep(c, d);
+}
+
+int DesignCache_List(DesignCache *c, char ids[][DESIGN_ID_SIZE], int max) {
+    char dirPath[220];
+    DIR *dir;
+    struct dirent *e;
+    int n = 0;
+    snprintf(dirPath, sizeof(dirPath), "%s/objects", c->dir);
+    if (!(dir = opendir(dirPath))) return 0;
+    while ((e = readdir(dir)) && n < max) {
+        size_t len = strlen(e->d_name);
+        if (len == SHA256_HEX - 1 + 4 && strcmp(e->d_name + len - 4, ".bit") == 0) {
+            memcpy(ids[n], e->d_name, len - 4);
+            ids[n++][len - 4] = 0;
+        } else if (len == DESIGN_ID_SIZE - 1 + 8 && strcmp(e->d_name + len - 8, ".session") == 0) {
+            memcpy(ids[n], e->d_name, len - 8);
+            ids[n++][len - 8] = 0;
+        }
+    }
+    closedir(dir);
+    return n;
+}
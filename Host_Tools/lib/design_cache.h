@@ -0,0 +1,80 @@
+/*
+ * Content-addressed design cache
+ * - A design is a bitstream, or a bitstream and a NEORV32 executable. Its
+ *   id is the bitstream's SHA-256, plus '+' and the first 16 digits of the
+ *   executable's when there is one
+ * - Everything sent to a programmer is built once and kept under
+ *   dir/objects, named by digest: the bitstream (.bit), its wire image
+ *   (.wire), its chunk frames at the cache's chunk length (.c256), the
+ *   executable (.fw) and the session image of the two (<id>.session)
+ * - dir/index remembers which file (device, inode, size, mtime) had which
+ *   digest, so a file seen before is not read again until it changes
+ * - A design is checked once, when it is built: the executable's header
+ *   and word sum, the bitstream's chunk count. It is mapped read-only
+ *   when first used and stays mapped
+ */
+
+#ifndef DESIGN_CACHE_H
+#define DESIGN_CACHE_H
+
+#include "sha256.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define DESIGN_CACHE_MAX 64          // Designs mapped at once
+#define DESIGN_ID_SIZE   (SHA256_HEX + 17)
+#define DESIGN_FW_DIGITS 16
+
+typedef struct {
+    char           id[DESIGN_ID_SIZE];
+    char           bits[SHA256_HEX];
+    char           fw[SHA256_HEX];        // "" without an executable
+    const uint8_t *data;   size_t len;         // .bit
+    const uint8_t *frames; size_t framesLen;   // .c<chunk>
+    const uint8_t *wire;   size_t wireLen;     // .wire
+    const uint8_t *session; size_t sessionLen; // NULL without an executable
+    uint32_t       uses;
+} Design;
+
+typedef struct {
+    dev_t    dev;
+    ino_t    ino;
+    off_t    size;
+    int64_t  mtimeNs;
+    char     hex[SHA256_HEX];
+} DesignIndexEntry;
+
+typedef struct {
+    char              dir[200];
+    uint32_t          chunk;
+    DesignIndexEntry *index;
+    size_t            indexCount, indexCap;
+    Design           *design[DESIGN_CACHE_MAX];
+    int               count;
+    const char       *error;              // Why the last call failed
+    // Statistics
+    uint32_t          hits;               // Designs handed out already mapped
+    uint32_t          loads;              // Mapped from dir/objects
+    uint32_t          builds;             // Objects written
+    uint32_t          hashed;             // Files read to hash them
+} DesignCache;
+
+// dir and dir/objects made if missing, dir/index read
+int  DesignCache_Open(DesignCache *c, const char *dir, uint32_t chunk);
+void DesignCache_Close(DesignCache *c);
+
+// The design for these files (fwPath may be NULL), building what is
+// missing; NULL with c->error set if a file cannot be read or fails its
+// check. *built is 1 if anything was hashed or written
+const Design *DesignCache_Add(DesignCache *c, const char *bitsPath, const char *fwPath, int *built);
+
+// A design already in dir/objects, by id or any unique prefix of at least
+// 8 digits; NULL with c->error set otherwise
+const Design *DesignCache_Find(DesignCache *c, const char *id);
+
+// Ids of every design in dir/objects, up to max; the number found
+int  DesignCache_List(DesignCache *c, char ids[][DESIGN_ID_SIZE], int max);
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ * Whole files into memory
+ */
+
+#include "host_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+uint8_t *HostFile_Load(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    uint8_t *buf;
+    long n;
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END); n = ftell(f); fseek(f, 0, SEEK_SET);
+    *len = n > 0 ? (size_t)n : 0;
+    buf = malloc(*len ? *len : 1);
+    if (!buf || fread(buf, 1, *len, f) != *len) { fclose(f); free(buf); return NULL; }
+    fclose(f);
+    return buf;
+}
@@ -0,0 +1,16 @@
+/*
+ * Whole files into memory, for the tools, benches and tests
+ * - HostFile_Load returns a malloc'd copy of the file (at least one byte
+ *   allocated, so an empty file is not NULL) or NULL if it cannot be
+ *   opened or read; the caller reports and frees
+ */
+
+#ifndef HOST_FILE_H
+#define HOST_FILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint8_t *HostFile_Load(const char *path, size_t *len);
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Host mirror of fanout.adb
+ */
+
+#include "jtag_fanout.h"
+
+void JtagFanout_CaptureStatus(JtagMaster *m, JtagSampleAllFn sampleAll, int targets, uint32_t *status) {
+    int lead = m->active, total = m->active + 32 + (m->count - 1 - m->active), i, t;
+
+    for (t = 0; t < targets; t++) status[t] = 0;
+    Jtag_Pulse(m, 1, 1); // SELECT-DR-SCAN
+    Jtag_Pulse(m, 0, 1); // CAPTURE-DR
+    Jtag_Pulse(m, 0, 1);
+    for (i = 0; i < total; i++) {
+        uint32_t lines;
+        Jtag_Pulse(m, (uint8_t)(i == total - 1), 0);
+        lines = sampleAll(m->ctx);
+        if (i >= lead && i < lead + 32) {
+            for (t = 0; t < targets; t++) status[t] |= ((lines >> t) & 1u) << (i - lead);
+        }
+    }
+    Jtag_Pulse(m, 1, 1); // UPDATE-DR
+    Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+    Jtag_Pulse(m, 0, 1);
+}
+
+int JtagFanout_Program(JtagMaster *m, JtagSampleAllFn sampleAll, int targets,
+                       const uint8_t *data, size_t len, uint32_t *status) {
+    int t, done = 0;
+
+    Jtag_ResetTap(m);
+    Jtag_InitConfiguration(m);
+    Jtag_StreamBitstream(m, data, len);
+    // Send_Configuration_Bitstream tail, with the status capture fanned out
+    Jtag_SendCommand(m, 0x0A);
+    Jtag_ScanDR(m, 0, 32);
+    Jtag_SendCommand(m, 0x08);
+    Jtag_SendCommand(m, 0x3A);
+    Jtag_SendCommand(m, 0x02);
+    Jtag_SendCommand(m, 0x41);
+    JtagFanout_CaptureStatus(m, sampleAll, targets, status);
+
+    for (t = 0; t < targets; t++) {
+        if (status[t] & STATUS_DONE_BIT) done++;
+    }
+    return done;
+}
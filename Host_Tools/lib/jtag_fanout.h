@@ -0,0 +1,27 @@
+/*
+ * Host mirror of fanout.adb
+ * - Commands and bitstream go through the normal JtagMaster (shared TDI)
+ * - Only the status capture differs: one DR scan, every TDO line sampled
+ */
+
+#ifndef JTAG_FANOUT_H
+#define JTAG_FANOUT_H
+
+#include <stdint.h>
+
+#include "jtag_master.h"
+
+#define JTAG_FANOUT_MAX   4
+#define STATUS_DONE_BIT   0x00002000
+
+// TDO of every target as sampled on the last edge, bit k = target k
+typedef uint32_t (*JtagSampleAllFn)(void *ctx);
+
+// Same TCK sequence as Jtag_ScanDR(m, 0, 32); fills status[0 .. targets-1]
+void JtagFanout_CaptureStatus(JtagMaster *m, JtagSampleAllFn sampleAll, int targets, uint32_t *status);
+
+// Full session (Init, stream, finish) shared by every target
+int  JtagFanout_Program(JtagMaster *m, JtagSampleAllFn sampleAll, int targets,
+                        const uint8_t *data, size_t len, uint32_t *status);
+
+#endif
@@ -0,0 +1,269 @@
+/*
+ * Host reference JTAG master
+ */
+
+#include "jtag_master.h"
+
+#include <string.h>
+
+void Jtag_Init(JtagMaster *m, JtagClockFn clock, void *ctx) {
+    memset(m, 0, sizeof(*m));
+    m->clock = clock;
+    m->ctx = ctx;
+    m->count = 1;
+    m->dev[0].idcode = 0;
+    m->dev[0].irLength = JTAG_GOWIN_IR_LEN;
+}
+
+uint8_t Jtag_Pulse(JtagMaster *m, uint8_t tms, uint8_t tdi) {
+    m->tckCount++;
+    return m->clock(m->ctx, tms, tdi);
+}
+
+// Phase timing in TCKs, like the firmware's Profiler.Start / Profiler.Stop
+static void Prof_Stop(JtagMaster *m, ProfPhase ph, uint64_t since) {
+    if (m->prof) SessionProf_Sample(m->prof, ph, (uint32_t)(m->tckCount - since));
+}
+
+uint8_t Jtag_KnownIrLength(uint32_t idcode) {
+    if ((idcode & 0xFFF) == 0x81B) return JTAG_GOWIN_IR_LEN;  // Gowin (JEDEC 0x40D)
+    return 0;
+}
+
+void Jtag_ResetTap(JtagMaster *m) {
+    uint64_t t = m->tckCount;
+    int i;
+    for (i = 0; i < 6; i++) Jtag_Pulse(m, 1, 1);
+    Prof_Stop(m, PROF_RESET, t);
+}
+
+// --- DISCOVERY ---
+static int Split_Capture(JtagMaster *m, const uint8_t *cap, int total) {
+    int starts[JTAG_MAX_IR_BITS];
+    int nStarts = 0, i, sum = 0, unknown = -1;
+
+    // IEEE 1149.1: every captured IR ends in ...01 (LSB first: 1 then 0)
+    for (i = 0; i + 1 < total; i++) {
+        if (cap[i] == 1 && cap[i + 1] == 0 && (nStarts == 0 || i >= starts[nStarts - 1] + 2)) {
+            starts[nStarts++] = i;
+        }
+    }
+    if (nStarts > 0 && nStarts == m->count && starts[0] == 0) {
+        for (i = 0; i < m->count; i++) {
+            int end = (i + 1 < m->count) ? starts[i + 1] : total;
+            m->dev[i].irLength = (uint8_t)(end - starts[i]);
+        }
+        return 0;
+    }
+
+    // Ambiguous capture pattern: fall back on known parts, one unknown allowed
+    for (i = 0; i < m->count; i++) {
+        m->dev[i].irLength = Jtag_KnownIrLength(m->dev[i].idcode);
+        if (m->dev[i].irLength == 0) {
+            if (unknown >= 0) return -1;
+            unknown = i;
+        }
+        sum += m->dev[i].irLength;
+    }
+    if (unknown >= 0) {
+        if (total - sum < 2) return -1;
+        m->dev[unknown].irLength = (uint8_t)(total - sum);
+        return 0;
+    }
+    return (sum == total) ? 0 : -1;
+}
+
+int Jtag_Discover(JtagMaster *m) {
+    uint8_t cap[JTAG_MAX_IR_BITS];
+    int count = 0, total = 0, i;
+
+    Jtag_ResetTap(m);
+    Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+
+    // IDCODE enumeration: after reset each TAP holds IDCODE (32 bits, LSB 1) or BYPASS (1 bit, 0)
+    Jtag_Pulse(m, 1, 1); // SELECT-DR-SCAN
+    Jtag_Pulse(m, 0, 1); // CAPTURE-DR
+    Jtag_Pulse(m, 0, 1); // SHIFT-DR
+    while (count < JTAG_MAX_DEVICES) {
+        uint32_t id;
+        int b;
+        if (Jtag_Pulse(m, 0, 1) == 0) {
+            m->dev[count].idcode = 0;
+            m->dev[count].irLength = 0;
+            count++;
+            continue;
+        }
+        id = 1;
+        for (b = 1; b < 32; b++) id |= (uint32_t)Jtag_Pulse(m, 0, 1) << b;
+        if (id == 0xFFFFFFFFu) break; // Our own ones came back: end of chain
+        m->dev[count].idcode = id;
+        m->dev[count].irLength = 0;
+        count++;
+    }
+    Jtag_Pulse(m, 1, 1); // EXIT1-DR
+    Jtag_Pulse(m, 1, 1); // UPDATE-DR
+    Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+    if (count == 0 || count == JTAG_MAX_DEVICES) return -1;
+    m->count = count;
+
+    // IR lengths: read the capture pattern while flooding with ones, then count ones back
+    Jtag_Pulse(m, 1, 1); // SELECT-DR-SCAN
+    Jtag_Pulse(m, 1, 1); // SELECT-IR-SCAN
+    Jtag_Pulse(m, 0, 1); // CAPTURE-IR
+    Jtag_Pulse(m, 0, 1); // SHIFT-IR
+    for (i = 0; i < JTAG_MAX_IR_BITS; i++) cap[i] = Jtag_Pulse(m, 0, 1);
+    while (total < JTAG_MAX_IR_BITS && Jtag_Pulse(m, 0, 0) == 1) total++;
+    // Refill with ones so UPDATE-IR leaves every TAP in BYPASS
+    for (i = 0; i <= total; i++) Jtag_Pulse(m, (uint8_t)(i == total), 1);
+    Jtag_Pulse(m, 1, 1); // UPDATE-IR
+    Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+    if (total == 0 || total >= JTAG_MAX_IR_BITS) return -1;
+    if (Split_Capture(m, cap, total) != 0) return -1;
+
+    m->active = 0;
+    for (i = 0; i < m->count; i++) {
+        if (Jtag_KnownIrLength(m->dev[i].idcode) == JTAG_GOWIN_IR_LEN) { m->active = i; break; }
+    }
+    return m->count;
+}
+
+int Jtag_Select(JtagMaster *m, int index) {
+    if (index < 0 || index >= m->count) return -1;
+    m->active = index;
+    return 0;
+}
+
+// --- PADDED SCANS ---
+void Jtag_ShiftIR(JtagMaster *m, uint8_t instr) {
+    int totalBits = 0, shifted = 0, i, b;
+
+    for (i = 0; i < m->count; i++) totalBits += m->dev[i].irLength;
+
+    Jtag_Pulse(m, 1, 1); // SELECT-DR-SCAN
+    Jtag_Pulse(m, 1, 1); // SELECT-IR-SCAN
+    Jtag_Pulse(m, 0, 1); // CAPTURE-IR
+    Jtag_Pulse(m, 0, 1);
+    for (i = 0; i < m->count; i++) {
+        for (b = 0; b < m->dev[i].irLength; b++) {
+            uint8_t tdi = (i == m->active) ? (uint8_t)((instr >> b) & 1) : 1;
+            shifted++;
+            Jtag_Pulse(m, (uint8_t)(shifted == totalBits), tdi);
+        }
+    }
+    Jtag_Pulse(m, 1, 1); // UPDATE-IR
+}
+
+uint32_t Jtag_ShiftDR(JtagMaster *m, uint32_t dataOut, int nbits) {
+    int lead = m->active, trail = m->count - 1 - m->active;
+    int totalBits = lead + nbits + trail, i;
+    uint32_t captured = 0;
+
+    Jtag_Pulse(m, 1, 1); // SELECT-DR-SCAN
+    Jtag_Pulse(m, 0, 1); // CAPTURE-DR
+    Jtag_Pulse(m, 0, 1);
+    for (i = 0; i < totalBits; i++) {
+        uint8_t tdi = 0, tdo;
+        if (i >= lead && i < lead + nbits) tdi = (uint8_t)((dataOut >> (i - lead)) & 1);
+        tdo = Jtag_Pulse(m, (uint8_t)(i == totalBits - 1), tdi);
+        if (i >= lead && i < lead + nbits) captured |= (uint32_t)tdo << (i - lead);
+    }
+    Jtag_Pulse(m, 1, 1); // UPDATE-DR
+    return captured;
+}
+
+void Jtag_SendCommand(JtagMaster *m, uint8_t instr) {
+    uint64_t t = m->tckCount;
+    Jtag_ShiftIR(m, instr);
+    Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+    Jtag_Pulse(m, 0, 1); // Extra pulse to ensure the FPGA has time to process the command
+    Prof_Stop(m, PROF_COMMAND, t);
+}
+
+uint32_t Jtag_ScanDR(JtagMaster *m, uint32_t dataOut, int nbits) {
+    uint32_t captured = Jtag_ShiftDR(m, dataOut, nbits);
+    Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+    Jtag_Pulse(m, 0, 1); // Extra pulse to ensure the FPGA has time to process the command
+    return captured;
+}
+
+uint32_t Jtag_ReadStatus(JtagMaster *m) {
+    Jtag_SendCommand(m, 0x41);
+    return Jtag_ScanDR(m, 0, 32);
+}
+
+// --- SESSION PHASES (Init_Configuration / Send_Configuration_Bitstream) ---
+void Jtag_InitConfiguration(JtagMaster *m) {
+    uint64_t t = m->tckCount;
+    int i;
+    Jtag_SendCommand(m, 0x41);
+    for (i = 1; i <= 10; i++) Jtag_Pulse(m, 0, 1);
+    Jtag_ScanDR(m, 0, 32);
+    Jtag_SendCommand(m, 0x15);
+    Jtag_SendCommand(m, 0x41);
+    Jtag_Pulse(m, 0, 1);
+    Jtag_Pulse(m, 0, 1);
+    Jtag_ScanDR(m, 0, 32);
+    Jtag_SendCommand(m, 0x05);
+    Jtag_SendCommand(m, 0x02);
+    Jtag_SendCommand(m, 0x41);
+    Jtag_ScanDR(m, 0, 32);
+    Jtag_SendCommand(m, 0x09);
+    Jtag_SendCommand(m, 0x02);
+    Jtag_SendCommand(m, 0x3A);
+    Jtag_SendCommand(m, 0x02);
+    Jtag_SendCommand(m, 0x41);
+    Jtag_ScanDR(m, 0, 32);
+    Jtag_SendCommand(m, 0x15);
+    Jtag_SendCommand(m, 0x12);
+    Jtag_SendCommand(m, 0x17);
+    Prof_Stop(m, PROF_INIT, t);
+}
+
+void Jtag_BeginStream(JtagMaster *m) {
+    m->streamStart = m->tckCount;
+    m->streamBytes = 0;
+    Jtag_Pulse(m, 1, 1); // SELECT-DR-SCAN
+    Jtag_Pulse(m, 0, 1); // CAPTURE-DR
+    Jtag_Pulse(m, 0, 1); // Shift-DR
+}
+
+// SPI body: MSB first, TMS held low
+void Jtag_StreamBytes(JtagMaster *m, const uint8_t *data, size_t len) {
+    size_t n;
+    int i;
+    for (n = 0; n < len; n++) {
+        for (i = 7; i >= 0; i--) Jtag_Pulse(m, 0, (uint8_t)((data[n] >> i) & 1));
+    }
+    m->streamBytes += len;
+}
+
+void Jtag_EndStream(JtagMaster *m, uint8_t last) {
+    int trail = m->count - 1 - m->active, i;
+    // Transceive_Last_Byte plus one bypass bit per TAP between TDI and the target
+    for (i = 7; i >= 0; i--) Jtag_Pulse(m, (uint8_t)(i == 0 && trail == 0), (uint8_t)((last >> i) & 1));
+    for (i = 0; i < trail; i++) Jtag_Pulse(m, (uint8_t)(i == trail - 1), 1);
+    Jtag_Pulse(m, 1, 1); // UPDATE-DR
+    Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+    m->streamBytes++;
+    if (m->prof) m->prof->bytes += (uint32_t)m->streamBytes;
+    Prof_Stop(m, PROF_PUMP, m->streamStart);
+}
+
+void Jtag_StreamBitstream(JtagMaster *m, const uint8_t *data, size_t len) {
+    if (len == 0) return;
+    Jtag_BeginStream(m);
+    Jtag_StreamBytes(m, data, len - 1);
+    Jtag_EndStream(m, data[len - 1]);
+}
+
+void Jtag_FinishConfiguration(JtagMaster *m) {
+    uint64_t t = m->tckCount;
+    Jtag_SendCommand(m, 0x0A);
+    Jtag_ScanDR(m, 0, 32);
+    Jtag_SendCommand(m, 0x08);
+    Jtag_SendCommand(m, 0x3A);
+    Jtag_SendCommand(m, 0x02);
+    Jtag_SendCommand(m, 0x41);
+    Jtag_ScanDR(m, 0, 32);
+    Prof_Stop(m, PROF_TRAILER, t);
+}
@@ -0,0 +1,73 @@
+/*
+ * Host reference JTAG master
+ * - Mirrors the TCK/TMS/TDI sequences of mcu_to_fpga.adb and jtag_chain.adb
+ *   so the simulator sees exactly what the STM32 would drive
+ * - Talks to any cable through a single per-edge clock callback
+ * - Device index 0 is the TAP nearest TDO (Ada Device 1)
+ */
+
+#ifndef JTAG_MASTER_H
+#define JTAG_MASTER_H
+
+#include "session_prof.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JTAG_MAX_DEVICES 8
+#define JTAG_MAX_IR_BITS 64
+#define JTAG_GOWIN_IR_LEN 8
+
+// One TCK rising edge with the given TMS/TDI; returns TDO sampled on that edge
+typedef uint8_t (*JtagClockFn)(void *ctx, uint8_t tms, uint8_t tdi);
+
+typedef struct {
+    uint32_t idcode;      // 0 = device came up in BYPASS (no IDCODE register)
+    uint8_t  irLength;
+} JtagDevice;
+
+typedef struct {
+    JtagClockFn clock;
+    void       *ctx;
+    uint64_t    tckCount;
+    JtagDevice  dev[JTAG_MAX_DEVICES];
+    int         count;
+    int         active;
+    SessionProf *prof;    // Optional: session phases timed in TCKs
+    uint64_t    streamStart;
+    size_t      streamBytes;
+} JtagMaster;
+
+// Starts out as the firmware does: one 8-bit Gowin TAP, no discovery needed
+void     Jtag_Init(JtagMaster *m, JtagClockFn clock, void *ctx);
+uint8_t  Jtag_Pulse(JtagMaster *m, uint8_t tms, uint8_t tdi);
+
+void     Jtag_ResetTap(JtagMaster *m);
+int      Jtag_Discover(JtagMaster *m);   // device count, -1 on a broken chain
+int      Jtag_Select(JtagMaster *m, int index);
+
+// Padded scans: every other TAP is held in BYPASS
+void     Jtag_SendCommand(JtagMaster *m, uint8_t instr);
+uint32_t Jtag_ScanDR(JtagMaster *m, uint32_t dataOut, int nbits);
+uint32_t Jtag_ReadStatus(JtagMaster *m);
+
+// The same scans without the walk back: they enter from Run-Test/Idle or
+// either Update state and stop in Update-IR / Update-DR (lib/jtag_opt.c)
+void     Jtag_ShiftIR(JtagMaster *m, uint8_t instr);
+uint32_t Jtag_ShiftDR(JtagMaster *m, uint32_t dataOut, int nbits);
+
+// Same phases as the firmware session
+void     Jtag_InitConfiguration(JtagMaster *m);
+void     Jtag_StreamBitstream(JtagMaster *m, const uint8_t *data, size_t len);
+void     Jtag_FinishConfiguration(JtagMaster *m);
+
+// Jtag_StreamBitstream in pieces, as the firmware pump sends it: the body
+// as it arrives, the last byte (with the TMS exit) once the host goes quiet
+void     Jtag_BeginStream(JtagMaster *m);
+void     Jtag_StreamBytes(JtagMaster *m, const uint8_t *data, size_t len);
+void     Jtag_EndStream(JtagMaster *m, uint8_t last);
+
+// IR length the firmware assumes for a known IDCODE (0 if unknown)
+uint8_t  Jtag_KnownIrLength(uint32_t idcode);
+
+#endif
@@ -0,0 +1,248 @@
+/*
+ * JTAG command sequence optimizer
+ */
+
+#include "jtag_opt.h"
+#include "tap_chain.h"
+
+#include <string.h>
+
+// --- SEQUENCES ---
+void JtagSeq_Init(JtagSeq *s) { s->n = 0; }
+
+static int Add(JtagSeq *s, uint8_t kind, uint8_t instr, size_t n, uint32_t data, uint8_t keep, const uint8_t *bytes) {
+    JtagOp *op;
+    if (s->n >= JTAG_SEQ_MAX) return -1;
+    op = &s->op[s->n++];
+    op->kind = kind; op->instr = instr; op->exit = JOP_EXIT_EXTRA;
+    op->keep = keep; op->n = n; op->data = data; op->bytes = bytes;
+    return 0;
+}
+
+int JtagSeq_Reset(JtagSeq *s) { return Add(s, JOP_RESET, 0, 0, 0, 0, NULL); }
+int JtagSeq_Command(JtagSeq *s, uint8_t instr) { return Add(s, JOP_COMMAND, instr, 0, 0, 0, NULL); }
+int JtagSeq_Scan(JtagSeq *s, uint32_t data, int nbits, int keep) { return Add(s, JOP_SCAN, 0, (size_t)nbits, data, (uint8_t)(keep != 0), NULL); }
+int JtagSeq_Idle(JtagSeq *s, int tcks) { return Add(s, JOP_IDLE, 0, (size_t)tcks, 0, 0, NULL); }
+int JtagSeq_Stream(JtagSeq *s, const uint8_t *data, size_t len) { return Add(s, JOP_STREAM, 0, len, 0, 0, data); }
+
+int JtagSeq_Session(JtagSeq *s, const uint8_t *bits, size_t len) {
+    static const uint8_t init[] = { 0x05, 0x02, 0x41, 0, 0x09, 0x02, 0x3A, 0x02, 0x41, 0, 0x15, 0x12, 0x17 };
+    int err = 0;
+    size_t i;
+
+    err |= JtagSeq_Reset(s);
+    // Init_Configuration: the first two status reads have their own waits
+    err |= JtagSeq_Command(s, 0x41);
+    err |= JtagSeq_Idle(s, 10);
+    err |= JtagSeq_Scan(s, 0, 32, 0);
+    err |= JtagSeq_Command(s, 0x15);
+    err |= JtagSeq_Command(s, 0x41);
+    err |= JtagSeq_Idle(s, 2);
+    err |= JtagSeq_Scan(s, 0, 32, 0);
+    for (i = 0; i < sizeof(init); i++) err |= init[i] ? JtagSeq_Command(s, init[i]) : JtagSeq_Scan(s, 0, 32, 0);
+    if (len) err |= JtagSeq_Stream(s, bits, len);
+
+    // Finish_Configuration: Capture_Status_All is the read that counts
+    err |= JtagSeq_Command(s, 0x0A);
+    err |= JtagSeq_Scan(s, 0, 32, 0);
+    err |= JtagSeq_Command(s, 0x08);
+    err |= JtagSeq_Command(s, 0x3A);
+    err |= JtagSeq_Command(s, 0x02);
+    err |= JtagSeq_Command(s, 0x41);
+    err |= JtagSeq_Scan(s, 0, 32, 1);
+    return err ? -1 : 0;
+}
+
+const char *JtagOp_Name(const JtagOp *op) {
+    static const char *const names[] = { "reset", "command", "scan", "idle", "stream" };
+    return op->kind < sizeof(names) / sizeof(names[0]) ? names[op->kind] : "?";
+}
+
+// --- PLAYBACK ---
+static void Walk_Back(JtagMaster *m, uint8_t exit) {
+    if (exit >= JOP_EXIT_IDLE) Jtag_Pulse(m, 0, 1); // RUN-TEST/IDLE
+    if (exit >= JOP_EXIT_EXTRA) Jtag_Pulse(m, 0, 1);
+}
+
+void JtagSeq_Play(JtagMaster *m, const JtagSeq *s, uint32_t *reads, uint32_t *tcks) {
+    int i;
+    size_t k;
+    for (i = 0; i < s->n; i++) {
+        const JtagOp *op = &s->op[i];
+        uint64_t t = m->tckCount;
+        uint32_t r = 0;
+        switch (op->kind) {
+            case JOP_RESET: Jtag_ResetTap(m); break;
+            case JOP_COMMAND:
+                if (op->exit == JOP_EXIT_EXTRA) Jtag_SendCommand(m, op->instr);
+                else { Jtag_ShiftIR(m, op->instr); Walk_Back(m, op->exit); }
+                break;
+            case JOP_SCAN:
+                if (op->exit == JOP_EXIT_EXTRA) r = Jtag_ScanDR(m, op->data, (int)op->n);
+                else { r = Jtag_ShiftDR(m, op->data, (int)op->n); Walk_Back(m, op->exit); }
+                break;
+            case JOP_IDLE: for (k = 0; k < op->n; k++) Jtag_Pulse(m, 0, 1); break;
+            case JOP_STREAM: Jtag_StreamBitstream(m, op->bytes, op->n); break;
+        }
+        if (reads) reads[i] = r;
+        if (tcks) tcks[i] = (uint32_t)(m->tckCount - t);
+    }
+}
+
+// --- REPLAY ---
+typedef struct {
+    TapState      tap;
+    ProtocolState proto;
+    uint8_t       lastCmd, edit, done, leds, unknown, erasePollCount;
+    uint32_t      erasePolls, diagErasePolls, streamBits;
+} TapEnd;
+
+typedef struct {
+    TapEnd   end[JTAG_MAX_DEVICES];
+    uint32_t kept[JTAG_SEQ_MAX];
+    int      nKept;
+    uint64_t tcks;
+} Replay;
+
+static void Replay_Run(const JtagSeq *s, int devices, int target, Replay *r) {
+    TapChain chain;
+    JtagMaster m;
+    uint32_t reads[JTAG_SEQ_MAX];
+    int i;
+
+    TapChain_Init(&chain);
+    for (i = 0; i < devices; i++) TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    m.count = devices;
+    for (i = 0; i < devices; i++) m.dev[i].irLength = JTAG_GOWIN_IR_LEN;
+    m.active = target;
+
+    JtagSeq_Play(&m, s, reads, NULL);
+
+    memset(r, 0, sizeof(*r));
+    r->tcks = m.tckCount;
+    for (i = 0; i < s->n; i++) {
+        if (s->op[i].kind == JOP_SCAN && s->op[i].keep) r->kept[r->nKept++] = reads[i];
+    }
+    for (i = 0; i < devices; i++) {
+        const GowinTap *g = TapChain_Gowin(&chain, i);
+        TapEnd *e = &r->end[i];
+        e->tap = g->tapState; e->proto = g->protoState; e->lastCmd = g->lastCmd;
+        e->edit = g->isEditMode; e->done = g->isDone; e->leds = g->leds;
+        e->unknown = g->diagUnknownCmd; e->erasePollCount = g->erasePollCount;
+        // Polls after ERASE count: the emulator reports them with ERASE_DONE
+        e->erasePolls = g->erasePolls; e->diagErasePolls = g->diagErasePolls;
+        e->streamBits = g->diagStreamBits;
+    }
+}
+
+static int Replay_Same(const Replay *a, const Replay *b, int devices) {
+    int i;
+    if (a->nKept != b->nKept) return 0;
+    for (i = 0; i < a->nKept; i++) if (a->kept[i] != b->kept[i]) return 0;
+    for (i = 0; i < devices; i++) {
+        const TapEnd *x = &a->end[i], *y = &b->end[i];
+        if (x->tap != y->tap || x->proto != y->proto || x->lastCmd != y->lastCmd
+            || x->edit != y->edit || x->done != y->done || x->leds != y->leds
+            || x->unknown != y->unknown || x->erasePollCount != y->erasePollCount
+            || x->erasePolls != y->erasePolls || x->diagErasePolls != y->diagErasePolls
+            || x->streamBits != y->streamBits) return 0;
+    }
+    return 1;
+}
+
+int JtagOpt_Equivalent(const JtagSeq *a, const JtagSeq *b, int devices, int target) {
+    Replay ra, rb;
+    if (devices < 1 || devices > JTAG_MAX_DEVICES || target < 0 || target >= devices) return 0;
+    Replay_Run(a, devices, target, &ra);
+    Replay_Run(b, devices, target, &rb);
+    return Replay_Same(&ra, &rb, devices);
+}
+
+// --- OPTIMIZER ---
+typedef struct {
+    JtagSeq seq;
+    int     src[JTAG_SEQ_MAX];   // Op of the input each op came from
+} Work;
+
+static void Drop(const Work *w, Work *out, int i, int j) {
+    int k;
+    out->seq.n = 0;
+    for (k = 0; k < w->seq.n; k++) {
+        if (k == i || k == j) continue;
+        out->seq.op[out->seq.n] = w->seq.op[k];
+        out->src[out->seq.n++] = w->src[k];
+    }
+}
+
+// The scan a status read at i feeds, past any waits; -1 if its value is used
+static int Status_Scan(const JtagSeq *s, int i) {
+    int j = i + 1;
+    if (s->op[i].kind != JOP_COMMAND || s->op[i].instr != CMD_READ_STATUS) return -1;
+    while (j < s->n && s->op[j].kind == JOP_IDLE) j++;
+    if (j >= s->n || s->op[j].kind != JOP_SCAN || s->op[j].keep) return -1;
+    return j;
+}
+
+static int Proves(const Replay *ref, const JtagSeq *s, int devices, int target, JtagOptReport *r) {
+    Replay t;
+    r->trials++;
+    Replay_Run(s, devices, target, &t);
+    return Replay_Same(ref, &t, devices);
+}
+
+int JtagOpt_Run(const JtagSeq *in, JtagSeq *out, int devices, int target, JtagOptReport *r) {
+    Replay ref, fin;
+    Work cur, trial;
+    int i;
+
+    memset(r, 0, sizeof(*r));
+    r->opsBefore = in->n;
+    if (devices < 1 || devices > JTAG_MAX_DEVICES || target < 0 || target >= devices) return -1;
+    Replay_Run(in, devices, target, &ref);
+    r->tckBefore = ref.tcks;
+
+    cur.seq = *in;
+    for (i = 0; i < in->n; i++) cur.src[i] = i;
+
+    // NOOPs and unused status reads, one at a time against the original
+    i = 0;
+    while (i < cur.seq.n) {
+        const JtagOp *op = &cur.seq.op[i];
+        int j = -1, noop = op->kind == JOP_COMMAND && op->instr == CMD_NOOP;
+        if (!noop) j = Status_Scan(&cur.seq, i);
+        if (noop || j >= 0) {
+            Drop(&cur, &trial, i, j);
+            if (Proves(&ref, &trial.seq, devices, target, r)) {
+                r->dropped[cur.src[i]] = 1;
+                if (j >= 0) r->dropped[cur.src[j]] = 1;
+                if (noop) r->noops++; else r->reads++;
+                cur = trial;
+                continue;
+            }
+        }
+        i++;
+    }
+
+    // Walks: straight on to the next scan, or back to Idle without the extra pulse
+    for (i = 0; i < cur.seq.n; i++) {
+        JtagOp *op = &cur.seq.op[i];
+        uint8_t next = i + 1 < cur.seq.n ? cur.seq.op[i + 1].kind : JOP_IDLE;
+        if (op->kind != JOP_COMMAND && op->kind != JOP_SCAN) continue;
+
+        if (next != JOP_IDLE) {
+            op->exit = JOP_EXIT_DIRECT;
+            if (Proves(&ref, &cur.seq, devices, target, r)) { r->direct++; continue; }
+        }
+        op->exit = JOP_EXIT_IDLE;
+        if (Proves(&ref, &cur.seq, devices, target, r)) { r->trimmed++; continue; }
+        op->exit = JOP_EXIT_EXTRA;
+    }
+
+    *out = cur.seq;
+    r->opsAfter = out->n;
+    Replay_Run(out, devices, target, &fin);
+    r->tckAfter = fin.tcks;
+    r->equivalent = Replay_Same(&ref, &fin, devices);
+    return r->equivalent ? 0 : -1;
+}
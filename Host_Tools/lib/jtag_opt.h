@@ -0,0 +1,82 @@
+/*
+ * JTAG command sequence optimizer
+ * - A session as ops (reset, command, DR scan, Run-Test/Idle wait, bitstream)
+ *   that JtagSeq_Play drives through a JtagMaster; as built, the TCKs are
+ *   exactly those of Jtag_InitConfiguration and friends
+ * - JtagOpt_Run drops 0x02 NOOPs and status reads (0x41 and its scan) whose
+ *   value nobody uses, and lets a command or scan stay in Update-IR/DR so
+ *   the next one starts from there instead of Run-Test/Idle
+ * - Each change is kept only if a replay on the Gowin TAP model ends in the
+ *   same state with the same kept reads: the model has no timing, so the
+ *   caller's waits are never touched
+ */
+
+#ifndef JTAG_OPT_H
+#define JTAG_OPT_H
+
+#include "jtag_master.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define JTAG_SEQ_MAX 64
+
+typedef enum { JOP_RESET=0, JOP_COMMAND, JOP_SCAN, JOP_IDLE, JOP_STREAM } JtagOpKind;
+
+// How a command or scan leaves Update-IR / Update-DR
+#define JOP_EXIT_DIRECT 0   // Stays there; the next scan's TMS 1 is Select-DR
+#define JOP_EXIT_IDLE   1   // Run-Test/Idle
+#define JOP_EXIT_EXTRA  2   // Run-Test/Idle and one more pulse there, as Jtag_SendCommand
+
+typedef struct {
+    uint8_t        kind;
+    uint8_t        instr;   // COMMAND
+    uint8_t        exit;    // COMMAND, SCAN
+    uint8_t        keep;    // SCAN: the caller uses what it reads
+    size_t         n;       // SCAN: bits (up to 32), IDLE: TCKs, STREAM: bytes
+    uint32_t       data;    // SCAN: shifted in
+    const uint8_t *bytes;   // STREAM
+} JtagOp;
+
+typedef struct {
+    JtagOp op[JTAG_SEQ_MAX];
+    int    n;
+} JtagSeq;
+
+// Each returns -1 once the sequence is full
+void JtagSeq_Init(JtagSeq *s);
+int  JtagSeq_Reset(JtagSeq *s);
+int  JtagSeq_Command(JtagSeq *s, uint8_t instr);
+int  JtagSeq_Scan(JtagSeq *s, uint32_t data, int nbits, int keep);
+int  JtagSeq_Idle(JtagSeq *s, int tcks);
+int  JtagSeq_Stream(JtagSeq *s, const uint8_t *data, size_t len);
+
+// Jtag_ResetTap, Jtag_InitConfiguration, Jtag_StreamBitstream and
+// Jtag_FinishConfiguration; only the trailer's status read is kept
+int  JtagSeq_Session(JtagSeq *s, const uint8_t *bits, size_t len);
+
+// reads[i] / tcks[i]: what scan op i shifted out, the TCKs op i took (either may be NULL)
+void JtagSeq_Play(JtagMaster *m, const JtagSeq *s, uint32_t *reads, uint32_t *tcks);
+
+const char *JtagOp_Name(const JtagOp *op);
+
+// Plays s on a fresh chain of `devices` Gowin TAPs, `target` selected, and
+// compares the end state of every TAP and the kept reads, in order
+int  JtagOpt_Equivalent(const JtagSeq *a, const JtagSeq *b, int devices, int target);
+
+typedef struct {
+    uint64_t tckBefore, tckAfter;
+    int      opsBefore, opsAfter;
+    int      noops;        // 0x02 commands dropped
+    int      reads;        // Status reads dropped
+    int      direct;       // Commands and scans now left in Update
+    int      trimmed;      // Back to Idle without the extra pulse
+    int      trials;       // Replays to prove each change
+    int      equivalent;   // Final replay of out against in
+    uint8_t  dropped[JTAG_SEQ_MAX];   // By op of `in`
+} JtagOptReport;
+
+// Returns 0 if out replays the same as in (it always should), -1 otherwise
+int  JtagOpt_Run(const JtagSeq *in, JtagSeq *out, int devices, int target, JtagOptReport *r);
+
+#endif
@@ -0,0 +1,317 @@
+/*
+ * JTAG edge trace from the emulator's capture mode
+ */
+
+#include "jtag_trace.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define VCD_KEEP 32            // Edges kept at each end of a long run
+
+void JtagTrace_Init(JtagTrace *t) {
+    memset(t, 0, sizeof(*t));
+}
+
+void JtagTrace_Free(JtagTrace *t) {
+    free(t->span);
+    free(t->mark);
+    memset(t, 0, sizeof(*t));
+}
+
+static void PushSpan(JtagTrace *t, const JtagSpan *s) {
+    if (t->spans == t->spanCap) {
+        t->spanCap = t->spanCap ? t->spanCap * 2 : 1024;
+        t->span = realloc(t->span, t->spanCap * sizeof(*t->span));
+    }
+    t->span[t->spans++] = *s;
+    t->edges += s->count;
+}
+
+static void PushMark(JtagTrace *t, uint8_t id, uint32_t arg) {
+    if (t->marks == t->markCap) {
+        t->markCap = t->markCap ? t->markCap * 2 : 256;
+        t->mark = realloc(t->mark, t->markCap * sizeof(*t->mark));
+    }
+    t->mark[t->marks].t = t->now;
+    t->mark[t->marks].id = id;
+    t->mark[t->marks].arg = arg;
+    t->marks++;
+}
+
+void JtagTrace_Add(JtagTrace *t, const LogRecord *r) {
+    JtagSpan s;
+
+    t->now += r->dt;
+    if (t->havePend && r->id != LOG_ID_TRACE_SPAN) { t->badRecords++; t->havePend = 0; }
+
+    switch (r->id) {
+        case LOG_ID_TRACE_EDGE:
+            memset(&s, 0, sizeof(s));
+            s.t = s.last = t->now; s.count = 1;
+            s.tms = r->arg & 1; s.tdi = (r->arg >> 1) & 1; s.tdo = (r->arg >> 2) & 1;
+            s.state = (r->arg >> 3) & 0x0F; s.high = r->arg >> 7;
+            PushSpan(t, &s);
+            break;
+        case LOG_ID_TRACE_RUN:
+            memset(&t->pend, 0, sizeof(t->pend));
+            t->pend.t = t->now; t->pend.count = r->arg >> 5;
+            t->pend.state = r->arg & 0x0F; t->pend.tms = (r->arg >> 4) & 1;
+            t->havePend = 1;
+            break;
+        case LOG_ID_TRACE_SPAN:
+            if (!t->havePend) { t->badRecords++; break; }
+            t->pend.last = t->now; t->pend.high = r->arg;
+            PushSpan(t, &t->pend);
+            t->havePend = 0;
+            break;
+        case LOG_ID_TRACE_LOST: t->lostEdges = r->arg; break;
+        case LOG_ID_DROPPED:    t->lostEvents = r->arg; break;
+        case LOG_ID_BOOT:       t->traceOn |= (r->arg & LOG_SRC_TRACE) != 0; break;
+        default:
+            if (r->id < LOG_ID_TRACE_EDGE) PushMark(t, r->id, r->arg);
+            break;
+    }
+}
+
+// --- STATISTICS ---
+typedef struct { double p; uint64_t w; } Period;
+
+static int ComparePeriod(const void *a, const void *b) {
+    double x = ((const Period *)a)->p, y = ((const Period *)b)->p;
+    return (x > y) - (x < y);
+}
+
+static double MedianPeriod(const JtagTrace *t) {
+    Period *p = malloc((2 * t->spans + 1) * sizeof(*p));
+    uint64_t total = 0, acc = 0;
+    size_t n = 0, i;
+    double m = 0;
+
+    for (i = 0; i < t->spans; i++) {
+        const JtagSpan *s = &t->span[i];
+        if (i) { p[n].p = (double)(s->t - t->span[i - 1].last); p[n].w = 1; total++; n++; }
+        if (s->count > 1) { p[n].p = (double)(s->last - s->t) / (s->count - 1); p[n].w = s->count - 1; total += p[n].w; n++; }
+    }
+    qsort(p, n, sizeof(*p), ComparePeriod);
+    for (i = 0; i < n; i++) {
+        acc += p[i].w;
+        if (2 * acc >= total) { m = p[i].p; break; }
+    }
+    free(p);
+    return m;
+}
+
+static void AddWorst(JtagTraceStats *s, const JtagGap *g) {
+    int i = s->nWorst < JTAG_TRACE_WORST ? s->nWorst++ : JTAG_TRACE_WORST;
+    if (i == JTAG_TRACE_WORST) {
+        if (g->len <= s->worst[JTAG_TRACE_WORST - 1].len) return;
+        i = JTAG_TRACE_WORST - 1;
+    }
+    while (i > 0 && s->worst[i - 1].len < g->len) { s->worst[i] = s->worst[i - 1]; i--; }
+    s->worst[i] = *g;
+}
+
+void JtagTrace_Analyze(const JtagTrace *t, uint64_t minGapTicks, JtagTraceStats *s) {
+    double sumP = 0, minP = 0, maxP = 0, hiSum = 0, hiPer = 0, p;
+    uint64_t n = 0;
+    long m = -1;
+    size_t i;
+    JtagGap g;
+
+    memset(s, 0, sizeof(*s));
+    s->duty = -1;
+    s->edges = t->edges;
+    if (!t->spans) return;
+
+    s->gapThreshold = (uint64_t)(8 * MedianPeriod(t));
+    if (s->gapThreshold < minGapTicks) s->gapThreshold = minGapTicks;
+    s->totalTicks = t->span[t->spans - 1].last - t->span[0].t;
+    s->scans = 1;
+
+    for (i = 0; i < t->spans; i++) {
+        const JtagSpan *sp = &t->span[i];
+        if (i) {
+            uint64_t d = sp->t - t->span[i - 1].last;
+            while (m + 1 < (long)t->marks && t->mark[m + 1].t <= t->span[i - 1].last) m++;
+            if (d > s->gapThreshold) {
+                s->gaps++; s->scans++; s->gapTicks += d;
+                g.t = t->span[i - 1].last; g.len = d; g.mark = m;
+                AddWorst(s, &g);
+            } else {
+                s->busyTicks += d;
+                p = (double)d;
+                sumP += p; n++;
+                if (!minP || p < minP) minP = p;
+                if (p > maxP) maxP = p;
+                if (sp->count == 1 && sp->high && sp->high < d) { hiSum += sp->high; hiPer += p; }
+            }
+        }
+        if (sp->count > 1) {
+            p = (double)(sp->last - sp->t) / (sp->count - 1);
+            s->busyTicks += sp->last - sp->t;
+            sumP += (double)(sp->last - sp->t); n += sp->count - 1;
+            if (!minP || p < minP) minP = p;
+            if (p > maxP) maxP = p;
+            if (sp->high) { hiSum += sp->high; hiPer += (double)(sp->last - sp->t); }
+        }
+    }
+    if (n && sumP > 0) {
+        s->tckHz = (double)LOG_TICK_HZ * (double)n / sumP;
+        s->maxHz = (double)LOG_TICK_HZ / minP;
+        s->minHz = (double)LOG_TICK_HZ / maxP;
+    }
+    if (hiPer > 0) s->duty = hiSum / hiPer;
+}
+
+static double Ms(uint64_t ticks) { return (double)ticks * 1000.0 / LOG_TICK_HZ; }
+
+void JtagTrace_PrintStats(const JtagTrace *t, const JtagTraceStats *s, FILE *f) {
+    char line[160];
+    LogRecord r;
+    int i;
+
+    fprintf(f, "edges              %" PRIu64 "\n", s->edges);
+    fprintf(f, "events             %zu\n", t->marks);
+    fprintf(f, "session            %.3f ms\n", Ms(s->totalTicks));
+    if (s->tckHz > 0) fprintf(f, "TCK                %.1f kHz (min %.1f, max %.1f)\n", s->tckHz / 1e3, s->minHz / 1e3, s->maxHz / 1e3);
+    else              fprintf(f, "TCK                n/a\n");
+    if (s->duty >= 0) fprintf(f, "duty cycle         %.1f %%\n", s->duty * 100.0);
+    else              fprintf(f, "duty cycle         n/a (TCK not wired to P2.4 / P2.5)\n");
+    fprintf(f, "scans              %" PRIu32 "\n", s->scans);
+    fprintf(f, "gaps > %.1f us     %" PRIu32 ", %.3f ms total (%.1f %% of the session)\n",
+            (double)s->gapThreshold * 1e6 / LOG_TICK_HZ, s->gaps, Ms(s->gapTicks),
+            s->totalTicks ? 100.0 * (double)s->gapTicks / (double)s->totalTicks : 0.0);
+    if (t->lostEdges || t->lostEvents || t->badRecords)
+        fprintf(f, "lost               %" PRIu32 " edges, %" PRIu32 " events, %" PRIu32 " bad records\n",
+                t->lostEdges, t->lostEvents, t->badRecords);
+    for (i = 0; i < s->nWorst; i++) {
+        const JtagGap *g = &s->worst[i];
+        if (g->mark >= 0) {
+            r.id = t->mark[g->mark].id; r.dt = 0; r.arg = t->mark[g->mark].arg;
+            LogText_Format(LOG_SRC_JTAG, &r, line, sizeof(line));
+        } else {
+            strcpy(line, "(session start)");
+        }
+        fprintf(f, "  gap %10.3f ms at %10.3f ms after %s\n", Ms(g->len), Ms(g->t - t->span[0].t), line);
+    }
+}
+
+// --- VCD ---
+typedef struct {
+    uint64_t t;
+    uint32_t high;             // Cycle ending at this edge, 0 = unknown
+    uint8_t  tms, tdi, tdo, state, known, skipBefore;
+} Edge;
+
+typedef struct {
+    const JtagTrace *tr;
+    size_t   si;
+    uint32_t j;
+} EdgeIter;
+
+static int NextEdge(EdgeIter *it, Edge *e) {
+    const JtagSpan *s;
+    if (it->si >= it->tr->spans) return 0;
+    s = &it->tr->span[it->si];
+    memset(e, 0, sizeof(*e));
+    e->tms = s->tms; e->state = s->state;
+    if (s->count == 1) {
+        e->t = s->t; e->high = s->high; e->tdi = s->tdi; e->tdo = s->tdo; e->known = 1;
+        it->si++; it->j = 0;
+        return 1;
+    }
+    e->t = s->t + (s->last - s->t) * it->j / (s->count - 1);
+    e->high = (it->j && s->high) ? s->high / (s->count - 1) : 0;
+    if (s->count > 2 * VCD_KEEP && it->j == s->count - VCD_KEEP) e->skipBefore = 1;
+    it->j++;
+    if (s->count > 2 * VCD_KEEP && it->j == VCD_KEEP) it->j = s->count - VCD_KEEP;
+    if (it->j >= s->count) { it->si++; it->j = 0; }
+    return 1;
+}
+
+static uint64_t Ns(uint64_t ticks) { return ticks * 1000000000ULL / LOG_TICK_HZ; }
+
+typedef struct { FILE *f; uint64_t at; int started; const JtagTrace *tr; size_t mi; } Vcd;
+
+static void At(Vcd *v, uint64_t ticks) {
+    uint64_t ns = Ns(ticks);
+    if (!v->started || ns > v->at) { fprintf(v->f, "#%" PRIu64 "\n", ns); v->at = ns; v->started = 1; }
+}
+
+// Events up to and including time ticks
+static void Marks(Vcd *v, uint64_t ticks) {
+    int b;
+    while (v->mi < v->tr->marks && v->tr->mark[v->mi].t <= ticks) {
+        At(v, v->tr->mark[v->mi].t);
+        fputc('b', v->f);
+        for (b = 7; b >= 0; b--) fputc('0' + ((v->tr->mark[v->mi].id >> b) & 1), v->f);
+        fputs(" &\n", v->f);
+        v->mi++;
+    }
+}
+
+static void Data(Vcd *v, const Edge *e) {
+    int b;
+    fprintf(v->f, "%c\"\n", '0' + e->tms);
+    fprintf(v->f, "%c#\n", e->known ? '0' + e->tdi : 'x');
+    fprintf(v->f, "%c$\n", e->known ? '0' + e->tdo : 'x');
+    fputc('b', v->f);
+    for (b = 3; b >= 0; b--) fputc('0' + ((e->state >> b) & 1), v->f);
+    fputs(" %\n", v->f);
+}
+
+void JtagTrace_WriteVcd(const JtagTrace *t, FILE *f) {
+    EdgeIter it = { t, 0, 0 };
+    Edge e, n;
+    int haveNext;
+    uint64_t half, fall, d;
+    Vcd v;
+
+    memset(&v, 0, sizeof(v));
+    v.f = f; v.tr = t;
+    half = (uint64_t)(MedianPeriod(t) / 2);
+    if (!half) half = 1;
+
+    fputs("$date emulator trace capture $end\n", f);
+    fputs("$timescale 1ns $end\n", f);
+    fputs("$scope module jtag $end\n", f);
+    fputs("$var wire 1 ! tck $end\n", f);
+    fputs("$var wire 1 \" tms $end\n", f);
+    fputs("$var wire 1 # tdi $end\n", f);
+    fputs("$var wire 1 $ tdo $end\n", f);
+    fputs("$var wire 4 % tap_state $end\n", f);
+    fputs("$var wire 8 & event $end\n", f);
+    fputs("$upscope $end\n$enddefinitions $end\n", f);
+
+    if (!NextEdge(&it, &e)) return;
+    At(&v, e.t > half ? e.t - half : 0);
+    fputs("$dumpvars\n0!\n", f);
+    Data(&v, &e);
+    fputs("b00000000 &\n$end\n", f);
+
+    for (;;) {
+        haveNext = NextEdge(&it, &n);
+        Marks(&v, e.t);
+        At(&v, e.t);
+        fputs("1!\n", f);
+
+        // Falling edge: measured when the next cycle carries it, else half a median period
+        d = haveNext ? n.t - e.t : 2 * half;
+        fall = e.t + (haveNext && !n.skipBefore && n.high && n.high < d ? n.high : (half < d / 2 ? half : d / 2));
+        if (fall == e.t) fall++;
+        Marks(&v, fall - 1);
+        At(&v, fall);
+        if (!haveNext) { fputs("0!\n", f); break; }
+        fputs(n.skipBefore ? "x!\n" : "0!\n", f);
+        Data(&v, &n);
+        if (n.skipBefore) {
+            Marks(&v, n.t - 1);
+            At(&v, n.t > half && n.t - half > fall ? n.t - half : fall + 1);
+            fputs("0!\n", f);
+        }
+        e = n;
+    }
+    Marks(&v, UINT64_MAX);
+}
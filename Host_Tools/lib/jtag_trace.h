@@ -0,0 +1,71 @@
+/*
+ * JTAG edge trace from the emulator's capture mode
+ * - Rebuilt from decoded log records: single edges, folded runs, events
+ * - Statistics: achieved TCK frequency and duty cycle inside scans, and the
+ *   gaps between scans with the event that preceded each one
+ * - VCD export for GTKWave; long runs keep their first and last 32 edges
+ *   with TCK shown as x in between
+ */
+
+#ifndef JTAG_TRACE_H
+#define JTAG_TRACE_H
+
+#include "log_decode.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define JTAG_TRACE_WORST 8
+
+typedef struct {
+    uint64_t t, last;          // LOG_TICK_HZ ticks of the first and last rising edge
+    uint32_t count;            // Edges
+    uint32_t high;             // TCK high ticks: edge = cycle ending at it, run = cycles after its first edge; 0 = unknown
+    uint8_t  state, tms, tdi, tdo;   // TDI / TDO are only known for single edges
+} JtagSpan;
+
+typedef struct { uint64_t t; uint8_t id; uint32_t arg; } JtagMark;
+
+typedef struct {
+    JtagSpan *span;
+    size_t    spans, spanCap;
+    JtagMark *mark;            // Emulator events (EventType ids)
+    size_t    marks, markCap;
+    uint64_t  now;
+    uint64_t  edges;
+    JtagSpan  pend;            // RUN waiting for its SPAN
+    int       havePend;
+    uint32_t  lostEdges;       // Last LOG_ID_TRACE_LOST
+    uint32_t  lostEvents;      // Last LOG_ID_DROPPED
+    uint32_t  badRecords;      // SPAN without a RUN, RUN without a SPAN
+    int       traceOn;         // Boot record had LOG_SRC_TRACE
+} JtagTrace;
+
+typedef struct {
+    uint64_t t, len;           // Gap start (last edge before it) and length, ticks
+    long     mark;             // Last event before the gap, -1 if none
+} JtagGap;
+
+typedef struct {
+    uint64_t edges;
+    uint64_t gapThreshold;     // Ticks; a longer edge-to-edge time is a gap
+    double   tckHz, minHz, maxHz;
+    double   duty;             // 0..1, -1 = unknown (TA0 capture pins not wired)
+    uint32_t scans;            // TCK bursts between gaps
+    uint32_t gaps;
+    uint64_t gapTicks, busyTicks, totalTicks;
+    JtagGap  worst[JTAG_TRACE_WORST];
+    int      nWorst;
+} JtagTraceStats;
+
+void JtagTrace_Init(JtagTrace *t);
+void JtagTrace_Free(JtagTrace *t);
+void JtagTrace_Add(JtagTrace *t, const LogRecord *r);
+
+// minGapTicks: lower bound on the gap threshold (default is 8 median periods)
+void JtagTrace_Analyze(const JtagTrace *t, uint64_t minGapTicks, JtagTraceStats *s);
+void JtagTrace_PrintStats(const JtagTrace *t, const JtagTraceStats *s, FILE *f);
+void JtagTrace_WriteVcd(const JtagTrace *t, FILE *f);
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Decoder for the emulators' binary UART log
+ */
+
+#include "log_decode.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void LogDecoder_Init(LogDecoder *d) {
+    memset(d, 0, sizeof(*d));
+}
+
+// 1 = value read (*used bytes), 0 = need more, -1 = longer than 32 bits
+static int Varint(const uint8_t *p, uint8_t len, uint8_t *used, uint32_t *v) {
+    uint8_t i;
+    *v = 0;
+    for (i = 0; i < len; i++) {
+        if (i == 4 && p[i] > 0x0F) return -1;
+        *v |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+        if (!(p[i] & 0x80)) { *used = i + 1; return 1; }
+    }
+    return 0;
+}
+
+// Same return values as Varint, for the record at the start of buf
+static int Parse(const uint8_t *buf, uint8_t len, LogRecord *rec) {
+    uint8_t n = 2, used, chk = 0, i;
+    int r;
+
+    if (len < n) return 0;
+    rec->id = buf[1];
+    if ((r = Varint(buf + n, len - n, &used, &rec->dt)) <= 0) return r;
+    n += used;
+    if ((r = Varint(buf + n, len - n, &used, &rec->arg)) <= 0) return r;
+    n += used;
+    if (len < n + 1) return 0;
+    for (i = 0; i < n; i++) chk ^= buf[i];
+    return chk == buf[n] ? 1 : -1;
+}
+
+// Drops the current sync byte and slides to the next one
+static void Resync(LogDecoder *d) {
+    uint8_t i = 1;
+    while (i < d->len && d->buf[i] != LOG_SYNC) i++;
+    d->skipped += i - 1;
+    memmove(d->buf, d->buf + i, d->len - i);
+    d->len -= i;
+}
+
+int LogDecoder_Push(LogDecoder *d, uint8_t b, LogRecord *rec) {
+    int r;
+
+    if (d->len == 0 && b != LOG_SYNC) { d->skipped++; return 0; }
+    d->buf[d->len++] = b;
+
+    // Bytes kept after a resync may already hold (part of) the next record
+    while (d->len) {
+        r = Parse(d->buf, d->len, rec);
+        if (r == 0) return 0;
+        if (r == 1) { d->len = 0; d->records++; return 1; }
+        d->badRecords++;
+        Resync(d);
+    }
+    return 0;
+}
+
+// --- TEXT (ids as in each emulator's EventType) ---
+static const char *const jtagText[] = {
+    0,
+    "[STATE] JTAG TAP Reset.",
+    "[CMD]   0x11 (READ IDCODE) Latched.",
+    "[CMD]   0x15 (ENABLE CONFIG) Latched.",
+    "[CMD]   0x05 (ERASE SRAM) Latched. Simulating erase...",
+    "[CMD]   0x09 (ERASE DONE) Latched. Status polls during erase: %u",
+    "[CMD]   0x12 (INIT ADDRESS) Latched.",
+    "[CMD]   0x17 (WRITE SRAM) Latched. Waiting for bitstream...",
+    "[CMD]   0x3A (DISABLE CONFIG) Latched.",
+    "[CMD]   0x41 (READ STATUS) Master is Polling... poll #%u",
+    "[WARN]  Unknown Instruction: 0x%02X",
+    "[DATA]  Target Read 32 bits from TDO (IDCODE Sent).",
+    "[PASS]  Bitstream Transmitted! Bits counted: %u",
+    "[FAIL]  Stream too small: %u bits.",
+    "[FAIL]  Protocol violation detected.",
+};
+
+static const char *const sspiText[] = {
+    0,
+    "[CMD] ENABLE (0x15)",
+    "[CMD] ERASE (0x05) - Timer Started",
+    "[CMD] INIT ADDR (0x12)",
+    "[CMD] READ ID (0x11)",
+    "[CMD] READ STATUS (0x41) #%u",
+    "[CMD] WRITE START (0x3B)",
+    "[CMD] WRITE DISABLE (0x3A) after %u bytes",
+    "[???] Unknown Command: 0x%02X",
+    0,                                   // ERR_SEQ, see below
+    "[FAIL] Timing: INIT_ADDR sent %u us after ERASE (4000 us needed)!",
+    "[INFO] Reset Active.",
+    "[PASS] Configuration Loaded. Done Flag Set. Burst bytes: %u",
+    "[WARN] Waiting for Mode Pins (001)... P2 = 0x%02X",
+    "[INFO] Mode Pins OK. Asserting READY.",
+    "[INFO] Reset Released.",
+    "[INFO] Ready Again.",
+};
+
+#define SSPI_ID_ERR_SEQ 9
+
+static const char *const tapName[16] = {
+    "TEST_LOGIC_RESET", "RUN_TEST_IDLE", "SELECT_DR", "CAPTURE_DR", "SHIFT_DR", "EXIT1_DR", "PAUSE_DR", "EXIT2_DR",
+    "UPDATE_DR", "SELECT_IR", "CAPTURE_IR", "SHIFT_IR", "EXIT1_IR", "PAUSE_IR", "EXIT2_IR", "UPDATE_IR"
+};
+
+static const char *const sspiExpected[] = {
+    "ERASE (0x05)", "INIT ADDR (0x12)", "ENABLE (0x15)", "WRITE REQ (0x3B)", "DISABLE (0x3A)"
+};
+
+void LogText_Format(int src, const LogRecord *rec, char *out, size_t n) {
+    const char *const *text = (src == LOG_SRC_SSPI) ? sspiText : jtagText;
+    size_t count = (src == LOG_SRC_SSPI) ? sizeof(sspiText) / sizeof(sspiText[0])
+                                         : sizeof(jtagText) / sizeof(jtagText[0]);
+    uint32_t st, boot = rec->arg & LOG_SRC_MASK;
+
+    if (rec->id == LOG_ID_BOOT) {
+        snprintf(out, n, "%s%s", boot == LOG_SRC_SSPI ? "--- GOWIN EMULATOR (Level 10: Flowchart Compliant) ---"
+                               : boot == LOG_SRC_JTAG ? "--- GOWIN JTAG REFEREE STARTED (PERFECT CLONE) ---"
+                               : "--- UNKNOWN EMULATOR ---",
+                 (rec->arg & LOG_SRC_TRACE) ? " [TRACE CAPTURE]" : "");
+    } else if (rec->id == LOG_ID_TRACE_EDGE) {
+        snprintf(out, n, "[TRACE] TMS=%u TDI=%u TDO=%u in %s", (unsigned)rec->arg & 1, (unsigned)(rec->arg >> 1) & 1,
+                 (unsigned)(rec->arg >> 2) & 1, tapName[(rec->arg >> 3) & 0x0F]);
+    } else if (rec->id == LOG_ID_TRACE_RUN) {
+        snprintf(out, n, "[TRACE] %u edges TMS=%u in %s", (unsigned)(rec->arg >> 5), (unsigned)(rec->arg >> 4) & 1,
+                 tapName[rec->arg & 0x0F]);
+    } else if (rec->id == LOG_ID_TRACE_SPAN) {
+        snprintf(out, n, "[TRACE] ... last edge of the run");
+    } else if (rec->id == LOG_ID_TRACE_LOST) {
+        snprintf(out, n, "[WARN]  Capture ring full, edges lost: %u", (unsigned)rec->arg);
+    } else if (rec->id == LOG_ID_DROPPED) {
+        snprintf(out, n, "[WARN]  Log queue full, events not printed: %u (counts stay exact)", (unsigned)rec->arg);
+    } else if (src == LOG_SRC_SSPI && rec->id == SSPI_ID_ERR_SEQ) {
+        st = rec->arg & 0xFF;
+        snprintf(out, n, "[FAIL] SEQUENCE ERROR! Received: 0x%02X Expected: %s",
+                 (unsigned)(rec->arg >> 8) & 0xFF, st < 5 ? sspiExpected[st] : "Unknown");
+    } else if (rec->id < count && text[rec->id]) {
+        snprintf(out, n, text[rec->id], (unsigned)rec->arg);
+    } else {
+        snprintf(out, n, "[????]  Event 0x%02X arg %u", rec->id, (unsigned)rec->arg);
+    }
+}
@@ -0,0 +1,39 @@
+/*
+ * Decoder for the emulators' binary UART log (log_record.h)
+ * - Streaming: one byte in at a time, a record out when its checksum matches
+ * - Bad checksums and over-long varints drop the sync byte and hunt for the
+ *   next one, so a corrupted or truncated record costs only itself
+ * - Text tables reproduce the messages the emulators used to print
+ */
+
+#ifndef LOG_DECODE_H
+#define LOG_DECODE_H
+
+#include "log_record.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint8_t  id;
+    uint32_t dt;               // LOG_TICK_HZ ticks since the previous record
+    uint32_t arg;
+} LogRecord;
+
+typedef struct {
+    uint8_t  buf[LOG_MAX_RECORD];
+    uint8_t  len;
+    uint32_t records;
+    uint32_t badRecords;       // Checksum or varint errors
+    uint32_t skipped;          // Bytes thrown away while hunting for LOG_SYNC
+} LogDecoder;
+
+void LogDecoder_Init(LogDecoder *d);
+
+// 1 = *rec holds a complete record, 0 = need more bytes
+int  LogDecoder_Push(LogDecoder *d, uint8_t b, LogRecord *rec);
+
+// One line of text for a record; src is LOG_SRC_JTAG or LOG_SRC_SSPI
+void LogText_Format(int src, const LogRecord *rec, char *out, size_t n);
+
+#endif
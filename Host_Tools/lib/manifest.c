@@ -0,0 +1,109 @@
+/*
+ * Programming manifest
+ */
+
+#include "manifest.h"
+#include "boot_cache.h"
+
+#include <string.h>
+
+static const char *const names[] = {
+    "NOT_RUN", "DONE", "BAD_MANIFEST", "NO_DEVICE", "WRONG_IDCODE",
+    "SHORT_DATA", "VERIFY_FAIL", "BAD_FIRMWARE", "START_FAIL"
+};
+
+const char *Manifest_OutcomeName(ManifestOutcome o) {
+    return (unsigned)o < sizeof(names) / sizeof(names[0]) ? names[o] : "?";
+}
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void Put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+size_t Manifest_Size(const ManifestStep *steps, int n) {
+    size_t size = MANIFEST_HEADER_SIZE + (size_t)n * MANIFEST_STEP_SIZE;
+    int i;
+    for (i = 0; i < n; i++) size += steps[i].length;
+    return size;
+}
+
+size_t Manifest_Build(const ManifestStep *steps, int n, uint8_t *out, size_t cap) {
+    size_t size, off;
+    uint32_t data = 0;
+    int i;
+    if (n < 1 || n > MANIFEST_MAX_STEPS) return 0;
+    size = Manifest_Size(steps, n);
+    if (size > cap) return 0;
+    off = MANIFEST_HEADER_SIZE;
+    for (i = 0; i < n; i++, off += MANIFEST_STEP_SIZE) {
+        Put32(out + off, steps[i].kind | (uint32_t)steps[i].arg << 8);
+        Put32(out + off + 4, steps[i].length);
+        Put32(out + off + 8, steps[i].value);
+        Put32(out + off + 12, steps[i].mask);
+        data += steps[i].length;
+    }
+    Put32(out, MANIFEST_MAGIC);
+    Put32(out + 4, (uint32_t)n);
+    Put32(out + 8, data);
+    Put32(out + 12, BootCache_Crc32(out + MANIFEST_HEADER_SIZE, (size_t)n * MANIFEST_STEP_SIZE));
+    for (i = 0; i < n; i++) {
+        if (steps[i].length) memcpy(out + off, steps[i].data, steps[i].length);
+        off += steps[i].length;
+    }
+    return size;
+}
+
+// manifest.Valid
+int Manifest_Parse(const uint8_t *m, size_t len, uint32_t stageSize, uint32_t cacheSize,
+                   ManifestStep steps[MANIFEST_MAX_STEPS]) {
+    uint32_t n, left;
+    int i, loaded = 0;
+    if (len < MANIFEST_HEADER_SIZE || Get32(m) != MANIFEST_MAGIC) return 0;
+    n = Get32(m + 4);
+    left = Get32(m + 8);
+    if (n == 0 || n > MANIFEST_MAX_STEPS || len < MANIFEST_HEADER_SIZE + n * MANIFEST_STEP_SIZE) return 0;
+    if (BootCache_Crc32(m + MANIFEST_HEADER_SIZE, n * MANIFEST_STEP_SIZE) != Get32(m + 12)) return 0;
+
+    for (i = 0; i < (int)n; i++) {
+        const uint8_t *p = m + MANIFEST_HEADER_SIZE + (size_t)i * MANIFEST_STEP_SIZE;
+        ManifestStep *s = &steps[i];
+        uint32_t op = Get32(p);
+        s->kind = (uint8_t)op;
+        s->arg = (uint8_t)(op >> 8);
+        s->length = Get32(p + 4);
+        s->value = Get32(p + 8);
+        s->mask = Get32(p + 12);
+        s->data = NULL;
+        if (s->length > left) return 0;
+        left -= s->length;
+
+        switch (s->kind) {
+        case MF_IDCODE:
+            if (s->length) return 0;
+            break;
+        case MF_SRAM:
+            if (!s->length) return 0;
+            break;
+        case MF_FLASH:
+            if (!s->length || (s->length & 3u) || s->length > cacheSize) return 0;
+            break;
+        case MF_VERIFY:
+            if (s->length || i == 0 || (steps[i - 1].kind != MF_SRAM && steps[i - 1].kind != MF_FLASH)) return 0;
+            break;
+        case MF_LOAD:
+            if (!s->length || (s->length & 3u) || s->length > stageSize || loaded) return 0;
+            loaded = 1;
+            break;
+        case MF_START:
+            if (s->length || !loaded || i != (int)n - 1 || s->arg > MF_START_DEBUG) return 0;
+            break;
+        default:
+            return 0;
+        }
+    }
+    return left == 0 ? (int)n : 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Programming manifest
+ * - Mirror of manifest.ads: a 16-byte header (magic "GWMF", step count,
+ *   data length, CRC-32 of the step table), up to eight 16-byte steps (op
+ *   word with the kind in bits 0..7 and its argument in 8..15, data
+ *   length, value, mask), then the data of each step in step order
+ * - `config` on the board runs the steps on its own once the table checks
+ *   out and answers with one `manifest` line: chain IDCODE, SRAM load,
+ *   boot image into the MCU's flash, verify, executable staged, started
+ * - Manifest_Build writes one from steps whose data the caller holds
+ */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MANIFEST_MAGIC       0x464D5747u   // "GWMF" little-endian
+#define MANIFEST_HEADER_SIZE 16u
+#define MANIFEST_STEP_SIZE   16u
+#define MANIFEST_MAX_STEPS   8
+
+#define MF_IDCODE 1   // Value under Mask against the part at chain position arg (0: the scan's pick)
+#define MF_SRAM   2   // Bitstream bytes, the last one the tail
+#define MF_FLASH  3   // boot_cache image into the boot image area
+#define MF_VERIFY 4   // The step before: DONE and status under Mask, or the boot image's CRC
+#define MF_LOAD   5   // NEORV32 executable into the stage, Value its CRC-32
+#define MF_START  6   // The staged executable up, the last step
+
+#define MF_START_DEFAULT    0   // As Firmware_Load says
+#define MF_START_BOOTLOADER 1
+#define MF_START_DEBUG      2
+
+typedef enum {
+    MF_NOT_RUN,
+    MF_DONE,
+    MF_BAD_MANIFEST,   // Refused before any step ran
+    MF_NO_DEVICE,      // No TAP at the IDCODE step's position
+    MF_WRONG_IDCODE,
+    MF_SHORT_DATA,     // The stream ended inside a step's data
+    MF_VERIFY_FAIL,
+    MF_BAD_FIRMWARE,   // Staged bytes do not match the Load step's CRC
+    MF_START_FAIL
+} ManifestOutcome;
+
+typedef struct {
+    uint8_t        kind;
+    uint8_t        arg;
+    uint32_t       length;   // Data bytes
+    uint32_t       value;
+    uint32_t       mask;
+    const uint8_t *data;     // Manifest_Build: length bytes; NULL from Manifest_Parse
+} ManifestStep;
+
+const char *Manifest_OutcomeName(ManifestOutcome o);
+
+// Bytes Manifest_Build writes: header, table and every step's data
+size_t Manifest_Size(const ManifestStep *steps, int n);
+// Returns the manifest size, or 0 if n is not 1..8 or it does not fit in
+// `cap`. The steps go in as given: Manifest_Parse says if the board takes them
+size_t Manifest_Build(const ManifestStep *steps, int n, uint8_t *out, size_t cap);
+
+// manifest.Valid on the header and table at `m` (len bytes of it there):
+// the step count, and steps[] filled, or 0 if the board would refuse it
+int    Manifest_Parse(const uint8_t *m, size_t len, uint32_t stageSize, uint32_t cacheSize,
+                      ManifestStep steps[MANIFEST_MAX_STEPS]);
+
+#endif
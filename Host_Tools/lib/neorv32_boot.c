@@ -0,0 +1,147 @@
+/*
+ * NEORV32 bootloader driver
+ */
+
+#include "neorv32_boot.h"
+
+#include <string.h>
+#include <time.h>
+
+static const char *const names[] = {
+    "BOOTED", "BAD_SIGNATURE", "BAD_SIZE", "NO_PROMPT", "SHORT_IMAGE", "BAD_CHECKSUM", "REJECTED", "SKIPPED"
+};
+
+const char *Neorv32_ResultName(Neorv32Result r) {
+    return (unsigned)r < sizeof(names) / sizeof(names[0]) ? names[r] : "?";
+}
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void Neorv32_ParseHeader(const uint8_t hdr[NEORV32_HEADER_SIZE], Neorv32Header *h) {
+    h->signature = Get32(hdr);
+    h->size = Get32(hdr + 4);
+    h->checksum = Get32(hdr + 8);
+}
+
+Neorv32Result Neorv32_Check(const Neorv32Header *h) {
+    if (h->signature != NEORV32_SIGNATURE) return NEORV32_BAD_SIGNATURE;
+    if (h->size == 0 || h->size % 4 || h->size > NEORV32_MAX_SIZE) return NEORV32_BAD_SIZE;
+    return NEORV32_BOOTED;
+}
+
+void Neorv32Sum_Add(Neorv32Sum *s, uint8_t b) {
+    s->word |= (uint32_t)b << (8 * s->count);
+    if (++s->count == 4) {
+        s->sum += s->word;
+        s->word = 0;
+        s->count = 0;
+    }
+}
+
+int Neorv32Sum_Ok(const Neorv32Sum *s, const Neorv32Header *h) {
+    return s->count == 0 && (uint32_t)(s->sum + h->checksum) == 0;
+}
+
+int Neorv32Match_Feed(Neorv32Match *m, const char *pattern, uint8_t c) {
+    size_t len = strlen(pattern);
+    if (len == 0) return 0;
+    if ((uint8_t)pattern[m->pos] == c) m->pos++;
+    else m->pos = (uint8_t)pattern[0] == c;
+    if (m->pos == len) { m->pos = 0; return 1; }
+    return 0;
+}
+
+// --- DRIVER (Send_Firmware) ---
+typedef enum { MATCHED, FAILED, TIMED_OUT } Reply;
+
+static double Now_Us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static Reply Expect(const Neorv32Link *l, const char *pattern, const char *fail, int withinMs) {
+    double deadline = Now_Us() + withinMs * 1000.0;
+    Neorv32Match m = { 0 }, f = { 0 };
+    uint8_t c;
+    for (;;) {
+        int left = (int)((deadline - Now_Us()) / 1000.0);
+        // A 0 from targetRead means the time it was given ran out
+        if (left <= 0 || !l->targetRead(l->ctx, &c, left)) return TIMED_OUT;
+        if (l->console) l->console(l->ctx, c);
+        if (Neorv32Match_Feed(&m, pattern, c)) return MATCHED;
+        if (Neorv32Match_Feed(&f, fail, c)) return FAILED;
+    }
+}
+
+static void Put(const Neorv32Link *l, char key) {
+    uint8_t b = (uint8_t)key;
+    l->targetWrite(l->ctx, &b, 1);
+}
+
+static Neorv32Result Finish(Neorv32Report *r, Neorv32Result res) {
+    r->result = res;
+    return res;
+}
+
+Neorv32Result Neorv32_Upload(const Neorv32Link *l, Neorv32Report *r) {
+    uint8_t hdr[NEORV32_HEADER_SIZE], buf[512];
+    Neorv32Header h;
+    Neorv32Sum sum = { 0, 0, 0 };
+    Neorv32Result check;
+    size_t got = 0, total, i;
+    double t;
+    int ok = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->result = NEORV32_SKIPPED;
+
+    // The header first: nothing reaches the bootloader unless it is a NEORV32 executable
+    while (got < NEORV32_HEADER_SIZE) {
+        size_t n = l->hostRead(l->ctx, hdr + got, NEORV32_HEADER_SIZE - got, got ? NEORV32_QUIET_MS : NEORV32_HEADER_MS);
+        if (n == 0) return Finish(r, NEORV32_SHORT_IMAGE);
+        got += n;
+    }
+    Neorv32_ParseHeader(hdr, &h);
+    if ((check = Neorv32_Check(&h)) != NEORV32_BOOTED) return Finish(r, check);
+    total = NEORV32_HEADER_SIZE + h.size;
+
+    // The countdown may not have started yet: ask again a few times
+    t = Now_Us();
+    while (!ok && r->hTries < NEORV32_TRIES) {
+        Put(l, 'h');
+        r->hTries++;
+        ok = Expect(l, NEORV32_PROMPT, "", NEORV32_REPLY_MS) == MATCHED;
+    }
+    if (!ok) return Finish(r, NEORV32_NO_PROMPT);
+    Put(l, 'u');
+    if (Expect(l, NEORV32_AWAITING, "", NEORV32_REPLY_MS) != MATCHED) return Finish(r, NEORV32_NO_PROMPT);
+    r->handshakeUs = Now_Us() - t;
+
+    // Exactly the executable, counted: no silence timeout at the end
+    t = Now_Us();
+    l->targetWrite(l->ctx, hdr, NEORV32_HEADER_SIZE);
+    r->bytes = NEORV32_HEADER_SIZE;
+    while (r->bytes < total) {
+        size_t want = total - r->bytes < sizeof(buf) ? total - r->bytes : sizeof(buf);
+        size_t n = l->hostRead(l->ctx, buf, want, NEORV32_QUIET_MS);
+        if (n == 0) return Finish(r, NEORV32_SHORT_IMAGE);
+        l->targetWrite(l->ctx, buf, n);
+        for (i = 0; i < n; i++) Neorv32Sum_Add(&sum, buf[i]);
+        r->bytes += (uint32_t)n;
+    }
+
+    // The bootloader checks the sum too; ours says which error it was
+    if (Expect(l, NEORV32_ACK, NEORV32_ERROR, NEORV32_REPLY_MS) != MATCHED)
+        return Finish(r, Neorv32Sum_Ok(&sum, &h) ? NEORV32_REJECTED : NEORV32_BAD_CHECKSUM);
+    r->uploadUs = Now_Us() - t;
+
+    t = Now_Us();
+    if (Expect(l, NEORV32_PROMPT, "", NEORV32_REPLY_MS) != MATCHED) return Finish(r, NEORV32_NO_PROMPT);
+    Put(l, 'e');
+    if (Expect(l, NEORV32_BOOTING, "", NEORV32_REPLY_MS) != MATCHED) return Finish(r, NEORV32_NO_PROMPT);
+    r->bootUs = Now_Us() - t;
+    return Finish(r, NEORV32_BOOTED);
+}
@@ -0,0 +1,89 @@
+/*
+ * NEORV32 bootloader driver
+ * - Mirror of neorv32_boot.ads and of Send_Firmware in mcu_to_fpga.adb:
+ *   executable header check, image word sum, prompt matcher
+ * - Neorv32_Upload runs the firmware's sequence over a link of callbacks:
+ *   header from the host, 'h' until "CMD:> ", 'u' until "bin... ", exactly
+ *   Size bytes, "OK" (or "ERR"), "CMD:> ", 'e' until "Booting"
+ */
+
+#ifndef NEORV32_BOOT_H
+#define NEORV32_BOOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NEORV32_SIGNATURE   0x4788CAFEu
+#define NEORV32_HEADER_SIZE 12u
+#define NEORV32_MAX_SIZE    0x10000u
+
+#define NEORV32_PROMPT   "CMD:> "
+#define NEORV32_AWAITING "bin... "
+#define NEORV32_ACK      "OK"
+#define NEORV32_ERROR    "ERR"
+#define NEORV32_BOOTING  "Booting"
+
+#define NEORV32_REPLY_MS  250    // Per prompt
+#define NEORV32_TRIES     8      // 'h' sent this often before NO_PROMPT
+#define NEORV32_QUIET_MS  1000   // Host silence that cuts an image short
+#define NEORV32_HEADER_MS 10000  // First byte; host side only, the firmware waits for ever
+
+typedef enum {
+    NEORV32_BOOTED,
+    NEORV32_BAD_SIGNATURE,
+    NEORV32_BAD_SIZE,
+    NEORV32_NO_PROMPT,
+    NEORV32_SHORT_IMAGE,
+    NEORV32_BAD_CHECKSUM,
+    NEORV32_REJECTED,
+    NEORV32_SKIPPED
+} Neorv32Result;
+
+typedef struct {
+    uint32_t signature;
+    uint32_t size;
+    uint32_t checksum;
+} Neorv32Header;
+
+typedef struct {
+    uint32_t sum;
+    uint32_t word;
+    int      count;
+} Neorv32Sum;
+
+typedef struct {
+    size_t pos;
+} Neorv32Match;
+
+typedef struct {
+    // Host bytes into buf: count, 0 on timeout
+    size_t (*hostRead)(void *ctx, uint8_t *buf, size_t max, int timeoutMs);
+    // One bootloader byte: 1, or 0 once timeoutMs has run out
+    int    (*targetRead)(void *ctx, uint8_t *c, int timeoutMs);
+    void   (*targetWrite)(void *ctx, const uint8_t *buf, size_t n);
+    void   (*console)(void *ctx, uint8_t c);   // Optional: bootloader text on to the host
+    void   *ctx;
+} Neorv32Link;
+
+typedef struct {
+    Neorv32Result result;
+    uint32_t      bytes;         // Image bytes forwarded, header included
+    uint32_t      hTries;        // 'h' keys sent
+    double        handshakeUs;   // First 'h' to "Awaiting ..."
+    double        uploadUs;      // First image byte to OK
+    double        bootUs;        // OK to "Booting"
+} Neorv32Report;
+
+const char   *Neorv32_ResultName(Neorv32Result r);
+
+void          Neorv32_ParseHeader(const uint8_t hdr[NEORV32_HEADER_SIZE], Neorv32Header *h);
+Neorv32Result Neorv32_Check(const Neorv32Header *h);   // NEORV32_BOOTED: fit to send
+
+void          Neorv32Sum_Add(Neorv32Sum *s, uint8_t b);
+int           Neorv32Sum_Ok(const Neorv32Sum *s, const Neorv32Header *h);
+
+int           Neorv32Match_Feed(Neorv32Match *m, const char *pattern, uint8_t c);   // 1 on a hit
+
+Neorv32Result Neorv32_Upload(const Neorv32Link *l, Neorv32Report *r);
+
+#endif
@@ -0,0 +1,306 @@
+/*
+ * Programming daemon: designs and ports kept warm between runs
+ */
+
+#include "prog_daemon.h"
+#include "pty_link.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_WORDS (STATION_MAX_PORTS + 2)
+
+static double Now_Ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static int Address(const char *path, struct sockaddr_un *a) {
+    memset(a, 0, sizeof(*a));
+    a->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(a->sun_path)) { errno = ENAMETOOLONG; return -1; }
+    strcpy(a->sun_path, path);
+    return 0;
+}
+
+int ProgDaemon_Open(ProgDaemon *d, const char *socketPath, const char *cacheDir, uint32_t chunk, uint32_t baud) {
+    struct sockaddr_un a;
+    memset(d, 0, sizeof(*d));
+    d->listenFd = -1;
+    d->baud = baud;
+    d->configMs = STATION_CONFIG_MS;
+    if (Address(socketPath, &a) < 0) return -1;
+    strcpy(d->socketPath, socketPath);
+    if (DesignCache_Open(&d->cache, cacheDir, chunk) < 0) return -1;
+    if ((d->listenFd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return -1;
+    // A socket left by a daemon that died; one still listening answers
+    // connect and is left alone
+    if (ProgDaemon_Request(socketPath, "", NULL, 0) < 0) unlink(socketPath);
+    if (bind(d->listenFd, (struct sockaddr *)&a, sizeof(a)) < 0 || chmod(socketPath, 0600) < 0 ||
+        listen(d->listenFd, 4) < 0) {
+        int e = errno;
+        close(d->listenFd);
+        d->listenFd = -1;
+        DesignCache_Close(&d->cache);
+        errno = e;
+        return -1;
+    }
+    return 0;
+}
+
+void ProgDaemon_Close(ProgDaemon *d) {
+    int i;
+    for (i = 0; i < d->ports; i++) close(d->port[i].fd);
+    d->ports = 0;
+    if (d->listenFd >= 0) {
+        close(d->listenFd);
+        unlink(d->socketPath);
+    }
+    d->listenFd = -1;
+    DesignCache_Close(&d->cache);
+}
+
+// --- PORTS ---
+static ProgPort *Port(ProgDaemon *d, const char *path, int open) {
+    ProgPort *p;
+    int i, fd;
+    for (i = 0; i < d->ports; i++)
+        if (strcmp(d->port[i].path, path) == 0) return &d->port[i];
+    if (!open || d->ports == STATION_MAX_PORTS || strlen(path) >= sizeof(p->path)) return NULL;
+    if ((fd = PtyLink_OpenPort(path)) < 0) return NULL;
+    if (d->baud && PtyLink_SetBaud(fd, d->baud) < 0) { close(fd); return NULL; }
+    p = &d->port[d->ports++];
+    strcpy(p->path, path);
+    p->fd = fd;
+    p->runs = 0;
+    d->opened++;
+    return p;
+}
+
+static void Drop(ProgDaemon *d, ProgPort *p) {
+    close(p->fd);
+    *p = d->port[--d->ports];
+}
+
+// --- REQUESTS ---
+static void Add(ProgDaemon *d, FILE *out, char **w, int n) {
+    double t0 = Now_Ms();
+    int built;
+    const Design *g;
+    if (n < 2 || n > 3) { fprintf(out, "error usage: add <bits> [fw]\n"); return; }
+    if (!(g = DesignCache_Add(&d->cache, w[1], n == 3 ? w[2] : NULL, &built))) {
+        fprintf(out, "error %s\n", d->cache.error);
+        return;
+    }
+    fprintf(out, "ok %s %s %.0f\n", g->id, built ? "built" : "cached", (Now_Ms() - t0) * 1000.0);
+}
+
+static void Program(ProgDaemon *d, FILE *out, char **w, int n) {
+    double t0 = Now_Ms(), prep;
+    const Design *g;
+    Station *st;
+    int i, built;
+    if (n < 3) { fprintf(out, "error usage: program <id|bits> <port> ...\n"); return; }
+    g = strchr(w[1], '/') ? DesignCache_Add(&d->cache, w[1], NULL, &built) : DesignCache_Find(&d->cache, w[1]);
+    if (!g) { fprintf(out, "error %s\n", d->cache.error); return; }
+    if (!(st = malloc(sizeof(*st)))) { fprintf(out, "error out of memory\n"); return; }
+    if (Station_Init(st, g->data, g->len, d->cache.chunk, 0) < 0) {
+        free(st);
+        fprintf(out, "error %s\n", strerror(errno));
+        return;
+    }
+    st->configMs = d->configMs;
+    if (g->session) {
+        st->image = g->session;
+        st->imageLen = g->sessionLen;
+    } else {
+        st->framed = g->frames;
+    }
+    prep = Now_Ms() - t0;
+    for (i = 2; i < n; i++) {
+        ProgPort *p;
+        int k;
+        for (k = 2; k < i && strcmp(w[k], w[i]) != 0; k++) {}
+        if (k < i) continue;   // Named twice, programmed once
+        // One that cannot be opened is listed, failed, as Station_Add does
+        if ((p = Port(d, w[i], 1))) p->runs++;
+        Station_Attach(st, w[i], p ? p->fd : -1);
+    }
+    Station_Run(st);
+    for (i = 0; i < st->count; i++) {
+        const StationPort *p = &st->port[i];
+        ProgPort *pp = Port(d, p->path, 0);
+        fprintf(out, "%s %s %.0f %s\n", p->path, Station_StateName(p->state),
+                p->state == PORT_DONE ? p->doneMs - p->uploadMs : 0.0, p->state == PORT_FAIL ? p->why : p->report);
+        // A port that went away is opened afresh next time
+        if (pp && p->state == PORT_FAIL &&
+            (strcmp(p->why, "port closed") == 0 || strcmp(p->why, "write failed") == 0 ||
+             strcmp(p->why, "cannot write") == 0))
+            Drop(d, pp);
+    }
+    fprintf(out, "ok %d/%d prep_us %.0f wall_ms %.0f\n", st->done, st->count, prep * 1000.0, st->wallMs);
+    Station_Free(st);
+    free(st);
+}
+
+static void Request(ProgDaemon *d, FILE *out, char *line) {
+    char *w[MAX_WORDS], *save = NULL, *t = strtok_r(line, " \t\r\n", &save);
+    int n = 0, i;
+    for (; t && n < MAX_WORDS; t = strtok_r(NULL, " \t\r\n", &save)) w[n++] = t;
+    if (n == 0) return;
+    if (strcmp(w[0], "add") == 0) {
+        Add(d, out, w, n);
+    } else if (strcmp(w[0], "program") == 0) {
+        Program(d, out, w, n);
+    } else if (strcmp(w[0], "list") == 0) {
+        static char ids[256][DESIGN_ID_SIZE];
+        int k = DesignCache_List(&d->cache, ids, 256);
+        for (i = 0; i < k; i++) fprintf(out, "%s\n", ids[i]);
+        fprintf(out, "ok %d\n", k);
+    } else if (strcmp(w[0], "ports") == 0) {
+        for (i = 0; i < d->ports; i++) fprintf(out, "%s runs %u\n", d->port[i].path, d->port[i].runs);
+        fprintf(out, "ok %d opened %u\n", d->ports, d->opened);
+    } else if (strcmp(w[0], "stats") == 0) {
+        fprintf(out, "ok hits %u loads %u builds %u hashed %u\n", d->cache.hits, d->cache.loads, d->cache.builds,
+                d->cache.hashed);
+    } else if (strcmp(w[0], "close") == 0 && n == 2) {
+        ProgPort *p = Port(d, w[1], 0);
+        if (p) Drop(d, p);
+        fprintf(out, p ? "ok\n" : "error not open\n");
+    } else if (strcmp(w[0], "shutdown") == 0) {
+        d->stop = 1;
+        fprintf(out, "ok\n");
+    } else {
+        fprintf(out, "error unknown command %s\n", w[0]);
+    }
+}
+
+// --- CONNECTIONS ---
+typedef struct {
+    int    fd;                    // -1: slot free
+    size_t len;                   // Bytes of an unfinished line in buf
+    char   buf[4096];
+} ProgClient;
+
+static void Hang_Up(int epfd, ProgClient *c) {
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+}
+
+static void Accept(ProgDaemon *d, int epfd, ProgClient *c) {
+    struct epoll_event ev;
+    int fd = accept(d->listenFd, NULL, NULL), i;
+    if (fd < 0) return;
+    for (i = 0; i < PROG_DAEMON_CLIENTS && c[i].fd >= 0; i++) {}
+    if (i == PROG_DAEMON_CLIENTS) {
+        static const char busy[] = "error busy\n";
+        if (write(fd, busy, sizeof(busy) - 1) < 0) {}
+        close(fd);
+        return;
+    }
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)i;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) { close(fd); return; }
+    c[i].fd = fd;
+    c[i].len = 0;
+}
+
+// What arrived, and a reply to each whole line; a client that sends
+// nothing costs its slot, not the others' requests
+static void Receive(ProgDaemon *d, int epfd, ProgClient *c) {
+    ssize_t got = read(c->fd, c->buf + c->len, sizeof(c->buf) - 1 - c->len);
+    size_t start = 0;
+    char *nl;
+    FILE *out;
+    if (got < 0 && errno == EINTR) return;
+    if (got > 0) c->len += (size_t)got;
+    c->buf[c->len] = 0;
+    if (got <= 0 && c->len) c->buf[c->len++] = '\n';   // The last line unended
+    if (memchr(c->buf, '\n', c->len) && (out = fdopen(dup(c->fd), "w"))) {
+        while (!d->stop && (nl = memchr(c->buf + start, '\n', c->len - start))) {
+            *nl = 0;
+            Request(d, out, c->buf + start);
+            fflush(out);
+            start = (size_t)(nl + 1 - c->buf);
+        }
+        fclose(out);
+    }
+    memmove(c->buf, c->buf + start, c->len - start);
+    c->len -= start;
+    if (c->len == sizeof(c->buf) - 1) c->len = 0;   // A line longer than the buffer is dropped
+    if (got <= 0) Hang_Up(epfd, c);
+}
+
+int ProgDaemon_Serve(ProgDaemon *d) {
+    static ProgClient c[PROG_DAEMON_CLIENTS];
+    struct epoll_event ev[PROG_DAEMON_CLIENTS + 1];
+    int epfd, i, n, err = 0;
+    // A client that hangs up mid-reply costs the reply, not the daemon
+    signal(SIGPIPE, SIG_IGN);
+    if ((epfd = epoll_create1(0)) < 0) return -1;
+    ev[0].events = EPOLLIN;
+    ev[0].data.u32 = PROG_DAEMON_CLIENTS;
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, d->listenFd, &ev[0]) < 0) { close(epfd); return -1; }
+    for (i = 0; i < PROG_DAEMON_CLIENTS; i++) c[i].fd = -1;
+    while (!d->stop) {
+        if ((n = epoll_wait(epfd, ev, PROG_DAEMON_CLIENTS + 1, -1)) < 0) {
+            if (errno == EINTR) continue;
+            err = -1;
+            break;
+        }
+        for (i = 0; i < n && !d->stop; i++) {
+            uint32_t k = ev[i].data.u32;
+            if (k == PROG_DAEMON_CLIENTS) Accept(d, epfd, c);
+            else if (c[k].fd >= 0) Receive(d, epfd, &c[k]);
+        }
+    }
+    for (i = 0; i < PROG_DAEMON_CLIENTS; i++)
+        if (c[i].fd >= 0) Hang_Up(epfd, &c[i]);
+    close(epfd);
+    return err;
+}
+
+int ProgDaemon_Request(const char *socketPath, const char *request, char *reply, size_t cap) {
+    struct sockaddr_un a;
+    char buf[4096];
+    size_t len = 0, start = 0;
+    int fd, status = -1;
+    if (Address(socketPath, &a) < 0 || (fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) return -1;
+    if (connect(fd, (struct sockaddr *)&a, sizeof(a)) < 0) { close(fd); return -1; }
+    if (!*request) { close(fd); return 0; }
+    if (write(fd, request, strlen(request)) < 0 || write(fd, "\n", 1) < 0) { close(fd); return -1; }
+    if (reply && cap) *reply = 0;
+    // Lines until the one that ends the reply
+    while (status < 0) {
+        ssize_t got = read(fd, buf + len, sizeof(buf) - 1 - len);
+        char *nl;
+        if (got <= 0) break;
+        len += (size_t)got;
+        buf[len] = 0;
+        while ((nl = strchr(buf + start, '\n'))) {
+            size_t k = (size_t)(nl + 1 - (buf + start));
+            if (reply && strlen(reply) + k < cap) strncat(reply, buf + start, k);
+            if (strncmp(buf + start, "ok", 2) == 0) status = 0;
+            else if (strncmp(buf + start, "error", 5) == 0) status = 1;
+            start += k;
+            if (status >= 0) break;
+        }
+        memmove(buf, buf + start, len - start);
+        len -= start;
+        start = 0;
+        if (len == sizeof(buf) - 1) len = 0;   // A line longer than the buffer is dropped
+    }
+    close(fd);
+    return status;
+}
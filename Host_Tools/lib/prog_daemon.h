@@ -0,0 +1,66 @@
+/*
+ * Programming daemon: designs and ports kept warm between runs
+ * - Listens on a Unix socket; a request is one line, the reply is any
+ *   number of lines and then one starting "ok" or "error"
+ *     add <bits> [fw]                -> ok <id> built|cached <us>
+ *     program <id|bits> <port> ...   -> <port> <state> <ms> <why|report>
+ *                                       per port, then ok <done>/<ports>
+ *                                       prep_us <us> wall_ms <ms>
+ *     list                           -> <id> per design, ok <n>
+ *     ports                          -> <port> runs <n> per port, ok <n>
+ *     stats                          -> ok hits .. loads .. builds .. hashed ..
+ *     close <port>, shutdown         -> ok
+ * - Every design goes through lib/design_cache.h, so a design programmed
+ *   before is found mapped, its frames (or session image) already built:
+ *   prep_us is the lookup and the first frame goes out at once
+ * - Ports are opened once, set to the baud once, and handed to the
+ *   station open on every run; one that goes away is closed and opened
+ *   again next time
+ * - Up to PROG_DAEMON_CLIENTS connections at once, polled with the
+ *   listener: one left open and idle does not hold up the others. A
+ *   request runs to its reply before the next is read; the station
+ *   programs a request's ports together
+ */
+
+#ifndef PROG_DAEMON_H
+#define PROG_DAEMON_H
+
+#include "design_cache.h"
+#include "station.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROG_DAEMON_SOCKET  "/tmp/fpga-progd.sock"
+#define PROG_DAEMON_CLIENTS 8
+
+typedef struct {
+    char     path[64];
+    int      fd;
+    uint32_t runs;
+} ProgPort;
+
+typedef struct {
+    DesignCache cache;
+    uint32_t    baud;             // 0: leave the ports as they are
+    double      configMs;         // Handed to the station
+    char        socketPath[108];
+    int         listenFd;
+    ProgPort    port[STATION_MAX_PORTS];
+    int         ports;
+    uint32_t    opened;           // Port opens since the start
+    int         stop;
+} ProgDaemon;
+
+// The cache opened and the socket bound (a stale one replaced); 0, or -1
+// with errno set
+int  ProgDaemon_Open(ProgDaemon *d, const char *socketPath, const char *cacheDir, uint32_t chunk, uint32_t baud);
+// Requests until `shutdown`
+int  ProgDaemon_Serve(ProgDaemon *d);
+void ProgDaemon_Close(ProgDaemon *d);
+
+// Client: one request, the reply lines into reply (cut at cap). 0 if it
+// ended "ok", 1 if "error", -1 if the daemon could not be reached
+int  ProgDaemon_Request(const char *socketPath, const char *request, char *reply, size_t cap);
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * Receive ring pool layout
+ */
+
+#include "ring_layout.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+void RingConfig_Defaults(RingConfig *c) {
+    c->ramSize = 16384;     // STM32F070RB
+    c->ramReserved = 8192;
+    c->windowSize = 0;
+}
+
+int RingConfig_Set(RingConfig *c, const char *name, const char *value) {
+    char *end;
+    unsigned long v = strtoul(value, &end, 0);
+    uint32_t *dst;
+
+    if (strcmp(name, "Ram_Size") == 0) dst = &c->ramSize;
+    else if (strcmp(name, "Ram_Reserved") == 0) dst = &c->ramReserved;
+    else if (strcmp(name, "Window_Size") == 0) dst = &c->windowSize;
+    else return 0;
+    while (isspace((unsigned char)*end)) end++;
+    if (end == value || (*end && *end != '#') || v > 65536) return -1;
+    *dst = (uint32_t)v;
+    return 1;
+}
+
+// "Name = { ... default = N }" or "jtag_test.Name = N"
+static int Toml_Line(RingConfig *c, char *line, int inVariables, int inValues) {
+    char *eq = strchr(line, '='), *name = line, *value, *end;
+    if (!eq) return 0;
+    *eq = '\0';
+    while (isspace((unsigned char)*name)) name++;
+    end = eq;
+    while (end > name && isspace((unsigned char)end[-1])) *--end = '\0';
+    value = eq + 1;
+
+    if (inVariables) {
+        value = strstr(value, "default");
+        if (!value || !(value = strchr(value, '='))) return 0;
+        value++;
+        while (isspace((unsigned char)*value)) value++;
+        end = value;
+        while (isdigit((unsigned char)*end)) end++;
+        *end = '\0';
+        return RingConfig_Set(c, name, value);
+    }
+    if (inValues && strncmp(name, "jtag_test.", 10) == 0) {
+        while (isspace((unsigned char)*value)) value++;
+        return RingConfig_Set(c, name + 10, value);
+    }
+    return 0;
+}
+
+int RingConfig_ParseToml(RingConfig *c, FILE *f) {
+    char line[256];
+    int inVariables = 0, inValues = 0, taken = 0, r;
+    while (fgets(line, sizeof(line), f)) {
+        char *s = line;
+        while (isspace((unsigned char)*s)) s++;
+        if (*s == '#' || *s == '\0') continue;
+        if (*s == '[') {
+            inVariables = strncmp(s, "[configuration.variables]", 25) == 0;
+            inValues = strncmp(s, "[configuration.values]", 22) == 0;
+            continue;
+        }
+        r = Toml_Line(c, s, inVariables, inValues);
+        if (r < 0) return -1;
+        taken += r;
+    }
+    return taken;
+}
+
+static uint32_t Floor_Pow2(uint32_t n) {
+    uint32_t p = RING_MAX;
+    while (p > RING_MIN && p > n) p >>= 1;
+    return p;
+}
+
+int RingLayout_Compute(const RingConfig *c, RingLayout *l) {
+    int64_t room;
+    memset(l, 0, sizeof(*l));
+    l->poolSize = c->ramSize > c->ramReserved ? c->ramSize - c->ramReserved : 0;
+    l->windowSize = c->windowSize;
+    room = (int64_t)l->poolSize - c->windowSize - RING_MIN;
+    if (room < RING_MIN) return -1;
+    l->usart2Size = Floor_Pow2((uint32_t)room);
+    room = (int64_t)l->poolSize - c->windowSize - l->usart2Size;
+    if (room > l->usart2Size) room = l->usart2Size;
+    l->usart1Size = Floor_Pow2((uint32_t)room);
+    l->usart2Offset = 0;
+    l->usart1Offset = l->usart2Offset + l->usart2Size;
+    l->windowOffset = l->usart1Offset + l->usart1Size;
+    l->poolUsed = l->windowOffset + l->windowSize;
+    return 0;
+}
+
+void RingLayout_Print(const RingLayout *l, FILE *f) {
+    static const uint32_t Bauds[] = { 115200, 921600, 2000000, 3000000 };
+    size_t i;
+
+    fprintf(f, "pool %u bytes, %u used, %u spare\n", l->poolSize, l->poolUsed, l->poolSize - l->poolUsed);
+    fprintf(f, "%-24s %8s %8s\n", "region", "offset", "size");
+    fprintf(f, "%-24s %8u %8u\n", "USART2 RX (DMA_Buffer)", l->usart2Offset, l->usart2Size);
+    fprintf(f, "%-24s %8u %8u\n", "USART1 RX (DMA1_Buffer)", l->usart1Offset, l->usart1Size);
+    fprintf(f, "%-24s %8u %8u\n", "window", l->windowOffset, l->windowSize);
+    fprintf(f, "USART2 stall absorbed:");
+    for (i = 0; i < sizeof(Bauds) / sizeof(Bauds[0]); i++)
+        fprintf(f, "  %.2f ms @ %u", (double)l->usart2Size * 10.0 * 1000.0 / Bauds[i], Bauds[i]);
+    fputc('\n', f);
+}
@@ -0,0 +1,48 @@
+/*
+ * Receive ring pool layout
+ * - Mirror of ring_layout.ads: the SRAM not reserved for the runtime,
+ *   task stacks and other globals is split between the decompression
+ *   window (exact size), USART2 RX and USART1 RX (powers of two)
+ * - Inputs are the [configuration.variables] defaults in alire.toml,
+ *   overridden by jtag_test.<Name> entries in [configuration.values]
+ */
+
+#ifndef RING_LAYOUT_H
+#define RING_LAYOUT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define RING_MIN  256u
+#define RING_MAX  32768u   // CNDTR is 16 bits
+
+typedef struct {
+    uint32_t ramSize;
+    uint32_t ramReserved;
+    uint32_t windowSize;
+} RingConfig;
+
+typedef struct {
+    uint32_t poolSize;
+    uint32_t usart2Size;
+    uint32_t usart1Size;
+    uint32_t windowSize;
+    uint32_t usart2Offset;
+    uint32_t usart1Offset;
+    uint32_t windowOffset;
+    uint32_t poolUsed;
+} RingLayout;
+
+void RingConfig_Defaults(RingConfig *c);
+
+// Applies one "Name = value" setting; 0 = not a layout name, -1 = bad value
+int  RingConfig_Set(RingConfig *c, const char *name, const char *value);
+
+// alire.toml; returns the number of settings taken, -1 on a bad value
+int  RingConfig_ParseToml(RingConfig *c, FILE *f);
+
+// -1 where the firmware build would stop on Compile_Time_Error
+int  RingLayout_Compute(const RingConfig *c, RingLayout *l);
+void RingLayout_Print(const RingLayout *l, FILE *f);
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * DMA ring monitor
+ */
+
+#include "ring_monitor.h"
+
+#include <string.h>
+
+void RingMonitor_Reset(RingMonitor *r, uint32_t size, uint32_t readIdx, uint32_t writeIdx) {
+    memset(r, 0, sizeof(*r));
+    r->size = size;
+    r->lastWrite = writeIdx;
+    r->produced = (writeIdx + size - readIdx) % size;
+    r->highWater = r->produced;
+}
+
+void RingMonitor_Produce(RingMonitor *r, uint32_t writeIdx, int half, int full) {
+    uint32_t halfIdx = r->size / 2;
+    uint32_t delta = (writeIdx + r->size - r->lastWrite) % r->size;
+    uint32_t reach = r->lastWrite + delta;
+    int crossedHalf = (r->lastWrite < halfIdx && reach >= halfIdx) || reach >= r->size + halfIdx;
+    int crossedFull = reach >= r->size;
+    int lapped = 0;
+    uint32_t backlog;
+
+    // A crossing can show in the index one poll before its flag
+    if (half && !crossedHalf && !r->pendingHalf) lapped = 1;
+    if (full && !crossedFull && !r->pendingFull) lapped = 1;
+    if (half) r->pendingHalf = 0; else if (crossedHalf) r->pendingHalf = 1;
+    if (full) r->pendingFull = 0; else if (crossedFull) r->pendingFull = 1;
+
+    if (lapped) delta += r->size;
+    r->produced += delta;
+    r->lastWrite = writeIdx;
+
+    // The consumer only sees the backlog modulo the ring size
+    backlog = r->produced - r->consumed;
+    if (backlog >= r->size) {
+        r->overruns++;
+        r->lost += backlog - backlog % r->size;
+        backlog %= r->size;
+        r->consumed = r->produced - backlog;
+        r->highWater = r->size;
+    }
+    if (backlog > r->highWater) r->highWater = backlog;
+}
@@ -0,0 +1,35 @@
+/*
+ * DMA ring monitor
+ * - Mirror of ring_monitor.ads/.adb: lap detection for a circular DMA
+ *   receive ring from its half / full transfer flags and write index
+ * - Produced / consumed byte counts, backlog high-water mark, overruns and
+ *   bytes lost to laps
+ * - Exact while the consumer polls at least once per half ring
+ */
+
+#ifndef RING_MONITOR_H
+#define RING_MONITOR_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t size;
+    uint32_t lastWrite;
+    uint32_t produced;     // Bytes the DMA has written
+    uint32_t consumed;     // Bytes drained, plus bytes lost
+    uint32_t highWater;    // Largest backlog seen (size after an overrun)
+    uint32_t overruns;     // Polls that found the ring lapped
+    uint32_t lost;         // Bytes overwritten before drained
+    uint8_t  pendingHalf;  // Crossing seen in the index before its flag
+    uint8_t  pendingFull;
+} RingMonitor;
+
+void     RingMonitor_Reset(RingMonitor *r, uint32_t size, uint32_t readIdx, uint32_t writeIdx);
+
+// Flags must be sampled (and cleared) before writeIdx is read
+void     RingMonitor_Produce(RingMonitor *r, uint32_t writeIdx, int half, int full);
+
+static inline void RingMonitor_Consume(RingMonitor *r, uint32_t count) { r->consumed += count; }
+static inline uint32_t RingMonitor_Level(const RingMonitor *r) { return r->produced - r->consumed; }
+
+#endif
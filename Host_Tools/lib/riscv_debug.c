@@ -0,0 +1,192 @@
+/*
+ * RISC-V debug loader
+ */
+
+#include "riscv_debug.h"
+#include "neorv32_boot.h"
+
+#include <string.h>
+
+static const char *const names[] = {
+    "LOADED", "BAD_SIGNATURE", "BAD_SIZE", "SHORT_IMAGE", "NO_DTM", "NO_HALT", "NO_SBA",
+    "BUS_ERROR", "NO_RESUME", "SKIPPED"
+};
+
+const char *RvDebug_ResultName(RvDebugResult r) {
+    return (unsigned)r < sizeof(names) / sizeof(names[0]) ? names[r] : "?";
+}
+
+void RvDebug_Init(RvDebug *d, JtagMaster *m) {
+    memset(d, 0, sizeof(*d));
+    d->m = m;
+    d->abits = 7;
+}
+
+// --- SCANS (from and back to Run-Test/Idle) ---
+static void Scan_IR(RvDebug *d, uint8_t ir) {
+    int i;
+    if (d->ir == ir) return;
+    Jtag_Pulse(d->m, 1, 1); // SELECT-DR-SCAN
+    Jtag_Pulse(d->m, 1, 1); // SELECT-IR-SCAN
+    Jtag_Pulse(d->m, 0, 1); // CAPTURE-IR
+    Jtag_Pulse(d->m, 0, 1); // SHIFT-IR
+    for (i = 0; i < RV_IR_LEN; i++) Jtag_Pulse(d->m, (uint8_t)(i == RV_IR_LEN - 1), (ir >> i) & 1u);
+    Jtag_Pulse(d->m, 1, 1); // UPDATE-IR
+    Jtag_Pulse(d->m, 0, 1); // RUN-TEST/IDLE
+    d->ir = ir;
+}
+
+static uint64_t Scan_DR(RvDebug *d, uint64_t out, int nbits) {
+    uint64_t in = 0;
+    uint32_t i;
+    int b;
+    Jtag_Pulse(d->m, 1, 0); // SELECT-DR-SCAN
+    Jtag_Pulse(d->m, 0, 0); // CAPTURE-DR
+    Jtag_Pulse(d->m, 0, 0); // SHIFT-DR
+    for (b = 0; b < nbits; b++) {
+        in |= (uint64_t)Jtag_Pulse(d->m, (uint8_t)(b == nbits - 1), (out >> b) & 1u) << b;
+    }
+    Jtag_Pulse(d->m, 1, 0); // UPDATE-DR
+    Jtag_Pulse(d->m, 0, 0); // RUN-TEST/IDLE
+    for (i = 0; i < d->idle; i++) Jtag_Pulse(d->m, 0, 0);
+    return in;
+}
+
+// --- DMI ---
+static void Dmi_Reset(RvDebug *d) {
+    Scan_IR(d, RV_IR_DTMCS);
+    Scan_DR(d, RV_DTMCS_DMIRESET, 32);
+    Scan_IR(d, RV_IR_DMI);
+}
+
+// One scan; returns what it captured (the status of the access before it)
+static uint64_t Dmi_Scan(RvDebug *d, uint32_t op, uint32_t addr, uint32_t data) {
+    uint64_t out = ((uint64_t)addr << 34) | ((uint64_t)data << 2) | op;
+    uint64_t in;
+    Scan_IR(d, RV_IR_DMI);
+    for (;;) {
+        in = Scan_DR(d, out, d->abits + 34);
+        if ((in & 3u) != RV_DMI_BUSY) break;
+        // This access was dropped: clear the sticky busy, wait longer, again
+        Dmi_Reset(d);
+        d->retries++;
+        if (d->idle >= RV_MAX_IDLE) { d->failed = 1; return in; }
+        d->idle++;
+    }
+    if ((in & 3u) == RV_DMI_FAILED) d->failed = 1;
+    return in;
+}
+
+void RvDebug_DmiWrite(RvDebug *d, uint32_t addr, uint32_t data) {
+    Dmi_Scan(d, RV_DMI_WRITE, addr, data);
+}
+
+uint32_t RvDebug_DmiRead(RvDebug *d, uint32_t addr) {
+    Dmi_Scan(d, RV_DMI_READ, addr, 0);
+    return (uint32_t)(Dmi_Scan(d, RV_DMI_NOP, 0, 0) >> 2);
+}
+
+// --- LOADER ---
+RvDebugResult RvDebug_Connect(RvDebug *d) {
+    uint32_t dtmcs, v;
+
+    Jtag_ResetTap(d->m);
+    Jtag_Pulse(d->m, 0, 1); // RUN-TEST/IDLE
+    d->ir = RV_IR_IDCODE;
+    d->failed = 0;
+    Scan_IR(d, RV_IR_DTMCS);
+    dtmcs = (uint32_t)Scan_DR(d, 0, 32);
+    if ((dtmcs & 0xFu) != 1u) return RVDBG_NO_DTM;
+    d->abits = (int)((dtmcs >> 4) & 0x3Fu);
+    if (d->abits < 7 || d->abits > 30) return RVDBG_NO_DTM;
+    d->idle = (dtmcs >> 12) & 7u;
+
+    RvDebug_DmiWrite(d, RV_DM_CONTROL, RV_CTRL_DMACTIVE);
+    RvDebug_DmiWrite(d, RV_DM_CONTROL, RV_CTRL_DMACTIVE | RV_CTRL_HALTREQ);
+    v = RvDebug_DmiRead(d, RV_DM_STATUS);
+    RvDebug_DmiWrite(d, RV_DM_CONTROL, RV_CTRL_DMACTIVE);
+    if (d->failed || !(v & RV_STAT_ALLHALTED)) return RVDBG_NO_HALT;
+
+    v = RvDebug_DmiRead(d, RV_DM_SBCS);
+    if ((v >> 29) != 1u || !(v & RV_SBCS_CAN32)) return RVDBG_NO_SBA;
+    return RVDBG_LOADED;
+}
+
+void RvDebug_BeginBlock(RvDebug *d, uint32_t addr) {
+    // sberror and sbbusyerror are write-1-to-clear
+    RvDebug_DmiWrite(d, RV_DM_SBCS, RV_SBCS_BUSYERROR | (7u << RV_SBCS_ERROR_SHIFT) |
+                                    RV_SBCS_ACCESS32 | RV_SBCS_AUTOINCREMENT);
+    RvDebug_DmiWrite(d, RV_DM_SBADDRESS0, addr);
+    d->base = addr;
+    d->words = 0;
+}
+
+void RvDebug_WriteWord(RvDebug *d, uint32_t word) {
+    RvDebug_DmiWrite(d, RV_DM_SBDATA0, word);
+    d->words++;
+}
+
+RvDebugResult RvDebug_EndBlock(RvDebug *d) {
+    uint32_t cs = RvDebug_DmiRead(d, RV_DM_SBCS);
+    uint32_t at = RvDebug_DmiRead(d, RV_DM_SBADDRESS0);
+    if (d->failed || (cs & RV_SBCS_BUSYERROR) || ((cs >> RV_SBCS_ERROR_SHIFT) & 7u)) return RVDBG_BUS_ERROR;
+    return at == d->base + 4u * d->words ? RVDBG_LOADED : RVDBG_BUS_ERROR;
+}
+
+RvDebugResult RvDebug_Resume(RvDebug *d, uint32_t entry) {
+    uint32_t v;
+    RvDebug_DmiWrite(d, RV_DM_DATA0, entry);
+    RvDebug_DmiWrite(d, RV_DM_COMMAND, RV_CMD_AARSIZE32 | RV_CMD_TRANSFER | RV_CMD_WRITE | RV_CSR_DPC);
+    v = RvDebug_DmiRead(d, RV_DM_ABSTRACTCS);
+    if (v & RV_ACS_BUSY) v = RvDebug_DmiRead(d, RV_DM_ABSTRACTCS);
+    if ((v & RV_ACS_BUSY) || ((v >> RV_ACS_CMDERR_SHIFT) & 7u)) return RVDBG_NO_RESUME;
+    RvDebug_DmiWrite(d, RV_DM_CONTROL, RV_CTRL_DMACTIVE | RV_CTRL_RESUMEREQ);
+    v = RvDebug_DmiRead(d, RV_DM_STATUS);
+    RvDebug_DmiWrite(d, RV_DM_CONTROL, RV_CTRL_DMACTIVE);
+    return (v & RV_STAT_ALLRESUMEACK) && !d->failed ? RVDBG_LOADED : RVDBG_NO_RESUME;
+}
+
+static RvDebugResult Finish(RvDebug *d, RvDebugReport *r, RvDebugResult result) {
+    r->result = result;
+    r->retries = d->retries;
+    r->idle = d->idle;
+    return result;
+}
+
+RvDebugResult RvDebug_Load(RvDebug *d, const uint8_t *exe, size_t len, RvDebugReport *r) {
+    Neorv32Header h;
+    RvDebugResult res;
+    uint64_t t;
+    size_t i;
+
+    memset(r, 0, sizeof(*r));
+    if (len < NEORV32_HEADER_SIZE) return Finish(d, r, RVDBG_SHORT_IMAGE);
+    Neorv32_ParseHeader(exe, &h);
+    switch (Neorv32_Check(&h)) {
+        case NEORV32_BOOTED: break;
+        case NEORV32_BAD_SIGNATURE: return Finish(d, r, RVDBG_BAD_SIGNATURE);
+        default: return Finish(d, r, RVDBG_BAD_SIZE);
+    }
+    if (len < NEORV32_HEADER_SIZE + h.size) return Finish(d, r, RVDBG_SHORT_IMAGE);
+
+    t = d->m->tckCount;
+    res = RvDebug_Connect(d);
+    r->connectTcks = d->m->tckCount - t;
+    if (res != RVDBG_LOADED) return Finish(d, r, res);
+
+    t = d->m->tckCount;
+    RvDebug_BeginBlock(d, RV_IMEM_BASE);
+    for (i = 0; i < h.size; i += 4) {
+        const uint8_t *p = exe + NEORV32_HEADER_SIZE + i;
+        RvDebug_WriteWord(d, (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+    }
+    res = RvDebug_EndBlock(d);
+    r->writeTcks = d->m->tckCount - t;
+    r->bytes = 4u * d->words;
+    if (res != RVDBG_LOADED) return Finish(d, r, res);
+
+    t = d->m->tckCount;
+    res = RvDebug_Resume(d, RV_IMEM_BASE);
+    r->resumeTcks = d->m->tckCount - t;
+    return Finish(d, r, res);
+}
@@ -0,0 +1,123 @@
+/*
+ * RISC-V debug loader
+ * - Mirror of riscv_debug.ads and of Load_Firmware_Debug in mcu_to_fpga.adb:
+ *   the NEORV32 executable written straight into IMEM through the on-chip
+ *   debugger (RISC-V Debug Spec 0.13) instead of the 19200-baud bootloader
+ * - Runs on a JtagMaster, so every TCK goes through the same clock callback
+ *   as the configuration session; the debug TAP is alone on the pins
+ * - DMI accesses are pipelined: each scan carries the next access and
+ *   captures the status of the last one. A busy status costs a dmireset and
+ *   one more Run-Test/Idle cycle per access from then on
+ */
+
+#ifndef RISCV_DEBUG_H
+#define RISCV_DEBUG_H
+
+#include "jtag_master.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// --- DTM ---
+#define RV_IR_LEN      5
+#define RV_IR_IDCODE   0x01
+#define RV_IR_DTMCS    0x10
+#define RV_IR_DMI      0x11
+#define RV_IR_BYPASS   0x1F
+
+#define RV_DMI_NOP     0
+#define RV_DMI_READ    1
+#define RV_DMI_WRITE   2
+#define RV_DMI_FAILED  2   // Captured op
+#define RV_DMI_BUSY    3   // Captured op: the last access was still running
+
+#define RV_DTMCS_DMIRESET (1u << 16)
+
+// --- DEBUG MODULE REGISTERS ---
+#define RV_DM_DATA0      0x04
+#define RV_DM_CONTROL    0x10
+#define RV_DM_STATUS     0x11
+#define RV_DM_ABSTRACTCS 0x16
+#define RV_DM_COMMAND    0x17
+#define RV_DM_SBCS       0x38
+#define RV_DM_SBADDRESS0 0x39
+#define RV_DM_SBDATA0    0x3C
+
+#define RV_CTRL_DMACTIVE  (1u << 0)
+#define RV_CTRL_RESUMEREQ (1u << 30)
+#define RV_CTRL_HALTREQ   (1u << 31)
+
+#define RV_STAT_ALLHALTED    (1u << 9)
+#define RV_STAT_ALLRUNNING   (1u << 11)
+#define RV_STAT_ALLRESUMEACK (1u << 17)
+
+#define RV_ACS_BUSY         (1u << 12)
+#define RV_ACS_CMDERR_SHIFT 8
+
+#define RV_CMD_AARSIZE32 (2u << 20)
+#define RV_CMD_TRANSFER  (1u << 17)
+#define RV_CMD_WRITE     (1u << 16)
+#define RV_CSR_DPC       0x7B1
+
+#define RV_SBCS_VERSION1      (1u << 29)
+#define RV_SBCS_BUSYERROR     (1u << 22)
+#define RV_SBCS_ACCESS32      (2u << 17)
+#define RV_SBCS_AUTOINCREMENT (1u << 16)
+#define RV_SBCS_ERROR_SHIFT   12
+#define RV_SBCS_CAN32         (1u << 2)
+
+#define RV_IMEM_BASE   0x00000000u
+#define RV_MAX_IDLE    16   // Run-Test/Idle cycles before a busy DM is given up
+
+typedef enum {
+    RVDBG_LOADED,          // Image written and the core resumed at IMEM
+    RVDBG_BAD_SIGNATURE,   // Not a NEORV32 executable: no TCKs
+    RVDBG_BAD_SIZE,        // Zero, unaligned or over the bound: no TCKs
+    RVDBG_SHORT_IMAGE,     // Fewer than Size bytes
+    RVDBG_NO_DTM,          // DTMCS does not read as a 0.13 DTM
+    RVDBG_NO_HALT,         // Hart did not halt
+    RVDBG_NO_SBA,          // No 32-bit system bus access in the DM
+    RVDBG_BUS_ERROR,       // sberror / busy DM / short count after the block
+    RVDBG_NO_RESUME,       // dpc write refused or no resume ack
+    RVDBG_SKIPPED
+} RvDebugResult;
+
+typedef struct {
+    JtagMaster *m;
+    uint8_t     ir;        // Instruction latched in the DTM (0 = unknown)
+    int         abits;
+    uint32_t    idle;      // Run-Test/Idle cycles after each DMI scan
+    uint32_t    retries;   // Busy responses recovered with dmireset
+    int         failed;    // A DMI access came back failed or stayed busy
+    uint32_t    base;
+    uint32_t    words;
+} RvDebug;
+
+typedef struct {
+    RvDebugResult result;
+    uint32_t      bytes;         // Image bytes written
+    uint32_t      retries;
+    uint32_t      idle;          // Idle cycles per access it settled on
+    uint64_t      connectTcks;   // Reset to hart halted, SBA checked
+    uint64_t      writeTcks;     // The block, end check included
+    uint64_t      resumeTcks;    // dpc and resume
+} RvDebugReport;
+
+const char   *RvDebug_ResultName(RvDebugResult r);
+
+void          RvDebug_Init(RvDebug *d, JtagMaster *m);
+
+// Raw DMI, busy handled; the read is a read scan then a NOP scan
+void          RvDebug_DmiWrite(RvDebug *d, uint32_t addr, uint32_t data);
+uint32_t      RvDebug_DmiRead(RvDebug *d, uint32_t addr);
+
+RvDebugResult RvDebug_Connect(RvDebug *d);
+void          RvDebug_BeginBlock(RvDebug *d, uint32_t addr);
+void          RvDebug_WriteWord(RvDebug *d, uint32_t word);
+RvDebugResult RvDebug_EndBlock(RvDebug *d);
+RvDebugResult RvDebug_Resume(RvDebug *d, uint32_t entry);
+
+// The whole load of a NEORV32 executable (header included) at RV_IMEM_BASE
+RvDebugResult RvDebug_Load(RvDebug *d, const uint8_t *exe, size_t len, RvDebugReport *r);
+
+#endif
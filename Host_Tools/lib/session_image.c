@@ -0,0 +1,78 @@
+/*
+ * Bitstream + firmware session image
+ */
+
+#include "session_image.h"
+
+#include <string.h>
+
+#define FRAME_MAX 0xFFFFFFu   // 24-bit length
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void Put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+// One frame at *off, or just its size counted when out is NULL
+static void Frame(uint8_t *out, size_t *off, uint8_t kind, const uint8_t *src, size_t n) {
+    while (n) {
+        size_t k = n < FRAME_MAX ? n : FRAME_MAX;
+        if (out) {
+            Put32(out + *off, kind | (uint32_t)k << 8);
+            memcpy(out + *off + SESSION_FRAME_SIZE, src, k);
+        }
+        *off += SESSION_FRAME_SIZE + k;
+        if (out) src += k;
+        n -= k;
+    }
+}
+
+// Firmware frames spread over the first half of the body, each after an
+// equal share of it: staged with time to spare, whatever the flash costs
+static size_t Frames(const uint8_t *bits, size_t body, const uint8_t *fw, size_t fwLen, uint32_t slice, uint8_t *out) {
+    size_t off = SESSION_HEADER_SIZE, head = fwLen ? body / 2 : 0, n = fwLen ? (fwLen + slice - 1) / slice : 0;
+    size_t i, b = 0, f = 0;
+    for (i = 0; i < n; i++) {
+        size_t to = head * (i + 1) / n, k = fwLen - f < slice ? fwLen - f : slice;
+        Frame(out, &off, SESSION_BITSTREAM, out ? bits + b : NULL, to - b);
+        Frame(out, &off, SESSION_FIRMWARE, out ? fw + f : NULL, k);
+        b = to; f += k;
+    }
+    Frame(out, &off, SESSION_BITSTREAM, out ? bits + b : NULL, body - b);
+    return off;
+}
+
+size_t SessionImage_Size(size_t bitsLen, size_t fwLen, uint32_t slice) {
+    if (bitsLen == 0 || slice < 2 || (slice & 1u)) return 0;
+    return Frames(NULL, bitsLen - 1, NULL, fwLen, slice, NULL);
+}
+
+size_t SessionImage_Build(const uint8_t *bits, size_t bitsLen, const uint8_t *fw, size_t fwLen,
+                          uint32_t slice, uint8_t *image, size_t cap) {
+    uint32_t body, tail, fwl;
+    size_t size = SessionImage_Size(bitsLen, fwLen, slice);
+    if (size == 0 || size > cap || bitsLen > 0xFFFFFFFFu || fwLen > 0xFFFFFFFFu) return 0;
+    body = (uint32_t)(bitsLen - 1);
+    tail = bits[bitsLen - 1];
+    fwl = (uint32_t)fwLen;
+    Put32(image, SESSION_MAGIC);
+    Put32(image + 4, body);
+    Put32(image + 8, tail);
+    Put32(image + 12, fwl);
+    Put32(image + 16, ~(SESSION_MAGIC ^ body ^ tail ^ fwl));
+    return Frames(bits, body, fw, fwLen, slice, image);
+}
+
+// session_image.Valid
+int SessionImage_Parse(const uint8_t header[SESSION_HEADER_SIZE], uint32_t stageSize, SessionHeader *h) {
+    uint32_t magic = Get32(header), body = Get32(header + 4), tail = Get32(header + 8), fwl = Get32(header + 12);
+    if (magic != SESSION_MAGIC || Get32(header + 16) != ~(magic ^ body ^ tail ^ fwl) || tail > 0xFF) return 0;
+    if (fwl > stageSize) return 0;
+    h->bodyLength = body;
+    h->tail = (uint8_t)tail;
+    h->firmwareLength = fwl;
+    return 1;
+}
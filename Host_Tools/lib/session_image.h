@@ -0,0 +1,42 @@
+/*
+ * Bitstream + firmware session image
+ * - Mirror of session_image.ads: a 20-byte header (magic "GWSS", body
+ *   length, last bitstream byte, firmware length, check word), then frames
+ *   of one word (kind in bits 0..7, length in bits 8..31) and their bytes
+ * - 'B' frames carry bitstream body bytes for SPI1, 'F' frames the NEORV32
+ *   executable for the MCU's flash stage; firmware frames are even-length
+ *   but for the last, which comes before the last bitstream frame
+ */
+
+#ifndef SESSION_IMAGE_H
+#define SESSION_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SESSION_MAGIC       0x53535747u   // "GWSS" little-endian
+#define SESSION_HEADER_SIZE 20u
+#define SESSION_FRAME_SIZE  4u
+#define SESSION_BITSTREAM   0x42u         // 'B'
+#define SESSION_FIRMWARE    0x46u         // 'F'
+#define SESSION_STAGE_SIZE  16384u        // Jtag_Test_Config.Stage_Size default
+
+typedef struct {
+    uint32_t bodyLength;
+    uint8_t  tail;
+    uint32_t firmwareLength;
+} SessionHeader;
+
+// Bytes SessionImage_Build writes for these inputs
+size_t SessionImage_Size(size_t bitsLen, size_t fwLen, uint32_t slice);
+
+// Interleaves `fw` in `slice`-byte frames (even, >= 2) over the first half
+// of the body, the rest of the body after it. Returns the image size, or 0
+// if bitsLen is 0, the slice is odd or the image does not fit in `cap`
+size_t SessionImage_Build(const uint8_t *bits, size_t bitsLen, const uint8_t *fw, size_t fwLen,
+                          uint32_t slice, uint8_t *image, size_t cap);
+
+// 1 and *h filled for a valid header whose firmware fits `stageSize`
+int    SessionImage_Parse(const uint8_t header[SESSION_HEADER_SIZE], uint32_t stageSize, SessionHeader *h);
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Programming-session profiler
+ */
+
+#include "session_prof.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const PhaseNames[PROF_PHASES] = { "reset", "init", "pump", "trailer", "command" };
+
+void SessionProf_Begin(SessionProf *p, uint32_t tickHz, uint32_t ringSize) {
+    int i;
+    memset(p, 0, sizeof(*p));
+    p->tickHz = tickHz;
+    p->ringSize = ringSize;
+    for (i = 0; i < PROF_PHASES; i++) p->phase[i].min = UINT32_MAX;
+}
+
+void SessionProf_Sample(SessionProf *p, ProfPhase ph, uint32_t ticks) {
+    ProfStats *s = &p->phase[ph];
+    s->count++;
+    s->total += ticks;
+    if (ticks < s->min) s->min = ticks;
+    if (ticks > s->max) s->max = ticks;
+}
+
+uint32_t ProfStats_Min(const ProfStats *s) {
+    return s->count ? s->min : 0;
+}
+
+uint32_t ProfStats_Avg(const ProfStats *s) {
+    return s->count ? (uint32_t)(s->total / s->count) : 0;
+}
+
+uint32_t SessionProf_Rate(const SessionProf *p) {
+    uint64_t t = p->phase[PROF_PUMP].total;
+    return t ? (uint32_t)((uint64_t)p->bytes * p->tickHz / t) : 0;
+}
+
+const char *ProfPhase_Name(ProfPhase ph) {
+    return ph < PROF_PHASES ? PhaseNames[ph] : "?";
+}
+
+void SessionProf_Print(const SessionProf *p, FILE *f) {
+    int i;
+    fprintf(f, "tick_hz %" PRIu32 "\n", p->tickHz);
+    fprintf(f, "%-8s%10s%10s%10s%10s%10s\n", "phase", "count", "min", "avg", "max", "total");
+    for (i = 0; i < PROF_PHASES; i++) {
+        const ProfStats *s = &p->phase[i];
+        fprintf(f, "%-8s%10" PRIu32 "%10" PRIu32 "%10" PRIu32 "%10" PRIu32 "%10" PRIu64 "\n",
+                PhaseNames[i], s->count, ProfStats_Min(s), ProfStats_Avg(s), s->max, s->total);
+    }
+    fprintf(f, "bytes %" PRIu32 "\n", p->bytes);
+    fprintf(f, "bytes_per_s %" PRIu32 "\n", SessionProf_Rate(p));
+    fprintf(f, "txe_spins %" PRIu32 "\n", p->txeSpins);
+    fprintf(f, "ring_high_water %" PRIu32 " of %" PRIu32 "\n", p->highWater, p->ringSize);
+}
+
+// Unsigned decimal fields after a keyword; returns how many were read
+static int Fields(const char *s, uint64_t *v, int max) {
+    char *end;
+    int n = 0;
+    while (n < max) {
+        while (*s == ' ' || *s == '\t') s++;
+        if (*s < '0' || *s > '9') break;
+        v[n++] = strtoull(s, &end, 10);
+        s = end;
+        if (strncmp(s, " of", 3) == 0) s += 3;
+    }
+    while (*s == ' ' || *s == '\t' || *s == '\r' || *s == '\n') s++;
+    return *s ? -1 : n;
+}
+
+static int Keyword(const char *line, const char *key, const char **rest) {
+    size_t n = strlen(key);
+    if (strncmp(line, key, n) != 0 || (line[n] != ' ' && line[n] != '\t')) return 0;
+    *rest = line + n;
+    return 1;
+}
+
+int SessionProf_ParseLine(SessionProf *p, const char *line) {
+    const char *rest;
+    uint64_t v[5];
+    int i;
+
+    if (Keyword(line, "tick_hz", &rest)) {
+        if (Fields(rest, v, 1) != 1) return -1;
+        p->tickHz = (uint32_t)v[0];
+        return 1;
+    }
+    if (Keyword(line, "phase", &rest)) return 1;
+    for (i = 0; i < PROF_PHASES; i++) {
+        if (!Keyword(line, PhaseNames[i], &rest)) continue;
+        if (Fields(rest, v, 5) != 5) return -1;
+        p->phase[i].count = (uint32_t)v[0];
+        p->phase[i].min = v[0] ? (uint32_t)v[1] : UINT32_MAX;
+        p->phase[i].max = (uint32_t)v[3];
+        p->phase[i].total = v[4];
+        return 1;
+    }
+    if (Keyword(line, "bytes", &rest)) {
+        if (Fields(rest, v, 1) != 1) return -1;
+        p->bytes = (uint32_t)v[0];
+        return 1;
+    }
+    if (Keyword(line, "bytes_per_s", &rest)) return Fields(rest, v, 1) == 1 ? 1 : -1;
+    if (Keyword(line, "txe_spins", &rest)) {
+        if (Fields(rest, v, 1) != 1) return -1;
+        p->txeSpins = (uint32_t)v[0];
+        return 1;
+    }
+    if (Keyword(line, "ring_high_water", &rest)) {
+        if (Fields(rest, v, 2) != 2) return -1;
+        p->highWater = (uint32_t)v[0];
+        p->ringSize = (uint32_t)v[1];
+        return 1;
+    }
+    return 0;
+}
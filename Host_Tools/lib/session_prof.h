@@ -0,0 +1,63 @@
+/*
+ * Programming-session profiler
+ * - Mirror of profiler.ads/.adb: per-phase count/min/max/total, bytes
+ *   streamed, SPI SR.TXE idle spins and DMA ring high-water mark
+ * - The firmware samples in microseconds (tickHz 1000000); the host
+ *   JtagMaster samples in TCKs, so the tick rate is part of the report
+ * - SessionProf_Print writes the same text as the Cmd_Call "prof" command
+ *   and SessionProf_ParseLine reads it back
+ */
+
+#ifndef SESSION_PROF_H
+#define SESSION_PROF_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define PROF_FW_TICK_HZ 1000000u   // Profiler.Tick_Hz
+#define PROF_FW_RING    4096u      // utils.Buffer_Size, default ring_layout
+
+typedef enum {
+    PROF_RESET=0,   // Reset_TAP
+    PROF_INIT,      // Init_Configuration
+    PROF_PUMP,      // Bitstream pump: first DMA byte to the silence timeout
+    PROF_TRAILER,   // Last byte, trailing commands and status capture
+    PROF_COMMAND,   // Every Send_Command, wherever it is called from
+    PROF_PHASES
+} ProfPhase;
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} ProfStats;
+
+typedef struct {
+    uint32_t  tickHz;
+    uint32_t  ringSize;
+    ProfStats phase[PROF_PHASES];
+    uint32_t  bytes;
+    uint32_t  txeSpins;
+    uint32_t  highWater;
+} SessionProf;
+
+void        SessionProf_Begin(SessionProf *p, uint32_t tickHz, uint32_t ringSize);
+void        SessionProf_Sample(SessionProf *p, ProfPhase ph, uint32_t ticks);
+
+// Ring occupancy seen by the consumer; keeps the largest
+static inline void SessionProf_Level(SessionProf *p, uint32_t level) {
+    if (level > p->highWater) p->highWater = level;
+}
+
+uint32_t    ProfStats_Min(const ProfStats *s);   // 0 when never sampled
+uint32_t    ProfStats_Avg(const ProfStats *s);
+uint32_t    SessionProf_Rate(const SessionProf *p);   // Bytes per second over the pump
+const char *ProfPhase_Name(ProfPhase ph);
+
+void        SessionProf_Print(const SessionProf *p, FILE *f);
+
+// 1 = report line taken, 0 = not part of a report, -1 = malformed
+int         SessionProf_ParseLine(SessionProf *p, const char *line);
+
+#endif
@@ -0,0 +1,32 @@
+/*
+ * SHA-256 (FIPS 180-4)
+ * - The content address of a cached design: two files with the same
+ *   digest are the same design, whatever they are called or wherever
+ *   they live
+ * - One call for a buffer in memory, or Init / Update / Final for one
+ *   read in pieces
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_SIZE 32u
+#define SHA256_HEX  65u   // 64 digits and the terminator
+
+typedef struct {
+    uint32_t h[8];
+    uint64_t bytes;
+    uint8_t  block[64];
+    size_t   fill;
+} Sha256;
+
+void Sha256_Init(Sha256 *s);
+void Sha256_Update(Sha256 *s, const void *data, size_t len);
+void Sha256_Final(Sha256 *s, uint8_t digest[SHA256_SIZE]);
+void Sha256_Digest(const void *data, size_t len, uint8_t digest[SHA256_SIZE]);
+void Sha256_Hex(const uint8_t digest[SHA256_SIZE], char hex[SHA256_HEX]);
+
+#endif
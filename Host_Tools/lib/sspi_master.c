@@ -0,0 +1,88 @@
+/*
+ * Host-side mirror of the programmer's SSPI path (sspi.adb)
+ */
+
+#include "sspi_master.h"
+
+void SspiMaster_Init(SspiMaster *m, const SspiBus *bus) {
+    m->bus = bus;
+    m->eraseWaitUs = SSPI_ERASE_WAIT_US;
+    m->readyPolls = SSPI_READY_POLLS;
+    m->donePolls = SSPI_DONE_POLLS;
+    m->idcode = 0; m->status = 0; m->bytesSent = 0;
+    m->configured = 0; m->notReady = 0;
+}
+
+int SspiMaster_WaitReady(SspiMaster *m) {
+    uint32_t polls;
+    if (m->notReady) return 0;
+    for (polls = 0; !m->bus->ready(m->bus->ctx); polls++) {
+        if (polls >= m->readyPolls) { m->notReady = 1; return 0; }
+        m->bus->delayUs(m->bus->ctx, 1);
+    }
+    return 1;
+}
+
+void SspiMaster_Command(SspiMaster *m, uint8_t cmd) {
+    const SspiBus *b = m->bus;
+    if (!SspiMaster_WaitReady(m)) return;
+    b->select(b->ctx, 1);
+    b->transfer(b->ctx, cmd);
+    b->transfer(b->ctx, 0x00);
+    b->select(b->ctx, 0);
+}
+
+uint32_t SspiMaster_Read(SspiMaster *m, uint8_t cmd) {
+    const SspiBus *b = m->bus;
+    uint32_t value = 0;
+    int i;
+    if (!SspiMaster_WaitReady(m)) return 0;
+    b->select(b->ctx, 1);
+    b->transfer(b->ctx, cmd);
+    for (i = 0; i < 3; i++) b->transfer(b->ctx, 0x00);
+    for (i = 0; i < 4; i++) value = (value << 8) | b->transfer(b->ctx, 0x00);
+    b->select(b->ctx, 0);
+    return value;
+}
+
+int Sspi_StatusDone(uint32_t status) { return (status & SSPI_STATUS_DONE_BIT) != 0; }
+
+static void StreamBitstream(SspiMaster *m, const uint8_t *data, size_t len) {
+    const SspiBus *b = m->bus;
+    size_t i;
+    if (!SspiMaster_WaitReady(m)) return;
+    b->select(b->ctx, 1);
+    b->transfer(b->ctx, 0x3B);
+    for (i = 0; i < len; i++) b->transfer(b->ctx, data[i]);
+    m->bytesSent += (uint32_t)len;
+    b->select(b->ctx, 0);
+}
+
+int SspiMaster_Program(SspiMaster *m, const uint8_t *data, size_t len) {
+    const SspiBus *b = m->bus;
+    uint32_t poll;
+
+    m->configured = 0; m->notReady = 0;
+    m->bytesSent = 0; m->idcode = 0; m->status = 0;
+
+    b->reconfig(b->ctx, 0);
+    b->delayUs(b->ctx, SSPI_RECONFIG_PULSE_US);
+    b->reconfig(b->ctx, 1);
+
+    m->idcode = SspiMaster_Read(m, 0x11);
+
+    SspiMaster_Command(m, 0x05);          // Erase
+    b->delayUs(b->ctx, m->eraseWaitUs);
+    SspiMaster_Command(m, 0x12);          // Init address
+    SspiMaster_Command(m, 0x15);          // Write enable
+    StreamBitstream(m, data, len);
+    SspiMaster_Command(m, 0x3A);          // Write disable
+
+    for (poll = 0; poll < m->donePolls; poll++) {
+        m->status = SspiMaster_Read(m, 0x41);
+        if (Sspi_StatusDone(m->status) || b->done(b->ctx) || m->notReady) break;
+    }
+
+    m->configured = !m->notReady && (Sspi_StatusDone(m->status) || b->done(b->ctx));
+    return m->configured;
+}
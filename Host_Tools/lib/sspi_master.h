@@ -0,0 +1,53 @@
+/*
+ * Host-side mirror of the programmer's SSPI path (sspi.adb)
+ * - Same command order, READY gating, 32-bit read-back and DONE polling
+ * - The pins are reached through an SspiBus so the same code drives the
+ *   target model, a trace recorder or real hardware
+ */
+
+#ifndef SSPI_MASTER_H
+#define SSPI_MASTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SSPI_STATUS_DONE_BIT   0x00002000
+#define SSPI_ERASE_WAIT_US     4000     // Erase_Wait
+#define SSPI_RECONFIG_PULSE_US 2000     // Reconfig_Pulse
+#define SSPI_READY_POLLS       100000   // Ready_Timeout, one poll per microsecond
+#define SSPI_DONE_POLLS        50       // Done_Timeout, in status reads
+
+typedef struct {
+    void    (*select)(void *ctx, int csLow);
+    uint8_t (*transfer)(void *ctx, uint8_t mosi);
+    int     (*ready)(void *ctx);
+    int     (*done)(void *ctx);
+    void    (*reconfig)(void *ctx, int level);
+    void    (*delayUs)(void *ctx, uint32_t us);
+    void     *ctx;
+} SspiBus;
+
+typedef struct {
+    const SspiBus *bus;
+    uint32_t eraseWaitUs;
+    uint32_t readyPolls;
+    uint32_t donePolls;
+
+    // Same results as sspi.ads
+    uint32_t idcode;
+    uint32_t status;
+    uint32_t bytesSent;
+    int      configured;
+    int      notReady;
+} SspiMaster;
+
+void     SspiMaster_Init(SspiMaster *m, const SspiBus *bus);
+int      SspiMaster_WaitReady(SspiMaster *m);
+void     SspiMaster_Command(SspiMaster *m, uint8_t cmd);
+uint32_t SspiMaster_Read(SspiMaster *m, uint8_t cmd);
+int      Sspi_StatusDone(uint32_t status);
+
+// Whole session; returns m->configured
+int      SspiMaster_Program(SspiMaster *m, const uint8_t *data, size_t len);
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * SspiBus that runs the SSPI master against the protocol checker
+ */
+
+#include "sspi_record.h"
+
+#include <string.h>
+
+static void Rec_Select(void *ctx, int csLow) {
+    SspiRecorder *r = ctx;
+    if (csLow) {
+        memset(&r->cur, 0, sizeof(r->cur));
+        r->cur.tNs = r->nowNs;
+        r->cur.kind = SSPI_TR_XFER;
+        SspiChecker_Begin(r->check, r->nowNs);
+    } else {
+        SspiChecker_End(r->check);
+        r->nowNs = r->check->nowNs;
+        if (r->out) SspiTrace_Write(r->out, &r->cur);
+    }
+}
+
+static uint8_t Rec_Transfer(void *ctx, uint8_t mosi) {
+    SspiRecorder *r = ctx;
+    // Past the head only the count is kept, so only bursts may run long
+    if (r->cur.headLen < SSPI_TRACE_HEAD && !r->cur.burstLen && !(r->cur.headLen == 1 && r->cur.head[0] == SSPI_CMD_WRITE_REQ))
+        r->cur.head[r->cur.headLen++] = mosi;
+    else
+        r->cur.burstLen++;
+    return SspiChecker_Byte(r->check, mosi);
+}
+
+static int Rec_Ready(void *ctx) { return ((SspiRecorder *)ctx)->check->t.ready; }
+static int Rec_Done(void *ctx) { return ((SspiRecorder *)ctx)->check->t.done; }
+
+static void Rec_Reconfig(void *ctx, int level) {
+    SspiRecorder *r = ctx;
+    SspiTraceRec rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.tNs = r->nowNs;
+    rec.kind = SSPI_TR_RECONFIG;
+    rec.level = (uint8_t)(level && !r->holdReset);
+    SspiChecker_Reconfig(r->check, r->nowNs, rec.level);
+    if (r->out) SspiTrace_Write(r->out, &rec);
+}
+
+static void Rec_Delay(void *ctx, uint32_t us) {
+    SspiRecorder *r = ctx;
+    r->nowNs += (uint64_t)us * 1000;
+    r->delayNs += (uint64_t)us * 1000;
+}
+
+void SspiRecorder_Init(SspiRecorder *r, SspiChecker *check, FILE *out) {
+    memset(r, 0, sizeof(*r));
+    r->check = check;
+    r->out = out;
+    r->bus.select = Rec_Select;
+    r->bus.transfer = Rec_Transfer;
+    r->bus.ready = Rec_Ready;
+    r->bus.done = Rec_Done;
+    r->bus.reconfig = Rec_Reconfig;
+    r->bus.delayUs = Rec_Delay;
+    r->bus.ctx = r;
+}
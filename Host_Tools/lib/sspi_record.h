@@ -0,0 +1,27 @@
+/*
+ * SspiBus that runs the SSPI master against the protocol checker
+ * - Keeps simulated time: one byte-time per transfer, delayUs as asked
+ * - Writes every transaction as a trace line when an output file is given
+ */
+
+#ifndef SSPI_RECORD_H
+#define SSPI_RECORD_H
+
+#include "sspi_check.h"
+#include "sspi_master.h"
+
+#include <stdio.h>
+
+typedef struct {
+    SspiChecker *check;
+    FILE        *out;          // Optional trace output
+    SspiBus      bus;
+    uint64_t     nowNs;
+    uint64_t     delayNs;      // Time spent in delayUs
+    uint8_t      holdReset;    // Keep RECONFIG_N low (READY never rises)
+    SspiTraceRec cur;
+} SspiRecorder;
+
+void SspiRecorder_Init(SspiRecorder *r, SspiChecker *check, FILE *out);
+
+#endif
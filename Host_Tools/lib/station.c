@@ -0,0 +1,321 @@
+/*
+ * Programming station: one bitstream into many programmers at once
+ */
+
+#include "station.h"
+#include "pty_link.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TICK_MS 5   // Resend timers and deadlines
+
+static double Now_Ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+const char *Station_StateName(StationPortState st) {
+    static const char *Names[] = { "CONFIG", "UPLOAD", "REPORT", "DONE", "FAIL" };
+    return (unsigned)st < sizeof(Names) / sizeof(Names[0]) ? Names[st] : "?";
+}
+
+int Station_Discover(const char *pattern, char paths[][64], int max) {
+    glob_t g;
+    int n = 0;
+    size_t i;
+    if (glob(pattern, 0, NULL, &g) != 0) return 0;
+    for (i = 0; i < g.gl_pathc && n < max; i++) {
+        if (strlen(g.gl_pathv[i]) >= 64) continue;
+        strcpy(paths[n++], g.gl_pathv[i]);
+    }
+    globfree(&g);
+    return n;
+}
+
+int Station_MapFile(const char *path, const uint8_t **data, size_t *len) {
+    struct stat sb;
+    void *m;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    errno = 0;
+    if (fstat(fd, &sb) < 0 || sb.st_size == 0) {
+        int e = errno ? errno : EINVAL;
+        close(fd);
+        errno = e;
+        return -1;
+    }
+    m = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED) return -1;
+    *data = m;
+    *len = (size_t)sb.st_size;
+    return 0;
+}
+
+void Station_UnmapFile(const uint8_t *data, size_t len) { munmap((void *)data, len); }
+
+int Station_Init(Station *st, const uint8_t *data, size_t len, uint32_t chunk, uint32_t baud) {
+    memset(st, 0, sizeof(*st));
+    st->data = data;
+    st->len = len;
+    st->chunk = chunk;
+    st->baud = baud;
+    st->configMs = STATION_CONFIG_MS;
+    st->epfd = epoll_create1(0);
+    st->t0 = Now_Ms();
+    return st->epfd < 0 ? -1 : 0;
+}
+
+static void Fail(Station *st, StationPort *p, const char *why) {
+    p->state = PORT_FAIL;
+    p->why = why;
+    p->doneMs = Now_Ms() - st->t0;
+    if (p->fd >= 0) {
+        epoll_ctl(st->epfd, EPOLL_CTL_DEL, p->fd, NULL);
+        if (p->owned) close(p->fd);
+        p->fd = -1;
+    }
+}
+
+static StationPort *New_Port(Station *st, const char *path, int *i) {
+    StationPort *p;
+    if (st->count == STATION_MAX_PORTS) return NULL;
+    *i = st->count++;
+    p = &st->port[*i];
+    memset(p, 0, sizeof(*p));
+    strncpy(p->path, path, sizeof(p->path) - 1);
+    p->state = PORT_CONFIG;
+    p->deadline = Now_Ms() + st->configMs;
+    return p;
+}
+
+// `config` out and the port into the epoll set
+static int Start(Station *st, StationPort *p, int i) {
+    static const uint8_t Command[] = "config\r";
+    struct epoll_event ev;
+    int flags = fcntl(p->fd, F_GETFL);
+    // Whatever the last run left on the line is not an answer to this one
+    tcflush(p->fd, TCIOFLUSH);
+    fcntl(p->fd, F_SETFL, flags & ~O_NONBLOCK);
+    if (PtyLink_WriteAll(p->fd, Command, sizeof(Command) - 1) < 0) { Fail(st, p, "cannot write"); return -1; }
+    fcntl(p->fd, F_SETFL, flags | O_NONBLOCK);
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)i;
+    if (epoll_ctl(st->epfd, EPOLL_CTL_ADD, p->fd, &ev) < 0) { Fail(st, p, "cannot poll"); return -1; }
+    return 0;
+}
+
+int Station_Add(Station *st, const char *path) {
+    int i;
+    StationPort *p = New_Port(st, path, &i);
+    if (!p) return -1;
+    p->owned = 1;
+    if ((p->fd = PtyLink_OpenPort(path)) < 0) { Fail(st, p, "cannot open"); return -1; }
+    if (st->baud && PtyLink_SetBaud(p->fd, st->baud) < 0) { Fail(st, p, "cannot set baud"); return -1; }
+    return Start(st, p, i);
+}
+
+int Station_Attach(Station *st, const char *path, int fd) {
+    int i;
+    StationPort *p = New_Port(st, path, &i);
+    if (!p) return -1;
+    p->fd = fd;
+    if (fd < 0) { Fail(st, p, "cannot open"); return -1; }
+    return Start(st, p, i);
+}
+
+static void Want_Out(Station *st, StationPort *p, int i, int want) {
+    struct epoll_event ev;
+    if (p->wantOut == want || p->fd < 0) return;
+    ev.events = EPOLLIN | (want ? EPOLLOUT : 0);
+    ev.data.u32 = (uint32_t)i;
+    epoll_ctl(st->epfd, EPOLL_CTL_MOD, p->fd, &ev);
+    p->wantOut = want;
+}
+
+static void Begin_Upload(Station *st, StationPort *p) {
+    p->uploadMs = Now_Ms() - st->t0;
+    if (st->image) {
+        p->state = PORT_UPLOAD;
+        return;
+    }
+    if (ChunkSender_Init(&p->s, st->data, st->len, st->chunk) < 0 ||
+        !(p->frame = malloc(ChunkLink_FrameSize(st->chunk)))) {
+        Fail(st, p, "out of memory");
+        return;
+    }
+    p->s.framed = st->framed;
+    p->state = PORT_UPLOAD;
+}
+
+static void End_Upload(Station *st, StationPort *p) {
+    p->doneMs = Now_Ms() - st->t0;
+    if (p->s.state != SEND_DONE) { Fail(st, p, ChunkSender_StateName(p->s.state)); return; }
+    p->state = PORT_REPORT;
+    p->lineLen = 0;
+    p->deadline = Now_Ms() + STATION_REPORT_MS;
+}
+
+// One line off the command line, CR / LF stripped
+static void Line(Station *st, StationPort *p, const char *text) {
+    const char *report = st->image ? "session " : "chunks ";
+    if (p->state == PORT_CONFIG) {
+        if (strcmp(text, "Configuring FPGA") == 0) Begin_Upload(st, p);
+        else if (strncmp(text, "Unknown command", 15) == 0) Fail(st, p, "no config command");
+    } else if (p->state == PORT_REPORT && strncmp(text, report, strlen(report)) == 0) {
+        size_t n = strlen(text);
+        strncpy(p->report, text, sizeof(p->report) - 1);
+        if (st->image) p->doneMs = Now_Ms() - st->t0;
+        if (n >= 4 && strcmp(text + n - 4, "DONE") == 0) p->state = PORT_DONE;
+        else Fail(st, p, "programmer reported FAIL");
+    }
+}
+
+// Text bytes; returns how many were taken before the upload started
+static size_t Text(Station *st, StationPort *p, const uint8_t *buf, size_t n) {
+    size_t i;
+    for (i = 0; i < n;) {
+        char c = (char)buf[i++];
+        if (c == '\r' || c == '\n') {
+            if (!p->lineLen) continue;
+            p->line[p->lineLen] = 0;
+            p->lineLen = 0;
+            Line(st, p, p->line);
+            if (p->state != PORT_CONFIG && p->state != PORT_REPORT) break;
+        } else if (p->lineLen < sizeof(p->line) - 1) {
+            p->line[p->lineLen++] = c;
+        }
+    }
+    return i;
+}
+
+static void Read(Station *st, StationPort *p) {
+    uint8_t buf[512];
+    for (;;) {
+        ssize_t got = p->fd < 0 ? 0 : read(p->fd, buf, sizeof(buf));
+        size_t used = 0;
+        if (got < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        if (got <= 0) { if (p->fd >= 0) Fail(st, p, "port closed"); return; }
+        if (p->state == PORT_CONFIG) used = Text(st, p, buf, (size_t)got);
+        if (p->state == PORT_UPLOAD && st->image) {
+            // Nothing comes back while an image goes out
+        } else if (p->state == PORT_UPLOAD && used < (size_t)got) {
+            ChunkSender_Rx(&p->s, buf + used, (size_t)got - used, Now_Ms());
+            if (ChunkSender_Finished(&p->s)) End_Upload(st, p);
+        } else if (p->state == PORT_REPORT) {
+            Text(st, p, buf, (size_t)got);
+        }
+    }
+}
+
+// The image out as it is, then the `session` line awaited
+static void Pump_Image(Station *st, StationPort *p, int i) {
+    while (p->imageOff < st->imageLen) {
+        ssize_t n = write(p->fd, st->image + p->imageOff, st->imageLen - p->imageOff);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) { Want_Out(st, p, i, 1); return; }
+        if (n < 0) { Fail(st, p, "write failed"); return; }
+        p->imageOff += (size_t)n;
+    }
+    Want_Out(st, p, i, 0);
+    p->state = PORT_REPORT;
+    p->lineLen = 0;
+    p->deadline = Now_Ms() + STATION_SESSION_MS;
+}
+
+// Frames out until the port is full or the sender has nothing to send
+static void Pump(Station *st, StationPort *p, int i) {
+    if (st->image) { Pump_Image(st, p, i); return; }
+    for (;;) {
+        if (p->frameOff < p->frameLen) {
+            ssize_t n = write(p->fd, p->frame + p->frameOff, p->frameLen - p->frameOff);
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) { Want_Out(st, p, i, 1); return; }
+            if (n < 0) { Fail(st, p, "write failed"); return; }
+            p->frameOff += (size_t)n;
+            continue;
+        }
+        p->frameLen = ChunkSender_Next(&p->s, Now_Ms(), p->frame);
+        p->frameOff = 0;
+        if (!p->frameLen) break;
+    }
+    Want_Out(st, p, i, 0);
+    if (ChunkSender_Finished(&p->s)) End_Upload(st, p);
+}
+
+static void Step(Station *st, int i) {
+    StationPort *p = &st->port[i];
+    double now = Now_Ms();
+    switch (p->state) {
+    case PORT_CONFIG:
+        if (now >= p->deadline) Fail(st, p, "no prompt");
+        break;
+    case PORT_UPLOAD:
+        Pump(st, p, i);
+        break;
+    case PORT_REPORT:
+        // The upload said DONE; the line is only the programmer's counts.
+        // An image has no replies: there the line is the verdict
+        if (now >= p->deadline) {
+            if (st->image) Fail(st, p, "no session report");
+            else p->state = PORT_DONE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+int Station_Run(Station *st) {
+    struct epoll_event ev[STATION_MAX_PORTS];
+    int i, active;
+    do {
+        int n = epoll_wait(st->epfd, ev, STATION_MAX_PORTS, TICK_MS);
+        for (i = 0; i < n; i++) {
+            StationPort *p = &st->port[ev[i].data.u32];
+            if (ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) Read(st, p);
+            if ((ev[i].events & EPOLLOUT) && p->state == PORT_UPLOAD) Pump(st, p, (int)ev[i].data.u32);
+        }
+        for (i = active = 0; i < st->count; i++) {
+            Step(st, i);
+            active += st->port[i].state != PORT_DONE && st->port[i].state != PORT_FAIL;
+        }
+    } while (active);
+
+    st->wallMs = Now_Ms() - st->t0;
+    st->done = 0;
+    st->wireBytes = 0;
+    for (i = 0; i < st->count; i++) {
+        st->done += st->port[i].state == PORT_DONE;
+        st->wireBytes += st->image ? st->port[i].imageOff : st->port[i].s.bytes;
+    }
+    return st->done;
+}
+
+double Station_PortRate(const Station *st, int i) {
+    const StationPort *p = &st->port[i];
+    if (p->state != PORT_DONE || p->doneMs <= p->uploadMs) return 0;
+    return (double)st->len * 1000.0 / (p->doneMs - p->uploadMs);
+}
+
+void Station_Free(Station *st) {
+    int i;
+    for (i = 0; i < st->count; i++) {
+        StationPort *p = &st->port[i];
+        if (p->frame) { ChunkSender_Free(&p->s); free(p->frame); }
+        if (p->fd >= 0 && p->owned) close(p->fd);
+        p->frame = NULL;
+        p->fd = -1;
+    }
+    if (st->epfd >= 0) close(st->epfd);
+    st->epfd = -1;
+}
@@ -0,0 +1,100 @@
+/*
+ * Programming station: one bitstream into many programmers at once
+ * - Every port (/dev/ttyACM*, found by glob or named) gets `config`, then
+ *   the chunked upload of lib/chunk_send.h once the programmer says
+ *   "Configuring FPGA", then its `chunks ...` report line is read
+ * - One process, one epoll set, no thread per port: every port's fd is
+ *   non-blocking and its ChunkSender is stepped whenever it can write, a
+ *   reply comes in, or the 5 ms tick that drives the resend timers fires
+ * - The bitstream is mapped once, read-only, and every sender frames its
+ *   chunks straight out of the mapping, or copies them out of a frame
+ *   image built beforehand (ChunkLink_Image) when there is one
+ * - With an image set instead (a wire or session image), each port is
+ *   written the image as it is and its `session ...` line is the verdict
+ * - Ports are opened by the station, or attached already open by a caller
+ *   that keeps them between runs (lib/prog_daemon.h); those are left open
+ * - Per port: the state it ended in, the time from the first frame to
+ *   DONE and the bitstream rate over it; over the station: the wall time
+ *   and the bitstream bytes of every board that reached DONE over it
+ */
+
+#ifndef STATION_H
+#define STATION_H
+
+#include "chunk_send.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define STATION_MAX_PORTS  64
+#define STATION_CONFIG_MS  5000.0   // `config` to "Configuring FPGA"
+#define STATION_REPORT_MS  2000.0   // DONE to the `chunks` line (the MCU lingers 500 ms)
+#define STATION_SESSION_MS 30000.0  // Image written to the `session` line (DONE, firmware loaded)
+
+typedef enum {
+    PORT_CONFIG,          // `config` sent, waiting for the prompt
+    PORT_UPLOAD,          // ChunkSender running
+    PORT_REPORT,          // Upload finished, waiting for the `chunks` line
+    PORT_DONE,            // DONE, report read (or not sent in time)
+    PORT_FAIL
+} StationPortState;
+
+typedef struct {
+    char             path[64];
+    int              fd;
+    int              owned;          // Opened here, closed here
+    StationPortState state;
+    const char      *why;            // PORT_FAIL: what went wrong
+    ChunkSender      s;
+    uint8_t         *frame;          // The frame being written
+    size_t           frameLen, frameOff;
+    size_t           imageOff;       // Image bytes written
+    int              wantOut;        // EPOLLOUT registered
+    char             line[256];      // Text from the command line
+    size_t           lineLen;
+    char             report[160];    // The `chunks` (`session`) line, if it came
+    double           deadline;
+    double           uploadMs, doneMs;   // First frame, last reply (station clock)
+} StationPort;
+
+typedef struct {
+    const uint8_t *data;             // The mapping
+    size_t         len;
+    uint32_t       chunk;
+    const uint8_t *framed;           // ChunkLink_Image of data at chunk, or NULL
+    const uint8_t *image;            // Written instead of the chunks, or NULL
+    size_t         imageLen;
+    uint32_t       baud;             // 0: leave the ports as they are
+    double         configMs;         // STATION_CONFIG_MS unless changed before Station_Add
+    StationPort    port[STATION_MAX_PORTS];
+    int            count;
+    int            epfd;
+    double         t0;
+    // Aggregate, after Station_Run
+    double         wallMs;
+    int            done;
+    uint64_t       wireBytes;
+} Station;
+
+// Paths matching a glob pattern into paths, sorted; the number found
+int  Station_Discover(const char *pattern, char paths[][64], int max);
+
+// The file mapped read-only; 0, or -1 with errno set
+int  Station_MapFile(const char *path, const uint8_t **data, size_t *len);
+void Station_UnmapFile(const uint8_t *data, size_t len);
+
+int  Station_Init(Station *st, const uint8_t *data, size_t len, uint32_t chunk, uint32_t baud);
+// Opens the port and sends `config`; -1 if it cannot be opened (the
+// port is still listed, failed)
+int  Station_Add(Station *st, const char *path);
+// The same on a port the caller opened and keeps: never closed here
+int  Station_Attach(Station *st, const char *path, int fd);
+// Every port to DONE or FAIL; the number that reached DONE
+int  Station_Run(Station *st);
+void Station_Free(Station *st);
+
+const char *Station_StateName(StationPortState st);
+// Bitstream bytes per second of a finished port, 0 if it failed
+double Station_PortRate(const Station *st, int i);
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * Pre-split SPI wire image
+ */
+
+#include "wire_image.h"
+
+#include <string.h>
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void Put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+size_t WireImage_Build(const uint8_t *bits, size_t len, uint8_t *image, size_t cap) {
+    uint32_t body, tail;
+    if (len == 0 || len > 0xFFFFFFFFu || WIRE_HEADER_SIZE + len - 1 > cap) return 0;
+    body = (uint32_t)(len - 1);
+    tail = bits[len - 1];
+    Put32(image, WIRE_MAGIC);
+    Put32(image + 4, body);
+    Put32(image + 8, tail);
+    Put32(image + 12, ~(WIRE_MAGIC ^ body ^ tail));
+    memcpy(image + WIRE_HEADER_SIZE, bits, body);
+    return WIRE_HEADER_SIZE + body;
+}
+
+// wire_image.Valid
+int WireImage_Parse(const uint8_t header[WIRE_HEADER_SIZE], WireHeader *h) {
+    uint32_t magic = Get32(header), body = Get32(header + 4), tail = Get32(header + 8);
+    if (magic != WIRE_MAGIC || Get32(header + 12) != ~(magic ^ body ^ tail) || tail > 0xFF) return 0;
+    h->bodyLength = body;
+    h->tail = (uint8_t)tail;
+    return 1;
+}
@@ -0,0 +1,31 @@
+/*
+ * Pre-split SPI wire image
+ * - Mirror of wire_image.ads: a 16-byte header (magic "GWSW", body length,
+ *   last bitstream byte, check word), then every bitstream byte but the
+ *   last, ready for SPI1 as they are (MSB first, no padding)
+ * - The last byte rides in the header so the pump never holds one back;
+ *   the bypass bits after it are added by whoever knows the chain
+ */
+
+#ifndef WIRE_IMAGE_H
+#define WIRE_IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WIRE_MAGIC       0x57535747u   // "GWSW" little-endian
+#define WIRE_HEADER_SIZE 16u
+
+typedef struct {
+    uint32_t bodyLength;
+    uint8_t  tail;
+} WireHeader;
+
+// Image for `len` (>= 1) bitstream bytes; WIRE_HEADER_SIZE + len - 1 bytes,
+// or 0 if it does not fit in `cap`
+size_t WireImage_Build(const uint8_t *bits, size_t len, uint8_t *image, size_t cap);
+
+// 1 and *h filled for a valid header, 0 for anything else (a raw bitstream)
+int    WireImage_Parse(const uint8_t header[WIRE_HEADER_SIZE], WireHeader *h);
+
+#endif
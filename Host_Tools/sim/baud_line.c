@@ -0,0 +1,73 @@
+/*
+ * UART line between the host's USB-serial bridge and USART2
+ */
+
+#include "baud_line.h"
+
+#include <string.h>
+
+#define TOLERANCE 0.03
+
+static uint32_t Next(BaudLine *l) {
+    uint32_t x = l->rng;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    return l->rng = x;
+}
+
+void BaudLine_Init(BaudLine *l, uint32_t ceiling, uint32_t overPpm, double hostClock, uint32_t seed) {
+    memset(l, 0, sizeof(*l));
+    l->ceiling = ceiling;
+    l->overPpm = overPpm;
+    l->hostClock = hostClock;
+    l->rng = seed ? seed : 1;
+}
+
+double BaudLine_McuRate(uint32_t nominal) {
+    uint32_t brr = (48000000u + nominal / 2) / nominal;
+    return 48e6 / (brr < 16 ? 16 : brr);
+}
+
+double BaudLine_HostRate(const BaudLine *l, uint32_t nominal) {
+    uint32_t div;
+    if (l->hostClock <= 0) return nominal;
+    div = (uint32_t)(l->hostClock / nominal + 0.5);
+    return l->hostClock / (div < 1 ? 1 : div);
+}
+
+void BaudLine_Send(BaudLine *l, int dir, double now, double rate, const uint8_t *buf, size_t n) {
+    BaudLineDir *d = &l->dir[dir];
+    size_t i;
+    if (d->busy < now) d->busy = now;
+    for (i = 0; i < n && d->len < sizeof(d->q) / sizeof(d->q[0]); i++) {
+        BaudLineByte *b = &d->q[(d->head + d->len++) % (sizeof(d->q) / sizeof(d->q[0]))];
+        d->busy += 10.0 * 1000.0 / rate;
+        b->at = d->busy;
+        b->rate = rate;
+        b->byte = buf[i];
+    }
+}
+
+int BaudLine_Busy(const BaudLine *l, int dir, double now) { return l->dir[dir].busy > now; }
+
+size_t BaudLine_Receive(BaudLine *l, int dir, double now, double rate, uint8_t *out, size_t max) {
+    BaudLineDir *d = &l->dir[dir];
+    size_t n = 0;
+    while (d->len && n < max && d->q[d->head].at <= now) {
+        BaudLineByte b = d->q[d->head];
+        d->head = (d->head + 1) % (sizeof(d->q) / sizeof(d->q[0]));
+        d->len--;
+        if ((b.rate > rate ? b.rate - rate : rate - b.rate) / rate > TOLERANCE) {
+            // Sampled at the wrong points: a framing error or noise
+            if (Next(l) & 1) { l->lost++; continue; }
+            l->garbled++;
+            out[n++] = (uint8_t)Next(l);
+            continue;
+        }
+        if ((b.rate > l->ceiling || rate > l->ceiling) && Next(l) % 1000000u < l->overPpm) {
+            b.byte ^= (uint8_t)(1u << (Next(l) & 7));
+            l->flipped++;
+        }
+        out[n++] = b.byte;
+    }
+    return n;
+}
@@ -0,0 +1,50 @@
+/*
+ * UART line between the host's USB-serial bridge and USART2
+ * - Each end runs at its own actual rate: USART2 divides 48 MHz by a
+ *   whole BRR (16x oversampling), the bridge its own clock (0: exact)
+ * - A byte takes ten bit times at the sender's rate. The receiver reads
+ *   it right only if the two rates are within 3 % of each other; else it
+ *   gets noise, or nothing at all for half of them
+ * - Past `ceiling` (what the cable and bridge carry cleanly) a byte has
+ *   a bit flipped at `overPpm` per million
+ */
+
+#ifndef BAUD_LINE_H
+#define BAUD_LINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BAUD_LINE_TO_MCU  0
+#define BAUD_LINE_TO_HOST 1
+
+typedef struct {
+    double  at;        // Last stop bit, ms
+    double  rate;      // Sender's actual rate
+    uint8_t byte;
+} BaudLineByte;
+
+typedef struct {
+    BaudLineByte q[4096];
+    size_t       head, len;
+    double       busy;          // Line free from here, ms
+} BaudLineDir;
+
+typedef struct {
+    uint32_t    ceiling, overPpm;
+    double      hostClock;
+    uint32_t    rng;
+    BaudLineDir dir[2];
+    uint32_t    garbled, lost, flipped;
+} BaudLine;
+
+void   BaudLine_Init(BaudLine *l, uint32_t ceiling, uint32_t overPpm, double hostClock, uint32_t seed);
+double BaudLine_McuRate(uint32_t nominal);
+double BaudLine_HostRate(const BaudLine *l, uint32_t nominal);
+// Queue bytes sent at `rate` from `now`; 1 while the line still has them
+void   BaudLine_Send(BaudLine *l, int dir, double now, double rate, const uint8_t *buf, size_t n);
+int    BaudLine_Busy(const BaudLine *l, int dir, double now);
+// Bytes whose stop bit has passed, as a receiver at `rate` reads them
+size_t BaudLine_Receive(BaudLine *l, int dir, double now, double rate, uint8_t *out, size_t max);
+
+#endif
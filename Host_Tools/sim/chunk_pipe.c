@@ -0,0 +1,155 @@
+/*
+ * Chunked upload over a faulty pseudo-terminal
+ */
+
+#include "chunk_pipe.h"
+#include "chunk_recv.h"
+#include "fault_link.h"
+#include "gowin_tap.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+#include "pty_link.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NO_DATA_MS 10000   // Give up if the host goes quiet for good
+
+// Written by a host child, read once it exits
+typedef struct {
+    uint32_t state, resumedAt, frames, resent, naks, rtos, probes, badReplies;
+    uint64_t bytes;
+} HostShared;
+
+static uint64_t Now_Ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// --- HOST ---
+static void Host(const ChunkPipeConfig *c, const char *port, uint32_t stopAfter, HostShared *sh) {
+    ChunkSender s;
+    int fd = PtyLink_OpenPort(port);
+    if (fd < 0 || ChunkSender_Init(&s, c->data, c->len, c->chunk) < 0) _exit(1);
+    ChunkSend_Port(&s, fd, stopAfter);
+    *sh = (HostShared){ (uint32_t)s.state, s.resumedAt, s.frames, s.resent, s.naks, s.rtos, s.probes, s.badReplies, s.bytes };
+    ChunkSender_Free(&s);
+    close(fd);
+    _exit(0);
+}
+
+// --- MCU ---
+// USART2 RX through the faults, as much as DMA_Buffer has room for
+static int Receive(int fd, McuRing *ring, FaultLink *f) {
+    uint8_t tmp[1024];
+    int total = 0;
+    for (;;) {
+        uint32_t room;
+        uint8_t *dst = McuRing_WriteSpan(ring, &room);
+        ssize_t n;
+        size_t kept;
+        if (room == 0) break;
+        n = read(fd, tmp, room < sizeof(tmp) ? room : sizeof(tmp));
+        if (n <= 0) break;
+        kept = FaultLink_Apply(f, tmp, (size_t)n);
+        memcpy(dst, tmp, kept);
+        McuRing_Commit(ring, (uint32_t)kept);
+        total += (int)n;
+    }
+    return total;
+}
+
+static void Send_Replies(int fd, McuChunk *m, FaultLink *f) {
+    uint8_t buf[sizeof(m->out)];
+    size_t n = McuChunk_TakeReplies(m, buf, sizeof(buf));
+    n = FaultLink_Apply(f, buf, n);
+    // A full pty drops them, as a host that stopped reading would
+    if (n && write(fd, buf, n) < 0 && errno != EAGAIN) return;
+}
+
+int ChunkPipe_Run(const ChunkPipeConfig *c, ChunkPipeResult *r) {
+    static GowinTap tap;
+    PtyLink link;
+    JtagMaster jtag;
+    McuRing ring;
+    McuChunk m;
+    FaultLink rx, tx;
+    HostShared *sh;
+    uint64_t t0, lastData;
+    int hosts = c->stopAfter ? 2 : 1, h;
+
+    memset(r, 0, sizeof(*r));
+    if (PtyLink_Open(&link) < 0) return -1;
+    sh = mmap(NULL, 2 * sizeof(*sh), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (sh == MAP_FAILED) { PtyLink_Close(&link); return -1; }
+    memset(sh, 0, 2 * sizeof(*sh));
+
+    GowinTap_Init(&tap);
+    Jtag_Init(&jtag, GowinTap_ClockFn, &tap);
+    Jtag_ResetTap(&jtag);
+    Jtag_InitConfiguration(&jtag);
+    McuRing_Init(&ring, c->ringSize);
+    McuChunk_Begin(&m, &ring, &jtag);
+    FaultLink_Init(&rx, c->seed, c->flipPpm, c->dropPpm, c->burst);
+    FaultLink_Init(&tx, c->seed * 2654435761u + 1, c->replyFlipPpm, c->replyDropPpm, 1);
+
+    t0 = lastData = Now_Ns();
+    for (h = 0; h < hosts; h++) {
+        pid_t pid = fork();
+        int status;
+        if (pid < 0) break;
+        if (pid == 0) Host(c, link.path, h == 0 ? c->stopAfter : 0, &sh[h]);
+        for (;;) {
+            struct pollfd p = { link.master, POLLIN, 0 };
+            int exited = waitpid(pid, &status, WNOHANG) == pid;
+            if (poll(&p, 1, 5) > 0 && Receive(link.master, &ring, &rx) > 0) lastData = Now_Ns();
+            McuChunk_Drain(&m);
+            Send_Replies(link.master, &m, &tx);
+            if (exited) break;
+            if (Now_Ns() - lastData > (uint64_t)NO_DATA_MS * 1000000u) {
+                kill(pid, SIGKILL);
+                waitpid(pid, &status, 0);
+                break;
+            }
+        }
+    }
+
+    r->wallS = (double)(Now_Ns() - t0) / 1e9;
+    for (h = 0; h < hosts; h++) {
+        r->wireBytes += sh[h].bytes;
+        r->frames += sh[h].frames;
+        r->resent += sh[h].resent;
+        r->naks += sh[h].naks;
+        r->rtos += sh[h].rtos;
+        r->probes += sh[h].probes;
+        r->badReplies += sh[h].badReplies;
+    }
+    r->host = (ChunkSendState)sh[hosts - 1].state;
+    r->resumedAt = hosts > 1 ? sh[1].resumedAt : 0;
+    r->rxFrames = m.frames;
+    r->badCrc = m.badCrc;
+    r->skipped = m.skipped;
+    r->dups = m.dups;
+    r->evicted = m.evicted;
+    r->held = m.held;
+    r->flipped = rx.flipped;
+    r->dropped = rx.dropped;
+    r->drops = rx.drops;
+    r->replyFaults = tx.flipped + tx.dropped;
+    r->streamBits = tap.diagStreamBits;
+    r->pass = m.status == CHUNK_DONE && m.shifted == c->len && tap.diagStreamBits == c->len * 8 &&
+              (tap.leds & LED_PROG_5) && r->host == SEND_DONE;
+
+    McuRing_Free(&ring);
+    munmap(sh, 2 * sizeof(*sh));
+    PtyLink_Close(&link);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/*
+ * Chunked upload over a faulty pseudo-terminal
+ * - Host: a child process running ChunkSend_Port on the USART2 pty, as
+ *   tools/chunk_send does on /dev/ttyACM0
+ * - MCU: this process; every byte read off the pty goes through a
+ *   FaultLink before it lands in DMA_Buffer, every reply through another
+ *   one on the way back, then McuChunk into the Gowin TAP model
+ * - stopAfter > 0: the first host dies after that many data frames and a
+ *   second one picks the session up from the MCU's next chunk
+ */
+
+#ifndef CHUNK_PIPE_H
+#define CHUNK_PIPE_H
+
+#include "chunk_send.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const uint8_t *data;
+    size_t         len;
+    uint32_t       chunk;
+    uint32_t       ringSize;       // DMA_Buffer
+    uint32_t       seed;
+    uint32_t       flipPpm, dropPpm, burst;   // Host to MCU
+    uint32_t       replyFlipPpm, replyDropPpm; // MCU to host
+    uint32_t       stopAfter;
+} ChunkPipeConfig;
+
+typedef struct {
+    int            pass;          // TAP DONE and every bit of the file in it
+    ChunkSendState host;          // Final state of the (last) host
+    uint32_t       resumedAt;     // Second host's first chunk
+    uint64_t       wireBytes;     // All hosts, frames and probes
+    uint32_t       frames, resent, naks, rtos, probes, badReplies;
+    uint32_t       rxFrames, badCrc, skipped, dups, evicted, held;   // MCU
+    uint32_t       flipped, dropped, drops;        // Injected, host to MCU
+    uint32_t       replyFaults;                    // Injected, MCU to host (bytes)
+    uint32_t       streamBits;
+    double         wallS;
+} ChunkPipeResult;
+
+// 0 when the run completed (pass or not), -1 if the pty or children failed
+int ChunkPipe_Run(const ChunkPipeConfig *c, ChunkPipeResult *r);
+
+#endif
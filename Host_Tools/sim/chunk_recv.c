@@ -0,0 +1,170 @@
+/*
+ * Chunked upload, MCU side
+ */
+
+#include "chunk_recv.h"
+#include "jtag_fanout.h"
+
+#include <string.h>
+
+void McuChunk_Begin(McuChunk *c, McuRing *r, JtagMaster *jtag) {
+    memset(c, 0, sizeof(*c));
+    c->ring = r;
+    c->jtag = jtag;
+    c->status = CHUNK_RUNNING;
+    Jtag_BeginStream(jtag);
+}
+
+static uint8_t Byte(const McuChunk *c, uint32_t at) { return c->ring->buf[at & (c->ring->size - 1)]; }
+
+static void Reply(McuChunk *c, uint8_t kind, uint16_t seq) {
+    ChunkReply r;
+    uint32_t room = c->ring->size / 64;
+    if (c->outLen + CHUNK_REPLY_SIZE > sizeof(c->out)) return;   // The host will time out
+    r.kind = kind;
+    r.seq = seq;
+    r.next = c->next;
+    r.room = (uint8_t)(room > 255 ? 255 : room);
+    r.chunk = c->chunk;
+    r.status = (uint8_t)c->status;
+    ChunkLink_Reply(&r, c->out + c->outLen);
+    c->outLen += CHUNK_REPLY_SIZE;
+    if (kind == CHUNK_NAK) c->naks++;
+}
+
+size_t McuChunk_TakeReplies(McuChunk *c, uint8_t *buf, size_t max) {
+    size_t n = c->outLen < max ? c->outLen : max;
+    memcpy(buf, c->out, n);
+    memmove(c->out, c->out + n, c->outLen - n);
+    c->outLen -= n;
+    return n;
+}
+
+static ChunkSlot *Slot(McuChunk *c, uint16_t seq) { return &c->slot[seq % CHUNK_SLOTS]; }
+
+// Bytes of the ring from `start`, which may wrap, into the TAP
+static void Stream(McuChunk *c, uint32_t start, uint32_t n) {
+    uint32_t at = start & (c->ring->size - 1), first = c->ring->size - at < n ? c->ring->size - at : n;
+    Jtag_StreamBytes(c->jtag, c->ring->buf + at, first);
+    if (n > first) Jtag_StreamBytes(c->jtag, c->ring->buf, n - first);
+}
+
+static void Finish(McuChunk *c, uint8_t tail) {
+    Jtag_EndStream(c->jtag, tail);
+    Jtag_FinishConfiguration(c->jtag);
+    c->status = Jtag_ReadStatus(c->jtag) & STATUS_DONE_BIT ? CHUNK_DONE : CHUNK_FAIL;
+}
+
+// The next chunk and every held one after it, in order
+static void Shift(McuChunk *c) {
+    ChunkSlot *s;
+    while (c->status == CHUNK_RUNNING && (s = Slot(c, c->next))->state == SLOT_HELD) {
+        uint32_t at = s->start + CHUNK_HEADER_SIZE;
+        if (s->flags & CHUNK_LAST) {
+            Stream(c, at, s->len - 1u);
+            Finish(c, Byte(c, at + s->len - 1u));
+        } else {
+            Stream(c, at, s->len);
+        }
+        c->shifted += s->len;
+        s->state = SLOT_EMPTY;
+        c->next++;
+    }
+}
+
+// A held chunk the DMA would reach within one more frame is given up
+static void Evict(McuChunk *c) {
+    uint32_t margin = (uint32_t)ChunkLink_FrameSize(c->chunk ? c->chunk : CHUNK_MAX), i;
+    for (i = 0; i < CHUNK_SLOTS; i++) {
+        ChunkSlot *s = &c->slot[i];
+        if (s->state == SLOT_HELD && c->ring->received - s->start > c->ring->size - margin) {
+            s->state = SLOT_NAKED;
+            c->evicted++;
+            Reply(c, CHUNK_NAK, s->seq);
+        }
+    }
+}
+
+// Up to the oldest byte still wanted: a held chunk, or the parse point
+static void Release(McuChunk *c) {
+    uint32_t rel = c->parse, i;
+    for (i = 0; i < CHUNK_SLOTS; i++) {
+        if (c->slot[i].state == SLOT_HELD && (int32_t)(c->slot[i].start - rel) < 0) rel = c->slot[i].start;
+    }
+    if ((int32_t)(rel - c->ring->consumed) > 0) McuRing_Consume(c->ring, rel - c->ring->consumed);
+}
+
+static void Nak(McuChunk *c, uint16_t seq) {
+    ChunkSlot *s = Slot(c, seq);
+    if ((uint16_t)(seq - c->next) >= CHUNK_SLOTS || s->state == SLOT_HELD) return;
+    s->state = SLOT_NAKED;
+    s->seq = seq;
+    Reply(c, CHUNK_NAK, seq);
+}
+
+int McuChunk_Drain(McuChunk *c) {
+    static uint8_t frame[CHUNK_HEADER_SIZE + CHUNK_MAX + CHUNK_CRC_SIZE];
+    for (;;) {
+        ChunkHeader h;
+        ChunkSlot *s;
+        uint32_t avail, size, i;
+        uint16_t ahead;
+        Evict(c);
+        avail = c->ring->received - c->parse;
+        if (avail < CHUNK_HEADER_SIZE) break;
+        for (i = 0; i < CHUNK_HEADER_SIZE; i++) frame[i] = Byte(c, c->parse + i);
+        // Not a frame this ring can hold: look again one byte on
+        if (!ChunkLink_ParseHeader(frame, &h) || (h.len == 0) != !!(h.flags & CHUNK_PROBE) ||
+            ChunkLink_FrameSize(h.len) > c->ring->size / 2) {
+            c->parse++;
+            c->skipped++;
+            continue;
+        }
+        size = (uint32_t)ChunkLink_FrameSize(h.len);
+        if (avail < size) break;
+        for (i = CHUNK_HEADER_SIZE; i < size; i++) frame[i] = Byte(c, c->parse + i);
+        c->frames++;
+        if (!ChunkLink_CheckFrame(frame, &h)) {
+            // The header may be noise too: the next frame could start inside
+            c->badCrc++;
+            if (!(h.flags & CHUNK_PROBE)) Nak(c, h.seq);
+            c->parse++;
+            continue;
+        }
+        s = Slot(c, h.seq);
+        ahead = (uint16_t)(h.seq - c->next);
+        if (h.flags & CHUNK_PROBE) {
+            Reply(c, CHUNK_ACK, h.seq);
+        } else if (c->status != CHUNK_RUNNING || ahead >= 0x8000u ||
+                   (ahead < CHUNK_SLOTS && s->state == SLOT_HELD)) {
+            c->dups++;
+            Reply(c, CHUNK_ACK, h.seq);
+        } else if (ahead < CHUNK_SLOTS) {
+            // Every chunk but the last is the length of the first
+            if ((c->chunk && (h.flags & CHUNK_LAST ? h.len > c->chunk : h.len != c->chunk))) {
+                Finish(c, 0xFF);
+                c->status = CHUNK_FAIL;
+                Reply(c, CHUNK_NAK, h.seq);
+                c->parse += size;
+                continue;
+            }
+            if (!c->chunk && !(h.flags & CHUNK_LAST)) c->chunk = h.len;
+            *s = (ChunkSlot){ SLOT_HELD, h.seq, c->parse, h.len, h.flags };
+            if (ahead) {
+                uint16_t g;
+                c->held++;
+                // Holes behind it that were never asked for
+                for (g = c->next; g != h.seq; g++) {
+                    if (Slot(c, g)->state == SLOT_EMPTY) Nak(c, g);
+                }
+            }
+            Shift(c);
+            Reply(c, CHUNK_ACK, h.seq);
+        }
+        // Past the window: the host's to resend once it has the replies
+        c->parse += size;
+        Release(c);
+    }
+    Release(c);
+    return c->status != CHUNK_RUNNING;
+}
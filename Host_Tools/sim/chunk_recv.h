@@ -0,0 +1,62 @@
+/*
+ * Chunked upload, MCU side
+ * - Stream_Chunked on an McuRing, byte for byte: frames found by their
+ *   magic and header check wherever they start, a chunk shifted only once
+ *   its CRC is good and every chunk before it is in, out-of-order ones
+ *   held in the ring (CHUNK_SLOTS of them) until the hole is filled
+ * - Replies queued in `out` for the link back to the host: ACK for every
+ *   good frame, NAK for a bad CRC and for each hole a later chunk shows
+ * - A held chunk the DMA is about to lap is given up and NAKed; the ring
+ *   is released up to the oldest byte still wanted
+ * - After the last chunk: the trailing commands, then replies only, so a
+ *   host that missed the final ACK still hears DONE
+ */
+
+#ifndef CHUNK_RECV_H
+#define CHUNK_RECV_H
+
+#include "chunk_link.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum { SLOT_EMPTY, SLOT_NAKED, SLOT_HELD } ChunkSlotState;
+
+typedef struct {
+    uint8_t  state;
+    uint16_t seq;
+    uint32_t start;       // Frame's first byte, in ring bytes received
+    uint16_t len, flags;
+} ChunkSlot;
+
+typedef struct {
+    McuRing    *ring;
+    JtagMaster *jtag;
+    uint32_t    parse;        // Next byte to look at, in ring bytes received
+    uint16_t    next;         // Every chunk before it is in the FPGA
+    uint16_t    chunk;        // Length of every chunk but the last (0 until seen)
+    ChunkSlot   slot[CHUNK_SLOTS];
+    ChunkStatus status;
+    uint32_t    shifted;      // Bitstream bytes into the TAP, the last one included
+    // Replies for the host, oldest first
+    uint8_t     out[64 * CHUNK_REPLY_SIZE];
+    size_t      outLen;
+    // chunk_link.Last
+    uint32_t    frames;       // Frames read, good or bad
+    uint32_t    badCrc;
+    uint32_t    skipped;      // Bytes passed over finding a frame
+    uint32_t    naks;
+    uint32_t    dups;         // Chunks that were in already
+    uint32_t    evicted;      // Held chunks given up before the DMA lapped them
+    uint32_t    held;         // Chunks that waited for an earlier one
+} McuChunk;
+
+void McuChunk_Begin(McuChunk *c, McuRing *r, JtagMaster *jtag);   // In Shift-DR
+// Everything the ring has; returns 1 once the last chunk is in and finished
+int  McuChunk_Drain(McuChunk *c);
+// Up to max queued reply bytes, taken off the queue
+size_t McuChunk_TakeReplies(McuChunk *c, uint8_t *buf, size_t max);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Circular DMA receive channel and producer/consumer simulation
+ */
+
+#include "dma_ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void DmaRing_Init(DmaRing *d, uint32_t size) {
+    memset(d, 0, sizeof(*d));
+    d->size = size;
+    d->seq = calloc(size, sizeof(*d->seq));
+    d->ndt = size;
+}
+
+void DmaRing_Free(DmaRing *d) {
+    free(d->seq);
+    d->seq = NULL;
+}
+
+uint32_t DmaRing_WriteIndex(const DmaRing *d) {
+    return d->size - d->ndt;
+}
+
+void DmaRing_Write(DmaRing *d) {
+    d->seq[DmaRing_WriteIndex(d)] = d->written++;
+    d->ndt--;
+    if (d->ndt == d->size / 2) d->htif = 1;
+    if (d->ndt == 0) { d->tcif = 1; d->ndt = d->size; }
+}
+
+uint32_t DmaRing_Poll(DmaRing *d, RingMonitor *m) {
+    int half = d->htif, full = d->tcif;
+    uint32_t w;
+    if (half) d->htif = 0;
+    if (full) d->tcif = 0;
+    w = DmaRing_WriteIndex(d);
+    RingMonitor_Produce(m, w, half, full);
+    return w;
+}
+
+// --- SIMULATION ---
+typedef struct {
+    DmaRing  d;
+    uint64_t byteNs;
+    uint32_t sent;
+    uint32_t total;
+} Producer;
+
+// Every byte whose stop bit has arrived by t
+static void Producer_Until(Producer *p, uint64_t t) {
+    while (p->sent < p->total && (uint64_t)(p->sent + 1) * p->byteNs <= t) {
+        DmaRing_Write(&p->d);
+        p->sent++;
+    }
+}
+
+void RingSim_Run(const RingScenario *s, RingResult *r) {
+    Producer p;
+    uint64_t t = 0;
+    uint32_t readIdx = 0, expect = 0, sinceStall = 0;
+
+    memset(r, 0, sizeof(*r));
+    DmaRing_Init(&p.d, s->ringSize);
+    p.byteNs = 10ull * 1000000000ull / s->baud;
+    p.sent = 0;
+    p.total = s->bytes;
+    RingMonitor_Reset(&r->mon, s->ringSize, 0, 0);
+
+    for (;;) {
+        uint32_t w, n, i;
+
+        Producer_Until(&p, t);
+        w = DmaRing_Poll(&p.d, &r->mon);
+        t += s->pollNs;
+        n = (w + s->ringSize - readIdx) % s->ringSize;
+        for (i = 0; i < n; i++) {
+            uint32_t seq;
+            t += s->drainNs;
+            Producer_Until(&p, t);   // The DMA keeps writing while we drain
+            seq = p.d.seq[readIdx];
+            if (seq > expect) r->trueLost += seq - expect;
+            expect = seq + 1;
+            readIdx = (readIdx + 1) % s->ringSize;
+            if (s->stallEvery && ++sinceStall == s->stallEvery) { sinceStall = 0; t += s->stallNs; }
+        }
+        RingMonitor_Consume(&r->mon, n);
+        r->drained += n;
+
+        if (n == 0 && readIdx == DmaRing_WriteIndex(&p.d)) {
+            if (p.sent == p.total) break;
+            if (t < (uint64_t)(p.sent + 1) * p.byteNs) t = (uint64_t)(p.sent + 1) * p.byteNs;   // Idle until the next byte lands
+        }
+    }
+    if (expect < s->bytes) r->trueLost += s->bytes - expect;
+    r->endNs = t;
+    DmaRing_Free(&p.d);
+}
@@ -0,0 +1,45 @@
+/*
+ * Emulator event queue, host port
+ * - Same single-producer / single-consumer ring as both MSP432 emulators:
+ *   free-running 8-bit head (ISR) and tail (main loop), power-of-two size
+ * - A full ring never blocks the producer; the event is counted in dropped
+ */
+
+#ifndef EVENT_RING_H
+#define EVENT_RING_H
+
+#include <stdint.h>
+
+#define EVENT_RING_MAX 64
+
+typedef struct {
+    uint8_t  buf[EVENT_RING_MAX];
+    uint8_t  size;      // Power of two, <= EVENT_RING_MAX
+    uint8_t  head;      // Written by the producer only
+    uint8_t  tail;      // Written by the consumer only
+    uint32_t dropped;
+} EventRing;
+
+static inline void EventRing_Init(EventRing *q, uint8_t size) {
+    q->size = size; q->head = 0; q->tail = 0; q->dropped = 0;
+}
+
+static inline uint8_t EventRing_Level(const EventRing *q) { return (uint8_t)(q->head - q->tail); }
+
+// Returns 0 when the ring was full and the event was dropped
+static inline int EventRing_Push(EventRing *q, uint8_t e) {
+    if (EventRing_Level(q) == q->size) { q->dropped++; return 0; }
+    q->buf[q->head & (q->size - 1)] = e;
+    q->head++;
+    return 1;
+}
+
+// Returns 0 when empty
+static inline int EventRing_Pop(EventRing *q, uint8_t *e) {
+    if (q->head == q->tail) return 0;
+    *e = q->buf[q->tail & (q->size - 1)];
+    q->tail++;
+    return 1;
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+ * Host-side fan-out bus model
+ */
+
+#include "fanout_bus.h"
+
+#include <string.h>
+
+void FanoutBus_Init(FanoutBus *b, int boards) {
+    int i;
+    memset(b, 0, sizeof(*b));
+    if (boards > FANOUT_MAX) boards = FANOUT_MAX;
+    for (i = 0; i < boards; i++) {
+        TapChain_Init(&b->board[i]);
+        TapChain_AddGowin(&b->board[i]);
+        b->connected[i] = 1;
+    }
+    b->count = boards;
+}
+
+uint8_t FanoutBus_Clock(void *ctx, uint8_t tms, uint8_t tdi) {
+    FanoutBus *b = (FanoutBus *)ctx;
+    uint32_t tdo = 0;
+    int i;
+    for (i = 0; i < b->count; i++) {
+        if (b->connected[i] && TapChain_Clock(&b->board[i], tms, tdi)) tdo |= 1u << i;
+    }
+    b->lastTdo = tdo;
+    b->tckCount++;
+    return (uint8_t)(tdo & 1u);
+}
+
+uint32_t FanoutBus_SampleAll(void *ctx) { return ((FanoutBus *)ctx)->lastTdo; }
+
+uint32_t FanoutBus_Tdo(const FanoutBus *b) {
+    uint32_t tdo = 0;
+    int i;
+    for (i = 0; i < b->count; i++) {
+        if (b->connected[i] && TapChain_Tdo(&b->board[i])) tdo |= 1u << i;
+    }
+    return tdo;
+}
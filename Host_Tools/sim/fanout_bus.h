@@ -0,0 +1,35 @@
+/*
+ * Host-side fan-out bus model
+ * - N boards share TCK/TMS/TDI, each board has its own TDO line
+ * - Each board is a full TapChain, so fan-out and chains combine
+ * - A disconnected board never sees TCK and reads TDO low (pull-down)
+ */
+
+#ifndef FANOUT_BUS_H
+#define FANOUT_BUS_H
+
+#include <stdint.h>
+
+#include "tap_chain.h"
+
+#define FANOUT_MAX 4
+
+typedef struct {
+    TapChain board[FANOUT_MAX];
+    uint8_t  connected[FANOUT_MAX];
+    int      count;
+    uint32_t lastTdo;     // bit k = TDO of board k sampled on the last edge
+    uint64_t tckCount;
+} FanoutBus;
+
+// Every board starts as a single Gowin TAP
+void     FanoutBus_Init(FanoutBus *b, int boards);
+
+// JtagClockFn-compatible: broadcasts the edge, returns board 0's TDO
+uint8_t  FanoutBus_Clock(void *ctx, uint8_t tms, uint8_t tdi);
+uint32_t FanoutBus_SampleAll(void *ctx);
+
+// Bit k = what board k drives on its TDO line right now (low if disconnected)
+uint32_t FanoutBus_Tdo(const FanoutBus *b);
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * Faulty serial link
+ */
+
+#include "fault_link.h"
+
+#include <string.h>
+
+void FaultLink_Init(FaultLink *f, uint32_t seed, uint32_t flipPpm, uint32_t dropPpm, uint32_t burst) {
+    memset(f, 0, sizeof(*f));
+    f->rng = seed ? seed : 1;
+    f->flipPpm = flipPpm;
+    f->dropPpm = dropPpm;
+    f->burst = burst ? burst : 1;
+}
+
+static uint32_t Next(FaultLink *f) {   // xorshift32
+    f->rng ^= f->rng << 13;
+    f->rng ^= f->rng >> 17;
+    f->rng ^= f->rng << 5;
+    return f->rng;
+}
+
+size_t FaultLink_Apply(FaultLink *f, uint8_t *buf, size_t n) {
+    size_t i, kept = 0;
+    for (i = 0; i < n; i++) {
+        uint8_t b = buf[i];
+        if (f->seen++ >= f->skip) {
+            if (!f->dropLeft && f->dropPpm && Next(f) % 1000000u < f->dropPpm) {
+                f->dropLeft = f->burst;
+                f->drops++;
+            }
+            if (f->dropLeft) {
+                f->dropLeft--;
+                f->dropped++;
+                continue;
+            }
+            if (f->flipPpm && Next(f) % 1000000u < f->flipPpm) {
+                b ^= (uint8_t)(1u << (Next(f) & 7u));
+                f->flipped++;
+            }
+        }
+        buf[kept++] = b;
+    }
+    return kept;
+}
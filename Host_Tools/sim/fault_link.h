@@ -0,0 +1,34 @@
+/*
+ * Faulty serial link
+ * - What a flaky USB hub does to the bytes between the host and USART2:
+ *   a bit flipped here and there, and runs of bytes lost (a dropped USB
+ *   packet is up to 64)
+ * - Applied in place to whatever one side read, before the other side
+ *   sees it; the same seed gives the same faults for the same byte count
+ */
+
+#ifndef FAULT_LINK_H
+#define FAULT_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    uint32_t rng;
+    uint32_t flipPpm;     // Per byte: one bit flipped
+    uint32_t dropPpm;     // Per byte: a run of `burst` bytes lost from here
+    uint32_t burst;
+    uint64_t skip;        // Bytes let through untouched first
+    uint32_t dropLeft;
+    // Counters
+    uint64_t seen;
+    uint32_t flipped;
+    uint32_t dropped;     // Bytes
+    uint32_t drops;       // Runs
+} FaultLink;
+
+void   FaultLink_Init(FaultLink *f, uint32_t seed, uint32_t flipPpm, uint32_t dropPpm, uint32_t burst);
+// Returns the bytes left in buf
+size_t FaultLink_Apply(FaultLink *f, uint8_t *buf, size_t n);
+
+#endif
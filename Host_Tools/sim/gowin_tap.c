@@ -0,0 +1,154 @@
+/*
+ * Host-side Gowin GW1NR-9 TAP model
+ * - Same transitions and Gowin status emulation as JTAG_Emulator/main.c
+ */
+
+#include "gowin_tap.h"
+
+#include <string.h>
+
+static void Count(GowinTap *t, EventType e) {
+    t->eventCount[e]++;
+    t->lastEvent = e;
+}
+
+static void Enqueue(GowinTap *t, EventType e) {
+    Count(t, e);
+    EventRing_Push(&t->log, (uint8_t)e);
+}
+
+static void Drive_TDO(GowinTap *t, uint32_t buf) { t->tdo = (uint8_t)(buf & 0x01); }
+
+void GowinTap_Init(GowinTap *t) {
+    memset(t, 0, sizeof(*t));
+    t->tapState = TAP_RESET;
+    t->protoState = PROTO_IDLE;
+    t->lastCmd = CMD_IDCODE;
+    EventRing_Init(&t->log, 64);
+}
+
+uint8_t GowinTap_Clock(GowinTap *t, uint8_t tms, uint8_t tdi) {
+    uint8_t sampled = t->tdo;
+
+    if (tms) {
+        t->tmsHighCount++;
+        if (t->tmsHighCount == 5) {
+            t->tapState = TAP_RESET; t->protoState = PROTO_IDLE; t->streamCount = 0;
+            t->lastCmd = CMD_IDCODE; t->isEditMode = 0; t->isDone = 0; t->erasePollCount = 0;
+            t->leds |= LED_PROG_1;
+            Enqueue(t, EVT_RESET_TAP);
+        }
+        if (t->tmsHighCount >= 5) return sampled;
+    } else { t->tmsHighCount = 0; }
+
+    switch (t->tapState) {
+        case TAP_RESET:      t->tapState = (tms ? TAP_RESET : TAP_IDLE); break;
+        case TAP_IDLE:       t->tapState = (tms ? TAP_SELECT_DR : TAP_IDLE); break;
+        case TAP_SELECT_DR:  t->tapState = (tms ? TAP_SELECT_IR : TAP_CAPTURE_DR); break;
+
+        case TAP_CAPTURE_DR:
+            t->tapState = (tms ? TAP_EXIT1_DR : TAP_SHIFT_DR);
+            t->streamCount = 0;
+
+            if (t->lastCmd == CMD_IDCODE) {
+                t->drShiftBuf = GOWIN_ID_VAL;
+            } else if (t->lastCmd == CMD_READ_STATUS) {
+                t->drShiftBuf = 0x00019000; // Base Status
+                if (t->isEditMode) t->drShiftBuf |= 0x00000080;
+                if (t->protoState == PROTO_ERASING) {
+                    t->drShiftBuf |= 0x00000020;
+                    if (++t->erasePollCount > 3) t->protoState = PROTO_ERASE_WAIT_09;
+                }
+                if (t->isDone) t->drShiftBuf |= 0x00002000;
+            } else {
+                t->drShiftBuf = 0;
+            }
+            Drive_TDO(t, t->drShiftBuf);
+            break;
+
+        case TAP_SHIFT_DR:
+            t->tapState = (tms ? TAP_EXIT1_DR : TAP_SHIFT_DR);
+
+            if (t->lastCmd == CMD_IDCODE || t->lastCmd == CMD_READ_STATUS) {
+                t->drShiftBuf = (t->drShiftBuf >> 1) | ((uint32_t)tdi << 31);
+            } else { t->drShiftBuf = tdi; }
+
+            if (t->lastCmd == CMD_WRITE) t->streamCount++;
+            Drive_TDO(t, t->drShiftBuf);
+            break;
+
+        case TAP_EXIT1_DR:   t->tapState = (tms ? TAP_UPDATE_DR : TAP_PAUSE_DR); break;
+        case TAP_PAUSE_DR:   t->tapState = (tms ? TAP_EXIT2_DR  : TAP_PAUSE_DR); break;
+        case TAP_EXIT2_DR:   t->tapState = (tms ? TAP_UPDATE_DR : TAP_SHIFT_DR); break;
+
+        case TAP_UPDATE_DR:
+            t->tapState = (tms ? TAP_SELECT_DR : TAP_IDLE);
+            if (t->lastCmd == CMD_WRITE) {
+                t->diagStreamBits = t->streamCount;
+                if (t->streamCount > MIN_STREAM_BITS) {
+                    t->isDone = 1;
+                    if (t->protoState == PROTO_ERASED) {
+                        t->leds |= LED_PROG_5; Enqueue(t, EVT_DATA_BITSTREAM_DONE);
+                    } else {
+                        t->leds |= LED_FAIL; Enqueue(t, EVT_ERR_PROTOCOL);
+                    }
+                } else { t->leds |= LED_FAIL; Enqueue(t, EVT_ERR_BITSTREAM_TINY); }
+            } else if (t->lastCmd == CMD_IDCODE) {
+                t->leds |= LED_PROG_2;
+                Enqueue(t, EVT_DATA_ID_READ);
+            }
+            break;
+
+        case TAP_SELECT_IR:  t->tapState = (tms ? TAP_RESET : TAP_CAPTURE_IR); break;
+        case TAP_CAPTURE_IR:
+            t->tapState = (tms ? TAP_EXIT1_IR : TAP_SHIFT_IR);
+            t->irShiftBuf = 0x01;
+            Drive_TDO(t, t->irShiftBuf);
+            break;
+
+        case TAP_SHIFT_IR:
+            t->irShiftBuf = (uint8_t)((t->irShiftBuf >> 1) | (tdi << 7));
+            t->tapState = (tms ? TAP_EXIT1_IR : TAP_SHIFT_IR);
+            Drive_TDO(t, t->irShiftBuf);
+            break;
+
+        case TAP_EXIT1_IR:   t->tapState = (tms ? TAP_UPDATE_IR : TAP_PAUSE_IR); break;
+        case TAP_PAUSE_IR:   t->tapState = (tms ? TAP_EXIT2_IR  : TAP_PAUSE_IR); break;
+        case TAP_EXIT2_IR:   t->tapState = (tms ? TAP_UPDATE_IR : TAP_SHIFT_IR); break;
+
+        case TAP_UPDATE_IR:
+            t->tapState = (tms ? TAP_SELECT_DR : TAP_IDLE);
+            if (t->irShiftBuf != CMD_NOOP) {
+                uint8_t ir = t->irShiftBuf;
+
+                if (ir == CMD_ENABLE) { t->isEditMode = 1; Enqueue(t, EVT_CMD_ENABLE); }
+                else if (ir == CMD_DISABLE) { t->isEditMode = 0; Enqueue(t, EVT_CMD_DISABLE); }
+                else if (ir == CMD_IDCODE) { t->leds |= LED_PROG_2; Enqueue(t, EVT_CMD_IDCODE); }
+                else if (ir == CMD_ERASE) {
+                    t->protoState = PROTO_ERASING; t->erasePollCount = 0; t->erasePolls = 0; t->isDone = 0;
+                    t->leds |= LED_PROG_3; Enqueue(t, EVT_CMD_ERASE);
+                }
+                else if (ir == CMD_ERASE_DONE) {
+                    if (t->protoState == PROTO_ERASING || t->protoState == PROTO_ERASE_WAIT_09) t->protoState = PROTO_ERASED;
+                    t->diagErasePolls = t->erasePolls;
+                    t->leds |= LED_PROG_4; Enqueue(t, EVT_CMD_ERASE_DONE);
+                }
+                else if (ir == CMD_WRITE) { t->streamCount = 0; Enqueue(t, EVT_CMD_WRITE); }
+                else if (ir == CMD_INIT_ADDR) Enqueue(t, EVT_CMD_INIT);
+                else if (ir == CMD_READ_STATUS) {
+                    if (t->protoState == PROTO_ERASING || t->protoState == PROTO_ERASE_WAIT_09) t->erasePolls++;
+                    // Every poll is counted; only the first of a run is logged
+                    if (t->lastCmd != CMD_READ_STATUS) Enqueue(t, EVT_CMD_STATUS); else Count(t, EVT_CMD_STATUS);
+                }
+                else if (ir == CMD_BYPASS || ir == CMD_BYPASS_ALL || ir == CMD_USER_MODE) {} // Silent whitelist
+                else if (ir == CMD_REPROGRAM) {}
+                else { t->diagUnknownCmd = ir; Enqueue(t, EVT_CMD_UNKNOWN); }
+
+                t->lastCmd = ir;
+            }
+            break;
+    }
+    return sampled;
+}
+
+uint8_t GowinTap_ClockFn(void *tap, uint8_t tms, uint8_t tdi) { return GowinTap_Clock((GowinTap *)tap, tms, tdi); }
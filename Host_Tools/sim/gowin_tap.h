@@ -0,0 +1,92 @@
+/*
+ * Host-side Gowin GW1NR-9 TAP model
+ * - Port of the MSP432 JTAG_Emulator PORT5_IRQHandler to plain C
+ * - One GowinTap = one TAP; clock it once per TCK rising edge
+ * - LED progress bits and events are kept in the struct instead of Port 4 / UART;
+ *   the log queue is the emulator's 64-entry ring, counts are exact
+ */
+
+#ifndef GOWIN_TAP_H
+#define GOWIN_TAP_H
+
+#include "event_ring.h"
+
+#include <stdint.h>
+
+// --- LED PROGRESS BAR (same bits as the emulator's Port 4) ---
+#define LED_PROG_1 0x01  // Reset
+#define LED_PROG_2 0x02  // ID Checked
+#define LED_PROG_3 0x04  // Erase Started
+#define LED_PROG_4 0x08  // Erase Done
+#define LED_PROG_5 0x10  // Write & Bitstream Complete (PASS)
+#define LED_FAIL   0x20  // Error Detected
+
+// --- GOWIN COMMANDS ---
+#define CMD_IDCODE      0x11
+#define CMD_ERASE       0x05
+#define CMD_ERASE_DONE  0x09
+#define CMD_WRITE       0x17
+#define CMD_NOOP        0x02
+#define CMD_ENABLE      0x15
+#define CMD_INIT_ADDR   0x12
+#define CMD_DISABLE     0x3A
+#define CMD_REPROGRAM   0x3C
+#define CMD_READ_STATUS 0x41
+#define CMD_BYPASS      0x08
+#define CMD_USER_MODE   0x0A
+#define CMD_BYPASS_ALL  0xFF  // IEEE 1149.1 mandatory all-ones BYPASS
+
+#define MIN_STREAM_BITS 100000
+#define GOWIN_ID_VAL    0x1100481B
+
+// --- 16-STATE TAP MACHINE ---
+typedef enum {
+    TAP_RESET=0, TAP_IDLE=1, TAP_SELECT_DR=2, TAP_CAPTURE_DR=3,
+    TAP_SHIFT_DR=4, TAP_EXIT1_DR=5, TAP_PAUSE_DR=6, TAP_EXIT2_DR=7,
+    TAP_UPDATE_DR=8, TAP_SELECT_IR=9, TAP_CAPTURE_IR=10, TAP_SHIFT_IR=11,
+    TAP_EXIT1_IR=12, TAP_PAUSE_IR=13, TAP_EXIT2_IR=14, TAP_UPDATE_IR=15
+} TapState;
+
+// --- PROTOCOL TRACKER ---
+typedef enum { PROTO_IDLE=0, PROTO_ERASING, PROTO_ERASE_WAIT_09, PROTO_ERASED, PROTO_WRITING } ProtocolState;
+
+// --- EVENTS (same ids as the emulator's queue) ---
+typedef enum {
+    EVT_NONE=0, EVT_RESET_TAP, EVT_CMD_IDCODE, EVT_CMD_ENABLE, EVT_CMD_ERASE,
+    EVT_CMD_ERASE_DONE, EVT_CMD_INIT, EVT_CMD_WRITE, EVT_CMD_DISABLE,
+    EVT_CMD_STATUS, EVT_CMD_UNKNOWN, EVT_DATA_ID_READ, EVT_DATA_BITSTREAM_DONE,
+    EVT_ERR_BITSTREAM_TINY, EVT_ERR_PROTOCOL, EVT_COUNT
+} EventType;
+
+typedef struct {
+    TapState      tapState;
+    ProtocolState protoState;
+    uint8_t       irShiftBuf;
+    uint32_t      drShiftBuf;
+    uint8_t       lastCmd;
+    uint32_t      streamCount;
+    int           tmsHighCount;
+    uint8_t       isEditMode;
+    uint8_t       isDone;
+    uint8_t       erasePollCount;
+    uint32_t      erasePolls;   // Status polls since ERASE
+    uint8_t       tdo;          // Level currently driven on TDO
+
+    // Diagnostics
+    uint8_t       leds;
+    uint8_t       diagUnknownCmd;
+    uint32_t      diagStreamBits;
+    uint32_t      diagErasePolls;
+    uint32_t      eventCount[EVT_COUNT];
+    EventType     lastEvent;
+    EventRing     log;          // What the main loop would print
+} GowinTap;
+
+void    GowinTap_Init(GowinTap *t);
+
+// One TCK rising edge. Returns the TDO level the master samples on this edge
+// (i.e. the value driven before the edge is processed).
+uint8_t GowinTap_Clock(GowinTap *t, uint8_t tms, uint8_t tdi);
+uint8_t GowinTap_ClockFn(void *tap, uint8_t tms, uint8_t tdi);   // As a JtagClockFn
+
+#endif
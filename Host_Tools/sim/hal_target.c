@@ -0,0 +1,90 @@
+/*
+ * Pin-level target for the host build of the programmer firmware
+ */
+
+#include "hal_target.h"
+
+#include <time.h>
+
+static FanoutBus  bus;
+static uint8_t   pin[8];
+static RvDm      dm;
+static int       debugWired;   // Debug TAP behind board 1
+static int       debugLive;    // ... and the pins are now its
+static SspiTarget sspi;
+static int        sspiLive;    // SPI1 in mode 0 on the SSPI lines
+
+void HalTarget_Init(int boards) {
+    int i;
+    FanoutBus_Init(&bus, boards < 1 ? 1 : boards);
+    for (i = 0; i < 8; i++) pin[i] = 0;
+    debugWired = debugLive = 0;
+    SspiTarget_Init(&sspi);
+    sspiLive = 0;
+}
+
+void HalTarget_UseDebug(int sba) {
+    RvDm_Init(&dm, sba, 0);
+    debugWired = 1;
+    debugLive = 0;
+}
+
+RvDm *HalTarget_Debug(void) { return debugLive ? &dm : 0; }
+
+static void Clock(uint8_t tms, uint8_t tdi) {
+    GowinTap *g;
+    if (debugLive) { RvDm_Clock(&dm, tms, tdi); return; }
+    FanoutBus_Clock(&bus, tms, tdi);
+    g = TapChain_Gowin(&bus.board[0], 0);
+    // Configured (PASS latched), then Test-Logic-Reset: the core's TAP,
+    // itself still in reset, has the pins from the next edge on
+    if (debugWired && g && (g->leds & LED_PROG_5) && g->tapState == TAP_RESET) debugLive = 1;
+}
+
+void HalTarget_Pin(int p, int high) {
+    uint8_t level = high ? 1 : 0;
+    if (p < 0 || p > 7 || p == HAL_PIN_TDO) return;
+    if (p == HAL_PIN_TCK && level && !pin[HAL_PIN_TCK]) {
+        Clock(pin[HAL_PIN_TMS], pin[HAL_PIN_TDI]);
+    }
+    pin[p] = level;
+}
+
+int HalTarget_PinRead(int p) {
+    if (p == HAL_PIN_TDO) return debugLive ? dm.tdo : (int)(FanoutBus_Tdo(&bus) & 1u);
+    return (p >= 0 && p <= 7) ? pin[p] : 0;
+}
+
+uint32_t HalTarget_TdoLines(void) { return FanoutBus_Tdo(&bus); }
+
+static uint64_t Now_Ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+uint8_t HalTarget_SpiTransfer(uint8_t data) {
+    uint8_t in = 0;
+    int i;
+    if (sspiLive) return SspiTarget_Transfer(&sspi, data, Now_Ns());
+    for (i = 7; i >= 0; i--) {
+        HalTarget_Pin(HAL_PIN_TCK, 0);
+        HalTarget_Pin(HAL_PIN_TDI, (data >> i) & 1u);
+        in = (uint8_t)(in << 1 | HalTarget_PinRead(HAL_PIN_TDO));
+        HalTarget_Pin(HAL_PIN_TCK, 1);
+    }
+    return in;
+}
+
+void HalTarget_SpiByte(uint8_t data) { (void)HalTarget_SpiTransfer(data); }
+
+void HalTarget_SpiRelease(void) { sspiLive = 0; }
+
+void HalTarget_SspiEnable(void) { sspiLive = 1; }
+void HalTarget_SspiSelect(int csLow) { SspiTarget_Select(&sspi, csLow ? 1 : 0); }
+void HalTarget_SspiReconfig(int level) { SspiTarget_Reconfig(&sspi, level ? 1 : 0); }
+int  HalTarget_SspiReady(void) { return sspi.ready; }
+int  HalTarget_SspiDone(void) { return sspi.done; }
+SspiTarget *HalTarget_Sspi(void) { return &sspi; }
+
+FanoutBus *HalTarget_Bus(void) { return &bus; }
@@ -0,0 +1,61 @@
+/*
+ * Pin-level target for the host build of the programmer firmware
+ * - The C side of src/hal/host/hal.adb in both programmers
+ * - GPIOA pin numbers as in utils.ads: TMS 4, TCK 5, TDO 6, TDI 7
+ * - A FanoutBus clocks on every TCK 0 -> 1 written through HalTarget_Pin
+ * - Optionally the NEORV32 debug TAP (RvDm) behind board 1: a design built
+ *   with the JTAG pins as regular IO hands them to the core once it is
+ *   configured, modelled as the first Test-Logic-Reset after DONE
+ * - An SSPI target (sim/sspi_target.h) on the slave serial lines: from
+ *   HalTarget_SspiEnable to HalTarget_SpiRelease, SPI1 bytes are its, in
+ *   mode 0, timed by CLOCK_MONOTONIC as the firmware's delays are
+ * - One instance per process, like the board it stands in for
+ */
+
+#ifndef HAL_TARGET_H
+#define HAL_TARGET_H
+
+#include <stdint.h>
+
+#include "fanout_bus.h"
+#include "riscv_dm.h"
+#include "sspi_target.h"
+
+#define HAL_PIN_TMS 4
+#define HAL_PIN_TCK 5
+#define HAL_PIN_TDO 6
+#define HAL_PIN_TDI 7
+
+// Fresh bus of Gowin TAPs, pins at main's reset levels (all low)
+void       HalTarget_Init(int boards);
+
+// Output pins latch; TDO and unknown pins ignore writes
+void       HalTarget_Pin(int pin, int high);
+int        HalTarget_PinRead(int pin);
+
+// hal.TDO_Lines: bit k = TDO of fan-out board k
+uint32_t   HalTarget_TdoLines(void);
+
+// SPI1 mode 3, MSB first: eight TCK edges with TMS held, TCK left high.
+// Transfer returns what came back: TDO before each rising edge, or the
+// SSPI target's MISO byte while it has the lines
+void       HalTarget_SpiByte(uint8_t data);
+uint8_t    HalTarget_SpiTransfer(uint8_t data);
+void       HalTarget_SpiRelease(void);   // SPI1 off: the pins are the TAPs' again
+
+// hal.SSPI_*: the SSPI target takes SPI1 until HalTarget_SpiRelease
+void        HalTarget_SspiEnable(void);
+void        HalTarget_SspiSelect(int csLow);
+void        HalTarget_SspiReconfig(int level);
+int         HalTarget_SspiReady(void);
+int         HalTarget_SspiDone(void);
+SspiTarget *HalTarget_Sspi(void);
+
+FanoutBus *HalTarget_Bus(void);
+
+// After HalTarget_Init: put the debug TAP behind board 1 (sba: system bus
+// access implemented). The pins stay the Gowin TAP's until the handover
+void       HalTarget_UseDebug(int sba);
+RvDm      *HalTarget_Debug(void);     // NULL unless the pins belong to it
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Host-side port of the JTAG emulator's trace capture
+ */
+
+#include "jtag_capture.h"
+#include "gowin_tap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void JtagCapture_Init(JtagCapture *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+void JtagCapture_Free(JtagCapture *c) {
+    free(c->buf);
+    memset(c, 0, sizeof(*c));
+}
+
+static void Write(JtagCapture *c, uint8_t id, uint32_t ts, uint32_t arg) {
+    if (c->len + LOG_MAX_RECORD > c->cap) {
+        c->cap = c->cap ? c->cap * 2 : 4096;
+        c->buf = realloc(c->buf, c->cap);
+    }
+    c->len += Log_Encode(c->buf + c->len, id, ts - c->lastLogTs, arg);
+    c->lastLogTs = ts;
+    c->records++;
+}
+
+void JtagCapture_Boot(JtagCapture *c, uint32_t ts) {
+    Write(c, LOG_ID_BOOT, ts, LOG_SRC_JTAG | LOG_SRC_TRACE);
+}
+
+int Trace_Foldable(uint8_t state) {
+    return state == TAP_RESET || state == TAP_IDLE || state == TAP_SHIFT_DR || state == TAP_PAUSE_DR || state == TAP_PAUSE_IR;
+}
+
+static void Emit(JtagCapture *c) {
+    TraceRun *run = &c->run;
+    if (run->count == 1) {
+        Write(c, LOG_ID_TRACE_EDGE, run->ts, run->sig | ((uint32_t)run->state << 3) | (run->highBad ? 0 : run->high << 7));
+    } else if (run->count) {
+        Write(c, LOG_ID_TRACE_RUN, run->ts, run->state | ((uint32_t)(run->sig & 1) << 4) | (run->count << 5));
+        Write(c, LOG_ID_TRACE_SPAN, run->last, run->highBad ? 0 : run->high);
+    }
+    run->count = 0;
+}
+
+// A pause longer than 1 ms or 4 average periods starts a new run
+static void Add(JtagCapture *c, const TraceEdge *e) {
+    TraceRun *run = &c->run;
+    uint32_t gap = e->ts - run->last;
+    if (run->count && e->state == run->state && (e->sig & 1) == (run->sig & 1) && Trace_Foldable(e->state)
+        && gap <= TRACE_IDLE_TICKS && (run->count == 1 || (uint64_t)gap * (run->count - 1) <= 4ULL * (run->last - run->ts))) {
+        if (run->count == 1) { run->high = 0; run->highBad = 0; }
+        if (e->high == 0 || e->high >= gap) run->highBad = 1;
+        run->high += e->high; run->last = e->ts; run->count++;
+        return;
+    }
+    Emit(c);
+    run->ts = run->last = e->ts; run->count = 1; run->sig = e->sig; run->state = e->state;
+    run->high = e->high; run->highBad = (e->high == 0 || e->high >= gap);
+}
+
+void JtagCapture_Edge(JtagCapture *c, uint32_t ts, uint8_t tms, uint8_t tdi, uint8_t tdo, uint8_t state, uint16_t high) {
+    TraceEdge e;
+    e.ts = ts; e.high = high; e.sig = (uint8_t)(tms | (tdi << 1) | (tdo << 2)); e.state = state;
+    Add(c, &e);
+}
+
+void JtagCapture_Event(JtagCapture *c, uint32_t ts, uint8_t id, uint32_t arg) {
+    Emit(c);
+    Write(c, id, ts, arg);
+}
+
+void JtagCapture_Flush(JtagCapture *c) {
+    Emit(c);
+}
@@ -0,0 +1,48 @@
+/*
+ * Host-side port of the JTAG emulator's trace capture
+ * - Same folding as the emulator's main loop (Trace_Add / Trace_Emit):
+ *   edges with one TMS level in a stable TAP state become a RUN + SPAN pair,
+ *   everything else is one EDGE record
+ * - Output is the emulator's byte stream (log_record.h), events included,
+ *   so the host decoder and bin/jtag_vcd can be tested without a board
+ */
+
+#ifndef JTAG_CAPTURE_H
+#define JTAG_CAPTURE_H
+
+#include "log_record.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRACE_IDLE_TICKS (LOG_TICK_HZ / 1000)
+
+typedef struct { uint32_t ts; uint16_t high; uint8_t sig; uint8_t state; } TraceEdge; // sig = TMS | TDI << 1 | TDO << 2
+typedef struct { uint32_t ts, last, high, count; uint8_t sig, state, highBad; } TraceRun;
+
+typedef struct {
+    TraceRun run;
+    uint32_t lastLogTs;
+    uint8_t *buf;              // Encoded records, grows as needed
+    size_t   len, cap;
+    uint32_t records;
+} JtagCapture;
+
+void JtagCapture_Init(JtagCapture *c);
+void JtagCapture_Free(JtagCapture *c);
+
+// Boot record (LOG_SRC_JTAG | LOG_SRC_TRACE)
+void JtagCapture_Boot(JtagCapture *c, uint32_t ts);
+
+// One TCK rising edge; state is the TAP state the edge is clocked in
+void JtagCapture_Edge(JtagCapture *c, uint32_t ts, uint8_t tms, uint8_t tdi, uint8_t tdo, uint8_t state, uint16_t high);
+
+// An emulator event at ts: closes the open run first, as Trace_Step does
+void JtagCapture_Event(JtagCapture *c, uint32_t ts, uint8_t id, uint32_t arg);
+
+// End of capture (the emulator's 1 ms idle close)
+void JtagCapture_Flush(JtagCapture *c);
+
+int  Trace_Foldable(uint8_t state);
+
+#endif
@@ -0,0 +1,241 @@
+/*
+ * A station's worth of programmers on pseudo-terminals
+ */
+
+#include "mcu_farm.h"
+#include "chunk_recv.h"
+#include "gowin_tap.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+#include "session_image.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef enum { FARM_COMMAND, FARM_UPLOAD, FARM_LINGER, FARM_GONE } FarmState;
+typedef enum { KIND_UNKNOWN, KIND_CHUNKS, KIND_PUMP } UploadKind;
+
+typedef struct {
+    int        fd;
+    FarmState  state;
+    char       line[64];
+    size_t     lineLen;
+    GowinTap   tap;
+    JtagMaster jtag;
+    McuRing    ring;
+    McuChunk   m;
+    McuPump    pump;          // Anything but chunk frames
+    uint8_t   *stage;         // hal.Stage_Base, SESSION_STAGE_SIZE
+    UploadKind kind;          // Told by the first four bytes
+    uint32_t   in;            // Upload bytes received
+    double     start, until;
+} FarmBoard;
+
+static double Now_Ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+static void Put(int fd, const char *text) {
+    if (write(fd, text, strlen(text)) < 0 && errno != EAGAIN) return;
+}
+
+static void Publish(FarmBoard *b, McuFarmBoard *out) {
+    int pump = b->kind == KIND_PUMP;
+    out->status = pump ? 0 : b->m.status;
+    out->shifted = pump ? b->pump.sent : b->m.shifted;
+    out->streamBits = b->tap.diagStreamBits;
+    out->frames = pump ? b->pump.frames : b->m.frames;
+    out->naks = pump ? 0 : b->m.naks;
+    out->staged = pump ? b->pump.staged : 0;
+    out->done = (b->tap.leds & LED_PROG_5) != 0;
+}
+
+// H2M: one line; `config` runs INIT_CONFIG and opens the stream
+static void Command(const McuFarmConfig *c, FarmBoard *b, McuFarmBoard *out, const char *line) {
+    if (strcmp(line, "config") != 0) {
+        Put(b->fd, "Unknown command: ");
+        Put(b->fd, line);
+        Put(b->fd, "\r\n");
+        return;
+    }
+    out->configs++;
+    Put(b->fd, "Initialize FPGA configuration\r\n");
+    GowinTap_Init(&b->tap);
+    Jtag_Init(&b->jtag, GowinTap_ClockFn, &b->tap);
+    Jtag_ResetTap(&b->jtag);
+    Jtag_InitConfiguration(&b->jtag);
+    McuRing_Init(&b->ring, c->ringSize);
+    b->kind = KIND_UNKNOWN;
+    b->in = 0;
+    b->start = Now_Ms();
+    b->state = FARM_UPLOAD;
+    Put(b->fd, "Send Configuration Bitstream\r\nConfiguring FPGA\r\n");
+}
+
+static void Serve_Command(const McuFarmConfig *c, FarmBoard *b, McuFarmBoard *out, int deaf) {
+    char buf[64];
+    ssize_t n, i;
+    // Not a byte past the command that starts an upload: the rest is the ring's
+    while (b->state == FARM_COMMAND && (n = read(b->fd, buf, sizeof(buf))) > 0) {
+        for (i = 0; i < n && !deaf && b->state == FARM_COMMAND; i++) {
+            if (buf[i] == '\r' || buf[i] == '\n') {
+                if (!b->lineLen) continue;
+                b->line[b->lineLen] = 0;
+                b->lineLen = 0;
+                Command(c, b, out, b->line);
+            } else if (b->lineLen < sizeof(b->line) - 1) {
+                b->line[b->lineLen++] = buf[i];
+            }
+        }
+    }
+}
+
+// Chunk frames open with their magic; anything else is the pump's, as
+// Send_Configuration_Bitstream sorts them
+static void Choose(FarmBoard *b) {
+    uint32_t avail;
+    const uint8_t *p = McuRing_ReadSpan(&b->ring, &avail);
+    if (McuRing_Level(&b->ring) < 4) return;
+    if (avail >= 4 && (p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24) == CHUNK_MAGIC) {
+        McuChunk_Begin(&b->m, &b->ring, &b->jtag);
+        b->kind = KIND_CHUNKS;
+        return;
+    }
+    if (!b->stage && !(b->stage = malloc(SESSION_STAGE_SIZE))) _exit(1);
+    McuPump_Begin(&b->pump, &b->ring, &b->jtag);
+    McuPump_SetStage(&b->pump, b->stage, SESSION_STAGE_SIZE);
+    b->kind = KIND_PUMP;
+}
+
+static void Put_Report(const McuFarmConfig *c, FarmBoard *b) {
+    char line[200];
+    unsigned us = (unsigned)((b->until - c->lingerMs - b->start) * 1000.0);
+    if (b->kind == KIND_PUMP)
+        snprintf(line, sizeof(line),
+                 "session frames %u staged %u staged_us %u done_us %u upload_us 0 total_us %u %s\r\n",
+                 b->pump.frames, b->pump.staged, us, us, us,
+                 b->pump.badFrame ? "BAD_FRAME" : (b->tap.leds & LED_PROG_5) ? "DONE" : "FAIL");
+    else
+        snprintf(line, sizeof(line),
+                 "chunks frames %u bytes %u bad_crc %u skipped %u nak %u dup %u held %u evicted %u us %u %s\r\n",
+                 b->m.frames, b->m.shifted, b->m.badCrc, b->m.skipped, b->m.naks, b->m.dups, b->m.held,
+                 b->m.evicted, us, b->m.status == CHUNK_DONE ? "DONE" : "FAIL");
+    Put(b->fd, line);
+}
+
+// USART2 RX into DMA_Buffer, the chunks (or the pump) drained, the replies back
+static void Serve_Upload(const McuFarmConfig *c, FarmBoard *b, McuFarmBoard *out, int hangup) {
+    uint8_t buf[sizeof(b->m.out)];
+    size_t n = 0;
+    int finished;
+    for (;;) {
+        uint32_t room;
+        uint8_t *dst = McuRing_WriteSpan(&b->ring, &room);
+        ssize_t got;
+        if (room == 0) break;
+        if ((got = read(b->fd, dst, room)) <= 0) break;
+        McuRing_Commit(&b->ring, (uint32_t)got);
+        b->in += (uint32_t)got;
+    }
+    if (hangup && b->in >= c->hangupAfter) {
+        Publish(b, out);
+        close(b->fd);
+        b->state = FARM_GONE;
+        return;
+    }
+    if (b->kind == KIND_UNKNOWN) Choose(b);
+    if (b->kind == KIND_CHUNKS) {
+        finished = McuChunk_Drain(&b->m);
+        n = McuChunk_TakeReplies(&b->m, buf, sizeof(buf));
+    } else if (b->kind == KIND_PUMP) {
+        McuPump_Drain(&b->pump);
+        if ((finished = b->state == FARM_UPLOAD && McuPump_BodyDone(&b->pump))) McuPump_Finish(&b->pump);
+    } else {
+        finished = 0;
+    }
+    if (finished && b->state == FARM_UPLOAD) {
+        b->state = FARM_LINGER;
+        b->until = Now_Ms() + c->lingerMs;
+    }
+    // A full pty drops them, as a host that stopped reading would
+    if (n > 0 && write(b->fd, buf, n) < 0 && errno != EAGAIN) return;
+    if (b->state == FARM_LINGER && Now_Ms() >= b->until) {
+        Publish(b, out);
+        Put_Report(c, b);
+        McuRing_Free(&b->ring);
+        b->state = FARM_COMMAND;
+    }
+}
+
+static void Child(const McuFarmConfig *c, McuFarm *f) {
+    FarmBoard *b = calloc((size_t)f->boards, sizeof(*b));
+    struct pollfd p[MCU_FARM_MAX];
+    pid_t parent = getppid();
+    int i;
+    if (!b) _exit(1);
+    for (i = 0; i < f->boards; i++) {
+        b[i].fd = f->link[i].master;
+        close(f->link[i].slave);
+    }
+    while (getppid() == parent) {
+        for (i = 0; i < f->boards; i++) {
+            p[i].fd = b[i].state == FARM_GONE ? -1 : b[i].fd;
+            p[i].events = POLLIN;
+        }
+        poll(p, (nfds_t)f->boards, 2);
+        for (i = 0; i < f->boards; i++) {
+            if (b[i].state == FARM_COMMAND) Serve_Command(c, &b[i], &f->board[i], (int)((c->deaf >> i) & 1));
+            else if (b[i].state != FARM_GONE) Serve_Upload(c, &b[i], &f->board[i], (int)((c->hangup >> i) & 1));
+        }
+    }
+    _exit(0);
+}
+
+int McuFarm_Start(McuFarm *f, const McuFarmConfig *c) {
+    int i;
+    memset(f, 0, sizeof(*f));
+    f->pid = -1;
+    if (c->boards < 1 || c->boards > MCU_FARM_MAX) return -1;
+    for (i = 0; i < c->boards; i++) {
+        if (PtyLink_Open(&f->link[i]) < 0) { McuFarm_Free(f); return -1; }
+        f->boards = i + 1;
+    }
+    f->board = mmap(NULL, MCU_FARM_MAX * sizeof(*f->board), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (f->board == MAP_FAILED) { f->board = NULL; McuFarm_Free(f); return -1; }
+    memset(f->board, 0, MCU_FARM_MAX * sizeof(*f->board));
+    if ((f->pid = fork()) < 0) { McuFarm_Free(f); return -1; }
+    if (f->pid == 0) Child(c, f);
+    // The child has the device ends; a hangup there must reach the host
+    for (i = 0; i < f->boards; i++) {
+        close(f->link[i].master);
+        f->link[i].master = -1;
+    }
+    return 0;
+}
+
+void McuFarm_Stop(McuFarm *f) {
+    int status;
+    if (f->pid <= 0) return;
+    kill(f->pid, SIGKILL);
+    waitpid(f->pid, &status, 0);
+    f->pid = -1;
+}
+
+void McuFarm_Free(McuFarm *f) {
+    int i;
+    McuFarm_Stop(f);
+    for (i = 0; i < f->boards; i++) PtyLink_Close(&f->link[i]);
+    if (f->board) munmap(f->board, MCU_FARM_MAX * sizeof(*f->board));
+    f->board = NULL;
+    f->boards = 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * A station's worth of programmers on pseudo-terminals
+ * - One child process serves every board, each on its own pty: the
+ *   command line until `config`, then the three lines H2M prints, then
+ *   McuChunk into that board's own Gowin TAP model, and after DONE (and
+ *   lingerMs of replies, as Stream_Chunked keeps answering) the `chunks`
+ *   line of Put_Chunks. An upload that does not open with the chunk
+ *   magic goes to McuPump with a stage instead, as a wire or session
+ *   image would on the board, and ends with the `session` line
+ * - deaf: boards that read everything and answer nothing; hangup: boards
+ *   whose USB goes away once hangupAfter bytes of the upload are in
+ * - The results are in shared memory, read after McuFarm_Stop
+ */
+
+#ifndef MCU_FARM_H
+#define MCU_FARM_H
+
+#include "pty_link.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define MCU_FARM_MAX 64
+
+typedef struct {
+    int      boards;
+    uint32_t ringSize;        // DMA_Buffer, each board
+    uint64_t deaf;            // Bit per board
+    uint64_t hangup;          // Bit per board
+    uint32_t hangupAfter;     // Upload bytes before the hangup
+    double   lingerMs;
+} McuFarmConfig;
+
+typedef struct {
+    uint32_t configs;         // `config` lines taken
+    uint32_t status;          // ChunkStatus of the last upload
+    uint32_t shifted;         // Bitstream bytes into the TAP
+    uint32_t streamBits;      // What the TAP counted in Shift-DR
+    uint32_t frames, naks;
+    uint32_t staged;          // Session: firmware bytes in the stage
+    int      done;            // The TAP's DONE LED
+} McuFarmBoard;
+
+typedef struct {
+    PtyLink       link[MCU_FARM_MAX];   // This side keeps the slaves
+    int           boards;
+    pid_t         pid;
+    McuFarmBoard *board;                // Shared with the child
+} McuFarm;
+
+// The ptys opened and the child serving them; -1 if any of it failed
+int  McuFarm_Start(McuFarm *f, const McuFarmConfig *c);
+// The child gone; f->board stays readable until McuFarm_Free
+void McuFarm_Stop(McuFarm *f);
+void McuFarm_Free(McuFarm *f);
+static inline const char *McuFarm_Path(const McuFarm *f, int i) { return f->link[i].path; }
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Run_Manifest on the host HAL target
+ */
+
+#include "mcu_manifest.h"
+#include "boot_cache.h"
+#include "hal_target.h"
+#include "jtag_fanout.h"
+#include "jtag_master.h"
+
+#include <string.h>
+
+// utils.Shift_Bit on the host HAL: TDO sampled with TCK low
+static uint8_t Pin_Clock(void *ctx, uint8_t tms, uint8_t tdi) {
+    uint8_t tdo;
+    (void)ctx;
+    HalTarget_Pin(HAL_PIN_TMS, tms);
+    HalTarget_Pin(HAL_PIN_TDI, tdi);
+    HalTarget_Pin(HAL_PIN_TCK, 0);
+    tdo = (uint8_t)HalTarget_PinRead(HAL_PIN_TDO);
+    HalTarget_Pin(HAL_PIN_TCK, 1);
+    return tdo;
+}
+
+typedef struct {
+    const uint8_t *m;
+    size_t         len, at;
+    JtagMaster     jtag;
+    int            fresh;     // The TAP as INIT_CONFIG left it
+    uint8_t       *cache, *stage;
+    uint32_t       cacheSize, stageSize;
+} Run;
+
+// Whole half-words as they come, each page erased as they reach it; the bytes programmed
+static uint32_t Program(Run *x, uint8_t *area, uint32_t size, uint32_t length, McuManifestReport *r) {
+    uint32_t off = 0;
+    while (off < length && x->len - x->at >= 2) {
+        if (off % MCU_FLASH_PAGE == 0) {
+            memset(area + off, 0xFF, MCU_FLASH_PAGE < size - off ? MCU_FLASH_PAGE : size - off);
+            if (area == x->cache) r->erased++;
+        }
+        area[off] &= x->m[x->at];
+        area[off + 1] &= x->m[x->at + 1];
+        x->at += 2;
+        off += 2;
+    }
+    return off;
+}
+
+static ManifestOutcome Sram(Run *x, const ManifestStep *s, McuManifestReport *r) {
+    size_t body = s->length - 1, have = x->len - x->at;
+    uint8_t tail = 0xFF;
+    int whole = have >= s->length;
+    if (!x->fresh) {
+        Jtag_ResetTap(&x->jtag);
+        Jtag_InitConfiguration(&x->jtag);
+    }
+    x->fresh = 0;
+    if (!whole) body = have;
+    Jtag_BeginStream(&x->jtag);
+    Jtag_StreamBytes(&x->jtag, x->m + x->at, body);
+    x->at += body;
+    if (whole) tail = x->m[x->at++];
+    // A short body still leaves Shift-DR; the status shows the failure
+    Jtag_EndStream(&x->jtag, tail);
+    Jtag_FinishConfiguration(&x->jtag);
+    r->bytes += (uint32_t)body + 1;
+    r->status = Jtag_ReadStatus(&x->jtag);
+    return whole ? MF_DONE : MF_SHORT_DATA;
+}
+
+static ManifestOutcome Step(Run *x, const ManifestStep *s, const ManifestStep *before, McuManifestReport *r) {
+    RvDebug d;
+    RvDebugReport dr;
+    switch (s->kind) {
+    case MF_IDCODE: {
+        int n = Jtag_Discover(&x->jtag);
+        x->fresh = 0;
+        if (n < 1 || s->arg > n) return MF_NO_DEVICE;
+        if (s->arg) Jtag_Select(&x->jtag, s->arg - 1);
+        r->idcode = x->jtag.dev[x->jtag.active].idcode;
+        return ((r->idcode ^ s->value) & s->mask) == 0 ? MF_DONE : MF_WRONG_IDCODE;
+    }
+    case MF_SRAM:
+        return Sram(x, s, r);
+    case MF_FLASH:
+        r->flashed = Program(x, x->cache, x->cacheSize, s->length, r);
+        return r->flashed == s->length ? MF_DONE : MF_SHORT_DATA;
+    case MF_VERIFY:
+        if (before->kind == MF_SRAM) {
+            uint32_t status = Jtag_ReadStatus(&x->jtag);
+            return (status & STATUS_DONE_BIT) && ((status ^ s->value) & s->mask) == 0 ? MF_DONE : MF_VERIFY_FAIL;
+        }
+        return BootCache_Decide(x->cache, x->cacheSize, 0) == BOOT_LOAD ? MF_DONE : MF_VERIFY_FAIL;
+    case MF_LOAD:
+        r->staged = Program(x, x->stage, x->stageSize, s->length, r);
+        if (r->staged != s->length) return MF_SHORT_DATA;
+        return BootCache_Crc32(x->stage, s->length) == s->value ? MF_DONE : MF_BAD_FIRMWARE;
+    default:
+        RvDebug_Init(&d, &x->jtag);
+        r->start = RvDebug_Load(&d, x->stage, r->staged, &dr);
+        return r->start == RVDBG_LOADED ? MF_DONE : MF_START_FAIL;
+    }
+}
+
+ManifestOutcome McuManifest_Run(const uint8_t *m, size_t len, uint8_t *cache, uint32_t cacheSize,
+                                uint8_t *stage, uint32_t stageSize, McuManifestReport *r) {
+    ManifestStep steps[MANIFEST_MAX_STEPS];
+    Run x;
+    int n, i;
+
+    memset(r, 0, sizeof(*r));
+    r->start = RVDBG_SKIPPED;
+    memset(&x, 0, sizeof(x));
+    x.m = m;
+    x.len = len;
+    x.fresh = 1;
+    x.cache = cache;
+    x.cacheSize = cacheSize;
+    x.stage = stage;
+    x.stageSize = stageSize;
+
+    // INIT_CONFIG, before the host is told to send
+    Jtag_Init(&x.jtag, Pin_Clock, NULL);
+    Jtag_ResetTap(&x.jtag);
+    Jtag_InitConfiguration(&x.jtag);
+
+    r->steps = len >= 8 ? (uint32_t)m[4] | (uint32_t)m[5] << 8 | (uint32_t)m[6] << 16 | (uint32_t)m[7] << 24 : 0;
+    n = Manifest_Parse(m, len, stageSize, cacheSize, steps);
+    r->result = n ? MF_DONE : MF_BAD_MANIFEST;
+    x.at = MANIFEST_HEADER_SIZE + (size_t)n * MANIFEST_STEP_SIZE;
+    for (i = 0; i < n && r->result == MF_DONE; i++) {
+        uint64_t t = x.jtag.tckCount;
+        r->step = (uint32_t)i + 1;
+        r->result = Step(&x, &steps[i], i ? &steps[i - 1] : NULL, r);
+        r->stepTck[i] = x.jtag.tckCount - t;
+    }
+    r->tck = x.jtag.tckCount;
+    return r->result;
+}
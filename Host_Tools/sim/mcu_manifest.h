@@ -0,0 +1,49 @@
+/*
+ * Run_Manifest on the host HAL target: a C mirror of it, not the Ada
+ * - tests/test_manifest.c tests this mirror; tests/test_firmware.c under
+ *   `make fw-check` runs the same manifests through the firmware's own
+ *   Run_Manifest and checks its `manifest` line against this report
+ * - The steps of a manifest (lib/manifest.h) as mcu_to_fpga.Run_Manifest
+ *   takes them, on the pins of sim/hal_target.c: INIT_CONFIG's reset and
+ *   initialisation first, then each step, the first one that fails
+ *   ending the run
+ * - The stream is a buffer: where it ends is where the host went quiet.
+ *   The cache and stage are flash as hal.adb's host body keeps it (page
+ *   erase to 0xFF, programming ANDs)
+ * - Start always goes through the debug module (RvDebug_Load); the
+ *   bootloader path needs the USART1 model and is left to the board
+ * - Times are TCKs per step: the steps that do not clock (flash, stage)
+ *   show 0
+ */
+
+#ifndef MCU_MANIFEST_H
+#define MCU_MANIFEST_H
+
+#include "manifest.h"
+#include "riscv_debug.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MCU_FLASH_PAGE 2048u   // hal.Flash_Page_Size
+
+typedef struct {
+    ManifestOutcome result;
+    uint32_t        steps;
+    uint32_t        step;       // Last step started, 1-based
+    uint32_t        idcode;     // Read by the IDCODE step
+    uint32_t        status;     // After the SRAM step
+    uint32_t        bytes;      // Bitstream bytes shifted
+    uint32_t        flashed;    // Boot image bytes programmed
+    uint32_t        staged;     // Executable bytes staged
+    uint32_t        erased;     // Cache pages erased
+    RvDebugResult   start;      // The Start step's load, RVDBG_SKIPPED if none
+    uint64_t        stepTck[MANIFEST_MAX_STEPS];
+    uint64_t        tck;        // Every TCK, INIT_CONFIG's included
+} McuManifestReport;
+
+// HalTarget_Init (and HalTarget_UseDebug for a Start step) by the caller
+ManifestOutcome McuManifest_Run(const uint8_t *m, size_t len, uint8_t *cache, uint32_t cacheSize,
+                                uint8_t *stage, uint32_t stageSize, McuManifestReport *r);
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ * Programmer receive paths, byte for byte
+ */
+
+#include "mcu_sim.h"
+#include "session_image.h"
+#include "wire_image.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void McuRing_Init(McuRing *r, uint32_t size) {
+    r->buf = calloc(size, 1);
+    r->size = size;
+    r->writeIdx = r->readIdx = 0;
+    r->received = r->consumed = 0;
+    RingMonitor_Reset(&r->mon, size, 0, 0);
+}
+
+void McuRing_Free(McuRing *r) { free(r->buf); r->buf = NULL; }
+
+uint8_t *McuRing_WriteSpan(McuRing *r, uint32_t *room) {
+    uint32_t space = r->size - 1 - McuRing_Level(r);
+    uint32_t toEnd = r->size - r->writeIdx;
+    *room = space < toEnd ? space : toEnd;
+    return r->buf + r->writeIdx;
+}
+
+void McuRing_Commit(McuRing *r, uint32_t n) {
+    uint32_t half = r->size / 2;
+    uint32_t reach = r->writeIdx + n;
+    int crossedHalf = (r->writeIdx < half && reach >= half) || reach >= r->size + half;
+    int crossedFull = reach >= r->size;
+    r->writeIdx = reach & (r->size - 1);
+    r->received += n;
+    RingMonitor_Produce(&r->mon, r->writeIdx, crossedHalf, crossedFull);
+}
+
+const uint8_t *McuRing_ReadSpan(const McuRing *r, uint32_t *avail) {
+    uint32_t level = McuRing_Level(r);
+    uint32_t toEnd = r->size - r->readIdx;
+    *avail = level < toEnd ? level : toEnd;
+    return r->buf + r->readIdx;
+}
+
+void McuRing_Consume(McuRing *r, uint32_t n) {
+    r->readIdx = (r->readIdx + n) & (r->size - 1);
+    r->consumed += n;
+    RingMonitor_Consume(&r->mon, n);
+}
+
+// --- BITSTREAM PUMP ---
+void McuPump_Begin(McuPump *p, McuRing *r, JtagMaster *jtag) {
+    p->ring = r;
+    p->jtag = jtag;
+    p->sent = 0;
+    p->mode = PUMP_HEADER;
+    p->bodyLeft = 0;
+    p->tail = 0;
+    p->stage = NULL;
+    p->stageSize = p->staged = p->fwLeft = p->frames = p->frameLeft = p->stagedAtDone = 0;
+    p->frameKind = 0;
+    p->badFrame = 0;
+    Jtag_BeginStream(jtag);
+}
+
+void McuPump_SetStage(McuPump *p, uint8_t *stage, uint32_t size) {
+    p->stage = stage;
+    p->stageSize = stage ? size : 0;
+}
+
+// Wait_Wire_Header: the ring restarts at 0, so the header is contiguous.
+// A raw bitstream gives itself away on its first byte
+static void Pump_Header(McuPump *p, int quiet) {
+    WireHeader h;
+    SessionHeader s;
+    uint32_t avail, i;
+    const uint8_t *src = McuRing_ReadSpan(p->ring, &avail);
+    int session;
+    for (i = 0; i < avail && i < 4; i++) {
+        if (src[i] != (uint8_t)(WIRE_MAGIC >> (8 * i)) && src[i] != (uint8_t)(SESSION_MAGIC >> (8 * i))) {
+            p->mode = PUMP_RAW;
+            return;
+        }
+    }
+    session = avail >= 4 && src[3] == (uint8_t)(SESSION_MAGIC >> 24);
+    if (avail < (session ? SESSION_HEADER_SIZE : WIRE_HEADER_SIZE)) {
+        if (quiet) p->mode = PUMP_RAW;
+        return;
+    }
+    if (session) {
+        if (!SessionImage_Parse(src, p->stageSize, &s)) { p->mode = PUMP_RAW; return; }
+        McuRing_Consume(p->ring, SESSION_HEADER_SIZE);
+        p->mode = PUMP_SESSION;
+        p->bodyLeft = s.bodyLength;
+        p->tail = s.tail;
+        p->fwLeft = s.firmwareLength;
+        return;
+    }
+    if (!WireImage_Parse(src, &h)) { p->mode = PUMP_RAW; return; }
+    McuRing_Consume(p->ring, WIRE_HEADER_SIZE);
+    p->mode = PUMP_WIRE;
+    p->bodyLeft = h.bodyLength;
+    p->tail = h.tail;
+}
+
+// Stream_Session: a frame word (which may wrap), then its bytes as they come
+static uint32_t Pump_Session(McuPump *p) {
+    uint32_t total = 0;
+    while (!p->badFrame && McuRing_Level(p->ring)) {
+        uint32_t avail, n;
+        const uint8_t *src;
+        if (p->frameLeft == 0) {
+            uint8_t w[SESSION_FRAME_SIZE];
+            uint32_t i;
+            if (!p->bodyLeft && !p->fwLeft) break;
+            if (McuRing_Level(p->ring) < SESSION_FRAME_SIZE) break;
+            for (i = 0; i < SESSION_FRAME_SIZE; i++) w[i] = p->ring->buf[(p->ring->readIdx + i) & (p->ring->size - 1)];
+            McuRing_Consume(p->ring, SESSION_FRAME_SIZE);
+            p->frameKind = w[0];
+            p->frameLeft = (uint32_t)w[1] | (uint32_t)w[2] << 8 | (uint32_t)w[3] << 16;
+            p->frames++;
+            // Firmware goes to flash in half-words: only its last frame may be odd
+            if (!(p->frameKind == SESSION_BITSTREAM && p->frameLeft <= p->bodyLeft) &&
+                !(p->frameKind == SESSION_FIRMWARE && p->frameLeft <= p->fwLeft &&
+                  (!(p->frameLeft & 1u) || p->frameLeft == p->fwLeft))) {
+                p->badFrame = 1;
+            }
+            continue;
+        }
+        src = McuRing_ReadSpan(p->ring, &avail);
+        n = avail < p->frameLeft ? avail : p->frameLeft;
+        if (p->frameKind == SESSION_BITSTREAM) {
+            Jtag_StreamBytes(p->jtag, src, n);
+            p->bodyLeft -= n;
+            total += n;
+        } else {
+            memcpy(p->stage + p->staged, src, n);
+            p->staged += n;
+            p->fwLeft -= n;
+        }
+        McuRing_Consume(p->ring, n);
+        p->frameLeft -= n;
+    }
+    p->sent += total;
+    return total;
+}
+
+uint32_t McuPump_Drain(McuPump *p) {
+    uint32_t total = 0;
+    if (p->mode == PUMP_HEADER) Pump_Header(p, 0);
+    if (p->mode == PUMP_SESSION) return Pump_Session(p);
+    if (p->mode == PUMP_WIRE) {
+        // Stream_Wire_Image: whole spans, no byte held back
+        while (p->bodyLeft && McuRing_Level(p->ring)) {
+            uint32_t avail, n;
+            const uint8_t *src = McuRing_ReadSpan(p->ring, &avail);
+            n = avail < p->bodyLeft ? avail : p->bodyLeft;
+            Jtag_StreamBytes(p->jtag, src, n);
+            McuRing_Consume(p->ring, n);
+            p->bodyLeft -= n;
+            total += n;
+        }
+        p->sent += total;
+        return total;
+    }
+    if (p->mode != PUMP_RAW) return 0;
+    // Keep the last byte in reserve: it goes out with TMS high
+    while (McuRing_Level(p->ring) > 1) {
+        uint32_t avail, n;
+        const uint8_t *src = McuRing_ReadSpan(p->ring, &avail);
+        n = avail < McuRing_Level(p->ring) - 1 ? avail : McuRing_Level(p->ring) - 1;
+        Jtag_StreamBytes(p->jtag, src, n);
+        McuRing_Consume(p->ring, n);
+        total += n;
+    }
+    p->sent += total;
+    return total;
+}
+
+int McuPump_BodyDone(const McuPump *p) {
+    return (p->mode == PUMP_WIRE || p->mode == PUMP_SESSION) && p->bodyLeft == 0;
+}
+
+int McuPump_Staged(const McuPump *p) {
+    return p->mode == PUMP_SESSION && p->fwLeft == 0 && !p->badFrame;
+}
+
+void McuPump_Finish(McuPump *p) {
+    uint32_t avail;
+    const uint8_t *last;
+    if (p->mode == PUMP_HEADER) {
+        Pump_Header(p, 1);
+        McuPump_Drain(p);
+    }
+    if (p->mode == PUMP_SESSION) p->stagedAtDone = p->staged;
+    if (p->mode == PUMP_WIRE || p->mode == PUMP_SESSION) {
+        Jtag_EndStream(p->jtag, p->tail);
+        p->sent++;
+        Jtag_FinishConfiguration(p->jtag);
+        return;
+    }
+    last = McuRing_ReadSpan(p->ring, &avail);
+    if (avail == 0) return;
+    Jtag_EndStream(p->jtag, *last);
+    McuRing_Consume(p->ring, 1);
+    p->sent++;
+    Jtag_FinishConfiguration(p->jtag);
+}
@@ -0,0 +1,76 @@
+/*
+ * Programmer receive paths, byte for byte
+ * - McuRing: DMA_Buffer behind USART2 RX with the data in it, written by
+ *   whatever stands in for the DMA and watched by the firmware's ring
+ *   monitor (flags derived from the index movement, as Poll_USART2_Ring
+ *   would see them)
+ * - McuPump: Send_Configuration_Bitstream's pump on top of it; every byte
+ *   but the last goes out as it arrives, the last one with the TMS exit
+ *   once the host goes quiet, then the trailing commands. A session that
+ *   opens with a wire image header (lib/wire_image.h) streams the body by
+ *   count instead, with the last byte taken from the header; a session
+ *   image (lib/session_image.h) streams its bitstream frames the same way
+ *   and copies its firmware frames into the stage
+ */
+
+#ifndef MCU_SIM_H
+#define MCU_SIM_H
+
+#include "jtag_master.h"
+#include "ring_monitor.h"
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t    *buf;
+    uint32_t    size;         // Power of two, like utils.Buffer_Size
+    uint32_t    writeIdx;
+    uint32_t    readIdx;
+    uint32_t    received;     // Bytes the DMA has written
+    uint32_t    consumed;     // Bytes the firmware has taken
+    RingMonitor mon;
+} McuRing;
+
+void     McuRing_Init(McuRing *r, uint32_t size);
+void     McuRing_Free(McuRing *r);
+static inline uint32_t McuRing_Level(const McuRing *r) { return r->received - r->consumed; }
+
+// Contiguous free space at the write index, stopping one short of a lap
+uint8_t *McuRing_WriteSpan(McuRing *r, uint32_t *room);
+void     McuRing_Commit(McuRing *r, uint32_t n);   // DMA wrote n bytes there
+// Contiguous unread bytes at the read index
+const uint8_t *McuRing_ReadSpan(const McuRing *r, uint32_t *avail);
+void     McuRing_Consume(McuRing *r, uint32_t n);
+
+typedef enum { PUMP_HEADER, PUMP_RAW, PUMP_WIRE, PUMP_SESSION } PumpMode;
+
+typedef struct {
+    McuRing    *ring;
+    JtagMaster *jtag;
+    uint32_t    sent;         // Bytes shifted into the TAP
+    PumpMode    mode;         // PUMP_HEADER until the first 16 (20) bytes are in
+    uint32_t    bodyLeft;     // PUMP_WIRE / PUMP_SESSION: body bytes still to come
+    uint8_t     tail;         // PUMP_WIRE / PUMP_SESSION: last byte, from the header
+    // PUMP_SESSION: the flash stage (hal.Stage_Base) and the frame in hand
+    uint8_t    *stage;
+    uint32_t    stageSize;    // 0: sessions are taken for raw bitstreams
+    uint32_t    staged;       // Firmware bytes in the stage
+    uint32_t    fwLeft;
+    uint32_t    frames;
+    uint32_t    frameLeft;
+    uint8_t     frameKind;
+    int         badFrame;     // Unknown kind, or longer than its section
+    uint32_t    stagedAtDone; // staged when McuPump_Finish ran
+} McuPump;
+
+void     McuPump_Begin(McuPump *p, McuRing *r, JtagMaster *jtag);  // To Shift-DR
+void     McuPump_SetStage(McuPump *p, uint8_t *stage, uint32_t size);  // After Begin
+// Raw: everything but the last byte. Wire: the whole body up to its
+// length. Session: every whole frame there is, the firmware staged (also
+// after McuPump_Finish). Returns bytes shifted
+uint32_t McuPump_Drain(McuPump *p);
+int      McuPump_BodyDone(const McuPump *p);   // Wire / session body complete: no need to wait for silence
+int      McuPump_Staged(const McuPump *p);     // Session: all the firmware in the stage
+void     McuPump_Finish(McuPump *p);    // Silence timeout or body done: last byte, trailer
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * NEORV32 UART bootloader stand-in
+ */
+
+#include "neorv32_bootloader.h"
+
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char banner[] =
+    "\n\n<< NEORV32 Bootloader >>\n\n"
+    "BLDV: Host_Tools model\n"
+    "HWV:  0x01090000\n"
+    "IMEM: 0x00010000 bytes @0x00000000\n"
+    "DMEM: 0x00002000 bytes @0x80000000\n\n"
+    "Autoboot in 8s. Press any key to abort.\n";
+
+static const char help[] =
+    "Available CMDs:\n"
+    " h: Help\n"
+    " r: Restart\n"
+    " u: Upload\n"
+    " e: Execute\n";
+
+static size_t Say(char *out, size_t cap, size_t at, const char *s) {
+    size_t n = strlen(s);
+    if (at + n > cap) n = cap > at ? cap - at : 0;
+    memcpy(out + at, s, n);
+    return at + n;
+}
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void Neorv32Bl_Init(Neorv32Bl *b, int atPrompt) {
+    memset(b, 0, sizeof(*b));
+    b->state = atPrompt ? BL_PROMPT : BL_AUTOBOOT;
+}
+
+size_t Neorv32Bl_PowerUp(Neorv32Bl *b, char *out, size_t cap) {
+    if (b->mute || b->state != BL_AUTOBOOT) return 0;
+    return Say(out, cap, 0, banner);
+}
+
+// One upload byte; the header is checked once it is complete
+static size_t Upload_Byte(Neorv32Bl *b, uint8_t c, char *out, size_t cap) {
+    size_t n = 0;
+    uint32_t at = b->got++;
+    if (at < 12) {
+        b->hdr[at] = c;
+        if (at < 11) return 0;
+        b->size = Get32(b->hdr + 4);
+        b->checksum = Get32(b->hdr + 8);
+        b->sum = 0;
+        if (Get32(b->hdr) != 0x4788CAFEu) n = Say(out, cap, n, "\a\nERR_EXE");
+        else if (b->size == 0 || b->size % 4 || b->size > NEORV32_BL_IMEM) n = Say(out, cap, n, "\a\nERR_SIZE");
+        else return 0;
+    } else {
+        uint32_t off = at - 12;
+        b->image[off] = c;
+        b->sum += (uint32_t)c << (8 * (off % 4)) ;
+        if (off + 1 < b->size) return 0;
+        if ((uint32_t)(b->sum + b->checksum) != 0) n = Say(out, cap, n, "\a\nERR_CHKS");
+        else { b->loaded = 1; n = Say(out, cap, n, "OK"); }
+    }
+    if (!b->loaded) b->errors++;
+    b->state = BL_PROMPT;
+    return Say(out, cap, n, "\n\nCMD:> ");
+}
+
+size_t Neorv32Bl_Rx(Neorv32Bl *b, uint8_t c, char *out, size_t cap) {
+    char echo[2] = { (char)c, 0 };
+    size_t n = 0;
+
+    if (b->mute) return 0;
+    switch (b->state) {
+    case BL_AUTOBOOT:
+        b->state = BL_PROMPT;
+        n = Say(out, cap, n, "Aborted.\n\n");
+        n = Say(out, cap, n, help);
+        return Say(out, cap, n, "\nCMD:> ");
+    case BL_UPLOAD:
+        return Upload_Byte(b, c, out, cap);
+    case BL_RUNNING:
+        return 0;
+    case BL_PROMPT:
+        break;
+    }
+
+    b->keys++;
+    n = Say(out, cap, n, echo);
+    switch (c) {
+    case 'h':
+        n = Say(out, cap, n, "\n");
+        n = Say(out, cap, n, help);
+        break;
+    case 'u':
+        b->state = BL_UPLOAD;
+        b->got = 0;
+        b->loaded = 0;
+        return Say(out, cap, n, "\nAwaiting neorv32_exe.bin... ");
+    case 'e':
+        if (b->loaded) {
+            b->state = BL_RUNNING;
+            return Say(out, cap, n, "\nBooting from 0x00000000...\n\n");
+        }
+        n = Say(out, cap, n, "\nNo executable available.\n");
+        break;
+    default:
+        n = Say(out, cap, n, "\nInvalid CMD\n");
+        break;
+    }
+    return Say(out, cap, n, "\nCMD:> ");
+}
+
+static int Write_All(int fd, const char *s, size_t n) {
+    while (n) {
+        ssize_t w = write(fd, s, n);
+        if (w <= 0) return -1;
+        s += w; n -= (size_t)w;
+    }
+    return 0;
+}
+
+int Neorv32Bl_Serve(Neorv32Bl *b, int fd, int bannerMs, int idleMs) {
+    char out[512];
+    uint8_t in[256];
+    size_t n;
+    ssize_t got, i;
+
+    if (bannerMs > 0) usleep((useconds_t)bannerMs * 1000);
+    n = Neorv32Bl_PowerUp(b, out, sizeof(out));
+    if (n && Write_All(fd, out, n) < 0) return (int)b->state;
+    while (b->state != BL_RUNNING) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        if (poll(&p, 1, idleMs) <= 0) break;
+        if ((got = read(fd, in, sizeof(in))) <= 0) break;
+        for (i = 0; i < got; i++) {
+            n = Neorv32Bl_Rx(b, in[i], out, sizeof(out));
+            if (n && Write_All(fd, out, n) < 0) return (int)b->state;
+        }
+    }
+    return (int)b->state;
+}
@@ -0,0 +1,42 @@
+/*
+ * NEORV32 UART bootloader stand-in
+ * - The console of the bootloader on the Tang Nano: banner and autoboot
+ *   countdown, any key aborts it, then h / u / e at "CMD:> " with the
+ *   command echoed, "Awaiting neorv32_exe.bin... " for an upload, OK or
+ *   ERR_EXE / ERR_SIZE / ERR_CHKS after it, "Booting from ..." on e
+ * - Byte in, reply text out; Neorv32Bl_Serve runs it on a pty so a driver
+ *   can be tested exactly as it would talk to /dev/ttyUSB* or USART1
+ */
+
+#ifndef NEORV32_BOOTLOADER_H
+#define NEORV32_BOOTLOADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define NEORV32_BL_IMEM 0x10000u
+
+typedef enum { BL_AUTOBOOT, BL_PROMPT, BL_UPLOAD, BL_RUNNING } Neorv32BlState;
+
+typedef struct {
+    Neorv32BlState state;
+    uint8_t  hdr[12];
+    uint32_t size, checksum, sum;
+    uint32_t got;           // Upload bytes so far, header included
+    uint8_t  image[NEORV32_BL_IMEM];
+    int      loaded;        // A good image is in memory
+    int      keys;          // Command keys seen at the prompt
+    int      errors;
+    int      mute;          // Scripted: never answers anything
+} Neorv32Bl;
+
+// atPrompt: the countdown was already aborted (no banner, straight to keys)
+void   Neorv32Bl_Init(Neorv32Bl *b, int atPrompt);
+size_t Neorv32Bl_PowerUp(Neorv32Bl *b, char *out, size_t cap);   // Banner text
+size_t Neorv32Bl_Rx(Neorv32Bl *b, uint8_t c, char *out, size_t cap);
+
+// Serves b on fd: the banner after bannerMs, then replies until it is
+// running the image or the line is quiet for idleMs. Returns b->state
+int    Neorv32Bl_Serve(Neorv32Bl *b, int fd, int bannerMs, int idleMs);
+
+#endif
@@ -0,0 +1,378 @@
+/*
+ * Host -> MCU -> FPGA pipeline over pseudo-terminals
+ */
+
+#include "pipeline.h"
+#include "gowin_tap.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+#include "neorv32_boot.h"
+#include "neorv32_bootloader.h"
+#include "pty_link.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NO_DATA_MS 10000   // Give up if the host never sends anything
+
+// Written by the children, read by the MCU after they exit
+typedef struct {
+    uint32_t sinkReceived;   // File bytes the bootloader got, commands excluded
+    uint32_t sinkMatch;      // All of them equal to the file, and started
+    uint32_t sinkHandshake;  // Command keys seen at the prompt
+} PipeShared;
+
+static uint64_t Now_Ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t Cpu_Ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static double Rusage_S(const struct rusage *u) {
+    return (double)u->ru_utime.tv_sec + (double)u->ru_utime.tv_usec / 1e6 +
+           (double)u->ru_stime.tv_sec + (double)u->ru_stime.tv_usec / 1e6;
+}
+
+static void Sleep_Until(uint64_t t) {
+    uint64_t now = Now_Ns();
+    struct timespec ts;
+    if (t <= now) return;
+    ts.tv_sec = (time_t)((t - now) / 1000000000u);
+    ts.tv_nsec = (long)((t - now) % 1000000000u);
+    nanosleep(&ts, NULL);
+}
+
+// Stamp every chunk completed by a byte count moving from..to
+static void Stamp(uint64_t *t, uint32_t nChunks, size_t len, size_t from, size_t to, uint64_t when) {
+    size_t k = from / PIPE_LAT_CHUNK;
+    for (; k < nChunks; k++) {
+        size_t end = (k + 1) * PIPE_LAT_CHUNK < len ? (k + 1) * PIPE_LAT_CHUNK : len;
+        if (end > to) break;
+        if (end > from) t[k] = when;
+    }
+}
+
+// --- HOST UPLOADER ---
+static void Uploader(const PipeConfig *c, const char *port, uint64_t *tWrite, uint32_t nChunks, uint64_t t0) {
+    int fd = PtyLink_OpenPort(port);
+    size_t off = 0;
+    if (fd < 0) _exit(1);
+    while (off < c->len) {
+        size_t n = c->len - off < c->chunk ? c->len - off : c->chunk;
+        uint64_t start;
+        if (c->baud) Sleep_Until(t0 + (uint64_t)((double)off * 10.0 * 1e9 / c->baud));
+        // Stamped before the call: the MCU can read the bytes before write() returns
+        start = Now_Ns();
+        if (PtyLink_WriteAll(fd, c->data + off, n) < 0) _exit(1);
+        Stamp(tWrite, nChunks, c->len, off, off + n, start);
+        off += n;
+    }
+    tcdrain(fd);
+    close(fd);
+    _exit(0);
+}
+
+// --- FPGA BOOTLOADER ---
+// The NEORV32 stand-in; its banner comes handshakeMs after the start
+static void Sink(const PipeConfig *c, const char *port, uint64_t *tSink, uint32_t nChunks, PipeShared *sh) {
+    static Neorv32Bl bl;
+    int fd = PtyLink_OpenPort(port);
+    uint8_t buf[4096];
+    char out[512];
+    size_t n;
+    if (fd < 0) _exit(1);
+    Neorv32Bl_Init(&bl, 0);
+    Sleep_Until(Now_Ns() + (uint64_t)c->handshakeMs * 1000000u);
+    n = Neorv32Bl_PowerUp(&bl, out, sizeof(out));
+    if (PtyLink_WriteAll(fd, (const uint8_t *)out, n) < 0) _exit(1);
+    while (bl.state != BL_RUNNING) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        ssize_t got, i;
+        uint64_t now;
+        if (poll(&p, 1, (int)(c->idleMs + NO_DATA_MS)) <= 0) break;
+        if ((got = read(fd, buf, sizeof(buf))) <= 0) break;
+        now = Now_Ns();
+        for (i = 0; i < got; i++) {
+            int image = bl.state == BL_UPLOAD;
+            n = Neorv32Bl_Rx(&bl, buf[i], out, sizeof(out));
+            if (image) Stamp(tSink, nChunks, c->len, bl.got - 1, bl.got, now);
+            if (n && PtyLink_WriteAll(fd, (const uint8_t *)out, n) < 0) _exit(1);
+        }
+    }
+    sh->sinkReceived = bl.got;
+    sh->sinkMatch = bl.state == BL_RUNNING && bl.got == c->len &&
+                    memcmp(bl.hdr, c->data, 12) == 0 && memcmp(bl.image, c->data + 12, c->len - 12) == 0;
+    sh->sinkHandshake = (uint32_t)bl.keys;
+    close(fd);
+    _exit(0);
+}
+
+// --- STATISTICS ---
+static int Cmp_U64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static PipeLatency Latency(const uint64_t *from, const uint64_t *to, uint32_t n) {
+    PipeLatency l = { 0, 0, 0, 0, 0, 0 };
+    uint64_t *d = malloc((n ? n : 1) * sizeof(*d));
+    uint64_t sum = 0;
+    uint32_t i, k = 0;
+    for (i = 0; i < n; i++) {
+        if (!from[i] || !to[i]) continue;
+        d[k] = to[i] > from[i] ? to[i] - from[i] : 0;
+        sum += d[k++];
+    }
+    if (k) {
+        qsort(d, k, sizeof(*d), Cmp_U64);
+        l.n = k;
+        l.min = (double)d[0] / 1e3;
+        l.max = (double)d[k - 1] / 1e3;
+        l.avg = (double)sum / k / 1e3;
+        l.p50 = (double)d[k / 2] / 1e3;
+        l.p99 = (double)d[(k * 99) / 100 < k ? (k * 99) / 100 : k - 1] / 1e3;
+    }
+    free(d);
+    return l;
+}
+
+const char *Pipeline_StageName(PipeStage s) {
+    static const char *Names[PIPE_STAGES] = { "host_to_ring", "ring_to_out", "out_to_target", "end_to_end" };
+    return s < PIPE_STAGES ? Names[s] : "?";
+}
+
+// --- MCU ---
+// USART2 RX: whatever the pty has, straight into DMA_Buffer
+static int Receive(int fd, McuRing *ring) {
+    int total = 0;
+    for (;;) {
+        uint32_t room;
+        uint8_t *dst = McuRing_WriteSpan(ring, &room);
+        ssize_t n;
+        if (room == 0) break;
+        n = read(fd, dst, room);
+        if (n <= 0) break;
+        McuRing_Commit(ring, (uint32_t)n);
+        total += (int)n;
+    }
+    return total;
+}
+
+// Send_Firmware's view of the two ports, for the bootloader driver
+typedef struct {
+    int       u2, u1;
+    McuRing  *ring;
+    uint64_t *tRecv, *tOut;
+    uint32_t  nChunks;
+    size_t    len, out;
+    uint64_t  tFirst, tLast;
+} FwPorts;
+
+static size_t Fw_HostRead(void *ctx, uint8_t *buf, size_t max, int timeoutMs) {
+    FwPorts *f = ctx;
+    uint32_t avail;
+    const uint8_t *src;
+    if (!McuRing_Level(f->ring)) {
+        struct pollfd p = { f->u2, POLLIN, 0 };
+        int got;
+        if (poll(&p, 1, timeoutMs) <= 0) return 0;
+        if ((got = Receive(f->u2, f->ring)) <= 0) return 0;
+        f->tLast = Now_Ns();
+        if (!f->tFirst) f->tFirst = f->tLast;
+        Stamp(f->tRecv, f->nChunks, f->len, f->ring->received - (uint32_t)got, f->ring->received, f->tLast);
+    }
+    src = McuRing_ReadSpan(f->ring, &avail);
+    if (avail > max) avail = (uint32_t)max;
+    memcpy(buf, src, avail);
+    McuRing_Consume(f->ring, avail);
+    return avail;
+}
+
+static int Fw_TargetRead(void *ctx, uint8_t *c, int timeoutMs) {
+    struct pollfd p = { ((FwPorts *)ctx)->u1, POLLIN, 0 };
+    if (poll(&p, 1, timeoutMs) <= 0) return 0;
+    return read(p.fd, c, 1) == 1;
+}
+
+static void Fw_TargetWrite(void *ctx, const uint8_t *buf, size_t n) {
+    FwPorts *f = ctx;
+    // Keys go out one at a time, the image (header first) in spans
+    int image = f->out < f->len && (n > 1 || f->out > 0);
+    while (n) {
+        ssize_t w = write(f->u1, buf, n);
+        if (w <= 0) { struct pollfd p = { f->u1, POLLOUT, 0 }; poll(&p, 1, 100); continue; }
+        if (image) Stamp(f->tOut, f->nChunks, f->len, f->out, f->out + (size_t)w, Now_Ns());
+        if (image) f->out += (size_t)w;
+        buf += w; n -= (size_t)w;
+    }
+}
+
+// Bootloader text on to the host, as Expect forwards it
+static void Fw_Console(void *ctx, uint8_t c) {
+    if (write(((FwPorts *)ctx)->u2, &c, 1) < 0) return;
+}
+
+int Pipeline_Run(const PipeConfig *c, PipeResult *r) {
+    uint32_t nChunks = (uint32_t)((c->len + PIPE_LAT_CHUNK - 1) / PIPE_LAT_CHUNK);
+    size_t stampBytes = (size_t)nChunks * sizeof(uint64_t);
+    size_t shBytes = sizeof(PipeShared) + 2 * stampBytes;
+    PtyLink u2, u1;
+    PipeShared *sh;
+    uint64_t *tWrite, *tSink, *tRecv, *tOut;
+    McuRing ring;
+    McuPump pump;
+    GowinTap tap;
+    JtagMaster m;
+    pid_t host, sink = -1;
+    struct rusage before, after, ru;
+    uint64_t t0, tFirst = 0, tLast = 0, tEnd, cpuTarget = 0, c0;
+    int status, firmware = c->mode == PIPE_FIRMWARE;
+
+    memset(r, 0, sizeof(*r));
+    r->bytes = c->len;
+    if (c->len == 0 || (c->ringSize & (c->ringSize - 1)) != 0) return -1;
+    if (PtyLink_Open(&u2) < 0) return -1;
+    if (firmware && PtyLink_Open(&u1) < 0) { PtyLink_Close(&u2); return -1; }
+    tWrite = mmap(NULL, shBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (tWrite == MAP_FAILED) { PtyLink_Close(&u2); if (firmware) PtyLink_Close(&u1); return -1; }
+    memset(tWrite, 0, shBytes);
+    tSink = tWrite + nChunks;
+    sh = (PipeShared *)(tSink + nChunks);
+    tRecv = calloc(nChunks, sizeof(uint64_t));
+    tOut = calloc(nChunks, sizeof(uint64_t));
+    McuRing_Init(&ring, c->ringSize);
+
+    // "config": reset and init before the host starts sending
+    if (!firmware) {
+        GowinTap_Init(&tap);
+        Jtag_Init(&m, GowinTap_ClockFn, &tap);
+        Jtag_ResetTap(&m);
+        Jtag_InitConfiguration(&m);
+        McuPump_Begin(&pump, &ring, &m);
+    }
+
+    getrusage(RUSAGE_SELF, &before);
+    t0 = Now_Ns();
+    if ((host = fork()) == 0) Uploader(c, u2.path, tWrite, nChunks, t0);
+    if (firmware && host > 0 && (sink = fork()) == 0) Sink(c, u1.path, tSink, nChunks, sh);
+    if (host < 0 || (firmware && sink < 0)) goto fail;
+
+    if (firmware) {
+        // Send_Firmware: prompts, exactly the image, then 'e'
+        FwPorts f = { u2.master, u1.master, &ring, tRecv, tOut, nChunks, c->len, 0, 0, 0 };
+        Neorv32Link l = { Fw_HostRead, Fw_TargetRead, Fw_TargetWrite, Fw_Console, &f };
+        Neorv32Report rep;
+        Neorv32_Upload(&l, &rep);
+        r->handshakeMs = rep.handshakeUs / 1e3;
+        tFirst = f.tFirst;
+        tLast = f.tLast;
+    }
+
+    while (!firmware) {
+        struct pollfd p = { u2.master, POLLIN, 0 };
+        uint64_t now = Now_Ns();
+        int wait, got;
+        if (tFirst) {
+            uint64_t idleEnd = tLast + (uint64_t)c->idleMs * 1000000u;
+            if (now >= idleEnd) break;
+            wait = (int)((idleEnd - now + 999999) / 1000000);
+        } else {
+            if (now - t0 > (uint64_t)NO_DATA_MS * 1000000u) break;
+            wait = NO_DATA_MS;
+        }
+        if (poll(&p, 1, wait) < 0 && errno != EINTR) break;
+
+        got = Receive(u2.master, &ring);
+        now = Now_Ns();
+        if (got > 0) {
+            if (!tFirst) tFirst = now;
+            tLast = now;
+            Stamp(tRecv, nChunks, c->len, ring.received - (uint32_t)got, ring.received, now);
+        }
+
+        {
+            uint32_t from = pump.sent;
+            c0 = Cpu_Ns();
+            if (McuPump_Drain(&pump)) {
+                cpuTarget += Cpu_Ns() - c0;
+                Stamp(tOut, nChunks, c->len, from, pump.sent, Now_Ns());
+            }
+            // A wire image ends on its byte count, not on silence
+            if (McuPump_BodyDone(&pump)) break;
+        }
+    }
+
+    if (!firmware && tFirst) {
+        uint32_t from = pump.sent;
+        c0 = Cpu_Ns();
+        McuPump_Finish(&pump);
+        cpuTarget += Cpu_Ns() - c0;
+        Stamp(tOut, nChunks, c->len, from, pump.sent, Now_Ns());
+    }
+    tEnd = Now_Ns();
+    getrusage(RUSAGE_SELF, &after);
+
+    wait4(host, &status, 0, &ru);
+    r->cpuHostS = Rusage_S(&ru);
+    if (firmware) {
+        wait4(sink, &status, 0, &ru);
+        r->cpuSinkS = Rusage_S(&ru);
+        // The session ends when the bootloader has the last byte
+        if (tSink[nChunks - 1] > tEnd) tEnd = tSink[nChunks - 1];
+    }
+
+    r->wallS = (double)(tEnd - t0) / 1e9;
+    r->bytesPerS = r->wallS > 0 ? (double)c->len / r->wallS : 0;
+    r->streamBytesPerS = tLast > tFirst ? (double)c->len / ((double)(tLast - tFirst) / 1e9) : 0;
+    r->firstByteMs = tFirst ? (double)(tFirst - t0) / 1e6 : 0;
+    r->tailMs = tLast ? (double)(tEnd - tLast) / 1e6 : 0;
+    r->cpuMcuS = Rusage_S(&after) - Rusage_S(&before);
+    r->cpuTargetS = (double)cpuTarget / 1e9;
+    r->ring = ring.mon;
+
+    // The pump's last chunk waits out the silence timeout: kept out of the stage figures
+    r->stage[STAGE_HOST_TO_RING] = Latency(tWrite, tRecv, nChunks);
+    r->stage[STAGE_RING_TO_OUT] = Latency(tRecv, tOut, firmware ? nChunks : nChunks - 1);
+    if (firmware) {
+        r->stage[STAGE_OUT_TO_TARGET] = Latency(tOut, tSink, nChunks);
+        r->stage[STAGE_END_TO_END] = Latency(tWrite, tSink, nChunks);
+        r->pass = sh->sinkMatch && sh->sinkHandshake == 2;   // 'u' and 'e'; the abort key is not one
+    } else {
+        r->stage[STAGE_END_TO_END] = Latency(tWrite, tOut, nChunks - 1);
+        r->tck = m.tckCount;
+        r->streamBits = tap.diagStreamBits;
+        r->pass = (tap.leds & LED_PROG_5) && ring.consumed == c->len;   // Wire header included
+    }
+
+    McuRing_Free(&ring);
+    free(tRecv); free(tOut);
+    munmap(tWrite, shBytes);
+    PtyLink_Close(&u2);
+    if (firmware) PtyLink_Close(&u1);
+    return 0;
+
+fail:
+    if (host > 0) { kill(host, SIGKILL); waitpid(host, &status, 0); }
+    if (sink > 0) { kill(sink, SIGKILL); waitpid(sink, &status, 0); }
+    McuRing_Free(&ring);
+    free(tRecv); free(tOut);
+    munmap(tWrite, shBytes);
+    PtyLink_Close(&u2);
+    if (firmware) PtyLink_Close(&u1);
+    return -1;
+}
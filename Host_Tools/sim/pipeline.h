@@ -0,0 +1,72 @@
+/*
+ * Host -> MCU -> FPGA pipeline over pseudo-terminals
+ * - Host uploader: a child process that opens the USART2 pty by name and
+ *   writes the file the way `cat output1.bin > /dev/ttyACM0` does,
+ *   optionally paced to a baud rate
+ * - MCU: this process; USART2 DMA ring (McuRing), then either the bitstream
+ *   pump into a Gowin TAP model or the firmware bridge out of USART1
+ * - FPGA bootloader (firmware only): a child process on the USART1 pty
+ *   that checks every byte it receives against the file
+ * - Every LAT_CHUNK bytes are time-stamped at each stage boundary
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "ring_monitor.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PIPE_LAT_CHUNK 256
+
+typedef enum { PIPE_BITSTREAM, PIPE_FIRMWARE } PipeMode;
+
+typedef enum {
+    STAGE_HOST_TO_RING,   // Host write() to the byte landing in DMA_Buffer
+    STAGE_RING_TO_OUT,    // DMA_Buffer to SPI (pump) or USART1 TDR (bridge)
+    STAGE_OUT_TO_TARGET,  // USART1 to the bootloader (firmware only)
+    STAGE_END_TO_END,
+    PIPE_STAGES
+} PipeStage;
+
+typedef struct {
+    PipeMode       mode;
+    const uint8_t *data;
+    size_t         len;
+    uint32_t       ringSize;     // DMA_Buffer size (utils.Buffer_Size)
+    uint32_t       chunk;        // Bytes per host write()
+    uint32_t       baud;         // Host pacing, 10 bits per byte; 0 = as fast as the pty takes it
+    uint32_t       idleMs;       // Silence that ends the session (Stable_Threshold)
+    uint32_t       handshakeMs;  // Bootloader banner delay after power-up (FPGA boot)
+} PipeConfig;
+
+typedef struct {
+    uint32_t n;
+    double   min, avg, p50, p99, max;   // Microseconds
+} PipeLatency;
+
+typedef struct {
+    int         pass;            // TAP reports DONE / bootloader got the exact file
+    size_t      bytes;
+    double      wallS;           // First host write to the end of the session
+    double      bytesPerS;       // bytes / wallS
+    double      streamBytesPerS; // First to last byte into DMA_Buffer
+    double      firstByteMs;     // First host write to the first byte in the ring
+    double      tailMs;          // Last byte in the ring to the end of the session
+    double      handshakeMs;     // Firmware: power-up to the bootloader taking the image
+    PipeLatency stage[PIPE_STAGES];
+    double      cpuHostS;        // Uploader process
+    double      cpuMcuS;         // MCU process, target model included
+    double      cpuTargetS;      // Of which the TAP model and JTAG master
+    double      cpuSinkS;        // Bootloader process
+    RingMonitor ring;            // DMA_Buffer as the firmware would report it
+    uint64_t    tck;
+    uint32_t    streamBits;      // DR bits the TAP counted in the bitstream
+} PipeResult;
+
+// 0 when the run completed (pass or not), -1 if the ptys or children failed
+int         Pipeline_Run(const PipeConfig *c, PipeResult *r);
+const char *Pipeline_StageName(PipeStage s);
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Pseudo-terminal serial link
+ */
+
+#define _XOPEN_SOURCE 600   // posix_openpt / grantpt / ptsname
+
+#include "pty_link.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+static int Make_Raw(int fd) {
+    struct termios t;
+    if (tcgetattr(fd, &t) < 0) return -1;
+    cfmakeraw(&t);
+    return tcsetattr(fd, TCSANOW, &t);
+}
+
+int PtyLink_Open(PtyLink *p) {
+    const char *name;
+    memset(p, 0, sizeof(*p));
+    p->slave = -1;
+    p->master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (p->master < 0) return -1;
+    if (grantpt(p->master) < 0 || unlockpt(p->master) < 0 || !(name = ptsname(p->master))) goto fail;
+    snprintf(p->path, sizeof(p->path), "%s", name);
+    if ((p->slave = open(p->path, O_RDWR | O_NOCTTY)) < 0) goto fail;
+    if (Make_Raw(p->slave) < 0 || Make_Raw(p->master) < 0) goto fail;
+    if (fcntl(p->master, F_SETFL, fcntl(p->master, F_GETFL) | O_NONBLOCK) < 0) goto fail;
+    return 0;
+fail:
+    PtyLink_Close(p);
+    return -1;
+}
+
+void PtyLink_Close(PtyLink *p) {
+    if (p->slave >= 0) close(p->slave);
+    if (p->master >= 0) close(p->master);
+    p->slave = p->master = -1;
+}
+
+int PtyLink_OpenPort(const char *path) {
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0) return -1;
+    if (Make_Raw(fd) < 0) { close(fd); return -1; }
+    return fd;
+}
+
+int PtyLink_SetBaud(int fd, uint32_t baud) {
+    static const struct { uint32_t baud; speed_t speed; } Speeds[] = {
+        { 9600, B9600 }, { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 }, { 115200, B115200 },
+        { 230400, B230400 }, { 460800, B460800 }, { 921600, B921600 }, { 1000000, B1000000 },
+        { 1500000, B1500000 }, { 2000000, B2000000 }, { 3000000, B3000000 }
+    };
+    struct termios t;
+    size_t i;
+    for (i = 0; i < sizeof(Speeds) / sizeof(Speeds[0]); i++) {
+        if (Speeds[i].baud != baud) continue;
+        if (tcgetattr(fd, &t) < 0) return -1;
+        cfsetispeed(&t, Speeds[i].speed);
+        cfsetospeed(&t, Speeds[i].speed);
+        return tcsetattr(fd, TCSANOW, &t);
+    }
+    return -1;
+}
+
+int PtyLink_WriteAll(int fd, const uint8_t *buf, size_t len) {
+    while (len) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n; len -= (size_t)n;
+    }
+    return 0;
+}
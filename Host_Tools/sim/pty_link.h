@@ -0,0 +1,34 @@
+/*
+ * Pseudo-terminal serial link
+ * - Stands in for a USB CDC port (/dev/ttyACM0) or a UART between two
+ *   boards: the device side keeps the master, the host side opens the
+ *   slave by name and talks to it exactly as it would to the real port
+ * - Both ends raw (stty raw -echo), the device end non-blocking
+ */
+
+#ifndef PTY_LINK_H
+#define PTY_LINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    int  master;          // Device side (the MCU model's USART)
+    int  slave;           // Held open so the device never sees a hangup
+    char path[64];        // What the host opens instead of /dev/ttyACMx
+} PtyLink;
+
+int  PtyLink_Open(PtyLink *p);   // 0, or -1 with errno set
+void PtyLink_Close(PtyLink *p);
+
+// Host side: open a port by name, raw, blocking (stty -F path raw -echo)
+int  PtyLink_OpenPort(const char *path);
+
+// Both directions to one of the standard rates (up to 3000000); -1 if
+// the rate has no termios speed or the port refuses it
+int  PtyLink_SetBaud(int fd, uint32_t baud);
+
+// Write all of buf to a blocking fd; -1 on error
+int  PtyLink_WriteAll(int fd, const uint8_t *buf, size_t len);
+
+#endif
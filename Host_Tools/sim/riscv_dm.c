@@ -0,0 +1,174 @@
+/*
+ * Host-side NEORV32 on-chip debugger model
+ */
+
+#include "riscv_dm.h"
+#include "tap_chain.h"
+
+#include <string.h>
+
+// --- DEBUG MODULE ---
+static uint32_t Dm_Status(const RvDm *d) {
+    uint32_t s = 2u | (1u << 7);   // version 0.13, authenticated
+    if (d->halted) s |= RV_STAT_ALLHALTED | (1u << 8);
+    else s |= RV_STAT_ALLRUNNING | (1u << 10);
+    if (d->resumeAck) s |= RV_STAT_ALLRESUMEACK | (1u << 16);
+    return s;
+}
+
+static uint32_t Sb_Cs(const RvDm *d) {
+    if (!d->sba) return 0;
+    return RV_SBCS_VERSION1 | d->sbcs | (32u << 5) | RV_SBCS_CAN32;   // sbasize 32
+}
+
+static void Sb_Write(RvDm *d, uint32_t value) {
+    uint32_t off = d->sbAddress - RV_IMEM_BASE;
+    if ((d->sbcs >> RV_SBCS_ERROR_SHIFT) & 7u) return;   // Ignored until cleared
+    if ((d->sbcs & (7u << 17)) != RV_SBCS_ACCESS32) { d->sbcs |= 4u << RV_SBCS_ERROR_SHIFT; return; }
+    if (off >= RV_IMEM_SIZE || (off & 3u)) { d->sbcs |= 2u << RV_SBCS_ERROR_SHIFT; return; }
+    d->mem[off / 4] = value;
+    d->sbWrites++;
+    if (d->sbcs & RV_SBCS_AUTOINCREMENT) d->sbAddress += 4;
+}
+
+static void Dm_Command(RvDm *d, uint32_t cmd) {
+    if (d->cmdErr) return;
+    if ((cmd >> 24) != 0 || (cmd & (7u << 20)) != RV_CMD_AARSIZE32) { d->cmdErr = 2; return; }
+    if (!d->halted) { d->cmdErr = 4; return; }
+    if (!(cmd & RV_CMD_TRANSFER)) return;
+    if ((cmd & 0xFFFFu) != RV_CSR_DPC || !(cmd & RV_CMD_WRITE)) { d->cmdErr = 2; return; }
+    d->dpc = d->data0;
+}
+
+static uint32_t Dm_Read(RvDm *d, uint32_t addr) {
+    switch (addr) {
+        case RV_DM_DATA0:      return d->data0;
+        case RV_DM_CONTROL:    return d->control;
+        case RV_DM_STATUS:     return Dm_Status(d);
+        case RV_DM_ABSTRACTCS: return (2u << 24) | ((uint32_t)d->cmdErr << RV_ACS_CMDERR_SHIFT) | 1u;
+        case RV_DM_SBCS:       return Sb_Cs(d);
+        case RV_DM_SBADDRESS0: return d->sba ? d->sbAddress : 0;
+        default:               return 0;
+    }
+}
+
+static void Dm_Write(RvDm *d, uint32_t addr, uint32_t value) {
+    if (addr != RV_DM_CONTROL && !(d->control & RV_CTRL_DMACTIVE)) return;
+    switch (addr) {
+        case RV_DM_DATA0: d->data0 = value; break;
+        case RV_DM_CONTROL:
+            d->control = value & RV_CTRL_DMACTIVE;
+            if (!(value & RV_CTRL_DMACTIVE)) { d->cmdErr = 0; d->sbcs = 0; break; }
+            if (value & RV_CTRL_HALTREQ) { d->halted = 1; d->resumeAck = 0; }
+            else if ((value & RV_CTRL_RESUMEREQ) && d->halted) {
+                d->halted = 0;
+                d->resumeAck = 1;
+                d->resumes++;
+                d->entry = d->dpc;
+            }
+            break;
+        case RV_DM_ABSTRACTCS:
+            d->cmdErr &= (uint8_t)~((value >> RV_ACS_CMDERR_SHIFT) & 7u);   // W1C
+            break;
+        case RV_DM_COMMAND: Dm_Command(d, value); break;
+        case RV_DM_SBCS:
+            if (!d->sba) break;
+            d->sbcs &= ~((value & RV_SBCS_BUSYERROR) | (value & (7u << RV_SBCS_ERROR_SHIFT)));
+            d->sbcs = (d->sbcs & (RV_SBCS_BUSYERROR | (7u << RV_SBCS_ERROR_SHIFT)))
+                    | (value & ((7u << 17) | RV_SBCS_AUTOINCREMENT));
+            break;
+        case RV_DM_SBADDRESS0: if (d->sba) d->sbAddress = value; break;
+        case RV_DM_SBDATA0:    if (d->sba) Sb_Write(d, value); break;
+        default: break;
+    }
+}
+
+// --- DTM ---
+static uint64_t Dtmcs(const RvDm *d) {
+    return 1u | ((uint32_t)RV_ABITS << 4) | ((uint32_t)d->dmiStat << 10);
+}
+
+static void Dtm_Capture(RvDm *d) {
+    switch (d->ir) {
+        case RV_IR_IDCODE: d->drShift = RV_DTM_IDCODE; break;
+        case RV_IR_DTMCS:  d->drShift = Dtmcs(d); break;
+        case RV_IR_DMI:
+            // Capturing while an access runs is what makes dmistat sticky
+            if (d->busyLeft) { d->dmiStat = RV_DMI_BUSY; d->busyHits++; }
+            d->drShift = ((uint64_t)d->lastData << 2) | (d->dmiStat ? RV_DMI_BUSY : d->lastOp);
+            break;
+        default: d->drShift = 0; break;
+    }
+}
+
+static int Dtm_Length(const RvDm *d) {
+    switch (d->ir) {
+        case RV_IR_IDCODE: case RV_IR_DTMCS: return 32;
+        case RV_IR_DMI: return RV_DMI_BITS;
+        default: return 1;
+    }
+}
+
+static void Dtm_Update(RvDm *d) {
+    if (d->ir == RV_IR_DTMCS) {
+        if (d->drShift & RV_DTMCS_DMIRESET) d->dmiStat = 0;
+    } else if (d->ir == RV_IR_DMI && !d->dmiStat) {
+        uint32_t op = (uint32_t)(d->drShift & 3u);
+        uint32_t data = (uint32_t)(d->drShift >> 2);
+        uint32_t addr = (uint32_t)(d->drShift >> 34) & ((1u << RV_ABITS) - 1u);
+        if (op == RV_DMI_NOP) return;
+        d->dmiAccesses++;
+        d->lastOp = 0;
+        if (op == RV_DMI_READ) d->lastData = Dm_Read(d, addr);
+        else if (op == RV_DMI_WRITE) Dm_Write(d, addr, data);
+        else d->lastOp = 2;
+        d->busyLeft = d->busyTcks;
+    }
+}
+
+void RvDm_Init(RvDm *d, int sba, uint32_t busyTcks) {
+    memset(d, 0, sizeof(*d));
+    d->tapState = TAP_RESET;
+    d->ir = RV_IR_IDCODE;
+    d->sba = (uint8_t)(sba != 0);
+    d->busyTcks = busyTcks;
+}
+
+uint8_t RvDm_Clock(RvDm *d, uint8_t tms, uint8_t tdi) {
+    uint8_t presented = d->tdo;
+    int len;
+
+    if (d->busyLeft) d->busyLeft--;
+    switch (d->tapState) {
+        case TAP_CAPTURE_DR:
+            Dtm_Capture(d);
+            d->tdo = d->drShift & 1u;
+            break;
+        case TAP_SHIFT_DR:
+            len = Dtm_Length(d);
+            d->drShift = (d->drShift >> 1) | ((uint64_t)tdi << (len - 1));
+            d->tdo = d->drShift & 1u;
+            break;
+        case TAP_UPDATE_DR:
+            Dtm_Update(d);
+            break;
+        case TAP_CAPTURE_IR:
+            d->irShift = 0x01;
+            d->tdo = 1;
+            break;
+        case TAP_SHIFT_IR:
+            d->irShift = (uint8_t)((d->irShift >> 1) | (tdi << (RV_IR_LEN - 1)));
+            d->tdo = d->irShift & 1u;
+            break;
+        case TAP_UPDATE_IR:
+            d->ir = d->irShift;
+            break;
+        default: break;
+    }
+    d->tapState = Tap_NextState(d->tapState, tms);
+    if (d->tapState == TAP_RESET) d->ir = RV_IR_IDCODE;
+    d->tckCount++;
+    return presented;
+}
+
+uint8_t RvDm_ClockFn(void *dm, uint8_t tms, uint8_t tdi) { return RvDm_Clock((RvDm *)dm, tms, tdi); }
@@ -0,0 +1,61 @@
+/*
+ * Host-side NEORV32 on-chip debugger model (RISC-V Debug Spec 0.13)
+ * - The JTAG DTM: 5-bit IR, IDCODE / DTMCS / DMI / BYPASS, abits 7
+ * - Just enough of the debug module to load a program: dmcontrol halt and
+ *   resume, dmstatus, an abstract write of dpc from data0, and system bus
+ *   access (32-bit, auto-increment) into the instruction memory
+ * - A DMI access keeps the DM busy for busyTcks edges; starting another
+ *   one before then latches dmistat busy until DTMCS.dmireset, as in the spec
+ * - Clock it once per TCK rising edge, like GowinTap
+ */
+
+#ifndef RISCV_DM_H
+#define RISCV_DM_H
+
+#include "gowin_tap.h"
+#include "riscv_debug.h"   // Register map
+
+#include <stdint.h>
+
+#define RV_ABITS       7
+#define RV_DMI_BITS    (RV_ABITS + 34)
+#define RV_DTM_IDCODE  0x00000001   // NEORV32 default: no JEDEC id
+#define RV_IMEM_SIZE   0x10000u
+
+typedef struct {
+    // DTM
+    TapState tapState;
+    uint8_t  ir, irShift;
+    uint64_t drShift;
+    uint8_t  tdo;
+    uint32_t busyTcks;      // Edges a DMI access takes (0 = done at Update-DR)
+    uint32_t busyLeft;
+    uint8_t  dmiStat;       // Sticky: 0 or RV_DMI_BUSY
+    uint8_t  lastOp;        // Status of the last completed access
+    uint32_t lastData;      // Its read data
+    // DM
+    uint8_t  sba;           // System bus access implemented (stock NEORV32: no)
+    uint32_t control;
+    uint8_t  halted, resumeAck;
+    uint32_t data0;
+    uint8_t  cmdErr;
+    uint32_t sbcs;          // sbaccess / sbautoincrement / sberror / sbbusyerror
+    uint32_t sbAddress;
+    uint32_t dpc;
+    uint32_t mem[RV_IMEM_SIZE / 4];
+    // Counters
+    uint64_t tckCount;
+    uint32_t dmiAccesses;
+    uint32_t busyHits;
+    uint32_t sbWrites;
+    uint32_t resumes;
+    uint32_t entry;         // dpc at the last resume
+} RvDm;
+
+void    RvDm_Init(RvDm *d, int sba, uint32_t busyTcks);
+
+// One TCK rising edge. Returns the TDO level the master samples on this edge
+uint8_t RvDm_Clock(RvDm *d, uint8_t tms, uint8_t tdi);
+uint8_t RvDm_ClockFn(void *dm, uint8_t tms, uint8_t tdi);   // As a JtagClockFn
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Session stage scheduling
+ */
+
+#include "session_sched.h"
+#include "neorv32_boot.h"
+#include "session_image.h"
+
+#include <string.h>
+
+void Sched_Defaults(SchedConfig *c, size_t bitsLen, size_t fwLen) {
+    memset(c, 0, sizeof(*c));
+    c->bitsLen = bitsLen;
+    c->fwLen = fwLen;
+    c->hostBaud = 230769;    // USART2's BRR mantissa 16#0D#: 48 MHz / 208
+    c->spiHz = 12000000;
+    c->flashUs = 52.5;       // STM32F070 tPROG, typical
+    c->trailerUs = 500;
+    c->switchMs = 500;
+    c->wakeMs = 100;
+    c->load = SCHED_BOOTLOADER;
+    c->targetBaud = 19200;
+    c->tckHz = 1000000;
+    c->tckPerWord = 46;      // One 41-bit DMI scan and five TAP moves (test_riscv_debug)
+    c->ringSize = 4096;
+}
+
+const char *Sched_StageName(SchedStage s) {
+    static const char *Names[SCHED_STAGES] = { "link", "shift", "stage", "wait", "upload" };
+    return s < SCHED_STAGES ? Names[s] : "?";
+}
+
+static double Byte_Ms(uint32_t baud) { return 10000.0 / baud; }
+
+// Executable into the target once it is ready, the image already at hand
+static double Upload_Ms(const SchedConfig *c) {
+    if (c->load == SCHED_BOOTLOADER) return (double)c->fwLen * Byte_Ms(c->targetBaud);
+    return (double)((c->fwLen - NEORV32_HEADER_SIZE) / 4 + 6) * c->tckPerWord * 1000.0 / c->tckHz;
+}
+
+static double Max(double a, double b) { return a > b ? a : b; }
+
+static void Bound(const SchedConfig *c, SchedTimeline *t) {
+    double bits = (double)(c->bitsLen + 15) * Byte_Ms(c->hostBaud) + c->trailerUs / 1000.0;
+    double fw = c->load == SCHED_BOOTLOADER ? Upload_Ms(c) : Max(Upload_Ms(c), (double)c->fwLen * Byte_Ms(c->hostBaud));
+    t->boundMs = Max(bits, fw);
+}
+
+void Sched_Sequential(const SchedConfig *c, SchedTimeline *t) {
+    double bms = Byte_Ms(c->hostBaud), second, ready, upload;
+    size_t wire = c->bitsLen + 15;   // Wire header and body
+
+    memset(t, 0, sizeof(*t));
+    // The pump keeps up with the link: the last byte shifts as it lands
+    t->stage[SCHED_SHIFT].start = 17 * bms;
+    t->stage[SCHED_SHIFT].end = wire * bms + 8000.0 / c->spiHz + c->trailerUs / 1000.0;
+    second = t->stage[SCHED_SHIFT].end + c->switchMs;
+    if (c->load == SCHED_BOOTLOADER) {
+        // Bridged: the host goes down to 19200 and the bootloader sets the pace
+        ready = Max(t->stage[SCHED_SHIFT].end + c->wakeMs, second);
+        upload = Upload_Ms(c);
+        t->stage[SCHED_LINK].end = ready + upload;
+    } else {
+        ready = second;
+        upload = Max(Upload_Ms(c), (double)c->fwLen * bms);
+        t->stage[SCHED_LINK].end = second + (double)c->fwLen * bms;
+    }
+    t->stage[SCHED_WAIT] = (SchedSpan){ t->stage[SCHED_SHIFT].end, ready };
+    t->stage[SCHED_UPLOAD] = (SchedSpan){ ready, ready + upload };
+    t->totalMs = ready + upload;
+    t->ringHighWater = 1;
+    Bound(c, t);
+}
+
+void Sched_Overlapped(const SchedConfig *c, const uint8_t *image, size_t len, SchedTimeline *t) {
+    double bms = Byte_Ms(c->hostBaud), spi = 8000.0 / c->spiHz, flash = c->flashUs / 1000.0;
+    double mcu = 0, done = -1, ready;
+    size_t i = SESSION_HEADER_SIZE, frameLeft = 0, bodyLeft;
+    int shifting = 0, staging = 0;
+    uint8_t kind = 0;
+
+    memset(t, 0, sizeof(*t));
+    if (len < SESSION_HEADER_SIZE) return;
+    bodyLeft = (size_t)image[4] | (size_t)image[5] << 8 | (size_t)image[6] << 16 | (size_t)image[7] << 24;
+    t->stage[SCHED_LINK].end = (double)len * bms;
+    while (i < len) {
+        size_t take = 1, arrived;
+        if (frameLeft == 0) {
+            // A frame word: needs all four bytes, costs nothing to speak of
+            if (i + SESSION_FRAME_SIZE > len) break;
+            kind = image[i];
+            frameLeft = (size_t)image[i + 1] | (size_t)image[i + 2] << 8 | (size_t)image[i + 3] << 16;
+            i += SESSION_FRAME_SIZE;
+            mcu = Max(mcu, (double)i * bms);
+            continue;
+        }
+        if (kind == SESSION_FIRMWARE) {
+            take = frameLeft >= 2 ? 2 : 1;
+            mcu = Max(mcu, (double)(i + take) * bms) + flash;
+            if (!staging++) t->stage[SCHED_STAGE].start = mcu - flash;
+            t->stage[SCHED_STAGE].end = mcu;
+        } else {
+            mcu = Max(mcu, (double)(i + 1) * bms) + spi;
+            if (!shifting++) t->stage[SCHED_SHIFT].start = mcu - spi;
+            // The last body byte: trailer and status before anything else
+            if (--bodyLeft == 0) {
+                mcu += c->trailerUs / 1000.0;
+                done = mcu;
+            }
+        }
+        i += take;
+        frameLeft -= take;
+        // What the DMA has put in the ring meanwhile and the pump has not taken
+        arrived = (size_t)(mcu / bms);
+        if (arrived > len) arrived = len;
+        if (arrived > i && arrived - i > t->ringHighWater) t->ringHighWater = (uint32_t)(arrived - i);
+    }
+    if (done < 0) done = mcu + c->trailerUs / 1000.0;   // No body at all
+    t->stage[SCHED_SHIFT].end = done;
+
+    // Straight from DONE; the bootloader still has to come up first
+    ready = c->load == SCHED_BOOTLOADER ? Max(done + c->wakeMs, t->stage[SCHED_STAGE].end)
+                                        : Max(done, t->stage[SCHED_STAGE].end);
+    t->stage[SCHED_WAIT] = (SchedSpan){ done, ready };
+    t->stage[SCHED_UPLOAD] = (SchedSpan){ ready, ready + Upload_Ms(c) };
+    t->totalMs = ready + Upload_Ms(c);
+    Bound(c, t);
+}
@@ -0,0 +1,62 @@
+/*
+ * Session stage scheduling
+ * - Timeline of one bitstream + firmware session through the programmer,
+ *   from the first byte the host sends to the NEORV32 core started
+ * - Sequential: the wire image, then a second send of the executable once
+ *   the host has turned around (bridged through the bootloader at 19200,
+ *   or `dmload` at the host rate)
+ * - Overlapped: one session image (lib/session_image.h), walked byte by
+ *   byte as Stream_Session takes it: each byte no earlier than it arrives
+ *   at the host rate, bitstream bytes at the SPI rate, firmware half-words
+ *   at the flash programming time (the core stalls, so the pump waits
+ *   too); the upload starts from the stage at DONE
+ */
+
+#ifndef SESSION_SCHED_H
+#define SESSION_SCHED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum { SCHED_BOOTLOADER, SCHED_DEBUG } SchedLoad;
+
+typedef struct {
+    size_t    bitsLen, fwLen;
+    uint32_t  hostBaud;       // USART2, 10 bits per byte
+    uint32_t  spiHz;          // SPI1 clock, 8 bits per byte
+    double    flashUs;        // One half-word programmed
+    double    trailerUs;      // Last byte, trailing commands, status capture
+    uint32_t  switchMs;       // Sequential: host turnaround between the two sends
+    uint32_t  wakeMs;         // DONE to the bootloader's prompt
+    SchedLoad load;
+    uint32_t  targetBaud;     // Bootloader UART
+    uint32_t  tckHz;          // Debug: bit-banged TCK
+    uint32_t  tckPerWord;     // Debug: per image word, connect and resume ~6 words more
+    uint32_t  ringSize;       // DMA_Buffer
+} SchedConfig;
+
+typedef enum {
+    SCHED_LINK,       // First to last byte from the host
+    SCHED_SHIFT,      // First to last bitstream byte shifted, trailer included (DONE)
+    SCHED_STAGE,      // First to last firmware byte staged
+    SCHED_WAIT,       // DONE (or the executable) to the target ready
+    SCHED_UPLOAD,     // Executable into the target, core started
+    SCHED_STAGES
+} SchedStage;
+
+typedef struct { double start, end; } SchedSpan;   // ms from the first host byte
+
+typedef struct {
+    SchedSpan stage[SCHED_STAGES];
+    double    totalMs;
+    double    boundMs;        // max(bitstream alone, firmware alone)
+    uint32_t  ringHighWater;  // Bytes arrived but not taken, at worst
+} SchedTimeline;
+
+void        Sched_Defaults(SchedConfig *c, size_t bitsLen, size_t fwLen);
+void        Sched_Sequential(const SchedConfig *c, SchedTimeline *t);
+// `image` is the session image the host sends
+void        Sched_Overlapped(const SchedConfig *c, const uint8_t *image, size_t len, SchedTimeline *t);
+const char *Sched_StageName(SchedStage s);
+
+#endif
@@ -0,0 +1,147 @@
+/*
+ * SSPI protocol and timing checker
+ */
+
+#include "sspi_check.h"
+
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+void SspiChecker_Init(SspiChecker *c, uint32_t sckHz) {
+    memset(c, 0, sizeof(*c));
+    SspiTarget_Init(&c->t);
+    c->byteNs = (uint32_t)((8000000000ULL + sckHz - 1) / sckHz);
+}
+
+static void Sync(SspiChecker *c) {
+    c->r.seqErrors = c->t.eventCount[SSPI_EVT_ERR_SEQ];
+    c->r.timingErrors = c->t.eventCount[SSPI_EVT_ERR_TIMING];
+    c->r.unknownCmds = c->t.eventCount[SSPI_EVT_UNKNOWN];
+    c->r.done = c->t.done;
+    c->r.endNs = c->nowNs;
+}
+
+void SspiChecker_Begin(SspiChecker *c, uint64_t tNs) {
+    if (tNs < c->nowNs) c->r.traceErrors++;
+    else c->nowNs = tNs;
+    if (!c->t.ready) c->r.notReady++;
+    c->r.transactions++;
+    c->xferBytes = 0;
+    c->inBurst = 0;
+    SspiTarget_Select(&c->t, 1);
+}
+
+uint8_t SspiChecker_Byte(SspiChecker *c, uint8_t mosi) {
+    uint8_t miso;
+    int64_t slack;
+
+    c->nowNs += c->byteNs;
+    if (c->xferBytes == 0) {
+        if (mosi == SSPI_CMD_ERASE) { c->eraseNs = c->nowNs; c->haveErase = 1; }
+        if (mosi == SSPI_CMD_INIT_ADDR && c->haveErase) {
+            slack = (int64_t)(c->nowNs - c->eraseNs) - SSPI_MIN_ERASE_WAIT_NS;
+            if (!c->r.haveEraseSlack || slack < c->r.minEraseSlackNs) c->r.minEraseSlackNs = slack;
+            c->r.haveEraseSlack = 1;
+            c->haveErase = 0;
+        }
+        c->inBurst = (mosi == SSPI_CMD_WRITE_REQ);
+    } else if (c->inBurst) {
+        c->r.burstBytes++;
+    }
+    c->xferBytes++;
+    miso = SspiTarget_Transfer(&c->t, mosi, c->nowNs);
+    Sync(c);
+    return miso;
+}
+
+void SspiChecker_End(SspiChecker *c) {
+    SspiTarget_Select(&c->t, 0);
+    Sync(c);
+}
+
+void SspiChecker_Reconfig(SspiChecker *c, uint64_t tNs, uint8_t level) {
+    if (tNs < c->nowNs) c->r.traceErrors++;
+    else c->nowNs = tNs;
+    SspiTarget_Reconfig(&c->t, level);
+    Sync(c);
+}
+
+void SspiChecker_Feed(SspiChecker *c, const SspiTraceRec *rec) {
+    uint32_t i;
+    if (rec->kind == SSPI_TR_RECONFIG) { SspiChecker_Reconfig(c, rec->tNs, rec->level); return; }
+    SspiChecker_Begin(c, rec->tNs);
+    for (i = 0; i < rec->headLen; i++) SspiChecker_Byte(c, rec->head[i]);
+    for (i = 0; i < rec->burstLen; i++) SspiChecker_Byte(c, 0x00);
+    SspiChecker_End(c);
+}
+
+int SspiChecker_Failed(const SspiChecker *c) {
+    return c->r.seqErrors || c->r.timingErrors || c->r.notReady || c->r.traceErrors;
+}
+
+void SspiChecker_Print(const SspiChecker *c, FILE *f) {
+    const SspiReport *r = &c->r;
+    fprintf(f, "transactions       %" PRIu32 "\n", r->transactions);
+    fprintf(f, "burst bytes        %" PRIu32 "\n", r->burstBytes);
+    fprintf(f, "sequence errors    %" PRIu32 "\n", r->seqErrors);
+    fprintf(f, "timing errors      %" PRIu32 "\n", r->timingErrors);
+    fprintf(f, "not-READY xfers    %" PRIu32 "\n", r->notReady);
+    fprintf(f, "unknown commands   %" PRIu32 "\n", r->unknownCmds);
+    fprintf(f, "trace errors       %" PRIu32 "\n", r->traceErrors);
+    if (r->haveEraseSlack) fprintf(f, "erase->init slack  %+" PRId64 " ns\n", r->minEraseSlackNs);
+    else                   fprintf(f, "erase->init slack  n/a\n");
+    fprintf(f, "DONE               %s\n", r->done ? "yes" : "no");
+    fprintf(f, "session time       %.3f ms\n", (double)r->endNs / 1e6);
+    fprintf(f, "%s\n", SspiChecker_Failed(c) ? "FAIL" : "PASS");
+}
+
+int SspiTrace_Parse(const char *line, SspiTraceRec *rec) {
+    char *end;
+    unsigned long v;
+
+    while (isspace((unsigned char)*line)) line++;
+    if (*line == '\0' || *line == '#') return 0;
+
+    memset(rec, 0, sizeof(*rec));
+    rec->tNs = strtoull(line, &end, 10);
+    if (end == line) return -1;
+    line = end;
+
+    while (isspace((unsigned char)*line)) line++;
+    if (strncmp(line, "RECONFIG", 8) == 0) {
+        rec->kind = SSPI_TR_RECONFIG;
+        v = strtoul(line + 8, &end, 10);
+        if (end == line + 8 || v > 1) return -1;
+        rec->level = (uint8_t)v;
+        return 1;
+    }
+
+    rec->kind = SSPI_TR_XFER;
+    for (;;) {
+        while (isspace((unsigned char)*line)) line++;
+        if (*line == '\0' || *line == '#') break;
+        if (*line == '+') {
+            v = strtoul(line + 1, &end, 10);
+            if (end == line + 1) return -1;
+            rec->burstLen = (uint32_t)v;
+            line = end;
+            continue;
+        }
+        v = strtoul(line, &end, 16);
+        if (end == line || v > 0xFF || rec->headLen == SSPI_TRACE_HEAD || rec->burstLen) return -1;
+        rec->head[rec->headLen++] = (uint8_t)v;
+        line = end;
+    }
+    return rec->headLen ? 1 : -1;
+}
+
+void SspiTrace_Write(FILE *f, const SspiTraceRec *rec) {
+    uint8_t i;
+    fprintf(f, "%" PRIu64, rec->tNs);
+    if (rec->kind == SSPI_TR_RECONFIG) { fprintf(f, " RECONFIG %u\n", rec->level); return; }
+    for (i = 0; i < rec->headLen; i++) fprintf(f, " %02X", rec->head[i]);
+    if (rec->burstLen) fprintf(f, " +%" PRIu32, rec->burstLen);
+    fputc('\n', f);
+}
@@ -0,0 +1,81 @@
+/*
+ * SSPI protocol and timing checker
+ * - The SSPI target model driven by a timestamped SPI transaction trace
+ * - Reports sequence errors, timing violations and byte counts, plus the
+ *   slack left on the 4 ms erase wait so delays can be cut to the minimum
+ * - Fed either live (Begin / Byte / End) or from trace text lines
+ *
+ * Trace format, one CS-low transaction or pin change per line:
+ *   <t_ns> XX XX ...       bytes on MOSI, hex, at most SSPI_TRACE_HEAD
+ *   <t_ns> XX ... +N       ... followed by N more bytes (bitstream burst)
+ *   <t_ns> RECONFIG 0|1    RECONFIG_N level
+ *   # comment
+ * t_ns is the CS falling edge; byte k ends k byte-times later.
+ */
+
+#ifndef SSPI_CHECK_H
+#define SSPI_CHECK_H
+
+#include "sspi_target.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SSPI_TRACE_HEAD   8
+#define SSPI_DEFAULT_SCK  12000000   // SPI1 BR = 1 at 48 MHz
+
+typedef enum { SSPI_TR_XFER=0, SSPI_TR_RECONFIG } SspiTraceKind;
+
+typedef struct {
+    uint64_t      tNs;
+    SspiTraceKind kind;
+    uint8_t       level;                   // RECONFIG_N
+    uint8_t       head[SSPI_TRACE_HEAD];
+    uint8_t       headLen;
+    uint32_t      burstLen;                // Bytes after head
+} SspiTraceRec;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t burstBytes;       // Data bytes after WRITE REQ (0x3B)
+    uint32_t seqErrors;
+    uint32_t timingErrors;
+    uint32_t notReady;         // Transactions started while READY was low
+    uint32_t unknownCmds;
+    uint32_t traceErrors;      // Overlapping or backwards timestamps
+    int64_t  minEraseSlackNs;  // (INIT - ERASE) - 4 ms, smallest seen
+    int      haveEraseSlack;
+    int      done;
+    uint64_t endNs;
+} SspiReport;
+
+typedef struct {
+    SspiTarget t;
+    uint32_t   byteNs;
+    uint64_t   nowNs;          // End of the last byte clocked
+    uint64_t   eraseNs;
+    int        haveErase;
+    int        inBurst;
+    uint32_t   xferBytes;
+    SspiReport r;
+} SspiChecker;
+
+void    SspiChecker_Init(SspiChecker *c, uint32_t sckHz);
+
+// Live feed
+void    SspiChecker_Begin(SspiChecker *c, uint64_t tNs);
+uint8_t SspiChecker_Byte(SspiChecker *c, uint8_t mosi);
+void    SspiChecker_End(SspiChecker *c);
+void    SspiChecker_Reconfig(SspiChecker *c, uint64_t tNs, uint8_t level);
+
+// Trace feed
+void    SspiChecker_Feed(SspiChecker *c, const SspiTraceRec *rec);
+
+int     SspiChecker_Failed(const SspiChecker *c);
+void    SspiChecker_Print(const SspiChecker *c, FILE *f);
+
+// 1 = record, 0 = blank / comment, -1 = malformed
+int     SspiTrace_Parse(const char *line, SspiTraceRec *rec);
+void    SspiTrace_Write(FILE *f, const SspiTraceRec *rec);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Host-side Gowin SSPI (slave serial) target model
+ * - Same flowchart checks and read-back as SSPI_Emultaor/main.c
+ */
+
+#include "sspi_target.h"
+
+#include <string.h>
+
+static void Enqueue(SspiTarget *t, SspiEvent e) {
+    t->eventCount[e]++;
+    t->lastEvent = e;
+    EventRing_Push(&t->log, (uint8_t)e);
+}
+
+// Byte n (0 = first byte after the command) of a register read
+static uint8_t ResponseByte(const SspiTarget *t, uint32_t n) {
+    return (n >= 3 && n <= 6) ? (uint8_t)(t->respWord >> (8 * (6 - n))) : 0x00;
+}
+
+static void SequenceError(SspiTarget *t, uint8_t cmd) {
+    t->diagReceivedCmd = cmd;
+    t->diagExpectedState = t->protoState;
+    t->leds |= SSPI_LED_FAIL;
+    Enqueue(t, SSPI_EVT_ERR_SEQ);
+}
+
+void SspiTarget_Init(SspiTarget *t) {
+    memset(t, 0, sizeof(*t));
+    t->spiState = SSPI_SPI_IDLE;
+    t->protoState = SSPI_PROTO_IDLE;
+    t->ready = 1;
+    t->leds = SSPI_LED_PWR | SSPI_LED_RDY;
+    EventRing_Init(&t->log, 32);
+}
+
+void SspiTarget_Reconfig(SspiTarget *t, uint8_t level) {
+    if (!level) {
+        t->ready = 0; t->done = 0;
+        t->protoState = SSPI_PROTO_IDLE; t->spiState = SSPI_SPI_IDLE;
+        t->leds &= SSPI_LED_PWR;
+        Enqueue(t, SSPI_EVT_RESET);
+    } else if (!t->ready) {
+        t->ready = 1;
+        t->leds |= SSPI_LED_RDY;
+    }
+}
+
+void SspiTarget_Select(SspiTarget *t, uint8_t csLow) {
+    t->csLow = csLow;
+    t->spiState = csLow ? SSPI_SPI_CMD : SSPI_SPI_IDLE;
+}
+
+static void Command(SspiTarget *t, uint8_t cmd, uint64_t nowNs) {
+    t->lastCmd = cmd;
+
+    if (cmd == SSPI_CMD_ERASE) {
+        t->eraseTimeNs = nowNs; Enqueue(t, SSPI_EVT_ERASE);
+        t->protoState = SSPI_PROTO_ERASED;
+        t->spiState = SSPI_SPI_DUMMY; t->done = 0;
+    }
+    else if (cmd == SSPI_CMD_INIT_ADDR) {
+        if (t->protoState != SSPI_PROTO_ERASED) {
+            SequenceError(t, cmd);
+            t->protoState = SSPI_PROTO_INIT;   // Recovery, like the emulator
+        } else if (nowNs - t->eraseTimeNs < SSPI_MIN_ERASE_WAIT_NS) {
+            t->leds |= SSPI_LED_FAIL;
+            Enqueue(t, SSPI_EVT_ERR_TIMING);
+        } else {
+            t->leds |= SSPI_LED_ERS; t->protoState = SSPI_PROTO_INIT;
+        }
+        Enqueue(t, SSPI_EVT_INIT_ADDR);
+        t->spiState = SSPI_SPI_DUMMY;
+    }
+    else if (cmd == SSPI_CMD_ENABLE) {
+        if (t->protoState == SSPI_PROTO_INIT) t->protoState = SSPI_PROTO_WRITE_WAIT;
+        Enqueue(t, SSPI_EVT_ENABLE); t->spiState = SSPI_SPI_DUMMY;
+    }
+    else if (cmd == SSPI_CMD_WRITE_REQ) {
+        if (t->protoState != SSPI_PROTO_WRITE_WAIT) SequenceError(t, cmd);
+        t->protoState = SSPI_PROTO_WRITING;
+        t->byteCount = 0; t->leds |= SSPI_LED_WRT; Enqueue(t, SSPI_EVT_WRITE_START);
+        t->spiState = SSPI_SPI_BURST;
+    }
+    else if (cmd == SSPI_CMD_DISABLE) {
+        Enqueue(t, SSPI_EVT_DISABLE);
+        if (t->byteCount > SSPI_MIN_BURST_BYTES) {
+            t->done = 1; t->leds |= SSPI_LED_DONE; Enqueue(t, SSPI_EVT_DONE);
+        }
+        t->spiState = SSPI_SPI_DUMMY;
+    }
+    else if (cmd == SSPI_CMD_IDCODE) {
+        t->respWord = SSPI_ID_VAL; t->byteCount = 0;
+        Enqueue(t, SSPI_EVT_IDCODE); t->spiState = SSPI_SPI_READ_RSP;
+    }
+    else if (cmd == SSPI_CMD_READ_STATUS) {
+        t->respWord = SSPI_STATUS_BASE | (t->done ? SSPI_STATUS_DONE : 0);
+        t->byteCount = 0; Enqueue(t, SSPI_EVT_STATUS); t->spiState = SSPI_SPI_STATUS_RSP;
+    }
+    else {
+        if (cmd != 0xFF && cmd != 0xFE) { t->diagUnknownByte = cmd; Enqueue(t, SSPI_EVT_UNKNOWN); }
+        t->spiState = SSPI_SPI_DUMMY;
+    }
+}
+
+uint8_t SspiTarget_Transfer(SspiTarget *t, uint8_t mosi, uint64_t nowNs) {
+    uint8_t miso = 0x00;
+
+    if (!t->csLow) return 0x00;
+
+    switch (t->spiState) {
+        case SSPI_SPI_CMD:
+            Command(t, mosi, nowNs);
+            break;
+        case SSPI_SPI_BURST:
+            t->byteCount++;
+            break;
+        case SSPI_SPI_READ_RSP:
+        case SSPI_SPI_STATUS_RSP:
+            miso = ResponseByte(t, t->byteCount);
+            t->byteCount++;
+            break;
+        default:
+            break;
+    }
+    return miso;
+}
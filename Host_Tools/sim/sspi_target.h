@@ -0,0 +1,95 @@
+/*
+ * Host-side Gowin SSPI (slave serial) target model
+ * - Port of the MSP432 SSPI_Emultaor PORT5_IRQHandler to plain C
+ * - Byte level: one SspiTarget_Transfer = eight SCK edges with CS low
+ * - Time comes from the caller in nanoseconds (the emulator uses SysTick)
+ * - LED progress bits and events are kept in the struct instead of Port 4 / UART;
+ *   the log queue is the emulator's 32-entry ring, counts are exact
+ */
+
+#ifndef SSPI_TARGET_H
+#define SSPI_TARGET_H
+
+#include "event_ring.h"
+
+#include <stdint.h>
+
+// --- LED PROGRESS BAR (same bits as the emulator's Port 4) ---
+#define SSPI_LED_PWR   0x01  // Power/Reset
+#define SSPI_LED_RDY   0x02  // READY asserted
+#define SSPI_LED_ERS   0x04  // Erase + 4 ms wait validated by INIT ADDR
+#define SSPI_LED_WRT   0x08  // Burst write active
+#define SSPI_LED_DONE  0x10  // Configuration done
+#define SSPI_LED_FAIL  0x20  // Timing or sequence error
+
+// --- COMMANDS ---
+#define SSPI_CMD_READ_STATUS 0x41
+#define SSPI_CMD_IDCODE      0x11
+#define SSPI_CMD_ENABLE      0x15
+#define SSPI_CMD_ERASE       0x05
+#define SSPI_CMD_INIT_ADDR   0x12
+#define SSPI_CMD_WRITE_REQ   0x3B
+#define SSPI_CMD_DISABLE     0x3A
+
+// --- READ-BACK (3 dummy bytes, then 32 bits MSB first) ---
+#define SSPI_ID_VAL          0x1100481B
+#define SSPI_STATUS_BASE     0x00019000
+#define SSPI_STATUS_DONE     0x00002000
+
+// --- TIMING ---
+#define SSPI_MIN_ERASE_WAIT_NS 4000000  // MIN_ERASE_WAIT_TICKS at 48 MHz
+#define SSPI_MIN_BURST_BYTES   100      // DONE needs more than this after 0x3B
+
+typedef enum {
+    SSPI_SPI_IDLE=0, SSPI_SPI_CMD, SSPI_SPI_DUMMY, SSPI_SPI_BURST, SSPI_SPI_READ_RSP, SSPI_SPI_STATUS_RSP
+} SspiSpiState;
+
+typedef enum {
+    SSPI_PROTO_IDLE=0,     // Waiting for ERASE
+    SSPI_PROTO_ERASED,     // Waiting for INIT ADDR
+    SSPI_PROTO_INIT,       // Waiting for WRITE ENABLE (0x15)
+    SSPI_PROTO_WRITE_WAIT, // Waiting for WRITE REQ (0x3B)
+    SSPI_PROTO_WRITING     // Writing Data
+} SspiProtoState;
+
+// --- EVENTS (same ids as the emulator's queue) ---
+typedef enum {
+    SSPI_EVT_NONE=0, SSPI_EVT_ENABLE, SSPI_EVT_ERASE, SSPI_EVT_INIT_ADDR, SSPI_EVT_IDCODE,
+    SSPI_EVT_STATUS, SSPI_EVT_WRITE_START, SSPI_EVT_DISABLE, SSPI_EVT_UNKNOWN,
+    SSPI_EVT_ERR_SEQ, SSPI_EVT_ERR_TIMING, SSPI_EVT_RESET, SSPI_EVT_DONE, SSPI_EVT_COUNT
+} SspiEvent;
+
+typedef struct {
+    SspiSpiState   spiState;
+    SspiProtoState protoState;
+    uint8_t        lastCmd;
+    uint32_t       byteCount;
+    uint32_t       respWord;
+    uint64_t       eraseTimeNs;
+    uint8_t        csLow;
+    uint8_t        ready;        // READY pin
+    uint8_t        done;         // DONE pin (internalDoneFlag)
+
+    // Diagnostics
+    uint8_t        leds;
+    uint8_t        diagReceivedCmd;
+    SspiProtoState diagExpectedState;
+    uint8_t        diagUnknownByte;
+    uint32_t       eventCount[SSPI_EVT_COUNT];
+    SspiEvent      lastEvent;
+    EventRing      log;          // What the main loop would print
+} SspiTarget;
+
+// Powered with the mode pins at 001: READY is already high
+void    SspiTarget_Init(SspiTarget *t);
+
+// RECONFIG_N level: low resets the target and drops READY/DONE
+void    SspiTarget_Reconfig(SspiTarget *t, uint8_t level);
+
+// CS edge: csLow = 1 starts a command, 0 ends it (and aborts a burst)
+void    SspiTarget_Select(SspiTarget *t, uint8_t csLow);
+
+// One byte in on MOSI at time nowNs (the 8th SCK edge); returns the byte the master reads on MISO
+uint8_t SspiTarget_Transfer(SspiTarget *t, uint8_t mosi, uint64_t nowNs);
+
+#endif
@@ -0,0 +1,108 @@
+/*
+ * Host-side JTAG chain model
+ */
+
+#include "tap_chain.h"
+
+#include <string.h>
+
+static const uint8_t nextOnTms0[16] = {
+    TAP_IDLE, TAP_IDLE, TAP_CAPTURE_DR, TAP_SHIFT_DR, TAP_SHIFT_DR, TAP_PAUSE_DR,
+    TAP_PAUSE_DR, TAP_SHIFT_DR, TAP_IDLE, TAP_CAPTURE_IR, TAP_SHIFT_IR, TAP_SHIFT_IR,
+    TAP_PAUSE_IR, TAP_PAUSE_IR, TAP_SHIFT_IR, TAP_IDLE
+};
+static const uint8_t nextOnTms1[16] = {
+    TAP_RESET, TAP_SELECT_DR, TAP_SELECT_IR, TAP_EXIT1_DR, TAP_EXIT1_DR, TAP_UPDATE_DR,
+    TAP_EXIT2_DR, TAP_UPDATE_DR, TAP_SELECT_DR, TAP_RESET, TAP_EXIT1_IR, TAP_EXIT1_IR,
+    TAP_UPDATE_IR, TAP_EXIT2_IR, TAP_UPDATE_IR, TAP_SELECT_DR
+};
+
+TapState Tap_NextState(TapState s, uint8_t tms) {
+    return (TapState)(tms ? nextOnTms1[s] : nextOnTms0[s]);
+}
+
+// --- GENERIC TAP ---
+static uint32_t Generic_AllOnes(const GenericTap *g) {
+    return (g->irLength >= 32) ? 0xFFFFFFFFu : ((1u << g->irLength) - 1u);
+}
+
+static void Generic_Reset(GenericTap *g) {
+    g->tapState = TAP_RESET;
+    // IEEE 1149.1: IDCODE if present, otherwise BYPASS
+    g->irLatched = g->idcode ? 0x01 : Generic_AllOnes(g);
+}
+
+static void Generic_Clock(GenericTap *g, uint8_t tms, uint8_t tdi) {
+    switch (g->tapState) {
+        case TAP_CAPTURE_DR:
+            if (g->idcode && g->irLatched == 0x01) { g->drShiftBuf = g->idcode; g->drLength = 32; }
+            else { g->drShiftBuf = 0; g->drLength = 1; }
+            g->tdo = g->drShiftBuf & 0x01;
+            break;
+        case TAP_SHIFT_DR:
+            g->drShiftBuf = (g->drShiftBuf >> 1) | ((uint32_t)tdi << (g->drLength - 1));
+            g->tdo = g->drShiftBuf & 0x01;
+            break;
+        case TAP_CAPTURE_IR:
+            g->irShiftBuf = 0x01;
+            g->tdo = 1;
+            break;
+        case TAP_SHIFT_IR:
+            g->irShiftBuf = (g->irShiftBuf >> 1) | ((uint32_t)tdi << (g->irLength - 1));
+            g->tdo = g->irShiftBuf & 0x01;
+            break;
+        case TAP_UPDATE_IR:
+            g->irLatched = g->irShiftBuf;
+            break;
+        default: break;
+    }
+    g->tapState = Tap_NextState(g->tapState, tms);
+    if (g->tapState == TAP_RESET) Generic_Reset(g);
+}
+
+// --- CHAIN ---
+void TapChain_Init(TapChain *c) { memset(c, 0, sizeof(*c)); }
+
+int TapChain_AddGowin(TapChain *c) {
+    if (c->count >= TAP_CHAIN_MAX) return -1;
+    c->dev[c->count].kind = TAP_KIND_GOWIN;
+    GowinTap_Init(&c->dev[c->count].u.gowin);
+    return c->count++;
+}
+
+int TapChain_AddGeneric(TapChain *c, uint8_t irLength, uint32_t idcode) {
+    if (c->count >= TAP_CHAIN_MAX || irLength < 2 || irLength > 32) return -1;
+    GenericTap *g = &c->dev[c->count].u.generic;
+    c->dev[c->count].kind = TAP_KIND_GENERIC;
+    memset(g, 0, sizeof(*g));
+    g->irLength = irLength;
+    g->idcode = idcode;
+    Generic_Reset(g);
+    return c->count++;
+}
+
+GowinTap *TapChain_Gowin(TapChain *c, int index) {
+    if (index < 0 || index >= c->count || c->dev[index].kind != TAP_KIND_GOWIN) return 0;
+    return &c->dev[index].u.gowin;
+}
+
+static uint8_t Slot_Tdo(const ChainSlot *s) { return (s->kind == TAP_KIND_GOWIN) ? s->u.gowin.tdo : s->u.generic.tdo; }
+
+uint8_t TapChain_Tdo(const TapChain *c) { return (c->count > 0) ? Slot_Tdo(&c->dev[0]) : 0; }
+
+uint8_t TapChain_Clock(TapChain *c, uint8_t tms, uint8_t tdi) {
+    uint8_t presented[TAP_CHAIN_MAX];
+    int i;
+
+    // Every TAP samples its neighbour's TDO as driven before this edge
+    for (i = 0; i < c->count; i++) presented[i] = Slot_Tdo(&c->dev[i]);
+    for (i = 0; i < c->count; i++) {
+        uint8_t in = (i == c->count - 1) ? tdi : presented[i + 1];
+        if (c->dev[i].kind == TAP_KIND_GOWIN) GowinTap_Clock(&c->dev[i].u.gowin, tms, in);
+        else Generic_Clock(&c->dev[i].u.generic, tms, in);
+    }
+    c->tckCount++;
+    return (c->count > 0) ? presented[0] : tdi;
+}
+
+uint8_t TapChain_ClockFn(void *chain, uint8_t tms, uint8_t tdi) { return TapChain_Clock((TapChain *)chain, tms, tdi); }
@@ -0,0 +1,56 @@
+/*
+ * Host-side JTAG chain model
+ * - N TAPs sharing TCK/TMS, TDI -> device[count-1] -> ... -> device[0] -> TDO
+ * - device[0] is the TAP nearest TDO (first IDCODE shifted out, Ada Device 1)
+ * - Each slot is either a full Gowin model or a generic IEEE 1149.1 TAP
+ */
+
+#ifndef TAP_CHAIN_H
+#define TAP_CHAIN_H
+
+#include <stdint.h>
+
+#include "gowin_tap.h"
+
+#define TAP_CHAIN_MAX 16
+
+typedef enum { TAP_KIND_GOWIN=0, TAP_KIND_GENERIC } TapKind;
+
+// Minimal IEEE 1149.1 device: IDCODE (optional), BYPASS, capture-IR = ...01
+typedef struct {
+    TapState tapState;
+    uint8_t  irLength;
+    uint32_t idcode;      // 0 = no IDCODE register, BYPASS selected after reset
+    uint32_t irShiftBuf;
+    uint32_t irLatched;
+    uint32_t drShiftBuf;
+    uint8_t  drLength;
+    uint8_t  tdo;
+} GenericTap;
+
+typedef struct {
+    TapKind kind;
+    union {
+        GowinTap   gowin;
+        GenericTap generic;
+    } u;
+} ChainSlot;
+
+typedef struct {
+    ChainSlot dev[TAP_CHAIN_MAX];
+    int       count;
+    uint64_t  tckCount;
+} TapChain;
+
+void     TapChain_Init(TapChain *c);
+int      TapChain_AddGowin(TapChain *c);
+int      TapChain_AddGeneric(TapChain *c, uint8_t irLength, uint32_t idcode);
+uint8_t  TapChain_Clock(TapChain *c, uint8_t tms, uint8_t tdi);
+uint8_t  TapChain_ClockFn(void *chain, uint8_t tms, uint8_t tdi);   // TapChain_Clock as a JtagClockFn
+uint8_t  TapChain_Tdo(const TapChain *c);           // Level on TDO before the next edge
+GowinTap *TapChain_Gowin(TapChain *c, int index);   // NULL if not a Gowin slot
+
+// Shared by the generic model; Gowin keeps the emulator's own switch
+TapState Tap_NextState(TapState s, uint8_t tms);
+
+#endif
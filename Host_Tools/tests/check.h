@@ -0,0 +1,26 @@
+/*
+ * Minimal assertion helpers shared by the host tests
+ * - CHECK keeps going so one run reports every failure
+ * - CHECK_DONE() returns the exit status for main()
+ */
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+static int checkFailures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); checkFailures++; } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    unsigned long long va_ = (unsigned long long)(a), vb_ = (unsigned long long)(b); \
+    if (va_ != vb_) { fprintf(stderr, "%s:%d: CHECK_EQ failed: %s = 0x%llX, %s = 0x%llX\n", \
+                              __FILE__, __LINE__, #a, va_, #b, vb_); checkFailures++; } \
+} while (0)
+
+#define CHECK_DONE() (checkFailures ? (fprintf(stderr, "%d check(s) failed\n", checkFailures), 1) : (printf("PASS\n"), 0))
+
+#endif
@@ -0,0 +1,265 @@
+/*
+ * Baud negotiation: frames and the pattern, both state machines over a
+ * UART line model with a rate ceiling, a bridge that cannot hit every
+ * rate, a CONFIRM or READY lost on the way, no programmer at all, and
+ * BaudHost_Port on a pty against the MCU side
+ */
+
+#include "baud_host.h"
+#include "baud_line.h"
+#include "baud_link.h"
+#include "check.h"
+#include "pty_link.h"
+
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static void Test_Format(void) {
+    uint8_t f[BAUD_FRAME_SIZE], op, index, arg, seen[256] = { 0 };
+    uint32_t i;
+    int frames = 0;
+
+    BaudLink_Frame(BAUD_VERDICT, 5, 17, f);
+    CHECK(BaudLink_Parse(f, &op, &index, &arg));
+    CHECK_EQ(op, BAUD_VERDICT);
+    CHECK_EQ(index, 5);
+    CHECK_EQ(arg, 17);
+    f[3] ^= 1;
+    CHECK(!BaudLink_Parse(f, &op, &index, &arg));
+    BaudLink_Frame(BAUD_TRY, BAUD_COUNT, 0, f);
+    CHECK(!BaudLink_Parse(f, &op, &index, &arg));
+
+    CHECK_EQ(BaudLink_Index(2000000), 5);
+    CHECK_EQ(BaudLink_Index(BaudLink_Rates[BAUD_POWER_UP]), BAUD_POWER_UP);
+    CHECK(BaudLink_Index(115200) < 0);
+    // BRR 16#0D# is the power-up rate, and every candidate is a whole BRR or near it
+    CHECK((uint32_t)(BaudLine_McuRate(BaudLink_Rates[BAUD_POWER_UP]) + 0.5) == 48000000u / (0x0Du * 16u));
+    for (i = 0; i < BAUD_COUNT; i++) {
+        double r = BaudLine_McuRate(BaudLink_Rates[i]);
+        CHECK((r > BaudLink_Rates[i] ? r - BaudLink_Rates[i] : BaudLink_Rates[i] - r) < BaudLink_Rates[i] * 0.005);
+    }
+
+    // Every byte value once, and no frame anywhere in it
+    for (i = 0; i < BAUD_PATTERN_SIZE; i++) seen[BaudLink_Pattern(i)]++;
+    for (i = 0; i < 256; i++) CHECK_EQ(seen[i], 1);
+    for (i = 0; i + BAUD_FRAME_SIZE <= BAUD_PATTERN_SIZE; i++) {
+        uint8_t w[BAUD_FRAME_SIZE];
+        uint32_t k;
+        for (k = 0; k < BAUD_FRAME_SIZE; k++) w[k] = BaudLink_Pattern(i + k);
+        frames += BaudLink_Parse(w, &op, &index, &arg);
+    }
+    CHECK_EQ(frames, 0);
+}
+
+// --- LINE ---
+typedef struct {
+    BaudLine line;
+    BaudMcu  m;
+    BaudHost h;
+    uint8_t  mcuRate, hostRate;
+    double   now;
+    int      mcu;             // 0: nobody on the other end
+    int      deafConfirm;     // MCU hears nothing at the new rate
+    int      loseReady;       // READY replies to drop, first ones first
+    double   mcuDone;
+} Bench;
+
+static void Run(Bench *b, uint8_t base, uint8_t top, uint32_t ceiling, double hostClock) {
+    static const char Banner[] = "Negotiating baud\r\n";
+    uint8_t buf[512];
+    size_t n;
+    int s;
+
+    int mcu = b->mcu, deaf = b->deafConfirm, lose = b->loseReady;
+
+    memset(b, 0, sizeof(*b));
+    b->mcu = mcu;
+    b->deafConfirm = deaf;
+    b->loseReady = lose;
+    BaudLine_Init(&b->line, ceiling, 50000, hostClock, 7);
+    b->mcuRate = b->hostRate = base;
+    b->now = 0;
+    BaudMcu_Begin(&b->m, base, 0);
+    // H2M's line ahead of the first frame
+    if (b->mcu) BaudLine_Send(&b->line, BAUD_LINE_TO_HOST, 0, BaudLine_McuRate(BaudLink_Rates[base]),
+                              (const uint8_t *)Banner, sizeof(Banner) - 1);
+    BaudHost_Begin(&b->h, base, top, 0);
+    while (b->now < 30000 && !(BaudHost_Finished(&b->h) && (!b->mcu || b->m.state == BMCU_DONE))) {
+        double mcuHz = BaudLine_McuRate(BaudLink_Rates[b->mcuRate]);
+        double hostHz = BaudLine_HostRate(&b->line, BaudLink_Rates[b->hostRate]);
+        b->now += 0.02;
+
+        // MCU
+        n = BaudLine_Receive(&b->line, BAUD_LINE_TO_MCU, b->now, mcuHz, buf, sizeof(buf));
+        if (b->mcu) {
+            if (b->deafConfirm && (b->m.state == BMCU_CONFIRM)) n = 0;
+            BaudMcu_Rx(&b->m, buf, n, b->now);
+            BaudMcu_Tick(&b->m, b->now);
+            n = BaudMcu_TakeTx(&b->m, buf, sizeof(buf));
+            if (n == BAUD_FRAME_SIZE && buf[1] == BAUD_READY && b->loseReady > 0) { b->loseReady--; n = 0; }
+            BaudLine_Send(&b->line, BAUD_LINE_TO_HOST, b->now, mcuHz, buf, n);
+            if (!BaudLine_Busy(&b->line, BAUD_LINE_TO_HOST, b->now) && (s = BaudMcu_TakeSwitch(&b->m)) >= 0) b->mcuRate = (uint8_t)s;
+            if (b->m.state == BMCU_DONE && !b->mcuDone) b->mcuDone = b->now;
+        }
+
+        // Host
+        n = BaudLine_Receive(&b->line, BAUD_LINE_TO_HOST, b->now, hostHz, buf, sizeof(buf));
+        BaudHost_Rx(&b->h, buf, n, b->now);
+        BaudHost_Tick(&b->h, b->now);
+        n = BaudHost_TakeTx(&b->h, buf, sizeof(buf));
+        BaudLine_Send(&b->line, BAUD_LINE_TO_MCU, b->now, hostHz, buf, n);
+        if (!BaudLine_Busy(&b->line, BAUD_LINE_TO_MCU, b->now) && (s = BaudHost_TakeSwitch(&b->h)) >= 0) b->hostRate = (uint8_t)s;
+    }
+}
+
+static Bench bench;
+
+static void Test_Ceiling(void) {
+    Bench *b = &bench;
+    b->mcu = 1;
+    Run(b, BAUD_POWER_UP, BAUD_COUNT - 1, 2000000, 0);
+    CHECK_EQ(b->h.state, BHOST_DONE);
+    CHECK_EQ(b->h.rate, 5);
+    CHECK_EQ(b->hostRate, 5);
+    CHECK_EQ(b->mcuRate, 5);
+    CHECK_EQ(b->m.base, 5);
+    CHECK_EQ(b->m.state, BMCU_DONE);
+    CHECK_EQ(b->h.mcuErrors[4], 0);
+    CHECK(b->h.mcuErrors[6] > 0 || b->h.hostErrors[6] > 0);
+    CHECK_EQ(b->m.trials, 6);
+    // Six trials and the switch: under two seconds of link time
+    CHECK(b->now < 2000);
+
+    Run(b, BAUD_POWER_UP, BAUD_COUNT - 1, 950000, 0);
+    CHECK_EQ(b->h.state, BHOST_DONE);
+    CHECK_EQ(b->h.rate, 2);
+    CHECK_EQ(b->mcuRate, 2);
+
+    // Nothing past the base: SET to where both are already
+    Run(b, BAUD_POWER_UP, BAUD_COUNT - 1, 300000, 0);
+    CHECK_EQ(b->h.state, BHOST_DONE);
+    CHECK_EQ(b->h.rate, BAUD_POWER_UP);
+    CHECK_EQ(b->mcuRate, BAUD_POWER_UP);
+    CHECK_EQ(b->m.state, BMCU_DONE);
+
+    // The host's port stops short of the line
+    Run(b, BAUD_POWER_UP, 2, 3000000, 0);
+    CHECK_EQ(b->h.rate, 2);
+    CHECK_EQ(b->m.trials, 2);
+
+    // From an earlier negotiation's rate
+    Run(b, 3, BAUD_COUNT - 1, 2000000, 0);
+    CHECK_EQ(b->h.rate, 5);
+    CHECK_EQ(b->m.trials, 3);
+}
+
+// A bridge dividing 7.2 MHz: 1.5 Mbaud comes out 4 % slow against USART2
+static void Test_Bridge(void) {
+    Bench *b = &bench;
+    b->mcu = 1;
+    Run(b, BAUD_POWER_UP, BAUD_COUNT - 1, 3000000, 7.2e6);
+    CHECK_EQ(b->h.state, BHOST_DONE);
+    CHECK_EQ(b->h.rate, 3);
+    CHECK_EQ(b->mcuRate, 3);
+    CHECK(b->h.mcuErrors[4] > 0 || b->h.hostErrors[4] > 0);
+}
+
+static void Test_Lost(void) {
+    Bench *b = &bench;
+
+    // The new rate never carries a CONFIRM: both back at the base
+    b->mcu = 1;
+    b->deafConfirm = 1;
+    Run(b, BAUD_POWER_UP, BAUD_COUNT - 1, 2000000, 0);
+    CHECK_EQ(b->h.state, BHOST_DONE);
+    CHECK_EQ(b->h.confirmsLost, 1);
+    CHECK_EQ(b->h.rate, BAUD_POWER_UP);
+    CHECK_EQ(b->mcuRate, BAUD_POWER_UP);
+    CHECK_EQ(b->m.base, BAUD_POWER_UP);
+    CHECK_EQ(b->m.state, BMCU_DONE);
+    b->deafConfirm = 0;
+
+    // A READY lost: the TRY goes again once the MCU has given up the trial
+    b->loseReady = 2;
+    Run(b, BAUD_POWER_UP, BAUD_COUNT - 1, 2000000, 0);
+    CHECK_EQ(b->h.state, BHOST_DONE);
+    CHECK_EQ(b->h.rate, 5);
+    CHECK_EQ(b->mcuRate, 5);
+    CHECK(b->h.retries >= 2);
+
+    // Nobody there: the port stays where it was
+    b->mcu = 0;
+    Run(b, BAUD_POWER_UP, BAUD_COUNT - 1, 2000000, 0);
+    CHECK_EQ(b->h.state, BHOST_FAIL);
+    CHECK_EQ(b->hostRate, BAUD_POWER_UP);
+    CHECK(b->now < 2000);
+}
+
+// --- PTY ---
+static double Now_Ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+// A pty carries any rate: every trial passes and the top one is kept
+static void Test_Pty(void) {
+    PtyLink link;
+    BaudMcu m;
+    uint8_t buf[512], line[16];
+    size_t lineLen = 0;
+    pid_t pid;
+    int status, begun = 0;
+    double start;
+
+    if (PtyLink_Open(&link) < 0) { CHECK(!"pty"); return; }
+    pid = fork();
+    if (pid == 0) {
+        BaudHost h;
+        int fd = PtyLink_OpenPort(link.path);
+        _exit(fd >= 0 && BaudHost_Port(&h, fd, BAUD_POWER_UP, BAUD_COUNT - 1) == BHOST_DONE && h.rate == BAUD_COUNT - 1 ? 0 : 1);
+    }
+    start = Now_Ms();
+    while (Now_Ms() - start < 10000) {
+        struct pollfd p = { link.master, POLLIN, 0 };
+        ssize_t got = 0;
+        size_t n;
+        if (poll(&p, 1, 1) > 0) got = read(link.master, buf, sizeof(buf));
+        if (got < 0) got = 0;
+        if (!begun) {
+            // The command line: "baud" then CR
+            size_t i;
+            for (i = 0; i < (size_t)got && !begun; i++) {
+                if (buf[i] == '\r') begun = lineLen == 4 && memcmp(line, "baud", 4) == 0;
+                else if (lineLen < sizeof(line)) line[lineLen++] = buf[i];
+            }
+            if (begun) BaudMcu_Begin(&m, BAUD_POWER_UP, Now_Ms());
+            continue;
+        }
+        BaudMcu_Rx(&m, buf, (size_t)got, Now_Ms());
+        BaudMcu_Tick(&m, Now_Ms());
+        while ((n = BaudMcu_TakeTx(&m, buf, sizeof(buf))) > 0) {
+            if (write(link.master, buf, n) < 0) break;
+        }
+        BaudMcu_TakeSwitch(&m);
+        if (waitpid(pid, &status, WNOHANG) == pid) break;
+    }
+    if (waitpid(pid, &status, WNOHANG) == 0) { kill(pid, SIGKILL); waitpid(pid, &status, 0); CHECK(!"host hung"); }
+    CHECK(begun);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK_EQ(m.base, BAUD_COUNT - 1);
+    PtyLink_Close(&link);
+}
+
+int main(void) {
+    Test_Format();
+    Test_Ceiling();
+    Test_Bridge();
+    Test_Lost();
+    Test_Pty();
+    return CHECK_DONE();
+}
@@ -0,0 +1,81 @@
+/*
+ * Boot cache: image checks in the firmware's order, and a power-up load
+ */
+
+#include "check.h"
+#include "boot_cache.h"
+#include "gowin_tap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define AREA 4096u
+
+static uint8_t flash[AREA];
+
+static void Erase(void) { memset(flash, 0xFF, sizeof(flash)); }
+
+int main(void) {
+    uint8_t bits[1000];
+    BootReport r;
+    size_t i, size;
+
+    CHECK_EQ(BootCache_Crc32((const uint8_t *)"123456789", 9), 0xCBF43926u);
+    CHECK_EQ(BootCache_Padded(13), 16);
+    CHECK_EQ(BootCache_Padded(16), 16);
+
+    for (i = 0; i < sizeof(bits); i++) bits[i] = (uint8_t)(i * 13 + 1);
+
+    Erase();
+    CHECK_EQ(BootCache_Decide(flash, AREA, 0), BOOT_NO_IMAGE);
+    CHECK_EQ(BootCache_Decide(flash, AREA, 1), BOOT_SKIPPED);
+    CHECK_EQ(BootCache_Decide(flash, 8, 0), BOOT_SKIPPED);
+
+    // 999 bytes: the CRC covers the zero pad
+    size = BootCache_Build(bits, 999, flash, AREA);
+    CHECK_EQ(size, BOOT_HEADER_SIZE + 1000);
+    CHECK_EQ(flash[BOOT_HEADER_SIZE + 999], 0);
+    CHECK_EQ(BootCache_Decide(flash, AREA, 0), BOOT_LOAD);
+    CHECK_EQ(BootCache_Decide(flash, AREA, 1), BOOT_SKIPPED);
+
+    // A length that runs past the area, with a consistent check word
+    CHECK_EQ(BootCache_Decide(flash, 512, 0), BOOT_TOO_LARGE);
+    CHECK_EQ(BootCache_Build(bits, 999, flash, 512), 0);
+
+    flash[BOOT_HEADER_SIZE + 10] ^= 0x01;
+    CHECK_EQ(BootCache_Decide(flash, AREA, 0), BOOT_BAD_CRC);
+    flash[BOOT_HEADER_SIZE + 10] ^= 0x01;
+
+    flash[5] ^= 0x01;   // Length without its check word
+    CHECK_EQ(BootCache_Decide(flash, AREA, 0), BOOT_BAD_HEADER);
+    flash[5] ^= 0x01;
+    flash[0] = 0;
+    CHECK_EQ(BootCache_Decide(flash, AREA, 0), BOOT_BAD_HEADER);
+
+    // A bitstream the TAP model accepts: configured at power-up
+    {
+        size_t len = MIN_STREAM_BITS / 8 + 64, cap = BOOT_HEADER_SIZE + len + 4;
+        uint8_t *stream = calloc(len, 1), *area = malloc(cap);
+        memset(area, 0xFF, cap);
+        CHECK(BootCache_Build(stream, len, area, cap) > 0);
+        CHECK_EQ(BootCache_Boot(area, cap, 24e6, 1e6, &r), BOOT_LOAD);
+        CHECK(r.done);
+        CHECK_EQ(r.bytes, len);
+        CHECK_EQ(r.streamBits, (uint64_t)(len - 1) * 8);
+        CHECK(r.tck > r.streamBits);
+
+        // Twice the SPI clock saves about half the stream time
+        {
+            BootReport slow;
+            BootCache_Boot(area, cap, 12e6, 1e6, &slow);
+            CHECK(slow.loadUs > r.loadUs);
+            CHECK(slow.loadUs - r.loadUs > (double)r.streamBits / 24e6 * 1e6 * 0.99);
+        }
+
+        area[BOOT_HEADER_SIZE] ^= 0x80;
+        CHECK_EQ(BootCache_Boot(area, cap, 24e6, 1e6, &r), BOOT_BAD_CRC);
+        CHECK(!r.done);
+        free(stream); free(area);
+    }
+    return CHECK_DONE();
+}
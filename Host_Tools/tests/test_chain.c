@@ -0,0 +1,95 @@
+/*
+ * Chain discovery and bypass-padded scans against N simulated TAPs
+ */
+
+#include "check.h"
+#include "jtag_master.h"
+#include "tap_chain.h"
+
+#include <stdlib.h>
+
+static void Test_Single_Gowin_Default(void) {
+    TapChain chain; JtagMaster m;
+    TapChain_Init(&chain); TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+
+    // Undiscovered master must drive the same IR scan as the firmware always did
+    Jtag_ResetTap(&m);
+    Jtag_Pulse(&m, 0, 1); // RUN-TEST/IDLE
+    Jtag_SendCommand(&m, CMD_ENABLE);
+    CHECK_EQ(m.tckCount, 6 + 1 + 15);
+    CHECK(TapChain_Gowin(&chain, 0)->isEditMode);
+}
+
+static void Test_Discover_Mixed(void) {
+    TapChain chain; JtagMaster m;
+    TapChain_Init(&chain);
+    TapChain_AddGeneric(&chain, 4, 0x0BA00477);   // nearest TDO
+    TapChain_AddGowin(&chain);
+    TapChain_AddGeneric(&chain, 5, 0);            // BYPASS-only, nearest TDI
+    TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+
+    CHECK_EQ(Jtag_Discover(&m), 4);
+    CHECK_EQ(m.dev[0].idcode, 0x0BA00477);
+    CHECK_EQ(m.dev[1].idcode, GOWIN_ID_VAL);
+    CHECK_EQ(m.dev[2].idcode, 0);
+    CHECK_EQ(m.dev[3].idcode, GOWIN_ID_VAL);
+    CHECK_EQ(m.dev[0].irLength, 4);
+    CHECK_EQ(m.dev[1].irLength, 8);
+    CHECK_EQ(m.dev[2].irLength, 5);
+    CHECK_EQ(m.dev[3].irLength, 8);
+    CHECK_EQ(m.active, 1);
+    // Discovery must leave every Gowin TAP without unknown-instruction warnings
+    CHECK_EQ(TapChain_Gowin(&chain, 1)->eventCount[EVT_CMD_UNKNOWN], 0);
+    CHECK_EQ(TapChain_Gowin(&chain, 3)->eventCount[EVT_CMD_UNKNOWN], 0);
+}
+
+static void Test_Padded_Scans_Reach_Only_Target(void) {
+    TapChain chain; JtagMaster m; int t;
+    TapChain_Init(&chain);
+    for (t = 0; t < 3; t++) TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    CHECK_EQ(Jtag_Discover(&m), 3);
+
+    for (t = 0; t < 3; t++) {
+        int other;
+        Jtag_Select(&m, t);
+        Jtag_SendCommand(&m, CMD_ENABLE);
+        CHECK(TapChain_Gowin(&chain, t)->isEditMode);
+        CHECK_EQ(Jtag_ReadStatus(&m) & 0x80, 0x80);
+        for (other = t + 1; other < 3; other++) CHECK(!TapChain_Gowin(&chain, other)->isEditMode);
+    }
+}
+
+static void Test_Program_Middle_Device(void) {
+    TapChain chain; JtagMaster m; int t;
+    size_t len = MIN_STREAM_BITS / 8 + 64;
+    uint8_t *bits = calloc(len, 1);
+    TapChain_Init(&chain);
+    for (t = 0; t < 3; t++) TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    CHECK_EQ(Jtag_Discover(&m), 3);
+    Jtag_Select(&m, 1);
+
+    Jtag_ResetTap(&m);
+    Jtag_InitConfiguration(&m);
+    Jtag_StreamBitstream(&m, bits, len);
+    Jtag_FinishConfiguration(&m);
+
+    CHECK(TapChain_Gowin(&chain, 1)->leds & LED_PROG_5);
+    CHECK(!(TapChain_Gowin(&chain, 1)->leds & LED_FAIL));
+    // Exactly the body plus the one bypass bit of the TAP between TDI and the target
+    CHECK_EQ(TapChain_Gowin(&chain, 1)->diagStreamBits, len * 8 + 1);
+    CHECK(!(TapChain_Gowin(&chain, 0)->leds & LED_PROG_5));
+    CHECK(!(TapChain_Gowin(&chain, 2)->leds & LED_PROG_5));
+    free(bits);
+}
+
+int main(void) {
+    Test_Single_Gowin_Default();
+    Test_Discover_Mixed();
+    Test_Padded_Scans_Reach_Only_Target();
+    Test_Program_Middle_Device();
+    return CHECK_DONE();
+}
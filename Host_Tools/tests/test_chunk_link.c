@@ -0,0 +1,273 @@
+/*
+ * Chunked upload: frames and replies, the bitstream through bit flips and
+ * dropped runs both ways with only the bad chunks resent, a host that dies
+ * half-way and another that picks the session up, and the same over a
+ * faulty pty
+ */
+
+#include "boot_cache.h"
+#include "check.h"
+#include "chunk_link.h"
+#include "chunk_pipe.h"
+#include "chunk_recv.h"
+#include "chunk_send.h"
+#include "fault_link.h"
+#include "gowin_tap.h"
+#include "host_file.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void Test_Format(const uint8_t *bits) {
+    uint8_t frame[CHUNK_HEADER_SIZE + 64 + CHUNK_CRC_SIZE], reply[CHUNK_REPLY_SIZE];
+    ChunkHeader h;
+    ChunkReply r = { CHUNK_NAK, 0x1234, 0x1200, 64, 256, CHUNK_RUNNING }, q;
+
+    CHECK_EQ(ChunkLink_Crc32(0, (const uint8_t *)"123456789", 9), 0xCBF43926u);
+    CHECK_EQ(ChunkLink_Crc32(ChunkLink_Crc32(0, bits, 100), bits + 100, 900), BootCache_Crc32(bits, 1000));
+
+    CHECK_EQ(ChunkLink_Frame(7, CHUNK_LAST, bits, 64, frame), sizeof(frame));
+    CHECK(ChunkLink_ParseHeader(frame, &h));
+    CHECK_EQ(h.seq, 7);
+    CHECK_EQ(h.len, 64);
+    CHECK_EQ(h.flags, CHUNK_LAST);
+    CHECK(ChunkLink_CheckFrame(frame, &h));
+    frame[CHUNK_HEADER_SIZE + 10] ^= 0x10;           // Payload
+    CHECK(!ChunkLink_CheckFrame(frame, &h));
+    frame[CHUNK_HEADER_SIZE + 10] ^= 0x10;
+    frame[5] ^= 1;                                   // Sequence, check word not fixed up
+    CHECK(!ChunkLink_ParseHeader(frame, &h));
+
+    ChunkLink_Reply(&r, reply);
+    CHECK(ChunkLink_ParseReply(reply, &q));
+    CHECK_EQ(q.kind, CHUNK_NAK);
+    CHECK_EQ(q.seq, 0x1234);
+    CHECK_EQ(q.next, 0x1200);
+    CHECK_EQ(q.chunk, 256);
+    reply[3] ^= 4;
+    CHECK(!ChunkLink_ParseReply(reply, &q));
+    memset(reply, 0, sizeof(reply));
+    CHECK(!ChunkLink_ParseReply(reply, &q));
+
+    // Half the ring, past one frame, 1 .. CHUNK_SLOTS
+    CHECK_EQ(ChunkLink_Window(4096, 256), 7);
+    CHECK_EQ(ChunkLink_Window(512, 256), 1);
+    CHECK_EQ(ChunkLink_Window(65536, 64), CHUNK_SLOTS);
+}
+
+// --- IN MEMORY ---
+// Host and MCU on one clock: frames through `up` into the ring a few
+// hundred bytes a tick, replies through `down` straight back
+typedef struct {
+    GowinTap   *tap;
+    JtagMaster  jtag;
+    McuRing     ring;
+    McuChunk    m;
+    FaultLink   up, down;
+    uint8_t    *queue;
+    size_t      queued;
+    double      now;
+} Link;
+
+static void Link_Init(Link *l, GowinTap *tap, uint32_t seed, uint32_t flipPpm, uint32_t dropPpm, uint32_t replyPpm) {
+    memset(l, 0, sizeof(*l));
+    l->tap = tap;
+    GowinTap_Init(tap);
+    Jtag_Init(&l->jtag, GowinTap_ClockFn, tap);
+    Jtag_ResetTap(&l->jtag);
+    Jtag_InitConfiguration(&l->jtag);
+    McuRing_Init(&l->ring, 4096);
+    McuChunk_Begin(&l->m, &l->ring, &l->jtag);
+    FaultLink_Init(&l->up, seed, flipPpm, dropPpm, 64);
+    FaultLink_Init(&l->down, seed + 1, replyPpm, replyPpm, 1);
+    l->queue = malloc(1 << 20);
+}
+
+static void Link_Free(Link *l) { McuRing_Free(&l->ring); free(l->queue); }
+
+static void Link_Run(Link *l, ChunkSender *s, uint32_t stopAfter) {
+    static uint8_t frame[CHUNK_HEADER_SIZE + CHUNK_MAX + CHUNK_CRC_SIZE];
+    uint8_t replies[sizeof(l->m.out)];
+    size_t step = 1;
+    while (!ChunkSender_Finished(s) && l->now < 600000.0) {
+        size_t n = ChunkSender_Next(s, l->now, frame), k;
+        if (n) {
+            if (stopAfter && s->frames > stopAfter) return;
+            n = FaultLink_Apply(&l->up, frame, n);
+            memcpy(l->queue + l->queued, frame, n);
+            l->queued += n;
+        }
+        // What the DMA writes this tick, room permitting
+        k = step < l->queued ? step : l->queued;
+        while (k) {
+            uint32_t room;
+            uint8_t *dst = McuRing_WriteSpan(&l->ring, &room);
+            size_t w = room < k ? room : k;
+            if (!w) break;
+            memcpy(dst, l->queue, w);
+            McuRing_Commit(&l->ring, (uint32_t)w);
+            memmove(l->queue, l->queue + w, l->queued - w);
+            l->queued -= w;
+            k -= w;
+        }
+        McuChunk_Drain(&l->m);
+        n = McuChunk_TakeReplies(&l->m, replies, sizeof(replies));
+        n = FaultLink_Apply(&l->down, replies, n);
+        ChunkSender_Rx(s, replies, n, l->now);
+        step = step * 7 % 509 + 1;
+        l->now += 0.5;
+    }
+}
+
+static void Test_Clean(const uint8_t *bits, size_t len) {
+    static GowinTap tap;
+    Link l;
+    ChunkSender s;
+
+    Link_Init(&l, &tap, 1, 0, 0, 0);
+    CHECK_EQ(ChunkSender_Init(&s, bits, len, 256), 0);
+    Link_Run(&l, &s, 0);
+    CHECK_EQ(s.state, SEND_DONE);
+    CHECK_EQ(s.resumedAt, 0);
+    CHECK_EQ(s.window, 7);
+    CHECK_EQ(s.frames, s.count);
+    CHECK_EQ(s.resent, 0);
+    CHECK_EQ(l.m.naks, 0);
+    CHECK_EQ(l.m.badCrc, 0);
+    CHECK_EQ(l.m.skipped, 0);
+    CHECK_EQ(l.m.status, CHUNK_DONE);
+    CHECK_EQ(l.m.shifted, len);
+    CHECK_EQ(tap.diagStreamBits, len * 8);
+    CHECK(tap.leds & LED_PROG_5);
+    ChunkSender_Free(&s);
+    Link_Free(&l);
+}
+
+static void Test_Faults(const uint8_t *bits, size_t len) {
+    static GowinTap tap;
+    static const uint32_t seeds[] = { 3, 17, 2024 };
+    size_t i;
+    for (i = 0; i < sizeof(seeds) / sizeof(seeds[0]); i++) {
+        Link l;
+        ChunkSender s;
+        // ~90 bit flips and ~9 dropped USB packets on the way in, ~5 bad reply bytes back
+        Link_Init(&l, &tap, seeds[i], 200, 20, 500);
+        CHECK_EQ(ChunkSender_Init(&s, bits, len, 256), 0);
+        Link_Run(&l, &s, 0);
+        CHECK_EQ(s.state, SEND_DONE);
+        CHECK(l.up.flipped > 0 && l.up.drops > 0);
+        CHECK(l.m.badCrc > 0);
+        CHECK(s.naks > 0);
+        CHECK_EQ(l.m.status, CHUNK_DONE);
+        CHECK_EQ(l.m.shifted, len);
+        CHECK_EQ(tap.diagStreamBits, len * 8);
+        CHECK(tap.leds & LED_PROG_5);
+        // Only the damaged chunks again
+        CHECK(s.resent > 0);
+        CHECK(s.resent < s.count / 10);
+        // 6 % of it is framing; a whole clean 444 KB at this error rate never happens
+        CHECK(s.bytes < (uint64_t)len * 12 / 10);
+        ChunkSender_Free(&s);
+        Link_Free(&l);
+    }
+}
+
+static void Test_Resume(const uint8_t *bits, size_t len) {
+    static GowinTap tap;
+    Link l;
+    ChunkSender a, b;
+
+    Link_Init(&l, &tap, 5, 100, 0, 0);
+    CHECK_EQ(ChunkSender_Init(&a, bits, len, 256), 0);
+    Link_Run(&l, &a, a.count / 2);
+    CHECK_EQ(a.state, SEND_RUNNING);
+    CHECK_EQ(l.m.status, CHUNK_RUNNING);
+
+    // A new host with the same file: it starts where the MCU got to
+    CHECK_EQ(ChunkSender_Init(&b, bits, len, 256), 0);
+    Link_Run(&l, &b, 0);
+    CHECK_EQ(b.state, SEND_DONE);
+    CHECK(b.resumedAt > 0 && b.resumedAt <= a.count / 2);
+    CHECK(b.frames - b.resent <= b.count - b.resumedAt);
+    CHECK_EQ(tap.diagStreamBits, len * 8);
+    CHECK(tap.leds & LED_PROG_5);
+    ChunkSender_Free(&a);
+    ChunkSender_Free(&b);
+
+    // At another chunk length it refuses rather than misplace every byte
+    CHECK_EQ(ChunkSender_Init(&b, bits, len, 512), 0);
+    b.state = SEND_PROBING;
+    {
+        ChunkReply r = { CHUNK_ACK, 0xFFFF, 100, 64, 256, CHUNK_RUNNING };
+        uint8_t raw[CHUNK_REPLY_SIZE];
+        ChunkLink_Reply(&r, raw);
+        ChunkSender_Rx(&b, raw, sizeof(raw), 0);
+    }
+    CHECK_EQ(b.state, SEND_MISMATCH);
+    ChunkSender_Free(&b);
+    Link_Free(&l);
+}
+
+// Held chunks the DMA would lap are given up and asked for again
+static void Test_Evict(const uint8_t *bits) {
+    static GowinTap tap;
+    static uint8_t frame[CHUNK_HEADER_SIZE + 256 + CHUNK_CRC_SIZE];
+    Link l;
+    uint16_t seq;
+
+    Link_Init(&l, &tap, 1, 0, 0, 0);
+    // Chunk 0 never comes; 1 .. 15 fill the ring behind the hole
+    for (seq = 1; seq < CHUNK_SLOTS; seq++) {
+        uint32_t room;
+        size_t n = ChunkLink_Frame(seq, 0, bits + seq * 256, 256, frame);
+        uint8_t *dst = McuRing_WriteSpan(&l.ring, &room);
+        if (room < n) break;
+        memcpy(dst, frame, n);
+        McuRing_Commit(&l.ring, (uint32_t)n);
+        McuChunk_Drain(&l.m);
+    }
+    CHECK(l.m.evicted > 0);
+    CHECK_EQ(l.m.next, 0);
+    CHECK_EQ(l.m.shifted, 0);
+    CHECK(McuRing_Level(&l.ring) <= l.ring.size - ChunkLink_FrameSize(256));
+    Link_Free(&l);
+}
+
+static void Test_Pty(const uint8_t *bits, size_t len) {
+    ChunkPipeConfig c = { bits, len, 256, 4096, 7, 100, 10, 64, 200, 200, 0 };
+    ChunkPipeResult r;
+
+    CHECK_EQ(ChunkPipe_Run(&c, &r), 0);
+    CHECK(r.pass);
+    CHECK_EQ(r.host, SEND_DONE);
+    CHECK(r.flipped > 0 && r.drops > 0);
+    CHECK(r.resent > 0);
+    CHECK(r.wireBytes < (uint64_t)len * 12 / 10);
+    CHECK_EQ(r.streamBits, len * 8);
+
+    // The host dies a third of the way in; the next one resumes
+    c.stopAfter = (uint32_t)(len / 256 / 3);
+    CHECK_EQ(ChunkPipe_Run(&c, &r), 0);
+    CHECK(r.pass);
+    CHECK(r.resumedAt > 0 && r.resumedAt <= c.stopAfter);
+    CHECK(r.wireBytes < (uint64_t)len * 12 / 10);
+}
+
+int main(void) {
+    size_t len = 0;
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &len);
+    CHECK(bits != NULL);
+    if (bits) {
+        Test_Format(bits);
+        Test_Clean(bits, len);
+        Test_Faults(bits, len);
+        Test_Resume(bits, len);
+        Test_Evict(bits);
+        Test_Pty(bits, len);
+    }
+    free(bits);
+    return CHECK_DONE();
+}
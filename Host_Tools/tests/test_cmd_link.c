@@ -0,0 +1,234 @@
+/*
+ * Binary commands: frames pinned to their bytes, requests and responses
+ * round-tripped, a run of tagged requests in one buffer and a byte at a
+ * time, a bad CRC, a length past the payload, garbage before a frame;
+ * then the parser fuzzed with random and damaged streams: it never
+ * reports a frame that was not on the wire and always finds the next one
+ */
+
+#include "check.h"
+#include "cmd_link.h"
+
+#include <string.h>
+
+static uint32_t Next(uint32_t *s) {
+    *s = *s * 1664525u + 1013904223u;
+    return *s >> 8;
+}
+
+static void Test_Format(void) {
+    static const uint8_t Ping[] = { 0xA5, 0x00, 0x07, 0x00, 0x00, 0x99, 0xC9, 0x0B, 0x24 };
+    static const uint8_t Select[] = { 0xA5, 0x05, 0x09, 0x01, 0x00, 0x02, 0xFC, 0x3C, 0x06, 0x9C };
+    uint8_t f[CMD_MAX_FRAME], arg = 2;
+    CHECK_EQ(CmdLink_Request(CMD_PING, 7, NULL, 0, f), sizeof(Ping));
+    CHECK(memcmp(f, Ping, sizeof(Ping)) == 0);
+    CHECK_EQ(CmdLink_Request(CMD_SELECT, 9, &arg, 1, f), sizeof(Select));
+    CHECK(memcmp(f, Select, sizeof(Select)) == 0);
+    CHECK_EQ(CmdLink_Request(CMD_PING, 0, f, CMD_MAX_PAYLOAD + 1, f), 0);
+
+    CHECK_EQ(CmdLink_OpByName("fanout"), CMD_FANOUT);
+    CHECK(strcmp(CmdLink_OpName(CMD_TEXT), "text") == 0);
+    CHECK(CmdLink_OpByName("bin") < 0);
+    CHECK(strcmp(CmdLink_StatusName(CMD_BAD_ARG), "BAD_ARG") == 0);
+}
+
+// The command line before `bin`: any length, one-digit N only after select and fanout
+static void Test_Command_Line(void) {
+    char line[300];
+    unsigned arg = 9;
+    CHECK_EQ(CmdLink_ParseLine("chain", 5, &arg), CMD_CHAIN);
+    CHECK_EQ(arg, 0);
+    CHECK_EQ(CmdLink_ParseLine("select 2", 8, &arg), CMD_SELECT);
+    CHECK_EQ(arg, 2);
+    CHECK_EQ(CmdLink_ParseLine("fanout 4", 8, &arg), CMD_FANOUT);
+    CHECK_EQ(arg, 4);
+    CHECK_EQ(CmdLink_ParseLine("help", 4, &arg), CMD_LINE_HELP);
+    CHECK_EQ(CmdLink_ParseLine("bin", 3, &arg), CMD_LINE_BIN);
+    CHECK_EQ(CmdLink_ParseLine("status 2", 8, &arg), CMD_LINE_NONE);
+    CHECK_EQ(CmdLink_ParseLine("select 12", 9, &arg), CMD_LINE_NONE);
+    CHECK_EQ(CmdLink_ParseLine("", 0, &arg), CMD_LINE_NONE);
+    memset(line, 'a', sizeof(line));
+    CHECK_EQ(CmdLink_ParseLine(line, 256, &arg), CMD_LINE_NONE);
+}
+
+static void Test_Round_Trip(void) {
+    uint8_t f[CMD_MAX_FRAME], payload[CMD_MAX_PAYLOAD];
+    CmdParser p, r;
+    unsigned op, len, i;
+    uint32_t s = 1;
+    CmdParser_Init(&p, 0);
+    CmdParser_Init(&r, 1);
+    for (op = 0; op < CMD_OPS; op++) {
+        for (len = 0; len <= CMD_MAX_PAYLOAD; len += 32) {
+            size_t n;
+            CmdVerdict v = CMDV_NONE;
+            for (i = 0; i < len; i++) payload[i] = (uint8_t)Next(&s);
+            n = CmdLink_Request((uint8_t)op, (uint8_t)(op + len), payload, (uint16_t)len, f);
+            CHECK_EQ(n, CMD_HEADER_SIZE + len + CMD_CRC_SIZE);
+            for (i = 0; i < n; i++) {
+                CHECK_EQ(v, CMDV_NONE);
+                v = CmdParser_Feed(&p, f[i]);
+            }
+            CHECK_EQ(v, CMDV_GOOD);
+            CHECK_EQ(p.op, op);
+            CHECK_EQ(p.tag, (uint8_t)(op + len));
+            CHECK_EQ(p.len, len);
+            CHECK(memcmp(p.payload, payload, len) == 0);
+
+            n = CmdLink_Reply((uint8_t)op, 3, CMD_READY, payload, (uint16_t)len, f);
+            CHECK_EQ(n, CMD_REPLY_HEADER_SIZE + len + CMD_CRC_SIZE);
+            for (i = 0, v = CMDV_NONE; i < n; i++) v = CmdParser_Feed(&r, f[i]);
+            CHECK_EQ(v, CMDV_GOOD);
+            CHECK_EQ(r.status, CMD_READY);
+            CHECK_EQ(r.len, len);
+            CHECK(memcmp(r.payload, payload, len) == 0);
+        }
+    }
+    // A request is no response, and the other way
+    CmdLink_Request(CMD_PING, 1, NULL, 0, f);
+    for (i = 0; i < CMD_HEADER_SIZE + CMD_CRC_SIZE; i++) CHECK_EQ(CmdParser_Feed(&r, f[i]), CMDV_NONE);
+    CHECK_EQ(r.frames, CMD_OPS * 5);
+    CHECK_EQ(p.skipped, 0);
+    CHECK_EQ(CmdLink_Word((const uint8_t *)"\x78\x56\x34\x12\x01\x00\x00\x00", 1), 1);
+    CHECK_EQ(CmdLink_Word((const uint8_t *)"\x78\x56\x34\x12", 0), 0x12345678u);
+}
+
+static void Test_Pipeline(void) {
+    uint8_t stream[16 * CMD_MAX_FRAME], arg;
+    size_t n = 0, i;
+    unsigned k, got = 0;
+    CmdParser p;
+    // Sixteen requests back to back, as the host sends them
+    for (k = 0; k < 16; k++) {
+        arg = (uint8_t)k;
+        n += CmdLink_Request((uint8_t)(k % CMD_OPS), (uint8_t)(0x40 + k), &arg, k & 1, stream + n);
+    }
+    CmdParser_Init(&p, 0);
+    for (i = 0; i < n; i++) {
+        if (CmdParser_Feed(&p, stream[i]) != CMDV_GOOD) continue;
+        CHECK_EQ(p.tag, 0x40 + got);
+        CHECK_EQ(p.op, got % CMD_OPS);
+        CHECK_EQ(p.len, got & 1);
+        if (p.len) CHECK_EQ(p.payload[0], got);
+        got++;
+    }
+    CHECK_EQ(got, 16);
+    CHECK_EQ(p.frames, 16);
+}
+
+static void Test_Damage(void) {
+    uint8_t f[CMD_MAX_FRAME], g[CMD_MAX_FRAME], arg = 4;
+    size_t n, m, i;
+    CmdParser p;
+    CmdVerdict v = CMDV_NONE;
+    CmdParser_Init(&p, 0);
+
+    // A bad CRC ends the frame; the next one is found
+    n = CmdLink_Request(CMD_FANOUT, 1, &arg, 1, f);
+    m = CmdLink_Request(CMD_STATUS, 2, NULL, 0, g);
+    f[5] ^= 0x10;
+    for (i = 0; i < n; i++) v = CmdParser_Feed(&p, f[i]);
+    CHECK_EQ(v, CMDV_BAD_CRC);
+    CHECK_EQ(p.op, CMD_FANOUT);      // Answered with the opcode and tag as they came
+    CHECK_EQ(p.tag, 1);
+    for (i = 0; i < m; i++) v = CmdParser_Feed(&p, g[i]);
+    CHECK_EQ(v, CMDV_GOOD);
+    CHECK_EQ(p.tag, 2);
+
+    // A length past the payload is refused at its second byte
+    n = CmdLink_Request(CMD_PING, 3, NULL, 0, f);
+    f[3] = CMD_MAX_PAYLOAD + 1;
+    for (i = 0; i < CMD_HEADER_SIZE; i++) {
+        v = CmdParser_Feed(&p, f[i]);
+        CHECK_EQ(v, i + 1 == CMD_HEADER_SIZE ? CMDV_TOO_LONG : CMDV_NONE);
+    }
+    CHECK_EQ(p.tooLong, 1);
+
+    // Garbage with no sync in it is passed over
+    for (i = 0; i < 50; i++) CHECK_EQ(CmdParser_Feed(&p, (uint8_t)(i * 7 + 1) == CMD_SYNC ? 0 : (uint8_t)(i * 7 + 1)),
+                                      CMDV_NONE);
+    for (i = 0; i < m; i++) v = CmdParser_Feed(&p, g[i]);
+    CHECK_EQ(v, CMDV_GOOD);
+    CHECK_EQ(p.skipped, 50);
+    CHECK_EQ(p.badCrc, 1);
+    CHECK_EQ(p.frames, 2);
+}
+
+// --- FUZZ ---
+// Every GOOD must be a frame that ends at that byte: built again from what
+// the parser holds it is the stream's last bytes. After any stream, one
+// frame of filler (no sync in it) brings the parser back to the hunt
+static void Check_Good(const CmdParser *p, const uint8_t *stream, size_t end) {
+    uint8_t f[CMD_MAX_FRAME];
+    size_t n = CmdLink_Request(p->op, p->tag, p->payload, p->len, f);
+    CHECK(n > 0 && n <= end);
+    if (n > 0 && n <= end) CHECK(memcmp(stream + end - n, f, n) == 0);
+}
+
+static void Recover(CmdParser *p) {
+    uint8_t f[CMD_MAX_FRAME];
+    size_t n = CmdLink_Request(CMD_PING, 0xEE, NULL, 0, f), i;
+    CmdVerdict v = CMDV_NONE;
+    for (i = 0; i < CMD_MAX_FRAME; i++) CmdParser_Feed(p, 0);
+    CHECK_EQ(p->got, 0);
+    for (i = 0; i < n; i++) v = CmdParser_Feed(p, f[i]);
+    CHECK_EQ(v, CMDV_GOOD);
+    CHECK_EQ(p->tag, 0xEE);
+}
+
+static void Test_Fuzz(void) {
+    static uint8_t stream[1 << 16];
+    uint32_t s = 2024;
+    unsigned round, good = 0, sent = 0;
+    for (round = 0; round < 200; round++) {
+        CmdParser p;
+        size_t n = 0, i;
+        unsigned frames = 0, flips = 0;
+        CmdParser_Init(&p, 0);
+        if (round & 1) {
+            // Random bytes, the sync made common
+            for (n = 0; n < sizeof(stream) / 8; n++)
+                stream[n] = Next(&s) % 8 == 0 ? CMD_SYNC : (uint8_t)Next(&s);
+        } else {
+            // Good frames with bits flipped, bytes dropped and bytes doubled
+            while (n + 2 * CMD_MAX_FRAME < sizeof(stream) / 4) {
+                uint8_t payload[CMD_MAX_PAYLOAD];
+                uint16_t len = (uint16_t)(Next(&s) % 16 ? Next(&s) % 9 : Next(&s) % (CMD_MAX_PAYLOAD + 1));
+                for (i = 0; i < len; i++) payload[i] = (uint8_t)Next(&s);
+                n += CmdLink_Request((uint8_t)(Next(&s) % 18), (uint8_t)frames, payload, len, stream + n);
+                frames++;
+            }
+            for (i = 0; i < n; i++) {
+                uint32_t r = Next(&s) % 1000;
+                if (r == 0) { stream[i] ^= (uint8_t)(1u << Next(&s) % 8); flips++; }
+                else if (r == 1 && i + 1 < n) { memmove(stream + i, stream + i + 1, n - i - 1); n--; flips++; }
+                else if (r == 2) { memmove(stream + i + 1, stream + i, n - i); n++; i++; flips++; }
+            }
+        }
+        for (i = 0; i < n; i++) {
+            CmdVerdict v = CmdParser_Feed(&p, stream[i]);
+            CHECK(p.got < CMD_HEADER_SIZE || p.len <= CMD_MAX_PAYLOAD);   // Between the length's bytes
+            CHECK(p.got < CMD_HEADER_SIZE + CMD_MAX_PAYLOAD + CMD_CRC_SIZE);
+            if (v == CMDV_GOOD) Check_Good(&p, stream, i + 1);
+        }
+        CHECK_EQ(p.frames + p.badCrc + p.tooLong + p.skipped > 0, 1);
+        if (frames) {
+            // Damage costs the frames it touches and a few after, not the rest
+            CHECK(p.frames + 4 * flips >= frames);
+            good += p.frames;
+            sent += frames;
+        }
+        Recover(&p);
+    }
+    CHECK(good > sent * 9 / 10);
+}
+
+int main(void) {
+    Test_Format();
+    Test_Command_Line();
+    Test_Round_Trip();
+    Test_Pipeline();
+    Test_Damage();
+    Test_Fuzz();
+    return CHECK_DONE();
+}
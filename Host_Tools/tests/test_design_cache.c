@@ -0,0 +1,254 @@
+/*
+ * Design cache and programming daemon: SHA-256 against the FIPS vectors,
+ * a design built once and found again without reading the file (also
+ * after a reopen), its frame and wire images the same as made on the
+ * fly, a bad executable refused; then progd serving a farm of simulated
+ * programmers twice on the same open ports past an idle client, and a
+ * bitstream with its executable as one session image
+ */
+
+#include "check.h"
+#include "chunk_link.h"
+#include "host_file.h"
+#include "mcu_farm.h"
+#include "prog_daemon.h"
+#include "session_image.h"
+#include "wire_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define SLICE  (32u * 1024u)   // Past the TAP's minimum stream, quick to shift
+#define BOARDS 4
+
+static void Save(const char *path, const uint8_t *data, size_t len) {
+    FILE *f = fopen(path, "wb");
+    CHECK(f != NULL);
+    if (!f) return;
+    CHECK_EQ(fwrite(data, 1, len, f), len);
+    fclose(f);
+}
+
+static void Test_Sha256(void) {
+    static const struct { const char *in, *hex; } V[] = {
+        { "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+        { "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+        { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+    };
+    uint8_t digest[SHA256_SIZE], a[1000];
+    char hex[SHA256_HEX];
+    Sha256 s;
+    size_t i;
+    for (i = 0; i < sizeof(V) / sizeof(V[0]); i++) {
+        Sha256_Digest(V[i].in, strlen(V[i].in), digest);
+        Sha256_Hex(digest, hex);
+        CHECK(strcmp(hex, V[i].hex) == 0);
+    }
+    // A million 'a', in pieces that straddle the blocks
+    memset(a, 'a', sizeof(a));
+    Sha256_Init(&s);
+    for (i = 0; i < 1000; i++) Sha256_Update(&s, a, 1000);
+    Sha256_Final(&s, digest);
+    Sha256_Hex(digest, hex);
+    CHECK(strcmp(hex, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0") == 0);
+}
+
+static void Test_Cache(const char *dir, const char *bitsPath, const char *exePath, const uint8_t *bits,
+                       const uint8_t *exe, size_t exeLen) {
+    static char ids[8][DESIGN_ID_SIZE];
+    DesignCache c;
+    const Design *d, *e, *s;
+    char id[DESIGN_ID_SIZE], prefix[12];
+    uint8_t frame[CHUNK_HEADER_SIZE + 256 + CHUNK_CRC_SIZE], *wire;
+    size_t n;
+    int built;
+
+    CHECK_EQ(DesignCache_Open(&c, dir, 256), 0);
+    d = DesignCache_Add(&c, bitsPath, NULL, &built);
+    CHECK(d != NULL);
+    if (!d) return;
+    CHECK(built);
+    CHECK_EQ(c.hashed, 1);
+    CHECK_EQ(d->len, SLICE);
+    CHECK(memcmp(d->data, bits, SLICE) == 0);
+    CHECK(d->session == NULL);
+    strcpy(id, d->id);
+
+    // Frames as ChunkSender would make them, the last one flagged
+    CHECK_EQ(d->framesLen, ChunkLink_ImageSize(SLICE, 256));
+    n = ChunkLink_Frame(0, 0, bits, 256, frame);
+    CHECK(memcmp(d->frames, frame, n) == 0);
+    n = ChunkLink_Frame(SLICE / 256 - 1, CHUNK_LAST, bits + SLICE - 256, 256, frame);
+    CHECK(memcmp(d->frames + d->framesLen - n, frame, n) == 0);
+    wire = malloc(WIRE_HEADER_SIZE + SLICE);
+    CHECK_EQ(d->wireLen, WireImage_Build(bits, SLICE, wire, WIRE_HEADER_SIZE + SLICE));
+    CHECK(memcmp(d->wire, wire, d->wireLen) == 0);
+    free(wire);
+
+    // Seen before: not read, not built, the same mapping
+    e = DesignCache_Add(&c, bitsPath, NULL, &built);
+    CHECK(e == d);
+    CHECK(!built);
+    CHECK_EQ(c.hashed, 1);
+    CHECK_EQ(c.hits, 1);
+    memcpy(prefix, id, 8);
+    prefix[8] = 0;
+    CHECK(DesignCache_Find(&c, prefix) == d);
+    prefix[4] = 0;
+    CHECK(DesignCache_Find(&c, prefix) == NULL);    // Too short to be an id
+
+    // With the executable: one session image of the two
+    s = DesignCache_Add(&c, bitsPath, exePath, &built);
+    CHECK(s != NULL);
+    if (s) {
+        CHECK(built);
+        CHECK(strncmp(s->id, id, SHA256_HEX - 1) == 0 && s->id[SHA256_HEX - 1] == '+');
+        CHECK_EQ(s->sessionLen, SessionImage_Size(SLICE, exeLen, 256));
+        n = s->sessionLen;
+        wire = malloc(n);
+        CHECK_EQ(SessionImage_Build(bits, SLICE, exe, exeLen, 256, wire, n), n);
+        CHECK(memcmp(s->session, wire, n) == 0);
+        free(wire);
+    }
+    // The bitstream is no executable
+    CHECK(DesignCache_Add(&c, bitsPath, bitsPath, &built) == NULL);
+    CHECK(strcmp(c.error, "not a NEORV32 executable") == 0);
+    CHECK_EQ(DesignCache_List(&c, ids, 8), 2);
+    CHECK(strcmp(ids[0], id) == 0 || strcmp(ids[1], id) == 0);
+    DesignCache_Close(&c);
+
+    // A fresh process: the index knows the file, the objects are there
+    CHECK_EQ(DesignCache_Open(&c, dir, 256), 0);
+    d = DesignCache_Add(&c, bitsPath, NULL, &built);
+    CHECK(d != NULL && strcmp(d->id, id) == 0);
+    CHECK(!built);
+    CHECK_EQ(c.hashed, 0);
+    CHECK_EQ(c.builds, 0);
+    CHECK_EQ(c.loads, 1);
+    DesignCache_Close(&c);
+}
+
+static int Ask(const char *sock, const char *req, char *reply, size_t cap) {
+    return ProgDaemon_Request(sock, req, reply, cap);
+}
+
+static int Connect(const char *sock) {
+    struct sockaddr_un a = { .sun_family = AF_UNIX };
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    snprintf(a.sun_path, sizeof(a.sun_path), "%s", sock);
+    if (fd >= 0 && connect(fd, (struct sockaddr *)&a, sizeof(a)) < 0) { close(fd); return -1; }
+    return fd;
+}
+
+static void Test_Daemon(const char *dir, const char *bitsPath, const char *exePath, size_t exeLen) {
+    McuFarmConfig c = { BOARDS, 4096, 0, 0, 0, 200.0 };
+    McuFarm f;
+    ProgDaemon d;
+    char sock[160], req[1024], reply[4096], id[DESIGN_ID_SIZE], session[DESIGN_ID_SIZE];
+    pid_t pid;
+    int i, status, done, ports, idle, partial;
+    unsigned prep, opened;
+
+    snprintf(sock, sizeof(sock), "%s/progd.sock", dir);
+    CHECK_EQ(McuFarm_Start(&f, &c), 0);
+    CHECK_EQ(ProgDaemon_Open(&d, sock, dir, 256, 0), 0);
+    d.configMs = 1000;
+    if ((pid = fork()) == 0) _exit(ProgDaemon_Serve(&d) < 0);
+    close(d.listenFd);
+    d.listenFd = -1;
+    DesignCache_Close(&d.cache);
+
+    // Connected and silent, or half a line in: neither holds up the rest
+    idle = Connect(sock);
+    partial = Connect(sock);
+    CHECK(idle >= 0 && partial >= 0);
+    CHECK(write(partial, "sta", 3) == 3);
+
+    snprintf(req, sizeof(req), "add %s", bitsPath);
+    CHECK_EQ(Ask(sock, req, reply, sizeof(reply)), 0);
+    CHECK(sscanf(reply, "ok %s", id) == 1);
+    CHECK(strstr(reply, " cached ") != NULL);          // Test_Cache built it
+
+    // Twice by id: the same ports, opened once
+    for (i = 0; i < 2; i++) {
+        int k;
+        snprintf(req, sizeof(req), "program %.12s", id);
+        for (k = 0; k < BOARDS; k++) {
+            strcat(req, " ");
+            strcat(req, McuFarm_Path(&f, k));
+        }
+        CHECK_EQ(Ask(sock, req, reply, sizeof(reply)), 0);
+        CHECK(strstr(reply, "FAIL") == NULL);
+        CHECK(sscanf(strstr(reply, "\nok ") + 4, "%d/%d prep_us %u", &done, &ports, &prep) == 3);
+        CHECK_EQ(done, BOARDS);
+        CHECK_EQ(ports, BOARDS);
+    }
+    CHECK_EQ(Ask(sock, "ports", reply, sizeof(reply)), 0);
+    CHECK(sscanf(strstr(reply, "ok "), "ok %d opened %u", &ports, &opened) == 2);
+    CHECK_EQ(ports, BOARDS);
+    CHECK_EQ(opened, BOARDS);
+    CHECK(strstr(reply, "runs 2") != NULL);
+
+    // The bitstream and the executable as one session image
+    snprintf(req, sizeof(req), "add %s %s", bitsPath, exePath);
+    CHECK_EQ(Ask(sock, req, reply, sizeof(reply)), 0);
+    CHECK(sscanf(reply, "ok %s", session) == 1);
+    snprintf(req, sizeof(req), "program %s %s %s", session, McuFarm_Path(&f, 0), McuFarm_Path(&f, 1));
+    CHECK_EQ(Ask(sock, req, reply, sizeof(reply)), 0);
+    CHECK(strstr(reply, "ok 2/2 ") != NULL);
+    CHECK(strstr(reply, "session frames") != NULL);
+
+    CHECK_EQ(Ask(sock, "list", reply, sizeof(reply)), 0);
+    CHECK(strstr(reply, id) != NULL && strstr(reply, session) != NULL);
+    CHECK_EQ(Ask(sock, "program 00000000 /dev/null", reply, sizeof(reply)), 1);
+    CHECK_EQ(Ask(sock, "bogus", reply, sizeof(reply)), 1);
+    // The rest of the half line, answered on its own connection
+    CHECK(write(partial, "ts\n", 3) == 3);
+    CHECK(read(partial, reply, sizeof(reply)) > 0 && strncmp(reply, "ok hits ", 8) == 0);
+    close(partial);
+    CHECK_EQ(Ask(sock, "shutdown", reply, sizeof(reply)), 0);
+    CHECK_EQ(waitpid(pid, &status, 0), pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(Ask(sock, "list", reply, sizeof(reply)) < 0);
+    close(idle);
+    McuFarm_Stop(&f);
+
+    for (i = 0; i < BOARDS; i++) {
+        const McuFarmBoard *b = &f.board[i];
+        CHECK(b->done);
+        CHECK_EQ(b->configs, i < 2 ? 3 : 2);
+        CHECK_EQ(b->staged, i < 2 ? exeLen : 0);
+    }
+    McuFarm_Free(&f);
+}
+
+int main(void) {
+    char dir[] = "/tmp/design_cache_XXXXXX", bitsPath[96], exePath[96], cmd[160];
+    size_t len = 0, exeLen = 0;
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &len);
+    uint8_t *exe = HostFile_Load("../JTAG_Programmer_Serial/hello.exe", &exeLen);
+    CHECK(bits != NULL && len >= SLICE);
+    CHECK(exe != NULL);
+    CHECK(mkdtemp(dir) != NULL);
+    if (!bits || len < SLICE || !exe) return CHECK_DONE();
+    snprintf(bitsPath, sizeof(bitsPath), "%s/slice.bin", dir);
+    snprintf(exePath, sizeof(exePath), "%s/hello.exe", dir);
+    Save(bitsPath, bits, SLICE);
+    Save(exePath, exe, exeLen);
+
+    Test_Sha256();
+    Test_Cache(dir, bitsPath, exePath, bits, exe, exeLen);
+    Test_Daemon(dir, bitsPath, exePath, exeLen);
+
+    snprintf(cmd, sizeof(cmd), "rm -rf %s", dir);
+    if (system(cmd) != 0) CHECK(0);
+    free(bits);
+    free(exe);
+    return CHECK_DONE();
+}
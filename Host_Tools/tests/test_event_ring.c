@@ -0,0 +1,66 @@
+/*
+ * Emulator event queue: exact counts, counted drops, one log line per poll run
+ */
+
+#include "check.h"
+#include "event_ring.h"
+#include "jtag_master.h"
+#include "tap_chain.h"
+
+static void Test_Ring(void) {
+    EventRing q;
+    uint8_t e = 0;
+    int i, ok = 1;
+
+    EventRing_Init(&q, 32);
+    for (i = 0; i < 40; i++) EventRing_Push(&q, (uint8_t)i);
+    CHECK_EQ(EventRing_Level(&q), 32);
+    CHECK_EQ(q.dropped, 8);
+    for (i = 0; i < 32; i++) ok &= EventRing_Pop(&q, &e) && e == i;
+    CHECK(ok);
+    CHECK(!EventRing_Pop(&q, &e));
+
+    // FIFO order survives the 8-bit indices wrapping many times
+    for (i = 0; i < 1000; i++) {
+        EventRing_Push(&q, (uint8_t)i);
+        EventRing_Push(&q, (uint8_t)(i + 1));
+        ok &= EventRing_Pop(&q, &e) && e == (uint8_t)i;
+        ok &= EventRing_Pop(&q, &e) && e == (uint8_t)(i + 1);
+    }
+    CHECK(ok);
+    CHECK_EQ(q.dropped, 8);
+}
+
+int main(void) {
+    static TapChain chain;
+    JtagMaster m;
+    GowinTap *t;
+    uint8_t e;
+    int i, statusLogged = 0;
+
+    Test_Ring();
+
+    TapChain_Init(&chain); TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    t = TapChain_Gowin(&chain, 0);
+    Jtag_ResetTap(&m);
+    Jtag_Pulse(&m, 0, 1);
+
+    // Erase followed by 1000 back-to-back polls: every poll counted, one logged
+    Jtag_SendCommand(&m, CMD_ERASE);
+    for (i = 0; i < 1000; i++) Jtag_ReadStatus(&m);
+    Jtag_SendCommand(&m, CMD_ERASE_DONE);
+    CHECK_EQ(t->eventCount[EVT_CMD_STATUS], 1000);
+    CHECK_EQ(t->diagErasePolls, 1000);
+    while (EventRing_Pop(&t->log, &e)) statusLogged += (e == EVT_CMD_STATUS);
+    CHECK_EQ(statusLogged, 1);
+    CHECK_EQ(t->log.dropped, 0);
+
+    // Undrained flood: the ring drops, the counters do not
+    for (i = 0; i < 100; i++) { Jtag_SendCommand(&m, CMD_READ_STATUS); Jtag_SendCommand(&m, CMD_IDCODE); }
+    CHECK_EQ(t->eventCount[EVT_CMD_STATUS], 1100);
+    CHECK_EQ(t->eventCount[EVT_CMD_IDCODE], 100);
+    CHECK_EQ(EventRing_Level(&t->log), 64);
+    CHECK_EQ(t->log.dropped, 200 - 64);
+    return CHECK_DONE();
+}
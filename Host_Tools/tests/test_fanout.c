@@ -0,0 +1,48 @@
+/*
+ * Fan-out programming: one broadcast session, per-board status
+ */
+
+#include "check.h"
+#include "fanout_bus.h"
+#include "jtag_fanout.h"
+
+#include <stdlib.h>
+
+static const size_t streamLen = MIN_STREAM_BITS / 8 + 64;
+
+static uint64_t Program(int boards, int unplugged, uint32_t *status, FanoutBus *bus, int *done) {
+    JtagMaster m;
+    uint8_t *bits = calloc(streamLen, 1);
+    FanoutBus_Init(bus, boards);
+    if (unplugged >= 0) bus->connected[unplugged] = 0;
+    Jtag_Init(&m, FanoutBus_Clock, bus);
+    *done = JtagFanout_Program(&m, FanoutBus_SampleAll, boards, bits, streamLen, status);
+    free(bits);
+    return m.tckCount;
+}
+
+int main(void) {
+    static FanoutBus bus;
+    uint32_t status[FANOUT_MAX];
+    uint64_t one, four;
+    int done, t;
+
+    one = Program(1, -1, status, &bus, &done);
+    CHECK_EQ(done, 1);
+
+    four = Program(4, -1, status, &bus, &done);
+    CHECK_EQ(done, 4);
+    for (t = 0; t < 4; t++) {
+        CHECK(bus.board[t].dev[0].u.gowin.leds & LED_PROG_5);
+        CHECK_EQ(status[t] & STATUS_DONE_BIT, STATUS_DONE_BIT);
+    }
+    // Four boards cost exactly the TCKs of one
+    CHECK_EQ(four, one);
+
+    // A missing board is reported on its own line, the others still pass
+    Program(4, 2, status, &bus, &done);
+    CHECK_EQ(done, 3);
+    CHECK_EQ(status[2], 0);
+    CHECK_EQ(status[3] & STATUS_DONE_BIT, STATUS_DONE_BIT);
+    return CHECK_DONE();
+}
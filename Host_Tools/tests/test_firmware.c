@@ -0,0 +1,242 @@
+/*
+ * The programmer's host build (-XJTAG_TEST_HAL=host) run whole: the
+ * firmware in a child process with USART2 on a pty, driven over its
+ * command line, its SPI1 and pins on sim/hal_target.c
+ * - sspi: the bitstream sent the moment the prompt arrives; the IDCODE,
+ *   status, byte count and DONE the shipped sspi.adb reads back off the
+ *   SSPI target
+ * - config with a manifest: mcu_to_fpga.Run_Manifest's `manifest` line
+ *   against sim/mcu_manifest.c, its C mirror, on the same manifest, for a
+ *   full run and one failure of each kind the mirror's tests cover
+ * - JTAG_TEST_FIRMWARE names the build; `make fw-check` builds it and sets
+ *   it. Without it there is nothing to run and the test passes empty
+ */
+
+#include "check.h"
+#include "boot_cache.h"
+#include "hal_target.h"
+#include "host_file.h"
+#include "manifest.h"
+#include "mcu_manifest.h"
+#include "pty_link.h"
+#include "session_image.h"
+#include "sspi_target.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define LINE_MS 5000                // Longest a reply line may take
+#define SLICE   (32u * 1024u)       // Past the TAP's minimum stream, quick to shift
+#define ID      0x1100481Bu         // The Gowin TAP model's IDCODE
+#define AREA    BOOT_AREA_DEFAULT   // Cache_Size as alire.toml has it
+
+typedef struct {
+    PtyLink link;
+    pid_t   pid;
+    char    buf[512];
+    size_t  len;
+} Firmware;
+
+static int Start(Firmware *f, const char *path) {
+    memset(f, 0, sizeof(*f));
+    if (PtyLink_Open(&f->link) < 0) return -1;
+    if ((f->pid = fork()) == 0) {
+        setenv("JTAG_TEST_USART2", f->link.path, 1);
+        setenv("JTAG_TEST_BOARDS", "1", 1);
+        setenv("JTAG_TEST_DTM", "sba", 1);   // As mcu_manifest starts the core
+        execl(path, path, (char *)NULL);
+        _exit(127);
+    }
+    return f->pid > 0 ? 0 : -1;
+}
+
+static void Stop(Firmware *f) {
+    int status;
+    if (f->pid > 0) {
+        kill(f->pid, SIGTERM);
+        waitpid(f->pid, &status, 0);
+    }
+    PtyLink_Close(&f->link);
+}
+
+static int Send(Firmware *f, const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len) {
+        struct pollfd pfd = { f->link.master, POLLOUT, 0 };
+        ssize_t n;
+        if (poll(&pfd, 1, LINE_MS) <= 0) return -1;
+        if ((n = write(f->link.master, p, len)) < 0) {
+            if (errno == EAGAIN || errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+// The next reply line, CR LF stripped; -1 if none comes in LINE_MS
+static int Line(Firmware *f, char *line, size_t cap) {
+    for (;;) {
+        char *nl = memchr(f->buf, '\n', f->len);
+        struct pollfd pfd = { f->link.master, POLLIN, 0 };
+        ssize_t n;
+        if (nl) {
+            size_t k = (size_t)(nl - f->buf);
+            size_t c = k && f->buf[k - 1] == '\r' ? k - 1 : k;
+            if (c >= cap) c = cap - 1;
+            memcpy(line, f->buf, c);
+            line[c] = 0;
+            memmove(f->buf, nl + 1, f->len - k - 1);
+            f->len -= k + 1;
+            return 0;
+        }
+        if (f->len == sizeof(f->buf)) f->len = 0;   // A line longer than the buffer is dropped
+        if (poll(&pfd, 1, LINE_MS) <= 0) return -1;
+        if ((n = read(f->link.master, f->buf + f->len, sizeof(f->buf) - f->len)) <= 0) {
+            if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+            return -1;
+        }
+        f->len += (size_t)n;
+    }
+}
+
+// Lines until one that starts with `text`
+static int Expect(Firmware *f, const char *text, char *line, size_t cap) {
+    while (Line(f, line, cap) == 0)
+        if (strncmp(line, text, strlen(text)) == 0) return 0;
+    return -1;
+}
+
+static void Test_Sspi(const char *path) {
+    static uint8_t bits[2048];   // One write: the pty takes it whole
+    Firmware f;
+    char line[256];
+    unsigned idcode = 0, status = 0, bytes = 0;
+    size_t i;
+
+    for (i = 0; i < sizeof(bits); i++) bits[i] = (uint8_t)(i * 7);
+    CHECK_EQ(Start(&f, path), 0);
+    CHECK_EQ(Send(&f, "sspi\r", 5), 0);
+    CHECK_EQ(Expect(&f, "Send configuration bitstream (SSPI)", line, sizeof(line)), 0);
+    // At once: the firmware is still erasing, the ring must hold it
+    CHECK_EQ(Send(&f, bits, sizeof(bits)), 0);
+    CHECK_EQ(Expect(&f, "I ", line, sizeof(line)), 0);
+    CHECK(sscanf(line, "I 0x%x", &idcode) == 1);
+    CHECK_EQ(Line(&f, line, sizeof(line)), 0);
+    CHECK(sscanf(line, "S 0x%x bytes %u", &status, &bytes) == 2);
+    CHECK_EQ(Line(&f, line, sizeof(line)), 0);
+    CHECK(strcmp(line, "DONE") == 0);
+    CHECK_EQ(idcode, SSPI_ID_VAL);
+    CHECK_EQ(status, SSPI_STATUS_BASE | SSPI_STATUS_DONE);
+    CHECK_EQ(bytes, sizeof(bits));
+    Stop(&f);
+}
+
+static uint8_t cache[AREA], stage[SESSION_STAGE_SIZE], image[AREA];
+static size_t  imageLen;
+
+// IDCODE, SRAM, verify, flash, verify, load, start
+static int Full(ManifestStep *s, const uint8_t *bits, const uint8_t *exe, size_t exeLen) {
+    memset(s, 0, sizeof(ManifestStep) * MANIFEST_MAX_STEPS);
+    s[0].kind = MF_IDCODE; s[0].value = ID; s[0].mask = 0xFFFFFFFFu;
+    s[1].kind = MF_SRAM; s[1].length = SLICE; s[1].data = bits;
+    s[2].kind = MF_VERIFY;
+    s[3].kind = MF_FLASH; s[3].length = (uint32_t)imageLen; s[3].data = image;
+    s[4].kind = MF_VERIFY;
+    s[5].kind = MF_LOAD; s[5].length = (uint32_t)exeLen; s[5].value = BootCache_Crc32(exe, exeLen); s[5].data = exe;
+    s[6].kind = MF_START; s[6].arg = MF_START_DEBUG;
+    return 7;
+}
+
+// The first `send` bytes of a manifest through `config`, and through the
+// mirror; the two reports must agree field for field
+static void Conforms(const char *path, const uint8_t *m, size_t send, ManifestOutcome expect) {
+    Firmware f;
+    McuManifestReport r;
+    char line[256], result[32] = "";
+    unsigned step = 0, steps = 0, idcode = 0, status = 0, bytes = 0, flashed = 0, staged = 0;
+
+    memset(cache, 0xFF, sizeof(cache));
+    memset(stage, 0xFF, sizeof(stage));
+    HalTarget_Init(1);
+    HalTarget_UseDebug(1);
+    CHECK_EQ(McuManifest_Run(m, send, cache, AREA, stage, SESSION_STAGE_SIZE, &r), expect);
+
+    CHECK_EQ(Start(&f, path), 0);
+    CHECK_EQ(Send(&f, "config\r", 7), 0);
+    CHECK_EQ(Expect(&f, "Configuring FPGA", line, sizeof(line)), 0);
+    CHECK_EQ(Send(&f, m, send), 0);
+    CHECK_EQ(Expect(&f, "manifest ", line, sizeof(line)), 0);
+    CHECK(sscanf(line, "manifest %31s step %u of %u idcode 0x%x status 0x%x bytes %u flashed %u staged %u",
+                 result, &step, &steps, &idcode, &status, &bytes, &flashed, &staged) == 8);
+    Stop(&f);
+
+    CHECK(strcmp(result, Manifest_OutcomeName(r.result)) == 0);
+    CHECK_EQ(step, r.step);
+    CHECK_EQ(steps, r.steps);
+    CHECK_EQ(idcode, r.idcode);
+    CHECK_EQ(status, r.status);
+    CHECK_EQ(bytes, r.bytes);
+    CHECK_EQ(flashed, r.flashed);
+    CHECK_EQ(staged, r.staged);
+}
+
+static void Test_Manifest(const char *path, const uint8_t *bits, const uint8_t *exe, size_t exeLen) {
+    ManifestStep s[MANIFEST_MAX_STEPS];
+    uint8_t *m;
+    size_t len, data = MANIFEST_HEADER_SIZE + 7 * MANIFEST_STEP_SIZE;
+    int n;
+
+    n = Full(s, bits, exe, exeLen);
+    len = Manifest_Size(s, n);
+    m = malloc(len);
+    CHECK_EQ(Manifest_Build(s, n, m, len), len);
+    Conforms(path, m, len, MF_DONE);
+    Conforms(path, m, data + 1000, MF_SHORT_DATA);              // Cut inside the bitstream
+    Conforms(path, m, data + SLICE + 1000, MF_SHORT_DATA);      // ... inside the boot image
+    m[data + SLICE + BOOT_HEADER_SIZE + 100] ^= 0x10;           // Damaged on the way
+    Conforms(path, m, len, MF_VERIFY_FAIL);
+    free(m);
+
+    s[0].value = 0x0100481Bu;                                   // Another part on the pins
+    m = malloc(len);
+    CHECK_EQ(Manifest_Build(s, n, m, len), len);
+    Conforms(path, m, len, MF_WRONG_IDCODE);
+    free(m);
+
+    n = Full(s, bits, exe, exeLen);
+    s[5].value ^= 1;                                            // Firmware off its CRC
+    m = malloc(len);
+    CHECK_EQ(Manifest_Build(s, n, m, len), len);
+    Conforms(path, m, len, MF_BAD_FIRMWARE);
+    free(m);
+}
+
+int main(void) {
+    const char *path = getenv("JTAG_TEST_FIRMWARE");
+    size_t len = 0, exeLen = 0;
+    uint8_t *bits, *exe;
+    if (!path || !*path) {
+        printf("no JTAG_TEST_FIRMWARE: nothing to run (make fw-check)\n");
+        return CHECK_DONE();
+    }
+    Test_Sspi(path);
+
+    bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &len);
+    exe = HostFile_Load("../JTAG_Programmer_Serial/hello.exe", &exeLen);
+    CHECK(bits != NULL && len >= SLICE);
+    CHECK(exe != NULL);
+    if (!bits || len < SLICE || !exe) return CHECK_DONE();
+    imageLen = BootCache_Build(bits, SLICE, image, sizeof(image));
+    Test_Manifest(path, bits, exe, exeLen);
+    free(bits);
+    free(exe);
+    return CHECK_DONE();
+}
@@ -0,0 +1,148 @@
+/*
+ * Host HAL target: the pin sequences utils.adb and fanout.adb write read
+ * the IDCODE back, SPI bytes cost eight TCKs, missing boards read low,
+ * and sspi.adb's session on the SSPI lines configures the SSPI target
+ * without clocking a TAP
+ */
+
+#include "check.h"
+#include "hal_target.h"
+#include "sspi_master.h"
+
+#include <time.h>
+
+// utils.Shift_Bit: TDO is sampled with TCK low, before the rising edge
+static int Shift_Bit(int tms, int tdi) {
+    int tdo;
+    HalTarget_Pin(HAL_PIN_TMS, tms);
+    HalTarget_Pin(HAL_PIN_TDI, tdi);
+    HalTarget_Pin(HAL_PIN_TCK, 0);
+    tdo = HalTarget_PinRead(HAL_PIN_TDO);
+    HalTarget_Pin(HAL_PIN_TCK, 1);
+    return tdo;
+}
+
+static void Reset_To_Idle(void) {
+    int i;
+    for (i = 0; i < 5; i++) Shift_Bit(1, 0);
+    Shift_Bit(0, 0);
+}
+
+static void Shift_IR(uint8_t cmd) {
+    int i;
+    Shift_Bit(1, 0); Shift_Bit(1, 0); Shift_Bit(0, 0); Shift_Bit(0, 0);   // SELECT-DR, SELECT-IR, CAPTURE-IR, SHIFT-IR
+    for (i = 0; i < 8; i++) Shift_Bit(i == 7, (cmd >> i) & 1);
+    Shift_Bit(1, 0); Shift_Bit(0, 0);                                      // UPDATE-IR, IDLE
+}
+
+static uint32_t Read_DR32(void) {
+    uint32_t v = 0;
+    int i;
+    Shift_Bit(1, 0); Shift_Bit(0, 0); Shift_Bit(0, 0);                     // SELECT-DR, CAPTURE-DR, SHIFT-DR
+    for (i = 0; i < 32; i++) v |= (uint32_t)Shift_Bit(i == 31, 0) << i;
+    Shift_Bit(1, 0); Shift_Bit(0, 0);
+    return v;
+}
+
+static void Test_Idcode(void) {
+    HalTarget_Init(1);
+    Reset_To_Idle();
+    Shift_IR(CMD_IDCODE);
+    CHECK_EQ(Read_DR32(), GOWIN_ID_VAL);
+    CHECK_EQ(HalTarget_Bus()->tckCount, 6 + 14 + 37);
+}
+
+static void Test_Pins(void) {
+    uint64_t before;
+    HalTarget_Init(1);
+    before = HalTarget_Bus()->tckCount;
+    HalTarget_Pin(HAL_PIN_TCK, 1);
+    HalTarget_Pin(HAL_PIN_TCK, 1);          // Already high: no edge
+    HalTarget_Pin(HAL_PIN_TCK, 0);          // Falling edge: no clock
+    CHECK_EQ(HalTarget_Bus()->tckCount - before, 1);
+    HalTarget_Pin(HAL_PIN_TDO, 1);          // Input pin
+    HalTarget_Pin(HAL_PIN_TMS, 1);
+    CHECK_EQ(HalTarget_PinRead(HAL_PIN_TMS), 1);
+}
+
+static void Test_Spi_Byte(void) {
+    uint64_t before;
+    HalTarget_Init(1);
+    Reset_To_Idle();
+    HalTarget_Pin(HAL_PIN_TMS, 0);
+    before = HalTarget_Bus()->tckCount;
+    HalTarget_SpiByte(0xA5);
+    HalTarget_SpiByte(0x00);
+    CHECK_EQ(HalTarget_Bus()->tckCount - before, 16);
+    CHECK_EQ(HalTarget_PinRead(HAL_PIN_TCK), 1);    // Mode 3 idles high
+    CHECK_EQ(HalTarget_PinRead(HAL_PIN_TDI), 0);    // Last bit of 0x00
+}
+
+static void Test_Fanout_Lines(void) {
+    int i;
+    uint32_t lines[32];
+    HalTarget_Init(3);
+    HalTarget_Bus()->connected[1] = 0;
+    Reset_To_Idle();
+    Shift_IR(CMD_IDCODE);
+    Shift_Bit(1, 0); Shift_Bit(0, 0); Shift_Bit(0, 0);
+    for (i = 0; i < 32; i++) {
+        HalTarget_Pin(HAL_PIN_TMS, i == 31);
+        HalTarget_Pin(HAL_PIN_TCK, 0);
+        lines[i] = HalTarget_TdoLines();
+        HalTarget_Pin(HAL_PIN_TCK, 1);
+    }
+    for (i = 0; i < 32; i++) {
+        uint32_t bit = (GOWIN_ID_VAL >> i) & 1u;
+        CHECK_EQ(lines[i], bit | (bit << 2));       // Board 1 unplugged: pulled low
+    }
+}
+
+// hal.SSPI_* as the host body calls them; delays are real, as the
+// firmware's are
+static void Lines_Select(void *c, int csLow) { (void)c; HalTarget_SspiSelect(csLow); }
+static uint8_t Lines_Transfer(void *c, uint8_t mosi) { (void)c; return HalTarget_SpiTransfer(mosi); }
+static int  Lines_Ready(void *c) { (void)c; return HalTarget_SspiReady(); }
+static int  Lines_Done(void *c) { (void)c; return HalTarget_SspiDone(); }
+static void Lines_Reconfig(void *c, int level) { (void)c; HalTarget_SspiReconfig(level); }
+
+static void Lines_Delay(void *c, uint32_t us) {
+    struct timespec ts = { 0, (long)us * 1000 };
+    (void)c;
+    nanosleep(&ts, NULL);
+}
+
+static void Test_Sspi_Lines(void) {
+    static const SspiBus bus = { Lines_Select, Lines_Transfer, Lines_Ready, Lines_Done, Lines_Reconfig, Lines_Delay, 0 };
+    static uint8_t bits[2048];
+    SspiMaster m;
+    uint64_t before;
+    size_t i;
+
+    for (i = 0; i < sizeof(bits); i++) bits[i] = (uint8_t)(i * 7);
+    HalTarget_Init(1);
+    before = HalTarget_Bus()->tckCount;
+    HalTarget_SspiEnable();
+    SspiMaster_Init(&m, &bus);
+    CHECK_EQ(SspiMaster_Program(&m, bits, sizeof(bits)), 1);
+    HalTarget_SpiRelease();
+    CHECK_EQ(m.idcode, SSPI_ID_VAL);
+    CHECK(Sspi_StatusDone(m.status));
+    CHECK_EQ(HalTarget_Sspi()->eventCount[SSPI_EVT_ERR_SEQ], 0);
+    CHECK_EQ(HalTarget_Sspi()->eventCount[SSPI_EVT_ERR_TIMING], 0);
+    CHECK(HalTarget_Sspi()->leds & SSPI_LED_DONE);
+    CHECK_EQ(HalTarget_Bus()->tckCount, before);     // No TAP saw the session
+
+    // Released: SPI1 bytes are TCKs again
+    HalTarget_SpiByte(0x00);
+    CHECK_EQ(HalTarget_Bus()->tckCount - before, 8);
+}
+
+int main(void) {
+    Test_Idcode();
+    Test_Pins();
+    Test_Spi_Byte();
+    Test_Fanout_Lines();
+    Test_Sspi_Lines();
+    return CHECK_DONE();
+}
@@ -0,0 +1,141 @@
+/*
+ * Command sequence optimizer: the session as ops, the optimized session on
+ * the TAP model, and the replay check catching a change that matters
+ */
+
+#include "check.h"
+#include "jtag_fanout.h"
+#include "jtag_opt.h"
+#include "tap_chain.h"
+
+#include <stdlib.h>
+
+#define BITS_LEN (MIN_STREAM_BITS / 8 + 512)
+
+// Edge recorder in front of a chain: FNV-1a over TMS/TDI, one byte per edge
+typedef struct { TapChain chain; uint64_t hash; } Rec;
+
+static uint8_t Rec_Clock(void *ctx, uint8_t tms, uint8_t tdi) {
+    Rec *r = ctx;
+    r->hash = (r->hash ^ (uint64_t)(tms | tdi << 1)) * 0x100000001B3ull;
+    return TapChain_Clock(&r->chain, tms, tdi);
+}
+
+static void Rec_Init(Rec *r, JtagMaster *m) {
+    TapChain_Init(&r->chain);
+    TapChain_AddGowin(&r->chain);
+    r->hash = 0xCBF29CE484222325ull;
+    Jtag_Init(m, Rec_Clock, r);
+}
+
+static uint8_t *Bits(void) {
+    uint8_t *b = malloc(BITS_LEN);
+    for (size_t i = 0; i < BITS_LEN; i++) b[i] = (uint8_t)(i * 37);
+    return b;
+}
+
+static void Test_Session_Matches_Master(void) {
+    uint8_t *bits = Bits();
+    Rec a, b; JtagMaster ma, mb; JtagSeq s;
+    uint32_t reads[JTAG_SEQ_MAX];
+
+    Rec_Init(&a, &ma);
+    Jtag_ResetTap(&ma);
+    Jtag_InitConfiguration(&ma);
+    Jtag_StreamBitstream(&ma, bits, BITS_LEN);
+    Jtag_FinishConfiguration(&ma);
+
+    JtagSeq_Init(&s);
+    CHECK_EQ(JtagSeq_Session(&s, bits, BITS_LEN), 0);
+    Rec_Init(&b, &mb);
+    JtagSeq_Play(&mb, &s, reads, NULL);
+
+    // As built, the ops are the firmware's edges exactly
+    CHECK_EQ(mb.tckCount, ma.tckCount);
+    CHECK_EQ(b.hash, a.hash);
+    CHECK(reads[s.n - 1] & STATUS_DONE_BIT);
+    free(bits);
+}
+
+static void Test_Optimized_Session(void) {
+    uint8_t *bits = Bits();
+    JtagSeq in, out; JtagOptReport r;
+    TapChain chain; JtagMaster m;
+    uint32_t reads[JTAG_SEQ_MAX];
+    int i, noops = 0, waits = 0;
+
+    JtagSeq_Init(&in);
+    JtagSeq_Session(&in, bits, BITS_LEN);
+    CHECK_EQ(JtagOpt_Run(&in, &out, 1, 0, &r), 0);
+    CHECK(r.equivalent);
+    CHECK_EQ(r.noops, 4);
+    CHECK(r.reads >= 1);
+    CHECK(r.direct > 0);
+    CHECK(r.tckAfter < r.tckBefore);
+    CHECK_EQ(r.opsAfter, out.n);
+    CHECK(JtagOpt_Equivalent(&in, &out, 1, 0));
+
+    for (i = 0; i < out.n; i++) {
+        if (out.op[i].kind == JOP_COMMAND && out.op[i].instr == CMD_NOOP) noops++;
+        if (out.op[i].kind == JOP_IDLE) waits++;
+    }
+    CHECK_EQ(noops, 0);
+    CHECK_EQ(waits, 2);                                // The caller's waits stay
+    CHECK(out.op[out.n - 1].keep);                     // So does the read that counts
+    CHECK_EQ(out.op[out.n - 1].exit, JOP_EXIT_IDLE);   // And the session ends in Idle
+
+    TapChain_Init(&chain); TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    JtagSeq_Play(&m, &out, reads, NULL);
+    CHECK_EQ(m.tckCount, r.tckAfter);
+    CHECK(TapChain_Gowin(&chain, 0)->leds & LED_PROG_5);
+    CHECK_EQ(TapChain_Gowin(&chain, 0)->tapState, TAP_IDLE);
+    CHECK(reads[out.n - 1] & STATUS_DONE_BIT);
+    free(bits);
+}
+
+static void Test_Chain_Target(void) {
+    uint8_t *bits = Bits();
+    JtagSeq in, out; JtagOptReport r;
+
+    JtagSeq_Init(&in);
+    JtagSeq_Session(&in, bits, BITS_LEN);
+    CHECK_EQ(JtagOpt_Run(&in, &out, 3, 1, &r), 0);
+    CHECK(r.tckAfter < r.tckBefore);
+    CHECK(JtagOpt_Equivalent(&in, &out, 3, 1));
+    CHECK_EQ(JtagOpt_Run(&in, &out, 3, 3, &r), -1);
+    free(bits);
+}
+
+static void Test_Replay_Catches_Changes(void) {
+    uint8_t *bits = Bits();
+    JtagSeq in, t;
+    int i;
+
+    JtagSeq_Init(&in);
+    JtagSeq_Session(&in, bits, BITS_LEN);
+
+    // No ERASE_DONE: the bitstream lands without an erase behind it
+    t.n = 0;
+    for (i = 0; i < in.n; i++) if (!(in.op[i].kind == JOP_COMMAND && in.op[i].instr == CMD_ERASE_DONE)) t.op[t.n++] = in.op[i];
+    CHECK(!JtagOpt_Equivalent(&in, &t, 1, 0));
+
+    // A kept read that reads something else
+    t = in;
+    t.op[t.n - 2].instr = CMD_IDCODE;
+    CHECK(!JtagOpt_Equivalent(&in, &t, 1, 0));
+
+    // Ending in Update-DR is not ending in Idle
+    t = in;
+    t.op[t.n - 1].exit = JOP_EXIT_DIRECT;
+    CHECK(!JtagOpt_Equivalent(&in, &t, 1, 0));
+    free(bits);
+}
+
+int main(void) {
+    Test_Session_Matches_Master();
+    Test_Optimized_Session();
+    Test_Chain_Target();
+    Test_Replay_Catches_Changes();
+    return CHECK_DONE();
+}
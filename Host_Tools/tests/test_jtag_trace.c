@@ -0,0 +1,145 @@
+/*
+ * JTAG trace capture: emulator-side folding -> log bytes -> trace stats / VCD
+ */
+
+#include "check.h"
+#include "jtag_capture.h"
+#include "jtag_master.h"
+#include "jtag_trace.h"
+#include "tap_chain.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    TapChain    chain;
+    JtagCapture cap;
+    uint32_t    now;           // Ticks
+    uint32_t    period, high;
+    uint32_t    events;
+} Probe;
+
+// One edge through the chain, recorded the way the emulator's ISR + main loop would
+static uint8_t Probe_Clock(void *ctx, uint8_t tms, uint8_t tdi) {
+    Probe *p = ctx;
+    GowinTap *g = TapChain_Gowin(&p->chain, 0);
+    uint8_t state = (uint8_t)g->tapState, tdo, e;
+
+    p->now += p->period;
+    tdo = TapChain_Clock(&p->chain, tms, tdi);
+    JtagCapture_Edge(&p->cap, p->now, tms, tdi, tdo, state, (uint16_t)p->high);
+    while (EventRing_Pop(&g->log, &e)) { JtagCapture_Event(&p->cap, p->now, e, 0); p->events++; }
+    return tdo;
+}
+
+static void Decode(const JtagCapture *c, JtagTrace *t, LogDecoder *d) {
+    LogRecord r;
+    size_t i;
+    LogDecoder_Init(d);
+    JtagTrace_Init(t);
+    for (i = 0; i < c->len; i++)
+        if (LogDecoder_Push(d, c->buf[i], &r)) JtagTrace_Add(t, &r);
+}
+
+static void Test_Session(void) {
+    static Probe p;
+    static uint8_t bits[13000];
+    JtagMaster m;
+    JtagTrace t;
+    JtagTraceStats s;
+    LogDecoder d;
+    FILE *f;
+    char buf[256];
+    long size;
+    int i, sawX = 0;
+
+    memset(&p, 0, sizeof(p));
+    TapChain_Init(&p.chain); TapChain_AddGowin(&p.chain);
+    JtagCapture_Init(&p.cap);
+    p.period = 6; p.high = 2;                      // 500 kHz, 33 % duty
+    JtagCapture_Boot(&p.cap, 100);
+    p.now = 100;
+    Jtag_Init(&m, Probe_Clock, &p);
+    Jtag_ResetTap(&m);
+    Jtag_Pulse(&m, 0, 1);
+
+    // Five status polls with a 300 us pause after each
+    for (i = 0; i < 5; i++) { Jtag_ReadStatus(&m); p.now += 900; }
+
+    for (i = 0; i < (int)sizeof(bits); i++) bits[i] = (uint8_t)(i * 13);
+    Jtag_InitConfiguration(&m);
+    Jtag_StreamBitstream(&m, bits, sizeof(bits));
+    Jtag_FinishConfiguration(&m);
+    JtagCapture_Flush(&p.cap);
+
+    Decode(&p.cap, &t, &d);
+    CHECK_EQ(d.badRecords, 0);
+    CHECK_EQ(t.badRecords, 0);
+    CHECK(t.traceOn);
+    CHECK_EQ(t.edges, m.tckCount);
+    CHECK_EQ(t.marks, p.events);
+    CHECK(p.cap.len < m.tckCount / 20);           // The bitstream is one run
+
+    JtagTrace_Analyze(&t, 0, &s);
+    CHECK(s.tckHz > 499999.0 && s.tckHz < 500001.0);
+    CHECK(s.minHz > 499999.0 && s.maxHz < 500001.0);
+    CHECK(s.duty > 0.3333 && s.duty < 0.3334);
+    CHECK_EQ(s.gaps, 5);
+    CHECK_EQ(s.scans, 6);
+    CHECK_EQ(s.gapTicks, 5 * 906);
+    CHECK_EQ(s.worst[0].len, 906);
+    CHECK(s.worst[0].mark >= 0 && t.mark[s.worst[0].mark].id == EVT_CMD_STATUS);
+    CHECK_EQ(s.busyTicks + s.gapTicks, s.totalTicks);
+
+    // VCD: header, and the bitstream run shown with TCK = x in its middle
+    f = tmpfile();
+    JtagTrace_WriteVcd(&t, f);
+    size = ftell(f);
+    CHECK(size > 1000);
+    rewind(f);
+    CHECK(fgets(buf, sizeof(buf), f) != NULL);
+    while (fgets(buf, sizeof(buf), f)) sawX |= strcmp(buf, "x!\n") == 0;
+    CHECK(sawX);
+    fclose(f);
+
+    JtagTrace_Free(&t);
+    JtagCapture_Free(&p.cap);
+}
+
+static void Test_Folding(void) {
+    JtagCapture c;
+    JtagTrace t;
+    JtagTraceStats s;
+    LogDecoder d;
+    uint32_t now = 0;
+    int i;
+
+    // 50 Run-Test/Idle clocks, a 2 ms stall, 50 more: two runs, one gap, no duty data
+    JtagCapture_Init(&c);
+    for (i = 0; i < 50; i++) JtagCapture_Edge(&c, now += 30, 0, 0, 0, TAP_IDLE, 0);
+    now += 2 * TRACE_IDLE_TICKS;
+    for (i = 0; i < 50; i++) JtagCapture_Edge(&c, now += 30, 0, 0, 0, TAP_IDLE, 0);
+    // IR shifts stay as single edges so the instruction can be read back
+    for (i = 0; i < 8; i++) JtagCapture_Edge(&c, now += 30, i == 7, (0x41 >> i) & 1, i == 0, TAP_SHIFT_IR, 10);
+    JtagCapture_Flush(&c);
+
+    Decode(&c, &t, &d);
+    CHECK_EQ(t.spans, 2 + 8);
+    CHECK_EQ(t.edges, 108);
+    CHECK_EQ(t.span[0].count, 50);
+    CHECK_EQ(t.span[0].high, 0);
+    CHECK_EQ(t.span[2].tdo, 1);
+    for (i = 0; i < 8; i++) CHECK_EQ(t.span[2 + i].tdi, (0x41 >> i) & 1);
+    JtagTrace_Analyze(&t, 0, &s);
+    CHECK_EQ(s.gaps, 1);
+    CHECK(s.tckHz > 99999.0 && s.tckHz < 100001.0);
+    CHECK(s.duty > 0.3333 && s.duty < 0.3334);    // Only the IR edges carry a high time
+    JtagTrace_Free(&t);
+    JtagCapture_Free(&c);
+}
+
+int main(void) {
+    Test_Session();
+    Test_Folding();
+    return CHECK_DONE();
+}
@@ -0,0 +1,149 @@
+/*
+ * Emulator binary log: encoder (log_record.h) against the host decoder
+ */
+
+#include "check.h"
+#include "log_decode.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const uint32_t values[] = { 0, 1, 127, 128, 0xA5, 16383, 16384, 0x1FFFFF, 0x200000, 0x0FFFFFFF, 0x10000000, 0xFFFFFFFF };
+#define NVALUES (sizeof(values) / sizeof(values[0]))
+
+// Feeds n bytes, copies out whatever records complete
+static int Feed(LogDecoder *d, const uint8_t *p, size_t n, LogRecord *out, int max) {
+    LogRecord rec;
+    int got = 0;
+    size_t i;
+    for (i = 0; i < n; i++)
+        if (LogDecoder_Push(d, p[i], &rec) && got < max) out[got++] = rec;
+    return got;
+}
+
+static int SameFile(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int ca, cb, same = fa && fb;
+    while (same) {
+        ca = getc(fa); cb = getc(fb);
+        if (ca != cb) same = 0;
+        if (ca == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+static void Test_Varint(void) {
+    uint8_t p[5];
+    CHECK_EQ(Log_Varint(p, 0), 1);
+    CHECK_EQ(Log_Varint(p, 127), 1);
+    CHECK_EQ(Log_Varint(p, 128), 2);
+    CHECK_EQ(Log_Varint(p, 16383), 2);
+    CHECK_EQ(Log_Varint(p, 16384), 3);
+    CHECK_EQ(Log_Varint(p, 0xFFFFFFFF), 5);
+    CHECK_EQ(p[4], 0x0F);
+}
+
+static void Test_RoundTrip(void) {
+    static uint8_t stream[NVALUES * NVALUES * LOG_MAX_RECORD];
+    static LogRecord out[NVALUES * NVALUES];
+    LogDecoder d;
+    size_t n = 0, i, j;
+    int ok = 1, got;
+
+    for (i = 0; i < NVALUES; i++)
+        for (j = 0; j < NVALUES; j++)
+            n += Log_Encode(stream + n, (uint8_t)(i * NVALUES + j) & 0x7F, values[i], values[j]);
+
+    LogDecoder_Init(&d);
+    got = Feed(&d, stream, n, out, (int)(NVALUES * NVALUES));
+    CHECK_EQ(got, NVALUES * NVALUES);
+    for (i = 0; i < NVALUES; i++)
+        for (j = 0; j < NVALUES; j++) {
+            LogRecord *r = &out[i * NVALUES + j];
+            ok &= r->id == ((i * NVALUES + j) & 0x7F) && r->dt == values[i] && r->arg == values[j];
+        }
+    CHECK(ok);
+    CHECK_EQ(d.badRecords, 0);
+    CHECK_EQ(d.skipped, 0);
+}
+
+static void Test_Resync(void) {
+    uint8_t s[64];
+    LogRecord out[4];
+    LogDecoder d;
+    size_t n = 0;
+
+    // Line noise before the first sync is skipped
+    s[n++] = 0x00; s[n++] = 0xFF; s[n++] = 0x13;
+    n += Log_Encode(s + n, 9, 3000, 42);
+    LogDecoder_Init(&d);
+    CHECK_EQ(Feed(&d, s, n, out, 4), 1);
+    CHECK_EQ(d.skipped, 3);
+    CHECK_EQ(out[0].arg, 42);
+
+    // A flipped bit costs that record only
+    n = Log_Encode(s, 1, 10, 0xA5);
+    s[3] ^= 0x04;
+    n += Log_Encode(s + n, 2, 20, 7);
+    LogDecoder_Init(&d);
+    CHECK_EQ(Feed(&d, s, n, out, 4), 1);
+    CHECK_EQ(d.badRecords, 1);
+    CHECK_EQ(out[0].id, 2);
+    CHECK_EQ(out[0].dt, 20);
+
+    // A record cut short (UART reset mid-record) before a good one
+    n = Log_Encode(s, 5, 0x200000, 0x10000000) - 3;
+    n += Log_Encode(s + n, 12, 1, 123456);
+    n += Log_Encode(s + n, 13, 2, 99);
+    LogDecoder_Init(&d);
+    CHECK_EQ(Feed(&d, s, n, out, 4), 2);
+    CHECK_EQ(out[0].id, 12);
+    CHECK_EQ(out[0].arg, 123456);
+    CHECK_EQ(out[1].arg, 99);
+
+    // An endless varint is rejected instead of overrunning the buffer
+    memset(s, 0xFF, sizeof(s));
+    s[0] = LOG_SYNC; s[1] = 1;
+    LogDecoder_Init(&d);
+    CHECK_EQ(Feed(&d, s, sizeof(s), out, 4), 0);
+    CHECK(d.badRecords >= 1);
+}
+
+static void Test_Text(void) {
+    LogRecord r = { 0, 0, 0 };
+    char line[160];
+    uint8_t rec[LOG_MAX_RECORD];
+
+    r.id = 10; r.arg = 0x07;
+    LogText_Format(LOG_SRC_JTAG, &r, line, sizeof(line));
+    CHECK(strcmp(line, "[WARN]  Unknown Instruction: 0x07") == 0);
+
+    r.id = 9; r.arg = (0x3B << 8) | 3;
+    LogText_Format(LOG_SRC_SSPI, &r, line, sizeof(line));
+    CHECK(strcmp(line, "[FAIL] SEQUENCE ERROR! Received: 0x3B Expected: WRITE REQ (0x3B)") == 0);
+
+    r.id = 10; r.arg = 1000;
+    LogText_Format(LOG_SRC_SSPI, &r, line, sizeof(line));
+    CHECK(strstr(line, "1000 us") != NULL);
+
+    r.id = 0x55;
+    LogText_Format(LOG_SRC_JTAG, &r, line, sizeof(line));
+    CHECK(strstr(line, "0x55") != NULL);
+
+    // A status poll 1 ms after the last record: 6 bytes instead of a 60-character line
+    CHECK_EQ(Log_Encode(rec, 9, LOG_TICK_HZ / 1000, 1), 6);
+}
+
+int main(void) {
+    Test_Varint();
+    Test_RoundTrip();
+    Test_Resync();
+    Test_Text();
+
+    // Both emulators ship the same header
+    CHECK(SameFile("../MSP432_Communication_Tester/JTAG_Emulator/log_record.h",
+                   "../MSP432_Communication_Tester/SSPI_Emultaor/log_record.h"));
+    return CHECK_DONE();
+}
@@ -0,0 +1,308 @@
+/*
+ * Programming manifest: the header and table bytes, every rule the board
+ * checks before a step runs, then whole runs on the host HAL target: all
+ * seven steps through to the core started from the stage, a wrong IDCODE
+ * that clocks nothing into SRAM or flash, a firmware CRC that keeps the
+ * core halted, a stream cut inside the data, and both verify steps failing
+ */
+
+#include "check.h"
+#include "boot_cache.h"
+#include "hal_target.h"
+#include "host_file.h"
+#include "manifest.h"
+#include "mcu_manifest.h"
+#include "session_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SLICE  (32u * 1024u)   // Past the TAP's minimum stream, quick to shift
+#define ID     0x1100481Bu     // The Gowin TAP model's IDCODE
+#define AREA   BOOT_AREA_DEFAULT
+
+static uint32_t Get32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint8_t cache[AREA], stage[SESSION_STAGE_SIZE], image[AREA];
+static size_t  imageLen;
+
+// IDCODE, SRAM, verify, flash, verify, load, start
+static int Full(ManifestStep *s, const uint8_t *bits, const uint8_t *exe, size_t exeLen) {
+    memset(s, 0, sizeof(ManifestStep) * MANIFEST_MAX_STEPS);
+    s[0].kind = MF_IDCODE; s[0].value = ID; s[0].mask = 0xFFFFFFFFu;
+    s[1].kind = MF_SRAM; s[1].length = SLICE; s[1].data = bits;
+    s[2].kind = MF_VERIFY;
+    s[3].kind = MF_FLASH; s[3].length = (uint32_t)imageLen; s[3].data = image;
+    s[4].kind = MF_VERIFY;
+    s[5].kind = MF_LOAD; s[5].length = (uint32_t)exeLen; s[5].value = BootCache_Crc32(exe, exeLen); s[5].data = exe;
+    s[6].kind = MF_START; s[6].arg = MF_START_DEBUG;
+    return 7;
+}
+
+static size_t Make(const ManifestStep *s, int n, uint8_t **m) {
+    size_t size = Manifest_Size(s, n);
+    *m = malloc(size);
+    CHECK_EQ(Manifest_Build(s, n, *m, size), size);
+    return size;
+}
+
+static ManifestOutcome Run(const uint8_t *m, size_t len, McuManifestReport *r) {
+    memset(cache, 0xFF, sizeof(cache));
+    memset(stage, 0xFF, sizeof(stage));
+    HalTarget_Init(1);
+    HalTarget_UseDebug(1);
+    return McuManifest_Run(m, len, cache, AREA, stage, SESSION_STAGE_SIZE, r);
+}
+
+static int Configured(void) { return (HalTarget_Bus()->board[0].dev[0].u.gowin.leds & LED_PROG_5) != 0; }
+
+static int Blank(const uint8_t *p, size_t n) {
+    while (n--) if (*p++ != 0xFF) return 0;
+    return 1;
+}
+
+static void Test_Format(const uint8_t *bits, const uint8_t *exe, size_t exeLen) {
+    ManifestStep s[MANIFEST_MAX_STEPS], p[MANIFEST_MAX_STEPS];
+    uint8_t *m;
+    int n = Full(s, bits, exe, exeLen), i;
+    size_t len = Make(s, n, &m);
+
+    CHECK_EQ(len, MANIFEST_HEADER_SIZE + 7 * MANIFEST_STEP_SIZE + SLICE + imageLen + exeLen);
+    CHECK_EQ(Get32(m), MANIFEST_MAGIC);
+    CHECK(memcmp(m, "GWMF", 4) == 0);
+    CHECK_EQ(Get32(m + 4), 7);
+    CHECK_EQ(Get32(m + 8), SLICE + imageLen + exeLen);
+    CHECK_EQ(Get32(m + 12), BootCache_Crc32(m + 16, 7 * MANIFEST_STEP_SIZE));
+    CHECK_EQ(Get32(m + 16), MF_IDCODE);
+    CHECK_EQ(Get32(m + 24), ID);
+    CHECK_EQ(Get32(m + 16 + 6 * 16), MF_START | MF_START_DEBUG << 8);
+    // The data in step order behind the table
+    CHECK(memcmp(m + 16 + 7 * 16, bits, SLICE) == 0);
+    CHECK(memcmp(m + 16 + 7 * 16 + SLICE, image, imageLen) == 0);
+    CHECK(memcmp(m + len - exeLen, exe, exeLen) == 0);
+
+    CHECK_EQ(Manifest_Parse(m, len, SESSION_STAGE_SIZE, AREA, p), 7);
+    for (i = 0; i < n; i++) {
+        CHECK_EQ(p[i].kind, s[i].kind);
+        CHECK_EQ(p[i].arg, s[i].arg);
+        CHECK_EQ(p[i].length, s[i].length);
+        CHECK_EQ(p[i].value, s[i].value);
+        CHECK_EQ(p[i].mask, s[i].mask);
+    }
+    // Only the header and table are looked at
+    CHECK_EQ(Manifest_Parse(m, 16 + 7 * 16, SESSION_STAGE_SIZE, AREA, p), 7);
+    CHECK_EQ(Manifest_Parse(m, 16 + 7 * 16 - 1, SESSION_STAGE_SIZE, AREA, p), 0);
+    CHECK(strcmp(Manifest_OutcomeName(MF_WRONG_IDCODE), "WRONG_IDCODE") == 0);
+    CHECK(strcmp(Manifest_OutcomeName(MF_START_FAIL), "START_FAIL") == 0);
+    CHECK_EQ(Manifest_Build(s, 0, m, len), 0);
+    CHECK_EQ(Manifest_Build(s, n, m, len - 1), 0);
+    free(m);
+}
+
+// One change to the full manifest, the board's verdict on it
+static int Takes(const uint8_t *bits, const uint8_t *exe, size_t exeLen, void (*edit)(ManifestStep *s, int *n)) {
+    ManifestStep s[MANIFEST_MAX_STEPS], p[MANIFEST_MAX_STEPS];
+    uint8_t *m;
+    int n = Full(s, bits, exe, exeLen), ok;
+    size_t len;
+    edit(s, &n);
+    len = Make(s, n, &m);
+    ok = Manifest_Parse(m, len, SESSION_STAGE_SIZE, AREA, p) == n;
+    free(m);
+    return ok;
+}
+
+static void Same(ManifestStep *s, int *n) { (void)s; (void)n; }
+static void Verify_First(ManifestStep *s, int *n) { s[0].kind = MF_VERIFY; s[0].mask = 0; (void)n; }
+static void Verify_After_Load(ManifestStep *s, int *n) { s[6].kind = MF_VERIFY; s[6].arg = 0; (void)n; }
+static void Start_Not_Last(ManifestStep *s, int *n) { s[*n] = s[0]; (*n)++; }
+static void Start_Unloaded(ManifestStep *s, int *n) { s[5].kind = MF_START; s[5].length = 0; *n = 6; }
+static void Start_Bad_Arg(ManifestStep *s, int *n) { s[6].arg = 3; (void)n; }
+static void Two_Loads(ManifestStep *s, int *n) { s[6] = s[5]; s[7] = s[6]; s[7].kind = MF_START; s[7].length = 0; *n = 8; }
+static void Odd_Load(ManifestStep *s, int *n) { s[5].length -= 2; (void)n; }
+static void Big_Load(ManifestStep *s, int *n) { s[5].length = SESSION_STAGE_SIZE + 4; s[5].data = s[1].data; (void)n; }
+static void Big_Flash(ManifestStep *s, int *n) { s[3].length = AREA + 4; s[3].data = s[1].data; (void)n; }
+static void Empty_Sram(ManifestStep *s, int *n) { s[1].length = 0; (void)n; }
+static void Idcode_Data(ManifestStep *s, int *n) { s[0].length = 4; s[0].data = s[1].data; (void)n; }
+static void Unknown(ManifestStep *s, int *n) { s[0].kind = 7; (void)n; }
+
+static void Test_Rules(const uint8_t *bits, const uint8_t *exe, size_t exeLen) {
+    ManifestStep s[MANIFEST_MAX_STEPS], p[MANIFEST_MAX_STEPS];
+    uint8_t *m, *bad;
+    int n;
+    size_t len;
+
+    CHECK(Takes(bits, exe, exeLen, Same));
+    CHECK(!Takes(bits, exe, exeLen, Verify_First));
+    CHECK(!Takes(bits, exe, exeLen, Verify_After_Load));
+    CHECK(!Takes(bits, exe, exeLen, Start_Not_Last));
+    CHECK(!Takes(bits, exe, exeLen, Start_Unloaded));
+    CHECK(!Takes(bits, exe, exeLen, Start_Bad_Arg));
+    CHECK(!Takes(bits, exe, exeLen, Two_Loads));
+    CHECK(!Takes(bits, exe, exeLen, Odd_Load));
+    CHECK(!Takes(bits, exe, exeLen, Big_Load));
+    CHECK(!Takes(bits, exe, exeLen, Big_Flash));
+    CHECK(!Takes(bits, exe, exeLen, Empty_Sram));
+    CHECK(!Takes(bits, exe, exeLen, Idcode_Data));
+    CHECK(!Takes(bits, exe, exeLen, Unknown));
+
+    // Header damage: magic, table CRC, step count, data length
+    n = Full(s, bits, exe, exeLen);
+    len = Make(s, n, &m);
+    bad = malloc(len);
+    memcpy(bad, m, len); bad[0] ^= 1;
+    CHECK_EQ(Manifest_Parse(bad, len, SESSION_STAGE_SIZE, AREA, p), 0);
+    memcpy(bad, m, len); bad[16 + 2 * 16 + 8] ^= 1;           // The verify step's value
+    CHECK_EQ(Manifest_Parse(bad, len, SESSION_STAGE_SIZE, AREA, p), 0);
+    memcpy(bad, m, len); bad[4] = 9;
+    CHECK_EQ(Manifest_Parse(bad, len, SESSION_STAGE_SIZE, AREA, p), 0);
+    memcpy(bad, m, len); bad[4] = 0;
+    CHECK_EQ(Manifest_Parse(bad, len, SESSION_STAGE_SIZE, AREA, p), 0);
+    memcpy(bad, m, len); bad[8] ^= 4;
+    CHECK_EQ(Manifest_Parse(bad, len, SESSION_STAGE_SIZE, AREA, p), 0);
+    // A smaller stage or cache than the host built for
+    CHECK_EQ(Manifest_Parse(m, len, (uint32_t)exeLen - 4, AREA, p), 0);
+    CHECK_EQ(Manifest_Parse(m, len, SESSION_STAGE_SIZE, (uint32_t)imageLen - 4, p), 0);
+    free(bad);
+    free(m);
+}
+
+static void Test_Run(const uint8_t *bits, const uint8_t *exe, size_t exeLen) {
+    ManifestStep s[MANIFEST_MAX_STEPS];
+    McuManifestReport r;
+    uint8_t *m;
+    int n = Full(s, bits, exe, exeLen), i;
+    size_t len = Make(s, n, &m);
+
+    CHECK_EQ(Run(m, len, &r), MF_DONE);
+    CHECK_EQ(r.steps, 7);
+    CHECK_EQ(r.step, 7);
+    CHECK_EQ(r.idcode, ID);
+    CHECK_EQ(r.bytes, SLICE);
+    CHECK(Configured());
+    CHECK(r.status & 0x2000u);                                  // DONE
+    CHECK_EQ(r.flashed, imageLen);
+    CHECK(memcmp(cache, image, imageLen) == 0);
+    CHECK(Blank(cache + imageLen, AREA - imageLen));
+    CHECK_EQ(r.erased, (imageLen + MCU_FLASH_PAGE - 1) / MCU_FLASH_PAGE);
+    CHECK_EQ(BootCache_Decide(cache, AREA, 0), BOOT_LOAD);
+    CHECK_EQ(r.staged, exeLen);
+    CHECK(memcmp(stage, exe, exeLen) == 0);
+    CHECK_EQ(r.start, RVDBG_LOADED);
+    CHECK(HalTarget_Debug() != NULL);
+    if (HalTarget_Debug()) {
+        CHECK(memcmp(HalTarget_Debug()->mem, exe + 12, exeLen - 12) == 0);
+        CHECK_EQ(HalTarget_Debug()->resumes, 1);
+    }
+    // The flash steps clock nothing; the SRAM load is most of the run
+    CHECK_EQ(r.stepTck[3] + r.stepTck[4] + r.stepTck[5], 0);
+    CHECK(r.stepTck[1] > (uint64_t)SLICE * 8);
+    for (i = 0; i < 7; i++) CHECK(r.stepTck[i] <= r.tck);
+
+    // Over an old image and old firmware: the pages they reach are erased first
+    memset(cache, 0, sizeof(cache));
+    memset(stage, 0, sizeof(stage));
+    HalTarget_Init(1);
+    HalTarget_UseDebug(1);
+    CHECK_EQ(McuManifest_Run(m, len, cache, AREA, stage, SESSION_STAGE_SIZE, &r), MF_DONE);
+    CHECK(memcmp(cache, image, imageLen) == 0);
+    CHECK(memcmp(stage, exe, exeLen) == 0);
+    free(m);
+}
+
+static void Test_Failures(const uint8_t *bits, const uint8_t *exe, size_t exeLen) {
+    ManifestStep s[MANIFEST_MAX_STEPS];
+    McuManifestReport r;
+    uint8_t *m;
+    int n;
+    size_t len, data = MANIFEST_HEADER_SIZE + 7 * MANIFEST_STEP_SIZE;
+
+    // Another part on the pins: nothing shifted, written or staged
+    n = Full(s, bits, exe, exeLen);
+    s[0].value = 0x0100481Bu;
+    len = Make(s, n, &m);
+    CHECK_EQ(Run(m, len, &r), MF_WRONG_IDCODE);
+    CHECK_EQ(r.step, 1);
+    CHECK_EQ(r.idcode, ID);
+    CHECK_EQ(r.bytes, 0);
+    CHECK(!Configured());
+    CHECK(Blank(cache, AREA));
+    CHECK(Blank(stage, SESSION_STAGE_SIZE));
+    CHECK_EQ(r.start, RVDBG_SKIPPED);
+    free(m);
+
+    // Under a mask that leaves the revision out it is the same part
+    s[0].mask = 0x0FFFFFFFu;
+    len = Make(s, n, &m);
+    CHECK_EQ(Run(m, len, &r), MF_DONE);
+    free(m);
+    // No fifth device in a one-TAP chain
+    s[0].value = ID; s[0].mask = 0xFFFFFFFFu; s[0].arg = 5;
+    len = Make(s, n, &m);
+    CHECK_EQ(Run(m, len, &r), MF_NO_DEVICE);
+    free(m);
+
+    // Firmware that does not match its CRC stays in the stage, not run
+    n = Full(s, bits, exe, exeLen);
+    s[5].value ^= 1;
+    len = Make(s, n, &m);
+    CHECK_EQ(Run(m, len, &r), MF_BAD_FIRMWARE);
+    CHECK_EQ(r.step, 6);
+    CHECK(Configured());
+    CHECK_EQ(r.start, RVDBG_SKIPPED);
+    CHECK(HalTarget_Debug() == NULL);
+    free(m);
+
+    // Cut inside the bitstream, then inside the boot image
+    n = Full(s, bits, exe, exeLen);
+    len = Make(s, n, &m);
+    CHECK_EQ(Run(m, data + 1000, &r), MF_SHORT_DATA);    // Short of the TAP's minimum stream
+    CHECK_EQ(r.step, 2);
+    CHECK_EQ(r.bytes, 1001);
+    CHECK(!Configured());
+    CHECK_EQ(Run(m, data + SLICE + 1000, &r), MF_SHORT_DATA);
+    CHECK_EQ(r.step, 4);
+    CHECK_EQ(r.flashed, 1000);
+    // The table itself cut short is no manifest at all
+    CHECK_EQ(Run(m, data - 1, &r), MF_BAD_MANIFEST);
+    CHECK_EQ(r.step, 0);
+
+    // A boot image damaged on the way fails its CRC in flash
+    m[data + SLICE + BOOT_HEADER_SIZE + 100] ^= 0x10;
+    CHECK_EQ(Run(m, len, &r), MF_VERIFY_FAIL);
+    CHECK_EQ(r.step, 5);
+    CHECK_EQ(BootCache_Decide(cache, AREA, 0), BOOT_BAD_CRC);
+    free(m);
+
+    // A status bit the load did not set
+    n = Full(s, bits, exe, exeLen);
+    s[2].value = 0x80000000u;
+    s[2].mask = 0x80000000u;
+    len = Make(s, n, &m);
+    CHECK_EQ(Run(m, len, &r), MF_VERIFY_FAIL);
+    CHECK_EQ(r.step, 3);
+    CHECK_EQ(r.flashed, 0);
+    free(m);
+}
+
+int main(void) {
+    size_t len = 0, exeLen = 0;
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &len);
+    uint8_t *exe = HostFile_Load("../JTAG_Programmer_Serial/hello.exe", &exeLen);
+    CHECK(bits != NULL && len >= SLICE);
+    CHECK(exe != NULL);
+    if (!bits || len < SLICE || !exe) return CHECK_DONE();
+    imageLen = BootCache_Build(bits, SLICE, image, sizeof(image));
+    CHECK_EQ(imageLen, BOOT_HEADER_SIZE + SLICE);
+
+    Test_Format(bits, exe, exeLen);
+    Test_Rules(bits, exe, exeLen);
+    Test_Run(bits, exe, exeLen);
+    Test_Failures(bits, exe, exeLen);
+    free(bits);
+    free(exe);
+    return CHECK_DONE();
+}
@@ -0,0 +1,216 @@
+/*
+ * NEORV32 bootloader driver: hello.exe's header, then the upload against
+ * the bootloader stand-in, in memory and on a pty
+ */
+
+#include "check.h"
+#include "host_file.h"
+#include "neorv32_boot.h"
+#include "neorv32_bootloader.h"
+#include "pty_link.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// --- IN MEMORY: replies queue up as the bootloader makes them ---
+typedef struct {
+    Neorv32Bl     bl;
+    const uint8_t *host;
+    size_t        hostLen, hostOff;
+    char          reply[4096];
+    size_t        head, tail;
+    int           banner;
+} MemLink;
+
+static size_t Mem_HostRead(void *c, uint8_t *buf, size_t max, int timeoutMs) {
+    MemLink *m = c;
+    size_t n = m->hostLen - m->hostOff < max ? m->hostLen - m->hostOff : max;
+    (void)timeoutMs;
+    memcpy(buf, m->host + m->hostOff, n);
+    m->hostOff += n;
+    return n;
+}
+
+static int Mem_TargetRead(void *c, uint8_t *b, int timeoutMs) {
+    MemLink *m = c;
+    (void)timeoutMs;
+    if (m->head == m->tail) return 0;
+    *b = (uint8_t)m->reply[m->head++];
+    return 1;
+}
+
+static void Mem_TargetWrite(void *c, const uint8_t *buf, size_t n) {
+    MemLink *m = c;
+    size_t i;
+    if (m->head == m->tail) m->head = m->tail = 0;
+    for (i = 0; i < n; i++) m->tail += Neorv32Bl_Rx(&m->bl, buf[i], m->reply + m->tail, sizeof(m->reply) - m->tail);
+}
+
+static Neorv32Result Mem_Upload(const uint8_t *exe, size_t len, int atPrompt, int mute, Neorv32Report *r, MemLink *m) {
+    Neorv32Link l = { Mem_HostRead, Mem_TargetRead, Mem_TargetWrite, NULL, m };
+    memset(m, 0, sizeof(*m));
+    Neorv32Bl_Init(&m->bl, atPrompt);
+    m->bl.mute = mute;
+    m->host = exe;
+    m->hostLen = len;
+    m->tail = Neorv32Bl_PowerUp(&m->bl, m->reply, sizeof(m->reply));
+    return Neorv32_Upload(&l, r);
+}
+
+static void Test_Header(const uint8_t *exe, size_t len) {
+    Neorv32Header h;
+    Neorv32Sum s = { 0, 0, 0 };
+    size_t i;
+
+    CHECK_EQ(len, 8636);
+    Neorv32_ParseHeader(exe, &h);
+    CHECK_EQ(h.signature, NEORV32_SIGNATURE);
+    CHECK_EQ(h.size, 0x21B0);
+    CHECK_EQ(h.checksum, 0xA72475DAu);
+    CHECK_EQ(NEORV32_HEADER_SIZE + h.size, len);
+    CHECK_EQ(Neorv32_Check(&h), NEORV32_BOOTED);
+    for (i = NEORV32_HEADER_SIZE; i < len; i++) Neorv32Sum_Add(&s, exe[i]);
+    CHECK(Neorv32Sum_Ok(&s, &h));
+
+    h.size = 6;
+    CHECK_EQ(Neorv32_Check(&h), NEORV32_BAD_SIZE);
+    h.size = 0;
+    CHECK_EQ(Neorv32_Check(&h), NEORV32_BAD_SIZE);
+    h.signature = 0;
+    CHECK_EQ(Neorv32_Check(&h), NEORV32_BAD_SIGNATURE);
+}
+
+static void Test_Match(void) {
+    static const char text[] = "CMD:CMD:> x";
+    Neorv32Match m = { 0 };
+    int hits = 0, at = -1;
+    for (int i = 0; text[i]; i++) if (Neorv32Match_Feed(&m, NEORV32_PROMPT, (uint8_t)text[i])) { hits++; at = i; }
+    CHECK_EQ(hits, 1);
+    CHECK_EQ(at, 9);
+    CHECK(!Neorv32Match_Feed(&m, "", 'x'));
+}
+
+static void Test_In_Memory(const uint8_t *exe, size_t len) {
+    static MemLink m;
+    Neorv32Report r;
+    uint8_t *bad = malloc(len);
+
+    // From the countdown and from a prompt that is already up
+    CHECK_EQ(Mem_Upload(exe, len, 0, 0, &r, &m), NEORV32_BOOTED);
+    CHECK_EQ(m.bl.state, BL_RUNNING);
+    CHECK_EQ(memcmp(m.bl.image, exe + NEORV32_HEADER_SIZE, len - NEORV32_HEADER_SIZE), 0);
+    CHECK_EQ(r.bytes, len);
+    CHECK_EQ(r.hTries, 1);
+    CHECK_EQ(Mem_Upload(exe, len, 1, 0, &r, &m), NEORV32_BOOTED);
+    CHECK_EQ(m.bl.keys, 3);   // h, u, e
+
+    // One flipped image bit: the bootloader refuses it and nothing is started
+    memcpy(bad, exe, len);
+    bad[100] ^= 0x10;
+    CHECK_EQ(Mem_Upload(bad, len, 0, 0, &r, &m), NEORV32_BAD_CHECKSUM);
+    CHECK_EQ(m.bl.errors, 1);
+    CHECK(m.bl.state != BL_RUNNING);
+
+    // Bad header: the bootloader never hears a key
+    memcpy(bad, exe, len);
+    bad[0] = 0;
+    CHECK_EQ(Mem_Upload(bad, len, 0, 0, &r, &m), NEORV32_BAD_SIGNATURE);
+    CHECK_EQ(m.bl.state, BL_AUTOBOOT);
+    CHECK_EQ(r.bytes, 0);
+
+    // Host stops inside the header, and early
+    CHECK_EQ(Mem_Upload(exe, NEORV32_HEADER_SIZE - 5, 0, 0, &r, &m), NEORV32_SHORT_IMAGE);
+    CHECK_EQ(m.bl.state, BL_AUTOBOOT);
+    CHECK_EQ(r.bytes, 0);
+    CHECK_EQ(Mem_Upload(exe, len - 100, 0, 0, &r, &m), NEORV32_SHORT_IMAGE);
+    CHECK_EQ(r.bytes, len - 100);
+
+    // Nothing answers
+    CHECK_EQ(Mem_Upload(exe, len, 0, 1, &r, &m), NEORV32_NO_PROMPT);
+    CHECK_EQ(r.hTries, NEORV32_TRIES);
+    free(bad);
+}
+
+// --- OVER PTYS: bootloader and uploader are processes of their own ---
+typedef struct { int host, target; } FdLink;
+
+static size_t Fd_HostRead(void *c, uint8_t *buf, size_t max, int timeoutMs) {
+    struct pollfd p = { ((FdLink *)c)->host, POLLIN, 0 };
+    ssize_t n;
+    if (poll(&p, 1, timeoutMs) <= 0) return 0;
+    n = read(p.fd, buf, max);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static int Fd_TargetRead(void *c, uint8_t *b, int timeoutMs) {
+    struct pollfd p = { ((FdLink *)c)->target, POLLIN, 0 };
+    if (poll(&p, 1, timeoutMs) <= 0) return 0;
+    return read(p.fd, b, 1) == 1;
+}
+
+static void Fd_TargetWrite(void *c, const uint8_t *buf, size_t n) {
+    int fd = ((FdLink *)c)->target;
+    while (n) {
+        ssize_t w = write(fd, buf, n);
+        if (w > 0) { buf += w; n -= (size_t)w; }
+        else { struct pollfd p = { fd, POLLOUT, 0 }; poll(&p, 1, 100); }
+    }
+}
+
+static void Test_Over_Ptys(const uint8_t *exe, size_t len) {
+    PtyLink u2, u1;
+    FdLink fds;
+    Neorv32Report r;
+    Neorv32Link l = { Fd_HostRead, Fd_TargetRead, Fd_TargetWrite, NULL, &fds };
+    Neorv32Bl *bl = mmap(NULL, sizeof(Neorv32Bl), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pid_t host, boot;
+    int status;
+
+    CHECK(bl != MAP_FAILED);
+    CHECK_EQ(PtyLink_Open(&u2), 0);
+    CHECK_EQ(PtyLink_Open(&u1), 0);
+    if ((boot = fork()) == 0) {
+        int fd = PtyLink_OpenPort(u1.path);
+        Neorv32Bl_Init(bl, 0);
+        Neorv32Bl_Serve(bl, fd, 20, 2000);   // FPGA still booting for 20 ms
+        _exit(0);
+    }
+    if ((host = fork()) == 0) {
+        int fd = PtyLink_OpenPort(u2.path);
+        _exit(PtyLink_WriteAll(fd, exe, len) < 0);
+    }
+    fds.host = u2.master;
+    fds.target = u1.master;
+    CHECK_EQ(Neorv32_Upload(&l, &r), NEORV32_BOOTED);
+    waitpid(host, &status, 0);
+    waitpid(boot, &status, 0);
+
+    CHECK_EQ(bl->state, BL_RUNNING);
+    CHECK_EQ(bl->errors, 0);
+    CHECK_EQ(memcmp(bl->image, exe + NEORV32_HEADER_SIZE, len - NEORV32_HEADER_SIZE), 0);
+    // The old bridge slept 2 x 100 ms before 'u' and idled out after the image
+    CHECK(r.handshakeUs < 200000.0);
+    CHECK(r.bootUs < NEORV32_REPLY_MS * 1000.0);
+    PtyLink_Close(&u2);
+    PtyLink_Close(&u1);
+    munmap(bl, sizeof(Neorv32Bl));
+}
+
+int main(void) {
+    size_t len = 0;
+    uint8_t *exe = HostFile_Load("../JTAG_Programmer_Serial/hello.exe", &len);
+    CHECK(exe != NULL);
+    Test_Match();
+    if (exe) {
+        Test_Header(exe, len);
+        Test_In_Memory(exe, len);
+        Test_Over_Ptys(exe, len);
+    }
+    free(exe);
+    return CHECK_DONE();
+}
@@ -0,0 +1,121 @@
+/*
+ * Host -> MCU -> FPGA pipeline: the incremental pump shifts exactly what
+ * the one-shot stream does, and both sessions survive the trip over ptys
+ */
+
+#include "check.h"
+#include "gowin_tap.h"
+#include "host_file.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+#include "pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static void Test_Ring_Wrap(void) {
+    McuRing r;
+    uint32_t room, avail;
+    uint8_t *dst;
+    McuRing_Init(&r, 16);
+
+    dst = McuRing_WriteSpan(&r, &room);
+    CHECK_EQ(room, 15);                 // One short of a lap
+    dst[0] = 1;
+    McuRing_Commit(&r, 12);
+    McuRing_Consume(&r, 12);
+    dst = McuRing_WriteSpan(&r, &room);
+    CHECK_EQ(room, 4);                  // Up to the end of the buffer
+    McuRing_Commit(&r, 4);
+    dst = McuRing_WriteSpan(&r, &room);
+    CHECK(dst == r.buf);
+    CHECK_EQ(room, 11);
+    McuRing_Commit(&r, 3);
+    McuRing_ReadSpan(&r, &avail);
+    CHECK_EQ(avail, 4);
+    CHECK_EQ(McuRing_Level(&r), 7);
+    CHECK_EQ(r.mon.produced, 19);
+    CHECK_EQ(r.mon.overruns, 0);
+    CHECK_EQ(r.mon.highWater, 12);
+    McuRing_Free(&r);
+}
+
+static void Test_Pump_Matches_Stream(const uint8_t *bits, size_t len) {
+    GowinTap a, b;
+    JtagMaster ma, mb;
+    McuRing r;
+    McuPump p;
+    size_t off = 0, step = 1;
+
+    GowinTap_Init(&a);
+    Jtag_Init(&ma, GowinTap_ClockFn, &a);
+    Jtag_ResetTap(&ma);
+    Jtag_InitConfiguration(&ma);
+    Jtag_StreamBitstream(&ma, bits, len);
+    Jtag_FinishConfiguration(&ma);
+
+    // Same session fed through a 512-byte ring in uneven pieces
+    GowinTap_Init(&b);
+    Jtag_Init(&mb, GowinTap_ClockFn, &b);
+    Jtag_ResetTap(&mb);
+    Jtag_InitConfiguration(&mb);
+    McuRing_Init(&r, 512);
+    McuPump_Begin(&p, &r, &mb);
+    while (off < len) {
+        uint32_t room;
+        uint8_t *dst = McuRing_WriteSpan(&r, &room);
+        size_t n = step < room ? step : room;
+        if (n > len - off) n = len - off;
+        for (size_t i = 0; i < n; i++) dst[i] = bits[off + i];
+        McuRing_Commit(&r, (uint32_t)n);
+        off += n;
+        McuPump_Drain(&p);
+        CHECK_EQ(McuRing_Level(&r), 1);
+        step = step * 7 % 1021 + 1;
+    }
+    McuPump_Finish(&p);
+
+    CHECK_EQ(p.sent, len);
+    CHECK_EQ(mb.tckCount, ma.tckCount);
+    CHECK_EQ(b.diagStreamBits, a.diagStreamBits);
+    CHECK_EQ(b.diagStreamBits, len * 8);
+    CHECK_EQ(b.leds, a.leds);
+    CHECK(b.leds & LED_PROG_5);
+    CHECK_EQ(r.mon.overruns, 0);
+    McuRing_Free(&r);
+}
+
+static void Test_Over_Ptys(const uint8_t *bits, size_t bitsLen, const uint8_t *fw, size_t fwLen) {
+    PipeConfig c = { PIPE_BITSTREAM, bits, bitsLen, 4096, 1000, 0, 10, 0 };
+    PipeResult r;
+
+    CHECK_EQ(Pipeline_Run(&c, &r), 0);
+    CHECK(r.pass);
+    CHECK_EQ(r.streamBits, bitsLen * 8);
+    CHECK_EQ(r.ring.overruns, 0);
+    CHECK_EQ(r.stage[STAGE_HOST_TO_RING].n, (bitsLen + PIPE_LAT_CHUNK - 1) / PIPE_LAT_CHUNK);
+    CHECK(r.tailMs >= 10.0);
+    CHECK(r.cpuTargetS > 0 && r.cpuTargetS <= r.cpuMcuS + 0.01);
+
+    c.mode = PIPE_FIRMWARE; c.data = fw; c.len = fwLen; c.handshakeMs = 1;
+    CHECK_EQ(Pipeline_Run(&c, &r), 0);
+    CHECK(r.pass);
+    // Prompt-driven: as long as the banner takes, not a fixed delay per key
+    CHECK(r.handshakeMs >= 1.0 && r.handshakeMs < 200.0);
+    CHECK_EQ(r.stage[STAGE_OUT_TO_TARGET].n, (fwLen + PIPE_LAT_CHUNK - 1) / PIPE_LAT_CHUNK);
+    CHECK(r.stage[STAGE_END_TO_END].min >= r.stage[STAGE_OUT_TO_TARGET].min);
+}
+
+int main(void) {
+    size_t bitsLen = 0, fwLen = 0;
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &bitsLen);
+    uint8_t *fw = HostFile_Load("../JTAG_Programmer_Serial/hello.exe", &fwLen);
+    CHECK(bits != NULL && fw != NULL);
+    Test_Ring_Wrap();
+    if (bits && fw) {
+        Test_Pump_Matches_Stream(bits, bitsLen);
+        Test_Over_Ptys(bits, bitsLen, fw, fwLen);
+    }
+    free(bits); free(fw);
+    return CHECK_DONE();
+}
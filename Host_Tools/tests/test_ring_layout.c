@@ -0,0 +1,123 @@
+/*
+ * Ring pool layout: the split ring_layout.ads makes and the alire.toml reader
+ */
+
+#include "check.h"
+#include "ring_layout.h"
+
+#include <stdio.h>
+
+static RingLayout Layout(uint32_t ram, uint32_t reserved, uint32_t window) {
+    RingConfig c = { ram, reserved, window };
+    RingLayout l;
+    CHECK_EQ(RingLayout_Compute(&c, &l), 0);
+    return l;
+}
+
+static void Test_Default_Split(void) {
+    RingLayout l = Layout(16384, 8192, 0);
+    CHECK_EQ(l.poolSize, 8192);
+    CHECK_EQ(l.usart2Size, 4096);
+    CHECK_EQ(l.usart1Size, 4096);
+    CHECK_EQ(l.usart1Offset, 4096);
+    CHECK_EQ(l.poolUsed, 8192);
+}
+
+static void Test_Window_And_Leftovers(void) {
+    RingLayout l = Layout(16384, 8192, 2048);
+    CHECK_EQ(l.usart2Size, 4096);
+    CHECK_EQ(l.usart1Size, 2048);
+    CHECK_EQ(l.windowOffset, 6144);
+    CHECK_EQ(l.poolUsed, 8192);
+
+    // Odd pool: USART2 takes the biggest power of two, USART1 what fits
+    l = Layout(16384, 5000, 0);
+    CHECK_EQ(l.usart2Size, 8192);
+    CHECK_EQ(l.usart1Size, 2048);
+    CHECK(l.poolUsed <= l.poolSize);
+
+    // USART1 is never bigger than USART2
+    l = Layout(65536, 1024, 0);
+    CHECK_EQ(l.usart2Size, 32768);
+    CHECK_EQ(l.usart1Size, 16384);
+
+    // Smallest pool that builds
+    l = Layout(4096, 3584, 0);
+    CHECK_EQ(l.usart2Size, 256);
+    CHECK_EQ(l.usart1Size, 256);
+}
+
+static void Test_Every_Layout_Fits(void) {
+    uint32_t reserved, window;
+    for (reserved = 1024; reserved <= 16384; reserved += 96) {
+        for (window = 0; window <= 4096; window += 512) {
+            RingConfig c = { 16384, reserved, window };
+            RingLayout l;
+            if (RingLayout_Compute(&c, &l) < 0) {
+                CHECK(16384 - reserved < window + 2 * RING_MIN);
+                continue;
+            }
+            CHECK(l.poolUsed <= l.poolSize);
+            CHECK((l.usart2Size & (l.usart2Size - 1)) == 0);
+            CHECK((l.usart1Size & (l.usart1Size - 1)) == 0);
+            CHECK(l.usart1Size <= l.usart2Size);
+            CHECK(l.usart1Size >= RING_MIN);
+            // Doubling USART2 would no longer leave room for USART1
+            CHECK(l.usart2Size == RING_MAX || 2 * l.usart2Size + RING_MIN + window > l.poolSize);
+        }
+    }
+}
+
+static void Test_Too_Small(void) {
+    RingConfig c = { 16384, 15000, 1024 };
+    RingLayout l;
+    CHECK_EQ(RingLayout_Compute(&c, &l), -1);
+}
+
+static void Test_Toml(void) {
+    FILE *f = tmpfile();
+    RingConfig c;
+    fputs("name = \"jtag_test\"\n"
+          "[configuration.variables]\n"
+          "Ram_Size     = { type = \"Integer\", first = 4096, last = 65536, default = 16384 }\n"
+          "Ram_Reserved = { type = \"Integer\", first = 1024, last = 65536, default = 6144 }\n"
+          "Window_Size  = { type = \"Integer\", first = 0,    last = 32768, default = 0 }\n"
+          "[configuration.values]\n"
+          "light_tasking_stm32f0xx.PLLMUL     = 12\n"
+          "jtag_test.Window_Size = 1024 # decompression\n", f);
+    rewind(f);
+    RingConfig_Defaults(&c);
+    CHECK_EQ(RingConfig_ParseToml(&c, f), 4);
+    fclose(f);
+    CHECK_EQ(c.ramSize, 16384);
+    CHECK_EQ(c.ramReserved, 6144);
+    CHECK_EQ(c.windowSize, 1024);
+
+    CHECK_EQ(RingConfig_Set(&c, "PLLMUL", "12"), 0);
+    CHECK_EQ(RingConfig_Set(&c, "Ram_Size", "lots"), -1);
+    CHECK_EQ(RingConfig_Set(&c, "Ram_Size", "0x8000"), 1);
+    CHECK_EQ(c.ramSize, 32768);
+}
+
+static void Test_Repo_Toml(void) {
+    FILE *f = fopen("../JTAG_Programmer_Cmd_Call/alire.toml", "r");
+    RingConfig c; RingLayout l;
+    CHECK(f != NULL);
+    if (!f) return;
+    RingConfig_Defaults(&c);
+    c.ramSize = c.ramReserved = 0;
+    CHECK_EQ(RingConfig_ParseToml(&c, f), 3);
+    fclose(f);
+    CHECK_EQ(RingLayout_Compute(&c, &l), 0);
+    CHECK_EQ(l.usart2Size, 4096);
+}
+
+int main(void) {
+    Test_Default_Split();
+    Test_Window_And_Leftovers();
+    Test_Every_Layout_Fits();
+    Test_Too_Small();
+    Test_Toml();
+    Test_Repo_Toml();
+    return CHECK_DONE();
+}
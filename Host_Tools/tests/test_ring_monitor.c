@@ -0,0 +1,176 @@
+/*
+ * DMA ring monitor: lap detection against the circular channel model and
+ * producer/consumer runs with known losses
+ */
+
+#include "check.h"
+#include "dma_ring.h"
+#include "ring_monitor.h"
+
+static void Write_N(DmaRing *d, uint32_t n) { while (n--) DmaRing_Write(d); }
+
+static void Test_Channel_Flags(void) {
+    DmaRing d;
+    DmaRing_Init(&d, 512);
+    Write_N(&d, 255);
+    CHECK_EQ(d.htif, 0);
+    DmaRing_Write(&d);
+    CHECK_EQ(d.htif, 1);
+    CHECK_EQ(DmaRing_WriteIndex(&d), 256);
+    Write_N(&d, 256);
+    CHECK_EQ(d.tcif, 1);
+    CHECK_EQ(DmaRing_WriteIndex(&d), 0);
+    CHECK_EQ(d.ndt, 512);
+    DmaRing_Free(&d);
+}
+
+static void Test_No_Lap(void) {
+    DmaRing d; RingMonitor m;
+    DmaRing_Init(&d, 512);
+    RingMonitor_Reset(&m, 512, 0, 0);
+
+    // Small steps across both boundaries, drained every time
+    for (int i = 0; i < 40; i++) {
+        Write_N(&d, 100);
+        DmaRing_Poll(&d, &m);
+        RingMonitor_Consume(&m, 100);
+    }
+    CHECK_EQ(m.produced, 4000);
+    CHECK_EQ(m.overruns, 0);
+    CHECK_EQ(m.lost, 0);
+    CHECK_EQ(m.highWater, 100);
+    CHECK_EQ(RingMonitor_Level(&m), 0);
+
+    // Backlog builds up without laps
+    Write_N(&d, 300); DmaRing_Poll(&d, &m);
+    Write_N(&d, 200); DmaRing_Poll(&d, &m);
+    CHECK_EQ(m.highWater, 500);
+    CHECK_EQ(m.overruns, 0);
+    DmaRing_Free(&d);
+}
+
+static void Test_Exact_Lap(void) {
+    DmaRing d; RingMonitor m;
+    DmaRing_Init(&d, 512);
+    RingMonitor_Reset(&m, 512, 0, 0);
+    Write_N(&d, 10); DmaRing_Poll(&d, &m); RingMonitor_Consume(&m, 10);
+
+    // The index does not move at all, only the flags tell
+    Write_N(&d, 512);
+    CHECK_EQ(DmaRing_Poll(&d, &m), 10);
+    CHECK_EQ(m.produced, 522);
+    CHECK_EQ(m.overruns, 1);
+    CHECK_EQ(m.lost, 512);
+    CHECK_EQ(m.highWater, 512);
+    CHECK_EQ(RingMonitor_Level(&m), 0);
+
+    // Lap plus a little: the consumer still sees the little
+    Write_N(&d, 512 + 40);
+    DmaRing_Poll(&d, &m);
+    CHECK_EQ(m.overruns, 2);
+    CHECK_EQ(m.lost, 1024);
+    CHECK_EQ(RingMonitor_Level(&m), 40);
+    DmaRing_Free(&d);
+}
+
+static void Test_Flag_After_Index(void) {
+    DmaRing d; RingMonitor m;
+    int half, full;
+    uint32_t w;
+    DmaRing_Init(&d, 512);
+    RingMonitor_Reset(&m, 512, 0, 0);
+    Write_N(&d, 250);
+    DmaRing_Poll(&d, &m); RingMonitor_Consume(&m, 250);
+
+    // Flags sampled, then the DMA crosses the middle before CNDTR is read
+    half = d.htif; full = d.tcif;
+    d.htif = d.tcif = 0;
+    Write_N(&d, 10);
+    w = DmaRing_WriteIndex(&d);
+    RingMonitor_Produce(&m, w, half, full);
+    CHECK_EQ(m.pendingHalf, 1);
+    RingMonitor_Consume(&m, 10);
+
+    // The late flag on the next poll is not a lap
+    Write_N(&d, 5);
+    DmaRing_Poll(&d, &m);
+    CHECK_EQ(m.overruns, 0);
+    CHECK_EQ(m.produced, 265);
+    CHECK_EQ(m.pendingHalf, 0);
+    DmaRing_Free(&d);
+}
+
+static void Test_Reset_Mid_Ring(void) {
+    RingMonitor m;
+    RingMonitor_Reset(&m, 512, 500, 20);   // 32 unread bytes across the wrap
+    CHECK_EQ(RingMonitor_Level(&m), 32);
+    CHECK_EQ(m.highWater, 32);
+}
+
+static RingScenario Pump(uint32_t ring, uint32_t baud) {
+    RingScenario s = { ring, baud, 60000, 300, 700, 0, 0 };
+    return s;
+}
+
+static void Test_Sim_Fast_Consumer(void) {
+    RingScenario s = Pump(512, 115200);
+    RingResult r;
+    RingSim_Run(&s, &r);
+    CHECK_EQ(r.drained, 60000);
+    CHECK_EQ(r.trueLost, 0);
+    CHECK_EQ(r.mon.produced, 60000);
+    CHECK_EQ(r.mon.overruns, 0);
+    CHECK(r.mon.highWater <= 2);
+}
+
+static void Test_Sim_Stalls(void) {
+    RingScenario s = Pump(512, 921600);
+    RingResult r;
+
+    // 2 ms stalls at 92 kB/s: 184 bytes pile up, no loss
+    s.stallEvery = 4096; s.stallNs = 2000000;
+    RingSim_Run(&s, &r);
+    CHECK_EQ(r.trueLost, 0);
+    CHECK_EQ(r.mon.overruns, 0);
+    CHECK(r.mon.highWater >= 184 && r.mon.highWater < 200);
+
+    // 7 ms stalls: 645 bytes, more than one lap of a 512-byte ring
+    s.stallNs = 7000000;
+    RingSim_Run(&s, &r);
+    CHECK(r.trueLost > 0);
+    CHECK_EQ(r.mon.lost, r.trueLost);
+    CHECK_EQ(r.mon.produced, 60000);
+    CHECK_EQ(r.drained + r.trueLost, 60000);
+    CHECK(r.mon.overruns > 0);
+    CHECK_EQ(r.mon.highWater, 512);
+
+    // The same stalls fit a 1024-byte ring
+    s.ringSize = 1024;
+    RingSim_Run(&s, &r);
+    CHECK_EQ(r.trueLost, 0);
+    CHECK_EQ(r.mon.overruns, 0);
+}
+
+static void Test_Sim_Slow_Consumer(void) {
+    // Drain slower than the wire: the ring overruns again and again
+    RingScenario s = Pump(512, 2000000);
+    RingResult r;
+    s.drainNs = 6000;
+    RingSim_Run(&s, &r);
+    CHECK(r.trueLost > 0);
+    CHECK(r.mon.overruns > 1);
+    CHECK(r.mon.lost <= r.trueLost);
+    CHECK_EQ(r.drained + r.trueLost, 60000);
+}
+
+int main(void) {
+    Test_Channel_Flags();
+    Test_No_Lap();
+    Test_Exact_Lap();
+    Test_Flag_After_Index();
+    Test_Reset_Mid_Ring();
+    Test_Sim_Fast_Consumer();
+    Test_Sim_Stalls();
+    Test_Sim_Slow_Consumer();
+    return CHECK_DONE();
+}
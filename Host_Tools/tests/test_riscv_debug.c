@@ -0,0 +1,154 @@
+/*
+ * RISC-V debug loader: hello.exe written into the debug module model's
+ * IMEM and started, a DM that answers busy, a DM without system bus
+ * access, a bad header, a write past IMEM, and the handover of the
+ * programmer's pins after configuration in the host HAL target
+ */
+
+#include "check.h"
+#include "hal_target.h"
+#include "host_file.h"
+#include "jtag_master.h"
+#include "riscv_debug.h"
+#include "riscv_dm.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static RvDm dm;
+
+static int Image_Matches(const RvDm *d, const uint8_t *exe, size_t len) {
+    return memcmp(d->mem, exe + 12, len - 12) == 0;   // Little-endian host
+}
+
+static void Test_Load(const uint8_t *exe, size_t len) {
+    JtagMaster m;
+    RvDebug d;
+    RvDebugReport r;
+    uint32_t words = (uint32_t)(len - 12) / 4;
+
+    RvDm_Init(&dm, 1, 0);
+    dm.dpc = 0x1234;
+    Jtag_Init(&m, RvDm_ClockFn, &dm);
+    RvDebug_Init(&d, &m);
+    CHECK_EQ(RvDebug_Load(&d, exe, len, &r), RVDBG_LOADED);
+    CHECK_EQ(r.bytes, len - 12);
+    CHECK_EQ(dm.sbWrites, words);
+    CHECK(Image_Matches(&dm, exe, len));
+    CHECK_EQ(dm.resumes, 1);
+    CHECK_EQ(dm.entry, RV_IMEM_BASE);
+    CHECK(!dm.halted);
+    CHECK_EQ(r.retries, 0);
+    // One 41-bit DMI scan plus five TAP moves per word
+    CHECK_EQ(r.writeTcks, (uint64_t)(words + 6) * 46);
+    CHECK_EQ(m.tckCount, dm.tckCount);
+}
+
+static void Test_Busy(const uint8_t *exe, size_t len) {
+    JtagMaster m;
+    RvDebug d;
+    RvDebugReport r;
+
+    // Each access keeps the DM busy past the next capture until idle is 4
+    RvDm_Init(&dm, 1, 8);
+    Jtag_Init(&m, RvDm_ClockFn, &dm);
+    RvDebug_Init(&d, &m);
+    CHECK_EQ(RvDebug_Load(&d, exe, len, &r), RVDBG_LOADED);
+    CHECK(Image_Matches(&dm, exe, len));
+    CHECK(r.retries > 0 && r.retries <= RV_MAX_IDLE);
+    CHECK_EQ(r.retries, dm.busyHits);
+    CHECK(r.idle >= 4);
+    CHECK_EQ(dm.resumes, 1);
+}
+
+static void Test_Refused(const uint8_t *exe, size_t len) {
+    JtagMaster m;
+    RvDebug d;
+    RvDebugReport r;
+    uint8_t *bad = malloc(len);
+
+    // Stock NEORV32: no system bus access, nothing written, still halted
+    RvDm_Init(&dm, 0, 0);
+    Jtag_Init(&m, RvDm_ClockFn, &dm);
+    RvDebug_Init(&d, &m);
+    CHECK_EQ(RvDebug_Load(&d, exe, len, &r), RVDBG_NO_SBA);
+    CHECK_EQ(dm.sbWrites, 0);
+    CHECK_EQ(dm.resumes, 0);
+
+    // Header checked before the first TCK
+    memcpy(bad, exe, len);
+    bad[0] ^= 1;
+    RvDm_Init(&dm, 1, 0);
+    Jtag_Init(&m, RvDm_ClockFn, &dm);
+    RvDebug_Init(&d, &m);
+    CHECK_EQ(RvDebug_Load(&d, bad, len, &r), RVDBG_BAD_SIGNATURE);
+    CHECK_EQ(m.tckCount, 0);
+    CHECK_EQ(RvDebug_Load(&d, exe, len - 4, &r), RVDBG_SHORT_IMAGE);
+    CHECK_EQ(m.tckCount, 0);
+    free(bad);
+
+    // Past the end of IMEM: sberror, and the count shows it
+    CHECK_EQ(RvDebug_Connect(&d), RVDBG_LOADED);
+    RvDebug_BeginBlock(&d, RV_IMEM_SIZE - 4);
+    RvDebug_WriteWord(&d, 1);
+    RvDebug_WriteWord(&d, 2);
+    CHECK_EQ(RvDebug_EndBlock(&d), RVDBG_BUS_ERROR);
+    CHECK_EQ(dm.mem[RV_IMEM_SIZE / 4 - 1], 1);
+}
+
+// utils.Shift_Bit on the host HAL: TDO sampled with TCK low
+static uint8_t Pin_Clock(void *ctx, uint8_t tms, uint8_t tdi) {
+    uint8_t tdo;
+    (void)ctx;
+    HalTarget_Pin(HAL_PIN_TMS, tms);
+    HalTarget_Pin(HAL_PIN_TDI, tdi);
+    HalTarget_Pin(HAL_PIN_TCK, 0);
+    tdo = (uint8_t)HalTarget_PinRead(HAL_PIN_TDO);
+    HalTarget_Pin(HAL_PIN_TCK, 1);
+    return tdo;
+}
+
+static void Test_Handover(const uint8_t *bits, size_t bitsLen, const uint8_t *exe, size_t len) {
+    JtagMaster m;
+    RvDebug d;
+    RvDebugReport r;
+
+    HalTarget_Init(1);
+    HalTarget_UseDebug(1);
+    Jtag_Init(&m, Pin_Clock, NULL);
+    RvDebug_Init(&d, &m);
+
+    // Unconfigured: the pins are still the Gowin TAP's
+    CHECK_EQ(RvDebug_Connect(&d), RVDBG_NO_DTM);
+    CHECK(HalTarget_Debug() == NULL);
+
+    Jtag_ResetTap(&m);
+    Jtag_InitConfiguration(&m);
+    Jtag_StreamBitstream(&m, bits, bitsLen);
+    Jtag_FinishConfiguration(&m);
+    CHECK(HalTarget_Bus()->board[0].dev[0].u.gowin.leds & LED_PROG_5);
+    CHECK(HalTarget_Debug() == NULL);
+
+    CHECK_EQ(RvDebug_Load(&d, exe, len, &r), RVDBG_LOADED);
+    CHECK(HalTarget_Debug() != NULL);
+    if (HalTarget_Debug()) {
+        CHECK(Image_Matches(HalTarget_Debug(), exe, len));
+        CHECK_EQ(HalTarget_Debug()->resumes, 1);
+    }
+}
+
+int main(void) {
+    size_t len = 0, bitsLen = 0;
+    uint8_t *exe = HostFile_Load("../JTAG_Programmer_Serial/hello.exe", &len);
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &bitsLen);
+    CHECK(exe != NULL && bits != NULL);
+    if (!exe || !bits) return CHECK_DONE();
+    Test_Load(exe, len);
+    Test_Busy(exe, len);
+    Test_Refused(exe, len);
+    Test_Handover(bits, bitsLen, exe, len);
+    free(exe);
+    free(bits);
+    return CHECK_DONE();
+}
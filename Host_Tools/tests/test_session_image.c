@@ -0,0 +1,182 @@
+/*
+ * Session image: the bitstream and the executable in one stream put the
+ * same DR bits into the TAP as the wire image, the executable lands whole
+ * in the stage before DONE and loads from there through the debug module,
+ * and the overlapped schedule beats the two sends
+ */
+
+#include "check.h"
+#include "gowin_tap.h"
+#include "host_file.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+#include "neorv32_boot.h"
+#include "riscv_debug.h"
+#include "riscv_dm.h"
+#include "session_image.h"
+#include "session_sched.h"
+#include "wire_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void Test_Header(void) {
+    uint8_t bits[9] = { 1, 2, 3, 4, 5, 6, 7, 8, 0xA5 }, fw[5] = { 0x11, 0x22, 0x33, 0x44, 0x55 }, img[96];
+    SessionHeader h;
+    size_t size = SessionImage_Size(9, 5, 2);
+
+    // Firmware frames of 2, 2 and 1 after body bytes 1, 1 and 2, then the other 4
+    CHECK_EQ(size, SESSION_HEADER_SIZE + 7 * SESSION_FRAME_SIZE + 8 + 5);
+    CHECK_EQ(SessionImage_Size(9, 5, 3), 0);
+    CHECK_EQ(SessionImage_Size(0, 5, 2), 0);
+    CHECK_EQ(SessionImage_Build(bits, 9, fw, 5, 2, img, size - 1), 0);
+    CHECK_EQ(SessionImage_Build(bits, 9, fw, 5, 2, img, sizeof(img)), size);
+    CHECK(SessionImage_Parse(img, SESSION_STAGE_SIZE, &h));
+    CHECK_EQ(h.bodyLength, 8);
+    CHECK_EQ(h.tail, 0xA5);
+    CHECK_EQ(h.firmwareLength, 5);
+    CHECK(!SessionImage_Parse(img, 4, &h));           // Bigger than the stage
+    CHECK_EQ(img[SESSION_HEADER_SIZE], SESSION_BITSTREAM);
+    CHECK_EQ(img[SESSION_HEADER_SIZE + 1], 1);        // 4 body bytes over 3 frames
+    CHECK_EQ(img[SESSION_HEADER_SIZE + 5], SESSION_FIRMWARE);
+    CHECK_EQ(img[SESSION_HEADER_SIZE + 6], 2);
+
+    img[16] ^= 1;                     // Check word
+    CHECK(!SessionImage_Parse(img, SESSION_STAGE_SIZE, &h));
+    img[16] ^= 1;
+    {
+        WireHeader w;                 // Not taken for a wire image
+        CHECK(!WireImage_Parse(img, &w));
+    }
+}
+
+// Feeds `data` through a 512-byte ring in uneven pieces
+static void Pump(const uint8_t *data, size_t len, GowinTap *t, JtagMaster *m, McuPump *p, McuRing *r,
+                 uint8_t *stage, uint32_t stageSize) {
+    size_t off = 0, step = 1;
+    GowinTap_Init(t);
+    Jtag_Init(m, GowinTap_ClockFn, t);
+    Jtag_ResetTap(m);
+    Jtag_InitConfiguration(m);
+    McuRing_Init(r, 512);
+    McuPump_Begin(p, r, m);
+    if (stage) McuPump_SetStage(p, stage, stageSize);
+    while (off < len) {
+        uint32_t room;
+        uint8_t *dst = McuRing_WriteSpan(r, &room);
+        size_t n = step < room ? step : room;
+        if (n > len - off) n = len - off;
+        memcpy(dst, data + off, n);
+        McuRing_Commit(r, (uint32_t)n);
+        off += n;
+        McuPump_Drain(p);
+        step = step * 7 % 1021 + 1;
+    }
+    CHECK(McuPump_BodyDone(p));
+    McuPump_Finish(p);
+}
+
+static void Test_Stream(const uint8_t *bits, size_t len, const uint8_t *exe, size_t exeLen) {
+    static GowinTap a, b;
+    static RvDm dm;
+    static uint8_t stage[SESSION_STAGE_SIZE];
+    JtagMaster ma, mb, md;
+    McuRing ra, rb;
+    McuPump pa, pb;
+    RvDebug d;
+    RvDebugReport rep;
+    uint8_t *wire = malloc(WIRE_HEADER_SIZE + len);
+    size_t wireLen = WireImage_Build(bits, len, wire, WIRE_HEADER_SIZE + len);
+    size_t cap = SessionImage_Size(len, exeLen, 256);
+    uint8_t *img = malloc(cap);
+    size_t imgLen = SessionImage_Build(bits, len, exe, exeLen, 256, img, cap);
+
+    CHECK_EQ(imgLen, cap);
+    memset(stage, 0xFF, sizeof(stage));
+    Pump(wire, wireLen, &a, &ma, &pa, &ra, NULL, 0);
+    Pump(img, imgLen, &b, &mb, &pb, &rb, stage, sizeof(stage));
+
+    CHECK_EQ(pb.mode, PUMP_SESSION);
+    CHECK(!pb.badFrame);
+    CHECK_EQ(pb.frames, (exeLen + 255) / 256 * 2 + 1);
+    CHECK_EQ(b.diagStreamBits, len * 8);
+    CHECK_EQ(mb.tckCount, ma.tckCount);
+    CHECK_EQ(b.leds, a.leds);
+    CHECK(b.leds & LED_PROG_5);
+    CHECK(McuPump_Staged(&pb));
+    CHECK_EQ(pb.stagedAtDone, exeLen);          // Staged before DONE, not after
+    CHECK_EQ(memcmp(stage, exe, exeLen), 0);
+    McuRing_Free(&ra); McuRing_Free(&rb);
+
+    // Out of the stage into IMEM, as Load_Firmware_Debug does From_Stage
+    RvDm_Init(&dm, 1, 0);
+    Jtag_Init(&md, RvDm_ClockFn, &dm);
+    RvDebug_Init(&d, &md);
+    CHECK_EQ(RvDebug_Load(&d, stage, exeLen, &rep), RVDBG_LOADED);
+    CHECK_EQ(memcmp(dm.mem, exe + NEORV32_HEADER_SIZE, exeLen - NEORV32_HEADER_SIZE), 0);
+    CHECK_EQ(dm.resumes, 1);
+
+    // Without a stage (Stage_Size 0) the session goes out as a raw bitstream
+    {
+        static GowinTap c;
+        JtagMaster mc;
+        McuRing rc;
+        McuPump pc;
+        size_t off = 0;
+        GowinTap_Init(&c);
+        Jtag_Init(&mc, GowinTap_ClockFn, &c);
+        Jtag_ResetTap(&mc);
+        Jtag_InitConfiguration(&mc);
+        McuRing_Init(&rc, 512);
+        McuPump_Begin(&pc, &rc, &mc);
+        while (off < imgLen) {
+            uint32_t room;
+            uint8_t *dst = McuRing_WriteSpan(&rc, &room);
+            size_t n = room < imgLen - off ? room : imgLen - off;
+            memcpy(dst, img + off, n);
+            McuRing_Commit(&rc, (uint32_t)n);
+            off += n;
+            McuPump_Drain(&pc);
+        }
+        McuPump_Finish(&pc);
+        CHECK_EQ(pc.mode, PUMP_RAW);
+        CHECK_EQ(c.diagStreamBits, imgLen * 8);
+        McuRing_Free(&rc);
+    }
+    free(wire);
+
+    // Overlapped against the two sends, both load paths
+    {
+        SchedConfig c;
+        SchedTimeline seq, ovl;
+        Sched_Defaults(&c, len, exeLen);
+        c.load = SCHED_DEBUG;
+        Sched_Sequential(&c, &seq);
+        Sched_Overlapped(&c, img, imgLen, &ovl);
+        CHECK(ovl.totalMs < seq.totalMs);
+        CHECK(ovl.totalMs >= ovl.boundMs);
+        CHECK(ovl.totalMs < ovl.boundMs * 1.05);
+        CHECK(ovl.stage[SCHED_STAGE].end <= ovl.stage[SCHED_SHIFT].end);
+        CHECK(ovl.ringHighWater < c.ringSize);
+
+        c.load = SCHED_BOOTLOADER;
+        Sched_Sequential(&c, &seq);
+        Sched_Overlapped(&c, img, imgLen, &ovl);
+        CHECK(ovl.totalMs < seq.totalMs);
+        CHECK(ovl.totalMs >= ovl.boundMs);
+        CHECK(ovl.ringHighWater < c.ringSize);
+    }
+    free(img);
+}
+
+int main(void) {
+    size_t len = 0, exeLen = 0;
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &len);
+    uint8_t *exe = HostFile_Load("../JTAG_Programmer_Serial/hello.exe", &exeLen);
+    CHECK(bits != NULL && exe != NULL);
+    Test_Header();
+    if (bits && exe) Test_Stream(bits, len, exe, exeLen);
+    free(bits); free(exe);
+    return CHECK_DONE();
+}
@@ -0,0 +1,135 @@
+/*
+ * Session profiler aggregation, report round trip and a profiled
+ * single-Gowin session through the reference master
+ */
+
+#include "check.h"
+#include "jtag_master.h"
+#include "session_prof.h"
+#include "tap_chain.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void Test_Aggregation(void) {
+    SessionProf p;
+    SessionProf_Begin(&p, PROF_FW_TICK_HZ, PROF_FW_RING);
+
+    CHECK_EQ(ProfStats_Min(&p.phase[PROF_COMMAND]), 0);
+    CHECK_EQ(ProfStats_Avg(&p.phase[PROF_COMMAND]), 0);
+    CHECK_EQ(SessionProf_Rate(&p), 0);
+
+    SessionProf_Sample(&p, PROF_COMMAND, 12);
+    SessionProf_Sample(&p, PROF_COMMAND, 30);
+    SessionProf_Sample(&p, PROF_COMMAND, 15);
+    CHECK_EQ(p.phase[PROF_COMMAND].count, 3);
+    CHECK_EQ(ProfStats_Min(&p.phase[PROF_COMMAND]), 12);
+    CHECK_EQ(p.phase[PROF_COMMAND].max, 30);
+    CHECK_EQ(ProfStats_Avg(&p.phase[PROF_COMMAND]), 19);
+    CHECK_EQ(p.phase[PROF_RESET].count, 0);
+
+    // 444430 bytes in 38.58 s of pump: the 115200 baud USART2 limit
+    p.bytes = 444430;
+    SessionProf_Sample(&p, PROF_PUMP, 38580000);
+    CHECK_EQ(SessionProf_Rate(&p), 11519);
+
+    SessionProf_Level(&p, 40);
+    SessionProf_Level(&p, 3);
+    SessionProf_Level(&p, 511);
+    SessionProf_Level(&p, 200);
+    CHECK_EQ(p.highWater, 511);
+
+    // Reset for the next session
+    SessionProf_Begin(&p, PROF_FW_TICK_HZ, PROF_FW_RING);
+    CHECK_EQ(p.highWater, 0);
+    CHECK_EQ(p.phase[PROF_COMMAND].count, 0);
+}
+
+static void Test_Report_Round_Trip(void) {
+    SessionProf p, q;
+    FILE *f = tmpfile();
+    char line[128];
+    int lines = 0, bad = 0;
+
+    SessionProf_Begin(&p, PROF_FW_TICK_HZ, PROF_FW_RING);
+    SessionProf_Sample(&p, PROF_RESET, 4);
+    SessionProf_Sample(&p, PROF_INIT, 1450);
+    SessionProf_Sample(&p, PROF_PUMP, 38580000);
+    SessionProf_Sample(&p, PROF_TRAILER, 210);
+    SessionProf_Sample(&p, PROF_COMMAND, 17);
+    SessionProf_Sample(&p, PROF_COMMAND, 21);
+    p.bytes = 444430; p.txeSpins = 9876; p.highWater = 37;
+
+    SessionProf_Print(&p, f);
+    rewind(f);
+    memset(&q, 0, sizeof(q));
+    SessionProf_Begin(&q, 0, 0);
+    while (fgets(line, sizeof(line), f)) {
+        int r = SessionProf_ParseLine(&q, line);
+        if (r > 0) lines++;
+        if (r < 0) bad++;
+    }
+    fclose(f);
+
+    CHECK_EQ(lines, 11);
+    CHECK_EQ(bad, 0);
+    CHECK(memcmp(&p, &q, sizeof(p)) == 0);
+    CHECK_EQ(SessionProf_Rate(&q), SessionProf_Rate(&p));
+
+    // Unrelated chatter is skipped, broken fields are not
+    CHECK_EQ(SessionProf_ParseLine(&q, "Configuring FPGA\r\n"), 0);
+    CHECK_EQ(SessionProf_ParseLine(&q, "bytes_per_second 5\n"), 0);
+    CHECK_EQ(SessionProf_ParseLine(&q, "pump 1 2 3\n"), -1);
+    CHECK_EQ(SessionProf_ParseLine(&q, "ring_high_water 37\n"), -1);
+    CHECK_EQ(SessionProf_ParseLine(&q, "txe_spins x\n"), -1);
+}
+
+static void Test_Profiled_Session(void) {
+    enum { LEN = MIN_STREAM_BITS / 8 + 64 };
+    TapChain chain; JtagMaster m; SessionProf p;
+    uint8_t *bits = malloc(LEN);
+    uint64_t sum = 0;
+    int i;
+
+    for (i = 0; i < LEN; i++) bits[i] = (uint8_t)(i * 37);
+    TapChain_Init(&chain); TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    SessionProf_Begin(&p, 12000000, PROF_FW_RING);
+    m.prof = &p;
+
+    Jtag_ResetTap(&m);
+    Jtag_InitConfiguration(&m);
+    Jtag_StreamBitstream(&m, bits, LEN);
+    Jtag_FinishConfiguration(&m);
+    CHECK(TapChain_Gowin(&chain, 0)->leds & LED_PROG_5);
+
+    // 14 commands in Init_Configuration, 5 in the trailer; 4 + 8 + 3 TCKs each
+    CHECK_EQ(p.phase[PROF_COMMAND].count, 19);
+    CHECK_EQ(ProfStats_Min(&p.phase[PROF_COMMAND]), 15);
+    CHECK_EQ(p.phase[PROF_COMMAND].max, 15);
+    CHECK_EQ(p.phase[PROF_RESET].total, 6);
+    CHECK_EQ(p.phase[PROF_PUMP].total, 3 + 8 * (uint64_t)LEN + 2);
+    CHECK_EQ(p.bytes, LEN);
+    for (i = 0; i < PROF_PHASES; i++) if (i != PROF_COMMAND) {
+        CHECK_EQ(p.phase[i].count, 1);
+        sum += p.phase[i].total;
+    }
+    // The phases cover the whole session and contain every command
+    CHECK_EQ(sum, m.tckCount);
+    CHECK(p.phase[PROF_INIT].total + p.phase[PROF_TRAILER].total > p.phase[PROF_COMMAND].total);
+    // A 12 MHz TCK moves just under 1.5 MB/s once the walk into Shift-DR is paid
+    CHECK(SessionProf_Rate(&p) < 1500000 && SessionProf_Rate(&p) > 1499000);
+
+    // Without a profiler attached nothing is recorded
+    m.prof = NULL;
+    Jtag_SendCommand(&m, 0x41);
+    CHECK_EQ(p.phase[PROF_COMMAND].count, 19);
+    free(bits);
+}
+
+int main(void) {
+    Test_Aggregation();
+    Test_Report_Round_Trip();
+    Test_Profiled_Session();
+    return CHECK_DONE();
+}
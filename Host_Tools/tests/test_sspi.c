@@ -0,0 +1,96 @@
+/*
+ * SSPI path: the programmer's session against the SSPI target model
+ */
+
+#include "check.h"
+#include "sspi_master.h"
+#include "sspi_target.h"
+
+#include <stdlib.h>
+
+typedef struct {
+    SspiTarget t;
+    uint64_t   nowNs;
+    int        holdReset;   // RECONFIG_N never released: READY stays low
+} SimBus;
+
+static void    Sim_Select(void *c, int csLow) { SspiTarget_Select(&((SimBus *)c)->t, (uint8_t)csLow); }
+static int     Sim_Ready(void *c) { return ((SimBus *)c)->t.ready; }
+static int     Sim_Done(void *c) { return ((SimBus *)c)->t.done; }
+static void    Sim_Delay(void *c, uint32_t us) { ((SimBus *)c)->nowNs += (uint64_t)us * 1000; }
+
+static uint8_t Sim_Transfer(void *c, uint8_t mosi) {
+    SimBus *s = c;
+    s->nowNs += 667;   // 8 bits at 12 MHz
+    return SspiTarget_Transfer(&s->t, mosi, s->nowNs);
+}
+
+static void Sim_Reconfig(void *c, int level) {
+    SimBus *s = c;
+    SspiTarget_Reconfig(&s->t, (uint8_t)(level && !s->holdReset));
+}
+
+static int Program(SimBus *s, SspiMaster *m, uint32_t eraseWaitUs, size_t len) {
+    static const SspiBus bus0 = { Sim_Select, Sim_Transfer, Sim_Ready, Sim_Done, Sim_Reconfig, Sim_Delay, 0 };
+    static SspiBus bus;
+    uint8_t *bits = malloc(len ? len : 1);
+    size_t i;
+    int ok;
+
+    for (i = 0; i < len; i++) bits[i] = (uint8_t)(i * 7);
+    bus = bus0; bus.ctx = s;
+    SspiTarget_Init(&s->t);
+    SspiMaster_Init(m, &bus);
+    m->eraseWaitUs = eraseWaitUs;
+    ok = SspiMaster_Program(m, bits, len);
+    free(bits);
+    return ok;
+}
+
+int main(void) {
+    static SimBus s;
+    SspiMaster m;
+    int i;
+
+    // Flowchart order with the 4 ms wait: no errors, ID and DONE read back
+    s.nowNs = 0; s.holdReset = 0;
+    CHECK_EQ(Program(&s, &m, SSPI_ERASE_WAIT_US, 4096), 1);
+    CHECK_EQ(m.idcode, SSPI_ID_VAL);
+    CHECK_EQ(m.status, SSPI_STATUS_BASE | SSPI_STATUS_DONE);
+    CHECK_EQ(m.bytesSent, 4096);
+    CHECK_EQ(s.t.eventCount[SSPI_EVT_ERR_SEQ], 0);
+    CHECK_EQ(s.t.eventCount[SSPI_EVT_ERR_TIMING], 0);
+    CHECK_EQ(s.t.eventCount[SSPI_EVT_DONE], 1);
+    CHECK_EQ(s.t.eventCount[SSPI_EVT_STATUS], 1);   // DONE on the first poll
+    CHECK_EQ(s.t.leds & (SSPI_LED_ERS | SSPI_LED_WRT | SSPI_LED_DONE | SSPI_LED_FAIL),
+             SSPI_LED_ERS | SSPI_LED_WRT | SSPI_LED_DONE);
+
+    // Status_Done: bit 13 of the 32-bit read-back, whatever the other bits say
+    for (i = 0; i < 32; i++) {
+        CHECK_EQ(Sspi_StatusDone(1u << i), (1u << i) == SSPI_STATUS_DONE_BIT);
+        CHECK_EQ(Sspi_StatusDone(~(1u << i)), (1u << i) != SSPI_STATUS_DONE_BIT);
+    }
+    CHECK(Sspi_StatusDone(SSPI_STATUS_BASE | SSPI_STATUS_DONE));
+    CHECK(!Sspi_StatusDone(SSPI_STATUS_BASE));
+
+    // Init too soon after Erase is flagged by the target
+    s.nowNs = 0;
+    Program(&s, &m, 1000, 4096);
+    CHECK_EQ(s.t.eventCount[SSPI_EVT_ERR_TIMING], 1);
+    CHECK(s.t.leds & SSPI_LED_FAIL);
+
+    // Too few bytes: DONE never comes, polling gives up
+    s.nowNs = 0;
+    CHECK_EQ(Program(&s, &m, SSPI_ERASE_WAIT_US, 50), 0);
+    CHECK_EQ(s.t.eventCount[SSPI_EVT_STATUS], SSPI_DONE_POLLS);
+    CHECK(!Sspi_StatusDone(m.status));
+
+    // READY low: nothing is clocked out and the session fails
+    s.nowNs = 0; s.holdReset = 1;
+    CHECK_EQ(Program(&s, &m, SSPI_ERASE_WAIT_US, 4096), 0);
+    CHECK(m.notReady);
+    CHECK_EQ(m.bytesSent, 0);
+    CHECK_EQ(s.t.eventCount[SSPI_EVT_IDCODE] + s.t.eventCount[SSPI_EVT_ERASE]
+             + s.t.eventCount[SSPI_EVT_WRITE_START], 0);
+    return CHECK_DONE();
+}
@@ -0,0 +1,106 @@
+/*
+ * SSPI checker: timing rules on traces and on the programmer's session
+ */
+
+#include "check.h"
+#include "sspi_check.h"
+#include "sspi_master.h"
+#include "sspi_record.h"
+
+#include <stdlib.h>
+
+static const char *goodTrace[] = {
+    "# t_ns  bytes",
+    "0        RECONFIG 0",
+    "2000000  RECONFIG 1",
+    "2001000  11 00 00 00 00 00 00 00",
+    "2010000  05 00",
+    "6010000  12 00",          // 4 ms after the erase byte, exactly
+    "6020000  15 00",
+    "6030000  3B +200",
+    "6200000  3A 00",
+    "6210000  41 00 00 00 00 00 00 00",
+};
+
+static void FeedLines(SspiChecker *c, const char **lines, size_t n) {
+    SspiTraceRec rec;
+    size_t i;
+    for (i = 0; i < n; i++) if (SspiTrace_Parse(lines[i], &rec) > 0) SspiChecker_Feed(c, &rec);
+}
+
+static int Session(SspiChecker *c, SspiRecorder *rec, uint32_t eraseWaitUs, size_t len) {
+    SspiMaster m;
+    uint8_t *bits = calloc(len, 1);
+    int ok;
+    SspiChecker_Init(c, SSPI_DEFAULT_SCK);
+    SspiRecorder_Init(rec, c, NULL);
+    SspiMaster_Init(&m, &rec->bus);
+    m.eraseWaitUs = eraseWaitUs;
+    ok = SspiMaster_Program(&m, bits, len);
+    free(bits);
+    return ok;
+}
+
+int main(void) {
+    static SspiChecker c;
+    static SspiRecorder rec;
+    SspiTraceRec r;
+    const char *lines[sizeof(goodTrace) / sizeof(goodTrace[0])];
+    size_t n = sizeof(goodTrace) / sizeof(goodTrace[0]), i;
+
+    // Parser
+    CHECK_EQ(SspiTrace_Parse("  # note", &r), 0);
+    CHECK_EQ(SspiTrace_Parse("12 3B +444430", &r), 1);
+    CHECK_EQ(r.tNs, 12); CHECK_EQ(r.headLen, 1); CHECK_EQ(r.head[0], 0x3B); CHECK_EQ(r.burstLen, 444430);
+    CHECK_EQ(SspiTrace_Parse("5 RECONFIG 1", &r), 1);
+    CHECK_EQ(r.kind, SSPI_TR_RECONFIG); CHECK_EQ(r.level, 1);
+    CHECK_EQ(SspiTrace_Parse("5 1FF", &r), -1);
+    CHECK_EQ(SspiTrace_Parse("5", &r), -1);
+
+    // A clean trace, the INIT byte ending exactly 4 ms after the ERASE byte
+    SspiChecker_Init(&c, SSPI_DEFAULT_SCK);
+    FeedLines(&c, goodTrace, n);
+    CHECK(!SspiChecker_Failed(&c));
+    CHECK_EQ(c.r.transactions, 7);
+    CHECK_EQ(c.r.burstBytes, 200);
+    CHECK_EQ(c.r.minEraseSlackNs, 0);
+    CHECK(c.r.done);
+
+    // 1 ns short of the erase wait is a timing violation
+    for (i = 0; i < n; i++) lines[i] = goodTrace[i];
+    lines[5] = "6009999  12 00";
+    SspiChecker_Init(&c, SSPI_DEFAULT_SCK);
+    FeedLines(&c, lines, n);
+    CHECK_EQ(c.r.timingErrors, 1);
+    CHECK_EQ(c.r.minEraseSlackNs, -1);
+    CHECK(SspiChecker_Failed(&c));
+
+    // Skipping the erase is a sequence error; overlapping lines are trace errors
+    lines[5] = goodTrace[5];
+    lines[4] = "# erase removed";
+    lines[9] = "6200001  41 00 00 00 00 00 00 00";
+    SspiChecker_Init(&c, SSPI_DEFAULT_SCK);
+    FeedLines(&c, lines, n);
+    CHECK_EQ(c.r.seqErrors, 1);
+    CHECK_EQ(c.r.traceErrors, 1);
+
+    // Commands while READY is low
+    SspiChecker_Init(&c, SSPI_DEFAULT_SCK);
+    lines[0] = "0 RECONFIG 0"; lines[1] = "10 05 00";
+    FeedLines(&c, lines, 2);
+    CHECK_EQ(c.r.notReady, 1);
+
+    // The programmer's session passes with the delays at the spec minimum:
+    // only the 2 ms RECONFIG_N pulse and the 4 ms erase wait, nothing padded
+    CHECK_EQ(Session(&c, &rec, SSPI_ERASE_WAIT_US, 4096), 1);
+    CHECK(!SspiChecker_Failed(&c));
+    CHECK_EQ(c.r.burstBytes, 4096);
+    CHECK_EQ(rec.delayNs, (SSPI_RECONFIG_PULSE_US + SSPI_ERASE_WAIT_US) * 1000ULL);
+    CHECK(c.r.minEraseSlackNs >= 0);
+    CHECK(c.r.minEraseSlackNs < 2000);   // Just the INIT command's own bytes
+
+    // ... and the slack is below 2 us, so 2 us less is caught
+    Session(&c, &rec, SSPI_ERASE_WAIT_US - 2, 4096);
+    CHECK_EQ(c.r.timingErrors, 1);
+    return CHECK_DONE();
+}
@@ -0,0 +1,112 @@
+/*
+ * Programming station: ports found by glob, the bitstream mapped once,
+ * 32 simulated programmers on ptys programmed from one process, and a deaf
+ * board and one that hangs up mid-way failing on their own while the
+ * rest finish
+ */
+
+#include "check.h"
+#include "host_file.h"
+#include "mcu_farm.h"
+#include "station.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SLICE (32u * 1024u)   // Past the TAP's minimum stream, quick to shift
+
+static void Test_Discover(void) {
+    char dir[] = "/tmp/station_XXXXXX", path[96], found[4][64];
+    const char *names[] = { "ttyACM10", "ttyACM2", "ttyACM0", "ttyUSB0" };
+    int i;
+    CHECK(mkdtemp(dir) != NULL);
+    for (i = 0; i < 4; i++) {
+        FILE *f;
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        if ((f = fopen(path, "w"))) fclose(f);
+    }
+    snprintf(path, sizeof(path), "%s/ttyACM*", dir);
+    CHECK_EQ(Station_Discover(path, found, 4), 3);
+    CHECK(strstr(found[0], "ttyACM0") != NULL);
+    CHECK(strstr(found[1], "ttyACM10") != NULL);   // glob order, as ls gives it
+    CHECK_EQ(Station_Discover(path, found, 2), 2);
+    snprintf(path, sizeof(path), "%s/ttyS*", dir);
+    CHECK_EQ(Station_Discover(path, found, 4), 0);
+    for (i = 0; i < 4; i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+static void Test_Map(const uint8_t *bits, size_t len) {
+    const uint8_t *data;
+    size_t n = 0;
+    CHECK_EQ(Station_MapFile("../JTAG_Programmer_Serial/output1.bin", &data, &n), 0);
+    CHECK_EQ(n, len);
+    if (n == len) CHECK(memcmp(data, bits, len) == 0);
+    Station_UnmapFile(data, n);
+    CHECK(Station_MapFile("/nonexistent.bin", &data, &n) < 0);
+}
+
+// Every board from one process; bad boards fail alone
+static void Test_Farm(const uint8_t *bits, int boards, uint64_t deaf, uint64_t hangup) {
+    McuFarmConfig c = { boards, 4096, deaf, hangup, SLICE / 4, 200.0 };
+    McuFarm f;
+    Station st;
+    int i, good = 0;
+
+    CHECK_EQ(McuFarm_Start(&f, &c), 0);
+    CHECK_EQ(Station_Init(&st, bits, SLICE, 256, 0), 0);
+    st.configMs = 1000;
+    for (i = 0; i < boards; i++) CHECK_EQ(Station_Add(&st, McuFarm_Path(&f, i)), 0);
+    Station_Run(&st);
+    McuFarm_Stop(&f);
+
+    for (i = 0; i < boards; i++) {
+        const StationPort *p = &st.port[i];
+        const McuFarmBoard *b = &f.board[i];
+        if ((deaf >> i) & 1) {
+            CHECK_EQ(p->state, PORT_FAIL);
+            CHECK(strcmp(p->why, "no prompt") == 0);
+            CHECK_EQ(b->configs, 0);
+        } else if ((hangup >> i) & 1) {
+            CHECK_EQ(p->state, PORT_FAIL);
+            CHECK(strcmp(p->why, "port closed") == 0);
+            CHECK(!b->done);
+        } else {
+            good++;
+            CHECK_EQ(p->state, PORT_DONE);
+            CHECK(strncmp(p->report, "chunks frames ", 14) == 0);
+            CHECK(strstr(p->report, " DONE") != NULL);
+            CHECK_EQ(b->configs, 1);
+            CHECK(b->done);
+            CHECK_EQ(b->shifted, SLICE);
+            CHECK_EQ(b->streamBits, SLICE * 8);
+            CHECK(Station_PortRate(&st, i) > 0);
+        }
+    }
+    CHECK_EQ(st.done, good);
+    CHECK(st.wireBytes >= (uint64_t)good * SLICE);
+    // Concurrent: one linger for all of them, not one after another
+    CHECK(st.wallMs < (deaf ? st.configMs : 0) + 2 * c.lingerMs + 500);
+    Station_Free(&st);
+    McuFarm_Free(&f);
+}
+
+int main(void) {
+    size_t len = 0;
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &len);
+    CHECK(bits != NULL && len >= SLICE);
+    Test_Discover();
+    if (bits && len >= SLICE) {
+        Test_Map(bits, len);
+        Test_Farm(bits, 1, 0, 0);
+        Test_Farm(bits, 32, 0, 0);
+        Test_Farm(bits, 24, 1u << 3, 1u << 17);
+    }
+    free(bits);
+    return CHECK_DONE();
+}
@@ -0,0 +1,377 @@
+/*
+ * Shared vectors for the C mirrors of the firmware's pure packages
+ * - tests/vectors/<unit>.vec drives cmd_link (frames and command lines),
+ *   ring_monitor, baud_link, profiler and manifest one directive a line;
+ *   each directive prints one line, and the lines must match <unit>.out
+ * - ada/vectors.adb runs the same files through the Ada units themselves
+ *   (make ada-check), so both sides answer to one expected output
+ * - fuzz directives draw from the same LCG on both sides
+ * - -w rewrites the .out files from the C side
+ */
+
+#include "check.h"
+#include "boot_cache.h"
+#include "baud_link.h"
+#include "chunk_link.h"
+#include "cmd_link.h"
+#include "manifest.h"
+#include "ring_monitor.h"
+#include "session_prof.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_TOKENS 320
+
+// --- SHARED HELPERS (ada/vectors.adb has the same) ---
+static uint32_t lcg;
+static uint32_t Next(void) {
+    lcg = lcg * 1103515245u + 12345u;
+    return lcg >> 16;
+}
+
+static uint32_t Fnv(uint32_t h, uint8_t b) { return (h ^ b) * 16777619u; }
+
+static uint32_t Num(const char *s) { return (uint32_t)strtoul(s, NULL, 10); }
+static uint32_t Hex(const char *s) { return (uint32_t)strtoul(s, NULL, 16); }
+
+static void Put_Hex(FILE *out, const uint8_t *b, size_t n) {
+    size_t i;
+    for (i = 0; i < n; i++) fprintf(out, "%02X", b[i]);
+}
+
+// --- CMD_LINK ---
+// Prints each verdict (or folds it into *hash), then the counters
+static void Cmd_Feed(FILE *out, const uint8_t *b, size_t n, uint32_t *hash) {
+    CmdParser p;
+    size_t i;
+    CmdParser_Init(&p, 0);
+    for (i = 0; i < n; i++) {
+        CmdVerdict v = CmdParser_Feed(&p, b[i]);
+        if (v == CMDV_NONE) continue;
+        if (hash) {
+            *hash = Fnv(*hash, (uint8_t)v); *hash = Fnv(*hash, p.op); *hash = Fnv(*hash, p.tag);
+            *hash = Fnv(*hash, (uint8_t)p.len); *hash = Fnv(*hash, (uint8_t)(p.len >> 8));
+        } else if (v == CMDV_GOOD) {
+            fprintf(out, " G:%02X:%02X:%u:", p.op, p.tag, p.len);
+            Put_Hex(out, p.payload, p.len);
+        } else if (v == CMDV_BAD_CRC) {
+            fprintf(out, " C:%02X:%02X", p.op, p.tag);
+        } else {
+            fprintf(out, " L");
+        }
+    }
+    fprintf(out, " | %u %u %u %u", p.frames, p.badCrc, p.tooLong, p.skipped);
+    if (hash) fprintf(out, " %08X", *hash);
+    fprintf(out, "\n");
+}
+
+// Valid frames, some damaged, some too long, and runs of garbage
+static size_t Cmd_Fuzz_Stream(uint8_t *s, uint32_t count) {
+    size_t n = 0;
+    uint32_t k, i;
+    for (k = 0; k < count; k++) {
+        uint32_t kind = Next() % 4;
+        if (kind == 0) {
+            uint32_t len = Next() % 8;
+            for (i = 0; i < len; i++) s[n++] = (uint8_t)Next();
+        } else {
+            size_t start = n;
+            uint32_t len = Next() % (CMD_MAX_PAYLOAD + 12), crc;
+            s[n++] = CMD_SYNC;
+            s[n++] = (uint8_t)(Next() % 16);
+            s[n++] = (uint8_t)Next();
+            s[n++] = (uint8_t)len;
+            s[n++] = (uint8_t)(len >> 8);
+            if (len <= CMD_MAX_PAYLOAD) {
+                for (i = 0; i < len; i++) s[n++] = (uint8_t)Next();
+                crc = ChunkLink_Crc32(0, s + start + 1, n - start - 1);
+                for (i = 0; i < 4; i++) s[n++] = (uint8_t)(crc >> (8 * i));
+            }
+            if (kind == 3) {
+                uint32_t at = Next() % (uint32_t)(n - start);
+                s[start + at] ^= (uint8_t)(1u << (Next() % 8));
+            }
+        }
+    }
+    return n;
+}
+
+static void Cmd_Line(char **t, int n, FILE *out) {
+    uint8_t b[MAX_TOKENS], f[CMD_MAX_FRAME];
+    int i;
+    if (strcmp(t[0], "feed") == 0) {
+        for (i = 1; i < n; i++) b[i - 1] = (uint8_t)Hex(t[i]);
+        fprintf(out, "feed");
+        Cmd_Feed(out, b, (size_t)(n - 1), NULL);
+    } else if (strcmp(t[0], "encode") == 0) {
+        uint8_t payload[CMD_MAX_PAYLOAD];
+        uint16_t len = 0;
+        size_t size;
+        for (i = 4; i < n && len + 4u <= CMD_MAX_PAYLOAD; i++) {
+            uint32_t w = Hex(t[i]);
+            payload[len++] = (uint8_t)w; payload[len++] = (uint8_t)(w >> 8);
+            payload[len++] = (uint8_t)(w >> 16); payload[len++] = (uint8_t)(w >> 24);
+        }
+        size = CmdLink_Reply((uint8_t)Hex(t[1]), (uint8_t)Hex(t[2]), (uint8_t)Hex(t[3]), payload, len, f);
+        fprintf(out, "encode ");
+        Put_Hex(out, f, size);
+        fprintf(out, "\n");
+    } else if (strcmp(t[0], "line") == 0) {
+        // The words after it, one space apart
+        char text[MAX_TOKENS * 8] = "";
+        size_t len = 0;
+        unsigned arg;
+        uint8_t op;
+        for (i = 1; i < n; i++) len += (size_t)snprintf(text + len, sizeof(text) - len, i > 1 ? " %s" : "%s", t[i]);
+        op = CmdLink_ParseLine(text, len, &arg);
+        fprintf(out, "line %02X %u\n", op, arg);
+    } else if (strcmp(t[0], "fuzz") == 0) {
+        uint32_t count = Num(t[2]), hash = 2166136261u;
+        uint8_t *s = malloc((size_t)count * (CMD_MAX_FRAME + 8));
+        size_t len;
+        lcg = Num(t[1]);
+        len = Cmd_Fuzz_Stream(s, count);
+        fprintf(out, "fuzz %zu", len);
+        Cmd_Feed(out, s, len, &hash);
+        free(s);
+    }
+}
+
+// --- RING_MONITOR ---
+static RingMonitor ring;
+
+static void Ring_Put(FILE *out, const char *what) {
+    fprintf(out, "%s %u %u %u %u %u %u\n", what, ring.produced, ring.consumed, RingMonitor_Level(&ring),
+            ring.highWater, ring.overruns, ring.lost);
+}
+
+// Crossings of offset h (1 .. size) in the bytes 1 .. x the DMA has written
+static uint32_t Hits(uint32_t x, uint32_t h, uint32_t size) { return x >= h ? (x - h) / size + 1 : 0; }
+
+static void Ring_Line(char **t, int n, FILE *out) {
+    (void)n;
+    if (strcmp(t[0], "reset") == 0) {
+        RingMonitor_Reset(&ring, Num(t[1]), Num(t[2]), Num(t[3]));
+        Ring_Put(out, "ring");
+    } else if (strcmp(t[0], "produce") == 0) {
+        RingMonitor_Produce(&ring, Num(t[1]), Num(t[2]) != 0, Num(t[3]) != 0);
+        Ring_Put(out, "ring");
+    } else if (strcmp(t[0], "consume") == 0) {
+        RingMonitor_Consume(&ring, Num(t[1]));
+        Ring_Put(out, "ring");
+    } else if (strcmp(t[0], "fuzz") == 0) {
+        // A DMA that runs ahead by up to 1.5 rings between polls, and a
+        // consumer that sometimes skips a poll
+        uint32_t count = Num(t[2]), size = Num(t[3]), pos = 0, k;
+        int half = 0, full = 0;
+        lcg = Num(t[1]);
+        RingMonitor_Reset(&ring, size, 0, 0);
+        for (k = 0; k < count; k++) {
+            uint32_t adv = Next() % (size + size / 2);
+            half |= Hits(pos + adv, size / 2, size) != Hits(pos, size / 2, size);
+            full |= Hits(pos + adv, size, size) != Hits(pos, size, size);
+            pos += adv;
+            if (Next() % 4 == 0) continue;
+            RingMonitor_Produce(&ring, pos % size, half, full);
+            half = full = 0;
+            RingMonitor_Consume(&ring, Next() % (RingMonitor_Level(&ring) + 1));
+        }
+        Ring_Put(out, "fuzz");
+    }
+}
+
+// --- BAUD_LINK ---
+static BaudMcu baud;
+
+static void Baud_Put(FILE *out) {
+    uint8_t tx[sizeof(baud.tx)];
+    size_t n = BaudMcu_TakeTx(&baud, tx, sizeof(tx));
+    int sw = BaudMcu_TakeSwitch(&baud);
+    fprintf(out, "baud %d %u %u %u %u %u %u tx=", (int)baud.state, baud.base, baud.rate, baud.trial,
+            baud.got, baud.errors, baud.trials);
+    Put_Hex(out, tx, n);
+    if (sw >= 0) fprintf(out, " sw=%d\n", sw); else fprintf(out, " sw=-\n");
+}
+
+static void Baud_Line(char **t, int n, FILE *out) {
+    uint8_t b[MAX_TOKENS];
+    int i;
+    if (strcmp(t[0], "start") == 0) {
+        BaudMcu_Begin(&baud, (uint8_t)Num(t[1]), Num(t[2]));
+        Baud_Put(out);
+    } else if (strcmp(t[0], "rx") == 0) {
+        for (i = 2; i < n; i++) b[i - 2] = (uint8_t)Hex(t[i]);
+        BaudMcu_Rx(&baud, b, (size_t)(n - 2), Num(t[1]));
+        Baud_Put(out);
+    } else if (strcmp(t[0], "pattern") == 0) {
+        uint32_t count = Num(t[2]), bad = Num(t[3]), k;
+        for (k = 0; k < count; k++) {
+            uint8_t p = BaudLink_Pattern(k) ^ (k < bad ? 0xFF : 0x00);
+            BaudMcu_Rx(&baud, &p, 1, Num(t[1]));
+        }
+        Baud_Put(out);
+    } else if (strcmp(t[0], "tick") == 0) {
+        BaudMcu_Tick(&baud, Num(t[1]));
+        Baud_Put(out);
+    } else if (strcmp(t[0], "frame") == 0) {
+        uint8_t f[BAUD_FRAME_SIZE], op, index, arg;
+        BaudLink_Frame((uint8_t)Hex(t[1]), (uint8_t)Num(t[2]), (uint8_t)Num(t[3]), f);
+        fprintf(out, "frame ");
+        Put_Hex(out, f, BAUD_FRAME_SIZE);
+        fprintf(out, " %d\n", BaudLink_Parse(f, &op, &index, &arg));
+    } else if (strcmp(t[0], "valid") == 0) {
+        uint8_t f[BAUD_FRAME_SIZE], op, index, arg;
+        for (i = 0; i < (int)BAUD_FRAME_SIZE; i++) f[i] = (uint8_t)Hex(t[i + 1]);
+        fprintf(out, "valid %d\n", BaudLink_Parse(f, &op, &index, &arg));
+    }
+}
+
+// --- PROFILER ---
+static SessionProf prof;
+
+static void Prof_Put(FILE *out) {
+    int i;
+    fprintf(out, "prof");
+    for (i = 0; i < PROF_PHASES; i++) {
+        const ProfStats *s = &prof.phase[i];
+        fprintf(out, " %u %u %u %u %u", s->count, ProfStats_Min(s), ProfStats_Avg(s), s->max, (uint32_t)s->total);
+    }
+    fprintf(out, " %u %u %u\n", prof.bytes, SessionProf_Rate(&prof), prof.highWater);
+}
+
+static void Prof_Line(char **t, int n, FILE *out) {
+    (void)n;
+    if (strcmp(t[0], "begin") == 0) SessionProf_Begin(&prof, PROF_FW_TICK_HZ, PROF_FW_RING);
+    else if (strcmp(t[0], "sample") == 0) SessionProf_Sample(&prof, (ProfPhase)Num(t[1]), Num(t[2]));
+    else if (strcmp(t[0], "level") == 0) SessionProf_Level(&prof, Num(t[1]));
+    else if (strcmp(t[0], "bytes") == 0) prof.bytes = Num(t[1]);
+    else return;
+    Prof_Put(out);
+}
+
+// --- MANIFEST ---
+typedef struct { uint32_t op, length, value, mask; } RawStep;
+
+static void Put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+// Header and table as Manifest_Build lays them out, data length and CRC
+// taken as given so the vectors can break them
+static int Manifest_Check(const RawStep *s, uint32_t n, uint32_t stage, uint32_t cache, int sumData,
+                          uint32_t dataLen, uint32_t crcXor) {
+    uint8_t m[MANIFEST_HEADER_SIZE + 16 * MANIFEST_STEP_SIZE];
+    ManifestStep parsed[MANIFEST_MAX_STEPS];
+    uint32_t i, sum = 0;
+    for (i = 0; i < n; i++) {
+        uint8_t *p = m + MANIFEST_HEADER_SIZE + i * MANIFEST_STEP_SIZE;
+        Put32(p, s[i].op); Put32(p + 4, s[i].length); Put32(p + 8, s[i].value); Put32(p + 12, s[i].mask);
+        sum += s[i].length;
+    }
+    Put32(m, MANIFEST_MAGIC);
+    Put32(m + 4, n);
+    Put32(m + 8, sumData ? sum : dataLen);
+    Put32(m + 12, BootCache_Crc32(m + MANIFEST_HEADER_SIZE, n * MANIFEST_STEP_SIZE) ^ crcXor);
+    return Manifest_Parse(m, MANIFEST_HEADER_SIZE + n * MANIFEST_STEP_SIZE, stage, cache, parsed);
+}
+
+static void Manifest_Line(char **t, int n, FILE *out) {
+    RawStep s[16];
+    uint32_t k;
+    if (strcmp(t[0], "build") == 0) {
+        // build STAGE CACHE DATALEN|- CRCXOR kind:arg:length[:value:mask] ...
+        int i;
+        k = 0;
+        for (i = 5; i < n && k < 16; i++, k++) {
+            char *p = t[i];
+            memset(&s[k], 0, sizeof(s[k]));
+            s[k].op = Num(p);
+            if ((p = strchr(p, ':'))) s[k].op |= Num(p + 1) << 8;
+            if (p && (p = strchr(p + 1, ':'))) s[k].length = Num(p + 1);
+            if (p && (p = strchr(p + 1, ':'))) s[k].value = Hex(p + 1);
+            if (p && (p = strchr(p + 1, ':'))) s[k].mask = Hex(p + 1);
+        }
+        fprintf(out, "build %d\n", Manifest_Check(s, k, Num(t[1]), Num(t[2]), strcmp(t[3], "-") == 0, Num(t[3]), Hex(t[4])));
+    } else if (strcmp(t[0], "fuzz") == 0) {
+        // Tables of 1 .. 9 steps, kinds 0 .. 7, lengths from around the limits
+        static const uint32_t Lengths[8] = { 0, 0, 4, 6, 2048, 16384, 16388, 65536 };
+        uint32_t count = Num(t[2]), valid = 0, hash = 2166136261u, j;
+        lcg = Num(t[1]);
+        for (k = 0; k < count; k++) {
+            uint32_t steps = Next() % 9 + 1;
+            int r;
+            for (j = 0; j < steps; j++) {
+                s[j].op = Next() % 8;
+                s[j].op |= (Next() % 4) << 8;
+                s[j].length = Lengths[Next() % 8];
+                s[j].value = s[j].mask = 0;
+            }
+            r = Manifest_Check(s, steps, 16384, 65536, 1, 0, 0);
+            if (r) valid++;
+            hash = Fnv(hash, (uint8_t)r);
+        }
+        fprintf(out, "fuzz %u %08X\n", valid, hash);
+    }
+}
+
+// --- FILES ---
+typedef void (*LineFn)(char **t, int n, FILE *out);
+static const struct { const char *unit; LineFn fn; } Units[] = {
+    { "cmd_link", Cmd_Line }, { "ring_monitor", Ring_Line }, { "baud_link", Baud_Line },
+    { "profiler", Prof_Line }, { "manifest", Manifest_Line },
+};
+
+static char *Read_All(const char *path) {
+    FILE *f = fopen(path, "rb");
+    char *buf;
+    long n;
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END); n = ftell(f); fseek(f, 0, SEEK_SET);
+    buf = malloc((size_t)n + 1);
+    if (fread(buf, 1, (size_t)n, f) != (size_t)n) n = 0;
+    buf[n] = 0;
+    fclose(f);
+    return buf;
+}
+
+static void Run(const char *unit, LineFn fn, int write) {
+    char path[256], line[4096], *t[MAX_TOKENS], *got = NULL, *want;
+    size_t gotLen = 0;
+    FILE *in, *out;
+    snprintf(path, sizeof(path), "tests/vectors/%s.vec", unit);
+    in = fopen(path, "r");
+    CHECK(in != NULL);
+    if (!in) return;
+    out = open_memstream(&got, &gotLen);
+    while (fgets(line, sizeof(line), in)) {
+        int n = 0;
+        char *tok = strtok(line, " \t\r\n");
+        while (tok && n < MAX_TOKENS) { t[n++] = tok; tok = strtok(NULL, " \t\r\n"); }
+        if (n == 0 || t[0][0] == '#') continue;
+        fn(t, n, out);
+    }
+    fclose(in);
+    fclose(out);
+
+    snprintf(path, sizeof(path), "tests/vectors/%s.out", unit);
+    if (write) {
+        FILE *f = fopen(path, "w");
+        CHECK(f != NULL);
+        if (f) { fputs(got, f); fclose(f); }
+    } else if (!(want = Read_All(path))) {
+        CHECK(!"missing .out");
+    } else {
+        if (strcmp(got, want) != 0) fprintf(stderr, "%s: output differs from %s\n", unit, path);
+        CHECK(strcmp(got, want) == 0);
+        free(want);
+    }
+    free(got);
+}
+
+int main(int argc, char **argv) {
+    int write = argc > 1 && strcmp(argv[1], "-w") == 0;
+    size_t i;
+    for (i = 0; i < sizeof(Units) / sizeof(Units[0]); i++) Run(Units[i].unit, Units[i].fn, write);
+    return CHECK_DONE();
+}
@@ -0,0 +1,110 @@
+/*
+ * Wire image: the pre-split stream puts exactly the same DR bits into the
+ * TAP as the raw bitstream, with no byte held back in the ring
+ */
+
+#include "check.h"
+#include "gowin_tap.h"
+#include "host_file.h"
+#include "jtag_master.h"
+#include "mcu_sim.h"
+#include "pipeline.h"
+#include "wire_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void Test_Header(void) {
+    uint8_t bits[5] = { 1, 2, 3, 4, 0xA5 }, img[32];
+    WireHeader h;
+
+    CHECK_EQ(WireImage_Build(bits, 5, img, sizeof(img)), WIRE_HEADER_SIZE + 4);
+    CHECK_EQ(WireImage_Build(bits, 5, img, WIRE_HEADER_SIZE + 3), 0);
+    CHECK_EQ(WireImage_Build(bits, 0, img, sizeof(img)), 0);
+    CHECK_EQ(WireImage_Build(bits, 5, img, sizeof(img)), WIRE_HEADER_SIZE + 4);
+    CHECK(WireImage_Parse(img, &h));
+    CHECK_EQ(h.bodyLength, 4);
+    CHECK_EQ(h.tail, 0xA5);
+    CHECK_EQ(memcmp(img + WIRE_HEADER_SIZE, bits, 4), 0);
+
+    img[12] ^= 1;                     // Check word
+    CHECK(!WireImage_Parse(img, &h));
+    img[12] ^= 1;
+    img[9] = 1;                       // Tail above one byte, check word fixed up
+    img[13] ^= 1;
+    CHECK(!WireImage_Parse(img, &h));
+    memset(img, 0xFF, WIRE_HEADER_SIZE);   // A Gowin bitstream opens with 0xFF
+    CHECK(!WireImage_Parse(img, &h));
+}
+
+// Feeds `data` through a 512-byte ring in uneven pieces; returns the pump
+static void Pump(const uint8_t *data, size_t len, GowinTap *t, JtagMaster *m, McuPump *p, McuRing *r, int wire) {
+    size_t off = 0, step = 1;
+    GowinTap_Init(t);
+    Jtag_Init(m, GowinTap_ClockFn, t);
+    Jtag_ResetTap(m);
+    Jtag_InitConfiguration(m);
+    McuRing_Init(r, 512);
+    McuPump_Begin(p, r, m);
+    while (off < len) {
+        uint32_t room;
+        uint8_t *dst = McuRing_WriteSpan(r, &room);
+        size_t n = step < room ? step : room;
+        if (n > len - off) n = len - off;
+        memcpy(dst, data + off, n);
+        McuRing_Commit(r, (uint32_t)n);
+        off += n;
+        McuPump_Drain(p);
+        // Past the header the wire pump empties the ring every time
+        if (wire && off >= WIRE_HEADER_SIZE) CHECK_EQ(McuRing_Level(r), 0);
+        if (!wire) CHECK_EQ(McuRing_Level(r), 1);
+        step = step * 7 % 1021 + 1;
+    }
+    if (wire) CHECK(McuPump_BodyDone(p));
+    McuPump_Finish(p);
+}
+
+static void Test_Same_Bits(const uint8_t *bits, size_t len) {
+    static GowinTap a, b;
+    JtagMaster ma, mb;
+    McuRing ra, rb;
+    McuPump pa, pb;
+    uint8_t *img = malloc(WIRE_HEADER_SIZE + len);
+    size_t imgLen = WireImage_Build(bits, len, img, WIRE_HEADER_SIZE + len);
+
+    CHECK_EQ(imgLen, WIRE_HEADER_SIZE + len - 1);
+    Pump(bits, len, &a, &ma, &pa, &ra, 0);
+    Pump(img, imgLen, &b, &mb, &pb, &rb, 1);
+
+    CHECK_EQ(pa.mode, PUMP_RAW);
+    CHECK_EQ(pb.mode, PUMP_WIRE);
+    CHECK_EQ(pb.sent, pa.sent);
+    CHECK_EQ(b.diagStreamBits, a.diagStreamBits);
+    CHECK_EQ(b.diagStreamBits, len * 8);
+    CHECK_EQ(mb.tckCount, ma.tckCount);
+    CHECK_EQ(b.leds, a.leds);
+    CHECK(b.leds & LED_PROG_5);
+    McuRing_Free(&ra); McuRing_Free(&rb);
+
+    // Over ptys the session ends on the byte count, not on the idle timeout
+    {
+        PipeConfig c = { PIPE_BITSTREAM, img, imgLen, 4096, 1000, 0, 200, 0 };
+        PipeResult r;
+        CHECK_EQ(Pipeline_Run(&c, &r), 0);
+        CHECK(r.pass);
+        CHECK_EQ(r.streamBits, len * 8);
+        CHECK(r.tailMs < 200.0);
+    }
+    free(img);
+}
+
+int main(void) {
+    size_t len = 0;
+    uint8_t *bits = HostFile_Load("../JTAG_Programmer_Serial/output1.bin", &len);
+    CHECK(bits != NULL);
+    Test_Header();
+    if (bits) Test_Same_Bits(bits, len);
+    free(bits);
+    return CHECK_DONE();
+}
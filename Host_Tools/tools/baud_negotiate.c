@@ -0,0 +1,56 @@
+/*
+ * Baud negotiation with the programmer
+ * - Sends `baud` on the command line at the rate both sides are at now
+ *   (-b, default the power-up 230400), then steps up the candidates in
+ *   baud_link.ads until a test pattern comes back with an error either
+ *   way, or -t (the fastest the port takes) is reached
+ * - Leaves the port at the rate agreed, so a `cat` or chunk_send after it
+ *   runs there; the programmer keeps it until it is reset
+ * usage: baud_negotiate [-b baud] [-t top_baud] /dev/ttyACM0
+ */
+
+#include "baud_host.h"
+#include "pty_link.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+    const char *port = NULL;
+    unsigned long baud = 230400, top = 3000000;
+    int base, last, fd, i;
+    struct timespec t0, t1;
+    BaudHost h;
+    BaudHostState st;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) baud = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) top = strtoul(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-') port = argv[i];
+    }
+    if (!port) { fprintf(stderr, "usage: baud_negotiate [-b baud] [-t top_baud] /dev/ttyACM0\n"); return 2; }
+    if ((base = BaudLink_Index((uint32_t)baud)) < 0 || (last = BaudLink_Index((uint32_t)top)) < base) {
+        fprintf(stderr, "rates are");
+        for (i = 0; i < (int)BAUD_COUNT; i++) fprintf(stderr, " %u", BaudLink_Rates[i]);
+        fprintf(stderr, "\n");
+        return 2;
+    }
+    if ((fd = PtyLink_OpenPort(port)) < 0) { perror(port); return 1; }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    st = BaudHost_Port(&h, fd, (uint8_t)base, (uint8_t)last);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for (i = base + 1; i <= last; i++) {
+        if (h.mcuErrors[i] < 0) break;
+        printf("%8u  mcu_errors %3d  host_errors %3d  %s\n", BaudLink_Rates[i], h.mcuErrors[i], h.hostErrors[i],
+               h.mcuErrors[i] == 0 && h.hostErrors[i] == 0 ? "ok" : "bad");
+    }
+    printf("%s %u baud in %.2f s (%u retries%s)\n", BaudHost_StateName(st), BaudLink_Rates[h.rate],
+           (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9, h.retries,
+           h.confirmsLost ? ", the new rate did not confirm" : "");
+    close(fd);
+    return st == BHOST_DONE ? 0 : 1;
+}
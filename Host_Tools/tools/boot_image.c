@@ -0,0 +1,76 @@
+/*
+ * Boot cache image builder / checker
+ * - Builds the image the firmware looks for in the top Cache_Size bytes
+ *   of flash (boot_cache.ads), and prints where to flash it
+ * - Checks an image the way the firmware does at power-up and simulates
+ *   the load into the Gowin TAP model
+ * usage: boot_image [-a area_bytes] -o cache.img bitstream.bin
+ *        boot_image [-a area_bytes] -c cache.img
+ */
+
+#include "boot_cache.h"
+#include "host_file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BITBANG_HZ 1e6   // Pulse_TCK through hal at 48 MHz, roughly
+
+static int Build(const char *out, const char *in, size_t area) {
+    size_t len, size;
+    uint8_t *bits = HostFile_Load(in, &len), *image = malloc(area);
+    FILE *f;
+    if (!bits) { perror(in); return 1; }
+    if (!(size = BootCache_Build(bits, len, image, area))) {
+        fprintf(stderr, "%s: %zu bytes, image needs %u of a %zu-byte area (TOO_LARGE)\n",
+                in, len, BOOT_HEADER_SIZE + BootCache_Padded((uint32_t)len), area);
+        return 1;
+    }
+    if (!(f = fopen(out, "wb")) || fwrite(image, 1, size, f) != size) { perror(out); return 1; }
+    fclose(f);
+    printf("%s: %zu bytes, crc 0x%08X\n", out, size, BootCache_Crc32(image + BOOT_HEADER_SIZE, BootCache_Padded((uint32_t)len)));
+    printf("flash at 0x%08X (Cache_Size %zu)\n", BOOT_FLASH_END - (unsigned)area, area);
+    free(bits); free(image);
+    return 0;
+}
+
+static int Check(const char *in, size_t area) {
+    static const double spi[] = { 12e6, 24e6 };
+    size_t len, i;
+    uint8_t *img = HostFile_Load(in, &len), *flash = malloc(area);
+    BootReport r;
+    if (!img) { perror(in); return 1; }
+
+    // Flash past the end of the image is erased
+    memset(flash, 0xFF, area);
+    memcpy(flash, img, len < area ? len : area);
+    for (i = 0; i < sizeof(spi) / sizeof(spi[0]); i++) {
+        BootCache_Boot(flash, area, spi[i], BITBANG_HZ, &r);
+        if (i == 0) printf("decision %s\n", BootAction_Name(r.result));
+        if (r.result != BOOT_LOAD) return 1;
+        if (i == 0) printf("bytes %u tck %llu stream_bits %llu status 0x%08X %s\n", r.bytes,
+                           (unsigned long long)r.tck, (unsigned long long)r.streamBits, r.status, r.done ? "DONE" : "FAIL");
+        printf("spi %2.0f MHz: crc_us %.0f load_us %.0f\n", spi[i] / 1e6, r.crcUs, r.loadUs);
+    }
+    free(img); free(flash);
+    return r.done ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    size_t area = BOOT_AREA_DEFAULT;
+    const char *out = NULL, *check = NULL;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) area = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) check = argv[++i];
+        else if (out && argv[i][0] != '-') return Build(out, argv[i], area);
+        else break;
+    }
+    if (check) return Check(check, area);
+    fprintf(stderr, "usage: boot_image [-a area_bytes] -o cache.img bitstream.bin\n"
+                    "       boot_image [-a area_bytes] -c cache.img\n");
+    return 2;
+}
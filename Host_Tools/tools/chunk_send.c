@@ -0,0 +1,63 @@
+/*
+ * Chunked bitstream upload
+ * - Sends a bitstream to the programmer in numbered, CRC-checked chunks
+ *   (chunk_link.ads) after `config`, in place of `cat output1.bin`; only
+ *   the chunks the MCU NAKs or never answers go again
+ * - Picks up a session the last run left half-way: the MCU's reply to the
+ *   first probe says which chunk it needs next (same -c as before)
+ * - The port is set raw at the baud given (stty -F port baud raw -echo)
+ * usage: chunk_send [-c chunk] [-w window] [-b baud] /dev/ttyACM0 bitstream.bin
+ */
+
+#include "chunk_send.h"
+#include "host_file.h"
+#include "pty_link.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+    const char *port = NULL, *in = NULL;
+    unsigned long chunk = 256, window = 0, baud = 0;
+    ChunkSender s;
+    ChunkSendState st;
+    struct timespec t0, t1;
+    uint8_t *bits;
+    size_t len;
+    double secs;
+    int fd, i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) chunk = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) window = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) baud = strtoul(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-' && !port) port = argv[i];
+        else if (argv[i][0] != '-') in = argv[i];
+    }
+    if (!port || !in) { fprintf(stderr, "usage: chunk_send [-c chunk] [-w window] [-b baud] /dev/ttyACM0 bitstream.bin\n"); return 2; }
+    if (!(bits = HostFile_Load(in, &len))) { perror(in); return 1; }
+    if (ChunkSender_Init(&s, bits, len, (uint32_t)chunk) < 0) {
+        fprintf(stderr, "chunk must be 1 .. %u and the file at most 65535 chunks\n", CHUNK_MAX);
+        return 2;
+    }
+    if (window) s.window = window < CHUNK_SLOTS ? (uint32_t)window : CHUNK_SLOTS;
+    if ((fd = PtyLink_OpenPort(port)) < 0) { perror(port); return 1; }
+    if (baud && PtyLink_SetBaud(fd, (uint32_t)baud) < 0) { fprintf(stderr, "%s: cannot set %lu baud\n", port, baud); return 1; }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    st = ChunkSend_Port(&s, fd, 0);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    secs = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+    printf("%s %s: %u chunks of %lu from %u, window %u, %u frames (%u resent: %u NAK, %u timeout), %u probes\n",
+           in, ChunkSender_StateName(st), s.count, chunk, s.resumedAt, s.window, s.frames, s.resent, s.naks, s.rtos, s.probes);
+    printf("%llu bytes on the wire (%.1f %% over the file), %.2f s, %.0f bytes/s\n",
+           (unsigned long long)s.bytes, 100.0 * ((double)s.bytes - (double)len) / (double)len, secs,
+           secs > 0 ? (double)(len - (size_t)s.resumedAt * chunk) / secs : 0.0);
+    close(fd);
+    ChunkSender_Free(&s);
+    free(bits);
+    return st == SEND_DONE ? 0 : 1;
+}
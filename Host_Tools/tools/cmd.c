@@ -0,0 +1,116 @@
+/*
+ * Binary commands to the programmer
+ * - Sends `bin` on the command line, then every request named on the
+ *   command line back to back, each with its own tag, and prints the
+ *   responses as they come: opcode, tag, status and the payload's words
+ * - A request is an opcode name (ping, chain, status, prof, rings, boot,
+ *   ...) or select=N / fanout=N. Config, upload, dmload, sspi and baud take
+ *   the line for their data, so they are left to the tools that send it
+ * - Ends with `text`, back to the command line, unless -k
+ * usage: cmd [-b baud] [-k] /dev/ttyACM0 request ...
+ */
+
+#include "cmd_link.h"
+#include "pty_link.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAX_REQUESTS 64
+#define TIMEOUT_MS   2000
+
+// The command line's answer to `bin`, then the binary side begins
+static int Enter(int fd) {
+    static const uint8_t Command[] = "bin\r";
+    char line[128];
+    size_t n = 0;
+    if (PtyLink_WriteAll(fd, Command, sizeof(Command) - 1) < 0) return -1;
+    for (;;) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        char c;
+        if (poll(&p, 1, TIMEOUT_MS) <= 0 || read(fd, &c, 1) != 1) return -1;
+        if (c != '\n') {
+            if (n < sizeof(line) - 1) line[n++] = c;
+            continue;
+        }
+        line[n] = 0;
+        n = 0;
+        if (strncmp(line, "bin ", 4) == 0) return atoi(line + 4) == (int)CMD_VERSION ? 0 : -1;
+    }
+}
+
+static void Put(const CmdParser *r) {
+    unsigned i;
+    printf("%-6s tag %3u %-8s", CmdLink_OpName(r->op), r->tag, CmdLink_StatusName(r->status));
+    for (i = 0; i + 4 <= r->len; i += 4) printf(" %08X", CmdLink_Word(r->payload, i / 4));
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    const char *port = NULL, *req[MAX_REQUESTS];
+    unsigned long baud = 0;
+    uint8_t out[MAX_REQUESTS * CMD_MAX_FRAME], buf[256];
+    int nreq = 0, keep = 0, fd, i, pending = 0, failed = 0;
+    size_t n = 0;
+    CmdParser r;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) baud = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-k") == 0) keep = 1;
+        else if (!port) port = argv[i];
+        else if (nreq < MAX_REQUESTS - 1) req[nreq++] = argv[i];
+    }
+    if (!port || nreq == 0) {
+        fprintf(stderr, "usage: cmd [-b baud] [-k] /dev/ttyACM0 request ...\n");
+        return 2;
+    }
+    // Requests first, so a typo costs nothing on the line
+    for (i = 0; i < nreq; i++) {
+        char name[16];
+        const char *eq = strchr(req[i], '=');
+        size_t k = eq ? (size_t)(eq - req[i]) : strlen(req[i]);
+        uint8_t arg = eq ? (uint8_t)atoi(eq + 1) : 0;
+        int op = -1;
+        if (k < sizeof(name)) {
+            memcpy(name, req[i], k);
+            name[k] = 0;
+            op = CmdLink_OpByName(name);
+        }
+        if (op < 0 || op == CMD_CONFIG || op == CMD_UPLOAD || op == CMD_DMLOAD || op == CMD_SSPI ||
+            op == CMD_BAUD || op == CMD_TEXT || (eq != NULL) != (op == CMD_SELECT || op == CMD_FANOUT)) {
+            fprintf(stderr, "cmd: cannot pipeline %s\n", req[i]);
+            return 2;
+        }
+        n += CmdLink_Request((uint8_t)op, (uint8_t)i, &arg, eq ? 1 : 0, out + n);
+    }
+    if (!keep) n += CmdLink_Request(CMD_TEXT, (uint8_t)nreq++, NULL, 0, out + n);
+
+    if ((fd = PtyLink_OpenPort(port)) < 0) { perror(port); return 1; }
+    if (baud && PtyLink_SetBaud(fd, (uint32_t)baud) < 0) { perror("baud"); return 1; }
+    if (Enter(fd) < 0) { fprintf(stderr, "cmd: no binary mode on %s\n", port); close(fd); return 1; }
+    if (PtyLink_WriteAll(fd, out, n) < 0) { perror("write"); close(fd); return 1; }
+
+    CmdParser_Init(&r, 1);
+    for (pending = nreq; pending > 0;) {
+        struct pollfd p = { fd, POLLIN, 0 };
+        ssize_t got;
+        int rc = poll(&p, 1, TIMEOUT_MS);
+        if (rc < 0 && errno == EINTR) continue;
+        if (rc <= 0 || (got = read(fd, buf, sizeof(buf))) <= 0) break;
+        for (i = 0; i < got; i++) {
+            CmdVerdict v = CmdParser_Feed(&r, buf[i]);
+            if (v == CMDV_NONE) continue;
+            if (v != CMDV_GOOD) { printf("bad response\n"); failed++; continue; }
+            Put(&r);
+            if (r.status != CMD_OK) failed++;
+            pending--;
+        }
+    }
+    close(fd);
+    if (pending) fprintf(stderr, "cmd: %d response(s) missing\n", pending);
+    return pending || failed ? 1 : 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * JTAG command sequence optimizer
+ * - Builds the firmware session (reset, Init_Configuration, bitstream,
+ *   Finish_Configuration) as ops, optimizes it against the Gowin TAP model
+ *   and prints the TCKs before and after
+ * - -n devices in the chain, -t the target (0 nearest TDO); -v lists every
+ *   op with its TCKs both ways
+ * - Without a bitstream, a pattern just over MIN_STREAM_BITS is streamed
+ * - Exits 1 if the optimized session does not replay the same
+ * usage: jtag_opt [-n devices] [-t target] [-v] [bitstream.bin]
+ */
+
+#include "gowin_tap.h"
+#include "host_file.h"
+#include "jtag_opt.h"
+#include "tap_chain.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t *Pattern(size_t *len) {
+    uint8_t *buf;
+    *len = MIN_STREAM_BITS / 8 + 1024;
+    buf = malloc(*len);
+    for (size_t i = 0; i < *len; i++) buf[i] = (uint8_t)(i * 37);
+    return buf;
+}
+
+static void Tcks(const JtagSeq *s, int devices, int target, uint32_t *tcks) {
+    TapChain chain;
+    JtagMaster m;
+    int i;
+    TapChain_Init(&chain);
+    for (i = 0; i < devices; i++) TapChain_AddGowin(&chain);
+    Jtag_Init(&m, TapChain_ClockFn, &chain);
+    m.count = devices;
+    for (i = 0; i < devices; i++) m.dev[i].irLength = JTAG_GOWIN_IR_LEN;
+    m.active = target;
+    JtagSeq_Play(&m, s, NULL, tcks);
+}
+
+static void List(const JtagSeq *in, const JtagSeq *out, const JtagOptReport *r, int devices, int target) {
+    static const char *const exits[] = { "direct", "idle", "" };
+    uint32_t before[JTAG_SEQ_MAX], after[JTAG_SEQ_MAX];
+    int i, j = 0;
+
+    Tcks(in, devices, target, before);
+    Tcks(out, devices, target, after);
+    printf("%-4s %-8s %-8s %8s %8s  %s\n", "op", "kind", "arg", "before", "after", "exit");
+    for (i = 0; i < in->n; i++) {
+        const JtagOp *op = &in->op[i];
+        char arg[16] = "";
+        if (op->kind == JOP_COMMAND) snprintf(arg, sizeof(arg), "0x%02X", op->instr);
+        else if (op->kind != JOP_RESET) snprintf(arg, sizeof(arg), "%zu%s", op->n, op->keep ? " kept" : "");
+        if (r->dropped[i]) { printf("%-4d %-8s %-8s %8u %8s\n", i, JtagOp_Name(op), arg, before[i], "dropped"); continue; }
+        printf("%-4d %-8s %-8s %8u %8u  %s\n", i, JtagOp_Name(op), arg, before[i], after[j],
+               (op->kind == JOP_COMMAND || op->kind == JOP_SCAN) ? exits[out->op[j].exit] : "");
+        j++;
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int devices = 1, target = 0, verbose = 0, i;
+    JtagSeq in, out;
+    JtagOptReport r;
+    uint64_t body;
+    uint8_t *bits;
+    size_t len;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) devices = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) target = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-v") == 0) verbose = 1;
+        else path = argv[i];
+    }
+    if (devices < 1 || devices >= JTAG_MAX_DEVICES || target < 0 || target >= devices) {
+        fprintf(stderr, "usage: jtag_opt [-n devices] [-t target] [-v] [bitstream.bin]\n");
+        return 2;
+    }
+    if (!path) bits = Pattern(&len);
+    else if (!(bits = HostFile_Load(path, &len))) { perror(path); return 1; }
+    JtagSeq_Init(&in);
+    if (JtagSeq_Session(&in, bits, len) != 0) { fprintf(stderr, "session does not fit\n"); return 1; }
+
+    JtagOpt_Run(&in, &out, devices, target, &r);
+    if (verbose) List(&in, &out, &r, devices, target);
+
+    // The SPI body is the same either way: the rest is what the optimizer works on
+    body = len ? (uint64_t)(len - 1) * 8 : 0;
+    printf("bitstream: %zu bytes, %d device(s), target %d\n", len, devices, target);
+    printf("ops:        %d -> %d\n", r.opsBefore, r.opsAfter);
+    printf("tck:        %llu -> %llu\n", (unsigned long long)r.tckBefore, (unsigned long long)r.tckAfter);
+    printf("bit-banged: %llu -> %llu (%.1f%% fewer)\n",
+           (unsigned long long)(r.tckBefore - body), (unsigned long long)(r.tckAfter - body),
+           r.tckBefore > body ? 100.0 * (double)(r.tckBefore - r.tckAfter) / (double)(r.tckBefore - body) : 0.0);
+    printf("dropped:    %d NOOP(s), %d status read(s)\n", r.noops, r.reads);
+    printf("walks:      %d left in Update for the next scan, %d back to Idle without the extra pulse\n", r.direct, r.trimmed);
+    printf("replay:     %s (%d trials)\n", r.equivalent ? "same end state and kept reads" : "DIFFERENT", r.trials);
+    free(bits);
+    return r.equivalent ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+/*
+ * JTAG trace capture to VCD
+ * - Reads the JTAG emulator's log captured in trace mode (S1 held at reset)
+ * - Prints achieved TCK frequency, duty cycle, scans and the longest gaps
+ *   between scans with the command that preceded each one
+ * - -o writes a VCD (tck, tms, tdi, tdo, tap_state, event) for GTKWave
+ * usage: jtag_vcd [-g min_gap_us] [-o out.vcd] [capture.bin | -]
+ * Capture: stty -F /dev/ttyACM0 115200 raw; cat /dev/ttyACM0 > capture.bin
+ */
+
+#include "jtag_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    const char *path = "-", *vcdPath = NULL;
+    double minGapUs = 0;
+    JtagTraceStats st;
+    LogDecoder d;
+    LogRecord rec;
+    JtagTrace t;
+    FILE *f, *out;
+    int c, i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) minGapUs = atof(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) vcdPath = argv[++i];
+        else path = argv[i];
+    }
+
+    f = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!f) { fprintf(stderr, "cannot read %s\n", path); return 2; }
+
+    LogDecoder_Init(&d);
+    JtagTrace_Init(&t);
+    while ((c = getc(f)) != EOF)
+        if (LogDecoder_Push(&d, (uint8_t)c, &rec)) JtagTrace_Add(&t, &rec);
+    if (f != stdin) fclose(f);
+
+    if (!t.edges) {
+        fprintf(stderr, "no TCK edges in the capture (%s)\n",
+                t.traceOn ? "nothing clocked" : "was S1 held at reset?");
+        JtagTrace_Free(&t);
+        return 1;
+    }
+
+    JtagTrace_Analyze(&t, (uint64_t)(minGapUs * LOG_TICK_HZ / 1e6), &st);
+    JtagTrace_PrintStats(&t, &st, stdout);
+    if (d.badRecords) printf("corrupt records    %u\n", (unsigned)d.badRecords);
+
+    if (vcdPath) {
+        out = fopen(vcdPath, "w");
+        if (!out) { fprintf(stderr, "cannot write %s\n", vcdPath); JtagTrace_Free(&t); return 2; }
+        JtagTrace_WriteVcd(&t, out);
+        fclose(out);
+    }
+    JtagTrace_Free(&t);
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*
+ * Emulator UART log decoder
+ * - Turns the binary records of JTAG_Emulator / SSPI_Emultaor back into the
+ *   lines they used to print, each with its time since boot
+ * - The emulator is picked from the boot record; -s overrides it when the
+ *   capture starts mid-session
+ * usage: log_decode [-s jtag|sspi] [capture.bin | /dev/ttyACM0 | -]
+ * Set the port up first: stty -F /dev/ttyACM0 9600 raw (115200 in trace capture)
+ */
+
+#include "log_decode.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    const char *path = "-";
+    int src = LOG_SRC_JTAG, forced = 0, c, i;
+    uint64_t ticks = 0;
+    LogDecoder d;
+    LogRecord rec;
+    char line[160];
+    FILE *f;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "jtag") == 0) src = LOG_SRC_JTAG;
+            else if (strcmp(argv[i], "sspi") == 0) src = LOG_SRC_SSPI;
+            else { fprintf(stderr, "unknown emulator %s\n", argv[i]); return 2; }
+            forced = 1;
+        }
+        else path = argv[i];
+    }
+
+    f = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!f) { fprintf(stderr, "cannot read %s\n", path); return 2; }
+
+    LogDecoder_Init(&d);
+    while ((c = getc(f)) != EOF) {
+        if (!LogDecoder_Push(&d, (uint8_t)c, &rec)) continue;
+        if (rec.id == LOG_ID_BOOT) {
+            ticks = 0;
+            c = (int)(rec.arg & LOG_SRC_MASK);
+            if (!forced && (c == LOG_SRC_JTAG || c == LOG_SRC_SSPI)) src = c;
+        } else {
+            ticks += rec.dt;
+        }
+        LogText_Format(src, &rec, line, sizeof(line));
+        printf("%12.3f ms  %s\n", (double)ticks * 1000.0 / LOG_TICK_HZ, line);
+        fflush(stdout);
+    }
+    if (f != stdin) fclose(f);
+
+    fprintf(stderr, "%" PRIu32 " records, %" PRIu32 " bad, %" PRIu32 " bytes skipped\n",
+            d.records, d.badRecords, d.skipped);
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Programming manifest builder
+ * - One file for a whole run (manifest.ads), steps in this order: check
+ *   the chain's IDCODE (-i), load SRAM (-b) and verify DONE, write a boot
+ *   image of -c into the MCU's flash and verify it, stage the executable
+ *   (-f) and start it (-d debug module, -u bootloader, -n not at all)
+ * - -v value/mask: what the SRAM verify wants of the status register
+ *   besides DONE. -i id[/mask][@position], position 1 nearest TDO
+ * - -r runs it on the simulated board (a Gowin TAP, the debug TAP behind
+ *   it) and prints what the `manifest` line would say
+ * - Send it after `config` like any image
+ * usage: manifest -o run.mf [-i id[/mask][@pos]] [-b bits.bin [-v value/mask]]
+ *                 [-c bits.bin [-a area]] [-f fw.exe [-d|-u|-n]] [-r]
+ */
+
+#include "boot_cache.h"
+#include "hal_target.h"
+#include "host_file.h"
+#include "manifest.h"
+#include "mcu_manifest.h"
+#include "session_image.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const kinds[] = { "?", "idcode", "sram", "flash", "verify", "load", "start" };
+
+static void Simulate(const uint8_t *m, size_t len, size_t area) {
+    uint8_t *cache = malloc(area), *stage = malloc(SESSION_STAGE_SIZE);
+    McuManifestReport r;
+    uint32_t i;
+    memset(cache, 0xFF, area);
+    HalTarget_Init(1);
+    HalTarget_UseDebug(1);
+    McuManifest_Run(m, len, cache, (uint32_t)area, stage, SESSION_STAGE_SIZE, &r);
+    printf("manifest %s step %u of %u idcode 0x%08X status 0x%08X bytes %u flashed %u staged %u\n",
+           Manifest_OutcomeName(r.result), r.step, r.steps, r.idcode, r.status, r.bytes, r.flashed, r.staged);
+    for (i = 0; i < r.step; i++) printf("  step %u: %" PRIu64 " TCKs\n", i + 1, r.stepTck[i]);
+    if (r.start != RVDBG_SKIPPED) printf("  start: %s\n", RvDebug_ResultName(r.start));
+    free(cache);
+    free(stage);
+}
+
+int main(int argc, char **argv) {
+    const char *out = NULL, *id = NULL, *sram = NULL, *flash = NULL, *fw = NULL, *verify = NULL;
+    ManifestStep s[MANIFEST_MAX_STEPS];
+    uint8_t *bits = NULL, *cacheBits = NULL, *image = NULL, *exe = NULL, *m;
+    size_t bitsLen = 0, cacheLen = 0, imageLen = 0, exeLen = 0, area = BOOT_AREA_DEFAULT, size;
+    int n = 0, start = MF_START_DEFAULT, run = 0, i;
+    FILE *f;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) id = argv[++i];
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) sram = argv[++i];
+        else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) verify = argv[++i];
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) flash = argv[++i];
+        else if (strcmp(argv[i], "-a") == 0 && i + 1 < argc) area = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) fw = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0) start = MF_START_DEBUG;
+        else if (strcmp(argv[i], "-u") == 0) start = MF_START_BOOTLOADER;
+        else if (strcmp(argv[i], "-n") == 0) start = -1;
+        else if (strcmp(argv[i], "-r") == 0) run = 1;
+    }
+    if (!out || !(id || sram || flash || fw)) {
+        fprintf(stderr, "usage: manifest -o run.mf [-i id[/mask][@pos]] [-b bits.bin [-v value/mask]]\n"
+                        "                [-c bits.bin [-a area]] [-f fw.exe [-d|-u|-n]] [-r]\n");
+        return 2;
+    }
+    memset(s, 0, sizeof(s));
+
+    if (id) {
+        const char *p;
+        s[n].kind = MF_IDCODE;
+        s[n].value = (uint32_t)strtoul(id, NULL, 0);
+        s[n].mask = (p = strchr(id, '/')) ? (uint32_t)strtoul(p + 1, NULL, 0) : 0xFFFFFFFFu;
+        s[n].arg = (p = strchr(id, '@')) ? (uint8_t)strtoul(p + 1, NULL, 0) : 0;
+        n++;
+    }
+    if (sram) {
+        const char *p;
+        if (!(bits = HostFile_Load(sram, &bitsLen))) { perror(sram); return 1; }
+        s[n].kind = MF_SRAM;
+        s[n].length = (uint32_t)bitsLen;
+        s[n++].data = bits;
+        s[n].kind = MF_VERIFY;
+        if (verify) {
+            s[n].value = (uint32_t)strtoul(verify, NULL, 0);
+            s[n].mask = (p = strchr(verify, '/')) ? (uint32_t)strtoul(p + 1, NULL, 0) : 0xFFFFFFFFu;
+        }
+        n++;
+    }
+    if (flash) {
+        if (!(cacheBits = HostFile_Load(flash, &cacheLen))) { perror(flash); return 1; }
+        image = malloc(area ? area : 1);
+        if (!(imageLen = BootCache_Build(cacheBits, cacheLen, image, area))) {
+            fprintf(stderr, "%s: %zu bytes do not fit a %zu-byte boot image area\n", flash, cacheLen, area);
+            return 1;
+        }
+        s[n].kind = MF_FLASH;
+        s[n].length = (uint32_t)imageLen;
+        s[n++].data = image;
+        s[n++].kind = MF_VERIFY;
+    }
+    if (fw) {
+        if (!(exe = HostFile_Load(fw, &exeLen))) { perror(fw); return 1; }
+        s[n].kind = MF_LOAD;
+        s[n].length = (uint32_t)exeLen;
+        s[n].value = BootCache_Crc32(exe, exeLen);
+        s[n++].data = exe;
+        if (start >= 0) {
+            s[n].kind = MF_START;
+            s[n++].arg = (uint8_t)start;
+        }
+    }
+
+    size = Manifest_Size(s, n);
+    m = malloc(size);
+    if (!m || !Manifest_Build(s, n, m, size)) return 1;
+    if (!Manifest_Parse(m, size, SESSION_STAGE_SIZE, (uint32_t)area, s)) {
+        fprintf(stderr, "the board would refuse this manifest (executable unaligned or over %u bytes?)\n",
+                SESSION_STAGE_SIZE);
+        return 1;
+    }
+    if (!(f = fopen(out, "wb")) || fwrite(m, 1, size, f) != size || fclose(f)) { perror(out); return 1; }
+    printf("%s: %d steps, %zu bytes\n", out, n, size);
+    for (i = 0; i < n; i++)
+        printf("  %d %-6s arg %u length %u value 0x%08X mask 0x%08X\n",
+               i + 1, kinds[s[i].kind], s[i].arg, s[i].length, s[i].value, s[i].mask);
+    if (run) Simulate(m, size, area);
+    free(bits); free(cacheBits); free(image); free(exe); free(m);
+    return 0;
+}
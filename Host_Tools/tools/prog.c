@@ -0,0 +1,61 @@
+/*
+ * Programming daemon client
+ * - Sends one request to progd and prints the reply; files named in it
+ *   are passed as absolute paths, since the daemon has its own directory
+ * - `program` without ports programs every match of /dev/ttyACM*
+ * usage: prog [-s socket] add bitstream.bin [firmware.exe]
+ *        prog [-s socket] program <id|bitstream.bin> [port ...]
+ *        prog [-s socket] list | ports | stats | close <port> | shutdown
+ */
+
+#include "prog_daemon.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static int Append(char *req, size_t cap, const char *word) {
+    if (strlen(req) + strlen(word) + 2 > cap) return -1;
+    if (*req) strcat(req, " ");
+    strcat(req, word);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    static char req[8192], reply[65536];
+    static char paths[STATION_MAX_PORTS][64];
+    const char *sock = PROG_DAEMON_SOCKET;
+    char full[PATH_MAX];
+    int i = 1, k, n, status;
+
+    if (i + 1 < argc && strcmp(argv[i], "-s") == 0) { sock = argv[i + 1]; i += 2; }
+    if (i >= argc) {
+        fprintf(stderr, "usage: prog [-s socket] add|program|list|ports|stats|close|shutdown ...\n");
+        return 2;
+    }
+    for (k = i; k < argc; k++) {
+        // The files of add, the design of program
+        int file = (strcmp(argv[i], "add") == 0 && k > i) || (strcmp(argv[i], "program") == 0 && k == i + 1);
+        const char *w = file && access(argv[k], R_OK) == 0 && realpath(argv[k], full) ? full : argv[k];
+        if (Append(req, sizeof(req), w) < 0) { fprintf(stderr, "request too long\n"); return 2; }
+    }
+    if (strcmp(argv[i], "program") == 0 && argc - i == 2) {
+        n = Station_Discover("/dev/ttyACM*", paths, STATION_MAX_PORTS);
+        if (n == 0) { fprintf(stderr, "no ports match /dev/ttyACM*\n"); return 1; }
+        for (k = 0; k < n; k++) Append(req, sizeof(req), paths[k]);
+    }
+    if ((status = ProgDaemon_Request(sock, req, reply, sizeof(reply))) < 0) {
+        perror(sock);
+        return 1;
+    }
+    fputs(reply, stdout);
+    // program: ok only if every port reached DONE
+    if (status == 0 && strcmp(argv[i], "program") == 0) {
+        const char *last = strstr(reply, "\nok ");
+        int done, ports;
+        if (last && sscanf(last + 4, "%d/%d", &done, &ports) == 2 && done != ports) status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,48 @@
+/*
+ * Programming daemon: keeps the designs and the ports warm
+ * - Serves lib/prog_daemon.h on a Unix socket until `shutdown` (prog
+ *   shutdown); designs are cached under the cache directory and stay
+ *   there across restarts
+ * usage: progd [-s socket] [-d cachedir] [-c chunk] [-b baud]
+ *   defaults: /tmp/fpga-progd.sock, $HOME/.cache/fpga-prog, 256, the ports' own
+ */
+
+#include "prog_daemon.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+int main(int argc, char **argv) {
+    static ProgDaemon d;
+    const char *sock = PROG_DAEMON_SOCKET, *dir = NULL, *home = getenv("HOME");
+    char dflt[200];
+    unsigned long chunk = 256, baud = 0;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) sock = argv[++i];
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) dir = argv[++i];
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) chunk = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) baud = strtoul(argv[++i], NULL, 0);
+        else chunk = 0;
+    }
+    if (chunk == 0 || chunk > CHUNK_MAX) {
+        fprintf(stderr, "usage: progd [-s socket] [-d cachedir] [-c chunk] [-b baud]\n");
+        return 2;
+    }
+    if (!dir) {
+        snprintf(dflt, sizeof(dflt), "%s/.cache", home ? home : "/tmp");
+        if (mkdir(dflt, 0755) < 0 && errno != EEXIST) { perror(dflt); return 1; }
+        snprintf(dflt, sizeof(dflt), "%s/.cache/fpga-prog", home ? home : "/tmp");
+        dir = dflt;
+    }
+    if (ProgDaemon_Open(&d, sock, dir, (uint32_t)chunk, (uint32_t)baud) < 0) { perror(sock); return 1; }
+    printf("progd: %s, cache %s, chunk %lu\n", sock, dir, chunk);
+    fflush(stdout);
+    i = ProgDaemon_Serve(&d);
+    ProgDaemon_Close(&d);
+    return i < 0 ? 1 : 0;
+}
@@ -0,0 +1,49 @@
+/*
+ * Receive ring layout report
+ * - Reads the ring pool settings from the programmer's alire.toml and
+ *   prints the split ring_layout.ads makes at build time
+ * usage: ring_layout [-D Name=value]... [alire.toml]
+ *   -D overrides a setting, as `alr build` would with a configuration value
+ */
+
+#include "ring_layout.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    const char *path = "../JTAG_Programmer_Cmd_Call/alire.toml";
+    const char *overrides[16];
+    int nOverrides = 0, i;
+    RingConfig c;
+    RingLayout l;
+    FILE *f;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-D") == 0 && i + 1 < argc && nOverrides < 16) overrides[nOverrides++] = argv[++i];
+        else if (argv[i][0] != '-') path = argv[i];
+        else { fprintf(stderr, "usage: ring_layout [-D Name=value]... [alire.toml]\n"); return 2; }
+    }
+
+    RingConfig_Defaults(&c);
+    if (!(f = fopen(path, "r"))) { perror(path); return 1; }
+    if (RingConfig_ParseToml(&c, f) < 0) { fprintf(stderr, "%s: bad ring setting\n", path); fclose(f); return 1; }
+    fclose(f);
+
+    for (i = 0; i < nOverrides; i++) {
+        char name[64];
+        const char *eq = strchr(overrides[i], '=');
+        size_t n = eq ? (size_t)(eq - overrides[i]) : 0;
+        if (!eq || n >= sizeof(name)) { fprintf(stderr, "bad -D %s\n", overrides[i]); return 2; }
+        memcpy(name, overrides[i], n); name[n] = '\0';
+        if (RingConfig_Set(&c, name, eq + 1) <= 0) { fprintf(stderr, "bad -D %s\n", overrides[i]); return 2; }
+    }
+
+    printf("Ram_Size %u, Ram_Reserved %u, Window_Size %u\n", c.ramSize, c.ramReserved, c.windowSize);
+    if (RingLayout_Compute(&c, &l) < 0) {
+        fprintf(stderr, "ring pool too small: raise Ram_Size or lower Ram_Reserved / Window_Size\n");
+        return 1;
+    }
+    RingLayout_Print(&l, stdout);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+ * SSPI trace checker
+ * - Replays a timestamped SPI transaction trace through the SSPI target
+ *   model and prints sequence errors, timing violations and byte counts
+ * - -r records the programmer's own session (sspi.adb mirror) as a trace
+ *   on stdout and prints its report on stderr
+ * usage: sspi_check [-k sck_hz] [trace.txt | -]
+ *        sspi_check [-k sck_hz] -r [bitstream.bin]
+ * Exit status is 1 when any rule is broken.
+ */
+
+#include "sspi_check.h"
+#include "sspi_master.h"
+#include "sspi_record.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int Record(SspiChecker *c, const char *path) {
+    SspiRecorder rec;
+    SspiMaster m;
+    FILE *f = fopen(path, "rb");
+    uint8_t *bits;
+    long len;
+
+    if (!f) { fprintf(stderr, "cannot read %s\n", path); return 2; }
+    fseek(f, 0, SEEK_END); len = ftell(f); fseek(f, 0, SEEK_SET);
+    bits = malloc(len > 0 ? (size_t)len : 1);
+    if (fread(bits, 1, (size_t)len, f) != (size_t)len) { fclose(f); free(bits); return 2; }
+    fclose(f);
+
+    SspiRecorder_Init(&rec, c, stdout);
+    SspiMaster_Init(&m, &rec.bus);
+    SspiMaster_Program(&m, bits, (size_t)len);
+    free(bits);
+    SspiChecker_Print(c, stderr);
+    return SspiChecker_Failed(c) || !m.configured;
+}
+
+int main(int argc, char **argv) {
+    static SspiChecker c;
+    uint32_t sck = SSPI_DEFAULT_SCK;
+    const char *path = "-";
+    int record = 0, lineNo = 0, i, rc;
+    SspiTraceRec rec;
+    char line[512];
+    FILE *f;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) sck = (uint32_t)strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-r") == 0) record = 1;
+        else path = argv[i];
+    }
+    if (sck == 0) { fprintf(stderr, "bad SCK frequency\n"); return 2; }
+    SspiChecker_Init(&c, sck);
+
+    if (record) return Record(&c, strcmp(path, "-") ? path : "../JTAG_Programmer_Cmd_Call/output1.bin");
+
+    f = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    if (!f) { fprintf(stderr, "cannot read %s\n", path); return 2; }
+    while (fgets(line, sizeof(line), f)) {
+        lineNo++;
+        rc = SspiTrace_Parse(line, &rec);
+        if (rc < 0) { fprintf(stderr, "%s:%d: malformed line\n", path, lineNo); c.r.traceErrors++; }
+        if (rc > 0) SspiChecker_Feed(&c, &rec);
+    }
+    if (f != stdin) fclose(f);
+    SspiChecker_Print(&c, stdout);
+    return SspiChecker_Failed(&c);
+}
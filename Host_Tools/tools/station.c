@@ -0,0 +1,60 @@
+/*
+ * Programming station: every programmer on the host at once
+ * - Ports are the ones named, or else every match of -g (default
+ *   /dev/ttyACM*); each gets `config` and the chunked upload of chunk_send,
+ *   all from this one process
+ * - The bitstream is mapped once and shared by every upload
+ * - One line per port (state, time from first frame to DONE, bitstream
+ *   rate, bytes on the wire, the programmer's `chunks` line or why it
+ *   failed), then the station's wall time and aggregate rate
+ * usage: station [-g pattern] [-c chunk] [-b baud] bitstream.bin [port ...]
+ */
+
+#include "station.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    static char paths[STATION_MAX_PORTS][64];
+    static Station st;
+    const char *pattern = "/dev/ttyACM*", *in = NULL;
+    unsigned long chunk = 256, baud = 0;
+    const uint8_t *data;
+    size_t len;
+    int i, n = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) pattern = argv[++i];
+        else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) chunk = strtoul(argv[++i], NULL, 0);
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) baud = strtoul(argv[++i], NULL, 0);
+        else if (!in) in = argv[i];
+        else if (n < STATION_MAX_PORTS && strlen(argv[i]) < sizeof(paths[0])) strcpy(paths[n++], argv[i]);
+    }
+    if (!in || chunk == 0 || chunk > CHUNK_MAX) {
+        fprintf(stderr, "usage: station [-g pattern] [-c chunk] [-b baud] bitstream.bin [port ...]\n");
+        return 2;
+    }
+    if (n == 0 && (n = Station_Discover(pattern, paths, STATION_MAX_PORTS)) == 0) {
+        fprintf(stderr, "no ports match %s\n", pattern);
+        return 1;
+    }
+    if (Station_MapFile(in, &data, &len) < 0) { perror(in); return 1; }
+    if (Station_Init(&st, data, len, (uint32_t)chunk, (uint32_t)baud) < 0) { perror("epoll"); return 1; }
+    for (i = 0; i < n; i++) Station_Add(&st, paths[i]);
+    printf("%s: %zu bytes to %d port%s\n", in, len, n, n == 1 ? "" : "s");
+
+    Station_Run(&st);
+    for (i = 0; i < st.count; i++) {
+        const StationPort *p = &st.port[i];
+        printf("%-20s %-6s %8.0f ms %9.1f KiB/s %10llu wire  %s\n", p->path, Station_StateName(p->state),
+               p->state == PORT_DONE ? p->doneMs - p->uploadMs : 0.0, Station_PortRate(&st, i) / 1024.0,
+               (unsigned long long)p->s.bytes, p->state == PORT_FAIL ? p->why : p->report);
+    }
+    printf("%d of %d DONE in %.0f ms, %.1f KiB/s aggregate, %llu bytes on the wire\n", st.done, st.count, st.wallMs,
+           (double)st.done * (double)len / 1024.0 * 1000.0 / st.wallMs, (unsigned long long)st.wireBytes);
+    Station_Free(&st);
+    Station_UnmapFile(data, len);
+    return st.done == st.count ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+/*
+ * Wire image builder
+ * - Splits a bitstream into the body SPI1 shifts as it is and the last
+ *   byte that leaves Shift-DR (wire_image.ads), so the firmware's pump
+ *   streams the body by count and holds nothing back
+ * - With -f, a session image instead (session_image.ads): the executable
+ *   in -s byte frames (default 256) among the first half of the body, so
+ *   the MCU stages it in flash while the bitstream shifts and uploads it
+ *   at DONE
+ * - Send the output instead of the raw file; `config` tells them apart
+ * usage: wire_image -o out.wire [-f firmware.exe [-s slice]] bitstream.bin
+ */
+
+#include "host_file.h"
+#include "session_image.h"
+#include "wire_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+    const char *out = NULL, *in = NULL, *fwPath = NULL;
+    uint8_t *bits, *fw = NULL, *img;
+    size_t len, fwLen = 0, size, cap;
+    unsigned long slice = 256;
+    FILE *f;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) out = argv[++i];
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) fwPath = argv[++i];
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) slice = strtoul(argv[++i], NULL, 0);
+        else if (argv[i][0] != '-') in = argv[i];
+    }
+    if (!out || !in) { fprintf(stderr, "usage: wire_image -o out.wire [-f firmware.exe [-s slice]] bitstream.bin\n"); return 2; }
+
+    if (!(bits = HostFile_Load(in, &len))) { perror(in); return 1; }
+    if (fwPath && !(fw = HostFile_Load(fwPath, &fwLen))) { perror(fwPath); return 1; }
+    if (fw && (slice < 2 || (slice & 1u) || slice > 0xFFFFFFu)) { fprintf(stderr, "slice must be even, 2 .. 16777214\n"); return 2; }
+    cap = fw ? SessionImage_Size(len, fwLen, (uint32_t)slice) : WIRE_HEADER_SIZE + len;
+    img = malloc(cap ? cap : 1);
+    if (!img) return 1;
+
+    size = fw ? SessionImage_Build(bits, len, fw, fwLen, (uint32_t)slice, img, cap)
+              : WireImage_Build(bits, len, img, cap);
+    if (!size) { fprintf(stderr, "%s: empty\n", in); return 1; }
+    if (!(f = fopen(out, "wb")) || fwrite(img, 1, size, f) != size || fclose(f)) { perror(out); return 1; }
+    printf("%s: body %zu bytes (%zu DR bits by SPI), tail 0x%02X (8 bits with the TMS exit)\n",
+           out, len - 1, (len - 1) * 8, bits[len - 1]);
+    if (fw) {
+        printf("%s: firmware %zu bytes in %zu frames of %lu, %zu bytes in all\n",
+               out, fwLen, (fwLen + slice - 1) / slice, slice, size);
+        if (fwLen > SESSION_STAGE_SIZE) fprintf(stderr, "warning: firmware is over the default Stage_Size (%u)\n", SESSION_STAGE_SIZE);
+    }
+    free(bits); free(fw); free(img);
+    return 0;
+}
@@ -0,0 +1,155 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        baud_link.adb
+--  Description: Package body for the host link's baud negotiation.
+--               mcu_to_fpga feeds a Session from the USART2 ring and
+--               switches the USART; Host_Tools/lib/baud_host.c is the
+--               other side.
+--
+--  Components:
+--               Frame / Valid -- The 5 frame bytes, check byte last
+--               Start         -- A session at Current, Idle_Ms to the
+--                                first frame
+--               Rx            -- Pattern bytes counted in a trial, frames
+--                                found anywhere else and acted on
+--               Tick          -- Trial, confirm and idle deadlines
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body baud_link is
+
+   function Check (Op, Index, Arg : Unsigned_8) return Unsigned_8 is
+     (16#5A# xor Sync xor Op xor Index xor Arg);
+
+   function Frame (Op, Index, Arg : Unsigned_8) return Frame_Bytes is
+     (Sync, Op, Index, Arg, Check (Op, Index, Arg));
+
+   function Valid (F : Frame_Bytes) return Boolean is
+     (F (0) = Sync and then F (2) < Count and then F (4) = Check (F (1), F (2), F (3)));
+
+   --  Wrap-safe: Now has reached T
+   function Reached (Now, T : Unsigned_32) return Boolean is (Now - T < 16#8000_0000#);
+
+   procedure Send (S : in out Session; Op, Index, Arg : Unsigned_8) is
+   begin
+      if S.Tx_Len + Frame_Size <= S.Tx'Length then
+         for B of Frame (Op, Index, Arg) loop
+            S.Tx (S.Tx_Len) := B;
+            S.Tx_Len := S.Tx_Len + 1;
+         end loop;
+      end if;
+   end Send;
+
+   procedure Switch_To (S : in out Session; Index : Unsigned_8) is
+   begin
+      S.Rate := Index;
+      S.Switch := True;
+      S.Rx_Len := 0;
+   end Switch_To;
+
+   procedure Back_To_Base (S : in out Session; Now : Unsigned_32) is
+   begin
+      Switch_To (S, S.Base);
+      S.State := AT_BASE;
+      S.Deadline := Now + Idle_Ms;
+   end Back_To_Base;
+
+   procedure Start (S : in out Session; Now : Unsigned_32) is
+   begin
+      S := (State    => AT_BASE,
+            Base     => Current,
+            Rate     => Current,
+            Trial    => Current,
+            Deadline => Now + Idle_Ms,
+            others   => <>);
+   end Start;
+
+   --  The pattern back and the verdict, at the trial rate, then home
+   procedure End_Trial (S : in out Session; Now : Unsigned_32) is
+   begin
+      S.Errors := S.Errors + (Pattern_Size - S.Got);
+      for I in 0 .. Pattern_Size - 1 loop
+         S.Tx (S.Tx_Len) := Pattern (Unsigned_32 (I));
+         S.Tx_Len := S.Tx_Len + 1;
+      end loop;
+      Send (S, Op_Verdict, S.Trial, Unsigned_8 (Unsigned_32'Min (S.Errors, 255)));
+      Back_To_Base (S, Now);
+   end End_Trial;
+
+   procedure Handle (S : in out Session; Op, Index : Unsigned_8; Now : Unsigned_32) is
+   begin
+      if S.State = AT_BASE and then Op = Op_Try then
+         Send (S, Op_Ready, Index, 0);
+         Switch_To (S, Index);
+         S.State := IN_TRIAL;
+         S.Trial := Index;
+         S.Got := 0;
+         S.Errors := 0;
+         S.Trials := S.Trials + 1;
+         S.Deadline := Now + Trial_Ms;
+      elsif S.State = AT_BASE and then Op = Op_Set then
+         Send (S, Op_Ready, Index, 0);
+         if Index = S.Base then
+            S.State := FINISHED;
+         else
+            Switch_To (S, Index);
+            S.State := AWAIT_CONFIRM;
+            S.Deadline := Now + Confirm_Ms;
+         end if;
+      elsif (S.State = AWAIT_CONFIRM or else S.State = CONFIRMED)
+        and then Op = Op_Confirm and then Index = S.Rate
+      then
+         --  Kept from the first one; later ones only mean the reply was lost
+         Send (S, Op_Confirm, Index, 0);
+         if S.State = AWAIT_CONFIRM then
+            S.Deadline := Now + Confirm_Ms;
+         end if;
+         S.State := CONFIRMED;
+         S.Base := Index;
+         Current := Index;
+      end if;
+   end Handle;
+
+   procedure Rx (S : in out Session; Data : Unsigned_8; Now : Unsigned_32) is
+   begin
+      case S.State is
+         when FINISHED =>
+            null;
+         when IN_TRIAL =>
+            if Data /= Pattern (S.Got) then
+               S.Errors := S.Errors + 1;
+            end if;
+            S.Got := S.Got + 1;
+            if S.Got = Pattern_Size then
+               End_Trial (S, Now);
+            end if;
+         when others =>
+            --  A frame wherever one checks out
+            S.Rx (S.Rx_Len) := Data;
+            S.Rx_Len := S.Rx_Len + 1;
+            if S.Rx_Len = Frame_Size then
+               if Valid (S.Rx) then
+                  S.Rx_Len := 0;
+                  Handle (S, S.Rx (1), S.Rx (2), Now);
+               else
+                  S.Rx (0 .. Frame_Size - 2) := S.Rx (1 .. Frame_Size - 1);
+                  S.Rx_Len := Frame_Size - 1;
+               end if;
+            end if;
+      end case;
+   end Rx;
+
+   procedure Tick (S : in out Session; Now : Unsigned_32) is
+   begin
+      if S.State = FINISHED or else not Reached (Now, S.Deadline) then
+         return;
+      end if;
+      case S.State is
+         when IN_TRIAL      => End_Trial (S, Now);
+         when AWAIT_CONFIRM => Back_To_Base (S, Now);   --  The new rate never carried one
+         when others        => S.State := FINISHED;     --  Confirmed, or the host is gone
+      end case;
+   end Tick;
+
+end baud_link;
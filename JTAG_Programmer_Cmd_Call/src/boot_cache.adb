@@ -0,0 +1,56 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        boot_cache.adb
+--  Description: Package body for the boot image checks. Decides from the
+--               image header whether the FPGA can be configured from flash
+--               at power-up; mcu_to_fpga.Load_Boot_Image does the CRC and
+--               the load itself.
+--
+--  Components:
+--               Check_Word -- Header self-check
+--               Padded     -- Payload length rounded up to whole words
+--               Decide     -- SKIPPED / NO_IMAGE / BAD_HEADER / TOO_LARGE
+--                             or LOAD, from the header alone
+--               Verify     -- LOAD or BAD_CRC
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body boot_cache is
+
+   function Check_Word (H : Header) return Unsigned_32 is
+   begin
+      return not (H.Magic xor H.Length xor H.CRC);
+   end Check_Word;
+
+   function Padded (Length : Unsigned_32) return Unsigned_32 is
+   begin
+      return (Length + 3) and not 3;
+   end Padded;
+
+   function Decide (H : Header; Area_Size : Unsigned_32; Skip : Boolean) return Action is
+   begin
+      if Skip then
+         return SKIPPED;
+      elsif H.Magic = 16#FFFF_FFFF# then
+         return NO_IMAGE;
+      elsif H.Magic /= Magic or else H.Check /= Check_Word (H) or else H.Length = 0 then
+         return BAD_HEADER;
+      elsif Area_Size < Header_Size
+        or else H.Length > Area_Size - Header_Size
+        or else Padded (H.Length) > Area_Size - Header_Size
+      then
+         return TOO_LARGE;
+      end if;
+      return LOAD;
+   end Decide;
+
+   function Verify (H : Header; Payload_CRC : Unsigned_32) return Action is
+   begin
+      if Payload_CRC /= H.CRC then
+         return BAD_CRC;
+      end if;
+      return LOAD;
+   end Verify;
+
+end boot_cache;
@@ -0,0 +1,52 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        chunk_link.adb
+--  Description: Package body for the chunked upload framing. mcu_to_fpga
+--               reads frames out of the USART2 ring with these and sends
+--               the replies; Host_Tools/lib/chunk_link.c builds the frames.
+--
+--  Components:
+--               CRC_Update -- CRC-32 (zlib), reflected, one byte through a
+--                             16-word nibble table
+--               Reply      -- The 10 reply bytes, check byte last
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body chunk_link is
+
+   type Nibble_Table is array (Unsigned_32 range 0 .. 15) of Unsigned_32;
+   Nibble : constant Nibble_Table :=
+     (16#0000_0000#, 16#1DB7_1064#, 16#3B6E_20C8#, 16#26D9_30AC#,
+      16#76DC_4190#, 16#6B6B_51F4#, 16#4DB2_6158#, 16#5005_713C#,
+      16#EDB8_8320#, 16#F00F_9344#, 16#D6D6_A3E8#, 16#CB61_B38C#,
+      16#9B64_C2B0#, 16#86D3_D2D4#, 16#A00A_E278#, 16#BDBD_F21C#);
+
+   function CRC_Update (CRC : Unsigned_32; Data : Unsigned_8) return Unsigned_32 is
+      C : Unsigned_32 := CRC xor Unsigned_32 (Data);
+   begin
+      C := Shift_Right (C, 4) xor Nibble (C and 16#F#);
+      C := Shift_Right (C, 4) xor Nibble (C and 16#F#);
+      return C;
+   end CRC_Update;
+
+   function Reply
+     (Kind : Unsigned_8; Seq, Next : Unsigned_16; Room : Unsigned_8;
+      Chunk : Unsigned_16; Result : Status) return Reply_Bytes
+   is
+      R : Reply_Bytes :=
+        (Kind,
+         Unsigned_8 (Seq and 16#FF#), Unsigned_8 (Shift_Right (Seq, 8)),
+         Unsigned_8 (Next and 16#FF#), Unsigned_8 (Shift_Right (Next, 8)),
+         Room,
+         Unsigned_8 (Chunk and 16#FF#), Unsigned_8 (Shift_Right (Chunk, 8)),
+         Status'Pos (Result),
+         16#5A#);
+   begin
+      for I in 0 .. Reply_Size - 2 loop
+         R (Reply_Size - 1) := R (Reply_Size - 1) xor R (I);
+      end loop;
+      return R;
+   end Reply;
+
+end chunk_link;
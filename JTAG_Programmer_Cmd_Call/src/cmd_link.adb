@@ -0,0 +1,166 @@
+pragma Style_Checks (Off);
+with chunk_link;
+------------------------------------------------------------------------------
+--  File:        cmd_link.adb
+--  Description: Package body for the binary command framing. host_to_mcu
+--               parses requests out of the USART2 ring with these and
+--               sends the responses; Host_Tools/lib/cmd_link.c builds the
+--               requests and reads the responses.
+--
+--  Components:
+--               Feed     -- One request byte: Sync hunt, header, payload,
+--                           CRC; the verdict once the frame ends
+--               Add_Word -- One little-endian word onto a response
+--               Encode   -- Response header, payload and CRC
+--               Parse_Line
+--                        -- A command line to its opcode and argument
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body cmd_link is
+
+   procedure Feed (P : in out Parser; Data : Unsigned_8; Result : out Verdict) is
+      Body_End : Natural;
+   begin
+      Result := NONE;
+      if P.Got = 0 then
+         if Data = Sync then
+            P.Got := 1;
+            P.Length := 0;
+            P.CRC := 16#FFFF_FFFF#;
+            P.Sent_CRC := 0;
+         else
+            P.Skipped := P.Skipped + 1;
+         end if;
+         return;
+      end if;
+
+      --  Length is 0 until both its bytes are in: the header always goes
+      --  into the CRC
+      Body_End := Header_Size + P.Length;
+      if P.Got < Body_End then
+         P.CRC := chunk_link.CRC_Update (P.CRC, Data);
+      end if;
+      case P.Got is
+         when 1 => P.Op := Data;
+         when 2 => P.Tag := Data;
+         when 3 => P.Length := Natural (Data);
+         when 4 =>
+            P.Length := P.Length + Natural (Data) * 256;
+            if P.Length > Max_Payload then
+               P.Too_Long := P.Too_Long + 1;
+               P.Got := 0;
+               P.Length := 0;
+               Result := TOO_LONG;
+               return;
+            end if;
+         when others =>
+            if P.Got < Body_End then
+               P.Payload (P.Got - Header_Size) := Data;
+            else
+               P.Sent_CRC := P.Sent_CRC
+                 or Shift_Left (Unsigned_32 (Data), 8 * (P.Got - Body_End));
+            end if;
+      end case;
+      P.Got := P.Got + 1;
+
+      if P.Got = Header_Size + P.Length + CRC_Size then
+         P.Got := 0;
+         if P.Sent_CRC = not P.CRC then
+            P.Frames := P.Frames + 1;
+            Result := GOOD;
+         else
+            P.Bad_CRC := P.Bad_CRC + 1;
+            Result := BAD_CRC;
+         end if;
+      end if;
+   end Feed;
+
+   procedure Add_Word (R : in out Response; W : Unsigned_32) is
+   begin
+      if R.Length + 4 > Max_Payload then
+         return;
+      end if;
+      for I in 0 .. 3 loop
+         R.Payload (R.Length + I) := Unsigned_8 (Shift_Right (W, 8 * I) and 16#FF#);
+      end loop;
+      R.Length := R.Length + 4;
+   end Add_Word;
+
+   procedure Encode (R : Response; F : out Frame_Bytes; Size : out Natural) is
+      CRC : Unsigned_32 := 16#FFFF_FFFF#;
+   begin
+      F := (others => 0);
+      F (0) := Reply_Sync;
+      F (1) := R.Op;
+      F (2) := R.Tag;
+      F (3) := R.Status;
+      F (4) := Unsigned_8 (R.Length mod 256);
+      F (5) := Unsigned_8 (R.Length / 256);
+      for I in 0 .. R.Length - 1 loop
+         F (Reply_Header_Size + I) := R.Payload (I);
+      end loop;
+      Size := Reply_Header_Size + R.Length;
+      for I in 1 .. Size - 1 loop
+         CRC := chunk_link.CRC_Update (CRC, F (I));
+      end loop;
+      CRC := not CRC;
+      for I in 0 .. 3 loop
+         F (Size + I) := Unsigned_8 (Shift_Right (CRC, 8 * I) and 16#FF#);
+      end loop;
+      Size := Size + CRC_Size;
+   end Encode;
+
+   type Text_Command is record
+      Name : String (1 .. 6);
+      Op   : Unsigned_8;
+   end record;
+   Commands : constant array (1 .. 16) of Text_Command :=
+     (("help  ", Op_Help),   ("exit  ", Op_Exit),
+      ("config", Op_Config), ("upload", Op_Upload),
+      ("dmload", Op_Dmload), ("chain ", Op_Chain),
+      ("select", Op_Select), ("fanout", Op_Fanout),
+      ("status", Op_Status), ("sspi  ", Op_SSPI),
+      ("prof  ", Op_Prof),   ("rings ", Op_Rings),
+      ("boot  ", Op_Boot),   ("baud  ", Op_Baud),
+      ("auto  ", Op_Auto),   ("bin   ", Op_Bin));
+
+   function Text_Op (Word : String) return Unsigned_8 is
+      Padded : String (1 .. 6) := (others => ' ');
+   begin
+      if Word'Length not in 1 .. 6 then
+         return Op_None;
+      end if;
+      Padded (1 .. Word'Length) := Word;
+      for C of Commands loop
+         if C.Name = Padded then
+            return C.Op;
+         end if;
+      end loop;
+      return Op_None;
+   end Text_Op;
+
+   procedure Parse_Line (Line : String; Op : out Unsigned_8; Arg : out Natural) is
+      Space : Natural := Line'Last + 1;
+   begin
+      for I in Line'Range loop
+         if Line (I) = ' ' then
+            Space := I;
+            exit;
+         end if;
+      end loop;
+      Op := Text_Op (Line (Line'First .. Space - 1));
+      Arg := 0;
+      if Line'Last > Space then
+         if Line'Last = Space + 1 and then Line (Line'Last) in '0' .. '9'
+           and then (Op = Op_Select or else Op = Op_Fanout)
+         then
+            Arg := Character'Pos (Line (Line'Last)) - Character'Pos ('0');
+         else
+            Op := Op_None;
+         end if;
+      end if;
+   end Parse_Line;
+
+end cmd_link;
@@ -0,0 +1,84 @@
+pragma Style_Checks (Off);
+with utils;          use utils;
+with hal;
+with jtag_chain;     use jtag_chain;
+------------------------------------------------------------------------------
+--  File:        fanout.adb
+--  Description: Package body for fan-out programming. Several FPGAs share
+--               TCK/TMS/TDI, so every command and the whole bitstream are
+--               shifted once for all of them; each target's status register
+--               is then captured from its own TDO line in the same DR scan.
+--
+--  Components:
+--               Set_Targets        -- Selects how many targets are wired and
+--                                     makes PC0 .. PC2 pulled-down inputs
+--               Capture_Status_All -- One 32-bit DR scan (same TCK sequence
+--                                     as Read_TDO) sampling every TDO line
+--               Target_Done        -- DONE bit of one target's last status
+--               All_Done           -- DONE on every wired target
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body fanout is
+
+   procedure Set_Targets (Count : Target_Index) is
+   begin
+      --  Pulled down: an unplugged target reads as status 0 (not DONE)
+      hal.TDO_Lines_Init;
+      Target_Count := Count;
+      Status := (others => 0);
+   end Set_Targets;
+
+   procedure Capture_Status_All is
+      Lead     : constant Natural := Active_Device - 1;
+      Total    : constant Natural := Lead + 32 + Trailing_Bypass_Bits;
+      Captured : Status_Table := (others => 0);
+      Lines    : Unsigned_32;
+      Level    : Unsigned_32;
+   begin
+      Pin_High (TMS_Pin);
+      Pulse_TCK; -- SELECT-DR-SCAN
+      Pin_Low (TMS_Pin);
+      Pulse_TCK; -- CAPTURE-DR
+      Pulse_TCK;
+      Pin_Low (TDI_Pin);
+      for I in 0 .. Total - 1 loop
+         if I = Total - 1 then
+            Pin_High (TMS_Pin); -- Pull TMS high on the last bit to exit Shift-DR
+         end if;
+         hal.Pin_Set (TCK_Pin, False);
+         --  One snapshot of every line per edge keeps every target in step
+         Lines := hal.TDO_Lines;
+         hal.Pin_Set (TCK_Pin, True);
+
+         if I >= Lead and then I < Lead + 32 then
+            for T in 1 .. Target_Count loop
+               Level := Shift_Right (Lines, T - 1) and 1;
+               Captured (T) := Captured (T) or Shift_Left (Level, I - Lead);
+            end loop;
+         end if;
+      end loop;
+      Pulse_TCK; -- UPDATE-DR
+      Pin_Low (TMS_Pin);
+      Pulse_TCK; -- RUN-TEST/IDLE
+      Pulse_TCK; -- Extra pulse to ensure the FPGA has time to process the command
+      Status := Captured;
+   end Capture_Status_All;
+
+   function Target_Done (Target : Target_Index) return Boolean is
+   begin
+      return Target <= Target_Count and then (Status (Target) and Status_Done_Bit) /= 0;
+   end Target_Done;
+
+   function All_Done return Boolean is
+   begin
+      for T in 1 .. Target_Count loop
+         if not Target_Done (T) then
+            return False;
+         end if;
+      end loop;
+      return True;
+   end All_Done;
+
+end fanout;
@@ -0,0 +1,397 @@
+pragma Style_Checks (Off);
+with Ada.Environment_Variables;
+with GNAT.OS_Lib;             use GNAT.OS_Lib;
+with Interfaces.C;            use Interfaces.C;
+with System;
+with utils;
+with Jtag_Test_Config;
+------------------------------------------------------------------------------
+--  File:        hal.adb (host)
+--  Description: Linux body of the hardware layer, so the programmer runs
+--               unmodified on a PC. The JTAG pins and SPI1 drive the
+--               Host_Tools fan-out bus model (sim/hal_target.c, one Gowin
+--               TAP per board), or its SSPI target while sspi has the
+--               lines; each USART is a file descriptor, normally
+--               a pty from Host_Tools, and its RX DMA is emulated by
+--               reading whatever the descriptor has into DMA_Buffer /
+--               DMA1_Buffer whenever the firmware looks at CNDTR, as long
+--               as the port's DMA requests are on.
+--
+--               JTAG_TEST_USART2  -- Host link (default stdin / stdout)
+--               JTAG_TEST_USART1  -- Tang Nano link (default unconnected)
+--               JTAG_TEST_BOARDS  -- Fan-out boards on the bus (default 1)
+--               JTAG_TEST_STRAP   -- Set: B1 held at reset (Mode_Strap)
+--               JTAG_TEST_CACHE   -- File holding the boot image area
+--                                    (default erased)
+--               JTAG_TEST_DTM     -- Set: the NEORV32 debug TAP takes the
+--                                    pins once board 1 is configured
+--                                    (sba: with system bus access, else
+--                                    stock, without)
+--
+--               Ports are used as they are; `stty -F <port> raw -echo`
+--               first, as on the board.
+--
+--  Components:
+--               Initialize      -- Opens the ports, builds the bus, arms
+--                                  both RX DMA channels (whole ring),
+--                                  USART1 requests on
+--               Pin_* / TDO_*   -- hal_target pin level and TDO lines
+--               SPI_Send        -- Eight TCKs, MSB first, TMS held
+--               SPI_Send_Block  -- SPI_Send per byte; no channel to save
+--               SPI_Transfer    -- SPI_Send, and the byte the target
+--                                  drives back
+--               SSPI_*          -- hal_target's SSPI target: from
+--                                  SSPI_Enable to SPI_Release SPI1 bytes
+--                                  go to it instead of the TAPs
+--               Cache_Base      -- Cache_Size bytes of 16#FF#, the start
+--                                  overwritten from JTAG_TEST_CACHE
+--               Stage_*         -- Stage_Size bytes in memory; erase sets
+--                                  16#FF#, programming ANDs, as flash does
+--               Cache_Erase_Page-- The same on the cache area's bytes
+--               Cache_Program
+--               CRC32           -- Bitwise, reflected 16#EDB8_8320#
+--               DMA_*           -- Ring position, HTIF / TCIF latched on
+--                                  crossing the middle and the end
+--               UART_*          -- write / read on the port; end of input
+--                                  on USART2 ends the program
+--
+--  Target:      Linux (native GNAT), links Host_Tools/obj/libhost.a
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body hal is
+
+   --  Host_Tools/sim/hal_target.h
+   procedure Target_Init (Boards : int)
+     with Import, Convention => C, External_Name => "HalTarget_Init";
+   procedure Target_Pin (Pin : int; High : int)
+     with Import, Convention => C, External_Name => "HalTarget_Pin";
+   function  Target_Pin_Read (Pin : int) return int
+     with Import, Convention => C, External_Name => "HalTarget_PinRead";
+   function  Target_TDO_Lines return Unsigned_32
+     with Import, Convention => C, External_Name => "HalTarget_TdoLines";
+   procedure Target_SPI_Byte (Data : Unsigned_8)
+     with Import, Convention => C, External_Name => "HalTarget_SpiByte";
+   function  Target_SPI_Transfer (Data : Unsigned_8) return Unsigned_8
+     with Import, Convention => C, External_Name => "HalTarget_SpiTransfer";
+   procedure Target_SPI_Release
+     with Import, Convention => C, External_Name => "HalTarget_SpiRelease";
+   procedure Target_SSPI_Enable
+     with Import, Convention => C, External_Name => "HalTarget_SspiEnable";
+   procedure Target_SSPI_Select (CS_Low : int)
+     with Import, Convention => C, External_Name => "HalTarget_SspiSelect";
+   procedure Target_SSPI_Reconfig (Level : int)
+     with Import, Convention => C, External_Name => "HalTarget_SspiReconfig";
+   function  Target_SSPI_Ready return int
+     with Import, Convention => C, External_Name => "HalTarget_SspiReady";
+   function  Target_SSPI_Done return int
+     with Import, Convention => C, External_Name => "HalTarget_SspiDone";
+   procedure Target_Use_Debug (SBA : int)
+     with Import, Convention => C, External_Name => "HalTarget_UseDebug";
+
+   type Poll_Fd is record
+      Fd      : int;
+      Events  : short;
+      Revents : short;
+   end record with Convention => C;
+   POLLIN : constant short := 1;
+   function C_Poll (Fds : in out Poll_Fd; Count : unsigned_long; Timeout : int) return int
+     with Import, Convention => C, External_Name => "poll";
+
+   type Flash_Area is array (Natural range <>) of Unsigned_8;
+   Flash : aliased Flash_Area (0 .. Jtag_Test_Config.Cache_Size - 1) := (others => 16#FF#);
+   Stage : aliased Flash_Area (0 .. Jtag_Test_Config.Stage_Size - 1) := (others => 16#FF#);
+
+   Unconnected : constant File_Descriptor := Invalid_FD;
+   RX_FD : array (Port) of File_Descriptor := (others => Unconnected);
+   TX_FD : array (Port) of File_Descriptor := (others => Unconnected);
+
+   type DMA_State is record
+      Size   : Natural := 0;
+      Pos    : Natural := 0;
+      Half   : Boolean := False;
+      Full   : Boolean := False;
+      On     : Boolean := False;   --  CR3.DMAR
+   end record;
+   DMA : array (Port) of DMA_State;
+
+   procedure Open_Port (P : Port; Variable : String) is
+   begin
+      if Ada.Environment_Variables.Exists (Variable) then
+         RX_FD (P) := Open_Read_Write (Ada.Environment_Variables.Value (Variable), Binary);
+         TX_FD (P) := RX_FD (P);
+      end if;
+   end Open_Port;
+
+   procedure Load_Flash (Variable : String) is
+      FD     : File_Descriptor;
+      Unused : Integer;
+   begin
+      if Ada.Environment_Variables.Exists (Variable) and then Flash'Length > 0 then
+         FD := Open_Read (Ada.Environment_Variables.Value (Variable), Binary);
+         if FD /= Invalid_FD then
+            Unused := Read (FD, Flash'Address, Flash'Length);
+            Close (FD);
+         end if;
+      end if;
+   end Load_Flash;
+
+   procedure Initialize is
+   begin
+      RX_FD (USART2) := Standin;
+      TX_FD (USART2) := Standout;
+      Open_Port (USART2, "JTAG_TEST_USART2");
+      Open_Port (USART1, "JTAG_TEST_USART1");
+      Target_Init (int'Value (Ada.Environment_Variables.Value ("JTAG_TEST_BOARDS", "1")));
+      DMA (USART2) := (Size => utils.Buffer_Size, others => <>);
+      DMA (USART1) := (Size => utils.Buffer1_Size, On => True, others => <>);
+      Load_Flash ("JTAG_TEST_CACHE");
+      if Ada.Environment_Variables.Exists ("JTAG_TEST_DTM") then
+         Target_Use_Debug (Boolean'Pos (Ada.Environment_Variables.Value ("JTAG_TEST_DTM") = "sba"));
+      end if;
+   end Initialize;
+
+   function Mode_Strap return Boolean is
+   begin
+      return Ada.Environment_Variables.Exists ("JTAG_TEST_STRAP");
+   end Mode_Strap;
+
+   procedure Pin_Set (Pin : Natural; High : Boolean) is
+   begin
+      Target_Pin (int (Pin), Boolean'Pos (High));
+   end Pin_Set;
+
+   function Pin_Read (Pin : Natural) return Boolean is
+   begin
+      return Target_Pin_Read (int (Pin)) /= 0;
+   end Pin_Read;
+
+   procedure TDO_Lines_Init is
+   begin
+      null;   --  Missing boards already read low
+   end TDO_Lines_Init;
+
+   function TDO_Lines return Unsigned_32 is
+   begin
+      return Target_TDO_Lines;
+   end TDO_Lines;
+
+   procedure SPI_Enable (Fast : Boolean := False) is
+      pragma Unreferenced (Fast);
+   begin
+      null;
+   end SPI_Enable;
+
+   procedure SPI_Send (Data : Unsigned_8; Spins : in out Unsigned_32) is
+      pragma Unreferenced (Spins);
+   begin
+      Target_SPI_Byte (Data);
+   end SPI_Send;
+
+   function SPI_Transfer (Data : Unsigned_8) return Unsigned_8 is
+   begin
+      return Target_SPI_Transfer (Data);
+   end SPI_Transfer;
+
+   procedure SPI_Flush_RX is
+   begin
+      null;
+   end SPI_Flush_RX;
+
+   procedure SPI_DMA_Begin is
+   begin
+      null;
+   end SPI_DMA_Begin;
+
+   procedure SPI_Send_Block (Data : System.Address; Count : Natural) is
+      Bytes : array (1 .. Count) of Unsigned_8
+      with Import, Address => Data;
+   begin
+      for B of Bytes loop
+         Target_SPI_Byte (B);
+      end loop;
+   end SPI_Send_Block;
+
+   procedure SPI_DMA_End is
+   begin
+      null;
+   end SPI_DMA_End;
+
+   procedure SPI_Wait_Idle is
+   begin
+      null;
+   end SPI_Wait_Idle;
+
+   procedure SPI_Release is
+   begin
+      Target_SPI_Release;
+   end SPI_Release;
+
+   procedure SSPI_Enable is
+   begin
+      Target_SSPI_Enable;
+   end SSPI_Enable;
+
+   procedure SSPI_Select (On : Boolean) is
+   begin
+      Target_SSPI_Select (Boolean'Pos (On));
+   end SSPI_Select;
+
+   procedure SSPI_Reconfig (Low : Boolean) is
+   begin
+      Target_SSPI_Reconfig (Boolean'Pos (not Low));
+   end SSPI_Reconfig;
+
+   function SSPI_Ready return Boolean is
+   begin
+      return Target_SSPI_Ready /= 0;
+   end SSPI_Ready;
+
+   function SSPI_Done return Boolean is
+   begin
+      return Target_SSPI_Done /= 0;
+   end SSPI_Done;
+
+   function Cache_Base return System.Address is
+   begin
+      return Flash'Address;
+   end Cache_Base;
+
+   function Stage_Base return System.Address is
+   begin
+      return Stage'Address;
+   end Stage_Base;
+
+   procedure Stage_Erase_Page (Offset : Natural) is
+   begin
+      Stage (Offset .. Natural'Min (Offset + Flash_Page_Size, Stage'Length) - 1) := (others => 16#FF#);
+   end Stage_Erase_Page;
+
+   procedure Stage_Program (Offset : Natural; Data : Unsigned_16) is
+   begin
+      Stage (Offset) := Stage (Offset) and Unsigned_8 (Data and 16#FF#);
+      Stage (Offset + 1) := Stage (Offset + 1) and Unsigned_8 (Shift_Right (Data, 8));
+   end Stage_Program;
+
+   procedure Cache_Erase_Page (Offset : Natural) is
+   begin
+      Flash (Offset .. Natural'Min (Offset + Flash_Page_Size, Flash'Length) - 1) := (others => 16#FF#);
+   end Cache_Erase_Page;
+
+   procedure Cache_Program (Offset : Natural; Data : Unsigned_16) is
+   begin
+      Flash (Offset) := Flash (Offset) and Unsigned_8 (Data and 16#FF#);
+      Flash (Offset + 1) := Flash (Offset + 1) and Unsigned_8 (Shift_Right (Data, 8));
+   end Cache_Program;
+
+   function CRC32 (Data : System.Address; Length : Natural) return Unsigned_32 is
+      Bytes : Flash_Area (1 .. Length)
+      with Import, Address => Data;
+      CRC : Unsigned_32 := 16#FFFF_FFFF#;
+   begin
+      for B of Bytes loop
+         CRC := CRC xor Unsigned_32 (B);
+         for I in 1 .. 8 loop
+            if (CRC and 1) /= 0 then
+               CRC := Shift_Right (CRC, 1) xor 16#EDB8_8320#;
+            else
+               CRC := Shift_Right (CRC, 1);
+            end if;
+         end loop;
+      end loop;
+      return not CRC;
+   end CRC32;
+
+   function Ready (FD : File_Descriptor) return Boolean is
+      P : Poll_Fd := (Fd => int (FD), Events => POLLIN, Revents => 0);
+   begin
+      return FD /= Unconnected and then C_Poll (P, 1, 0) > 0;
+   end Ready;
+
+   --  What the DMA would have written since the last look; at most one lap
+   procedure Receive (P : Port) is
+      D    : DMA_State renames DMA (P);
+      Old  : Natural;
+      N    : Integer;
+      Addr : System.Address;
+   begin
+      for Pass in 1 .. 2 loop
+         exit when D.Size = 0 or else not D.On or else not Ready (RX_FD (P));
+         Addr := (if P = USART2 then utils.DMA_Buffer (D.Pos)'Address
+                  else utils.DMA1_Buffer (D.Pos)'Address);
+         N := Read (RX_FD (P), Addr, D.Size - D.Pos);
+         exit when N <= 0;
+         Old := D.Pos;
+         D.Pos := D.Pos + N;
+         if Old < D.Size / 2 and then D.Pos >= D.Size / 2 then
+            D.Half := True;
+         end if;
+         if D.Pos = D.Size then
+            D.Full := True;
+            D.Pos := 0;
+         end if;
+      end loop;
+   end Receive;
+
+   function DMA_Remaining (P : Port) return Natural is
+   begin
+      Receive (P);
+      return DMA (P).Size - DMA (P).Pos;
+   end DMA_Remaining;
+
+   procedure DMA_Take_Flags (P : Port; Half, Full : out Boolean) is
+   begin
+      Half := DMA (P).Half;
+      Full := DMA (P).Full;
+      DMA (P).Half := False;
+      DMA (P).Full := False;
+   end DMA_Take_Flags;
+
+   procedure DMA_Clear_Flags (P : Port) is
+   begin
+      DMA (P).Half := False;
+      DMA (P).Full := False;
+   end DMA_Clear_Flags;
+
+   procedure DMA_Restart (P : Port; Count : Natural) is
+   begin
+      DMA (P) := (Size => Count, On => DMA (P).On, others => <>);
+   end DMA_Restart;
+
+   procedure UART_Receive_DMA (P : Port; On : Boolean) is
+   begin
+      DMA (P).On := On;
+   end UART_Receive_DMA;
+
+   procedure UART_Put (P : Port; Data : Unsigned_8) is
+      B      : aliased Unsigned_8 := Data;
+      Unused : Integer;
+   begin
+      if TX_FD (P) /= Unconnected then
+         Unused := Write (TX_FD (P), B'Address, 1);
+      end if;
+   end UART_Put;
+
+   function UART_Get (P : Port) return Unsigned_8 is
+      B : aliased Unsigned_8 := 0;
+   begin
+      if RX_FD (P) = Unconnected or else Read (RX_FD (P), B'Address, 1) /= 1 then
+         --  The host closed the port: nothing more will ever arrive
+         OS_Exit (0);
+      end if;
+      return B;
+   end UART_Get;
+
+   procedure UART_Flush (P : Port) is
+   begin
+      null;
+   end UART_Flush;
+
+   --  A pty runs at whatever speed both ends manage; DMAR goes on as on
+   --  the board
+   procedure UART_Set_Baud (P : Port; Baud : Positive) is
+      pragma Unreferenced (Baud);
+   begin
+      DMA (P).On := True;
+   end UART_Set_Baud;
+
+end hal;
@@ -0,0 +1,562 @@
+pragma Style_Checks (Off);
+with STM32F0x0;               use STM32F0x0;
+with STM32F0x0.RCC;           use STM32F0x0.RCC;
+with STM32F0x0.GPIO;          use STM32F0x0.GPIO;
+with STM32F0x0.SPI;           use STM32F0x0.SPI;
+with STM32F0x0.USART;         use STM32F0x0.USART;
+with STM32F0x0.DMA;           use STM32F0x0.DMA;
+with STM32F0x0.CRC;           use STM32F0x0.CRC;
+with STM32F0x0.Flash;         use STM32F0x0.Flash;
+with System.Storage_Elements; use System.Storage_Elements;
+with utils;
+with sspi;
+with Jtag_Test_Config;
+------------------------------------------------------------------------------
+--  File:        hal.adb (stm32)
+--  Description: STM32F0x0 body of the hardware layer. The register code
+--               that used to sit in main, utils, mcu_to_fpga, fanout and
+--               host_to_mcu, unchanged in what it writes and in what order,
+--               plus the USART1 and RX DMA set-up that only existed in
+--               supplementary_work/JTAG_Test.
+--
+--  Components:
+--               Initialize      -- GPIOA / USART2 clocks, PA0 / PA2 / PA3
+--                                  AF1, PA4 .. PA7 JTAG pins low, USART2
+--                                  with CTS (was main's Initialize_Hardware);
+--                                  USART1 19200 on PA9 / PA10; DMA1 channel
+--                                  3 / 5 circular into DMA1_Buffer /
+--                                  DMA_Buffer
+--               Mode_Strap      -- PC13 (B1) low
+--               Pin_Set         -- GPIOA BSRR.BS / BSRR.BR
+--               Pin_Read        -- GPIOA IDR
+--               TDO_Lines_Init  -- PC0 .. PC2 pulled-down inputs
+--               TDO_Lines       -- GPIOA and GPIOC IDR read back to back
+--               SPI_Enable      -- SPI1 master, 12 MHz (24 MHz Fast),
+--                                  mode 3, 8-bit frames, PA5 .. PA7 to AF0
+--               SPI_Send        -- 8-bit DR write once TXE is set,
+--                                  counting the polls that found it clear
+--               SPI_Transfer    -- The same, then the RXNE byte back
+--               SPI_Flush_RX    -- Reads DR until RXNE clears
+--               SPI_Wait_Idle   -- Waits for SR.BSY to clear
+--               SPI_Release     -- PA5 / PA7 outputs, PA6 input, clock off
+--               SSPI_Enable     -- GPIOB handshake pins, CS high, SPI1
+--                                  mode 0 at 12 MHz (was sspi.SSPI_Init)
+--               SSPI_*          -- PA4 BSRR, PB2 BSRR, PB0 / PB1 IDR
+--               SPI_DMA_*       -- DMA1 channel 3 memory-to-SPI1, the
+--               SPI_Send_Block     channel's USART1 setup saved around it
+--               DMA_*           -- DMA1 channel 5 (USART2 RX) / 3 (USART1
+--                                  RX): CNDTR, HTIF / TCIF, restart
+--               Cache_Base      -- Top Cache_Size bytes of the 128 KiB
+--                                  flash
+--               Cache_Erase_Page-- Stage_* for one page of the cache area
+--               Cache_Program
+--               Stage_*         -- Stage_Size bytes below it: 2 KiB page
+--                                  erase (PER) of a page that is not all
+--                                  16#FF#, half-word programming (PG)
+--               CRC32           -- CRC unit, word fed, input and output
+--                                  reflected
+--               UART_*          -- USART2 / USART1 TDR, RDR, TC, BRR,
+--                                  CR3.DMAR
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body hal is
+
+   type USART_Access is access all USART_Peripheral;
+   UART_Regs : constant array (Port) of USART_Access :=
+     (USART2 => USART2_Periph'Access, USART1 => USART1_Periph'Access);
+
+   procedure Initialize is
+   begin
+      --  Enable GPIOA
+      RCC_Periph.AHBENR.IOPAEN := 1;
+
+      --  Enable USART2
+      RCC_Periph.APB1ENR.USART2EN := 1;
+
+      --  PA0, PA2, PA3, PA4, PA5, PA6, PA7
+      GPIOA_Periph.MODER.Arr (0) := 2;
+      GPIOA_Periph.MODER.Arr (2) := 2;
+      GPIOA_Periph.MODER.Arr (3) := 2;
+      GPIOA_Periph.MODER.Arr (4) := 1;
+      GPIOA_Periph.MODER.Arr (5) := 1;
+      GPIOA_Periph.MODER.Arr (6) := 0;
+      GPIOA_Periph.MODER.Arr (7) := 1;
+
+      --  Set Alternate function for PA2, PA3 (AF1 for USART2)
+      GPIOA_Periph.AFRL.Arr (0) := 1; --  AF1 for USART2
+      GPIOA_Periph.AFRL.Arr (2) := 1; --  AF1 for USART2
+      GPIOA_Periph.AFRL.Arr (3) := 1; --  AF1 for USART2
+
+      --  Initial CS Low(PA4) and TCK, TMS, TDI Low
+      GPIOA_Periph.BSRR.BR.Arr (4) := 1;
+      GPIOA_Periph.BSRR.BR.Arr (5) := 1;
+      GPIOA_Periph.BSRR.BR.Arr (6) := 1;
+      GPIOA_Periph.BSRR.BR.Arr (7) := 1;
+
+      USART2_Periph.CR3.CTSE := 1;
+
+      --  USART2 Configuration (230400 Baud @ 48MHz: 48 MHz / 208 = 230769,
+      --  baud_link.Rates (Power_Up); `baud` on the command line moves it)
+      USART2_Periph.BRR := (DIV_Mantissa => 16#0D#,
+                            DIV_Fraction => 0,
+                            others       => <>);
+
+      --  Enable UART, Transmit, and Receive
+      USART2_Periph.CR1 := (UE     => 1,
+                            TE     => 1,
+                            RE     => 1,
+                            RXNEIE => 0,
+                            OVER8  => 0,
+                            others => <>);
+
+      RCC_Periph.AHBENR.DMA1EN := 1;
+      RCC_Periph.APB2ENR.USART1EN := 1;
+
+      --  PA9 / PA10 AF1 for USART1 (Tang Nano link)
+      GPIOA_Periph.MODER.Arr (9) := 2;
+      GPIOA_Periph.MODER.Arr (10) := 2;
+      GPIOA_Periph.AFRH.Arr (9) := 1;
+      GPIOA_Periph.AFRH.Arr (10) := 1;
+
+      --  USART1 Configuration (19200 Baud @ 48MHz), RX through DMA only
+      USART1_Periph.BRR :=
+        (DIV_Mantissa => 16#9C#, DIV_Fraction => 16#04#, others => <>);
+      USART1_Periph.CR3.DMAR := 1;
+      USART1_Periph.CR1 :=
+        (UE => 1, TE => 1, RE => 1, OVER8 => 0, others => <>);
+
+      --  DMA1 Channel 3 -- USART1 RX (fixed mapping on STM32F070RB)
+      DMA1_Periph.CPAR3 := UInt32 (To_Integer (USART1_Periph.RDR'Address));
+      DMA1_Periph.CMAR3 := UInt32 (To_Integer (utils.DMA1_Buffer'Address));
+      DMA1_Periph.CNDTR3.NDT := UInt16 (utils.Buffer1_Size);
+      DMA1_Periph.CCR3 :=
+        (MINC => 1, CIRC => 1, PL => 2, EN => 1, others => <>);
+
+      --  DMA1 Channel 5 -- USART2 RX. Armed here, but USART2 only raises
+      --  requests (UART_Receive_DMA) while a bitstream or firmware session
+      --  runs; the command line reads RDR itself
+      DMA1_Periph.CPAR5 := UInt32 (To_Integer (USART2_Periph.RDR'Address));
+      DMA1_Periph.CMAR5 := UInt32 (To_Integer (utils.DMA_Buffer'Address));
+      DMA1_Periph.CNDTR5.NDT := UInt16 (utils.Buffer_Size);
+      DMA1_Periph.CCR5 :=
+        (MINC => 1, CIRC => 1, PL => 2, EN => 1, others => <>);
+   end Initialize;
+
+   function Mode_Strap return Boolean is
+   begin
+      RCC_Periph.AHBENR.IOPCEN := 1;
+      GPIOC_Periph.MODER.Arr (13) := 0;   --  External pull-up on the Nucleo
+      return GPIOC_Periph.IDR.IDR.Arr (13) = 0;
+   end Mode_Strap;
+
+   procedure Pin_Set (Pin : Natural; High : Boolean) is
+   begin
+      if High then
+         GPIOA_Periph.BSRR.BS.Arr (Pin) := 1;
+      else
+         GPIOA_Periph.BSRR.BR.Arr (Pin) := 1;
+      end if;
+   end Pin_Set;
+
+   function Pin_Read (Pin : Natural) return Boolean is
+   begin
+      return GPIOA_Periph.IDR.IDR.Arr (Pin) = 1;
+   end Pin_Read;
+
+   procedure TDO_Lines_Init is
+   begin
+      RCC_Periph.AHBENR.IOPCEN := 1;
+      for Pin in 0 .. 2 loop
+         GPIOC_Periph.MODER.Arr (Pin) := 0;
+         --  Pull-down: an unplugged target reads as status 0 (not DONE)
+         GPIOC_Periph.PUPDR.Arr (Pin) := 2;
+      end loop;
+   end TDO_Lines_Init;
+
+   function TDO_Lines return Unsigned_32 is
+      Port_A : constant Unsigned_32 := Unsigned_32 (GPIOA_Periph.IDR.IDR.Val);
+      Port_C : constant Unsigned_32 := Unsigned_32 (GPIOC_Periph.IDR.IDR.Val);
+   begin
+      return (Shift_Right (Port_A, 6) and 1) or Shift_Left (Port_C and 7, 1);
+   end TDO_Lines;
+
+   procedure SPI_Enable (Fast : Boolean := False) is
+   begin
+      RCC_Periph.APB2ENR.SPI1EN := 1;
+
+      --  CR1: Master mode, Baud rate 12MHz (fPCLK / 4; Fast: fPCLK / 2),
+      --  Software Slave Mgmt, Internal Slave Select
+      SPI1_Periph.CR1 :=
+        (MSTR     => 1,
+         BR       => (if Fast then 0 else 1),
+         CPOL     => 1,
+         CPHA     => 1,
+         LSBFIRST => 0,
+         SSM      => 1,
+         SSI      => 1,
+         SPE      => 1,
+         others   => <>);
+
+      --  CR2: 8-bit Data Size (7 is 8-bit), FRXTH must be 1 for 8-bit/Byte access
+      SPI1_Periph.CR2 := (DS => 7, FRXTH => 1, others => <>);
+
+      GPIOA_Periph.AFRL.Arr (5) := 0; --  AF0 for SPI1
+      GPIOA_Periph.AFRL.Arr (6) := 0; --  AF0 for SPI1
+      GPIOA_Periph.AFRL.Arr (7) := 0; --  AF0 for SPI1
+
+      GPIOA_Periph.MODER.Arr (5) := 2;
+      GPIOA_Periph.MODER.Arr (6) := 2;
+      GPIOA_Periph.MODER.Arr (7) := 2;
+   end SPI_Enable;
+
+   --  8-bit access to DR: a 16-bit write would queue two frames
+   DR_Byte : Unsigned_8
+   with Volatile, Address => SPI1_Periph.DR'Address;
+
+   procedure SPI_Send (Data : Unsigned_8; Spins : in out Unsigned_32) is
+   begin
+      while SPI1_Periph.SR.TXE = 0 loop
+         Spins := Spins + 1;
+      end loop;
+      DR_Byte := Data;
+   end SPI_Send;
+
+   function SPI_Transfer (Data : Unsigned_8) return Unsigned_8 is
+   begin
+      while SPI1_Periph.SR.TXE = 0 loop
+         null;
+      end loop;
+      DR_Byte := Data;
+      while SPI1_Periph.SR.RXNE = 0 loop
+         null;
+      end loop;
+      return DR_Byte;
+   end SPI_Transfer;
+
+   procedure SPI_Flush_RX is
+      Unused : Unsigned_8;
+   begin
+      while SPI1_Periph.SR.RXNE /= 0 loop
+         Unused := DR_Byte;
+      end loop;
+   end SPI_Flush_RX;
+
+   procedure SPI_Wait_Idle is
+   begin
+      while SPI1_Periph.SR.BSY /= 0 loop
+         null;
+      end loop;
+   end SPI_Wait_Idle;
+
+   procedure SPI_Release is
+   begin
+      GPIOA_Periph.MODER.Arr (5) := 1;
+      GPIOA_Periph.MODER.Arr (6) := 0;
+      GPIOA_Periph.MODER.Arr (7) := 1;
+      RCC_Periph.APB2ENR.SPI1EN := 0;
+   end SPI_Release;
+
+   procedure SSPI_Enable is
+   begin
+      RCC_Periph.AHBENR.IOPAEN := 1;
+      RCC_Periph.AHBENR.IOPBEN := 1;
+      RCC_Periph.APB2ENR.SPI1EN := 1;
+
+      --  CS idles high
+      GPIOA_Periph.BSRR.BS.Arr (sspi.CS_Pin) := 1;
+      GPIOA_Periph.MODER.Arr (sspi.CS_Pin) := 1;
+
+      --  PB0 DONE and PB1 READY inputs; pulled down so a missing FPGA reads
+      --  as not ready / not done
+      GPIOB_Periph.MODER.Arr (sspi.DONE_Pin) := 0;
+      GPIOB_Periph.MODER.Arr (sspi.READY_Pin) := 0;
+      GPIOB_Periph.PUPDR.Arr (sspi.DONE_Pin) := 2;
+      GPIOB_Periph.PUPDR.Arr (sspi.READY_Pin) := 2;
+
+      --  PB2 RECONFIG_N and PB3 MODE0 high, PB4 MODE1 and PB5 MODE2 low
+      GPIOB_Periph.BSRR.BS.Arr (sspi.Reconfig_N_Pin) := 1;
+      GPIOB_Periph.BSRR.BS.Arr (3) := 1;
+      GPIOB_Periph.BSRR.BR.Arr (4) := 1;
+      GPIOB_Periph.BSRR.BR.Arr (5) := 1;
+      for Pin in 2 .. 5 loop
+         GPIOB_Periph.MODER.Arr (Pin) := 1;
+      end loop;
+
+      --  CR1: Master mode, Baud rate 12MHz, mode 0, Software Slave Mgmt
+      SPI1_Periph.CR1 :=
+        (MSTR     => 1,
+         BR       => 1,
+         CPOL     => 0,
+         CPHA     => 0,
+         LSBFIRST => 0,
+         SSM      => 1,
+         SSI      => 1,
+         SPE      => 1,
+         others   => <>);
+
+      --  CR2: 8-bit Data Size (7 is 8-bit), FRXTH must be 1 for 8-bit/Byte access
+      SPI1_Periph.CR2 := (DS => 7, FRXTH => 1, others => <>);
+
+      GPIOA_Periph.AFRL.Arr (5) := 0; --  AF0 for SPI1
+      GPIOA_Periph.AFRL.Arr (6) := 0; --  AF0 for SPI1
+      GPIOA_Periph.AFRL.Arr (7) := 0; --  AF0 for SPI1
+
+      GPIOA_Periph.MODER.Arr (5) := 2;
+      GPIOA_Periph.MODER.Arr (6) := 2;
+      GPIOA_Periph.MODER.Arr (7) := 2;
+   end SSPI_Enable;
+
+   procedure SSPI_Select (On : Boolean) is
+   begin
+      if On then
+         GPIOA_Periph.BSRR.BR.Arr (sspi.CS_Pin) := 1;
+      else
+         GPIOA_Periph.BSRR.BS.Arr (sspi.CS_Pin) := 1;
+      end if;
+   end SSPI_Select;
+
+   procedure SSPI_Reconfig (Low : Boolean) is
+   begin
+      if Low then
+         GPIOB_Periph.BSRR.BR.Arr (sspi.Reconfig_N_Pin) := 1;
+      else
+         GPIOB_Periph.BSRR.BS.Arr (sspi.Reconfig_N_Pin) := 1;
+      end if;
+   end SSPI_Reconfig;
+
+   function SSPI_Ready return Boolean is
+   begin
+      return GPIOB_Periph.IDR.IDR.Arr (sspi.READY_Pin) /= 0;
+   end SSPI_Ready;
+
+   function SSPI_Done return Boolean is
+   begin
+      return GPIOB_Periph.IDR.IDR.Arr (sspi.DONE_Pin) /= 0;
+   end SSPI_Done;
+
+   Saved_CCR3  : STM32F0x0.DMA.CCR_Register;
+   Saved_CPAR3 : UInt32;
+   Saved_CMAR3 : UInt32;
+   Saved_NDT3  : UInt16;
+
+   procedure SPI_DMA_Begin is
+   begin
+      Saved_CCR3 := DMA1_Periph.CCR3;
+      Saved_CPAR3 := DMA1_Periph.CPAR3;
+      Saved_CMAR3 := DMA1_Periph.CMAR3;
+      Saved_NDT3 := DMA1_Periph.CNDTR3.NDT;
+      DMA1_Periph.CCR3.EN := 0;
+      DMA1_Periph.CPAR3 := UInt32 (To_Integer (SPI1_Periph.DR'Address));
+      SPI1_Periph.CR2.TXDMAEN := 1;
+   end SPI_DMA_Begin;
+
+   procedure SPI_Send_Block (Data : System.Address; Count : Natural) is
+   begin
+      if Count = 0 then
+         return;
+      end if;
+      DMA1_Periph.CCR3.EN := 0;
+      DMA1_Periph.IFCR := (CGIF3 => 1, others => <>);
+      DMA1_Periph.CMAR3 := UInt32 (To_Integer (Data));
+      DMA1_Periph.CNDTR3.NDT := UInt16 (Count);
+      DMA1_Periph.CCR3 := (DIR => 1, MINC => 1, PL => 2, EN => 1, others => <>);
+      while DMA1_Periph.ISR.TCIF3 = 0 loop
+         null;
+      end loop;
+      DMA1_Periph.CCR3.EN := 0;
+   end SPI_Send_Block;
+
+   procedure SPI_DMA_End is
+   begin
+      --  TC only means the last byte reached the TX FIFO
+      while SPI1_Periph.SR.FTLVL /= 0 loop
+         null;
+      end loop;
+      SPI_Wait_Idle;
+      SPI1_Periph.CR2.TXDMAEN := 0;
+      DMA1_Periph.CPAR3 := Saved_CPAR3;
+      DMA1_Periph.CMAR3 := Saved_CMAR3;
+      DMA1_Periph.CNDTR3.NDT := Saved_NDT3;
+      DMA1_Periph.CCR3 := Saved_CCR3;
+   end SPI_DMA_End;
+
+   function DMA_Remaining (P : Port) return Natural is
+   begin
+      case P is
+         when USART2 => return Natural (DMA1_Periph.CNDTR5.NDT);
+         when USART1 => return Natural (DMA1_Periph.CNDTR3.NDT);
+      end case;
+   end DMA_Remaining;
+
+   procedure DMA_Take_Flags (P : Port; Half, Full : out Boolean) is
+      Flags : constant STM32F0x0.DMA.ISR_Register := DMA1_Periph.ISR;
+   begin
+      case P is
+         when USART2 =>
+            DMA1_Periph.IFCR := (CHTIF5 => Flags.HTIF5, CTCIF5 => Flags.TCIF5, others => <>);
+            Half := Flags.HTIF5 = 1;
+            Full := Flags.TCIF5 = 1;
+         when USART1 =>
+            DMA1_Periph.IFCR := (CHTIF3 => Flags.HTIF3, CTCIF3 => Flags.TCIF3, others => <>);
+            Half := Flags.HTIF3 = 1;
+            Full := Flags.TCIF3 = 1;
+      end case;
+   end DMA_Take_Flags;
+
+   procedure DMA_Clear_Flags (P : Port) is
+   begin
+      case P is
+         when USART2 => DMA1_Periph.IFCR := (CHTIF5 => 1, CTCIF5 => 1, others => <>);
+         when USART1 => DMA1_Periph.IFCR := (CHTIF3 => 1, CTCIF3 => 1, others => <>);
+      end case;
+   end DMA_Clear_Flags;
+
+   --  Disable, reload CNDTR, re-enable so the channel is in a clean state
+   procedure DMA_Restart (P : Port; Count : Natural) is
+   begin
+      case P is
+         when USART2 =>
+            DMA1_Periph.CCR5.EN := 0;
+            DMA1_Periph.CNDTR5.NDT := UInt16 (Count);
+            DMA1_Periph.CCR5.EN := 1;
+         when USART1 =>
+            DMA1_Periph.CCR3.EN := 0;
+            DMA1_Periph.CNDTR3.NDT := UInt16 (Count);
+            DMA1_Periph.CCR3.EN := 1;
+      end case;
+   end DMA_Restart;
+
+   Flash_End : constant := 16#0802_0000#;   --  STM32F070RB: 128 KiB
+
+   function Cache_Base return System.Address is
+   begin
+      return To_Address (Flash_End - Jtag_Test_Config.Cache_Size);
+   end Cache_Base;
+
+   function Stage_Base return System.Address is
+   begin
+      return To_Address (Flash_End - Jtag_Test_Config.Cache_Size - Jtag_Test_Config.Stage_Size);
+   end Stage_Base;
+
+   procedure Flash_Unlock is
+   begin
+      if Flash_Periph.CR.LOCK = 1 then
+         Flash_Periph.KEYR := 16#4567_0123#;
+         Flash_Periph.KEYR := 16#CDEF_89AB#;
+      end if;
+   end Flash_Unlock;
+
+   procedure Flash_Wait is
+   begin
+      while Flash_Periph.SR.BSY = 1 loop
+         null;
+      end loop;
+      --  EOP, PGERR and WRPRT are write-1-to-clear
+      Flash_Periph.SR := (EOP => 1, PGERR => 1, WRPRT => 1, others => <>);
+   end Flash_Wait;
+
+   --  PER on the page at Base unless all of it reads 16#FF#
+   procedure Erase_Page (Base : System.Address) is
+      Page : array (0 .. Flash_Page_Size / 4 - 1) of UInt32
+      with Import, Address => Base;
+   begin
+      if (for some W of Page => W /= 16#FFFF_FFFF#) then
+         Flash_Unlock;
+         Flash_Periph.CR.PER := 1;
+         Flash_Periph.AR := UInt32 (To_Integer (Base));
+         Flash_Periph.CR.STRT := 1;
+         Flash_Wait;
+         Flash_Periph.CR.PER := 0;
+      end if;
+   end Erase_Page;
+
+   procedure Stage_Erase_Page (Offset : Natural) is
+   begin
+      Erase_Page (Stage_Base + Storage_Offset (Offset));
+   end Stage_Erase_Page;
+
+   procedure Stage_Program (Offset : Natural; Data : Unsigned_16) is
+      Half : UInt16 with Volatile, Import, Address => Stage_Base + Storage_Offset (Offset);
+   begin
+      Flash_Unlock;
+      Flash_Periph.CR.PG := 1;
+      Half := UInt16 (Data);
+      Flash_Wait;
+      Flash_Periph.CR.PG := 0;
+   end Stage_Program;
+
+   procedure Cache_Erase_Page (Offset : Natural) is
+   begin
+      Erase_Page (Cache_Base + Storage_Offset (Offset));
+   end Cache_Erase_Page;
+
+   procedure Cache_Program (Offset : Natural; Data : Unsigned_16) is
+      Half : UInt16 with Volatile, Import, Address => Cache_Base + Storage_Offset (Offset);
+   begin
+      Flash_Unlock;
+      Flash_Periph.CR.PG := 1;
+      Half := UInt16 (Data);
+      Flash_Wait;
+      Flash_Periph.CR.PG := 0;
+   end Cache_Program;
+
+   function CRC32 (Data : System.Address; Length : Natural) return Unsigned_32 is
+      Words : array (1 .. Length / 4) of UInt32
+      with Import, Address => Data;
+   begin
+      RCC_Periph.AHBENR.CRCEN := 1;
+      --  Reflected in (by word) and out, all-ones start: zlib's CRC-32
+      --  once the result is inverted
+      CRC_Periph.INIT := 16#FFFF_FFFF#;
+      CRC_Periph.CR := (RESET => 1, REV_IN => 3, REV_OUT => 1, others => <>);
+      for W of Words loop
+         CRC_Periph.DR := W;
+      end loop;
+      return not Unsigned_32 (CRC_Periph.DR);
+   end CRC32;
+
+   procedure UART_Receive_DMA (P : Port; On : Boolean) is
+   begin
+      UART_Regs (P).CR3.DMAR := (if On then 1 else 0);
+   end UART_Receive_DMA;
+
+   procedure UART_Put (P : Port; Data : Unsigned_8) is
+   begin
+      while UART_Regs (P).ISR.TXE = 0 loop
+         null;
+      end loop;
+      UART_Regs (P).TDR.TDR := TDR_TDR_Field (Data);
+   end UART_Put;
+
+   function UART_Get (P : Port) return Unsigned_8 is
+   begin
+      while UART_Regs (P).ISR.RXNE = 0 loop
+         null;
+      end loop;
+      return Unsigned_8 (UART_Regs (P).RDR.RDR and 16#FF#);
+   end UART_Get;
+
+   procedure UART_Flush (P : Port) is
+   begin
+      while UART_Regs (P).ISR.TC = 0 loop
+         null;
+      end loop;
+      --  Clear TC flag by writing to ICR before sending next byte
+      UART_Regs (P).ICR.TCCF := 1;
+   end UART_Flush;
+
+   procedure UART_Set_Baud (P : Port; Baud : Positive) is
+      Div : constant Natural := 48_000_000 / Baud;
+   begin
+      UART_Regs (P).CR1 := (UE => 0, others => <>);
+      UART_Regs (P).BRR :=
+        (DIV_Mantissa => BRR_DIV_Mantissa_Field (Div / 16),
+         DIV_Fraction => BRR_DIV_Fraction_Field (Div mod 16),
+         others       => <>);
+      UART_Regs (P).CR3.DMAR := 1;
+      UART_Regs (P).CR1 := (UE => 1, TE => 1, RE => 1, others => <>);
+   end UART_Set_Baud;
+
+end hal;
@@ -1,7 +1,21 @@
 pragma Style_Checks (Off);
-with STM32F0x0;               use STM32F0x0;
-with STM32F0x0.USART;         use STM32F0x0.USART;
+with hal;
 with Utils; use Utils;
+with Interfaces; use Interfaces;
+with jtag_chain; use jtag_chain;
+with fanout; use fanout;
+with sspi;
+with profiler;
+with ring_monitor;
+with boot_cache; use type boot_cache.Action;
+with riscv_debug;
+with session_image;
+with chunk_link;
+with manifest; use type manifest.Outcome;
+with baud_link;
+with cmd_link;
+with Jtag_Test_Config;
+with Ada.Real_Time;
 ------------------------------------------------------------------------------
 --  File:        host_to_mcu.adb
 --  Description: Package body for host-to-MCU communication over USART2.
@@ -15,10 +29,65 @@ with Utils; use Utils;
 --               Get_Char    -- Blocking single-character receive over USART2
 --               Get_Line    -- Receives a CR/LF-terminated string into a
 --                              caller-supplied buffer
---               H2M (Task)  -- Command interpreter task; reads lines from
---                              the host and dispatches state transitions:
---                                "config"  -> INIT_CONFIG then PROG_BITSTREAM
+--               Put_Hex     -- Transmits a 32-bit value as 0xXXXXXXXX
+--               Put_Dec     -- Transmits a 32-bit value in decimal,
+--                              right-aligned in a field of Width
+--               Put_Profile -- Transmits the last session's profiler
+--                              report (same text as session_prof.c)
+--               Put_Ring    -- Transmits one DMA ring's size, bytes,
+--                              high-water mark, overruns and lost bytes
+--               Put_Debug_Load
+--                           -- Transmits the last debug module load
+--               Put_Session -- Transmits the last session's frames, staged
+--                              bytes and timing (and the debug load in it)
+--               Put_Chunks  -- Transmits the last chunked upload's frames,
+--                              CRC failures, NAKs, evictions and time
+--               Put_Manifest-- Transmits the last manifest's result, the
+--                              step it ended on, what it wrote and the
+--                              time of each step
+--               Execute     -- One command from either mode: the state
+--                              transitions, then text lines or a binary
+--                              response (READY first for those that take
+--                              the line for data)
+--               Serve_Binary-- cmd_link requests out of the USART2 DMA
+--                              ring, so a host can pipeline them; bad
+--                              frames answered with their status
+--               H2M (Task)  -- Command interpreter task; idle when main
+--                              boots in RUN_SEQUENCE, otherwise reads lines
+--                              from the host and dispatches state
+--                              transitions:
+--                                "config"  -> INIT_CONFIG then PROG_BITSTREAM;
+--                                             a session image also loads
+--                                             its firmware and reports,
+--                                             a chunked upload reports
+--                                             its frames and resends, a
+--                                             manifest its one result
 --                                "upload"  -> PROG_FIRMWARE
+--                                "dmload"  -> PROG_DEBUG, the executable
+--                                             through the NEORV32 debug
+--                                             module; reports the result
+--                                "chain"   -> SCAN_CHAIN, lists the TAPs
+--                                "select N"-> targets device N of the chain
+--                                "fanout N"-> programs N boards in parallel
+--                                "status"  -> DONE / status of each board
+--                                "sspi"    -> PROG_SSPI, configures over
+--                                             slave serial and reports
+--                                             IDCODE / status / DONE
+--                                "prof"    -> timing report of the last
+--                                             config session
+--                                "rings"   -> DMA ring statistics of the
+--                                             last session on each ring
+--                                "boot"    -> outcome and timing of the
+--                                             power-up load from the
+--                                             boot cache
+--                                "baud"    -> NEGOTIATE_BAUD with
+--                                             baud_negotiate on the host;
+--                                             reports the rate agreed, at
+--                                             that rate
+--                                "bin"     -> binary requests (cmd_link)
+--                                             until Op_Text
+--                                "auto"    -> RUN_SEQUENCE, as if booted
+--                                             in sequence mode
 --                                "help"    -> prints available commands
 --                                "exit"    -> ESCAPE
 --
@@ -29,10 +98,7 @@ package body host_to_mcu is
 
    procedure Put_Char (C : Character) is
    begin
-      while USART2_Periph.ISR.TXE = 0 loop
-         null;
-      end loop;
-      USART2_Periph.TDR.TDR := Character'Pos (C);
+      hal.UART_Put (hal.USART2, Character'Pos (C));
    end Put_Char;
 
 
@@ -47,10 +113,7 @@ package body host_to_mcu is
 
    function Get_Char return Character is
    begin
-      while USART2_Periph.ISR.RXNE = 0 loop
-         null;
-      end loop;
-      return Character'Val (USART2_Periph.RDR.RDR);
+      return Character'Val (hal.UART_Get (hal.USART2));
    end Get_Char;
 
    procedure Get_Line (Buffer : out String; Last : out Natural) is
@@ -66,45 +129,606 @@ package body host_to_mcu is
       end loop;
    end Get_Line;
 
-   task body H2M is 
-      Input : String (1 .. 256);
-      Last : Natural;
-      cmd : String (1 .. 256);
+   procedure Put_Hex (V : Unsigned_32) is
+      Digits_Hex : constant String := "0123456789ABCDEF";
    begin
+      Put_Char ('0');
+      Put_Char ('x');
+      for I in reverse 0 .. 7 loop
+         Put_Char (Digits_Hex (Natural (Shift_Right (V, I * 4) and 16#F#) + 1));
+      end loop;
+   end Put_Hex;
 
+   procedure Put_Dec (V : Unsigned_32; Width : Natural := 0) is
+      Buf : String (1 .. 10);
+      N   : Natural := 0;
+      X   : Unsigned_32 := V;
+   begin
       loop
-         Get_Line (Input, Last);
+         Buf (Buf'Last - N) := Character'Val (Character'Pos ('0') + Natural (X mod 10));
+         N := N + 1;
+         X := X / 10;
+         exit when X = 0;
+      end loop;
+      for I in N + 1 .. Width loop
+         Put_Char (' ');
+      end loop;
+      for I in Buf'Last - N + 1 .. Buf'Last loop
+         Put_Char (Buf (I));
+      end loop;
+   end Put_Dec;
 
-         cmd := Input (1 .. Last);
-         if cmd = "exit" then
-            Put_Line ("Exiting...");
-            Current_State.Set (ESCAPE);
-            exit;
+   procedure Put_Profile is
+      use profiler;
+      Names : constant array (Phase) of String (1 .. 8) :=
+        ("reset   ", "init    ", "pump    ", "trailer ", "command ");
+
+      procedure Put_Text (T : String) is
+      begin
+         for C of T loop
+            Put_Char (C);
+         end loop;
+      end Put_Text;
+   begin
+      Put_Text ("tick_hz ");
+      Put_Dec (Tick_Hz);
+      Put_Line ("");
+      Put_Line ("phase        count       min       avg       max     total");
+      for P in Phase loop
+         Put_Text (Names (P));
+         Put_Dec (Report.Phases (P).Count, 10);
+         Put_Dec (Minimum (Report.Phases (P)), 10);
+         Put_Dec (Average (Report.Phases (P)), 10);
+         Put_Dec (Report.Phases (P).Max, 10);
+         Put_Dec (Report.Phases (P).Total, 10);
+         Put_Line ("");
+      end loop;
+      Put_Text ("bytes ");
+      Put_Dec (Report.Bytes);
+      Put_Line ("");
+      Put_Text ("bytes_per_s ");
+      Put_Dec (Bytes_Per_Second);
+      Put_Line ("");
+      Put_Text ("txe_spins ");
+      Put_Dec (Report.TXE_Spins);
+      Put_Line ("");
+      Put_Text ("ring_high_water ");
+      Put_Dec (Report.High_Water);
+      Put_Text (" of ");
+      Put_Dec (Buffer_Size);
+      Put_Line ("");
+   end Put_Profile;
+
+   procedure Put_Ring (Name : String; R : ring_monitor.Ring_Stats) is
+   begin
+      for C of Name loop
+         Put_Char (C);
+      end loop;
+      Put_Line (" size" & Natural'Image (R.Size)
+                & " bytes" & Unsigned_32'Image (R.Produced)
+                & " high_water" & Unsigned_32'Image (R.High_Water)
+                & " overruns" & Unsigned_32'Image (R.Overruns)
+                & " lost" & Unsigned_32'Image (R.Lost));
+   end Put_Ring;
+
+   procedure Put_Debug_Load is
+   begin
+      Put_Line ("dm " & riscv_debug.Result'Image (riscv_debug.Last.Result)
+                & " bytes" & Unsigned_32'Image (riscv_debug.Last.Bytes)
+                & " load_us" & Unsigned_32'Image (riscv_debug.Last.Load_Us)
+                & " retries" & Unsigned_32'Image (riscv_debug.Last.Retries)
+                & " idle" & Unsigned_32'Image (riscv_debug.Last.Idle));
+   end Put_Debug_Load;
+
+   procedure Put_Session is
+      use session_image;
+      use type Jtag_Test_Config.Firmware_Load_Kind;
+   begin
+      Put_Line ("session frames" & Unsigned_32'Image (Last.Frames)
+                & " staged" & Unsigned_32'Image (Last.Staged)
+                & " staged_us" & Unsigned_32'Image (Last.Staged_Us)
+                & " done_us" & Unsigned_32'Image (Last.Done_Us)
+                & " upload_us" & Unsigned_32'Image (Last.Upload_Us)
+                & " total_us" & Unsigned_32'Image (Last.Total_Us)
+                & (if Last.Bad_Frame then " BAD_FRAME" elsif Last.Done then " DONE" else " FAIL"));
+      --  The bootloader driver reports for itself
+      if Last.Upload_Us > 0 and then Jtag_Test_Config.Firmware_Load = Jtag_Test_Config.Debug then
+         Put_Debug_Load;
+      end if;
+   end Put_Session;
+
+   procedure Put_Chunks is
+      use chunk_link;
+   begin
+      Put_Line ("chunks frames" & Unsigned_32'Image (Last.Frames)
+                & " bytes" & Unsigned_32'Image (Last.Shifted)
+                & " bad_crc" & Unsigned_32'Image (Last.Bad_CRC)
+                & " skipped" & Unsigned_32'Image (Last.Skipped)
+                & " nak" & Unsigned_32'Image (Last.Naks)
+                & " dup" & Unsigned_32'Image (Last.Dups)
+                & " held" & Unsigned_32'Image (Last.Held)
+                & " evicted" & Unsigned_32'Image (Last.Evicted)
+                & " us" & Unsigned_32'Image (Last.Us)
+                & " " & Status'Image (Last.Result));
+   end Put_Chunks;
+
+   procedure Put_Manifest is
+      use manifest;
+   begin
+      for C of String'("manifest " & Outcome'Image (Last.Result)
+                       & " step" & Unsigned_32'Image (Last.Step) & " of" & Unsigned_32'Image (Last.Steps)
+                       & " idcode ")
+      loop
+         Put_Char (C);
+      end loop;
+      Put_Hex (Last.IDCODE);
+      for C of String'(" status ") loop
+         Put_Char (C);
+      end loop;
+      Put_Hex (Last.Status);
+      Put_Line (" bytes" & Unsigned_32'Image (Last.Bytes)
+                & " flashed" & Unsigned_32'Image (Last.Flashed)
+                & " staged" & Unsigned_32'Image (Last.Staged)
+                & " total_us" & Unsigned_32'Image (Last.Total_Us));
+      for C of String'("step_us") loop
+         Put_Char (C);
+      end loop;
+      for I in 1 .. Natural (Unsigned_32'Min (Last.Step, Max_Steps)) loop
+         for C of Unsigned_32'Image (Last.Step_Us (I)) loop
+            Put_Char (C);
+         end loop;
+      end loop;
+      Put_Line ("");
+   end Put_Manifest;
+
+   --  Binary mode reads USART2 through the DMA ring, so requests sent
+   --  back to back wait there while one runs. Ring_Read is the next byte
+   Binary    : Boolean := False;
+   Ring_Read : Natural := 0;
+
+   procedure Resume_Ring is
+   begin
+      Open_USART2_Stream;
+      Ring_Read := 0;
+   end Resume_Ring;
+
+   procedure Respond (R : cmd_link.Response) is
+      F    : cmd_link.Frame_Bytes;
+      Size : Natural;
+   begin
+      cmd_link.Encode (R, F, Size);
+      for I in 0 .. Size - 1 loop
+         hal.UART_Put (hal.USART2, F (I));
+      end loop;
+   end Respond;
+
+   procedure Run (S : State) is
+   begin
+      Current_State.Set (S);
+      while Current_State.Get /= IDLE loop
+         null;
+      end loop;
+   end Run;
+
+   --  Parks H2M for good: the sequence owns USART2 from here on
+   procedure Hand_Over is
+   begin
+      delay until Ada.Real_Time.Time_Last;
+   end Hand_Over;
+
+   procedure Put_Help is
+   begin
+      Put_Line ("Available commands:");
+      Put_Line ("  help - Show this help message");
+      Put_Line ("  exit - Exit the program");
+      Put_Line ("  chain - Discover the JTAG chain");
+      Put_Line ("  select N - Configure device N of the chain");
+      Put_Line ("  fanout N - Program N boards sharing TCK/TMS/TDI");
+      Put_Line ("  status - Show each board's last status");
+      Put_Line ("  sspi - Configure over slave serial (SSPI)");
+      Put_Line ("  prof - Timing report of the last config session");
+      Put_Line ("  rings - DMA ring high-water marks and overruns");
+      Put_Line ("  boot - Power-up load from the boot cache");
+      Put_Line ("  dmload - Load the firmware over JTAG (debug module)");
+      Put_Line ("  baud - Agree a faster rate with baud_negotiate");
+      Put_Line ("  bin - Binary commands (Host_Tools/bin/cmd) until Op_Text");
+      Put_Line ("  auto - Config, bitstream, then firmware (no more commands)");
+   end Put_Help;
+
+   --  One command from either mode: the same work, then text lines or one
+   --  response (two for those that send READY first). Arg is select's or
+   --  fanout's N
+   procedure Execute (Op : Unsigned_8; Arg : Natural; Tag : Unsigned_8) is
+      use cmd_link;
+      R : Response := (Op => Op, Tag => Tag, Status => St_OK, Length => 0, Payload => (others => 0));
+
+      procedure Ready is
+      begin
+         if Binary then
+            R.Status := St_Ready;
+            Respond (R);
+            R.Status := St_OK;
          end if;
+      end Ready;
 
-         if cmd = "help" then
-            Put_Line ("Available commands:");
-            Put_Line ("  help - Show this help message");
-            Put_Line ("  exit - Exit the program");
-         elsif cmd = "config" then
-            Put_Line ("Initialize FPGA configuration");
-            Current_State.Set (INIT_CONFIG);
-            while Current_State.Get /= IDLE 
-            loop
-               null;
-            end loop;
-            Put_Line ("Send Configuration Bitstream");
-            Put_Line ("Configuring FPGA");
-            Current_State.Set (PROG_BITSTREAM);
-         elsif cmd = "upload" then
-            Put_Line ("Send firmware file");
-            Put_Line ("Uploading file...");
+      procedure Add_Ring (S : ring_monitor.Ring_Stats) is
+      begin
+         Add_Word (R, Unsigned_32 (S.Size));
+         Add_Word (R, S.Produced);
+         Add_Word (R, S.High_Water);
+         Add_Word (R, S.Overruns);
+         Add_Word (R, S.Lost);
+      end Add_Ring;
+   begin
+      case Op is
+         when Op_Ping =>
+            Add_Word (R, Unsigned_32 (Version));
+            Add_Word (R, Buffer_Size);
+            Add_Word (R, Max_Payload);
+
+         when Op_Exit =>
+            if Binary then
+               Respond (R);
+               Binary := False;
+            else
+               Put_Line ("Exiting...");
+            end if;
+            Current_State.Set (ESCAPE);
+            return;
+
+         when Op_Config =>
+            if not Binary then
+               Put_Line ("Initialize FPGA configuration");
+            end if;
+            Run (INIT_CONFIG);
+            if Binary then
+               Ready;
+            else
+               Put_Line ("Send Configuration Bitstream");
+               Put_Line ("Configuring FPGA");
+            end if;
+            --  USART2 RX is the DMA's until the pump goes quiet
+            Run (PROG_BITSTREAM);
+            if not Binary then
+               if session_image.Last.Frames > 0 then
+                  Put_Session;
+               end if;
+               if chunk_link.Last.Frames > 0 then
+                  Put_Chunks;
+               end if;
+               if manifest.Last.Result /= manifest.NOT_RUN then
+                  Put_Manifest;
+               end if;
+               return;
+            end if;
+            Resume_Ring;
+            declare
+               Done_Mask : Unsigned_32 := 0;
+               S : session_image.Session_Report renames session_image.Last;
+               C : chunk_link.Chunk_Report renames chunk_link.Last;
+               M : manifest.Manifest_Report renames manifest.Last;
+            begin
+               for T in 1 .. Target_Count loop
+                  if Target_Done (T) then
+                     Done_Mask := Done_Mask or Shift_Left (1, T - 1);
+                  end if;
+               end loop;
+               --  A manifest need not load SRAM: its own result decides
+               if (if M.Result = manifest.NOT_RUN then not All_Done else M.Result /= manifest.DONE) then
+                  R.Status := St_Fail;
+               end if;
+               Add_Word (R, Done_Mask);
+               Add_Word (R, S.Frames);
+               Add_Word (R, S.Staged);
+               Add_Word (R, S.Staged_Us);
+               Add_Word (R, S.Done_Us);
+               Add_Word (R, S.Upload_Us);
+               Add_Word (R, S.Total_Us);
+               Add_Word (R, (if S.Bad_Frame then 1 else 0) or (if S.Done then 2 else 0));
+               Add_Word (R, C.Frames);
+               Add_Word (R, C.Shifted);
+               Add_Word (R, C.Bad_CRC);
+               Add_Word (R, C.Skipped);
+               Add_Word (R, C.Naks);
+               Add_Word (R, C.Dups);
+               Add_Word (R, C.Held);
+               Add_Word (R, C.Evicted);
+               Add_Word (R, C.Us);
+               Add_Word (R, chunk_link.Status'Pos (C.Result));
+               Add_Word (R, manifest.Outcome'Pos (M.Result));
+               Add_Word (R, M.Step);
+               Add_Word (R, M.Steps);
+               Add_Word (R, M.IDCODE);
+               Add_Word (R, M.Status);
+               Add_Word (R, M.Bytes);
+               Add_Word (R, M.Flashed);
+               Add_Word (R, M.Staged);
+               Add_Word (R, M.Total_Us);
+            end;
+
+         when Op_Upload =>
+            if Binary then
+               Ready;
+               Binary := False;
+            else
+               Put_Line ("Send firmware file");
+               Put_Line ("Uploading file...");
+            end if;
             Current_State.Set (PROG_FIRMWARE);
+            return;
+
+         when Op_Dmload =>
+            --  As INIT_CONFIG does: the ring is open before the host is
+            --  told to send
+            Open_USART2_Stream;
+            if Binary then
+               Ready;
+            else
+               Put_Line ("Send firmware file");
+            end if;
+            Run (PROG_DEBUG);
+            if not Binary then
+               Put_Debug_Load;
+               return;
+            end if;
+            Resume_Ring;
+            declare
+               use type riscv_debug.Result;
+               L : riscv_debug.Load_Report renames riscv_debug.Last;
+            begin
+               if L.Result /= riscv_debug.LOADED then
+                  R.Status := St_Fail;
+               end if;
+               Add_Word (R, riscv_debug.Result'Pos (L.Result));
+               Add_Word (R, L.Bytes);
+               Add_Word (R, L.Load_Us);
+               Add_Word (R, L.Retries);
+               Add_Word (R, L.Idle);
+            end;
+
+         when Op_Chain =>
+            Run (SCAN_CHAIN);
+            if Binary then
+               Add_Word (R, (if Chain_Valid then 1 else 0));
+               Add_Word (R, Unsigned_32 (Active_Device));
+               Add_Word (R, Unsigned_32 (Device_Count));
+               for D in 1 .. Device_Count loop
+                  Add_Word (R, Devices (D).IDCODE);
+                  Add_Word (R, Unsigned_32 (Devices (D).IR_Length));
+               end loop;
+            else
+               if not Chain_Valid then
+                  Put_Line ("Chain discovery failed");
+               end if;
+               for D in 1 .. Device_Count loop
+                  Put_Char (Character'Val (Character'Pos ('0') + D));
+                  if D = Active_Device then
+                     Put_Char ('*');
+                  else
+                     Put_Char (' ');
+                  end if;
+                  Put_Char (' ');
+                  Put_Hex (Devices (D).IDCODE);
+                  Put_Line (" IR" & Natural'Image (Devices (D).IR_Length));
+               end loop;
+            end if;
+
+         when Op_Select | Op_Fanout =>
+            if Arg not in 1 .. (if Op = Op_Select then Max_Devices else Max_Targets) then
+               R.Status := St_Bad_Arg;
+               if not Binary then
+                  Put_Line ("Bad argument:" & Natural'Image (Arg));
+               end if;
+            elsif Op = Op_Select then
+               Select_Device (Arg);
+               Add_Word (R, Unsigned_32 (Active_Device));
+               if not Binary then
+                  Put_Line ("Active device:" & Natural'Image (Active_Device));
+               end if;
+            else
+               Set_Targets (Arg);
+               Add_Word (R, Unsigned_32 (Target_Count));
+               if not Binary then
+                  Put_Line ("Fan-out targets:" & Natural'Image (Target_Count));
+               end if;
+            end if;
+
+         when Op_Status =>
+            Add_Word (R, Unsigned_32 (Target_Count));
+            for T in 1 .. Target_Count loop
+               Add_Word (R, Status (T));
+               Add_Word (R, (if Target_Done (T) then 1 else 0));
+               if not Binary then
+                  Put_Char (Character'Val (Character'Pos ('0') + T));
+                  Put_Char (' ');
+                  Put_Hex (Status (T));
+                  Put_Line ((if Target_Done (T) then " DONE" else " FAIL"));
+               end if;
+            end loop;
+
+         when Op_SSPI =>
+            --  As dmload: the ring is open before the host is told to
+            --  send, so nothing it sends at once is lost
+            Open_USART2_Stream;
+            if Binary then
+               Ready;
+            else
+               Put_Line ("Send configuration bitstream (SSPI)");
+            end if;
+            Run (PROG_SSPI);
+            if Binary then
+               Resume_Ring;
+               if not sspi.Configured then
+                  R.Status := St_Fail;
+               end if;
+               Add_Word (R, sspi.Last_IDCODE);
+               Add_Word (R, sspi.Last_Status);
+               Add_Word (R, Unsigned_32 (sspi.Bytes_Sent));
+               Add_Word (R, (if sspi.Configured then 1 else 0));
+            else
+               Put_Char ('I');
+               Put_Char (' ');
+               Put_Hex (sspi.Last_IDCODE);
+               Put_Line ("");
+               Put_Char ('S');
+               Put_Char (' ');
+               Put_Hex (sspi.Last_Status);
+               Put_Line (" bytes" & Natural'Image (sspi.Bytes_Sent));
+               Put_Line ((if sspi.Configured then "DONE" else "FAIL"));
+            end if;
+
+         when Op_Prof =>
+            if not Binary then
+               Put_Profile;
+               return;
+            end if;
+            declare
+               use profiler;
+            begin
+               Add_Word (R, Tick_Hz);
+               for P in Phase loop
+                  Add_Word (R, Report.Phases (P).Count);
+                  Add_Word (R, Minimum (Report.Phases (P)));
+                  Add_Word (R, Average (Report.Phases (P)));
+                  Add_Word (R, Report.Phases (P).Max);
+                  Add_Word (R, Report.Phases (P).Total);
+               end loop;
+               Add_Word (R, Report.Bytes);
+               Add_Word (R, Bytes_Per_Second);
+               Add_Word (R, Report.TXE_Spins);
+               Add_Word (R, Report.High_Water);
+               Add_Word (R, Buffer_Size);
+            end;
+
+         when Op_Rings =>
+            if Binary then
+               Add_Ring (USART2_Ring);
+               Add_Ring (USART1_Ring);
+            else
+               Put_Ring ("usart2", USART2_Ring);
+               Put_Ring ("usart1", USART1_Ring);
+            end if;
+
+         when Op_Boot =>
+            declare
+               B : boot_cache.Boot_Report renames boot_cache.Last;
+            begin
+               Add_Word (R, boot_cache.Action'Pos (B.Result));
+               Add_Word (R, B.Bytes);
+               Add_Word (R, B.CRC_Us);
+               Add_Word (R, B.Load_Us);
+               Add_Word (R, B.User_Us);
+               Add_Word (R, B.Status);
+               Add_Word (R, (if B.Done then 1 else 0));
+               if not Binary then
+                  Put_Line ("boot " & boot_cache.Action'Image (B.Result)
+                            & " bytes" & Unsigned_32'Image (B.Bytes)
+                            & " crc_us" & Unsigned_32'Image (B.CRC_Us)
+                            & " load_us" & Unsigned_32'Image (B.Load_Us)
+                            & " user_mode_us" & Unsigned_32'Image (B.User_Us));
+                  if B.Result = boot_cache.LOAD then
+                     Put_Char ('S');
+                     Put_Char (' ');
+                     Put_Hex (B.Status);
+                     Put_Line ((if B.Done then " DONE" else " FAIL"));
+                  end if;
+               end if;
+            end;
+
+         when Op_Baud =>
+            --  The host is already sending frames: nothing before them
+            Run (NEGOTIATE_BAUD);
+            if Binary then
+               Resume_Ring;
+               Add_Word (R, baud_link.Rates (baud_link.Current));
+            else
+               Put_Line ("baud" & Unsigned_32'Image (baud_link.Rates (baud_link.Current)));
+            end if;
+
+         when Op_Auto =>
+            if Binary then
+               Ready;
+            else
+               Put_Line ("Config, bitstream, then firmware");
+            end if;
+            Current_State.Set (RUN_SEQUENCE);
+            Hand_Over;
+
+         when Op_Text =>
+            if Binary then
+               Respond (R);
+               Close_USART2_Stream;
+               Binary := False;
+            end if;
+            return;
+
+         when others =>
+            R.Status := St_Unknown;
+      end case;
+      if Binary then
+         Respond (R);
+      end if;
+   end Execute;
+
+   --  Requests out of the ring until Op_Text (or a command that keeps the
+   --  line); bad frames get their status back, tagged as they arrived
+   procedure Serve_Binary is
+      use type cmd_link.Verdict;
+      P : cmd_link.Parser;
+      V : cmd_link.Verdict;
+      R : cmd_link.Response;
+   begin
+      while Binary loop
+         if Ring_Read /= (Buffer_Size - hal.DMA_Remaining (hal.USART2)) mod Buffer_Size then
+            cmd_link.Feed (P, Unsigned_8 (DMA_Buffer (Ring_Read)), V);
+            Ring_Read := (Ring_Read + 1) mod Buffer_Size;
+            case V is
+               when cmd_link.NONE =>
+                  null;
+               when cmd_link.GOOD =>
+                  Execute (P.Op, (if P.Length > 0 then Natural (P.Payload (0)) else 0), P.Tag);
+               when cmd_link.BAD_CRC | cmd_link.TOO_LONG =>
+                  R := (Op => P.Op, Tag => P.Tag, Length => 0, Payload => (others => 0),
+                        Status => (if V = cmd_link.BAD_CRC then cmd_link.St_Bad_CRC else cmd_link.St_Too_Long));
+                  Respond (R);
+            end case;
+         end if;
+      end loop;
+   end Serve_Binary;
+
+   task body H2M is
+      Input : String (1 .. 256);
+      Last  : Natural;
+      Op    : Unsigned_8;
+      Arg   : Natural;
+   begin
+      --  main picks the mode once the hardware is up
+      while Current_State.Get = BOOT loop
+         null;
+      end loop;
+      if Current_State.Get = RUN_SEQUENCE then
+         Hand_Over;
+      end if;
+
+      while Current_State.Get /= ESCAPE loop
+         Get_Line (Input, Last);
+         cmd_link.Parse_Line (Input (1 .. Last), Op, Arg);
+
+         if Op = cmd_link.Op_Help then
+            Put_Help;
+         elsif Op = cmd_link.Op_Bin then
+            --  The ring is up before the host hears it may send
+            Resume_Ring;
+            Put_Line ("bin" & Unsigned_8'Image (cmd_link.Version));
+            Binary := True;
+            Serve_Binary;
+         elsif Op = cmd_link.Op_None then
+            Put_Line ("Unknown command: " & Input (1 .. Last));
          else
-            Put_Line ("Unknown command: " & cmd);
+            Execute (Op, Arg, 0);
          end if;
       end loop;
 
-   end H2M;  
+   end H2M;
 
 end host_to_mcu;
@@ -0,0 +1,258 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        jtag_chain.adb
+--  Description: Package body for multi-device JTAG chains. Discovers every
+--               TAP between TDI and TDO and pads each IR/DR scan so only
+--               the selected device sees the instruction or data while all
+--               others sit in BYPASS.
+--
+--  Components:
+--               Discover_Chain       -- Resets the chain, enumerates IDCODE /
+--                                       BYPASS registers and measures the
+--                                       total and per-device IR lengths
+--               Select_Device        -- Chooses the TAP later scans target
+--               Scan_IR              -- Shifts an instruction into the
+--                                       selected TAP, all-ones (BYPASS) into
+--                                       the others
+--               Scan_DR              -- Shifts a DR of up to 32 bits through
+--                                       the selected TAP, one pad bit per
+--                                       bypassed device; returns TDO capture
+--               Trailing_Bypass_Bits -- Bypassed TAPs between TDI and the
+--                                       selected one; a streamed DR must be
+--                                       followed by this many extra bits
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body jtag_chain is
+
+   function To_Bit (B : Boolean) return Bit is (if B then 1 else 0);
+
+   function Known_IR_Length (IDCODE : Unsigned_32) return Natural is
+   begin
+      --  Gowin (JEDEC 0x40D)
+      if (IDCODE and 16#FFF#) = 16#81B# then
+         return Gowin_IR_Length;
+      end if;
+      return 0;
+   end Known_IR_Length;
+
+   --  Splits the captured IR pattern into devices: IEEE 1149.1 requires
+   --  every TAP to capture ...01, i.e. a 1 followed by a 0 shifting LSB first.
+   --  Falls back on known IR lengths when the pattern is ambiguous.
+   function Split_Capture (Capture : Bit_Array; Total : Natural) return Boolean is
+      Starts   : array (1 .. Max_Devices) of Natural := (others => 0);
+      N_Starts : Natural := 0;
+      Sum      : Natural := 0;
+      Unknown  : Natural := 0;
+      Last_End : Natural;
+   begin
+      for I in 0 .. Total - 2 loop
+         if Capture (I) = 1 and then Capture (I + 1) = 0
+           and then (N_Starts = 0 or else I >= Starts (N_Starts) + 2)
+           and then N_Starts < Max_Devices
+         then
+            N_Starts := N_Starts + 1;
+            Starts (N_Starts) := I;
+         end if;
+      end loop;
+
+      if N_Starts > 0 and then N_Starts = Device_Count and then Starts (1) = 0 then
+         for D in 1 .. Device_Count loop
+            if D < Device_Count then
+               Last_End := Starts (D + 1);
+            else
+               Last_End := Total;
+            end if;
+            Devices (D).IR_Length := Last_End - Starts (D);
+         end loop;
+         return True;
+      end if;
+
+      for D in 1 .. Device_Count loop
+         Devices (D).IR_Length := Known_IR_Length (Devices (D).IDCODE);
+         if Devices (D).IR_Length = 0 then
+            if Unknown /= 0 then
+               return False;
+            end if;
+            Unknown := D;
+         end if;
+         Sum := Sum + Devices (D).IR_Length;
+      end loop;
+
+      if Unknown /= 0 then
+         if Total < Sum + 2 then
+            return False;
+         end if;
+         Devices (Unknown).IR_Length := Total - Sum;
+         return True;
+      end if;
+      return Sum = Total;
+   end Split_Capture;
+
+   procedure Discover_Chain is
+      Capture : Bit_Array (0 .. Max_IR_Bits - 1);
+      Count   : Natural := 0;
+      Total   : Natural := 0;
+      ID      : Unsigned_32;
+      Unused  : Bit;
+   begin
+      Chain_Valid := False;
+
+      --  Test-Logic-Reset loads IDCODE (or BYPASS) in every TAP
+      for I in 1 .. 6 loop
+         Unused := Shift_Bit (1, 1);
+      end loop;
+      Unused := Shift_Bit (0, 1); -- RUN-TEST/IDLE
+      Unused := Shift_Bit (1, 1); -- SELECT-DR-SCAN
+      Unused := Shift_Bit (0, 1); -- CAPTURE-DR
+      Unused := Shift_Bit (0, 1); -- SHIFT-DR
+
+      --  A 0 is a 1-bit BYPASS register, a 1 starts a 32-bit IDCODE; once
+      --  our own ones come back (IDCODE of all ones) the chain has ended.
+      while Count < Max_Devices loop
+         if Shift_Bit (0, 1) = 0 then
+            Count := Count + 1;
+            Devices (Count) := (IDCODE => 0, IR_Length => 0);
+         else
+            ID := 1;
+            for B in 1 .. 31 loop
+               ID := ID or Shift_Left (Unsigned_32 (Shift_Bit (0, 1)), B);
+            end loop;
+            exit when ID = 16#FFFF_FFFF#;
+            Count := Count + 1;
+            Devices (Count) := (IDCODE => ID, IR_Length => 0);
+         end if;
+      end loop;
+      Unused := Shift_Bit (1, 1); -- EXIT1-DR
+      Unused := Shift_Bit (1, 1); -- UPDATE-DR
+      Unused := Shift_Bit (0, 1); -- RUN-TEST/IDLE
+
+      if Count = 0 or else Count = Max_Devices then
+         Device_Count := 1;
+         Devices (1) := (IDCODE => 0, IR_Length => Gowin_IR_Length);
+         Active_Device := 1;
+         return;
+      end if;
+      Device_Count := Count;
+
+      --  Read the capture pattern while flooding every IR with ones, then
+      --  shift zeros and count the ones that come back: total IR length.
+      Unused := Shift_Bit (1, 1); -- SELECT-DR-SCAN
+      Unused := Shift_Bit (1, 1); -- SELECT-IR-SCAN
+      Unused := Shift_Bit (0, 1); -- CAPTURE-IR
+      Unused := Shift_Bit (0, 1); -- SHIFT-IR
+      for I in Capture'Range loop
+         Capture (I) := Shift_Bit (0, 1);
+      end loop;
+      while Total < Max_IR_Bits and then Shift_Bit (0, 0) = 1 loop
+         Total := Total + 1;
+      end loop;
+
+      --  Refill with ones so UPDATE-IR leaves every TAP in BYPASS
+      for I in 0 .. Total loop
+         Unused := Shift_Bit (To_Bit (I = Total), 1);
+      end loop;
+      Unused := Shift_Bit (1, 1); -- UPDATE-IR
+      Unused := Shift_Bit (0, 1); -- RUN-TEST/IDLE
+
+      if Total = 0 or else Total >= Max_IR_Bits
+        or else not Split_Capture (Capture, Total)
+      then
+         Device_Count := 1;
+         Devices (1) := (IDCODE => 0, IR_Length => Gowin_IR_Length);
+         Active_Device := 1;
+         return;
+      end if;
+
+      --  Target the first Gowin part by default
+      Active_Device := 1;
+      for D in 1 .. Device_Count loop
+         if Known_IR_Length (Devices (D).IDCODE) = Gowin_IR_Length then
+            Active_Device := D;
+            exit;
+         end if;
+      end loop;
+      Chain_Valid := True;
+   end Discover_Chain;
+
+   procedure Select_Device (Device : Device_Index) is
+   begin
+      if Device <= Device_Count then
+         Active_Device := Device;
+      end if;
+   end Select_Device;
+
+   procedure Scan_IR (Instruction : Bit_Array) is
+      Total   : Natural := 0;
+      Shifted : Natural := 0;
+      Data    : Bit;
+      Unused  : Bit;
+   begin
+      for D in 1 .. Device_Count loop
+         Total := Total + Devices (D).IR_Length;
+      end loop;
+
+      Pin_High (TMS_Pin);
+      Pulse_TCK; -- SELECT-DR-SCAN
+      Pulse_TCK; -- SELECT-IR-SCAN
+      Pin_Low (TMS_Pin);
+      Pulse_TCK; -- CAPTURE-IR
+      Pulse_TCK;
+      for D in 1 .. Device_Count loop
+         for I in 0 .. Devices (D).IR_Length - 1 loop
+            Shifted := Shifted + 1;
+            if D = Active_Device and then Instruction'First + I <= Instruction'Last then
+               Data := Instruction (Instruction'First + I);
+            else
+               Data := 1; -- BYPASS
+            end if;
+            --  Pull TMS high on the last bit of the whole chain to exit Shift-IR
+            Unused := Shift_Bit (To_Bit (Shifted = Total), Data);
+            if D = Active_Device then
+               delay 0.0001;
+            end if;
+         end loop;
+      end loop;
+      Pulse_TCK; -- UPDATE-IR
+      Pin_Low (TMS_Pin);
+      Pulse_TCK; -- RUN-TEST/IDLE
+      Pulse_TCK; -- Extra pulse to ensure the FPGA has time to process the command
+   end Scan_IR;
+
+   function Scan_DR (Data_Out : Unsigned_32; Length : Natural) return Unsigned_32 is
+      Lead     : constant Natural := Active_Device - 1;
+      Total    : constant Natural := Lead + Length + Trailing_Bypass_Bits;
+      Captured : Unsigned_32 := 0;
+      Data     : Bit;
+      TDO_Val  : Bit;
+   begin
+      Pin_High (TMS_Pin);
+      Pulse_TCK; -- SELECT-DR-SCAN
+      Pin_Low (TMS_Pin);
+      Pulse_TCK; -- CAPTURE-DR
+      Pulse_TCK;
+      for I in 0 .. Total - 1 loop
+         if I >= Lead and then I < Lead + Length then
+            Data := Bit (Shift_Right (Data_Out, I - Lead) and 1);
+         else
+            Data := 0; -- Bypass pad
+         end if;
+         TDO_Val := Shift_Bit (To_Bit (I = Total - 1), Data);
+         if I >= Lead and then I < Lead + Length then
+            Captured := Captured or Shift_Left (Unsigned_32 (TDO_Val), I - Lead);
+         end if;
+      end loop;
+      Pulse_TCK; -- UPDATE-DR
+      Pin_Low (TMS_Pin);
+      Pulse_TCK; -- RUN-TEST/IDLE
+      Pulse_TCK; -- Extra pulse to ensure the FPGA has time to process the command
+      return Captured;
+   end Scan_DR;
+
+   function Trailing_Bypass_Bits return Natural is
+   begin
+      return Device_Count - Active_Device;
+   end Trailing_Bypass_Bits;
+
+end jtag_chain;
@@ -1,8 +1,7 @@
 pragma Style_Checks (Off);
-with STM32F0x0; use STM32F0x0;
-with STM32F0x0.RCC; use STM32F0x0.RCC;
-with STM32F0x0.GPIO; use STM32F0x0.GPIO;
-with STM32F0x0.USART; use STM32F0x0.USART;
+with hal;
+with Ada.Real_Time;
+with Jtag_Test_Config;
 with host_to_mcu; use host_to_mcu;
 with mcu_to_fpga; use mcu_to_fpga;
 with utils; use utils;
@@ -11,10 +10,22 @@ with utils; use utils;
 --  Description: Application entry point for the MCU firmware. Performs all
 --               hardware initialization before the Ada runtime starts the
 --               H2M and M2F tasks defined in host_to_mcu and mcu_to_fpga
---               respectively. Once Initialize_Hardware returns, the two tasks
---               take over all program activity.
+--               respectively. Once hal.Initialize returns, main picks the
+--               mode and the two tasks take over all program activity.
 --
---  Hardware Initialization (Initialize_Hardware):
+--  Mode:        Boot_Mode in alire.toml is the default; holding B1 (PC13)
+--               through reset picks the other one
+--                 Commands -- IDLE: H2M takes commands over USART2
+--                 Sequence -- RUN_SEQUENCE: M2F runs chain -> config ->
+--                             bitstream -> firmware with no command line
+--                             (JTAG_Programmer_Serial builds this default)
+--
+--  Boot cache:  in Commands mode, with Boot_Cache on, a good boot_cache
+--               image in the top Cache_Size bytes of flash is shifted into
+--               the FPGA before the command line starts (Load_Boot_Image);
+--               the `boot` command reports the outcome and its timing
+--
+--  Hardware Initialization (hal.Initialize, src/hal/stm32):
 --               GPIOA       -- Enables IOPAEN clock; configures pin modes:
 --                                PA0        : Alternate function (USART2)
 --                                PA2, PA3   : Alternate function AF1 (USART2
@@ -23,9 +34,11 @@ with utils; use utils;
 --                                PA5        : Output (TCK,  initially low)
 --                                PA6        : Input  (TDO)
 --                                PA7        : Output (TDI/TMS, initially low)
---               USART2      -- Enables APB1 clock; configures 115200 baud
---                             at 48 MHz with CTS flow control; enables
---                             UART, TX, and RX
+--               USART2      -- Enables APB1 clock; configures 230400 baud
+--                             (48 MHz / 208) with CTS flow control;
+--                             enables UART, TX, and RX
+--               On the host build (src/hal/host) it opens the USART ports
+--               and builds the simulated fan-out bus instead.
 --
 --  Tasks Started Implicitly by Ada Runtime:
 --               H2M (host_to_mcu) -- Serial command interpreter; drives
@@ -39,52 +52,13 @@ with utils; use utils;
 --  Language:    Ada 2012
 ------------------------------------------------------------------------------
 procedure Main is
-
-procedure Initialize_Hardware is
-      begin
-
-      --  Enable GPIOA
-      RCC_Periph.AHBENR.IOPAEN := 1;
-
-      --  Enable USART2
-      RCC_Periph.APB1ENR.USART2EN := 1;
-
-      --  PA0, PA2, PA3, PA4, PA5, PA6, PA7
-      GPIOA_Periph.MODER.Arr (0) := 2;
-      GPIOA_Periph.MODER.Arr (2) := 2;
-      GPIOA_Periph.MODER.Arr (3) := 2;
-      GPIOA_Periph.MODER.Arr (4) := 1;
-      GPIOA_Periph.MODER.Arr (5) := 1;
-      GPIOA_Periph.MODER.Arr (6) := 0;
-      GPIOA_Periph.MODER.Arr (7) := 1;
-
-      --  Set Alternate function for PA2, PA3 (AF1 for USART2)
-      GPIOA_Periph.AFRL.Arr (0) := 1; --  AF1 for USART2
-      GPIOA_Periph.AFRL.Arr (2) := 1; --  AF1 for USART2
-      GPIOA_Periph.AFRL.Arr (3) := 1; --  AF1 for USART2
-
-      --  Initial CS Low(PA4) and TCK, TMS, TDI Low
-      GPIOA_Periph.BSRR.BR.Arr (4) := 1;
-      GPIOA_Periph.BSRR.BR.Arr (5) := 1;
-      GPIOA_Periph.BSRR.BR.Arr (6) := 1;
-      GPIOA_Periph.BSRR.BR.Arr (7) := 1;
-
-      USART2_Periph.CR3.CTSE := 1;
-
-      --  USART2 Configuration (115200 Baud @ 48MHz)
-      USART2_Periph.BRR := (DIV_Mantissa => 16#0D#,
-                            DIV_Fraction => 0,
-                            others       => <>);
-
-      --  Enable UART, Transmit, and Receive
-      USART2_Periph.CR1 := (UE     => 1,
-                            TE     => 1,
-                            RE     => 1,
-                            RXNEIE => 0,
-                            OVER8  => 0,
-                            others => <>);
-   end Initialize_Hardware;
-
+   use type Jtag_Test_Config.Boot_Mode_Kind;
+   Boot_Start : constant Ada.Real_Time.Time := Ada.Real_Time.Clock;
+   Sequence   : Boolean;
    begin
-      Initialize_Hardware;
-end Main;
\ No newline at end of file
+      hal.Initialize;
+      Sequence := (Jtag_Test_Config.Boot_Mode = Jtag_Test_Config.Sequence) xor hal.Mode_Strap;
+      --  The sequence brings its own bitstream over USART2
+      Load_Boot_Image (Boot_Start, Skip => Sequence or else not Jtag_Test_Config.Boot_Cache);
+      Current_State.Set (if Sequence then RUN_SEQUENCE else IDLE);
+end Main;
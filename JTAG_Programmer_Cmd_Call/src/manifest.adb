@@ -0,0 +1,87 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        manifest.adb
+--  Description: Package body for the programming manifest checks. Decides
+--               from the header and step table alone whether a manifest
+--               may run; mcu_to_fpga.Run_Manifest carries out the steps.
+--
+--  Components:
+--               Valid -- Magic, step count, table CRC, then each step:
+--                        kind, data length, place in the run (one
+--                        Load: the stage holds one executable, its
+--                        pages erased as the data reaches them)
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body manifest is
+
+   function Valid
+     (H          : Header;
+      Steps      : Step_Table;
+      Steps_CRC  : Unsigned_32;
+      Stage_Size : Natural;
+      Cache_Size : Natural) return Boolean
+   is
+      Left   : Unsigned_32 := H.Data_Length;
+      Loaded : Boolean := False;
+   begin
+      if H.Magic /= Magic or else H.Steps = 0 or else H.Steps > Max_Steps
+        or else Steps_CRC /= H.CRC
+      then
+         return False;
+      end if;
+
+      for I in 1 .. Natural (H.Steps) loop
+         declare
+            S : Step renames Steps (I);
+         begin
+            if S.Length > Left then
+               return False;
+            end if;
+            Left := Left - S.Length;
+
+            case Kind (S) is
+               when Step_IDCODE =>
+                  if S.Length /= 0 then
+                     return False;
+                  end if;
+               when Step_SRAM =>
+                  if S.Length = 0 then
+                     return False;
+                  end if;
+               when Step_Flash =>
+                  if S.Length = 0 or else S.Length mod 4 /= 0
+                    or else S.Length > Unsigned_32 (Cache_Size)
+                  then
+                     return False;
+                  end if;
+               when Step_Verify =>
+                  if S.Length /= 0 or else I = 1
+                    or else (Kind (Steps (I - 1)) /= Step_SRAM
+                             and then Kind (Steps (I - 1)) /= Step_Flash)
+                  then
+                     return False;
+                  end if;
+               when Step_Load =>
+                  if S.Length = 0 or else S.Length mod 4 /= 0
+                    or else S.Length > Unsigned_32 (Stage_Size) or else Loaded
+                  then
+                     return False;
+                  end if;
+                  Loaded := True;
+               when Step_Start =>
+                  if S.Length /= 0 or else not Loaded or else I /= Natural (H.Steps)
+                    or else Arg (S) > Start_Debug
+                  then
+                     return False;
+                  end if;
+               when others =>
+                  return False;
+            end case;
+         end;
+      end loop;
+      return Left = 0;
+   end Valid;
+
+end manifest;
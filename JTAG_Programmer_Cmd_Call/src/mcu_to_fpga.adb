@@ -1,11 +1,22 @@
 pragma Style_Checks (Off);
-with STM32F0x0;               use STM32F0x0;
-with STM32F0x0.RCC;           use STM32F0x0.RCC;
-with STM32F0x0.GPIO;          use STM32F0x0.GPIO;
-with STM32F0x0.SPI;           use STM32F0x0.SPI;
-with STM32F0x0.USART;         use STM32F0x0.USART;
-with STM32F0x0.DMA;           use STM32F0x0.DMA;
+with Interfaces;               use type Interfaces.Unsigned_32;
+with hal;                     use hal;
 with System.Storage_Elements; use System.Storage_Elements;
+with Ada.Real_Time;           use type Ada.Real_Time.Time;
+with Jtag_Test_Config;
+with boot_cache;
+with wire_image;
+with session_image;
+with manifest;
+with chunk_link;
+with baud_link;
+with neorv32_boot;
+with riscv_debug;
+with jtag_chain;              use jtag_chain;
+with fanout;                  use fanout;
+with profiler;
+with ring_monitor;
+with sspi;
 ------------------------------------------------------------------------------
 --  File:        mcu_to_fpga.adb
 --  Description: Package body for MCU-to-FPGA communication over JTAG.
@@ -15,20 +26,83 @@ with System.Storage_Elements; use System.Storage_Elements;
 --
 --  Components:
 --               Send_Command             -- Shifts an 8-bit IR command into
---                                           the FPGA via JTAG Shift-IR state
---               Read_TDO                 -- Clocks through the DR chain to
---                                           capture TDO output
+--                                           the active FPGA via JTAG Shift-IR,
+--                                           BYPASS into every other TAP
+--                                           (timed as profiler COMMAND)
+--               Read_TDO                 -- Clocks the active device's 32-bit
+--                                           DR through the chain to capture
+--                                           TDO output
 --               Init_Configuration       -- Executes the FPGA configuration
 --                                           initialization sequence
 --               Read_IDCODE              -- Reads the JTAG IDCODE register
 --               Reset_TAP                -- Forces TAP controller to
 --                                           Test-Logic-Reset state
+--               Begin_Bitstream          -- Shift-DR and SPI1 on, ready for
+--                                           the body of a bitstream
+--               Finish_Configuration     -- Last byte with the TMS exit, the
+--                                           trailing commands and the status
+--                                           capture; shared by both sources
+--               Load_Boot_Image          -- Power-up configuration from the
+--                                           boot_cache image in flash at
+--                                           24 MHz, timed to DONE
+--               Wait_Wire_Header         -- First Header_Size bytes of a
+--                                           session, or the silence that
+--                                           ends a shorter stream
+--               Stream_Wire_Image        -- Body of a host-split image:
+--                                           whole ring spans to SPI1 by DMA,
+--                                           ended by the byte count
+--               Stream_Session           -- Bitstream and firmware frames
+--                                           in one stream: bitstream spans
+--                                           to SPI1 by DMA, firmware into
+--                                           the flash stage in between;
+--                                           the upload from the stage
+--                                           starts once DONE is read
+--               Stream_Chunked           -- Numbered, CRC-checked chunks:
+--                                           each checked in the ring, held
+--                                           if it came ahead of a gap, sent
+--                                           to SPI1 by DMA in order; NAKs
+--                                           back for the bad and missing,
+--                                           so only those are resent;
+--                                           result in chunk_link.Last
+--               Run_Manifest             -- manifest steps run on their own:
+--                                           chain IDCODE, SRAM load, boot
+--                                           image into flash, verify,
+--                                           executable staged and started;
+--                                           one result in manifest.Last
+--               Image_*                  -- The executable's bytes, from
+--                                           the USART2 ring or the stage
 --               Send_Configuration_Bitstream -- Streams bitstream data from
---                                           DMA circular buffer over JTAG
---               Send_Firmware            -- Bridges USART2 (host) to USART1
---                                           (Tang Nano) for firmware upload
+--                                           DMA circular buffer over JTAG to
+--                                           every fan-out target at once and
+--                                           captures each target's status;
+--                                           profiles the pump (bytes, ring
+--                                           backlog, TXE spins) and trailer;
+--                                           counts DMA laps as overruns
+--               Send_Firmware            -- NEORV32 bootloader driver: checks
+--                                           the executable header, waits for
+--                                           each prompt in DMA1_Buffer, sends
+--                                           exactly Size bytes from USART2
+--                                           (or the stage), then 'e' once
+--                                           the upload is OK;
+--                                           result in neorv32_boot.Last
+--               Load_Firmware_Debug      -- The same executable over JTAG
+--                                           instead: header checked, then
+--                                           each image word from USART2
+--                                           (or the stage) written into
+--                                           IMEM through the NEORV32 debug
+--                                           module and the core resumed;
+--                                           result in riscv_debug.Last
+--               Negotiate_Baud           -- `baud`: frames and test
+--                                           patterns through the USART2
+--                                           ring into a baud_link.Session,
+--                                           USART2 switched between them;
+--                                           the rate stays until reset
+--               Relay_Console            -- USART1 to the host afterwards
 --               M2F (Task)               -- State-machine task driving the
---                                           above procedures
+--                                           above procedures and the SSPI
+--                                           path in sspi; RUN_SEQUENCE is
+--                                           the fixed chain -> config ->
+--                                           bitstream -> firmware run
 --
 --  Target:      STM32F0x0
 --  Language:    Ada 2012
@@ -44,56 +118,31 @@ package body mcu_to_fpga is
    Has_Data         : Boolean := False;
    cmd : Bit_Array (0 .. 7);
 
+   --  Executable staged by a session (hal.Stage_Base). While From_Stage,
+   --  Send_Firmware and Load_Firmware_Debug read it from Stage_Read on
+   --  instead of the USART2 ring
+   Stage      : Byte_Array (0 .. Jtag_Test_Config.Stage_Size - 1)
+   with Import, Address => hal.Stage_Base;
+   From_Stage : Boolean := False;
+   Stage_Read : Natural := 0;
+
    procedure Send_Command (c : Bit_Array) is
+      T : constant Ada.Real_Time.Time := profiler.Start;
    begin
-      Pin_High (TMS_PIN);
-      Pulse_TCK; -- SELECT-DR-SCAN
-      Pulse_TCK; -- SELECT-IR-SCAN
-      Pin_Low (TMS_PIN);
-      Pulse_TCK; -- CAPTURE-IR
-      Pulse_TCK;
-      for I in 0 .. 7 loop
-         if c (I) = 1 then
-            Pin_High (TDI_Pin);
-         else
-            Pin_Low (TDI_Pin);
-         end if;
-         if (I = 7) then
-            Pin_High (TMS_PIN); -- Pull TMS high on the last bit to exit Shift-IR
-
-         end if;
-         Pulse_TCK;
-         delay 0.0001;
-      end loop;
-      Pulse_TCK; -- UPDATE-IR
-      Pin_Low (TMS_PIN);
-      Pulse_TCK; -- RUN-TEST/IDLE
-      Pulse_TCK; -- Extra pulse to ensure the FPGA has time to process the command
-
+      Scan_IR (c);
+      profiler.Stop (profiler.COMMAND, T);
    end Send_Command;
 
    --  CHANGE TO FUNCTION LATER: SHOULD RETURN THE VALUE OF TDO
    procedure Read_TDO is
+      Unused : Interfaces.Unsigned_32;
    begin
-      Pin_High (TMS_PIN);
-      Pulse_TCK; -- SELECT-DR-SCAN
-      Pin_Low (TMS_PIN);
-      Pulse_TCK; -- CAPTURE-DR
-      for I in 0 .. 32 loop
-         if (I = 32) then
-            Pin_High (TMS_PIN); -- Pull TMS high on the last bit to exit Shift-DR
-         end if;
-         Pulse_TCK;
-      end loop;
-      Pin_High (TMS_PIN);
-      Pulse_TCK; -- UPDATE-DR
-      Pin_Low (TMS_PIN);
-      Pulse_TCK; -- RUN-TEST/IDLE
-      Pulse_TCK; -- Extra pulse to ensure the FPGA has time to process the command
+      Unused := Scan_DR (0, 32);
    end Read_TDO;
 
    procedure Init_Configuration is
       cmd : Bit_Array (0 .. 7);
+      T   : constant Ada.Real_Time.Time := profiler.Start;
    begin
       
       delay 0.001; -- Delay to get to CONFIGURATION state
@@ -148,46 +197,912 @@ package body mcu_to_fpga is
       Send_Command (cmd);
       cmd := (1, 1, 1, 0, 1, 0, 0, 0); -- Example command (IR=0x17)
       Send_Command (cmd);
+      profiler.Stop (profiler.INIT, T);
    end Init_Configuration;
 
    procedure Read_IDCODE is
+      Unused : Interfaces.Unsigned_32;
    begin
-      Pin_High (TMS_PIN);
-      Pulse_TCK; -- SELECT-DR-SCAN
-      Pin_Low (TMS_PIN);
-      Pulse_TCK; -- CAPTURE-DR
-      for I in 0 .. 31 loop
-         if (I = 31) then
-            Pin_High (TMS_PIN); -- Pull TMS high on the last bit to exit
-         end if;
-         Pulse_TCK;
-      end loop;
-      Pin_High (TMS_PIN);
-      Pulse_TCK; -- UPDATE-DR
-      Pin_Low (TMS_PIN);
-      Pulse_TCK; -- RUN-TEST/IDLE
-      Pulse_TCK; -- Extra pulse to ensure the FPGA has time to process the command
+      Unused := Scan_DR (0, 32);
    end Read_IDCODE;
 
    procedure Reset_TAP is
+      T : constant Ada.Real_Time.Time := profiler.Start;
    begin
       Pin_High (TMS_PIN);
       for I in 1 .. 6 loop
          Pulse_TCK;
       end loop;
+      profiler.Stop (profiler.RESET, T);
    end Reset_TAP;
 
-   procedure Send_Configuration_Bitstream is
-      cmd : Bit_Array (0 .. 7);
+   procedure Begin_Bitstream (Fast : Boolean := False) is
    begin
       Pin_High (tms_pin);
       Pulse_TCK; -- SELECT-DR-SCAN
       Pin_Low (tms_pin);
       Pulse_TCK; -- CAPTURE-DR
       Pulse_TCK; -- Shift-DR
-      SPI_Enable;
+      hal.SPI_Enable (Fast);
+   end Begin_Bitstream;
+
+   procedure Finish_Configuration (Last : Byte) is
+      cmd : Bit_Array (0 .. 7);
+   begin
+      SPI_Disable;
+      Transceive_Last_Byte (Last, Trailing_Bypass_Bits);
+      Pulse_TCK; -- UPDATE-DR
+      Pin_Low (TMS_Pin);
+      Pulse_TCK; -- RUN-TEST/IDLE
+      cmd := (0, 1, 0, 1, 0, 0, 0, 0); -- (IR=0x0A)
+      Send_Command (cmd);
+      Read_TDO;
+      cmd := (0, 0, 0, 1, 0, 0, 0, 0); -- (IR=0x08)
+      Send_Command (cmd);
+      --  Read SRAM
+      cmd := (0, 1, 0, 1, 1, 1, 0, 0); -- IR=0x3A)
+      Send_Command (cmd);
+      cmd := (0, 1, 0, 0, 0, 0, 0, 0); -- (IR=0x02)
+      Send_Command (cmd);
+      cmd := (1, 0, 0, 0, 0, 0, 1, 0); -- (IR=0x41)
+      Send_Command (cmd);
+      Capture_Status_All; -- Status of every fan-out target at once
+   end Finish_Configuration;
+
+   function Micros (From, To : Ada.Real_Time.Time) return Interfaces.Unsigned_32 is
+     (Interfaces.Unsigned_32 ((To - From) / Ada.Real_Time.Microseconds (1)));
+
+   procedure Load_Boot_Image (Boot_Start : Ada.Real_Time.Time; Skip : Boolean) is
+      use boot_cache;
+      Area  : constant Interfaces.Unsigned_32 := Jtag_Test_Config.Cache_Size;
+      Image : constant System.Address := hal.Cache_Base;
+      T     : Ada.Real_Time.Time := profiler.Start;
+   begin
+      boot_cache.Last := (others => <>);
+      if Skip or else Area < Header_Size then
+         return;
+      end if;
+      declare
+         H : Header with Import, Address => Image;
+      begin
+         boot_cache.Last.Result := Decide (H, Area, Skip => False);
+         if boot_cache.Last.Result /= LOAD then
+            return;
+         end if;
+         boot_cache.Last.Result :=
+           Verify (H, hal.CRC32 (Image + Header_Size, Natural (Padded (H.Length))));
+         boot_cache.Last.CRC_Us := Micros (T, profiler.Start);
+         if boot_cache.Last.Result /= LOAD then
+            return;
+         end if;
+
+         declare
+            Bits : Byte_Array (0 .. Natural (H.Length) - 1)
+            with Import, Address => Image + Header_Size;
+         begin
+            T := profiler.Start;
+            TXE_Spins := 0;
+            profiler.Begin_Session;
+            Reset_TAP;
+            Init_Configuration;
+            Begin_Bitstream (Fast => True);
+            for I in 0 .. Bits'Last - 1 loop
+               Transceive_Byte (Bits (I));
+            end loop;
+            Finish_Configuration (Bits (Bits'Last));
+            profiler.Report.Bytes := H.Length;
+            profiler.Report.TXE_Spins := TXE_Spins;
+         end;
+      end;
+
+      boot_cache.Last.Load_Us := Micros (T, profiler.Start);
+      boot_cache.Last.Bytes := profiler.Report.Bytes;
+      boot_cache.Last.Status := fanout.Status (1);
+      boot_cache.Last.Done := All_Done;
+      if boot_cache.Last.Done then
+         boot_cache.Last.User_Us := Micros (Boot_Start, profiler.Start);
+      end if;
+   end Load_Boot_Image;
+
+   --  Byte by byte: the ring need not be word aligned, and may wrap
+   function Ring_Byte (I : Natural) return Interfaces.Unsigned_32 is
+     (Interfaces.Unsigned_32 (DMA_Buffer (I mod Buffer_Size)));
+
+   function Ring_Word (First : Natural) return Interfaces.Unsigned_32 is
+     (Ring_Byte (First)
+      or Interfaces.Shift_Left (Ring_Byte (First + 1), 8)
+      or Interfaces.Shift_Left (Ring_Byte (First + 2), 16)
+      or Interfaces.Shift_Left (Ring_Byte (First + 3), 24));
+
+   --  Bytes of the executable ready to read, and the one Offset past the
+   --  read point; Image_Skip moves the read point on
+   function Image_Bytes return Natural is
+     (if From_Stage then Natural (session_image.Last.Staged) - Stage_Read
+      else (Poll_USART2_Ring + Buffer_Size - Read_Idx) mod Buffer_Size);
+
+   function Image_Byte (Offset : Natural) return Byte is
+     (if From_Stage then Stage (Stage_Read + Offset)
+      else DMA_Buffer ((Read_Idx + Offset) mod Buffer_Size));
+
+   function Image_Word (Offset : Natural) return Interfaces.Unsigned_32 is
+     (Interfaces.Unsigned_32 (Image_Byte (Offset))
+      or Interfaces.Shift_Left (Interfaces.Unsigned_32 (Image_Byte (Offset + 1)), 8)
+      or Interfaces.Shift_Left (Interfaces.Unsigned_32 (Image_Byte (Offset + 2)), 16)
+      or Interfaces.Shift_Left (Interfaces.Unsigned_32 (Image_Byte (Offset + 3)), 24));
+
+   procedure Image_Skip (Count : Natural) is
+   begin
+      if From_Stage then
+         Stage_Read := Stage_Read + Count;
+      else
+         Read_Idx := (Read_Idx + Count) mod Buffer_Size;
+         ring_monitor.Consume (USART2_Ring, Count);
+      end if;
+   end Image_Skip;
+
+   --  The executable header: the host takes its time to start, but once
+   --  the first byte is in, False after Quiet_Time without another
+   function Wait_Image_Header (Quiet_Time : Ada.Real_Time.Time_Span) return Boolean is
+      use type Ada.Real_Time.Time_Span;
+      Seen        : Natural := 0;
+      Got         : Natural;
+      Quiet_Since : Ada.Real_Time.Time := Ada.Real_Time.Clock;
+   begin
+      loop
+         Got := Image_Bytes;
+         exit when Got >= neorv32_boot.Header_Size;
+         if Got /= Seen or else Got = 0 then
+            Seen := Got;
+            Quiet_Since := Ada.Real_Time.Clock;
+         elsif Ada.Real_Time.Clock - Quiet_Since > Quiet_Time then
+            return False;
+         end if;
+      end loop;
+      return True;
+   end Wait_Image_Header;
+
+   function Magic_Byte (Magic : Interfaces.Unsigned_32; I : Natural) return Interfaces.Unsigned_32 is
+     (Interfaces.Shift_Right (Magic, 8 * I) and 16#FF#);
+
+   --  Wire image, session, chunk or manifest header, whichever the magic says
+   function Wait_Wire_Header return Boolean is
+      Quiet : Natural := 0;
+      Last  : Natural := 0;
+   begin
+      loop
+         Write_Idx := Poll_USART2_Ring;
+         --  A raw bitstream gives itself away on its first byte
+         for I in 0 .. Natural'Min (Write_Idx, 4) - 1 loop
+            if Ring_Byte (I) /= Magic_Byte (wire_image.Magic, I)
+              and then Ring_Byte (I) /= Magic_Byte (session_image.Magic, I)
+              and then Ring_Byte (I) /= Magic_Byte (chunk_link.Magic, I)
+              and then Ring_Byte (I) /= Magic_Byte (manifest.Magic, I)
+            then
+               return False;
+            end if;
+         end loop;
+         if Write_Idx >= 4 and then Ring_Word (0) = session_image.Magic then
+            if Write_Idx >= session_image.Header_Size then
+               return True;
+            end if;
+         elsif Write_Idx >= 4 and then Ring_Word (0) = chunk_link.Magic then
+            if Write_Idx >= chunk_link.Header_Size then
+               return True;
+            end if;
+         elsif Write_Idx >= 4 and then Ring_Word (0) = manifest.Magic then
+            if Write_Idx >= manifest.Header_Size then
+               return True;
+            end if;
+         elsif Write_Idx >= wire_image.Header_Size then
+            return True;
+         end if;
+         if Write_Idx /= Last then
+            Quiet := 0;
+            Last := Write_Idx;
+         elsif Write_Idx > 0 then
+            Quiet := Quiet + 1;
+            exit when Quiet >= Stable_Threshold;
+         end if;
+      end loop;
+      return False;
+   end Wait_Wire_Header;
+
+   procedure Stream_Wire_Image (Body_Length : Natural; Tail : Byte) is
+      Left       : Natural := Body_Length;
+      Span       : Natural;
+      Quiet      : Natural := 0;
+      Pump_Start : constant Ada.Real_Time.Time := profiler.Start;
+      Tail_Start : Ada.Real_Time.Time;
+   begin
+      Read_Idx := wire_image.Header_Size;
+      ring_monitor.Consume (USART2_Ring, wire_image.Header_Size);
+      hal.SPI_DMA_Begin;
+      while Left > 0 and then Quiet < Stable_Threshold loop
+         Write_Idx := Poll_USART2_Ring;
+         if Write_Idx = Read_Idx then
+            Quiet := Quiet + 1;
+         else
+            Quiet := 0;
+            profiler.Note_Level (ring_monitor.Level (USART2_Ring));
+            Span := Natural'Min
+              ((if Write_Idx > Read_Idx then Write_Idx else Buffer_Size) - Read_Idx, Left);
+            hal.SPI_Send_Block (DMA_Buffer (Read_Idx)'Address, Span);
+            Read_Idx := (Read_Idx + Span) mod Buffer_Size;
+            Left := Left - Span;
+            ring_monitor.Consume (USART2_Ring, Span);
+         end if;
+      end loop;
+      hal.SPI_DMA_End;
+      profiler.Stop (profiler.PUMP, Pump_Start);
+
+      --  A short body still leaves Shift-DR; the status shows the failure
+      Tail_Start := profiler.Start;
+      profiler.Report.Bytes := Interfaces.Unsigned_32 (Body_Length - Left + 1);
+      Close_USART2_Stream;
+      Finish_Configuration (Tail);
+      profiler.Stop (profiler.TRAILER, Tail_Start);
+   end Stream_Wire_Image;
+
+   procedure Stream_Session (H : session_image.Header) is
+      use session_image;
+      use type Interfaces.Unsigned_8;
+      use type Jtag_Test_Config.Firmware_Load_Kind;
+      Body_Left  : Natural := Natural (H.Body_Length);
+      Fw_Left    : Natural := Natural (H.Firmware_Length);
+      Frame_Left : Natural := 0;
+      Kind       : Interfaces.Unsigned_8 := 0;
+      Word       : Interfaces.Unsigned_32;
+      Avail      : Natural;
+      Span       : Natural;
+      Quiet      : Natural := 0;
+      Start      : constant Ada.Real_Time.Time := profiler.Start;
+      Tail_Start : Ada.Real_Time.Time;
+      Done_At    : Ada.Real_Time.Time := Start;
+      Shifting   : Boolean := True;   --  SPI1 and the DMA channel still the body's
+
+      procedure Take (Count : Natural) is
+      begin
+         Read_Idx := (Read_Idx + Count) mod Buffer_Size;
+         ring_monitor.Consume (USART2_Ring, Count);
+         Quiet := 0;
+      end Take;
+
+      --  The moment the body is in: trailer and status, stream or no
+      procedure Finish_Bitstream is
+      begin
+         Shifting := False;
+         hal.SPI_DMA_End;
+         profiler.Stop (profiler.PUMP, Start);
+         Tail_Start := profiler.Start;
+         profiler.Report.Bytes := Interfaces.Unsigned_32 (Natural (H.Body_Length) - Body_Left + 1);
+         Finish_Configuration (Byte (Tail_Byte (H)));
+         profiler.Stop (profiler.TRAILER, Tail_Start);
+         Done_At := profiler.Start;
+         Last.Done := All_Done;
+         Last.Done_Us := Micros (Start, Done_At);
+      end Finish_Bitstream;
+   begin
+      Read_Idx := Header_Size;
+      ring_monitor.Consume (USART2_Ring, Header_Size);
+      hal.SPI_DMA_Begin;
+      while (Body_Left > 0 or else Fw_Left > 0) and then Quiet < Stable_Threshold loop
+         Write_Idx := Poll_USART2_Ring;
+         Avail := (Write_Idx + Buffer_Size - Read_Idx) mod Buffer_Size;
+         --  A frame word, one bitstream byte or one firmware half-word at least
+         if Avail < (if Frame_Left = 0 then Frame_Size
+                     elsif Kind = Firmware_Frame then Natural'Min (Frame_Left, 2)
+                     else 1)
+         then
+            Quiet := Quiet + 1;
+
+         elsif Frame_Left = 0 then
+            Word := Ring_Word (Read_Idx);
+            Kind := Frame_Kind (Word);
+            Frame_Left := Natural (Frame_Length (Word));
+            Take (Frame_Size);
+            Last.Frames := Last.Frames + 1;
+            --  Firmware is staged in half-words: only its last frame may be odd
+            if not ((Kind = Bitstream_Frame and then Frame_Left <= Body_Left)
+                    or else (Kind = Firmware_Frame and then Frame_Left <= Fw_Left
+                             and then (Frame_Left mod 2 = 0 or else Frame_Left = Fw_Left)))
+            then
+               Last.Bad_Frame := True;
+               exit;
+            end if;
+
+         elsif Kind = Bitstream_Frame then
+            profiler.Note_Level (ring_monitor.Level (USART2_Ring));
+            Span := Natural'Min (Natural'Min (Buffer_Size - Read_Idx, Avail), Frame_Left);
+            hal.SPI_Send_Block (DMA_Buffer (Read_Idx)'Address, Span);
+            Take (Span);
+            Frame_Left := Frame_Left - Span;
+            Body_Left := Body_Left - Span;
+            if Body_Left = 0 then
+               Finish_Bitstream;
+            end if;
+
+         else
+            --  One half-word into flash, the upper byte erased if it is the
+            --  last; each stage page is erased as the firmware reaches it
+            Span := Natural'Min (Frame_Left, 2);
+            if Natural (Last.Staged) mod hal.Flash_Page_Size = 0 then
+               hal.Stage_Erase_Page (Natural (Last.Staged));
+            end if;
+            hal.Stage_Program
+              (Natural (Last.Staged),
+               Interfaces.Unsigned_16 (Ring_Byte (Read_Idx))
+               or (if Span = 2 then Interfaces.Unsigned_16 (Ring_Byte (Read_Idx + 1)) * 256 else 16#FF00#));
+            Take (Span);
+            Frame_Left := Frame_Left - Span;
+            Fw_Left := Fw_Left - Span;
+            Last.Staged := Last.Staged + Interfaces.Unsigned_32 (Span);
+            if Fw_Left = 0 then
+               Last.Staged_Us := Micros (Start, profiler.Start);
+            end if;
+         end if;
+      end loop;
+
+      --  A short or bad stream still leaves Shift-DR; the status shows it
+      if Shifting then
+         Finish_Bitstream;
+      end if;
+      Close_USART2_Stream;
+
+      --  Straight from DONE: the executable is already on the board
+      if Last.Done and then Fw_Left = 0 and then H.Firmware_Length > 0 and then not Last.Bad_Frame then
+         From_Stage := True;
+         Stage_Read := 0;
+         if Jtag_Test_Config.Firmware_Load = Jtag_Test_Config.Debug then
+            Load_Firmware_Debug;
+         else
+            Send_Firmware;
+         end if;
+         From_Stage := False;
+         Last.Upload_Us := Micros (Done_At, profiler.Start);
+         Last.Total_Us := Micros (Start, profiler.Start);
+      end if;
+   end Stream_Session;
+
+   --  Chunked session (chunk_link): each frame is checked where the DMA
+   --  left it in the ring, held there if it came ahead of a gap, and sent
+   --  to SPI1 by DMA once every chunk before it is in. Parse, Released and
+   --  the slots' Start are absolute byte counts since the session began,
+   --  USART2_Ring.Produced the DMA's; the ring is released up to the oldest
+   --  held frame, and a held frame the DMA would lap is dropped and NAKed
+   procedure Stream_Chunked is
+      use type Interfaces.Unsigned_8;
+      use type Interfaces.Unsigned_16;
+      use type chunk_link.Status;
+      subtype U16 is Interfaces.Unsigned_16;
+      subtype U32 is Interfaces.Unsigned_32;
+
+      type Slot_State is (EMPTY, NAKED, HELD);
+      type Slot is record
+         State : Slot_State := EMPTY;
+         Seq   : U16        := 0;
+         Start : U32        := 0;   --  The frame's header
+         Len   : U16        := 0;
+         Flags : U16        := 0;
+      end record;
+      type Slot_Table is array (0 .. chunk_link.Slots - 1) of Slot;
+
+      --  How long a restarted host has to probe, and how long the replies
+      --  go on after the status is known
+      Resume_Timeout : constant Ada.Real_Time.Time_Span := Ada.Real_Time.Seconds (10);
+      Linger         : constant Ada.Real_Time.Time_Span := Ada.Real_Time.Milliseconds (500);
+
+      Ring_Size  : constant U32 := U32 (Buffer_Size);
+      Room       : constant Interfaces.Unsigned_8 :=
+        Interfaces.Unsigned_8 (Natural'Min (Buffer_Size / 64, 255));
+      Table      : Slot_Table;
+      Recv       : U32 := 0;
+      Parse      : U32 := 0;
+      Released   : U32 := 0;
+      Next       : U16 := 0;
+      Chunk      : U16 := 0;   --  Every chunk but the last, once one is in
+      Result     : chunk_link.Status := chunk_link.RUNNING;
+      Start      : constant Ada.Real_Time.Time := profiler.Start;
+      Heard      : Ada.Real_Time.Time := Start;
+      Tail_Start : Ada.Real_Time.Time;
+
+      function Half (A : U32) return U16 is
+        (U16 (Ring_Byte (Natural (A mod Ring_Size)))
+         or Interfaces.Shift_Left (U16 (Ring_Byte (Natural ((A + 1) mod Ring_Size))), 8));
+
+      function Slot_Of (Seq : U16) return Natural is (Natural (Seq mod chunk_link.Slots));
+
+      procedure Send_Reply (Kind : Interfaces.Unsigned_8; Seq : U16) is
+         R : constant chunk_link.Reply_Bytes :=
+           chunk_link.Reply (Kind, Seq, Next, Room, Chunk, Result);
+      begin
+         for B of R loop
+            hal.UART_Put (hal.USART2, B);
+         end loop;
+         if Kind = chunk_link.Nak then
+            chunk_link.Last.Naks := chunk_link.Last.Naks + 1;
+         end if;
+      end Send_Reply;
+
+      --  Count bytes of the ring from absolute From, two blocks if it wraps
+      procedure Stream (From : U32; Count : Natural) is
+         First_Idx : constant Natural := Natural (From mod Ring_Size);
+         First     : constant Natural := Natural'Min (Buffer_Size - First_Idx, Count);
+      begin
+         profiler.Note_Level (ring_monitor.Level (USART2_Ring));
+         if First > 0 then
+            hal.SPI_Send_Block (DMA_Buffer (First_Idx)'Address, First);
+         end if;
+         if Count > First then
+            hal.SPI_Send_Block (DMA_Buffer (0)'Address, Count - First);
+         end if;
+      end Stream;
+
+      procedure Finish (Tail : Byte) is
+      begin
+         hal.SPI_DMA_End;
+         profiler.Stop (profiler.PUMP, Start);
+         Tail_Start := profiler.Start;
+         profiler.Report.Bytes := chunk_link.Last.Shifted;
+         Finish_Configuration (Tail);
+         profiler.Stop (profiler.TRAILER, Tail_Start);
+         Result := (if All_Done then chunk_link.DONE else chunk_link.FAIL);
+         chunk_link.Last.Us := Micros (Start, profiler.Start);
+      end Finish;
+
+      --  The next chunk and every held one after it, in order
+      procedure Shift is
+      begin
+         while Result = chunk_link.RUNNING and then Table (Slot_Of (Next)).State = HELD loop
+            declare
+               S    : Slot renames Table (Slot_Of (Next));
+               Data : constant U32 := S.Start + chunk_link.Header_Size;
+               Len  : constant Natural := Natural (S.Len);
+            begin
+               S.State := EMPTY;
+               Next := Next + 1;
+               chunk_link.Last.Shifted := chunk_link.Last.Shifted + U32 (Len);
+               if (S.Flags and chunk_link.Last_Flag) /= 0 then
+                  Stream (Data, Len - 1);
+                  Finish (Byte (Ring_Byte (Natural ((Data + U32 (Len) - 1) mod Ring_Size))));
+               else
+                  Stream (Data, Len);
+               end if;
+            end;
+         end loop;
+      end Shift;
+
+      --  A held chunk the DMA would reach within one more frame is given up
+      procedure Evict is
+         Margin : constant U32 := chunk_link.Header_Size + chunk_link.CRC_Size
+           + (if Chunk = 0 then chunk_link.Max_Chunk else U32 (Chunk));
+      begin
+         for S of Table loop
+            if S.State = HELD and then Recv - S.Start > Ring_Size - Margin then
+               S.State := NAKED;
+               chunk_link.Last.Evicted := chunk_link.Last.Evicted + 1;
+               Send_Reply (chunk_link.Nak, S.Seq);
+            end if;
+         end loop;
+      end Evict;
+
+      --  Up to the oldest byte still wanted: a held frame, or the parse point
+      procedure Release is
+         Upto : U32 := Parse;
+      begin
+         for S of Table loop
+            if S.State = HELD and then S.Start - Released < Upto - Released then
+               Upto := S.Start;
+            end if;
+         end loop;
+         if Upto /= Released then
+            ring_monitor.Consume (USART2_Ring, Natural (Upto - Released));
+            Released := Upto;
+         end if;
+      end Release;
+
+      --  Missing, in the window, and not held: ask for it
+      procedure Nak_Chunk (Seq : U16) is
+         S : Slot renames Table (Slot_Of (Seq));
+      begin
+         if Seq - Next < chunk_link.Slots and then S.State /= HELD then
+            S.State := NAKED;
+            S.Seq := Seq;
+            Send_Reply (chunk_link.Nak, Seq);
+         end if;
+      end Nak_Chunk;
+
+      --  A frame whose CRC is good
+      procedure Take (Seq, Len, Flags : U16) is
+         S       : Slot renames Table (Slot_Of (Seq));
+         Ahead   : constant U16 := Seq - Next;
+         Is_Last : constant Boolean := (Flags and chunk_link.Last_Flag) /= 0;
+         Gap     : U16 := Next;
+      begin
+         if (Flags and chunk_link.Probe_Flag) /= 0 then
+            Send_Reply (chunk_link.Ack, Seq);
+         elsif Result /= chunk_link.RUNNING or else Ahead >= 16#8000#
+           or else (Ahead < chunk_link.Slots and then S.State = HELD)
+         then
+            chunk_link.Last.Dups := chunk_link.Last.Dups + 1;
+            Send_Reply (chunk_link.Ack, Seq);
+         elsif Ahead < chunk_link.Slots then
+            --  Every chunk but the last is the length of the first
+            if Chunk /= 0 and then (if Is_Last then Len > Chunk else Len /= Chunk) then
+               Finish (16#FF#);
+               Result := chunk_link.FAIL;
+               Send_Reply (chunk_link.Nak, Seq);
+               return;
+            end if;
+            if Chunk = 0 and then not Is_Last then
+               Chunk := Len;
+            end if;
+            S := (HELD, Seq, Parse, Len, Flags);
+            if Ahead /= 0 then
+               chunk_link.Last.Held := chunk_link.Last.Held + 1;
+               while Gap /= Seq loop
+                  if Table (Slot_Of (Gap)).State = EMPTY then
+                     Nak_Chunk (Gap);
+                  end if;
+                  Gap := Gap + 1;
+               end loop;
+            end if;
+            Shift;
+            Send_Reply (chunk_link.Ack, Seq);
+         end if;
+         --  Past the window: the host's to resend once it has the replies
+      end Take;
+
+      procedure Drain is
+         Avail, Frame, CRC : U32;
+         Seq, Len, Flags   : U16;
+      begin
+         loop
+            Evict;
+            Avail := Recv - Parse;
+            exit when Avail < chunk_link.Header_Size;
+            Seq := Half (Parse + 4);
+            Len := Half (Parse + 6);
+            Flags := Half (Parse + 8);
+            Frame := chunk_link.Header_Size + U32 (Len) + chunk_link.CRC_Size;
+            --  Not a frame this ring can hold: look again one byte on
+            if Ring_Word (Natural (Parse mod Ring_Size)) /= chunk_link.Magic
+              or else Half (Parse + 10) /= chunk_link.Header_Check (Seq, Len, Flags)
+              or else Len > chunk_link.Max_Chunk
+              or else (Len = 0) /= ((Flags and chunk_link.Probe_Flag) /= 0)
+              or else Frame > Ring_Size / 2
+            then
+               Parse := Parse + 1;
+               chunk_link.Last.Skipped := chunk_link.Last.Skipped + 1;
+            else
+               exit when Avail < Frame;
+               chunk_link.Last.Frames := chunk_link.Last.Frames + 1;
+               CRC := 16#FFFF_FFFF#;
+               for I in U32 range 4 .. Frame - chunk_link.CRC_Size - 1 loop
+                  CRC := chunk_link.CRC_Update
+                    (CRC, Interfaces.Unsigned_8 (Ring_Byte (Natural ((Parse + I) mod Ring_Size))));
+               end loop;
+               if (not CRC) /= Ring_Word (Natural ((Parse + Frame - chunk_link.CRC_Size) mod Ring_Size)) then
+                  --  The header may be noise too: the next frame could start inside
+                  chunk_link.Last.Bad_CRC := chunk_link.Last.Bad_CRC + 1;
+                  if (Flags and chunk_link.Probe_Flag) = 0 then
+                     Nak_Chunk (Seq);
+                  end if;
+                  Parse := Parse + 1;
+               else
+                  Take (Seq, Len, Flags);
+                  Parse := Parse + Frame;
+                  Release;
+               end if;
+            end if;
+         end loop;
+         Release;
+      end Drain;
+   begin
+      hal.SPI_DMA_Begin;
+      loop
+         Write_Idx := Poll_USART2_Ring;
+         if USART2_Ring.Produced /= Recv then
+            Recv := USART2_Ring.Produced;
+            Heard := Ada.Real_Time.Clock;
+         end if;
+         Drain;
+         if Result /= chunk_link.RUNNING then
+            exit when Ada.Real_Time.Clock > Heard + Linger;
+         elsif Ada.Real_Time.Clock > Heard + Resume_Timeout then
+            --  Nobody came back: out of Shift-DR, and the status says so
+            Finish (16#FF#);
+            Result := chunk_link.FAIL;
+            exit;
+         end if;
+      end loop;
+      Close_USART2_Stream;
+      chunk_link.Last.Result := Result;
+   end Stream_Chunked;
+
+   --  Programming manifest (manifest): header at 0, the step table behind
+   --  it, then each step's data in step order. Nothing is clocked until the
+   --  whole table checks out; the first step that fails ends the run, and
+   --  the rest of the stream is read off so it never reaches the command
+   --  line. INIT_CONFIG has already reset and initialised the TAP
+   procedure Run_Manifest is
+      use manifest;
+      use type Interfaces.Unsigned_8;
+      use type Interfaces.Unsigned_16;
+      use type Jtag_Test_Config.Firmware_Load_Kind;
+      use type riscv_debug.Result;
+      use type neorv32_boot.Result;
+      H     : constant manifest.Header :=
+        (Ring_Word (0), Ring_Word (4), Ring_Word (8), Ring_Word (12));
+      Table : Step_Table;
+      CRC   : Interfaces.Unsigned_32 := 16#FFFF_FFFF#;
+      Start : constant Ada.Real_Time.Time := profiler.Start;
+      T     : Ada.Real_Time.Time;
+      Fresh : Boolean := True;    --  The TAP as INIT_CONFIG left it
+      Open  : Boolean := True;    --  USART2 RX still the DMA's
+
+      function Avail return Natural is
+        ((Write_Idx + Buffer_Size - Read_Idx) mod Buffer_Size);
+
+      procedure Take (Count : Natural) is
+      begin
+         Read_Idx := (Read_Idx + Count) mod Buffer_Size;
+         ring_monitor.Consume (USART2_Ring, Count);
+      end Take;
+
+      --  Count bytes past Read_Idx, or False once the stream goes quiet
+      function Wait_Bytes (Count : Natural) return Boolean is
+         Seen  : Natural := Write_Idx;
+         Quiet : Natural := 0;
+      begin
+         loop
+            Write_Idx := Poll_USART2_Ring;
+            if Avail >= Count then
+               return True;
+            elsif Write_Idx /= Seen then
+               Seen := Write_Idx;
+               Quiet := 0;
+            else
+               Quiet := Quiet + 1;
+               exit when Quiet >= Stable_Threshold;
+            end if;
+         end loop;
+         return False;
+      end Wait_Bytes;
+
+      --  Ring bytes in half-words into flash; the number written
+      function Program (Length : Natural; Cache : Boolean) return Natural is
+         Offset : Natural := 0;
+         Half   : Interfaces.Unsigned_16;
+      begin
+         while Offset < Length and then Wait_Bytes (2) loop
+            Half := Interfaces.Unsigned_16 (Ring_Byte (Read_Idx))
+              or Interfaces.Unsigned_16 (Ring_Byte (Read_Idx + 1)) * 256;
+            if Offset mod hal.Flash_Page_Size = 0 then
+               if Cache then
+                  hal.Cache_Erase_Page (Offset);
+               else
+                  hal.Stage_Erase_Page (Offset);
+               end if;
+            end if;
+            if Cache then
+               hal.Cache_Program (Offset, Half);
+            else
+               hal.Stage_Program (Offset, Half);
+            end if;
+            Take (2);
+            Offset := Offset + 2;
+         end loop;
+         return Offset;
+      end Program;
+
+      function SRAM (S : Step) return Outcome is
+         Left       : Natural := Natural (S.Length) - 1;
+         Span       : Natural;
+         Tail       : Byte := 16#FF#;
+         Pump_Start : Ada.Real_Time.Time;
+         Tail_Start : Ada.Real_Time.Time;
+      begin
+         if not Fresh then
+            Reset_TAP;
+            Init_Configuration;
+         end if;
+         Fresh := False;
+         Begin_Bitstream;
+         Pump_Start := profiler.Start;
+         hal.SPI_DMA_Begin;
+         while Left > 0 and then Wait_Bytes (1) loop
+            profiler.Note_Level (ring_monitor.Level (USART2_Ring));
+            Span := Natural'Min (Natural'Min (Buffer_Size - Read_Idx, Avail), Left);
+            hal.SPI_Send_Block (DMA_Buffer (Read_Idx)'Address, Span);
+            Take (Span);
+            Left := Left - Span;
+         end loop;
+         hal.SPI_DMA_End;
+         profiler.Stop (profiler.PUMP, Pump_Start);
+
+         --  A short body still leaves Shift-DR; the status shows the failure
+         Tail_Start := profiler.Start;
+         if Left = 0 and then Wait_Bytes (1) then
+            Tail := DMA_Buffer (Read_Idx);
+            Take (1);
+         else
+            Left := Left + 1;
+         end if;
+         Finish_Configuration (Tail);
+         profiler.Stop (profiler.TRAILER, Tail_Start);
+         profiler.Report.Bytes := S.Length - Interfaces.Unsigned_32 (Left);
+         Last.Bytes := Last.Bytes + profiler.Report.Bytes;
+         Last.Status := fanout.Status (1);
+         return (if Left > 0 then SHORT_DATA else DONE);
+      end SRAM;
+
+      function Verify (After : Step; S : Step) return Outcome is
+         use type boot_cache.Action;
+      begin
+         if Kind (After) = Step_SRAM then
+            return (if All_Done and then ((fanout.Status (1) xor S.Value) and S.Mask) = 0
+                    then DONE else VERIFY_FAIL);
+         end if;
+         declare
+            B : boot_cache.Header with Import, Address => hal.Cache_Base;
+         begin
+            if boot_cache.Decide (B, Jtag_Test_Config.Cache_Size, Skip => False) /= boot_cache.LOAD
+              or else boot_cache.Verify
+                (B, hal.CRC32 (hal.Cache_Base + boot_cache.Header_Size,
+                               Natural (boot_cache.Padded (B.Length)))) /= boot_cache.LOAD
+            then
+               return VERIFY_FAIL;
+            end if;
+         end;
+         return DONE;
+      end Verify;
+
+      --  From the stage, as a session starts its executable at DONE
+      function Start_Firmware (S : Step) return Outcome is
+         Debug : constant Boolean :=
+           Arg (S) = Start_Debug
+           or else (Arg (S) = Start_Default
+                    and then Jtag_Test_Config.Firmware_Load = Jtag_Test_Config.Debug);
+         Good  : Boolean;
+      begin
+         Close_USART2_Stream;
+         Open := False;
+         From_Stage := True;
+         Stage_Read := 0;
+         if Debug then
+            Load_Firmware_Debug;
+            Good := riscv_debug.Last.Result = riscv_debug.LOADED;
+         else
+            Send_Firmware;
+            Good := neorv32_boot.Last.Result = neorv32_boot.BOOTED;
+         end if;
+         From_Stage := False;
+         return (if Good then DONE else START_FAIL);
+      end Start_Firmware;
+
+      function Run_Step (I : Step_Index) return Outcome is
+         S : Step renames Table (I);
+      begin
+         case Kind (S) is
+            when Step_IDCODE =>
+               Discover_Chain;
+               Fresh := False;
+               if not Chain_Valid or else Natural (Arg (S)) > Device_Count then
+                  return NO_DEVICE;
+               elsif Arg (S) > 0 then
+                  Select_Device (Natural (Arg (S)));
+               end if;
+               Last.IDCODE := Devices (Active_Device).IDCODE;
+               return (if ((Last.IDCODE xor S.Value) and S.Mask) = 0 then DONE else WRONG_IDCODE);
+            when Step_SRAM =>
+               return SRAM (S);
+            when Step_Flash =>
+               Last.Flashed := Interfaces.Unsigned_32 (Program (Natural (S.Length), Cache => True));
+               return (if Last.Flashed = S.Length then DONE else SHORT_DATA);
+            when Step_Verify =>
+               return Verify (Table (I - 1), S);
+            when Step_Load =>
+               Last.Staged := Interfaces.Unsigned_32 (Program (Natural (S.Length), Cache => False));
+               session_image.Last.Staged := Last.Staged;
+               if Last.Staged /= S.Length then
+                  return SHORT_DATA;
+               end if;
+               return (if hal.CRC32 (hal.Stage_Base, Natural (S.Length)) = S.Value
+                       then DONE else BAD_FIRMWARE);
+            when others =>
+               return Start_Firmware (S);
+         end case;
+      end Run_Step;
+   begin
+      Last.Steps := H.Steps;
+      Last.Result := DONE;
+      Take (Header_Size);
+      if H.Steps in 1 .. Max_Steps and then Wait_Bytes (Natural (H.Steps) * Step_Size) then
+         for I in 1 .. Natural (H.Steps) loop
+            Table (I) := (Ring_Word (Read_Idx), Ring_Word (Read_Idx + 4),
+                          Ring_Word (Read_Idx + 8), Ring_Word (Read_Idx + 12));
+            for B in 0 .. Step_Size - 1 loop
+               CRC := chunk_link.CRC_Update (CRC, Interfaces.Unsigned_8 (Ring_Byte (Read_Idx + B)));
+            end loop;
+            Take (Step_Size);
+         end loop;
+      end if;
+
+      if not Valid (H, Table, not CRC, Jtag_Test_Config.Stage_Size, Jtag_Test_Config.Cache_Size) then
+         Last.Result := BAD_MANIFEST;
+      else
+         for I in 1 .. Natural (H.Steps) loop
+            Last.Step := Interfaces.Unsigned_32 (I);
+            T := profiler.Start;
+            Last.Result := Run_Step (I);
+            Last.Step_Us (I) := Micros (T, profiler.Start);
+            exit when Last.Result /= DONE;
+         end loop;
+      end if;
+
+      if Open then
+         while Wait_Bytes (1) loop
+            Take (Avail);
+         end loop;
+         Close_USART2_Stream;
+      end if;
+      Last.Total_Us := Micros (Start, profiler.Start);
+   end Run_Manifest;
+
+   procedure Send_Configuration_Bitstream is
+      Pump_Start : Ada.Real_Time.Time;
+      Tail_Start : Ada.Real_Time.Time;
+      Old_Read   : Natural;
+      Sent       : Natural := 0;
+      Last_Byte  : Byte;
+      Is_Image   : Boolean;
+   begin
+      --  A new session: wait for fresh data before the silence timeout.
+      --  Open_USART2_Stream restarted the ring, so the data starts at 0
+      Has_Data := False;
+      Stable_Count := 0;
+      TXE_Spins := 0;
+      Read_Idx := 0;
+      session_image.Last := (others => <>);
+      chunk_link.Last := (others => <>);
+      manifest.Last := (others => <>);
+      Last_Write_Idx := Buffer_Size;
+      Start_USART2_Ring (Read_Idx);
+
+      --  A manifest moves the TAP itself, step by step
+      Is_Image := Wait_Wire_Header;
+      if Is_Image and then Ring_Word (0) = manifest.Magic then
+         Run_Manifest;
+         return;
+      end if;
+      Begin_Bitstream;
+
+      --  A host-split image carries its own length and last byte; a
+      --  chunked one checks each frame as it comes
+      if Is_Image then
+         if Ring_Word (0) = chunk_link.Magic then
+            Stream_Chunked;
+            return;
+         end if;
+         declare
+            H : constant wire_image.Header :=
+              (Ring_Word (0), Ring_Word (4), Ring_Word (8), Ring_Word (12));
+            S : constant session_image.Header :=
+              (Ring_Word (0), Ring_Word (4), Ring_Word (8), Ring_Word (12), Ring_Word (16));
+         begin
+            if wire_image.Valid (H) then
+               Stream_Wire_Image (Natural (H.Body_Length), Byte (wire_image.Tail_Byte (H)));
+               return;
+            elsif session_image.Valid (S, Jtag_Test_Config.Stage_Size) then
+               Stream_Session (S);
+               return;
+            end if;
+         end;
+      end if;
+
+      --  Raw bitstream: the bytes so far are still unread at Read_Idx
       loop
-         Write_Idx := Buffer_Size - Natural (DMA1_Periph.CNDTR5.NDT);
+         Write_Idx := Poll_USART2_Ring;
 
          --  Check if the write pointer has moved since last iteration
          if Write_Idx /= Last_Write_Idx then
@@ -203,7 +1118,12 @@ package body mcu_to_fpga is
 
          --  Process any newly arrived bytes, keeping the last one in reserve
          if Write_Idx /= Read_Idx then
+            if not Has_Data then
+               Pump_Start := profiler.Start; --  First bytes from the host
+            end if;
             Has_Data := True;
+            profiler.Note_Level (ring_monitor.Level (USART2_Ring));
+            Old_Read := Read_Idx;
 
             if Write_Idx > Read_Idx then
                for I in Read_Idx .. Write_Idx - 2 loop
@@ -226,29 +1146,23 @@ package body mcu_to_fpga is
                   Read_Idx := Write_Idx - 1;
                end if;
             end if;
+            Sent := Sent + (Read_Idx + Buffer_Size - Old_Read) mod Buffer_Size;
+            ring_monitor.Consume (USART2_Ring, (Read_Idx + Buffer_Size - Old_Read) mod Buffer_Size);
          end if;
 
          --  Timeout
          if Has_Data and then Stable_Count >= Stable_Threshold then
-            SPI_Disable;
-            Transceive_Last_Byte (DMA_Buffer (Read_Idx));
+            --  The pump time includes the silence that ended it
+            profiler.Stop (profiler.PUMP, Pump_Start);
+            Tail_Start := profiler.Start;
+            profiler.Report.Bytes := Interfaces.Unsigned_32 (Sent + 1);
+            profiler.Report.TXE_Spins := TXE_Spins;
+            Last_Byte := DMA_Buffer (Read_Idx);
             Read_Idx := (Read_Idx + 1) mod Buffer_Size;
-            Pulse_TCK; -- UPDATE-DR
-            Pin_Low (TMS_Pin);
-            Pulse_TCK; -- RUN-TEST/IDLE
-            cmd := (0, 1, 0, 1, 0, 0, 0, 0); -- (IR=0x0A)
-            Send_Command (cmd);
-            Read_TDO;
-            cmd := (0, 0, 0, 1, 0, 0, 0, 0); -- (IR=0x08)
-            Send_Command (cmd);
-            --  Read SRAM
-            cmd := (0, 1, 0, 1, 1, 1, 0, 0); -- IR=0x3A)
-            Send_Command (cmd);
-            cmd := (0, 1, 0, 0, 0, 0, 0, 0); -- (IR=0x02)
-            Send_Command (cmd);
-            cmd := (1, 0, 0, 0, 0, 0, 1, 0); -- (IR=0x41)
-            Send_Command (cmd);
-            Read_TDO;
+            ring_monitor.Consume (USART2_Ring, 1);
+            Close_USART2_Stream;
+            Finish_Configuration (Last_Byte);
+            profiler.Stop (profiler.TRAILER, Tail_Start);
             exit;
 
          end if;
@@ -257,119 +1171,349 @@ package body mcu_to_fpga is
    end Send_Configuration_Bitstream;
 
    procedure Send_Firmware is
-      --  Read indices into the two circular DMA buffers for this session
-      U2_Read_Idx      : Natural;
-      U1_Read_Idx      : Natural;
-      U2_Write         : Natural;
-      U1_Write         : Natural;
-      Last_U2_Write    : Natural;
-      Stable_Count     : Natural := 0;
-      Stable_Threshold : constant := 10_000;
-      Has_Data         : Boolean := False;
-   begin
-      --  Wait for any in-flight USART2 TX to finish before reconfiguring
-      while USART2_Periph.ISR.TC = 0 loop
-         null;
-      end loop;
+      use neorv32_boot;
+      use type Ada.Real_Time.Time_Span;
+      --  USART1 read index; the executable comes through Image_*
+      U1_Read_Idx : Natural;
+      Ready       : Natural;
+      C           : Interfaces.Unsigned_8;
+      H           : neorv32_boot.Header;
+      Total       : Natural;
+      Sent        : Natural := 0;
+      Sum         : Summer;
+      Quiet_Since : Ada.Real_Time.Time;
+      T           : Ada.Real_Time.Time;
+      Reply_Time  : constant Ada.Real_Time.Time_Span := Ada.Real_Time.Milliseconds (250);
+      Quiet_Time  : constant Ada.Real_Time.Time_Span := Ada.Real_Time.Seconds (1);
 
-      --  Reconfigure USART2 to 19200 baud to match USART1 / Tang Nano side
-      USART2_Periph.CR1 := (UE => 0, others => <>);
-      USART2_Periph.BRR :=
-        (DIV_Mantissa => 16#9C#, DIV_Fraction => 16#04#, others => <>);
-      USART2_Periph.CR3.DMAR := 1;
-      USART2_Periph.CR1 := (UE => 1, TE => 1, RE => 1, others => <>);
-
-      --  Reconfigure DMA1 Channel 5 (USART2 RX) with updated baud — disable,
-      --  reload CNDTR, re-enable so the channel is in a clean state.
-      DMA1_Periph.CCR5.EN := 0;
-      DMA1_Periph.CNDTR5.NDT := UInt16 (Buffer_Size);
-      DMA1_Periph.CCR5.EN := 1;
-
-      U2_Read_Idx := Buffer_Size - Natural (DMA1_Periph.CNDTR5.NDT);
-      U1_Read_Idx := Buffer_Size - Natural (DMA1_Periph.CNDTR3.NDT);
-      Last_U2_Write := U2_Read_Idx;
-
-      delay 0.1;
-      USART1_Periph.TDR.TDR := RDR_RDR_Field (16#75#);
-      delay 0.1;
-      USART1_Periph.TDR.TDR := RDR_RDR_Field (16#75#);
-
-      while U2_Read_Idx = Buffer_Size - Natural (DMA1_Periph.CNDTR5.NDT) loop
-         null;
-      end loop;
+      type Reply is (MATCHED, FAILED, TIMED_OUT);
 
-      loop
-         --  Snapshot write pointer ONCE at the top before any draining
-         U2_Write := Buffer_Size - Natural (DMA1_Periph.CNDTR5.NDT);
+      --  Bootloader output goes on to the host, looked at on the way
+      function Expect (Pattern, Fail : String; Within : Ada.Real_Time.Time_Span) return Reply is
+         Deadline  : constant Ada.Real_Time.Time := Ada.Real_Time.Clock + Within;
+         U1_Write  : Natural;
+         M, F      : Matcher;
+         Hit, Miss : Boolean;
+         C         : Character;
+      begin
+         loop
+            U1_Write := Poll_USART1_Ring;
+            while U1_Read_Idx /= U1_Write loop
+               C := Character'Val (DMA1_Buffer (U1_Read_Idx));
+               U1_Read_Idx := (U1_Read_Idx + 1) mod Buffer1_Size;
+               ring_monitor.Consume (USART1_Ring, 1);
+               UART_Put (USART2, Character'Pos (C));
+               Feed (M, Pattern, C, Hit);
+               Feed (F, Fail, C, Miss);
+               if Hit then
+                  return MATCHED;
+               elsif Miss then
+                  return FAILED;
+               end if;
+            end loop;
+            exit when Ada.Real_Time.Clock > Deadline;
+         end loop;
+         return TIMED_OUT;
+      end Expect;
 
-         if U2_Write /= Last_U2_Write then
-            Stable_Count := 0;
-            Last_U2_Write := U2_Write;
-            Has_Data := True;
-         else
-            if Has_Data then
-               Stable_Count := Stable_Count + 1;
+      --  The countdown may not have started yet: ask again a few times
+      function Wait_Prompt return Boolean is
+      begin
+         for Try in 1 .. 8 loop
+            UART_Put (USART1, Character'Pos (Key_Help));
+            if Expect (Prompt, "", Reply_Time) = MATCHED then
+               return True;
             end if;
-         end if;
-
-         --  Drain only up to the snapshot — do NOT re-read CNDTR5 here
-         while U2_Read_Idx /= U2_Write loop
-            while USART1_Periph.ISR.TXE = 0 loop
-               null;
-            end loop;
-            USART1_Periph.TDR.TDR := RDR_RDR_Field (DMA_Buffer (U2_Read_Idx));
-            U2_Read_Idx := (U2_Read_Idx + 1) mod Buffer_Size;
          end loop;
+         return False;
+      end Wait_Prompt;
 
-         --  Tang Nano --> Laptop (unchanged)
-         U1_Write := Buffer_Size - Natural (DMA1_Periph.CNDTR3.NDT);
-         while U1_Read_Idx /= U1_Write loop
-            while USART2_Periph.ISR.TXE = 0 loop
-               null;
-            end loop;
-            USART2_Periph.TDR.TDR := RDR_RDR_Field (DMA1_Buffer (U1_Read_Idx));
-            U1_Read_Idx := (U1_Read_Idx + 1) mod Buffer_Size;
+      procedure Put_Text (S : String) is
+      begin
+         for C of S loop
+            UART_Put (USART2, Character'Pos (C));
          end loop;
+      end Put_Text;
 
-         exit when Has_Data and then Stable_Count >= Stable_Threshold;
-      end loop;
+      procedure Finish (R : neorv32_boot.Result) is
+      begin
+         neorv32_boot.Last.Result := R;
+         neorv32_boot.Last.Bytes := Interfaces.Unsigned_32 (Sent);
+         UART_Flush (USART1);
+         Put_Text (ASCII.CR & ASCII.LF & "fw " & neorv32_boot.Result'Image (R)
+                   & " bytes" & Natural'Image (Sent) & ASCII.CR & ASCII.LF);
+      end Finish;
+   begin
+      neorv32_boot.Last := (others => <>);
+
+      --  Bridged from the host: USART2 goes down to USART1's 19200. A
+      --  staged image is sent from flash and USART2 stays as it is
+      if not From_Stage then
+         --  Wait for any in-flight USART2 TX to finish before reconfiguring
+         UART_Flush (USART2);
+
+         --  Reconfigure USART2 to 19200 baud to match USART1 / Tang Nano side
+         UART_Set_Baud (USART2, 19_200);
 
-      while USART1_Periph.ISR.TC = 0 loop
-         null;
+         --  Restart the USART2 RX DMA channel with the updated baud
+         DMA_Restart (USART2, Buffer_Size);
+
+         Read_Idx := Buffer_Size - DMA_Remaining (USART2);
+         Start_USART2_Ring (Read_Idx);
+      end if;
+      U1_Read_Idx := Buffer1_Size - DMA_Remaining (USART1);
+      Start_USART1_Ring (U1_Read_Idx);
+
+      --  The header first: nothing reaches the bootloader unless it is
+      --  a NEORV32 executable
+      if not Wait_Image_Header (Quiet_Time) then
+         Finish (SHORT_IMAGE);
+         return;
+      end if;
+      H := (Image_Word (0), Image_Word (4), Image_Word (8));
+      if Check (H) /= BOOTED then
+         Finish (Check (H));
+         return;
+      end if;
+      Total := Header_Size + Natural (H.Size);
+
+      T := profiler.Start;
+      if not Wait_Prompt then
+         Finish (NO_PROMPT);
+         return;
+      end if;
+      UART_Put (USART1, Character'Pos (Key_Upload));
+      if Expect (Awaiting, "", Reply_Time) /= MATCHED then
+         Finish (NO_PROMPT);
+         return;
+      end if;
+      neorv32_boot.Last.Handshake_Us := Micros (T, profiler.Start);
+
+      --  Exactly the executable, counted: no silence timeout at the end
+      T := profiler.Start;
+      Quiet_Since := T;
+      while Sent < Total loop
+         Ready := Image_Bytes;
+         if Ready = 0 then
+            exit when Ada.Real_Time.Clock - Quiet_Since > Quiet_Time;
+         else
+            for I in 1 .. Natural'Min (Ready, Total - Sent) loop
+               C := Interfaces.Unsigned_8 (Image_Byte (0));
+               UART_Put (USART1, C);
+               if Sent >= Header_Size then
+                  Add (Sum, C);
+               end if;
+               Image_Skip (1);
+               Sent := Sent + 1;
+            end loop;
+            Quiet_Since := Ada.Real_Time.Clock;
+         end if;
       end loop;
+      if Sent < Total then
+         Finish (SHORT_IMAGE);
+         return;
+      end if;
+
+      --  The bootloader checks the sum too; ours says which error it was
+      case Expect (Ack, Error, Reply_Time) is
+         when MATCHED =>
+            null;
+         when FAILED | TIMED_OUT =>
+            Finish (if Sum_Ok (Sum, H) then REJECTED else BAD_CHECKSUM);
+            return;
+      end case;
+      neorv32_boot.Last.Upload_Us := Micros (T, profiler.Start);
+
+      T := profiler.Start;
+      if Expect (Prompt, "", Reply_Time) /= MATCHED then
+         Finish (NO_PROMPT);
+         return;
+      end if;
+      UART_Put (USART1, Character'Pos (Key_Execute));
+      if Expect (Booting, "", Reply_Time) /= MATCHED then
+         Finish (NO_PROMPT);
+         return;
+      end if;
+      neorv32_boot.Last.Boot_Us := Micros (T, profiler.Start);
+      Finish (BOOTED);
+   end Send_Firmware;
+
+   procedure Load_Firmware_Debug is
+      use riscv_debug;
+      use type Ada.Real_Time.Time_Span;
+      H           : neorv32_boot.Header;
+      Left        : Natural;
+      Quiet_Since : Ada.Real_Time.Time;
+      T           : Ada.Real_Time.Time;
+      Quiet_Time  : constant Ada.Real_Time.Time_Span := Ada.Real_Time.Seconds (1);
+
+      procedure Finish (R : riscv_debug.Result) is
+      begin
+         if not From_Stage then
+            Close_USART2_Stream;
+         end if;
+         riscv_debug.Last.Result := R;
+         riscv_debug.Last.Load_Us := Micros (T, profiler.Start);
+      end Finish;
+   begin
+      riscv_debug.Last := (others => <>);
+      if not From_Stage then
+         --  The caller opened the stream before the host was told to send
+         Read_Idx := 0;
+         Start_USART2_Ring (Read_Idx);
+      end if;
+      T := profiler.Start;
+
+      --  Nothing is clocked into the FPGA unless it is a NEORV32 executable
+      if not Wait_Image_Header (Quiet_Time) then
+         Finish (SHORT_IMAGE);
+         return;
+      end if;
+      H := (Image_Word (0), Image_Word (4), Image_Word (8));
+      case neorv32_boot.Check (H) is
+         when neorv32_boot.BOOTED        => null;
+         when neorv32_boot.BAD_SIGNATURE => Finish (BAD_SIGNATURE); return;
+         when others                     => Finish (BAD_SIZE); return;
+      end case;
+      Image_Skip (neorv32_boot.Header_Size);
 
-      --  Clear TC flag by writing to ICR before sending next byte
-      USART1_Periph.ICR.TCCF := 1;
+      T := profiler.Start;
+      riscv_debug.Last.Result := Connect;
+      if riscv_debug.Last.Result /= LOADED then
+         Finish (riscv_debug.Last.Result);
+         return;
+      end if;
 
-      while USART1_Periph.ISR.TXE = 0 loop
-         null;
+      --  One word at a time as it arrives; Size is whole words
+      Begin_Block (IMEM_Base);
+      Left := Natural (H.Size);
+      Quiet_Since := Ada.Real_Time.Clock;
+      while Left > 0 loop
+         if Image_Bytes >= 4 then
+            Write_Word (Image_Word (0));
+            Image_Skip (4);
+            Left := Left - 4;
+            riscv_debug.Last.Bytes := riscv_debug.Last.Bytes + 4;
+            Quiet_Since := Ada.Real_Time.Clock;
+         elsif Ada.Real_Time.Clock - Quiet_Since > Quiet_Time then
+            Finish (SHORT_IMAGE);
+            return;
+         end if;
       end loop;
-      USART1_Periph.TDR.TDR := RDR_RDR_Field (16#65#);
+      if End_Block /= LOADED then
+         Finish (BUS_ERROR);
+         return;
+      end if;
+      Finish (Resume (IMEM_Base));
+   end Load_Firmware_Debug;
+
+   --  `baud`: the host's side runs in Host_Tools/lib/baud_host.c. The frames
+   --  and patterns come through the DMA ring like a bitstream; a switch waits
+   --  for the bytes ahead of it to leave the shift register
+   procedure Negotiate_Baud is
+      use type baud_link.Phase;
+      Start : constant Ada.Real_Time.Time := Ada.Real_Time.Clock;
+      S     : baud_link.Session;
+      Recv  : Interfaces.Unsigned_32 := 0;
 
-      --  Wait for this byte to finish too
-      while USART1_Periph.ISR.TC = 0 loop
-         null;
+      function Now return Interfaces.Unsigned_32 is
+        (Micros (Start, Ada.Real_Time.Clock) / 1000);
+   begin
+      Open_USART2_Stream;
+      Start_USART2_Ring (0);
+      baud_link.Start (S, Now);
+      while S.State /= baud_link.FINISHED or else S.Tx_Len > 0 loop
+         Write_Idx := Poll_USART2_Ring;
+         while Recv /= USART2_Ring.Produced loop
+            baud_link.Rx (S, Interfaces.Unsigned_8 (DMA_Buffer (Natural (Recv mod Buffer_Size))), Now);
+            Recv := Recv + 1;
+            ring_monitor.Consume (USART2_Ring, 1);
+         end loop;
+         baud_link.Tick (S, Now);
+         for I in 0 .. S.Tx_Len - 1 loop
+            UART_Put (USART2, S.Tx (I));
+         end loop;
+         S.Tx_Len := 0;
+         if S.Switch then
+            UART_Flush (USART2);
+            UART_Set_Baud (USART2, Positive (baud_link.Rates (S.Rate)));
+            S.Switch := False;
+         end if;
       end loop;
+      Close_USART2_Stream;
+   end Negotiate_Baud;
 
+   --  After an upload USART2 carries the FPGA's console (19200 baud, or
+   --  the session's own rate after a session)
+   procedure Relay_Console is
+      U1_Read_Idx : Natural := Buffer1_Size - DMA_Remaining (USART1);
+      U1_Write    : Natural;
+   begin
       loop
-         null;
+         U1_Write := Poll_USART1_Ring;
+         ring_monitor.Consume (USART1_Ring, (U1_Write + Buffer1_Size - U1_Read_Idx) mod Buffer1_Size);
+         while U1_Read_Idx /= U1_Write loop
+            UART_Put (USART2, Interfaces.Unsigned_8 (DMA1_Buffer (U1_Read_Idx)));
+            U1_Read_Idx := (U1_Read_Idx + 1) mod Buffer1_Size;
+         end loop;
       end loop;
-   end Send_Firmware;
+   end Relay_Console;
 
 
    task body M2F is
+      use type Jtag_Test_Config.Firmware_Load_Kind;
+      use type manifest.Outcome;
    begin
       loop
          case Current_State.Get is
-            when IDLE =>
+            when BOOT | IDLE =>
                null;
             when INIT_CONFIG =>
+               profiler.Begin_Session;
                Reset_TAP;
                Init_Configuration;
+               Open_USART2_Stream; --  Before H2M tells the host to send
+               Current_State.Set (IDLE);
             when PROG_BITSTREAM =>
                Send_Configuration_Bitstream;
+               Current_State.Set (IDLE);
             when PROG_FIRMWARE =>
                Send_Firmware;
+               Relay_Console;
+            when PROG_DEBUG =>
+               Load_Firmware_Debug;
+               Current_State.Set (IDLE);
+            when SCAN_CHAIN =>
+               Discover_Chain;
+               Current_State.Set (IDLE);
+            when NEGOTIATE_BAUD =>
+               Negotiate_Baud;
+               Current_State.Set (IDLE);
+            when PROG_SSPI =>
+               sspi.Program_Bitstream;
+               Close_USART2_Stream;
+               Current_State.Set (IDLE);
+            when RUN_SEQUENCE =>
+               Discover_Chain;
+               profiler.Begin_Session;
+               Reset_TAP;
+               Init_Configuration;
+               Open_USART2_Stream;
+               Send_Configuration_Bitstream;
+               if session_image.Last.Frames > 0 then
+                  null;   --  A session: the staged executable went up at DONE
+               elsif manifest.Last.Result /= manifest.NOT_RUN then
+                  null;   --  A manifest: its Start step, if it had one
+               elsif Jtag_Test_Config.Firmware_Load = Jtag_Test_Config.Debug then
+                  Open_USART2_Stream;
+                  Load_Firmware_Debug;
+                  UART_Flush (USART2);
+                  UART_Set_Baud (USART2, 19_200);
+                  UART_Set_Baud (USART1, 19_200);
+               else
+                  Send_Firmware;
+               end if;
+               Relay_Console; --  USART1 to USART2 from here on
             when ESCAPE =>
                exit;
          end case;
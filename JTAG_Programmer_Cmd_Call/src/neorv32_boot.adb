@@ -0,0 +1,63 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        neorv32_boot.adb
+--  Description: Package body for the NEORV32 bootloader protocol pieces
+--               that do not touch hardware: the executable header check,
+--               the checksum over the image and the prompt matcher.
+--
+--  Components:
+--               Check  -- Signature, then size (non-zero, whole words,
+--                         at most Max_Size)
+--               Add    -- Image byte into the little-endian word sum
+--               Sum_Ok -- Sum plus the header checksum is zero
+--               Feed   -- One console character against a pattern
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body neorv32_boot is
+
+   function Check (H : Header) return Result is
+   begin
+      if H.Signature /= Signature then
+         return BAD_SIGNATURE;
+      elsif H.Size = 0 or else H.Size mod 4 /= 0 or else H.Size > Max_Size then
+         return BAD_SIZE;
+      end if;
+      return BOOTED;
+   end Check;
+
+   procedure Add (S : in out Summer; B : Unsigned_8) is
+   begin
+      S.Word := S.Word or Shift_Left (Unsigned_32 (B), 8 * S.Count);
+      S.Count := S.Count + 1;
+      if S.Count = 4 then
+         S.Sum := S.Sum + S.Word;
+         S.Word := 0;
+         S.Count := 0;
+      end if;
+   end Add;
+
+   function Sum_Ok (S : Summer; H : Header) return Boolean is
+     (S.Count = 0 and then S.Sum + H.Checksum = 0);
+
+   procedure Feed (M : in out Matcher; Pattern : String; C : Character; Hit : out Boolean) is
+   begin
+      Hit := False;
+      if Pattern'Length = 0 then
+         return;
+      end if;
+      if Pattern (Pattern'First + M.Pos) = C then
+         M.Pos := M.Pos + 1;
+      elsif Pattern (Pattern'First) = C then
+         M.Pos := 1;
+      else
+         M.Pos := 0;
+      end if;
+      if M.Pos = Pattern'Length then
+         M.Pos := 0;
+         Hit := True;
+      end if;
+   end Feed;
+
+end neorv32_boot;
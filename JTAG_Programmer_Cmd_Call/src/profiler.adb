@@ -0,0 +1,80 @@
+pragma Style_Checks (Off);
+with Ada.Real_Time; use Ada.Real_Time;
+------------------------------------------------------------------------------
+--  File:        profiler.adb
+--  Description: Package body for the programming-session profiler. Times
+--               each phase of a JTAG configuration session with the Ada
+--               real-time clock and keeps per-phase count / min / max /
+--               total, the bitstream byte count, SPI TXE idle spins and the
+--               DMA ring high-water mark for the host "prof" report.
+--
+--  Components:
+--               Begin_Session     -- Clears the report for a new session
+--               Add_Sample        -- Folds one phase duration into its stats
+--               Note_Level        -- Keeps the largest ring backlog seen
+--               Minimum / Average -- Per-phase figures, 0 when never sampled
+--               Bytes_Per_Second  -- Bitstream bytes over the pump time
+--               Start / Stop      -- Clock stamp, and the microseconds
+--                                    since it recorded against a phase
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body profiler is
+
+   procedure Begin_Session is
+   begin
+      Report := (others => <>);
+   end Begin_Session;
+
+   procedure Add_Sample (P : Phase; Ticks : Unsigned_32) is
+      S : Phase_Stats renames Report.Phases (P);
+   begin
+      S.Count := S.Count + 1;
+      S.Total := S.Total + Ticks;
+      if Ticks < S.Min then
+         S.Min := Ticks;
+      end if;
+      if Ticks > S.Max then
+         S.Max := Ticks;
+      end if;
+   end Add_Sample;
+
+   procedure Note_Level (Level : Natural) is
+   begin
+      if Unsigned_32 (Level) > Report.High_Water then
+         Report.High_Water := Unsigned_32 (Level);
+      end if;
+   end Note_Level;
+
+   function Minimum (S : Phase_Stats) return Unsigned_32 is
+   begin
+      if S.Count = 0 then
+         return 0;
+      end if;
+      return S.Min;
+   end Minimum;
+
+   function Average (S : Phase_Stats) return Unsigned_32 is
+   begin
+      if S.Count = 0 then
+         return 0;
+      end if;
+      return S.Total / S.Count;
+   end Average;
+
+   function Bytes_Per_Second return Unsigned_32 is
+      T : constant Unsigned_64 := Unsigned_64 (Report.Phases (PUMP).Total);
+   begin
+      if T = 0 then
+         return 0;
+      end if;
+      return Unsigned_32 (Unsigned_64 (Report.Bytes) * Tick_Hz / T);
+   end Bytes_Per_Second;
+
+   procedure Stop (P : Phase; Since : Time) is
+   begin
+      Add_Sample (P, Unsigned_32 ((Clock - Since) / Microseconds (1)));
+   end Stop;
+
+end profiler;
@@ -0,0 +1,96 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        ring_monitor.adb
+--  Description: Package body for the DMA ring monitor. A circular DMA
+--               channel only exposes its write index modulo the ring size,
+--               so a consumer that falls a whole lap behind cannot tell
+--               from the index alone. The half-transfer and transfer-
+--               complete flags latch every time the DMA crosses the middle
+--               or the end of the ring; a set flag with no matching
+--               crossing in the index movement means at least one lap.
+--               Exact while the consumer polls at least once per half
+--               ring, a lower bound on the loss otherwise.
+--
+--  Components:
+--               Reset   -- Starts a session at the consumer's read index
+--               Produce -- Folds one (flags, write index) sample into the
+--                          produced count; detects laps and counts the
+--                          bytes the consumer can no longer reach as lost
+--               Consume -- Records bytes drained by the consumer
+--               Level   -- Current backlog (produced - consumed)
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body ring_monitor is
+
+   procedure Reset (R : in out Ring_Stats; Size : Positive; Read_Idx, Write_Idx : Natural) is
+   begin
+      R := (Size       => Size,
+            Last_Write => Write_Idx,
+            Produced   => Unsigned_32 ((Write_Idx + Size - Read_Idx) mod Size),
+            others     => <>);
+      R.High_Water := R.Produced;
+   end Reset;
+
+   procedure Produce (R : in out Ring_Stats; Write_Idx : Natural; Half, Full : Boolean) is
+      Half_Idx     : constant Natural := R.Size / 2;
+      Delta_Bytes  : Natural := (Write_Idx + R.Size - R.Last_Write) mod R.Size;
+      Reach        : constant Natural := R.Last_Write + Delta_Bytes;
+      Crossed_Half : constant Boolean :=
+        (R.Last_Write < Half_Idx and then Reach >= Half_Idx) or else Reach >= R.Size + Half_Idx;
+      Crossed_Full : constant Boolean := Reach >= R.Size;
+      Lapped       : Boolean := False;
+      Backlog      : Unsigned_32;
+   begin
+      --  The flags are read before the index, so a crossing can show in the
+      --  index one poll before its flag; that late flag is not a lap
+      if Half and then not Crossed_Half and then not R.Pending_Half then
+         Lapped := True;
+      end if;
+      if Full and then not Crossed_Full and then not R.Pending_Full then
+         Lapped := True;
+      end if;
+      if Half then
+         R.Pending_Half := False;
+      elsif Crossed_Half then
+         R.Pending_Half := True;
+      end if;
+      if Full then
+         R.Pending_Full := False;
+      elsif Crossed_Full then
+         R.Pending_Full := True;
+      end if;
+
+      if Lapped then
+         Delta_Bytes := Delta_Bytes + R.Size;
+      end if;
+      R.Produced := R.Produced + Unsigned_32 (Delta_Bytes);
+      R.Last_Write := Write_Idx;
+
+      --  The consumer only sees the backlog modulo the ring size; whole
+      --  laps on top of that are gone
+      Backlog := R.Produced - R.Consumed;
+      if Backlog >= Unsigned_32 (R.Size) then
+         R.Overruns := R.Overruns + 1;
+         R.Lost := R.Lost + (Backlog - Backlog mod Unsigned_32 (R.Size));
+         Backlog := Backlog mod Unsigned_32 (R.Size);
+         R.Consumed := R.Produced - Backlog;
+         R.High_Water := Unsigned_32 (R.Size);
+      end if;
+      if Backlog > R.High_Water then
+         R.High_Water := Backlog;
+      end if;
+   end Produce;
+
+   procedure Consume (R : in out Ring_Stats; Count : Natural) is
+   begin
+      R.Consumed := R.Consumed + Unsigned_32 (Count);
+   end Consume;
+
+   function Level (R : Ring_Stats) return Natural is
+   begin
+      return Natural (R.Produced - R.Consumed);
+   end Level;
+
+end ring_monitor;
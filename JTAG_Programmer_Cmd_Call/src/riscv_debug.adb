@@ -0,0 +1,206 @@
+pragma Style_Checks (Off);
+with utils; use utils;
+------------------------------------------------------------------------------
+--  File:        riscv_debug.adb
+--  Description: Package body for loading the NEORV32 through its debug
+--               module over the bit-banged JTAG pins. DMI accesses are
+--               pipelined: each scan carries the next access and captures
+--               the status of the one before. A busy status means this
+--               access was dropped; it is sent again after a dmireset,
+--               with one more Run-Test/Idle cycle per access from then on.
+--
+--  Components:
+--               Scan_IR     -- 5-bit instruction, skipped when already in
+--               Scan_DR     -- Up to 64 bits LSB first, then Idle cycles
+--               DMI_Scan    -- One DMI access, busy handled
+--               DMI_Write / DMI_Read
+--                           -- A write scan; a read scan then a NOP scan
+--               Connect     -- Reset, DTMCS (version, abits, idle), dmactive,
+--                              haltreq until allhalted, sbcs has 32-bit SBA
+--               Begin_Block -- sbcs 32-bit auto-increment, errors cleared;
+--                              sbaddress0
+--               Write_Word  -- sbdata0: one scan per word
+--               End_Block   -- sbcs clean and sbaddress0 one past the last
+--                              word written
+--               Resume      -- dpc from data0 by abstract command, then
+--                              resumereq until allresumeack
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body riscv_debug is
+
+   Current : Unsigned_8  := 0;   --  Instruction latched in the DTM (0 = unknown)
+   Abits   : Natural     := 7;
+   Idle    : Natural     := 0;
+   Failed  : Boolean     := False;
+   Base    : Unsigned_32 := 0;
+   Words   : Unsigned_32 := 0;
+
+   function To_Bit (B : Boolean) return Bit is (if B then 1 else 0);
+
+   procedure Scan_IR (Instruction : Unsigned_8) is
+      Unused : Bit;
+   begin
+      if Current = Instruction then
+         return;
+      end if;
+      Unused := Shift_Bit (1, 1); -- SELECT-DR-SCAN
+      Unused := Shift_Bit (1, 1); -- SELECT-IR-SCAN
+      Unused := Shift_Bit (0, 1); -- CAPTURE-IR
+      Unused := Shift_Bit (0, 1); -- SHIFT-IR
+      for I in 0 .. IR_Length - 1 loop
+         Unused := Shift_Bit (To_Bit (I = IR_Length - 1), Bit (Shift_Right (Instruction, I) and 1));
+      end loop;
+      Unused := Shift_Bit (1, 1); -- UPDATE-IR
+      Unused := Shift_Bit (0, 1); -- RUN-TEST/IDLE
+      Current := Instruction;
+   end Scan_IR;
+
+   function Scan_DR (Data_Out : Unsigned_64; Length : Natural) return Unsigned_64 is
+      Captured : Unsigned_64 := 0;
+      Unused   : Bit;
+   begin
+      Unused := Shift_Bit (1, 0); -- SELECT-DR-SCAN
+      Unused := Shift_Bit (0, 0); -- CAPTURE-DR
+      Unused := Shift_Bit (0, 0); -- SHIFT-DR
+      for I in 0 .. Length - 1 loop
+         Captured := Captured or Shift_Left
+           (Unsigned_64 (Shift_Bit (To_Bit (I = Length - 1), Bit (Shift_Right (Data_Out, I) and 1))), I);
+      end loop;
+      Unused := Shift_Bit (1, 0); -- UPDATE-DR
+      Unused := Shift_Bit (0, 0); -- RUN-TEST/IDLE
+      for I in 1 .. Idle loop
+         Unused := Shift_Bit (0, 0);
+      end loop;
+      return Captured;
+   end Scan_DR;
+
+   function DMI_Scan (Op : Unsigned_64; Address : Unsigned_32; Data : Unsigned_32) return Unsigned_64 is
+      Data_Out : constant Unsigned_64 :=
+        Shift_Left (Unsigned_64 (Address), 34) or Shift_Left (Unsigned_64 (Data), 2) or Op;
+      Captured : Unsigned_64;
+      Unused   : Unsigned_64;
+   begin
+      Scan_IR (IR_DMI);
+      loop
+         Captured := Scan_DR (Data_Out, Abits + 34);
+         exit when (Captured and 3) /= DMI_BUSY;
+         --  This access was dropped: clear the sticky busy, wait longer, again
+         Scan_IR (IR_DTMCS);
+         Unused := Scan_DR (Unsigned_64 (DTMCS_DMI_Reset), 32);
+         Scan_IR (IR_DMI);
+         Last.Retries := Last.Retries + 1;
+         if Idle >= Max_Idle then
+            Failed := True;
+            return Captured;
+         end if;
+         Idle := Idle + 1;
+      end loop;
+      if (Captured and 3) = DMI_FAILED then
+         Failed := True;
+      end if;
+      return Captured;
+   end DMI_Scan;
+
+   procedure DMI_Write (Address : Unsigned_32; Data : Unsigned_32) is
+      Unused : Unsigned_64;
+   begin
+      Unused := DMI_Scan (DMI_WRITE, Address, Data);
+   end DMI_Write;
+
+   function DMI_Read (Address : Unsigned_32) return Unsigned_32 is
+      Unused : Unsigned_64;
+   begin
+      Unused := DMI_Scan (DMI_READ, Address, 0);
+      return Unsigned_32 (Shift_Right (DMI_Scan (DMI_NOP, 0, 0), 2) and 16#FFFF_FFFF#);
+   end DMI_Read;
+
+   function Connect return Result is
+      DTMCS  : Unsigned_32;
+      V      : Unsigned_32;
+      Unused : Bit;
+   begin
+      for I in 1 .. 6 loop
+         Unused := Shift_Bit (1, 1); -- TEST-LOGIC-RESET: IDCODE latched
+      end loop;
+      Unused := Shift_Bit (0, 1); -- RUN-TEST/IDLE
+      Current := 16#01#;
+      Failed := False;
+      Idle := 0;
+      Scan_IR (IR_DTMCS);
+      DTMCS := Unsigned_32 (Scan_DR (0, 32) and 16#FFFF_FFFF#);
+      if (DTMCS and 16#F#) /= 1 then
+         return NO_DTM;
+      end if;
+      Abits := Natural (Shift_Right (DTMCS, 4) and 16#3F#);
+      if Abits < 7 or else Abits > 30 then
+         return NO_DTM;
+      end if;
+      Idle := Natural (Shift_Right (DTMCS, 12) and 7);
+
+      DMI_Write (DM_Control, Control_Active);
+      DMI_Write (DM_Control, Control_Active or Control_Halt);
+      V := DMI_Read (DM_Status);
+      DMI_Write (DM_Control, Control_Active);
+      if Failed or else (V and Status_Halted) = 0 then
+         return NO_HALT;
+      end if;
+
+      V := DMI_Read (DM_SB_CS);
+      if Shift_Right (V, 29) /= 1 or else (V and SB_Can_32) = 0 then
+         return NO_SBA;
+      end if;
+      return LOADED;
+   end Connect;
+
+   procedure Begin_Block (Address : Unsigned_32) is
+   begin
+      --  sberror and sbbusyerror are write-1-to-clear
+      DMI_Write (DM_SB_CS, SB_Busy_Error or SB_Error or SB_Access_32 or SB_Auto_Inc);
+      DMI_Write (DM_SB_Address, Address);
+      Base := Address;
+      Words := 0;
+   end Begin_Block;
+
+   procedure Write_Word (Word : Unsigned_32) is
+   begin
+      DMI_Write (DM_SB_Data, Word);
+      Words := Words + 1;
+   end Write_Word;
+
+   function End_Block return Result is
+      CS : constant Unsigned_32 := DMI_Read (DM_SB_CS);
+      At_Address : constant Unsigned_32 := DMI_Read (DM_SB_Address);
+   begin
+      Last.Idle := Unsigned_32 (Idle);
+      if Failed or else (CS and (SB_Busy_Error or SB_Error)) /= 0
+        or else At_Address /= Base + 4 * Words
+      then
+         return BUS_ERROR;
+      end if;
+      return LOADED;
+   end End_Block;
+
+   function Resume (Entry_Point : Unsigned_32) return Result is
+      V : Unsigned_32;
+   begin
+      DMI_Write (DM_Data0, Entry_Point);
+      DMI_Write (DM_Command, Command_Set_DPC);
+      V := DMI_Read (DM_Abstract_CS);
+      if (V and Abstract_Busy) /= 0 then
+         V := DMI_Read (DM_Abstract_CS);
+      end if;
+      if (V and (Abstract_Busy or Abstract_Error)) /= 0 then
+         return NO_RESUME;
+      end if;
+      DMI_Write (DM_Control, Control_Active or Control_Resume);
+      V := DMI_Read (DM_Status);
+      DMI_Write (DM_Control, Control_Active);
+      if Failed or else (V and Status_Resumed) = 0 then
+         return NO_RESUME;
+      end if;
+      return LOADED;
+   end Resume;
+
+end riscv_debug;
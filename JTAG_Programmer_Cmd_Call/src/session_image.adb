@@ -0,0 +1,31 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        session_image.adb
+--  Description: Package body for the bitstream + firmware session header.
+--               Tells a session from a wire image or a raw bitstream at the
+--               start of a config session; mcu_to_fpga streams the frames.
+--
+--  Components:
+--               Valid     -- Magic, check word, upper tail bits clear,
+--                            firmware section fits the stage
+--               Tail_Byte -- The byte Finish_Configuration bit-bangs
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body session_image is
+
+   function Valid (H : Header; Stage_Size : Natural) return Boolean is
+   begin
+      return H.Magic = Magic
+        and then H.Check = not (H.Magic xor H.Body_Length xor H.Tail xor H.Firmware_Length)
+        and then H.Tail <= 16#FF#
+        and then H.Firmware_Length <= Unsigned_32 (Stage_Size);
+   end Valid;
+
+   function Tail_Byte (H : Header) return Unsigned_8 is
+   begin
+      return Unsigned_8 (H.Tail and 16#FF#);
+   end Tail_Byte;
+
+end session_image;
@@ -0,0 +1,226 @@
+pragma Style_Checks (Off);
+with Ada.Real_Time;           use Ada.Real_Time;
+with hal;
+with ring_monitor;
+------------------------------------------------------------------------------
+--  File:        sspi.adb
+--  Description: Package body for slave serial (SSPI) configuration of the
+--               Gowin FPGA over SPI1, following UG290E Figure 7-44:
+--               Erase (0x05) -> Init (0x12) -> Enable (0x15) ->
+--               Write (0x3B) + bitstream -> Disable (0x3A).
+--               Every command waits for READY; the bitstream is moved from
+--               the USART2 DMA ring to SPI1 by DMA in one CS-low burst
+--               (hal.SPI_DMA_Begin / SPI_Send_Block / SPI_DMA_End). The
+--               lines are hal's SSPI_*, so the host build runs this
+--               against the Host_Tools SSPI target model.
+--
+--  Components:
+--               SSPI_Init         -- hal.SSPI_Enable: handshake pins, CS
+--                                    high, SPI1 in mode 0 on PA5/PA6/PA7
+--               Wait_Ready        -- Waits (bounded) for READY on PB1
+--               SSPI_Command      -- Command byte plus one dummy byte
+--               SSPI_Read         -- Command, three dummy bytes, then a
+--                                    32-bit register read MSB first
+--               Status_Done       -- DONE bit of a status register value
+--               Program_Bitstream -- Full SSPI session; leaves the result
+--                                    in Last_IDCODE, Last_Status,
+--                                    Bytes_Sent and Configured
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body sspi is
+
+   --  UG290E: at least 4 ms between Erase and Init on the GW1N-9. This and
+   --  the RECONFIG_N pulse are the only waits; Host_Tools sspi_check replays
+   --  the session against the emulator's rules to keep it that way
+   Erase_Wait       : constant Time_Span := Milliseconds (4);
+   Reconfig_Pulse   : constant Time_Span := Milliseconds (2);
+   Ready_Timeout    : constant Time_Span := Milliseconds (100);
+   Done_Timeout     : constant Time_Span := Milliseconds (50);
+   Stable_Threshold : constant := 10_000; -- same silence window as JTAG mode
+
+   Not_Ready : Boolean := False;
+
+   procedure CS_Low is
+   begin
+      hal.SSPI_Select (True);
+   end CS_Low;
+
+   procedure CS_High is
+   begin
+      hal.SPI_Wait_Idle;
+      hal.SSPI_Select (False);
+   end CS_High;
+
+   function Transceive (Data_Out : Byte) return Byte is
+   begin
+      return Byte (hal.SPI_Transfer (Unsigned_8 (Data_Out)));
+   end Transceive;
+
+   procedure SSPI_Init is
+   begin
+      hal.SSPI_Enable;
+      hal.SPI_Flush_RX;
+      Not_Ready := False;
+   end SSPI_Init;
+
+   --  Hands PA4 .. PA7 back to the JTAG bit-bang code; CS stays high
+   procedure SSPI_Release is
+   begin
+      CS_High;
+      hal.SPI_Release;
+   end SSPI_Release;
+
+   function Wait_Ready return Boolean is
+      Deadline : constant Time := Clock + Ready_Timeout;
+   begin
+      while not hal.SSPI_Ready loop
+         if Clock > Deadline then
+            Not_Ready := True;
+            return False;
+         end if;
+      end loop;
+      return True;
+   end Wait_Ready;
+
+   procedure SSPI_Command (Cmd : Byte) is
+      Unused : Byte;
+   begin
+      if Not_Ready or else not Wait_Ready then
+         return;
+      end if;
+      CS_Low;
+      Unused := Transceive (Cmd);
+      Unused := Transceive (16#00#);
+      CS_High;
+   end SSPI_Command;
+
+   function SSPI_Read (Cmd : Byte) return Unsigned_32 is
+      Value  : Unsigned_32 := 0;
+      Unused : Byte;
+   begin
+      if Not_Ready or else not Wait_Ready then
+         return 0;
+      end if;
+      --  A DMA burst only transmits, so stale bytes (and OVR) pile up in
+      --  the RX FIFO; drop them before the read-back
+      hal.SPI_Flush_RX;
+      CS_Low;
+      Unused := Transceive (Cmd);
+      for I in 1 .. 3 loop
+         Unused := Transceive (16#00#);
+      end loop;
+      for I in 1 .. 4 loop
+         Value := Shift_Left (Value, 8) or Unsigned_32 (Transceive (16#00#));
+      end loop;
+      CS_High;
+      return Value;
+   end SSPI_Read;
+
+   function Status_Done (Value : Unsigned_32) return Boolean is
+   begin
+      return (Value and Status_Done_Bit) /= 0;
+   end Status_Done;
+
+   --  0x3B then every byte the host sends, in a single CS-low burst, until
+   --  USART2 has been quiet for Stable_Threshold polls. H2M opened the
+   --  stream before the prompt, so the data starts at 0 however long the
+   --  erase took. Without READY the stream is read off and dropped the
+   --  same way, so Close_USART2_Stream does not hand the bitstream to H2M
+   --  as command lines
+   procedure Stream_Bitstream is
+      Read_Idx       : Natural := 0;
+      Write_Idx      : Natural;
+      Count          : Natural;
+      Last_Write_Idx : Natural := Buffer_Size;
+      Stable_Count   : Natural := 0;
+      Has_Data       : Boolean := False;
+      Ready          : constant Boolean := not Not_Ready and then Wait_Ready;
+      Unused         : Byte;
+   begin
+      Start_USART2_Ring (Read_Idx);
+      if Ready then
+         CS_Low;
+         Unused := Transceive (16#3B#);
+         hal.SPI_DMA_Begin;
+      end if;
+      loop
+         Write_Idx := Poll_USART2_Ring;
+
+         if Write_Idx /= Last_Write_Idx then
+            Stable_Count := 0;
+            Last_Write_Idx := Write_Idx;
+         elsif Has_Data then
+            Stable_Count := Stable_Count + 1;
+         end if;
+
+         if Write_Idx /= Read_Idx then
+            Has_Data := True;
+            Count := (Write_Idx + Buffer_Size - Read_Idx) mod Buffer_Size;
+            if Ready then
+               if Write_Idx > Read_Idx then
+                  hal.SPI_Send_Block (DMA_Buffer (Read_Idx)'Address, Count);
+               else
+                  hal.SPI_Send_Block (DMA_Buffer (Read_Idx)'Address, Buffer_Size - Read_Idx);
+                  hal.SPI_Send_Block (DMA_Buffer (0)'Address, Write_Idx);
+               end if;
+               Bytes_Sent := Bytes_Sent + Count;
+            end if;
+            ring_monitor.Consume (USART2_Ring, Count);
+            Read_Idx := Write_Idx;
+         end if;
+
+         exit when Has_Data and then Stable_Count >= Stable_Threshold;
+      end loop;
+      if not Ready then
+         return;
+      end if;
+
+      --  Channel 3 is USART1 RX (firmware upload), idle in SSPI mode and
+      --  put back by SPI_DMA_End once the last frame has left
+      hal.SPI_DMA_End;
+      CS_High;
+      hal.SPI_Flush_RX;
+   end Stream_Bitstream;
+
+   procedure Program_Bitstream is
+      Deadline : Time;
+   begin
+      Configured := False;
+      Bytes_Sent := 0;
+      Last_IDCODE := 0;
+      Last_Status := 0;
+      SSPI_Init;
+
+      --  Pulse RECONFIG_N; the FPGA raises READY once it takes commands
+      hal.SSPI_Reconfig (Low => True);
+      delay until Clock + Reconfig_Pulse;
+      hal.SSPI_Reconfig (Low => False);
+
+      Last_IDCODE := SSPI_Read (16#11#);
+
+      --  Always erase: SRAM must be cleared before Init is accepted
+      SSPI_Command (16#05#);
+      delay until Clock + Erase_Wait;
+      SSPI_Command (16#12#); -- Init address
+      SSPI_Command (16#15#); -- Write enable
+      Stream_Bitstream;
+      SSPI_Command (16#3A#); -- Write disable
+
+      --  Poll until DONE instead of sleeping a fixed time
+      Deadline := Clock + Done_Timeout;
+      loop
+         Last_Status := SSPI_Read (16#41#);
+         exit when Status_Done (Last_Status)
+           or else hal.SSPI_Done;
+         exit when Not_Ready or else Clock > Deadline;
+      end loop;
+
+      Configured := not Not_Ready
+        and then (Status_Done (Last_Status)
+                  or else hal.SSPI_Done);
+      SSPI_Release;
+   end Program_Bitstream;
+
+end sspi;
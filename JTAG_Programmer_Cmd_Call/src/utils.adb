@@ -1,39 +1,45 @@
 pragma Style_Checks (Off);
 
-with STM32F0x0;               use STM32F0x0;
-with STM32F0x0.RCC;           use STM32F0x0.RCC;
-with STM32F0x0.GPIO;          use STM32F0x0.GPIO;
-with STM32F0x0.SPI;           use STM32F0x0.SPI;
+with Interfaces;
+with hal;
 ------------------------------------------------------------------------------
 --  File:        utils.adb
 --  Description: Package body providing shared low-level hardware utilities
 --               used by both host_to_mcu and mcu_to_fpga. Contains the
 --               protected shared state object, GPIO pin control, JTAG clock
 --               generation, SPI peripheral management, and the byte-level
---               SPI/JTAG data transfer routines.
+--               SPI/JTAG data transfer routines. All register access goes
+--               through hal, so this runs on the host build unchanged.
 --
 --  Components:
 --               ProgState (Protected) -- Thread-safe getter/setter for the
 --                                        shared State enumeration; coordinates
 --                                        the H2M and M2F task state machine
---               Pin_Low               -- Drives a GPIOA pin low via BSRR.BR
---               Pin_High              -- Drives a GPIOA pin high via BSRR.BS
+--               Pin_Low               -- Drives a GPIOA pin low
+--               Pin_High              -- Drives a GPIOA pin high
 --               Pulse_TCK             -- Generates a single JTAG TCK pulse
 --                                        (low then high on PA5)
---               SPI_Enable            -- Enables SPI1 clock; configures
---                                        master mode, 12 MHz baud, CPOL/CPHA
---                                        mode 3, 8-bit frames, software SSM;
---                                        switches PA5/PA6/PA7 to AF0 for
---                                        SPI1 SCK/MISO/MOSI
---               SPI_Disable           -- Waits for SPI1 bus idle, restores
---                                        PA5/PA6/PA7 to GPIO output/input
---                                        mode, and gates off the SPI1 clock
---               Transceive_Byte       -- Blocking SPI byte transmit; writes
---                                        directly to the DR register via an
---                                        address overlay for 8-bit access
+--               Shift_Bit             -- One TCK cycle with the given TMS
+--                                        and TDI; returns TDO sampled just
+--                                        before the rising edge
+--               SPI_Disable           -- Waits for SPI1 bus idle, sets the
+--                                        JTAG idle levels, restores PA5/PA6/
+--                                        PA7 to GPIO and gates off SPI1
+--               Transceive_Byte       -- Blocking SPI byte transmit; counts
+--                                        busy TXE polls in TXE_Spins
 --               Transceive_Last_Byte -- Bit-bangs the final bitstream
---                                        byte over JTAG, asserting TMS high
+--                                        byte over JTAG plus any trailing
+--                                        bypass bits, asserting TMS high
 --                                        on the last bit to exit Shift-DR
+--               Open_USART2_Stream   -- Restarts the USART2 RX DMA at the
+--                                        top of DMA_Buffer and hands it RX
+--               Close_USART2_Stream  -- Hands USART2 RX back to Get_Char
+--               Start_USARTx_Ring    -- Clears the RX DMA half and full
+--                                        transfer flags and starts a
+--                                        ring_monitor session at Read_Idx
+--               Poll_USARTx_Ring     -- Samples the flags, then CNDTR; feeds
+--                                        the ring monitor and returns the
+--                                        DMA write index into the ring
 --
 --  Target:      STM32F0x0
 --  Language:    Ada 2012
@@ -53,81 +59,56 @@ package body utils is
    end ProgState;
 
 
+   use type Interfaces.Unsigned_8;
+
    procedure Pin_Low (Pin : Natural) is
    begin
-      GPIOA_Periph.BSRR.BR.Arr (Pin) := 1;
+      hal.Pin_Set (Pin, False);
    end Pin_Low;
 
    procedure Pin_High (Pin : Natural) is
    begin
-      GPIOA_Periph.BSRR.BS.Arr (Pin) := 1;
+      hal.Pin_Set (Pin, True);
    end Pin_High;
 
    procedure Pulse_TCK is
    begin
-      GPIOA_Periph.BSRR.BR.Arr (TCK_Pin) := 1;
-      GPIOA_Periph.BSRR.BS.Arr (TCK_Pin) := 1;
+      hal.Pin_Set (TCK_Pin, False);
+      hal.Pin_Set (TCK_Pin, True);
    end Pulse_TCK;
 
-    procedure SPI_Enable is
+   function Shift_Bit (TMS_Val : Bit; TDI_Val : Bit) return Bit is
+      TDO_Val : Bit;
    begin
-      RCC_Periph.APB2ENR.SPI1EN := 1;
-
-      --  CR1: Master mode, Baud rate 12MHz, Software Slave Mgmt, Internal Slave Select
-      SPI1_Periph.CR1 :=
-        (MSTR     => 1,
-         BR       => 1,
-         CPOL     => 1,
-         CPHA     => 1,
-         LSBFIRST => 0,
-         SSM      => 1,
-         SSI      => 1,
-         SPE      => 1,
-         others   => <>);
-
-      --  CR2: 8-bit Data Size (7 is 8-bit), FRXTH must be 1 for 8-bit/Byte access
-      SPI1_Periph.CR2 := (DS => 7, FRXTH => 1, others => <>);
-
-      GPIOA_Periph.AFRL.Arr (5) := 0; --  AF0 for SPI1
-      GPIOA_Periph.AFRL.Arr (6) := 0; --  AF0 for SPI1
-      GPIOA_Periph.AFRL.Arr (7) := 0; --  AF0 for SPI1
-
-      GPIOA_Periph.MODER.Arr (5) := 2;
-      GPIOA_Periph.MODER.Arr (6) := 2;
-      GPIOA_Periph.MODER.Arr (7) := 2;
-
-   end SPI_Enable;
+      hal.Pin_Set (TMS_Pin, TMS_Val = 1);
+      hal.Pin_Set (TDI_Pin, TDI_Val = 1);
+      hal.Pin_Set (TCK_Pin, False);
+      --  The target drives TDO on the falling edge; sample before rising
+      TDO_Val := (if hal.Pin_Read (TDO_Pin) then 1 else 0);
+      hal.Pin_Set (TCK_Pin, True);
+      return TDO_Val;
+   end Shift_Bit;
 
    procedure SPI_Disable is
    begin
-      while SPI1_Periph.SR.BSY /= 0 loop
-         null;
-      end loop;
+      hal.SPI_Wait_Idle;
 
       Pin_High (TCK_Pin);
       Pin_HIGH (TDI_Pin);
       Pin_Low (tms_pin);
 
-      GPIOA_Periph.MODER.Arr (5) := 1;
-      GPIOA_Periph.MODER.Arr (6) := 0;
-      GPIOA_Periph.MODER.Arr (7) := 1;
-      RCC_Periph.APB2ENR.SPI1EN := 0;
+      hal.SPI_Release;
    end SPI_Disable;
 
    procedure Transceive_Byte (Data_Out : Byte) is
-      DR_Byte : Byte
-      with Address => SPI1_Periph.DR'Address;
    begin
-      while SPI1_Periph.SR.TXE = 0 loop
-         null;
-      end loop;
-      DR_Byte := Data_Out;
+      hal.SPI_Send (Interfaces.Unsigned_8 (Data_Out), TXE_Spins);
    end Transceive_Byte;
 
-   procedure Transceive_Last_Byte (Data_Out : Byte) is
+   procedure Transceive_Last_Byte (Data_Out : Byte; Trailing_Bits : Natural := 0) is
    begin
       for Bit in reverse 0 .. 7 loop
-         if Bit = 0 then
+         if Bit = 0 and then Trailing_Bits = 0 then
             Pin_High (tms_pin);
          end if;
 
@@ -139,6 +120,65 @@ package body utils is
 
          Pulse_TCK;
       end loop;
+
+      --  One bit per bypassed TAP between TDI and the target pushes the
+      --  last data bit all the way into it
+      if Trailing_Bits > 0 then
+         Pin_High (TDI_Pin);
+         for I in 1 .. Trailing_Bits loop
+            if I = Trailing_Bits then
+               Pin_High (tms_pin);
+            end if;
+            Pulse_TCK;
+         end loop;
+      end if;
    end Transceive_Last_Byte;
 
+   procedure Open_USART2_Stream is
+   begin
+      hal.DMA_Restart (hal.USART2, Buffer_Size);
+      hal.UART_Receive_DMA (hal.USART2, True);
+   end Open_USART2_Stream;
+
+   procedure Close_USART2_Stream is
+   begin
+      hal.UART_Receive_DMA (hal.USART2, False);
+   end Close_USART2_Stream;
+
+   procedure Start_USART2_Ring (Read_Idx : Natural) is
+      Write_Idx : constant Natural := Buffer_Size - hal.DMA_Remaining (hal.USART2);
+   begin
+      hal.DMA_Clear_Flags (hal.USART2);
+      ring_monitor.Reset (USART2_Ring, Buffer_Size, Read_Idx, Write_Idx);
+   end Start_USART2_Ring;
+
+   procedure Start_USART1_Ring (Read_Idx : Natural) is
+      Write_Idx : constant Natural := Buffer1_Size - hal.DMA_Remaining (hal.USART1);
+   begin
+      hal.DMA_Clear_Flags (hal.USART1);
+      ring_monitor.Reset (USART1_Ring, Buffer1_Size, Read_Idx, Write_Idx);
+   end Start_USART1_Ring;
+
+   --  Flags before the index: a crossing in between is seen in the index
+   --  first and its flag on the next poll, which the monitor expects
+   function Poll_USART2_Ring return Natural is
+      Half, Full : Boolean;
+      Write_Idx  : Natural;
+   begin
+      hal.DMA_Take_Flags (hal.USART2, Half, Full);
+      Write_Idx := Buffer_Size - hal.DMA_Remaining (hal.USART2);
+      ring_monitor.Produce (USART2_Ring, Write_Idx, Half, Full);
+      return Write_Idx;
+   end Poll_USART2_Ring;
+
+   function Poll_USART1_Ring return Natural is
+      Half, Full : Boolean;
+      Write_Idx  : Natural;
+   begin
+      hal.DMA_Take_Flags (hal.USART1, Half, Full);
+      Write_Idx := Buffer1_Size - hal.DMA_Remaining (hal.USART1);
+      ring_monitor.Produce (USART1_Ring, Write_Idx, Half, Full);
+      return Write_Idx;
+   end Poll_USART1_Ring;
+
 end Utils;
\ No newline at end of file
@@ -0,0 +1,29 @@
+pragma Style_Checks (Off);
+------------------------------------------------------------------------------
+--  File:        wire_image.adb
+--  Description: Package body for the pre-split bitstream header. Tells a
+--               wire image from a raw bitstream at the start of a config
+--               session; mcu_to_fpga streams the body.
+--
+--  Components:
+--               Valid     -- Magic, check word, upper tail bits clear
+--               Tail_Byte -- The byte Finish_Configuration bit-bangs
+--
+--  Target:      STM32F0x0
+--  Language:    Ada 2012
+------------------------------------------------------------------------------
+package body wire_image is
+
+   function Valid (H : Header) return Boolean is
+   begin
+      return H.Magic = Magic
+        and then H.Check = not (H.Magic xor H.Body_Length xor H.Tail)
+        and then H.Tail <= 16#FF#;
+   end Valid;
+
+   function Tail_Byte (H : Header) return Unsigned_8 is
+   begin
+      return Unsigned_8 (H.Tail and 16#FF#);
+   end Tail_Byte;
+
+end wire_image;
@@ -2,17 +2,27 @@
  * MSP432 Gowin JTAG Emulator (The Final Masterpiece V2)
  * - Fixed sticky LED bug (changed = to |= on TAP Reset)
  * - Added CMD_USER_MODE (0x0A) to whitelist
+ * - Added all-ones BYPASS (0xFF) to whitelist for multi-device chains
+ * - Lossless statistics: exact per-event counters, lock-free log queue that
+ *   counts what it drops; every status poll is counted (no 1-in-500 sampling)
+ * - Timestamped binary log records (log_record.h) drained to the UART by DMA;
+ *   the main loop never waits on TXIFG. Decode with Host_Tools bin/log_decode
+ * - Trace capture (hold S1 at reset): every TCK rising edge with TMS, TDI, TDO
+ *   and TAP state, folded into runs, at 115200 baud. Host_Tools bin/jtag_vcd
  */
 
 #include "msp.h"
 #include <stdint.h>
-#include <stdio.h>
+#include "log_record.h"
 
 // --- PINS ---
 #define PIN_TCK  BIT0
 #define PIN_TMS  BIT1
 #define PIN_TDI  BIT2
 #define PIN_TDO_OUT BIT4
+#define PIN_S1      BIT1  // P1.1 LaunchPad button: held at reset = trace capture
+#define PIN_TA_RISE BIT4  // P2.4 = TA0.1, wire to TCK for the duty cycle
+#define PIN_TA_FALL BIT5  // P2.5 = TA0.2, wire to TCK for the duty cycle
 
 // --- LED PROGRESS BAR (Port 4) ---
 #define LED_PROG_1 BIT0  // White: Reset
@@ -35,6 +45,7 @@
 #define CMD_READ_STATUS 0x41
 #define CMD_BYPASS      0x08
 #define CMD_USER_MODE   0x0A  // New: Boot to User Mode
+#define CMD_BYPASS_ALL  0xFF  // IEEE 1149.1 all-ones BYPASS (chain padding)
 
 #define MIN_STREAM_BITS 100000
 #define GOWIN_ID_VAL    0x1100481B //0x1100581B
@@ -50,30 +61,184 @@ typedef enum {
 // --- PROTOCOL TRACKER ---
 typedef enum { PROTO_IDLE=0, PROTO_ERASING, PROTO_ERASE_WAIT_09, PROTO_ERASED, PROTO_WRITING } ProtocolState;
 
-// --- EVENT QUEUE (FIFO) ---
-#define QUEUE_SIZE 64
+// --- EVENT QUEUE (single producer = ISR, single consumer = main loop) ---
+#define QUEUE_SIZE 64                 // Power of two, divides 256
+#define QUEUE_MASK (QUEUE_SIZE - 1)
 typedef enum {
     EVT_NONE=0, EVT_RESET_TAP, EVT_CMD_IDCODE, EVT_CMD_ENABLE, EVT_CMD_ERASE,
     EVT_CMD_ERASE_DONE, EVT_CMD_INIT, EVT_CMD_WRITE, EVT_CMD_DISABLE,
     EVT_CMD_STATUS, EVT_CMD_UNKNOWN, EVT_DATA_ID_READ, EVT_DATA_BITSTREAM_DONE,
-    EVT_ERR_BITSTREAM_TINY, EVT_ERR_PROTOCOL
+    EVT_ERR_BITSTREAM_TINY, EVT_ERR_PROTOCOL, EVT_COUNT
 } EventType;
 
-volatile EventType eventQueue[QUEUE_SIZE];
-volatile uint8_t head = 0, tail = 0;
+// Event arguments: STATUS = poll number, ERASE_DONE = polls during erase,
+// BITSTREAM_DONE / TINY = bits counted, UNKNOWN = instruction byte
+typedef struct { uint8_t id; uint32_t ts; uint32_t arg; } LogEvent;
 
-void Enqueue(EventType e) {
-    uint8_t next = (head + 1) % QUEUE_SIZE;
-    if (next != tail) { eventQueue[head] = e; head = next; }
+volatile LogEvent eventQueue[QUEUE_SIZE];
+volatile uint8_t head = 0, tail = 0;         // Free-running: head written by the ISR only, tail by main only
+volatile uint32_t eventCount[EVT_COUNT];     // Exact totals, updated even when the queue is full
+volatile uint32_t eventsDropped = 0;
+
+void Count(EventType e) { eventCount[e]++; }
+
+// --- TIMESTAMPS (Timer32_1 free-running at MCLK / 16 = LOG_TICK_HZ) ---
+void Timer_Init(void) {
+    TIMER32_1->LOAD = 0xFFFFFFFF;
+    TIMER32_1->CONTROL = TIMER32_CONTROL_SIZE | TIMER32_CONTROL_PRESCALE_1 | TIMER32_CONTROL_ENABLE;
+}
+uint32_t Now(void) { return ~TIMER32_1->VALUE; } // Counts up
+
+void EnqueueArg(EventType e, uint32_t arg) {
+    Count(e);
+    if ((uint8_t)(head - tail) == QUEUE_SIZE) {
+        eventsDropped++;
+        return;
+    }
+    volatile LogEvent *slot = &eventQueue[head & QUEUE_MASK];
+    slot->id = e; slot->ts = Now(); slot->arg = arg;
+    head++; // Publish only after the slot is written
+}
+void Enqueue(EventType e) { EnqueueArg(e, 0); }
+
+uint8_t Dequeue(LogEvent *ev) {
+    if (head == tail) return 0;
+    volatile LogEvent *slot = &eventQueue[tail & QUEUE_MASK];
+    ev->id = slot->id; ev->ts = slot->ts; ev->arg = slot->arg;
+    tail++;
+    return 1;
+}
+
+// --- BINARY LOG (TX ring drained by DMA channel 0 into EUSCI_A0) ---
+#define TX_RING_SIZE 256                     // Power of two
+#define TX_RING_MASK (TX_RING_SIZE - 1)
+#define LOGDMA_CH      0                     // Channel 0, source 1 = eUSCI_A0 TX
+#define LOGDMA_SRC     1
+#define LOGDMA_CTL(n)  ((3UL << 30) | (((uint32_t)(n) - 1) << 4) | 1UL) // Bytes, src +1, dst fixed, basic
+
+#pragma DATA_ALIGN(dmaControlTable, 256)
+volatile uint32_t dmaControlTable[64];       // 8 primary + 8 alternate: src end, dst end, control, spare
+
+uint8_t  txRing[TX_RING_SIZE];
+uint16_t txHead = 0, txTail = 0;             // Free-running, main only
+uint16_t txInFlight = 0;                     // Bytes handed to the DMA, not yet retired
+uint32_t lastLogTs = 0;
+
+void Log_Init(void) {
+    DMA_Control->CFG = DMA_CFG_MASTEN;
+    DMA_Control->CTLBASE = (uint32_t)dmaControlTable;
+    DMA_Channel->CH_SRCCFG[LOGDMA_CH] = LOGDMA_SRC;
+}
+
+uint16_t Log_Space(void) { return TX_RING_SIZE - (uint16_t)(txHead - txTail); }
+
+// Appends one record; the caller checks Log_Space() >= LOG_MAX_RECORD first
+void Log_Write(uint8_t id, uint32_t ts, uint32_t arg) {
+    uint8_t rec[LOG_MAX_RECORD], n, i;
+    n = Log_Encode(rec, id, ts - lastLogTs, arg);
+    for (i = 0; i < n; i++) txRing[(txHead + i) & TX_RING_MASK] = rec[i];
+    txHead += n;
+    lastLogTs = ts;
+}
+
+// Retires a finished DMA run and starts the next one; never waits
+void Log_Kick(void) {
+    uint16_t n, at;
+    if (txInFlight) {
+        if (DMA_Control->ENASET & (1 << LOGDMA_CH)) return; // Still moving
+        txTail += txInFlight; txInFlight = 0;
+    }
+    n = (uint16_t)(txHead - txTail);
+    if (n == 0) return;
+    at = txTail & TX_RING_MASK;
+    if (n > TX_RING_SIZE - at) n = TX_RING_SIZE - at;   // Contiguous run only
+    dmaControlTable[LOGDMA_CH * 4 + 0] = (uint32_t)&txRing[at + n - 1];
+    dmaControlTable[LOGDMA_CH * 4 + 1] = (uint32_t)&EUSCI_A0->TXBUF;
+    dmaControlTable[LOGDMA_CH * 4 + 2] = LOGDMA_CTL(n);
+    txInFlight = n;
+    DMA_Control->ENASET = 1 << LOGDMA_CH;
+    DMA_Channel->SW_CHTRIG = 1 << LOGDMA_CH;  // TXIFG is already high: first byte by hand
+}
+
+// --- TRACE CAPTURE (ISR -> edge ring -> runs folded by the main loop) ---
+#define TRACE_SIZE 1024                      // Power of two
+#define TRACE_MASK (TRACE_SIZE - 1)
+#define TRACE_IDLE_TICKS (LOG_TICK_HZ / 1000) // 1 ms without TCK closes a run
+typedef struct { uint32_t ts; uint16_t high; uint8_t sig; uint8_t state; } TraceEdge; // sig = TMS | TDI << 1 | TDO << 2
+typedef struct { uint32_t ts, last, high, count; uint8_t sig, state, highBad; } TraceRun;
+
+uint8_t traceMode = 0;
+volatile TraceEdge traceRing[TRACE_SIZE];
+volatile uint16_t traceHead = 0, traceTail = 0; // Free-running: head by the ISR, tail by main
+volatile uint32_t traceLost = 0;
+uint16_t traceRiseTa = 0;                    // ISR only: TA0.1 capture of the previous edge
+TraceRun run;                                // Main only
+
+void Trace_Init(void) {
+    P2->SEL0 |= (PIN_TA_RISE | PIN_TA_FALL); P2->SEL1 &= ~(PIN_TA_RISE | PIN_TA_FALL);
+    P2->DIR &= ~(PIN_TA_RISE | PIN_TA_FALL);
+    TIMER_A0->CTL = TIMER_A_CTL_SSEL__SMCLK | TIMER_A_CTL_MC__CONTINUOUS | TIMER_A_CTL_CLR; // 3 MHz, same as LOG_TICK_HZ
+    TIMER_A0->CCTL[1] = TIMER_A_CCTLN_CM__RISING  | TIMER_A_CCTLN_CCIS__CCIA | TIMER_A_CCTLN_SCS | TIMER_A_CCTLN_CAP;
+    TIMER_A0->CCTL[2] = TIMER_A_CCTLN_CM__FALLING | TIMER_A_CCTLN_CCIS__CCIA | TIMER_A_CCTLN_SCS | TIMER_A_CCTLN_CAP;
 }
-EventType Dequeue(void) {
-    if (head == tail) return EVT_NONE;
-    EventType e = eventQueue[tail]; tail = (tail + 1) % QUEUE_SIZE; return e;
+
+// ISR: one rising edge, TDO as the master sampled it
+void Trace_Edge(uint8_t tms, uint8_t tdi, uint8_t state) {
+    uint16_t rise = TIMER_A0->CCR[1];
+    if ((uint16_t)(traceHead - traceTail) == TRACE_SIZE) { traceLost++; traceRiseTa = rise; return; }
+    volatile TraceEdge *e = &traceRing[traceHead & TRACE_MASK];
+    e->ts = Now();
+    e->high = TIMER_A0->CCR[2] - traceRiseTa;  // Last fall - previous rise
+    e->sig = tms | (tdi << 1) | ((P5->OUT & PIN_TDO_OUT) ? 4 : 0);
+    e->state = state;
+    traceRiseTa = rise;
+    traceHead++;
+}
+
+// States a constant TMS keeps the TAP in; their edges fold into one run
+uint8_t Trace_Foldable(uint8_t state) {
+    return state == TAP_RESET || state == TAP_IDLE || state == TAP_SHIFT_DR || state == TAP_PAUSE_DR || state == TAP_PAUSE_IR;
+}
+
+void Trace_Emit(void) {
+    if (run.count == 1) {
+        Log_Write(LOG_ID_TRACE_EDGE, run.ts, run.sig | ((uint32_t)run.state << 3) | (run.highBad ? 0 : run.high << 7));
+    } else if (run.count) {
+        Log_Write(LOG_ID_TRACE_RUN, run.ts, run.state | ((uint32_t)(run.sig & 1) << 4) | (run.count << 5));
+        Log_Write(LOG_ID_TRACE_SPAN, run.last, run.highBad ? 0 : run.high);
+    }
+    run.count = 0;
+}
+
+// A pause longer than 1 ms or 4 average periods starts a new run
+void Trace_Add(const TraceEdge *e) {
+    uint32_t gap = e->ts - run.last;
+    if (run.count && e->state == run.state && (e->sig & 1) == (run.sig & 1) && Trace_Foldable(e->state)
+        && gap <= TRACE_IDLE_TICKS && (run.count == 1 || (uint64_t)gap * (run.count - 1) <= 4ULL * (run.last - run.ts))) {
+        if (run.count == 1) { run.high = 0; run.highBad = 0; } // The first edge's cycle lies before the run
+        if (e->high == 0 || e->high >= gap) run.highBad = 1;
+        run.high += e->high; run.last = e->ts; run.count++;
+        return;
+    }
+    Trace_Emit();
+    run.ts = run.last = e->ts; run.count = 1; run.sig = e->sig; run.state = e->state;
+    run.high = e->high; run.highBad = (e->high == 0 || e->high >= gap);
 }
 
-// --- DIAGNOSTIC VARIABLES ---
-volatile uint8_t  diag_UnknownCmd = 0;
-volatile uint32_t diag_StreamBits = 0;
+// One step of work, kept in time order with the next logged event (if any)
+uint8_t Trace_Step(uint8_t eventPending, uint32_t eventTs) {
+    if (traceHead != traceTail) {
+        volatile TraceEdge *slot = &traceRing[traceTail & TRACE_MASK];
+        if (!eventPending || (int32_t)(slot->ts - eventTs) <= 0) {
+            TraceEdge e = { slot->ts, slot->high, slot->sig, slot->state };
+            traceTail++;
+            Trace_Add(&e);
+            return 1;
+        }
+    }
+    if (run.count && (eventPending || Now() - run.last > TRACE_IDLE_TICKS)) { Trace_Emit(); return 1; }
+    return 0;
+}
 
 // --- SYSTEM CLOCK & UART ---
 void System_Clock_Init_48MHz(void) {
@@ -90,17 +255,22 @@ void UART_Init(void) {
     P1->SEL0 |= (BIT2|BIT3); P1->SEL1 &= ~(BIT2|BIT3);
     EUSCI_A0->CTLW0 |= EUSCI_A_CTLW0_SWRST;
     EUSCI_A0->CTLW0 = EUSCI_A_CTLW0_SWRST | EUSCI_A_CTLW0_SSEL__SMCLK;
-    EUSCI_A0->BRW = 19; EUSCI_A0->MCTLW = (0x55 << 8) | (8 << 4) | EUSCI_A_MCTLW_OS16;
+    if (traceMode) { EUSCI_A0->BRW = 1; EUSCI_A0->MCTLW = (0x00 << 8) | (10 << 4) | EUSCI_A_MCTLW_OS16; } // 115200
+    else { EUSCI_A0->BRW = 19; EUSCI_A0->MCTLW = (0x55 << 8) | (8 << 4) | EUSCI_A_MCTLW_OS16; }          // 9600
     EUSCI_A0->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;
 }
-void UART_Print(char *str) { while (*str) { while (!(EUSCI_A0->IFG & EUSCI_A_IFG_TXIFG)); EUSCI_A0->TXBUF = *str++; }}
-void Print_Hex(uint8_t n) { char b[10]; sprintf(b, "0x%02X", n); UART_Print(b); }
-void Print_Int(uint32_t n) { char b[16]; sprintf(b, "%lu", n); UART_Print(b); }
 
 // --- MAIN LOOP ---
 void main(void) {
     WDT_A->CTL = WDT_A_CTL_PW | WDT_A_CTL_HOLD;
-    System_Clock_Init_48MHz(); UART_Init();
+    System_Clock_Init_48MHz();
+
+    P1->DIR &= ~PIN_S1; P1->REN |= PIN_S1; P1->OUT |= PIN_S1; // Pull-up, pressed = low
+    for (volatile int i = 0; i < 1000; i++);
+    traceMode = !(P1->IN & PIN_S1);
+
+    UART_Init(); Timer_Init(); Log_Init();
+    if (traceMode) Trace_Init();
 
     P4->DIR |= 0x3F; P4->OUT &= ~0x3F; // LEDs
     P5->DIR &= ~(PIN_TCK|PIN_TMS|PIN_TDI); P5->REN |= (PIN_TCK|PIN_TMS|PIN_TDI); P5->OUT &= ~(PIN_TCK|PIN_TMS|PIN_TDI);
@@ -108,35 +278,24 @@ void main(void) {
 
     P5->IES &= ~PIN_TCK; P5->IFG &= ~PIN_TCK; P5->IE |= PIN_TCK;
     NVIC->ISER[1] = 1 << ((PORT5_IRQn) & 31);
+    Log_Write(LOG_ID_BOOT, Now(), LOG_SRC_JTAG | (traceMode ? LOG_SRC_TRACE : 0));
     __enable_irq();
 
-    UART_Print("\r\n==================================================\r\n");
-    UART_Print("--- GOWIN JTAG REFEREE STARTED (PERFECT CLONE) ---\r\n");
-    UART_Print("==================================================\r\n");
-
+    uint32_t reportedDrops = 0, reportedLost = 0;
+    LogEvent ev;
     while (1) {
-        EventType e = Dequeue();
-        if (e != EVT_NONE) {
-            switch(e) {
-                case EVT_RESET_TAP: UART_Print("\n[STATE] JTAG TAP Reset.\r\n"); break;
-                case EVT_CMD_IDCODE: UART_Print("[CMD]   0x11 (READ IDCODE) Latched.\r\n"); break;
-                case EVT_CMD_ENABLE: UART_Print("[CMD]   0x15 (ENABLE CONFIG) Latched.\r\n"); break;
-                case EVT_CMD_STATUS: UART_Print("[CMD]   0x41 (READ STATUS) Master is Polling...\r\n"); break;
-                case EVT_CMD_ERASE: UART_Print("[CMD]   0x05 (ERASE SRAM) Latched. Simulating erase...\r\n"); break;
-                case EVT_CMD_ERASE_DONE: UART_Print("[CMD]   0x09 (ERASE DONE) Latched.\r\n"); break;
-                case EVT_CMD_INIT: UART_Print("[CMD]   0x12 (INIT ADDRESS) Latched.\r\n"); break;
-                case EVT_CMD_WRITE: UART_Print("[CMD]   0x17 (WRITE SRAM) Latched. Waiting for bitstream...\r\n"); break;
-                case EVT_CMD_DISABLE: UART_Print("[CMD]   0x3A (DISABLE CONFIG) Latched.\r\n"); break;
-                case EVT_CMD_UNKNOWN: UART_Print("[WARN]  Unknown Instruction: "); Print_Hex(diag_UnknownCmd); UART_Print("\r\n"); break;
-                case EVT_DATA_ID_READ: UART_Print("[DATA]  Target Read 32 bits from TDO (IDCODE Sent).\r\n"); break;
-                case EVT_DATA_BITSTREAM_DONE:
-                    UART_Print("[PASS]  Bitstream Transmitted! Bits counted: "); Print_Int(diag_StreamBits); UART_Print("\r\n");
-                    UART_Print("        --> Sequence Completed Successfully.\r\n");
-                    break;
-                case EVT_ERR_BITSTREAM_TINY: UART_Print("[FAIL]  Stream too small: "); Print_Int(diag_StreamBits); UART_Print(" bits.\r\n"); break;
-                case EVT_ERR_PROTOCOL: UART_Print("[FAIL]  Protocol violation detected.\r\n"); break;
-                default: break;
-            }
+        Log_Kick();
+        if (Log_Space() < 2 * LOG_MAX_RECORD) continue; // Back-pressure lands in the counted event / edge rings
+        if (eventsDropped != reportedDrops) {
+            reportedDrops = eventsDropped;
+            Log_Write(LOG_ID_DROPPED, lastLogTs, reportedDrops);
+        } else if (traceLost != reportedLost) {
+            reportedLost = traceLost;
+            Log_Write(LOG_ID_TRACE_LOST, lastLogTs, reportedLost);
+        } else if (traceMode && Trace_Step(head != tail, eventQueue[tail & QUEUE_MASK].ts)) {
+            // Edges up to the next event go first
+        } else if (Dequeue(&ev)) {
+            Log_Write(ev.id, ev.ts, ev.arg);
         }
     }
 }
@@ -154,11 +313,13 @@ volatile int tmsHighCount = 0;
 volatile uint8_t isEditMode = 0;
 volatile uint8_t isDone = 0;
 volatile uint8_t erasePollCount = 0;
+volatile uint32_t erasePolls = 0;
 
 void PORT5_IRQHandler(void) {
     if (P5->IFG & PIN_TCK) {
         uint8_t tms = (P5->IN & PIN_TMS) ? 1 : 0;
         uint8_t tdi = (P5->IN & PIN_TDI) ? 1 : 0;
+        if (traceMode) Trace_Edge(tms, tdi, tapState);
 
         if (tms) {
             tmsHighCount++;
@@ -217,15 +378,14 @@ void PORT5_IRQHandler(void) {
             case TAP_UPDATE_DR:
                 tapState = (tms ? TAP_SELECT_DR : TAP_IDLE);
                 if (lastCmd == CMD_WRITE) {
-                    diag_StreamBits = streamCount;
                     if (streamCount > MIN_STREAM_BITS) {
                         isDone = 1;
                         if (protoState == PROTO_ERASED) {
-                            P4->OUT |= LED_PROG_5; Enqueue(EVT_DATA_BITSTREAM_DONE);
+                            P4->OUT |= LED_PROG_5; EnqueueArg(EVT_DATA_BITSTREAM_DONE, streamCount);
                         } else {
                             P4->OUT |= LED_FAIL; Enqueue(EVT_ERR_PROTOCOL);
                         }
-                    } else { P4->OUT |= LED_FAIL; Enqueue(EVT_ERR_BITSTREAM_TINY); }
+                    } else { P4->OUT |= LED_FAIL; EnqueueArg(EVT_ERR_BITSTREAM_TINY, streamCount); }
                 } else if (lastCmd == CMD_IDCODE) {
                     P4->OUT |= LED_PROG_2;
                     Enqueue(EVT_DATA_ID_READ);
@@ -260,22 +420,23 @@ void PORT5_IRQHandler(void) {
                     else if (irShiftBuf == CMD_DISABLE) { isEditMode = 0; Enqueue(EVT_CMD_DISABLE); }
                     else if (irShiftBuf == CMD_IDCODE) { P4->OUT |= LED_PROG_2; Enqueue(EVT_CMD_IDCODE); }
                     else if (irShiftBuf == CMD_ERASE) {
-                        protoState = PROTO_ERASING; erasePollCount = 0; isDone = 0;
+                        protoState = PROTO_ERASING; erasePollCount = 0; erasePolls = 0; isDone = 0;
                         P4->OUT |= LED_PROG_3; Enqueue(EVT_CMD_ERASE);
                     }
                     else if (irShiftBuf == CMD_ERASE_DONE) {
                         if (protoState == PROTO_ERASING || protoState == PROTO_ERASE_WAIT_09) protoState = PROTO_ERASED;
-                        P4->OUT |= LED_PROG_4; Enqueue(EVT_CMD_ERASE_DONE);
+                        P4->OUT |= LED_PROG_4; EnqueueArg(EVT_CMD_ERASE_DONE, erasePolls);
                     }
                     else if (irShiftBuf == CMD_WRITE) { streamCount = 0; Enqueue(EVT_CMD_WRITE); }
                     else if (irShiftBuf == CMD_INIT_ADDR) Enqueue(EVT_CMD_INIT);
                     else if (irShiftBuf == CMD_READ_STATUS) {
-                        static int pollCount = 0; pollCount++;
-                        if (pollCount % 500 == 1) Enqueue(EVT_CMD_STATUS);
+                        if (protoState == PROTO_ERASING || protoState == PROTO_ERASE_WAIT_09) erasePolls++;
+                        // Every poll is counted; only the first of a run is logged
+                        if (lastCmd != CMD_READ_STATUS) EnqueueArg(EVT_CMD_STATUS, eventCount[EVT_CMD_STATUS] + 1); else Count(EVT_CMD_STATUS);
                     }
-                    else if (irShiftBuf == CMD_BYPASS || irShiftBuf == CMD_USER_MODE){} // Silent whitelist
+                    else if (irShiftBuf == CMD_BYPASS || irShiftBuf == CMD_BYPASS_ALL || irShiftBuf == CMD_USER_MODE){} // Silent whitelist
                     else if (irShiftBuf == CMD_REPROGRAM){}
-                    else { diag_UnknownCmd = irShiftBuf; Enqueue(EVT_CMD_UNKNOWN); }
+                    else EnqueueArg(EVT_CMD_UNKNOWN, irShiftBuf);
 
                     lastCmd = irShiftBuf;
                 }
@@ -0,0 +1,54 @@
+/*
+ * Compact binary log record shared by both emulators and the host decoder
+ * - Record: [SYNC 0xA5] [id] [dt varint] [arg varint] [chk]
+ * - dt:  timer ticks since the previous record (LOG_TICK_HZ), LEB128
+ * - arg: event argument, LEB128 (0 costs one byte)
+ * - chk: XOR of every byte before it, sync included; a bad chk makes the
+ *        decoder drop the sync byte and hunt for the next one
+ * - JTAG_Emulator/log_record.h and SSPI_Emultaor/log_record.h are identical
+ */
+
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <stdint.h>
+
+#define LOG_SYNC        0xA5
+#define LOG_MAX_RECORD  13          // 1 + 1 + 5 + 5 + 1
+#define LOG_TICK_HZ     3000000     // Timer32 at MCLK 48 MHz / 16
+
+// Ids shared by both emulators; each one's EventType stays below 0x70
+#define LOG_ID_DROPPED  0x7E        // arg = events lost so far (queue + TX ring)
+#define LOG_ID_BOOT     0x7F        // arg = LOG_SRC_* | LOG_SRC_TRACE
+#define LOG_SRC_JTAG    1
+#define LOG_SRC_SSPI    2
+#define LOG_SRC_MASK    0x0F
+#define LOG_SRC_TRACE   0x10        // TCK edge capture is on
+
+// JTAG edge capture (time = TCK rising edge)
+#define LOG_ID_TRACE_EDGE 0x70      // arg = TMS | TDI << 1 | TDO << 2 | state << 3 | high << 7
+#define LOG_ID_TRACE_RUN  0x71      // arg = state | TMS << 4 | edges << 5; same TMS, one stable state
+#define LOG_ID_TRACE_SPAN 0x72      // Follows RUN: time = its last edge, arg = high summed after its first edge
+#define LOG_ID_TRACE_LOST 0x73      // arg = edges lost so far (capture ring full)
+// high: timer ticks TCK spent high in the cycle that ended at this edge; 0 = unknown
+
+static inline uint8_t Log_Varint(uint8_t *p, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) { p[n++] = (uint8_t)(v | 0x80); v >>= 7; }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Writes one record into out (LOG_MAX_RECORD bytes); returns its length
+static inline uint8_t Log_Encode(uint8_t *out, uint8_t id, uint32_t dt, uint32_t arg) {
+    uint8_t n = 0, chk = 0, i;
+    out[n++] = LOG_SYNC;
+    out[n++] = id;
+    n += Log_Varint(out + n, dt);
+    n += Log_Varint(out + n, arg);
+    for (i = 0; i < n; i++) chk ^= out[i];
+    out[n++] = chk;
+    return n;
+}
+
+#endif
@@ -3,11 +3,19 @@
  * * LOGIC: Follows UG290E Figure 7-44 exactly.
  * * FLOW: Erase(05) -> Init(12) -> Enable(15) -> Write(3B)
  * * FIX: Removed incorrect requirement for initial Enable.
+ * * READS: 0x11 / 0x41 answer 3 dummy bytes then a 32-bit word, MSB first
+ *          (IDCODE 0x1100481B; status bit 13 = DONE). MISO is presented
+ *          before the next rising edge (Mode 0).
+ * * STATS: exact per-event counters and a lock-free log queue that counts
+ *          the events it has to drop instead of losing them silently.
+ * * LOG: timestamped binary records (log_record.h) drained to the UART by
+ *        DMA; the main loop never waits on TXIFG. Decode with
+ *        Host_Tools bin/log_decode.
  */
 
 #include "msp.h"
 #include <stdint.h>
-#include <stdio.h>
+#include "log_record.h"
 
 // --- PINS ---
 #define PIN_SCK   BIT0
@@ -38,6 +46,11 @@
 #define CMD_WRITE_REQ   0x3B
 #define CMD_DISABLE     0x3A
 
+// --- READ-BACK ---
+#define GOWIN_ID_VAL     0x1100481B
+#define STATUS_BASE      0x00019000
+#define STATUS_DONE      0x00002000
+
 // --- TIMING ---
 #define TICKS_PER_MS  48000
 #define MIN_ERASE_WAIT_TICKS (4 * TICKS_PER_MS)
@@ -51,8 +64,9 @@ typedef enum {
     PROTO_WRITING     // Writing Data
 } ProtocolState;
 
-// --- EVENT QUEUE ---
-#define QUEUE_SIZE 32
+// --- EVENT QUEUE (single producer = ISR, single consumer = main loop) ---
+#define QUEUE_SIZE 32                 // Power of two, divides 256
+#define QUEUE_MASK (QUEUE_SIZE - 1)
 typedef enum {
     EVT_NONE=0,
     EVT_ENABLE,
@@ -66,31 +80,104 @@ typedef enum {
     EVT_ERR_SEQ,
     EVT_ERR_TIMING,
     EVT_RESET,
-    EVT_DONE
+    EVT_DONE,
+    EVT_MODE_WAIT,      // Posted by main: mode pins not at 001 (arg = P2 mode bits)
+    EVT_MODE_OK,
+    EVT_RESET_RELEASED,
+    EVT_READY_AGAIN,
+    EVT_COUNT
 } EventType;
 
-volatile EventType eventQueue[QUEUE_SIZE];
-volatile uint8_t head = 0;
-volatile uint8_t tail = 0;
-
-// --- DIAGNOSTIC DATA ---
-volatile uint8_t  diag_ReceivedCmd = 0;
-volatile ProtocolState diag_ExpectedState = PROTO_IDLE;
-volatile uint8_t  diag_UnknownByte = 0;
+// Event arguments: STATUS = poll number, DISABLE / DONE = burst bytes,
+// UNKNOWN = command byte, ERR_SEQ = (command << 8) | expected ProtocolState,
+// ERR_TIMING = microseconds between ERASE and INIT ADDR
+typedef struct { uint8_t id; uint32_t ts; uint32_t arg; } LogEvent;
+
+volatile LogEvent eventQueue[QUEUE_SIZE];
+volatile uint8_t head = 0;                   // Free-running, written by the ISR only
+volatile uint8_t tail = 0;                   // Free-running, written by main only
+volatile uint32_t eventCount[EVT_COUNT];     // Exact totals, updated even when the queue is full
+volatile uint32_t eventsDropped = 0;
+
+// --- TIMESTAMPS (Timer32_1 free-running at MCLK / 16 = LOG_TICK_HZ) ---
+void Timer_Init(void) {
+    TIMER32_1->LOAD = 0xFFFFFFFF;
+    TIMER32_1->CONTROL = TIMER32_CONTROL_SIZE | TIMER32_CONTROL_PRESCALE_1 | TIMER32_CONTROL_ENABLE;
+}
+uint32_t Now(void) { return ~TIMER32_1->VALUE; } // Counts up
 
-void Enqueue(EventType e) {
-    uint8_t next = (head + 1) % QUEUE_SIZE;
-    if (next != tail) {
-        eventQueue[head] = e;
-        head = next;
+void EnqueueArg(EventType e, uint32_t arg) {
+    eventCount[e]++;
+    if ((uint8_t)(head - tail) == QUEUE_SIZE) {
+        eventsDropped++;
+        return;
     }
+    volatile LogEvent *slot = &eventQueue[head & QUEUE_MASK];
+    slot->id = e; slot->ts = Now(); slot->arg = arg;
+    head++; // Publish only after the slot is written
+}
+void Enqueue(EventType e) { EnqueueArg(e, 0); }
+
+// From main: masks the ISR so stamps stay in queue order
+void Post(EventType e, uint32_t arg) { __disable_irq(); EnqueueArg(e, arg); __enable_irq(); }
+
+uint8_t Dequeue(LogEvent *ev) {
+    if (head == tail) return 0;
+    volatile LogEvent *slot = &eventQueue[tail & QUEUE_MASK];
+    ev->id = slot->id; ev->ts = slot->ts; ev->arg = slot->arg;
+    tail++;
+    return 1;
+}
+
+// --- BINARY LOG (TX ring drained by DMA channel 0 into EUSCI_A0) ---
+#define TX_RING_SIZE 256                     // Power of two
+#define TX_RING_MASK (TX_RING_SIZE - 1)
+#define LOGDMA_CH      0                     // Channel 0, source 1 = eUSCI_A0 TX
+#define LOGDMA_SRC     1
+#define LOGDMA_CTL(n)  ((3UL << 30) | (((uint32_t)(n) - 1) << 4) | 1UL) // Bytes, src +1, dst fixed, basic
+
+#pragma DATA_ALIGN(dmaControlTable, 256)
+volatile uint32_t dmaControlTable[64];       // 8 primary + 8 alternate: src end, dst end, control, spare
+
+uint8_t  txRing[TX_RING_SIZE];
+uint16_t txHead = 0, txTail = 0;             // Free-running, main only
+uint16_t txInFlight = 0;                     // Bytes handed to the DMA, not yet retired
+uint32_t lastLogTs = 0;
+
+void Log_Init(void) {
+    DMA_Control->CFG = DMA_CFG_MASTEN;
+    DMA_Control->CTLBASE = (uint32_t)dmaControlTable;
+    DMA_Channel->CH_SRCCFG[LOGDMA_CH] = LOGDMA_SRC;
+}
+
+uint16_t Log_Space(void) { return TX_RING_SIZE - (uint16_t)(txHead - txTail); }
+
+// Appends one record; the caller checks Log_Space() >= LOG_MAX_RECORD first
+void Log_Write(uint8_t id, uint32_t ts, uint32_t arg) {
+    uint8_t rec[LOG_MAX_RECORD], n, i;
+    n = Log_Encode(rec, id, ts - lastLogTs, arg);
+    for (i = 0; i < n; i++) txRing[(txHead + i) & TX_RING_MASK] = rec[i];
+    txHead += n;
+    lastLogTs = ts;
 }
 
-EventType Dequeue(void) {
-    if (head == tail) return EVT_NONE;
-    EventType e = eventQueue[tail];
-    tail = (tail + 1) % QUEUE_SIZE;
-    return e;
+// Retires a finished DMA run and starts the next one; never waits
+void Log_Kick(void) {
+    uint16_t n, at;
+    if (txInFlight) {
+        if (DMA_Control->ENASET & (1 << LOGDMA_CH)) return; // Still moving
+        txTail += txInFlight; txInFlight = 0;
+    }
+    n = (uint16_t)(txHead - txTail);
+    if (n == 0) return;
+    at = txTail & TX_RING_MASK;
+    if (n > TX_RING_SIZE - at) n = TX_RING_SIZE - at;   // Contiguous run only
+    dmaControlTable[LOGDMA_CH * 4 + 0] = (uint32_t)&txRing[at + n - 1];
+    dmaControlTable[LOGDMA_CH * 4 + 1] = (uint32_t)&EUSCI_A0->TXBUF;
+    dmaControlTable[LOGDMA_CH * 4 + 2] = LOGDMA_CTL(n);
+    txInFlight = n;
+    DMA_Control->ENASET = 1 << LOGDMA_CH;
+    DMA_Channel->SW_CHTRIG = 1 << LOGDMA_CH;  // TXIFG is already high: first byte by hand
 }
 
 // --- STATE VARIABLES ---
@@ -104,6 +191,7 @@ volatile int      bitIdx = 0;
 volatile uint8_t  lastCmd = 0;
 volatile uint32_t byteCount = 0;
 volatile uint32_t outShiftReg = 0;
+volatile uint32_t respWord = 0;
 volatile uint8_t  internalDoneFlag = 0;
 
 // --- SYSTEM INIT ---
@@ -127,8 +215,6 @@ void UART_Init(void) {
     EUSCI_A0->CTLW0 &= ~EUSCI_A_CTLW0_SWRST;
 }
 
-void UART_Print(char *str) { while (*str) { while (!(EUSCI_A0->IFG & EUSCI_A_IFG_TXIFG)); EUSCI_A0->TXBUF = *str++; }}
-void Print_Hex(uint8_t n) { char b[10]; sprintf(b, "0x%02X", n); UART_Print(b); }
 void SysTick_Init(void) { SysTick->LOAD = 0xFFFFFF; SysTick->VAL = 0; SysTick->CTRL = 5; }
 uint32_t GetTickDelta(uint32_t start) { uint32_t now = SysTick->VAL; return (start >= now) ? (start - now) : (start + (0xFFFFFF - now)); }
 uint8_t CheckModePins(void) {
@@ -163,18 +249,20 @@ void main(void) {
 
     UART_Init();
     SysTick_Init();
+    Timer_Init();
+    Log_Init();
 
-    UART_Print("\r\n--- GOWIN EMULATOR (Level 10: Flowchart Compliant) ---\r\n");
+    Log_Write(LOG_ID_BOOT, Now(), LOG_SRC_SSPI); Log_Kick();
 
     for(i=0; i<1500000; i++);
 
     if (!CheckModePins()) {
-        UART_Print("[WARN] Waiting for Mode Pins (001)...\r\n");
-        while (!CheckModePins()) { P4->OUT ^= LED_FAIL; for(i=0; i<800000; i++); }
+        Log_Write(EVT_MODE_WAIT, Now(), P2->IN & (PIN_MODE0 | PIN_MODE1 | PIN_MODE2)); Log_Kick();
+        while (!CheckModePins()) { P4->OUT ^= LED_FAIL; for(i=0; i<800000; i++); Log_Kick(); }
         P4->OUT &= ~LED_FAIL;
     }
 
-    UART_Print("[INFO] Mode Pins OK. Asserting READY.\r\n");
+    Log_Write(EVT_MODE_OK, Now(), 0); Log_Kick();
     P5->OUT |= PIN_READY;
     P4->OUT |= LED_RDY;
 
@@ -183,67 +271,57 @@ void main(void) {
     NVIC->ISER[1] = 1 << ((PORT5_IRQn) & 31);
     __enable_irq();
 
+    uint32_t reportedDrops = 0;
+    LogEvent ev;
     while (1) {
-        EventType e = Dequeue();
-
-        if (e != EVT_NONE) {
-            switch(e) {
-                case EVT_ENABLE: UART_Print("[CMD] ENABLE (0x15)\r\n"); break;
-                case EVT_ERASE: UART_Print("[CMD] ERASE (0x05) - Timer Started\r\n"); break;
-                case EVT_INIT_ADDR: UART_Print("[CMD] INIT ADDR (0x12)\r\n"); break;
-                case EVT_IDCODE: UART_Print("[CMD] READ ID (0x11)\r\n"); break;
-                case EVT_STATUS: UART_Print("[CMD] READ STATUS (0x41)\r\n"); break;
-                case EVT_WRITE_START: UART_Print("[CMD] WRITE START (0x3B)\r\n"); break;
-                case EVT_DISABLE: UART_Print("[CMD] WRITE DISABLE (0x3A)\r\n"); break;
-
-                case EVT_UNKNOWN:
-                    UART_Print("[???] Unknown Command: "); Print_Hex(diag_UnknownByte); UART_Print("\r\n");
-                    break;
-
-                case EVT_ERR_SEQ:
-                     P4->OUT |= LED_FAIL;
-                     UART_Print("[FAIL] SEQUENCE ERROR!\r\n");
-                     UART_Print("       Received: "); Print_Hex(diag_ReceivedCmd); UART_Print("\r\n");
-                     UART_Print("       Expected: ");
-                     switch(diag_ExpectedState) {
-                         case PROTO_IDLE:       UART_Print("ERASE (0x05)"); break; // Changed from ENABLE
-                         case PROTO_ERASED:     UART_Print("INIT ADDR (0x12)"); break;
-                         case PROTO_INIT:       UART_Print("ENABLE (0x15)"); break;
-                         case PROTO_WRITE_WAIT: UART_Print("WRITE REQ (0x3B)"); break;
-                         case PROTO_WRITING:    UART_Print("DISABLE (0x3A)"); break;
-                         default:               UART_Print("Unknown"); break;
-                     }
-                     UART_Print("\r\n       Action: Forcing State to Continue...\r\n");
-                     break;
-
-                case EVT_ERR_TIMING:
-                    UART_Print("[FAIL] Timing: INIT_ADDR sent before 4ms elapsed!\r\n");
-                    P4->OUT |= LED_FAIL;
-                    break;
-                case EVT_RESET:
-                    UART_Print("[INFO] Reset Active.\r\n");
-                    P4->OUT &= LED_PWR;
-                    internalDoneFlag = 0;
-                    protoState = PROTO_IDLE;
-                    while (!(P5->IN & PIN_RESET));
-                    UART_Print("[INFO] Reset Released.\r\n");
-                    for(i=0; i<1200000; i++);
-                    while (!CheckModePins()) { P4->OUT ^= LED_FAIL; for(i=0; i<800000; i++); }
-                    P4->OUT &= ~LED_FAIL;
-                    UART_Print("[INFO] Ready Again.\r\n");
-                    P5->OUT |= PIN_READY;
-                    P4->OUT |= LED_RDY;
-                    break;
-                case EVT_DONE:
-                    UART_Print("[PASS] Configuration Loaded. Done Flag Set.\r\n");
-                    P4->OUT |= LED_DONE;
-                    break;
-                default: break;
-            }
+        Log_Kick();
+        if (Log_Space() < LOG_MAX_RECORD) continue; // Back-pressure lands in the counted event queue
+        if (eventsDropped != reportedDrops) {
+            reportedDrops = eventsDropped;
+            Log_Write(LOG_ID_DROPPED, lastLogTs, reportedDrops);
+            continue;
+        }
+        if (!Dequeue(&ev)) continue;
+
+        Log_Write(ev.id, ev.ts, ev.arg);
+        switch(ev.id) {
+            case EVT_ERR_SEQ:
+            case EVT_ERR_TIMING:
+                P4->OUT |= LED_FAIL;
+                break;
+            case EVT_RESET:
+                P4->OUT &= LED_PWR;
+                internalDoneFlag = 0;
+                protoState = PROTO_IDLE;
+                while (!(P5->IN & PIN_RESET)) Log_Kick();
+                Post(EVT_RESET_RELEASED, 0);
+                for(i=0; i<1200000; i++);
+                while (!CheckModePins()) { P4->OUT ^= LED_FAIL; for(i=0; i<800000; i++); Log_Kick(); }
+                P4->OUT &= ~LED_FAIL;
+                Post(EVT_READY_AGAIN, 0);
+                P5->OUT |= PIN_READY;
+                P4->OUT |= LED_RDY;
+                break;
+            case EVT_DONE:
+                P4->OUT |= LED_DONE;
+                break;
+            default: break;
         }
     }
 }
 
+// Byte n (0 = first byte after the command) of a register read
+uint8_t ResponseByte(uint32_t n) {
+    return (n >= 3 && n <= 6) ? (uint8_t)(respWord >> (8 * (6 - n))) : 0x00;
+}
+
+// Loads the next response byte and presents its MSB right away
+void Load_MISO(uint8_t b) {
+    outShiftReg = b;
+    if (outShiftReg & 0x80) P5->OUT |= PIN_MISO;
+    else P5->OUT &= ~PIN_MISO;
+}
+
 // --- ISR (Flowchart State Machine) ---
 void PORT5_IRQHandler(void) {
     uint32_t flags = P5->IFG;
@@ -252,10 +330,11 @@ void PORT5_IRQHandler(void) {
         uint8_t mosi = (P5->IN & PIN_MOSI) ? 1 : 0;
         shiftReg = (shiftReg << 1) | mosi;
 
+        // The master sampled this edge already; present the following bit
         if (currentState == SPI_READ_RSP || currentState == SPI_STATUS_RSP) {
+             outShiftReg <<= 1;
              if (outShiftReg & 0x80) P5->OUT |= PIN_MISO;
              else P5->OUT &= ~PIN_MISO;
-             outShiftReg <<= 1;
         }
 
         bitIdx++;
@@ -277,14 +356,14 @@ void PORT5_IRQHandler(void) {
                 else if (lastCmd == CMD_INIT_ADDR) {
                     // EXPECTED: State should be PROTO_ERASED
                     if (protoState != PROTO_ERASED) {
-                        diag_ReceivedCmd = lastCmd;
-                        diag_ExpectedState = protoState; // Will likely be IDLE (expects Erase)
-                        Enqueue(EVT_ERR_SEQ);
+                        // Expected state will likely be IDLE (expects Erase)
+                        EnqueueArg(EVT_ERR_SEQ, ((uint32_t)lastCmd << 8) | protoState);
                         // RECOVERY: Advance to INIT anyway
                         protoState = PROTO_INIT;
                     } else {
-                        if (GetTickDelta(eraseTimestamp) < MIN_ERASE_WAIT_TICKS) {
-                            Enqueue(EVT_ERR_TIMING);
+                        uint32_t waited = GetTickDelta(eraseTimestamp);
+                        if (waited < MIN_ERASE_WAIT_TICKS) {
+                            EnqueueArg(EVT_ERR_TIMING, waited / (TICKS_PER_MS / 1000));
                         } else {
                             P4->OUT |= LED_ERS; protoState = PROTO_INIT;
                         }
@@ -309,9 +388,7 @@ void PORT5_IRQHandler(void) {
                 // --- WRITE REQ (0x3B) ---
                 else if (lastCmd == CMD_WRITE_REQ) {
                     if (protoState != PROTO_WRITE_WAIT) {
-                        diag_ReceivedCmd = lastCmd;
-                        diag_ExpectedState = protoState;
-                        Enqueue(EVT_ERR_SEQ);
+                        EnqueueArg(EVT_ERR_SEQ, ((uint32_t)lastCmd << 8) | protoState);
                         protoState = PROTO_WRITING;
                     } else {
                         protoState = PROTO_WRITING;
@@ -322,35 +399,34 @@ void PORT5_IRQHandler(void) {
 
                 // --- DISABLE (0x3A) ---
                 else if (lastCmd == CMD_DISABLE) {
-                    Enqueue(EVT_DISABLE);
+                    EnqueueArg(EVT_DISABLE, byteCount);
                     if (byteCount > 100) {
-                        P5->OUT |= PIN_DONE; internalDoneFlag = 1; Enqueue(EVT_DONE);
+                        P5->OUT |= PIN_DONE; internalDoneFlag = 1; EnqueueArg(EVT_DONE, byteCount);
                     }
                     currentState = SPI_DUMMY;
                 }
 
                 // --- READS ---
                 else if (lastCmd == CMD_IDCODE) {
-                    outShiftReg = 0x11; Enqueue(EVT_IDCODE); currentState = SPI_READ_RSP;
+                    respWord = GOWIN_ID_VAL; byteCount = 0; Load_MISO(ResponseByte(0));
+                    Enqueue(EVT_IDCODE); currentState = SPI_READ_RSP;
                 }
                 else if (lastCmd == CMD_READ_STATUS) {
-                    byteCount = 0; Enqueue(EVT_STATUS); currentState = SPI_STATUS_RSP;
+                    respWord = STATUS_BASE | (internalDoneFlag ? STATUS_DONE : 0);
+                    byteCount = 0; Load_MISO(ResponseByte(0));
+                    EnqueueArg(EVT_STATUS, eventCount[EVT_STATUS] + 1); currentState = SPI_STATUS_RSP;
                 }
                 else {
                     if (lastCmd != 0xFF && lastCmd != 0xFE) {
-                         diag_UnknownByte = lastCmd; Enqueue(EVT_UNKNOWN);
+                         EnqueueArg(EVT_UNKNOWN, lastCmd);
                     }
                     currentState = SPI_DUMMY;
                 }
             }
             else if (currentState == SPI_BURST) { byteCount++; }
-            else if (currentState == SPI_READ_RSP) { outShiftReg = 0x00; }
-            else if (currentState == SPI_STATUS_RSP) {
+            else if (currentState == SPI_READ_RSP || currentState == SPI_STATUS_RSP) {
                 byteCount++;
-                if (byteCount == 6) {
-                    if (internalDoneFlag) outShiftReg = 0x02;
-                    else outShiftReg = 0x00;
-                } else { outShiftReg = 0x00; }
+                Load_MISO(ResponseByte(byteCount));
             }
         }
         P5->IFG &= ~PIN_SCK;
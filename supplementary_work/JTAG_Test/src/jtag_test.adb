@@ -1,5 +1,9 @@
 pragma Style_Checks (Off);
 
+--  Bring-up prototype, kept for reference. The maintained firmware is
+--  JTAG_Programmer_Cmd_Call; its hal.Initialize carries the USART1 and
+--  DMA1 channel 3 / 5 set-up below.
+
 with STM32F0x0;               use STM32F0x0;
 with STM32F0x0.RCC;           use STM32F0x0.RCC;
 with STM32F0x0.GPIO;          use STM32F0x0.GPIO;